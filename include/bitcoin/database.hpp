@@ -15,23 +15,58 @@
  */
 
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/block_filter.hpp>
+#include <bitcoin/database/block_record.hpp>
 #include <bitcoin/database/block_state.hpp>
+#include <bitcoin/database/commit_counter.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/compact_codec.hpp>
+#include <bitcoin/database/crc32c.hpp>
 #include <bitcoin/database/data_base.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/eviction_policy.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/hash_filter.hpp>
+#include <bitcoin/database/header_cache.hpp>
+#include <bitcoin/database/manifest.hpp>
+#include <bitcoin/database/map_advice.hpp>
+#include <bitcoin/database/parallel.hpp>
+#include <bitcoin/database/sequence_lock.hpp>
 #include <bitcoin/database/settings.hpp>
+#include <bitcoin/database/state_table.hpp>
+#include <bitcoin/database/storage_backend.hpp>
 #include <bitcoin/database/store.hpp>
+#include <bitcoin/database/table_directories.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+#include <bitcoin/database/trace.hpp>
+#include <bitcoin/database/transaction_pool.hpp>
 #include <bitcoin/database/unspent_outputs.hpp>
 #include <bitcoin/database/unspent_transaction.hpp>
 #include <bitcoin/database/verify.hpp>
 #include <bitcoin/database/version.hpp>
+#include <bitcoin/database/write_sequence.hpp>
 #include <bitcoin/database/databases/address_database.hpp>
 #include <bitcoin/database/databases/block_database.hpp>
+#include <bitcoin/database/databases/filter_database.hpp>
+#include <bitcoin/database/databases/spend_database.hpp>
 #include <bitcoin/database/databases/transaction_database.hpp>
 #include <bitcoin/database/memory/accessor.hpp>
+#include <bitcoin/database/memory/block_arena.hpp>
+#include <bitcoin/database/memory/buffer_storage.hpp>
 #include <bitcoin/database/memory/file_storage.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/memory/memory_storage.hpp>
+#include <bitcoin/database/memory/pinned_accessor.hpp>
+#include <bitcoin/database/memory/prefetcher.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
+#include <bitcoin/database/memory/segmented_storage.hpp>
 #include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/primitives/chunk_element.hpp>
+#include <bitcoin/database/primitives/element_traits.hpp>
+#include <bitcoin/database/primitives/hash_index.hpp>
 #include <bitcoin/database/primitives/hash_table.hpp>
+#include <bitcoin/database/primitives/hash_table_chunked_multimap.hpp>
 #include <bitcoin/database/primitives/hash_table_header.hpp>
 #include <bitcoin/database/primitives/hash_table_multimap.hpp>
 #include <bitcoin/database/primitives/list.hpp>
@@ -45,5 +80,6 @@
 #include <bitcoin/database/result/inpoint_iterator.hpp>
 #include <bitcoin/database/result/transaction_iterator.hpp>
 #include <bitcoin/database/result/transaction_result.hpp>
+#include <bitcoin/database/result/transaction_view.hpp>
 
 #endif
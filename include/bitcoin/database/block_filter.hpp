@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_BLOCK_FILTER_HPP
+#define LIBBITCOIN_DATABASE_BLOCK_FILTER_HPP
+
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe (stateless).
+/// The BIP158 basic filter of a block, a Golomb-coded set of the scripts of
+/// its outputs and of the previous outputs spent by its inputs.
+class BCD_API block_filter
+{
+public:
+    /// The Golomb-Rice parameter and the inverse false positive rate.
+    static const uint8_t rice_bits;
+    static const uint64_t inverse_rate;
+
+    /// The filter of the block, requires that every prevout (other than of
+    /// the coinbase) is cached in the previous output metadata.
+    static data_chunk compute(const chain::block& block);
+
+    /// The filter of the (distinct and nonempty) elements, keyed by the hash.
+    static data_chunk encode(const hash_digest& block_hash,
+        const data_stack& elements);
+
+    /// The SipHash-2-4 of the element, keyed by the hash.
+    static uint64_t hash(const hash_digest& key, const data_chunk& element);
+
+    /// The filter of the hashes of the elements (sorted in place).
+    static data_chunk encode(std::vector<uint64_t>& hashes);
+
+    /// True if any of the hashes (sorted) may be of an element of the filter,
+    /// false if the filter is not well formed.
+    static bool match(const data_slice& filter,
+        const std::vector<uint64_t>& hashes);
+
+    /// The filter header, committing to the filter and the previous header
+    /// (null_hash for the genesis block).
+    static hash_digest header(const data_chunk& filter,
+        const hash_digest& previous_header);
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
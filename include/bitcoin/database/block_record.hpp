@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_BLOCK_RECORD_HPP
+#define LIBBITCOIN_DATABASE_BLOCK_RECORD_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// The fixed layout of a block table record value (excludes key and link).
+/// Fields are little-endian byte arrays, so the struct has no padding or
+/// alignment requirement and may be overlaid directly on mapped memory.
+struct block_record
+{
+    /// The size of a serialized header (without transaction count).
+    static constexpr size_t header_size = 80;
+
+    uint8_t header[header_size];
+    uint8_t median_time_past[sizeof(uint32_t)];
+    uint8_t height[sizeof(uint32_t)];
+    uint8_t state[sizeof(uint8_t)];
+    uint8_t checksum[sizeof(uint32_t)];
+    uint8_t tx_start[sizeof(uint32_t)];
+    uint8_t tx_count[sizeof(uint16_t)];
+
+    /// Load an integer from a field of the same width.
+    template <typename Integer, size_t Size>
+    static Integer load(const uint8_t (&field)[Size])
+    {
+        static_assert(sizeof(Integer) == Size, "field width mismatch");
+        return from_little_endian_unsafe<Integer>(&field[0]);
+    }
+
+    /// Store an integer to a field of the same width.
+    template <typename Integer, size_t Size>
+    static void store(uint8_t (&field)[Size], Integer value)
+    {
+        static_assert(sizeof(Integer) == Size, "field width mismatch");
+        const auto bytes = to_little_endian(value);
+        std::copy(bytes.begin(), bytes.end(), &field[0]);
+    }
+};
+
+static_assert(sizeof(block_record) == 99, "unexpected block record size");
+static_assert(alignof(block_record) == 1, "block record must be unaligned");
+
+/// Field offsets within the record value, for in-place updates.
+static constexpr size_t block_record_height_offset =
+    offsetof(block_record, height);
+static constexpr size_t block_record_state_offset =
+    offsetof(block_record, state);
+static constexpr size_t block_record_checksum_offset =
+    offsetof(block_record, checksum);
+static constexpr size_t block_record_transactions_offset =
+    offsetof(block_record, tx_start);
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_COMMIT_COUNTER_HPP
+#define LIBBITCOIN_DATABASE_COMMIT_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// The writer of a store publishes the sequence and top heights of each
+/// completed write here, and read-only secondaries (in other processes) read
+/// it to learn which heights are safe to read. The record is checksummed, so
+/// a read that overlaps a publish is detected and retried.
+class BCD_API commit_counter
+  : noncopyable
+{
+public:
+    typedef boost::filesystem::path path;
+
+    /// A published state, heights are the candidate and confirmed tops.
+    struct state
+    {
+        uint64_t sequence;
+        size_t candidate_height;
+        size_t confirmed_height;
+    };
+
+    /// Construct the counter (the file is not opened).
+    commit_counter(const path& filename);
+
+    /// Close the counter.
+    ~commit_counter();
+
+    /// Open the file, the writer creates it and continues its sequence.
+    bool open(bool writer);
+
+    /// Close the file, idempotent.
+    bool close();
+
+    /// Publish the next sequence with the top heights (writer only).
+    bool publish(size_t candidate_height, size_t confirmed_height);
+
+    /// Read the last published state, false if none is readable.
+    bool read(state& out) const;
+
+private:
+    bool read_state(state& out) const;
+
+    const path filename_;
+
+    // Protected by mutex.
+    int file_handle_;
+    bool writer_;
+    uint64_t sequence_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
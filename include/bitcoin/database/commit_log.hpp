@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_COMMIT_LOG_HPP
+#define LIBBITCOIN_DATABASE_COMMIT_LOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// An append-only redo log of table writes, committed in checksummed batches.
+/// Each entry is the after-image of a byte range of a named table file.
+class BCD_API commit_log
+  : noncopyable
+{
+public:
+    typedef boost::filesystem::path path;
+    typedef std::function<bool(const std::string& table, file_offset offset,
+        const data_chunk& data)> replay_handler;
+
+    /// Construct the log (the file is not opened).
+    commit_log(const path& filename);
+
+    /// Close the log.
+    ~commit_log();
+
+    /// Open (or create) the log file for append.
+    bool open();
+
+    /// Close the log file, idempotent.
+    bool close();
+
+    /// Buffer the after-image of a range of a table file.
+    void write(const std::string& table, file_offset offset,
+        const uint8_t* data, size_t size);
+
+    /// The number of bytes buffered and not yet committed.
+    size_t pending() const;
+
+    /// Drop buffered entries without committing them.
+    void discard();
+
+    /// Append buffered entries as one batch and sync the log file.
+    bool commit();
+
+    /// The size of the log file.
+    size_t size() const;
+
+    /// Empty the log file (and the buffer), after all tables are flushed.
+    bool reset();
+
+    /// Apply the entries of each complete batch in order, ignoring any tail.
+    bool replay(replay_handler handler) const;
+
+private:
+    const path filename_;
+
+    // Protected by mutex.
+    int file_handle_;
+    size_t file_size_;
+    data_chunk buffer_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_COMPACT_CODEC_HPP
+#define LIBBITCOIN_DATABASE_COMPACT_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe (stateless).
+/// The compact stored encoding of a transaction (from its output count).
+/// Output values are compressed varints and standard output scripts are
+/// stored as template codes with their hash or key. The spend metadata of
+/// each output remains fixed size at the start of the output, so spends are
+/// written in place as in the full encoding. Inputs are not changed.
+class BCD_API compact_codec
+{
+public:
+    /// True if all output values of the transaction can be compressed.
+    static bool compactable(const chain::transaction& tx);
+
+    /// The compact stored size of the transaction.
+    static size_t size(const chain::transaction& tx);
+
+    /// The compact stored size of the output.
+    static size_t output_size(const chain::output& output);
+
+    /// Write the compact encoding of the transaction.
+    static void write(byte_serializer& serial, const chain::transaction& tx);
+
+    /// Write the compact encoding of the output.
+    static void write_output(byte_serializer& serial,
+        const chain::output& output);
+
+    /// Skip the compact output, returning its stored size.
+    static size_t skip_output(byte_deserializer& deserial);
+
+    /// Skip the compact output value and script, positioned after the spend
+    /// metadata, returning their stored size.
+    static size_t skip_payload(byte_deserializer& deserial);
+
+    /// Read the compact output value, positioned after the spend metadata.
+    static uint64_t read_value(byte_deserializer& deserial);
+
+    /// Read the compact output script, positioned after the value.
+    static data_chunk read_script(byte_deserializer& deserial);
+
+    /// Read the compact output as its full stored encoding.
+    static data_chunk expand_output(byte_deserializer& deserial);
+
+    /// Read the compact transaction as its full stored encoding.
+    static data_chunk expand(byte_deserializer& deserial);
+
+    /// The compressed value of an amount (zero maps to zero).
+    static uint64_t compress(uint64_t amount);
+
+    /// The amount of a compressed value.
+    static uint64_t decompress(uint64_t value);
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
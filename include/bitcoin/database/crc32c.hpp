@@ -0,0 +1,36 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_CRC32C_HPP
+#define LIBBITCOIN_DATABASE_CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// The CRC-32C (Castagnoli) checksum of the bytes, continuing from crc.
+/// Uses the SSE4.2 or ARMv8 crc32 instructions where available.
+BCD_API uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc=0);
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
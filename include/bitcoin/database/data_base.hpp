@@ -20,22 +20,46 @@
 #define LIBBITCOIN_DATABASE_DATA_BASE_HPP
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/databases/address_database.hpp>
 #include <bitcoin/database/databases/block_database.hpp>
+#include <bitcoin/database/databases/filter_database.hpp>
+#include <bitcoin/database/databases/spend_database.hpp>
 #include <bitcoin/database/databases/transaction_database.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/settings.hpp>
 #include <bitcoin/database/store.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+#include <bitcoin/database/write_sequence.hpp>
 
 namespace libbitcoin {
 namespace database {
 
+/// A copy of the counters of the store, not atomic across counters.
+struct store_metrics
+{
+    table_metrics::values blocks;
+    table_metrics::values transactions;
+    table_metrics::values addresses;
+    table_metrics::values filters;
+    table_metrics::values spends;
+    float unspent_hit_rate;
+    uint64_t write_wait_ns;
+    uint64_t flushes;
+    uint64_t flush_ns;
+};
+
 /// This class provides thread safe access to the database.
 class BCD_API data_base
   : public store
@@ -63,6 +87,19 @@ public:
     /// Close all databases.
     bool close() override;
 
+    /// Repair a store that was not closed cleanly (in place of open), leaving
+    /// it closed. Block indexes are truncated to their consistent heights.
+    bool repair();
+
+    /// Follow the writer of a read-only secondary, not concurrent with its
+    /// queries. Returns the published state, heights above which are unsafe.
+    bool refresh(commit_counter::state& out);
+
+    /// Invoke the reader until its table reads do not overlap a write, false
+    /// if each of the attempts overlaps a write. The reader must tolerate
+    /// discard of its results, as those of an overlapping read are invalid.
+    bool snapshot(const write_sequence::reader& reader, size_t attempts) const;
+
     /// Call close on destruct.
     ~data_base();
 
@@ -77,6 +114,26 @@ public:
     /// Invalid if indexes not initialized.
      address_database& addresses() const;
 
+    /// Invalid if filters not initialized.
+     filter_database& filters() const;
+
+    /// Invalid if spends not initialized.
+     spend_database& spends() const;
+
+    /// Append the wire serialization of the stored block of the hash to the
+    /// buffer, transcoded from the mapped tables as for serving to peers.
+    /// False if the block or any of its txs is not stored (or pruned).
+    bool get_block_data(data_chunk& out_data, const hash_digest& hash,
+        bool witness=true) const;
+
+    /// Write the confirmed outputs unspent at the confirmed top to a snapshot.
+    /// Writes are blocked for the duration of the export.
+    bool export_unspent(const path& filename) const;
+
+    /// The counters of each table and of store writes and flushes.
+    /// Address, filter and spend counters are zero if not initialized.
+    store_metrics metrics() const;
+
     // Node writers.
     // ------------------------------------------------------------------------
 
@@ -95,6 +152,11 @@ public:
     /// Update the stored block with txs.
     code update( chain::block& block, size_t height);
 
+    /// Update the stored block with txs, if linked the link of each stored
+    /// tx is set (e.g. a compact block from the pool) so others are written
+    /// without existence lookup.
+    code update( chain::block& block, size_t height, bool linked);
+
     // BLOCK ORGANIZER (update, invalidate)
     /// Set header validation state and metadata.
     code invalidate( chain::header& header, const code& error);
@@ -105,6 +167,7 @@ public:
 
     // BLOCK ORGANIZER (candidate)
     /// Add payments of transactions of the block to the payment index.
+    /// When indexing is deferred confirmed blocks are indexed in background.
     code index( chain::block& block);
 
     // BLOCK ORGANIZER (reorganize)
@@ -113,18 +176,53 @@ public:
         block_const_ptr_list_const_ptr incoming,
         block_const_ptr_list_ptr outgoing);
 
+    // BLOCK ORGANIZER (reorganize)
+    /// Reorganize the block index to the specified fork point, returning the
+    /// outgoing blocks as stored results (txs are read on demand by link).
+    code reorganize(const config::checkpoint& fork_point,
+        block_const_ptr_list_const_ptr incoming,
+        block_result::list& outgoing);
+
+    // INITCHAIN (snapshot)
+    /// Store the txs of an unspent output snapshot into a newly created store.
+    /// The header and block indexes are not populated from the snapshot.
+    bool import_unspent(const path& filename);
+
     // TRANSACTION ORGANIZER (store)
     /// Store unconfirmed tx/payments that was verified with the given forks.
+    /// With a commit window, concurrent stores share one write (and flush),
+    /// so this must not be called from an asynchronous write handler.
     code store( chain::transaction& tx, uint32_t forks);
 
     // TRANSACTION ORGANIZER (store)
     /// Add payments of the transaction to the payment index.
+    /// When indexing is deferred unconfirmed payments are not indexed.
     code index( chain::transaction& tx);
 
+    // Asynchronous writers.
+    // ------------------------------------------------------------------------
+    // Each write is queued to the writer thread and the handler is invoked on
+    // that thread, in call order. Consecutive queued stores of txs are group
+    // committed, in one write (and one flush).
+
+    void push(block_ptr block, size_t height, uint32_t median_time_past,
+        result_handler handler);
+    void update(block_ptr block, size_t height, result_handler handler);
+    void candidate(block_ptr block, result_handler handler);
+    void reorganize(const config::checkpoint& fork_point,
+        header_const_ptr_list_const_ptr incoming,
+        header_const_ptr_list_ptr outgoing, result_handler handler);
+    void reorganize(const config::checkpoint& fork_point,
+        block_const_ptr_list_const_ptr incoming,
+        block_const_ptr_list_ptr outgoing, result_handler handler);
+    void store(transaction_ptr tx, uint32_t forks, result_handler handler);
+
 protected:
     void start();
     void commit();
     bool flush() const override;
+    bool journal(commit_log& log) const override;
+    bool tops(size_t& candidate, size_t& confirmed) const override;
 
     // Header reorganization.
     // ------------------------------------------------------------------------
@@ -144,7 +242,8 @@ protected:
         const config::checkpoint& fork_point);
     bool pop_above(block_const_ptr_list_ptr headers,
         const config::checkpoint& fork_point);
-    code push_block( chain::block& block, size_t height);
+    bool pop_above(block_result::list& results,
+        const config::checkpoint& fork_point);
     code pop_block(chain::block& out_block, size_t height);
 
 
@@ -154,15 +253,94 @@ protected:
     std::shared_ptr<block_database> blocks_;
     std::shared_ptr<transaction_database> transactions_;
     std::shared_ptr<address_database> addresses_;
+    std::shared_ptr<filter_database> filters_;
+    std::shared_ptr<spend_database> spends_;
 
 private:
     chain::transaction::list to_transactions(const block_result& result) const;
 
+    // Block reorganization (caller must hold the write lock).
+    bool read_above(block_result::list& out_results,
+        const config::checkpoint& fork_point) const;
+    bool unconfirm_above(const block_result::list& results,
+        const config::checkpoint& fork_point);
+
+    // Prevouts of the block not cached by validation.
+    void populate_prevouts(const chain::block& block, size_t height) const;
+
+    // Block filters.
+    data_chunk compute_filter(const chain::block& block, size_t height) const;
+    void store_filter(const chain::block& block, const data_chunk& filter);
+
+    // Transaction pruning (caller must hold the write lock).
+    void prune(size_t height);
+
+    // Background writeback.
+    void start_flusher();
+    void stop_flusher();
+    void flush_dirty();
+    void pregrow();
+
+    // Asynchronous writes, of which a tx store is one with a tx.
+    struct write_request
+    {
+        std::function<code()> write;
+        std::shared_ptr<chain::transaction> tx;
+        uint32_t forks;
+        result_handler handler;
+    };
+
+    typedef std::vector<write_request> write_requests;
+
+    void start_writer();
+    void stop_writer();
+    void enqueue(write_request&& request);
+    void execute(write_requests& requests);
+    void store(write_requests::iterator first, write_requests::iterator last);
+
+    // Acquire the write lock, timing the wait if contended.
+    unique_lock lock_write() const;
+
+    // Background payment indexing.
+    bool deferred() const;
+    void start_indexer();
+    void stop_indexer();
+    void notify_indexer();
+    bool index_next();
+
     std::atomic<bool> closed_;
     const settings& settings_;
 
     // Used to prevent unsafe concurrent writes.
     mutable shared_mutex write_mutex_;
+
+    // Write lock wait and flush counters.
+    mutable std::atomic<uint64_t> write_wait_ns_;
+    mutable std::atomic<uint64_t> flushes_;
+    mutable std::atomic<uint64_t> flush_ns_;
+
+    // Used to detect reads that overlap writes.
+    write_sequence sequence_;
+
+    // Background writeback thread, signaled on close.
+    std::thread flusher_;
+    std::mutex flusher_mutex_;
+    std::condition_variable flusher_condition_;
+    bool flusher_stopped_;
+
+    // Background payment indexer, signaled on confirmation and close.
+    std::thread indexer_;
+    std::mutex indexer_mutex_;
+    std::condition_variable indexer_condition_;
+    std::atomic<bool> indexer_stopped_;
+    bool indexer_pending_;
+
+    // Asynchronous writer, signaled on enqueue and close.
+    std::thread writer_;
+    std::mutex writer_mutex_;
+    std::condition_variable writer_condition_;
+    write_requests writes_;
+    bool writer_stopped_;
 };
 
 } // namespace database
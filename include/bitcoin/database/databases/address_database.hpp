@@ -19,14 +19,26 @@
 #ifndef LIBBITCOIN_DATABASE_ADDRESS_DATABASE_HPP
 #define LIBBITCOIN_DATABASE_ADDRESS_DATABASE_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/map_advice.hpp>
 #include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/storage.hpp>
 #include <bitcoin/database/primitives/hash_table.hpp>
-#include <bitcoin/database/primitives/hash_table_multimap.hpp>
+#include <bitcoin/database/primitives/hash_table_chunked_multimap.hpp>
 #include <bitcoin/database/primitives/record_manager.hpp>
+#include <bitcoin/database/primitives/slab_manager.hpp>
 #include <bitcoin/database/result/address_result.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -38,9 +50,59 @@ class BCD_API address_database
 public:
     typedef boost::filesystem::path path;
 
+    /// The payment of a transaction to or from an address hash, with the
+    /// value of the output or of the prevout of the input (or unvalued).
+    struct payment
+    {
+        short_hash hash;
+        chain::payment_record record;
+        uint64_t value;
+    };
+
+    /// The payments of transactions by address hash, in order of indexing.
+    typedef std::vector<payment> payments;
+
+    /// The first heights of ranges of blocks.
+    typedef std::vector<size_t> heights;
+
+    /// A row of the history of an address hash.
+    struct history_row
+    {
+        short_hash hash;
+        chain::payment_record record;
+    };
+
+    /// The rows of the histories of address hashes, newest first.
+    typedef std::vector<history_row> history_rows;
+
+    /// The totals of the payments indexed for an address hash.
+    struct aggregate
+    {
+        uint64_t received;
+        uint64_t spent;
+        uint32_t transactions;
+        uint32_t height;
+    };
+
+    /// The height of rows of unconfirmed transactions.
+    static const size_t unconfirmed;
+
+    /// The cursor of the newest row of a query.
+    static const uint64_t not_found;
+
+    /// The value of a spend of which the prevout is not populated, which is
+    /// indexed as a row but excluded from the balance totals.
+    static const uint64_t unvalued;
+
     /// Construct the database.
+    /// Balances are maintained only for nonzero balance buckets, and filters
+    /// of the address hashes paid in each range of blocks only for a nonzero
+    /// filter range (blocks per filter).
     address_database(const path& lookup_filename, const path& rows_filename,
-        size_t buckets, size_t expansion);
+        const path& height_filename, const path& balances_filename,
+        const path& filters_filename, size_t buckets, size_t balance_buckets,
+        size_t filter_range, size_t expansion, size_t reservation=0,
+        storage_backend backend=storage_backend::file);
 
     /// Close the database (all threads must first be stopped).
     ~address_database();
@@ -54,12 +116,46 @@ public:
     /// Call before using the database.
     bool open();
 
+    /// Follow the writes of another process (read only), not concurrent
+    /// with queries. Remaps grown files and rereads table sizes.
+    bool refresh();
+
     /// Commit latest inserts.
     void commit();
 
     /// Flush the memory maps to disk.
     bool flush() const;
 
+    /// Schedule asynchronous writeback of newly-allocated space.
+    bool flush_dirty() const;
+
+    /// Begin journaling writes to the memory maps.
+    void enable_journal();
+
+    /// Advise the memory maps (header_only applies to the hash table).
+    void enable_advice(const map_advice& advice);
+
+    /// Apply the growth policy to the memory maps, must be closed.
+    void enable_file_growth(const file_growth& growth);
+
+    /// Allocate the next growth of the memory maps, if near full.
+    void pregrow();
+
+    /// Write journaled ranges to the commit log.
+    bool log_writes(commit_log& log);
+
+    /// The counters of the table, its indexes and their files.
+    table_metrics::values metrics() const;
+
+    /// Grow the hash table buckets above the load factor (percentage).
+    void enable_growth(size_t load_percent);
+
+    /// The average number of entries per hash table bucket.
+    float load_factor() const;
+
+    /// Extract and write the payments of a block across threads (0 = all).
+    void enable_parallel(size_t threads);
+
     /// Call to unload the memory map.
     bool close();
 
@@ -69,34 +165,144 @@ public:
     /// Get the output and input points associated with the address hash.
     address_result get(const short_hash& hash) const;
 
+    /// Get up to limit payments of the address hash, newest first, from the
+    /// row at cursor (not_found for the newest) and stopping at the first row
+    /// indexed below from_height. The iterator link is the next page cursor.
+    address_result get(const short_hash& hash, size_t from_height,
+        size_t limit, uint64_t cursor=not_found) const;
+
+    /// Get up to limit payments of the address hashes, newest first across
+    /// all of them, stopping at the first rows indexed below from_height.
+    /// The hashes are found in order of bucket, with bucket rows prefetched.
+    history_rows get(const std::vector<short_hash>& hashes,
+        size_t from_height, size_t limit) const;
+
+    /// Get the totals of the payments indexed for the address hash, false if
+    /// balances are not maintained or the address hash has no payments.
+    bool get(aggregate& out_totals, const short_hash& hash) const;
+
+    /// The height through which confirmed blocks are indexed, false if the
+    /// height is not tracked (payments are indexed as blocks are connected).
+    bool indexed_height(size_t& out_height) const;
+
+    /// The height below which payments are filtered, a multiple of the
+    /// filter range (zero if filters are not maintained).
+    size_t filtered_height() const;
+
+    /// The first height of each filtered range, at or above from_height, that
+    /// may include a payment of any of the address hashes. Payments at or
+    /// above the filtered height, or unconfirmed, are not filtered.
+    heights match(const std::vector<short_hash>& hashes,
+        size_t from_height) const;
+
     // Store.
     //-------------------------------------------------------------------------
 
-    /// Add a row for each payment recorded in the transaction.
-    void index( chain::transaction& tx);
+    /// Add a row for each payment recorded in the unconfirmed transaction.
+    void index(const chain::transaction& tx);
+
+    /// Add a row for each payment recorded in the transactions not existed,
+    /// of the block at the given height.
+    void index(const chain::transaction::list& transactions, size_t height);
+
+    /// Extract the payments of the transactions, including those existed.
+    payments extract(const chain::transaction::list& transactions,
+        size_t height) const;
+
+    /// Add a row for each payment, with one link for each key.
+    void index(const payments& payments);
+
+    /// Remove the newest row of each payment key that matches the payment.
+    void unindex(const payments& payments);
+
+    /// Set the height through which confirmed blocks are indexed.
+    void set_indexed_height(size_t height);
+
+    /// Stop tracking the indexed height.
+    void reset_indexed_height();
 
 private:
     typedef short_hash key_type;
     typedef array_index index_type;
     typedef array_index link_type;
-    typedef record_manager<link_type> manager_type;
-    typedef hash_table<manager_type, index_type, link_type, key_type>
-        record_map;
+    typedef hash_table_chunked_multimap<index_type, link_type, key_type>
+        record_multimap;
+    typedef record_multimap::table record_map;
+    typedef record_multimap::manager manager_type;
+    typedef hash_table<record_manager<index_type>, index_type, link_type,
+        key_type> balance_map;
+    typedef slab_manager<file_offset> filter_manager;
+
+    // The position and size of the filter of a range (zero if unfiltered).
+    struct filter_slab
+    {
+        file_offset position;
+        uint32_t size;
+    };
 
     // The record multimap as distinct file as opposed to linkage within the map
     // allows avoidance of hash storage with each entry. This is similar to
     // the transaction index with the exception that the tx index stores tx
     // sets by block in a contiguous array, eliminating a need for linked list.
-    typedef hash_table_multimap<index_type, link_type, key_type> record_multimap;
+    // Rows of a key are stored in chunks, so history is read sequentially.
+
+    // Extract the payments of the transaction, by address hash.
+    static void extract(payments& out, const chain::transaction& tx,
+        size_t height);
+
+    // Extract the payments of the transactions across threads.
+    payments extract(const chain::transaction::list& transactions,
+        size_t height, bool existed) const;
+
+    // Write the indexed height (or untracked) to the height file.
+    void write_height(uint64_t height);
+
+    // Add the totals to (or subtract them from) those of the address hash.
+    void add_totals(const short_hash& hash, const aggregate& totals);
+    void subtract_totals(const short_hash& hash, const aggregate& totals);
+
+    // Add the address hashes of confirmed payments to the pending filters,
+    // and write the filter of each range that is then buried.
+    void add_filters(const payments& payments);
+    void write_filter(size_t range, const data_chunk& filter);
+    bool read_filters();
 
     /// Hash table used for start index lookup for linked list by address hash.
-    file_storage hash_table_file_;
+    // Counters, outlive the files that report to them.
+    table_metrics metrics_;
+
+    storage::ptr hash_table_file_;
     record_map hash_table_;
 
     /// History rows.
-    file_storage address_index_file_;
+    storage::ptr address_index_file_;
     manager_type address_index_;
     record_multimap address_multimap_;
+
+    /// Height through which confirmed blocks are indexed.
+    storage::ptr height_file_;
+    std::atomic<uint64_t> height_;
+
+    /// Totals by address hash, updated in place.
+    const bool balances_enabled_;
+    storage::ptr balance_file_;
+    balance_map balances_;
+    mutable shared_mutex balance_mutex_;
+
+    /// Filters of the address hashes paid in each range of blocks, with the
+    /// hashes of the ranges not yet filtered (from complete_range_ these are
+    /// known to be all of the hashes paid in the range).
+    const bool filters_enabled_;
+    const size_t filter_range_;
+    storage::ptr filter_file_;
+    filter_manager filters_;
+    std::vector<filter_slab> filter_slabs_;
+    std::map<size_t, std::vector<uint64_t>> pending_;
+    size_t complete_range_;
+    size_t top_height_;
+    mutable shared_mutex filter_mutex_;
+
+    size_t threads_;
 };
 
 } // namespace database
@@ -24,11 +24,22 @@
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/block_state.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/databases/transaction_database.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/manifest.hpp>
+#include <bitcoin/database/map_advice.hpp>
+#include <bitcoin/database/header_cache.hpp>
 #include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/primitives/hash_index.hpp>
 #include <bitcoin/database/primitives/hash_table.hpp>
 #include <bitcoin/database/primitives/record_manager.hpp>
 #include <bitcoin/database/result/block_result.hpp>
+#include <bitcoin/database/sequence_lock.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -44,7 +55,9 @@ public:
     block_database(const path& map_filename,
         const path& candidate_index_filename,
         const path& confirmed_index_filename, const path& tx_index_filename,
-        size_t buckets, size_t expansion);
+        size_t buckets, size_t expansion, size_t reservation=0,
+        size_t header_cache_capacity=0,
+        storage_backend backend=storage_backend::file);
 
     /// Close the database (all threads must first be stopped).
     ~block_database();
@@ -58,12 +71,54 @@ public:
     /// Call before using the database.
     bool open();
 
+    /// Call before using the database, restoring the header caches from the
+    /// manifest of a clean shutdown (else reading them from the table).
+    bool open(const manifest& clean);
+
+    /// Save the header caches to the manifest, call before close.
+    void save(manifest& clean) const;
+
+    /// Call before using the database after an unclean shutdown (in place of
+    /// open), truncating each index to its consistent heights (verified on
+    /// up to threads threads) and rebuilding the hash index of the table.
+    bool recover(const transaction_database& transactions, size_t threads);
+
+    /// The number of consistent heights of the candidate|confirmed index,
+    /// from genesis to the first inconsistent header.
+    size_t verify(const transaction_database& transactions, bool candidate,
+        size_t threads) const;
+
+    /// Follow the writes of another process (read only), not concurrent
+    /// with queries. Remaps grown files and rereads table sizes.
+    bool refresh();
+
     /// Commit latest inserts.
     void commit();
 
     /// Flush the memory maps to disk.
     bool flush() const;
 
+    /// Schedule asynchronous writeback of newly-allocated space.
+    bool flush_dirty() const;
+
+    /// Begin journaling writes to the memory maps.
+    void enable_journal();
+
+    /// Advise the memory maps of the table and of the three indexes.
+    void enable_advice(const map_advice& table, const map_advice& index);
+
+    /// Apply the growth policy to the memory maps, must be closed.
+    void enable_file_growth(const file_growth& growth);
+
+    /// Allocate the next growth of the memory maps, if near full.
+    void pregrow();
+
+    /// Write journaled ranges to the commit log.
+    bool log_writes(commit_log& log);
+
+    /// The counters of the table, its indexes and their files.
+    table_metrics::values metrics() const;
+
     /// Call to unload the memory map.
     bool close();
 
@@ -79,6 +134,15 @@ public:
     /// Fetch block by hash.
     block_result get(const hash_digest& hash) const;
 
+    /// Fetch header values by block index height (cached for top heights).
+    bool get(cached_header& out_header, size_t height, bool candidate) const;
+
+    /// Get the link of the tx at the position of the block at the height,
+    /// without construction of a block result (or reading of its header).
+    /// False if the height is not indexed or the position is not populated.
+    bool get_transaction(file_offset& out_link, size_t height,
+        size_t position, bool candidate) const;
+
     /// Populate header metadata for the given header.
     void get_header_metadata(const chain::header& header) const;
 
@@ -98,15 +162,30 @@ public:
     /// Promote pooled|candidate block to candidate|confirmed respectively.
     bool index(const hash_digest& hash, size_t height, bool candidate);
 
+    /// Promote the blocks to candidate|confirmed from the first height, and
+    /// optionally also to valid, with one metadata lock and index allocation.
+    bool index(const hash_list& hashes, size_t first_height, bool candidate,
+        bool validate);
+
+    /// Store new headers and promote all to candidate from the first height,
+    /// allocating the records and the candidate index range once.
+    bool push(const header_const_ptr_list& headers, size_t first_height);
+
     /// Demote candidate|confirmed header to pooled|pooled (not candidate).
     bool unindex(const hash_digest& hash, size_t height, bool candidate);
 
+    /// Demote all candidate|confirmed headers above the fork height, with one
+    /// truncation of the index.
+    bool unindex_above(size_t fork_height, bool candidate);
+
 private:
     typedef hash_digest key_type;
     typedef array_index link_type;
     typedef record_manager<link_type> manager_type;
     typedef list_element<const manager_type, link_type, key_type> const_element;
-    typedef hash_table<manager_type, array_index, link_type, key_type> record_map;
+
+    // The block count is bounded by the buckets, so open addressing is used.
+    typedef hash_index<manager_type, array_index, link_type, key_type> record_map;
 
     typedef message::compact_block::short_id_list short_id_list;
 
@@ -116,6 +195,16 @@ private:
         uint32_t median_time_past, uint32_t checksum, link_type tx_start,
         size_t tx_count, uint8_t status);
 
+    // Header cache utilities.
+    void warm(header_cache& cache, bool candidate);
+    bool restore(header_cache& cache, bool candidate, const manifest& clean);
+    void set_state(const hash_digest& hash, size_t height, uint8_t state);
+
+    // Repair utilities.
+    bool consistent(size_t height, bool candidate,
+        const transaction_database& transactions) const;
+    void truncate(size_t count, bool candidate);
+
     // Index Utilities.
     bool read_top(size_t& out_height, const manager_type& manager) const;
     link_type read_index(size_t height, const manager_type& manager) const;
@@ -124,26 +213,33 @@ private:
 
     static const size_t prefix_size_;
 
+    // Counters, outlive the files that report to them.
+    table_metrics metrics_;
+
     // Hash table used for looking up block headers by hash.
-    file_storage hash_table_file_;
+    storage::ptr hash_table_file_;
     record_map hash_table_;
 
     // Table used for looking up candidate headers by height.
-    file_storage candidate_index_file_;
+    storage::ptr candidate_index_file_;
     manager_type candidate_index_;
 
     // Table used for looking up confirmed headers by height.
-    file_storage confirmed_index_file_;
+    storage::ptr confirmed_index_file_;
     manager_type confirmed_index_;
 
     // Association table between blocks and their contained transactions.
     // Only first tx is indexed and count is required to read the full set.
     // This indexes txs (vs. blocks) so the link type may be differentiated.
-    file_storage tx_index_file_;
+    storage::ptr tx_index_file_;
     manager_type tx_index_;
 
+    // These are thread safe, copies of the top of each index.
+    header_cache candidate_headers_;
+    header_cache confirmed_headers_;
+
     // This provides atomicity for checksum, tx_start, tx_count, state.
-    mutable shared_mutex metadata_mutex_;
+    mutable sequence_lock metadata_lock_;
 };
 
 } // namespace database
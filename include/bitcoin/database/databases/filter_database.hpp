@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_FILTER_DATABASE_HPP
+#define LIBBITCOIN_DATABASE_FILTER_DATABASE_HPP
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/map_advice.hpp>
+#include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/primitives/hash_table.hpp>
+#include <bitcoin/database/primitives/slab_manager.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This enables lookup of the BIP158 basic filter of a block by block hash.
+/// Each filter is stored with its filter header, which commits to the header
+/// of the previous block's filter. Filters are keyed by block hash, so those
+/// of blocks reorganized out remain valid and are not removed.
+class BCD_API filter_database
+{
+public:
+    typedef boost::filesystem::path path;
+
+    /// Construct the database.
+    filter_database(const path& map_filename, size_t buckets,
+        size_t expansion, size_t reservation=0,
+        storage_backend backend=storage_backend::file);
+
+    /// Close the database (all threads must first be stopped).
+    ~filter_database();
+
+    // Startup and shutdown.
+    // ------------------------------------------------------------------------
+
+    /// Initialize a new filter database.
+    bool create();
+
+    /// Call before using the database.
+    bool open();
+
+    /// Follow the writes of another process (read only), not concurrent
+    /// with queries. Remaps grown files and rereads table sizes.
+    bool refresh();
+
+    /// Commit latest inserts.
+    void commit();
+
+    /// Flush the memory map to disk.
+    bool flush() const;
+
+    /// Schedule asynchronous writeback of newly-allocated space.
+    bool flush_dirty() const;
+
+    /// Begin journaling writes to the memory map.
+    void enable_journal();
+
+    /// Advise the memory map of the table.
+    void enable_advice(const map_advice& advice);
+
+    /// Apply the growth policy to the memory map, must be closed.
+    void enable_file_growth(const file_growth& growth);
+
+    /// Allocate the next growth of the memory map, if near full.
+    void pregrow();
+
+    /// Write journaled ranges to the commit log.
+    bool log_writes(commit_log& log);
+
+    /// The counters of the table, its indexes and their files.
+    table_metrics::values metrics() const;
+
+    /// Grow the hash table buckets above the load factor (percentage).
+    void enable_growth(size_t load_percent);
+
+    /// Call to unload the memory map.
+    bool close();
+
+    // Queries.
+    //-------------------------------------------------------------------------
+
+    /// Get the filter header of the block, false if not found.
+    bool get(hash_digest& out_header, const hash_digest& block_hash) const;
+
+    /// Get the filter and filter header of the block, false if not found.
+    bool get(data_chunk& out_filter, hash_digest& out_header,
+        const hash_digest& block_hash) const;
+
+    // Store.
+    //-------------------------------------------------------------------------
+
+    /// Store the filter of the block (if not stored), false if the filter of
+    /// the previous block is not stored (unless the block is genesis).
+    bool store(const hash_digest& block_hash,
+        const hash_digest& previous_block_hash, const data_chunk& filter);
+
+private:
+    typedef hash_digest key_type;
+    typedef array_index index_type;
+    typedef file_offset link_type;
+    typedef slab_manager<link_type> manager_type;
+
+    // The block count is unbounded, so chained buckets are used.
+    typedef hash_table<manager_type, index_type, link_type, key_type> slab_map;
+
+    // Hash table used for looking up filters by block hash.
+    // Counters, outlive the file that reports to them.
+    table_metrics metrics_;
+
+    storage::ptr hash_table_file_;
+    slab_map hash_table_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_SPEND_DATABASE_HPP
+#define LIBBITCOIN_DATABASE_SPEND_DATABASE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/databases/transaction_database.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/map_advice.hpp>
+#include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/primitives/hash_table.hpp>
+#include <bitcoin/database/primitives/record_manager.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This enables lookup of the spender (input point) of a confirmed output by
+/// outpoint, in place of a scan of the txs of the block at its spender height.
+/// Rows are keyed by a fingerprint of the outpoint and verified against the
+/// input of the stored spender tx, so fingerprint collisions are probed past.
+/// An unwound spend remains as a vacant row, which is reused by the outpoint.
+class BCD_API spend_database
+{
+public:
+    typedef boost::filesystem::path path;
+
+    /// Construct the database (spenders are verified in the transactions).
+    spend_database(const path& map_filename, size_t buckets,
+        size_t expansion, const transaction_database& transactions,
+        size_t reservation=0, storage_backend backend=storage_backend::file);
+
+    /// Close the database (all threads must first be stopped).
+    ~spend_database();
+
+    // Startup and shutdown.
+    // ------------------------------------------------------------------------
+
+    /// Initialize a new spend database.
+    bool create();
+
+    /// Call before using the database.
+    bool open();
+
+    /// Follow the writes of another process (read only), not concurrent
+    /// with queries. Remaps grown files and rereads table sizes.
+    bool refresh();
+
+    /// Commit latest inserts.
+    void commit();
+
+    /// Flush the memory map to disk.
+    bool flush() const;
+
+    /// Schedule asynchronous writeback of newly-allocated space.
+    bool flush_dirty() const;
+
+    /// Begin journaling writes to the memory map.
+    void enable_journal();
+
+    /// Advise the memory map of the table.
+    void enable_advice(const map_advice& advice);
+
+    /// Apply the growth policy to the memory map, must be closed.
+    void enable_file_growth(const file_growth& growth);
+
+    /// Allocate the next growth of the memory map, if near full.
+    void pregrow();
+
+    /// Write journaled ranges to the commit log.
+    bool log_writes(commit_log& log);
+
+    /// The counters of the table, its indexes and their files.
+    table_metrics::values metrics() const;
+
+    /// Grow the hash table buckets above the load factor (percentage).
+    void enable_growth(size_t load_percent);
+
+    /// Call to unload the memory map.
+    bool close();
+
+    // Queries.
+    //-------------------------------------------------------------------------
+
+    /// Get the input point of the confirmed spender of the outpoint, false
+    /// if not spent in a confirmed block (or the spender is pruned).
+    bool get(chain::input_point& out_spender,
+        const chain::output_point& outpoint) const;
+
+    // Store.
+    //-------------------------------------------------------------------------
+
+    /// Index the spends of the confirmed txs (tx links must be set).
+    void index(const chain::transaction::list& transactions);
+
+    /// Unindex the spends of the tx of the link, as it is unconfirmed.
+    void unindex(file_offset link);
+
+private:
+    typedef byte_array<sizeof(uint64_t)> key_type;
+    typedef array_index index_type;
+    typedef array_index link_type;
+    typedef record_manager<link_type> manager_type;
+    typedef hash_table<manager_type, index_type, link_type, key_type>
+        record_map;
+
+    // The key of the outpoint at the probe of its collision sequence.
+    static key_type fingerprint(const chain::output_point& outpoint,
+        size_t probe);
+
+    // True if the input of the tx of the link spends the outpoint.
+    bool spends(chain::input_point& out_spender, file_offset link,
+        uint32_t input, const chain::output_point& outpoint) const;
+
+    void index(const chain::output_point& outpoint, file_offset link,
+        uint32_t input);
+    void unindex(const chain::output_point& outpoint, file_offset link,
+        uint32_t input);
+
+    // Counters, outlive the file that reports to them.
+    table_metrics metrics_;
+
+    storage::ptr hash_table_file_;
+    record_map hash_table_;
+
+    // Spender txs, for verification of fingerprint matches.
+    const transaction_database& transactions_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
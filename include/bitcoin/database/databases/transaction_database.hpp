@@ -19,14 +19,31 @@
 #ifndef LIBBITCOIN_DATABASE_TRANSACTION_DATABASE_HPP
 #define LIBBITCOIN_DATABASE_TRANSACTION_DATABASE_HPP
 
+#include <atomic>
 #include <cstddef>
+#include <unordered_map>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/map_advice.hpp>
+#include <bitcoin/database/eviction_policy.hpp>
+#include <bitcoin/database/hash_filter.hpp>
+#include <bitcoin/database/memory/block_arena.hpp>
 #include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
+#include <bitcoin/database/memory/storage.hpp>
 #include <bitcoin/database/primitives/hash_table.hpp>
 #include <bitcoin/database/primitives/slab_manager.hpp>
+#include <bitcoin/database/result/block_result.hpp>
 #include <bitcoin/database/result/transaction_result.hpp>
+#include <bitcoin/database/sequence_lock.hpp>
+#include <bitcoin/database/state_table.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+#include <bitcoin/database/transaction_pool.hpp>
 #include <bitcoin/database/unspent_outputs.hpp>
 
 namespace libbitcoin {
@@ -42,9 +59,17 @@ class BCD_API transaction_database
 public:
     typedef boost::filesystem::path path;
 
-    /// Construct the database.
+    /// Construct the database, a zero filter size disables the hash filter
+    /// and a zero pool budget stores unconfirmed txs in the table.
     transaction_database(const path& map_filename, size_t buckets,
-        size_t expansion, size_t cache_capacity);
+        size_t expansion, size_t cache_budget, size_t reservation=0,
+        const path& filter_filename={}, size_t filter_size=0,
+        size_t filter_error_ppm=0,
+        eviction_policy cache_policy=eviction_policy::fifo,
+        const path& transaction_state_filename={},
+        const path& output_state_filename={},
+        storage_backend backend=storage_backend::file,
+        size_t pool_budget=0);
 
     /// Close the database (all threads must first be stopped).
     ~transaction_database();
@@ -58,24 +83,116 @@ public:
     /// Call before using the database.
     bool open();
 
+    /// Call before using the database after an unclean shutdown, cutting
+    /// hash chains at links beyond the table (sets the number of cuts).
+    bool recover(size_t& out_cut);
+
+    /// Follow the writes of another process (read only), not concurrent
+    /// with queries. Remaps grown files and rereads table sizes.
+    bool refresh();
+
     /// Commit latest inserts.
     void commit();
 
     /// Flush the memory map to disk.
     bool flush() const;
 
+    /// Schedule asynchronous writeback of newly-allocated space.
+    bool flush_dirty() const;
+
+    /// Begin journaling writes to the memory map.
+    void enable_journal();
+
+    /// Advise the memory maps of the table and state table.
+    void enable_advice(const map_advice& advice);
+
+    /// Apply the growth policy to the memory maps, must be closed.
+    void enable_file_growth(const file_growth& growth);
+
+    /// Allocate the next growth of the memory maps, if near full.
+    void pregrow();
+
+    /// Compress the next cold segment of the table, if segmented.
+    size_t compress(size_t retain);
+
+    /// Write journaled ranges to the commit log.
+    bool log_writes(commit_log& log);
+
+    /// The counters of the table and its file.
+    table_metrics::values metrics() const;
+
+    /// The hit rate of the unspent output cache.
+    float cache_hit_rate() const;
+
+    /// Grow the hash table buckets above the load factor (percentage).
+    void enable_growth(size_t load_percent);
+
+    /// Partition block stores across threads (zero is all cores).
+    void enable_parallel(size_t threads);
+
+    /// Store new transactions with compact outputs (existing are unchanged).
+    void enable_compaction();
+
+    /// Store new transactions with input points linked to previous txs.
+    void enable_linked_inputs();
+
+    /// Store the mutable state of new transactions in the state table.
+    void enable_split_state();
+
+    /// Store new split transactions followed by a checksum of the record.
+    void enable_checksums();
+
+    /// Verify the checksum of every nth checked record read by get (zero is
+    /// none), a mismatch is logged, counted and read as not found.
+    void enable_verification(size_t sample_rate);
+
+    /// The average number of entries per hash table bucket.
+    float load_factor() const;
+
+    /// The expected hash filter false positive rate (one if disabled).
+    float filter_false_positive_rate() const;
+
+    /// Save the output cache as valid at the confirmed top height.
+    bool save_cache(const path& filename, size_t top_height) const;
+
+    /// Load an output cache saved at the confirmed top height.
+    bool load_cache(const path& filename, size_t top_height);
+
     /// Call to unload the memory map.
     bool close();
 
     // Queries.
     //-------------------------------------------------------------------------
 
+    /// True if the link is within the table (not that it is a tx).
+    bool contains(file_offset link) const;
+
     /// Fetch transaction by its link.
     transaction_result get(file_offset link) const;
 
     /// Fetch transaction by its hash.
     transaction_result get(const hash_digest& hash) const;
 
+    /// Fetch an unconfirmed transaction from the pool by its hash, with the
+    /// forks at which it was validated (null if not pooled).
+    transaction_pool::transaction_ptr get_pooled(const hash_digest& hash,
+        uint32_t& out_forks) const;
+
+    /// Fetch the transactions of the block in one pass over its links, the
+    /// metadata of each is not read (false if any is missing).
+    bool get_transactions(chain::transaction::list& out_transactions,
+        const block_result& block, bool witness=true) const;
+
+    /// Append the wire serialization of the block (header, tx count and
+    /// transactions) to the buffer, transcoded from the mapped records as
+    /// for serving (false and unchanged if any tx is missing or pruned).
+    bool get_block_data(data_chunk& out_data, const block_result& block,
+        bool witness=true) const;
+
+    /// Advise a sequential read of the txs stored in the link range, for the
+    /// lifetime of the guard (e.g. the txs of a block, which are contiguous).
+    scan_guard::ptr scan(file_offset first, file_offset last) const;
+
     /// Populate tx metadata for the given block context.
     void get_block_metadata( chain::transaction& tx, uint32_t forks,
         size_t fork_height) const;
@@ -87,15 +204,30 @@ public:
     bool get_output(const chain::output_point& point, size_t fork_height,
         bool candidate) const;
 
+    /// The output of the point is spent in the given context, reading only
+    /// its spend metadata (the output is not populated). False if the point
+    /// is null or its transaction is not found.
+    bool is_spent(const chain::output_point& point, size_t fork_height,
+        bool candidate) const;
+
+    /// Populate output metadata for all prevouts of the block, returns the
+    /// number of prevouts populated.
+    size_t get_outputs(const chain::block& block, size_t fork_height,
+        bool candidate) const;
+
     // Writers.
     // ------------------------------------------------------------------------
 
-    /// Store a transaction not associated with a block.
+    /// Store a transaction not associated with a block (pooled if enabled).
     bool store( chain::transaction& tx, uint32_t forks);
 
     /// Store a set of transactions associated with an unconfirmed block.
     bool store( chain::transaction::list& transactions);
 
+    /// Store a set of transactions associated with an unconfirmed block, if
+    /// linked the link of each stored tx is set so unlinked txs are missing.
+    bool store( chain::transaction::list& transactions, bool linked);
+
     /// Store a set of transactions associated with a confirmed block.
     bool store( chain::transaction::list& transactions, size_t height,
         uint32_t median_time_past);
@@ -103,11 +235,14 @@ public:
     /// Mark outputs spent by the candidate tx.
     bool candidate(file_offset link);
 
+    /// Mark the txs of a candidate block and the outputs spent by them.
+    bool candidate(const chain::transaction::list& transactions);
+
     /// Unmark outputs formerly spent by the candidate tx.
     bool uncandidate(file_offset link);
 
     /// Promote the set of transactions associated with a block to confirmed.
-    bool confirm( chain::transaction::list& transactions, size_t height,
+    bool confirm(const chain::transaction::list& transactions, size_t height,
         uint32_t median_time_past);
 
     /// Promote the transaction to confirmed.
@@ -117,17 +252,112 @@ public:
     /// Demote the transaction to pooled.
     bool unconfirm(file_offset link);
 
+    /// Demote the transactions to pooled, from stored links and inpoints.
+    bool unconfirm(const std::vector<file_offset>& links);
+
+    /// Prune each previous tx of the inputs of the confirmed txs whose
+    /// outputs are all spent at or below the height (that of the txs).
+    /// Returns the number of txs pruned.
+    size_t prune(const std::vector<file_offset>& links, size_t height);
+
+    // Snapshot.
+    // ------------------------------------------------------------------------
+
+    /// Read the header of an unspent output snapshot, with the number of its
+    /// transactions (for sizing of the table into which it is imported).
+    static bool read_snapshot(const path& filename, size_t& out_height,
+        hash_digest& out_block_hash, uint64_t& out_transactions);
+
+    /// Write the confirmed outputs unspent at the height (of the block hash)
+    /// to a chunked and checksummed snapshot, walking the table on threads.
+    bool export_unspent(const path& filename, size_t height,
+        const hash_digest& block_hash) const;
+
+    /// Store the txs of the snapshot outputs, confirmed at their heights and
+    /// with other outputs spent at the snapshot height (inputs are empty).
+    bool import_unspent(const path& filename);
+
 private:
     typedef hash_digest key_type;
     typedef array_index index_type;
     typedef file_offset link_type;
     typedef slab_manager<link_type> manager_type;
+
+    // The transaction count is unbounded, so chained buckets are used.
     typedef hash_table<manager_type, index_type, link_type, key_type> slab_map;
 
+    // Populate output metadata from the found tx of the point.
+    bool populate(const chain::output_point& point,
+        const transaction_result& result, size_t fork_height,
+        bool candidate) const;
+
+    // Record the link of a tx found by output lookup, for use when spending.
+    void remember(const hash_digest& hash, link_type link) const;
+
+    // Record the link of the tx of a linked input point, for use when spending.
+    void remember(const inpoint_iterator& inpoint) const;
+
+    // Populate output metadata from the pooled tx of the point.
+    bool populate_pooled(const chain::output_point& point) const;
+
+    // Find a spent tx, by its remembered link if found by output lookup.
+    slab_map::const_value_type find_spent(const hash_digest& hash) const;
+
+    // The result, or not found if sampled and its checksum does not match.
+    transaction_result verified(transaction_result&& result) const;
+
     // Store a transaction.
     //-------------------------------------------------------------------------
+    bool compact(const chain::transaction& tx) const;
+    void store_state(const chain::transaction& tx, link_type state,
+        link_type outputs, size_t height, size_t position,
+        uint32_t median_time_past) const;
+    bool find_state(const slab_map::const_value_type& element,
+        link_type& out_state, link_type& out_outputs) const;
+    std::vector<link_type> link_inputs(const chain::transaction& tx) const;
     bool storize( chain::transaction& tx, size_t height,
         uint32_t median_time_past, size_t position);
+    link_type write(const hash_digest& key, const chain::transaction& tx,
+        size_t height, uint32_t median_time_past, size_t position);
+    bool storize( chain::transaction::list& transactions, size_t height,
+        uint32_t median_time_past, bool confirmed, bool linked);
+
+    // A stored output spent by a block, by tx link and record offset, and
+    // by output state ordinal if the tx is split (otherwise not found).
+    struct spend_target
+    {
+        link_type link;
+        size_t offset;
+        link_type state;
+    };
+
+    // The temporaries of a block write are allocated from the arena.
+    typedef std::vector<spend_target, arena_allocator<spend_target>>
+        spend_targets;
+    typedef std::vector<const chain::output_point*,
+        arena_allocator<const chain::output_point*>> point_list;
+
+    // The half-open range [first, last) of points or targets of one spent tx.
+    struct spend_group
+    {
+        size_t first;
+        size_t last;
+    };
+
+    typedef std::vector<spend_group, arena_allocator<spend_group>>
+        spend_groups;
+
+    // Locate the outputs spent by the txs, with one lookup for each spent tx.
+    bool locate_spends(const chain::transaction::list& transactions,
+        bool confirmed, size_t spender_height, spend_targets& targets) const;
+
+    // Locate the outputs spent at the points (sorted in place by hash).
+    bool locate_spends(point_list& points, bool confirmed,
+        size_t spender_height, spend_targets& targets) const;
+
+    // Locate the outputs spent at the points of the group (thread safe).
+    bool locate_spends(const point_list& points, const spend_group& group,
+        bool confirmed, size_t spender_height, spend_target* targets) const;
 
     // Update the candidate state of the tx.
     //-------------------------------------------------------------------------
@@ -136,6 +366,13 @@ private:
     // Update the candidate spent of the output.
     bool candidate_spend(const chain::output_point& point, bool positive);
 
+    // Update the candidate spent of all outputs spent by the txs.
+    bool candidate_spend(const chain::transaction::list& transactions,
+        bool positive);
+
+    // Update the candidate spent of the located outputs.
+    void candidate_spend(const spend_targets& targets, bool positive);
+
     // Update the candidate metadata of the existing tx.
     bool candidize(link_type link, bool candidate);
 
@@ -144,19 +381,57 @@ private:
     bool confirmed_spend(const chain::output_point& point,
         size_t spender_height);
 
+    // Update the spender height of all outputs spent by the txs.
+    bool confirmed_spend(const chain::transaction::list& transactions,
+        size_t spender_height);
+
+    // Update the spender height of the located outputs.
+    void confirmed_spend(const spend_targets& targets, size_t spender_height);
+
     // Promote metadata of the existing tx to confirmed.
     bool confirmize(link_type link, size_t height, uint32_t median_time_past,
         size_t position);
 
+    // Release the outputs and inputs of the existing tx, if all spent.
+    bool prune(link_type link, size_t height);
+
     // Hash table used for looking up txs by hash.
-    file_storage hash_table_file_;
+    // Counters, outlive the file that reports to them.
+    table_metrics metrics_;
+
+    storage::ptr hash_table_file_;
     slab_map hash_table_;
+    size_t threads_;
+    bool compact_;
+    bool linked_;
+    bool split_;
+    bool checksums_;
+    size_t sample_rate_;
+    mutable std::atomic<size_t> reads_;
+    mutable std::atomic<uint64_t> corruptions_;
+
+    // Mutable state of split transactions, by ordinal.
+    state_table state_;
+
+    // Negative lookups are resolved without touching the table.
+    const path filter_filename_;
+    hash_filter filter_;
 
     // This is thread safe.
     unspent_outputs cache_;
 
+    // This is thread safe.
+    transaction_pool pool_;
+
     // This provides atomicity for height and position.
-    mutable shared_mutex metadata_mutex_;
+    mutable sequence_lock metadata_lock_;
+
+    // Temporaries of the writer, released at the end of each block write.
+    mutable block_arena arena_;
+
+    // Links of txs found by output lookup, saving a lookup when spent.
+    mutable std::unordered_map<hash_digest, link_type> spent_links_;
+    mutable shared_mutex spent_links_mutex_;
 };
 
 } // namespace database
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_FILE_GROWTH_HPP
+#define LIBBITCOIN_DATABASE_FILE_GROWTH_HPP
+
+#include <cstdint>
+
+namespace libbitcoin {
+namespace database {
+
+/// The growth of a table file beyond its physical size.
+enum class growth_policy : uint8_t
+{
+    /// Grow by the expansion rate (percentage) of the required size.
+    geometric = 0,
+
+    /// Grow by the chunk beyond the required size.
+    fixed = 1,
+
+    /// Grow by the expansion rate, limited to the chunk.
+    capped = 2
+};
+
+/// The growth of the file of a table, applied by each reservation beyond its
+/// physical size. Value initialization (all zero) is geometric growth.
+struct file_growth
+{
+    /// The growth policy.
+    growth_policy policy;
+
+    /// The fixed growth, or the limit of capped growth, in bytes.
+    uint64_t chunk;
+
+    /// Allocate the growth on disk (fallocate) rather than leave it sparse.
+    bool preallocate;
+
+    /// Allocate the next growth in the background once the logical size
+    /// reaches this percentage of the physical size (zero disables).
+    uint8_t pregrow_percent;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
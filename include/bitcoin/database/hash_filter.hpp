@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_HASH_FILTER_HPP
+#define LIBBITCOIN_DATABASE_HASH_FILTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// A blocked Bloom filter of hash digests, for lookups that usually miss.
+/// The bits of each hash are set within one 64 byte block (a cache line).
+/// A filter that is not valid (not loaded) contains every hash.
+class BCD_API hash_filter
+  : noncopyable
+{
+public:
+    typedef boost::filesystem::path path;
+
+    /// Construct a filter of size bytes (zero disables the filter), with bit
+    /// count chosen for the false positive rate (parts per million).
+    hash_filter(size_t size, size_t error_ppm);
+
+    /// The filter size is zero.
+    bool disabled() const;
+
+    /// The filter reflects every hash of its set (created or loaded).
+    bool valid() const;
+
+    /// Reset the filter to reflect an empty set.
+    void create();
+
+    /// Load the filter saved for a set of count hashes, and remove the file
+    /// so that a filter cannot be reloaded after an unclean shutdown.
+    bool load(const path& filename, uint64_t count);
+
+    /// Save the filter for reload at next open, if valid.
+    bool save(const path& filename) const;
+
+    /// Add the hash to the filter.
+    void insert(const hash_digest& hash);
+
+    /// False implies the hash is not in the set.
+    bool contains(const hash_digest& hash) const;
+
+    /// The number of bits set for each hash.
+    size_t hashes() const;
+
+    /// The filter size in bytes.
+    size_t size() const;
+
+    /// The expected false positive rate given the hashes inserted.
+    float false_positive_rate() const;
+
+private:
+    typedef std::vector<std::atomic<uint64_t>> words;
+
+    size_t block(const hash_digest& hash) const;
+
+    // These are thread safe.
+    const size_t hashes_;
+    const size_t blocks_;
+    std::atomic<bool> valid_;
+    std::atomic<uint64_t> count_;
+    words words_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
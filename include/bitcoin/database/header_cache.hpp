@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_HEADER_CACHE_HPP
+#define LIBBITCOIN_DATABASE_HEADER_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// The header values of an indexed block used by header sync and chain state.
+struct BCD_API cached_header
+{
+    hash_digest hash;
+    uint32_t bits;
+    uint32_t timestamp;
+    uint32_t version;
+    uint32_t median_time_past;
+    uint32_t height;
+    uint8_t state;
+};
+
+/// This class is thread safe.
+/// A contiguous cache of the top headers of one block index, by height.
+/// Headers are pushed and popped with the index, so the cache holds a window
+/// of consecutive heights ending at the top of the index.
+class BCD_API header_cache
+  : noncopyable
+{
+public:
+    /// Construct a cache of the specified number of headers.
+    header_cache(size_t capacity);
+
+    /// The cache capacity is zero.
+    bool disabled() const;
+
+    /// The maximum number of headers in the cache.
+    size_t capacity() const;
+
+    /// The number of headers in the cache.
+    size_t size() const;
+
+    /// Get the header at the height, false if not cached.
+    bool get(cached_header& out_header, size_t height) const;
+
+    /// Add the header at the top of the index.
+    void push(const cached_header& header);
+
+    /// Remove the header at the top of the index.
+    void pop(size_t height);
+
+    /// Update the state of the header, if cached.
+    void set_state(const hash_digest& hash, size_t height, uint8_t state);
+
+    /// Remove all headers.
+    void clear();
+
+    /// Serialize the headers, in height order.
+    data_chunk to_data() const;
+
+    /// Replace the headers with those serialized, the lowest of which are
+    /// dropped if above capacity. False (and empty) if the data is invalid.
+    bool from_data(const data_chunk& data);
+
+private:
+    static const size_t serialized_size;
+
+    // A circular buffer of the heights [first_, top_).
+    std::vector<cached_header> headers_;
+    size_t first_;
+    size_t top_;
+
+    mutable shared_mutex mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
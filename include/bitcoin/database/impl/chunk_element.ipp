@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_CHUNK_ELEMENT_IPP
+#define LIBBITCOIN_DATABASE_CHUNK_ELEMENT_IPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// A chunk is a block of store memory with the following layout.
+// Only the count and free rows of the first chunk of a list are written in
+// place, the count under the mutex and only after the row is written.
+// [ next     ] Link
+// [ capacity ] uint8_t
+// [ count    ] uint8_t
+// [ rows...  ] capacity * value_size (oldest first)
+
+// static
+template <typename Manager, typename Link>
+size_t chunk_element<Manager, Link>::size(size_t capacity,
+    size_t value_size)
+{
+    return header_size + capacity * value_size;
+}
+
+// static
+template <typename Manager, typename Link>
+uint64_t chunk_element<Manager, Link>::position(Link chunk, size_t slot)
+{
+    if (chunk == not_found)
+        return max_uint64;
+
+    return (static_cast<uint64_t>(chunk) << slot_bits) | slot;
+}
+
+template <typename Manager, typename Link>
+chunk_element<Manager, Link>::chunk_element(Manager& manager,
+    size_t value_size, shared_mutex& mutex)
+  : chunk_(not_found),
+    slot_(0),
+    value_size_(value_size),
+    manager_(manager),
+    mutex_(mutex)
+{
+}
+
+template <typename Manager, typename Link>
+chunk_element<Manager, Link>::chunk_element(Manager& manager,
+    size_t value_size, Link chunk, shared_mutex& mutex)
+  : chunk_(not_found),
+    slot_(0),
+    value_size_(value_size),
+    manager_(manager),
+    mutex_(mutex)
+{
+    seek(chunk);
+}
+
+template <typename Manager, typename Link>
+chunk_element<Manager, Link>::chunk_element(Manager& manager,
+    size_t value_size, Link chunk, size_t slot, shared_mutex& mutex)
+  : chunk_(chunk),
+    slot_(slot),
+    value_size_(value_size),
+    manager_(manager),
+    mutex_(mutex)
+{
+}
+
+// private
+// Position to the newest row of the chunk, skipping any emptied chunk.
+template <typename Manager, typename Link>
+void chunk_element<Manager, Link>::seek(Link chunk)
+{
+    while (chunk != not_found)
+    {
+        const auto memory = manager_.pin(chunk);
+        auto deserial = make_unsafe_deserializer(memory.buffer());
+        Link next;
+        size_t count;
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        {
+            shared_lock lock(mutex_);
+            next = deserial.template read_little_endian<Link>();
+            deserial.skip(sizeof(uint8_t));
+            count = deserial.read_byte();
+        }
+        ///////////////////////////////////////////////////////////////////////
+
+        if (count != 0)
+        {
+            chunk_ = chunk;
+            slot_ = count - 1u;
+            return;
+        }
+
+        chunk = next;
+    }
+
+    terminate();
+}
+
+// Jump to the next older row in the list.
+template <typename Manager, typename Link>
+bool chunk_element<Manager, Link>::jump_next()
+{
+    if (chunk_ == not_found)
+        return false;
+
+    if (slot_ != 0)
+    {
+        --slot_;
+        return true;
+    }
+
+    auto memory = manager_.pin(chunk_);
+    auto deserial = make_unsafe_deserializer(memory.buffer());
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    Link next;
+    {
+        shared_lock lock(mutex_);
+        next = deserial.template read_little_endian<Link>();
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    seek(next);
+    return true;
+}
+
+template <typename Manager, typename Link>
+void chunk_element<Manager, Link>::terminate()
+{
+    chunk_ = not_found;
+    slot_ = 0;
+}
+
+template <typename Manager, typename Link>
+template <typename Reader>
+void chunk_element<Manager, Link>::read(Reader reader) const
+{
+    BITCOIN_ASSERT(chunk_ != not_found);
+    auto memory = manager_.pin(chunk_);
+    memory.increment(header_size + slot_ * value_size_);
+    auto deserial = make_unsafe_deserializer(memory.buffer());
+    reader(deserial);
+}
+
+template <typename Manager, typename Link>
+Link chunk_element<Manager, Link>::chunk() const
+{
+    return chunk_;
+}
+
+template <typename Manager, typename Link>
+uint64_t chunk_element<Manager, Link>::position() const
+{
+    return position(chunk_, slot_);
+}
+
+template <typename Manager, typename Link>
+chunk_element<Manager, Link>
+chunk_element<Manager, Link>::terminator() const
+{
+    return { manager_, value_size_, mutex_ };
+}
+
+template <typename Manager, typename Link>
+bool chunk_element<Manager, Link>::terminal() const
+{
+    return chunk_ == not_found;
+}
+
+template <typename Manager, typename Link>
+chunk_element<Manager, Link>::operator bool() const
+{
+    return !terminal();
+}
+
+template <typename Manager, typename Link>
+bool chunk_element<Manager, Link>::operator==(
+    const chunk_element& other) const
+{
+    return chunk_ == other.chunk_ && slot_ == other.slot_;
+}
+
+template <typename Manager, typename Link>
+bool chunk_element<Manager, Link>::operator!=(
+    const chunk_element& other) const
+{
+    return !(*this == other);
+}
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
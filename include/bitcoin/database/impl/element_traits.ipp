@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_ELEMENT_TRAITS_IPP
+#define LIBBITCOIN_DATABASE_ELEMENT_TRAITS_IPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <bitcoin/bitcoin.hpp>
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+    #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        #define BC_ELEMENT_BIG_ENDIAN
+    #endif
+#endif
+
+namespace libbitcoin {
+namespace database {
+
+// Words are copied, since elements are not aligned.
+template <typename Word>
+inline Word load_word(const uint8_t* buffer, size_t offset)
+{
+    Word word;
+    std::memcpy(&word, buffer + offset, sizeof(Word));
+    return word;
+}
+
+template <typename Word>
+inline Word differ_word(const uint8_t* left, const uint8_t* right,
+    size_t offset)
+{
+    return load_word<Word>(left, offset) ^ load_word<Word>(right, offset);
+}
+
+// key_compare
+// ----------------------------------------------------------------------------
+
+template <size_t Size>
+bool key_compare<Size>::equal(const uint8_t* left, const uint8_t* right)
+{
+    return std::memcmp(left, right, Size) == 0;
+}
+
+inline bool key_compare<hash_size>::equal(const uint8_t* left,
+    const uint8_t* right)
+{
+    return (differ_word<uint64_t>(left, right, 0) |
+        differ_word<uint64_t>(left, right, 8) |
+        differ_word<uint64_t>(left, right, 16) |
+        differ_word<uint64_t>(left, right, 24)) == 0;
+}
+
+inline bool key_compare<short_hash_size>::equal(const uint8_t* left,
+    const uint8_t* right)
+{
+    return (differ_word<uint64_t>(left, right, 0) |
+        differ_word<uint64_t>(left, right, 8) |
+        differ_word<uint32_t>(left, right, 16)) == 0;
+}
+
+// element_traits
+// ----------------------------------------------------------------------------
+
+template <typename Link, typename Key>
+const size_t element_traits<Link, Key>::key_size;
+
+template <typename Link, typename Key>
+const size_t element_traits<Link, Key>::next_offset;
+
+template <typename Link, typename Key>
+const size_t element_traits<Link, Key>::value_offset;
+
+template <typename Link, typename Key>
+size_t element_traits<Link, Key>::size(size_t value_size)
+{
+    return value_offset + value_size;
+}
+
+template <typename Link, typename Key>
+bool element_traits<Link, Key>::match(const uint8_t* element, const Key& key)
+{
+    return key_compare<key_size>::equal(element, key.data());
+}
+
+// The link is stored little-endian, so on a little-endian platform it is
+// copied as a word (a single unaligned load or store).
+template <typename Link, typename Key>
+Link element_traits<Link, Key>::read_next(const uint8_t* element)
+{
+#ifdef BC_ELEMENT_BIG_ENDIAN
+    Link next = 0;
+
+    for (size_t byte = 0; byte < sizeof(Link); ++byte)
+        next |= static_cast<Link>(static_cast<uint64_t>(
+            element[next_offset + byte]) << (byte * 8u));
+
+    return next;
+#else
+    return load_word<Link>(element, next_offset);
+#endif
+}
+
+template <typename Link, typename Key>
+void element_traits<Link, Key>::write_next(uint8_t* element, Link next)
+{
+#ifdef BC_ELEMENT_BIG_ENDIAN
+    for (size_t byte = 0; byte < sizeof(Link); ++byte)
+        element[next_offset + byte] = static_cast<uint8_t>(
+            static_cast<uint64_t>(next) >> (byte * 8u));
+#else
+    std::memcpy(element + next_offset, &next, sizeof(Link));
+#endif
+}
+
+// The stored link is little-endian, so the atomic link is of the same value
+// only on a little-endian platform.
+template <typename Link, typename Key>
+bool element_traits<Link, Key>::atomic_next(const uint8_t* element)
+{
+#ifdef BC_ELEMENT_BIG_ENDIAN
+    return false;
+#else
+    const auto address = reinterpret_cast<uintptr_t>(element + next_offset);
+    return address % alignof(std::atomic<Link>) == 0;
+#endif
+}
+
+template <typename Link, typename Key>
+Link element_traits<Link, Key>::load_next(const uint8_t* element)
+{
+    BITCOIN_ASSERT(atomic_next(element));
+    const auto next = reinterpret_cast<const std::atomic<Link>*>(element +
+        next_offset);
+
+    return next->load(std::memory_order_acquire);
+}
+
+template <typename Link, typename Key>
+void element_traits<Link, Key>::store_next(uint8_t* element, Link next)
+{
+    BITCOIN_ASSERT(atomic_next(element));
+    const auto link = reinterpret_cast<std::atomic<Link>*>(element +
+        next_offset);
+
+    link->store(next, std::memory_order_release);
+}
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
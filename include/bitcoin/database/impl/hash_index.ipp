@@ -0,0 +1,493 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_HASH_INDEX_IPP
+#define LIBBITCOIN_DATABASE_HASH_INDEX_IPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/primitives/hash_table_header.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+template <typename Manager, typename Index, typename Link, typename Key>
+const size_t hash_index<Manager, Index, Link, Key>::bucket_size;
+
+template <typename Manager, typename Index, typename Link, typename Key>
+const size_t hash_index<Manager, Index, Link, Key>::slots;
+
+template <typename Manager, typename Index, typename Link, typename Key>
+const Link hash_index<Manager, Index, Link, Key>::not_found =
+    (Link)bc::max_uint64;
+
+template <typename Manager, typename Index, typename Link, typename Key>
+const uint16_t hash_index<Manager, Index, Link, Key>::removed;
+
+// static
+template <typename Manager, typename Index, typename Link, typename Key>
+size_t hash_index<Manager, Index, Link, Key>::size(Index buckets)
+{
+    // The size and version are padded to a bucket, aligning the buckets.
+    return bucket_offset(buckets);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+hash_index<Manager, Index, Link, Key>::hash_index(storage& file,
+    Index buckets)
+  : file_(file),
+    buckets_(buckets),
+    manager_(file, size(buckets)),
+    metrics_(nullptr)
+{
+    static_assert(std::is_unsigned<Link>::value,
+        "Hash index requires unsigned link type.");
+
+    static_assert(slots > 0, "Hash index link type is too large.");
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+hash_index<Manager, Index, Link, Key>::hash_index(storage& file,
+    Index buckets, size_t value_size)
+  : file_(file),
+    buckets_(buckets),
+    manager_(file, size(buckets), value_type::size(value_size)),
+    metrics_(nullptr)
+{
+    static_assert(std::is_unsigned<Link>::value,
+        "Hash index requires unsigned link type.");
+
+    static_assert(slots > 0, "Hash index link type is too large.");
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_index<Manager, Index, Link, Key>::create()
+{
+    const auto file_size = size(buckets_);
+    const auto prior = std::min(file_.logical_size(), file_size);
+
+    // The accessor must remain in scope until the end of the block.
+    {
+        const auto memory = file_.resize(file_size);
+
+        // Empty links are stored as zero (complemented), so the extension of
+        // the file (sparse where supported) is empty slots.
+        memset(memory->buffer(), 0, prior);
+
+        auto serial = make_unsafe_serializer(memory->buffer());
+        serial.template write_little_endian<Index>(buckets_);
+        serial.template write_little_endian<Index>(
+            hash_table_header<Index, Link>::version);
+    }
+
+    return manager_.create();
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_index<Manager, Index, Link, Key>::start()
+{
+    return verify() && manager_.start();
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_index<Manager, Index, Link, Key>::recover()
+{
+    return verify() && manager_.recover();
+}
+
+// Slots are cleared as in create and the elements relinked in the order of
+// the manager, so elements of one key are again found in the order added.
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_index<Manager, Index, Link, Key>::rebuild()
+{
+    const auto first = bucket_offset(0);
+    const auto count = manager_.count();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(index_mutex_);
+
+    // The accessor must remain in scope until the end of the block.
+    {
+        const auto memory = file_.access();
+        memset(memory->buffer() + first, 0, bucket_offset(buckets_) - first);
+    }
+
+    for (Link link = 0; link < count; ++link)
+    {
+        const auto key = find(link).key();
+        const auto slot = vacancy(key);
+
+        if (slot == max_size_t)
+            throw std::runtime_error("The hash index is full.");
+
+        write(slot, hash_table_header<Index, Link>::fingerprint(key), link);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_index<Manager, Index, Link, Key>::contains(Link link) const
+{
+    return manager_.contains(link);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_index<Manager, Index, Link, Key>::commit()
+{
+    return manager_.commit();
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+typename hash_index<Manager, Index, Link, Key>::value_type
+hash_index<Manager, Index, Link, Key>::allocator()
+{
+    return { manager_, list_mutex_ };
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+Link hash_index<Manager, Index, Link, Key>::allocate(size_t size)
+{
+    return manager_.allocate(size);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+typename hash_index<Manager, Index, Link, Key>::const_value_type
+hash_index<Manager, Index, Link, Key>::find(const Key& key) const
+{
+    auto link = not_found;
+    size_t probes = 0;
+    const auto slot = search(key, link, probes);
+
+    if (metrics_ != nullptr)
+        metrics_->lookup(slot != max_size_t, probes);
+
+    return find(link);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+typename hash_index<Manager, Index, Link, Key>::const_value_type
+hash_index<Manager, Index, Link, Key>::find(Link link) const
+{
+    return { manager_, link, list_mutex_ };
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+typename hash_index<Manager, Index, Link, Key>::const_value_type
+hash_index<Manager, Index, Link, Key>::terminator() const
+{
+    return find(not_found);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_index<Manager, Index, Link, Key>::enable_metrics(
+    table_metrics& metrics)
+{
+    metrics_ = &metrics;
+    manager_.enable_metrics(metrics);
+}
+
+// Probes from the key's bucket to the first empty slot. Elements of a key
+// are therefore found in the order added.
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_index<Manager, Index, Link, Key>::link(value_type& element)
+{
+    const auto key = element.key();
+    const auto fingerprint = hash_table_header<Index, Link>::fingerprint(key);
+    auto bucket = hash_table_header<Index, Link>::remainder(key, buckets_);
+    fingerprint_type fingerprints[slots];
+    Link links[slots];
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    index_mutex_.lock_upgrade();
+
+    for (Index probe = 0; probe < buckets_; ++probe, bucket = next(bucket))
+    {
+        read(bucket, fingerprints, links);
+
+        for (size_t slot = 0; slot < slots; ++slot)
+        {
+            if (links[slot] == not_found)
+            {
+                index_mutex_.unlock_upgrade_and_lock();
+                //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+                write(bucket * slots + slot, fingerprint, element.link());
+                index_mutex_.unlock();
+                //-------------------------------------------------------------
+                return;
+            }
+        }
+    }
+
+    index_mutex_.unlock_upgrade();
+    ///////////////////////////////////////////////////////////////////////////
+
+    throw std::runtime_error("The hash index is full.");
+}
+
+// Elements of one key are found in the order of the vector.
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_index<Manager, Index, Link, Key>::link(
+    std::vector<value_type>& elements)
+{
+    if (elements.empty())
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(index_mutex_);
+
+    for (auto& element: elements)
+    {
+        const auto key = element.key();
+        const auto slot = vacancy(key);
+
+        if (slot == max_size_t)
+            throw std::runtime_error("The hash index is full.");
+
+        write(slot, hash_table_header<Index, Link>::fingerprint(key),
+            element.link());
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Unlink the last of matching key value, retaining the slot for probing.
+// Unlink is not executed concurrently with writes.
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_index<Manager, Index, Link, Key>::unlink(const Key& key)
+{
+    auto link = not_found;
+    size_t probes = 0;
+    const auto slot = search(key, link, probes);
+
+    if (slot == max_size_t)
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(index_mutex_);
+    write(slot, removed, link);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+size_t hash_index<Manager, Index, Link, Key>::search(const Key& key,
+    Link& link, size_t& probes) const
+{
+    const auto fingerprint = hash_table_header<Index, Link>::fingerprint(key);
+    auto bucket = hash_table_header<Index, Link>::remainder(key, buckets_);
+    auto found = max_size_t;
+    fingerprint_type fingerprints[slots];
+    Link links[slots];
+
+    for (Index probe = 0; probe < buckets_; ++probe, bucket = next(bucket))
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        index_mutex_.lock_shared();
+        read(bucket, fingerprints, links);
+        index_mutex_.unlock_shared();
+        ///////////////////////////////////////////////////////////////////////
+
+        ++probes;
+
+        // Slots beyond the first empty slot are not part of the probe.
+        const auto empty = empties(links);
+        const auto probed = empty == 0 ? ~slot_mask(0) :
+            static_cast<slot_mask>(~empty & (empty - 1u));
+        auto hits = matches(fingerprints, fingerprint) & probed;
+
+        // The element is read only for a matching fingerprint.
+        for (size_t slot = 0; hits != 0; ++slot, hits >>= 1)
+        {
+            if ((hits & 1) != 0 && find(links[slot]).match(key))
+            {
+                found = bucket * slots + slot;
+                link = links[slot];
+            }
+        }
+
+        if (empty != 0)
+            return found;
+    }
+
+    return found;
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+typename hash_index<Manager, Index, Link, Key>::slot_mask
+hash_index<Manager, Index, Link, Key>::matches(
+    const fingerprint_type fingerprints[], fingerprint_type fingerprint)
+{
+    slot_mask mask = 0;
+
+    for (size_t slot = 0; slot < slots; ++slot)
+        mask |= slot_mask(fingerprints[slot] == fingerprint) << slot;
+
+    return mask;
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+typename hash_index<Manager, Index, Link, Key>::slot_mask
+hash_index<Manager, Index, Link, Key>::empties(const Link links[])
+{
+    slot_mask mask = 0;
+
+    for (size_t slot = 0; slot < slots; ++slot)
+        mask |= slot_mask(links[slot] == not_found) << slot;
+
+    return mask;
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+size_t hash_index<Manager, Index, Link, Key>::vacancy(const Key& key) const
+{
+    auto bucket = hash_table_header<Index, Link>::remainder(key, buckets_);
+    fingerprint_type fingerprints[slots];
+    Link links[slots];
+
+    for (Index probe = 0; probe < buckets_; ++probe, bucket = next(bucket))
+    {
+        read(bucket, fingerprints, links);
+
+        auto empty = empties(links);
+
+        for (size_t slot = 0; empty != 0; ++slot, empty >>= 1)
+            if ((empty & 1) != 0)
+                return bucket * slots + slot;
+    }
+
+    return max_size_t;
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_index<Manager, Index, Link, Key>::read(Index bucket,
+    fingerprint_type fingerprints[], Link links[]) const
+{
+    // The handle must remain in scope until the end of the block.
+    auto memory = file_.pin();
+    memory.increment(bucket_offset(bucket));
+    auto deserial = make_unsafe_deserializer(memory.buffer());
+
+    for (size_t slot = 0; slot < slots; ++slot)
+        fingerprints[slot] =
+            deserial.template read_little_endian<fingerprint_type>();
+
+    for (size_t slot = 0; slot < slots; ++slot)
+        links[slot] = hash_table_header<Index, Link>::encode(
+            deserial.template read_little_endian<Link>());
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_index<Manager, Index, Link, Key>::write(size_t slot,
+    fingerprint_type fingerprint, Link link)
+{
+    // The accessor must remain in scope until the end of the block.
+    {
+        const auto memory = file_.access();
+        const auto buffer = memory->buffer();
+
+        // The fingerprint is written first, the link publishes the slot.
+        auto serial = make_unsafe_serializer(buffer +
+            fingerprint_offset(slot));
+        serial.template write_little_endian<fingerprint_type>(fingerprint);
+        serial = make_unsafe_serializer(buffer + link_offset(slot));
+        serial.template write_little_endian<Link>(
+            hash_table_header<Index, Link>::encode(link));
+    }
+
+    file_.journal(fingerprint_offset(slot), sizeof(fingerprint_type));
+    file_.journal(link_offset(slot), sizeof(Link));
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_index<Manager, Index, Link, Key>::verify() const
+{
+    // File is too small for the number of buckets in the header.
+    if (file_.size() < size(buckets_))
+        return false;
+
+    // Does not require atomicity (no concurrency during start).
+    {
+        const auto memory = file_.access();
+        auto deserial = make_unsafe_deserializer(memory->buffer());
+        const auto buckets = deserial.template read_little_endian<Index>();
+        const auto version = deserial.template read_little_endian<Index>();
+
+        if (buckets != buckets_ ||
+            version != hash_table_header<Index, Link>::version)
+            return false;
+    }
+
+    return true;
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+Index hash_index<Manager, Index, Link, Key>::next(Index bucket) const
+{
+    return bucket + 1u == buckets_ ? 0 : bucket + 1u;
+}
+
+// static
+template <typename Manager, typename Index, typename Link, typename Key>
+file_offset hash_index<Manager, Index, Link, Key>::bucket_offset(
+    Index bucket)
+{
+    // The first bucket follows the padded size and version.
+    return (static_cast<file_offset>(bucket) + 1u) * bucket_size;
+}
+
+// static
+template <typename Manager, typename Index, typename Link, typename Key>
+file_offset hash_index<Manager, Index, Link, Key>::fingerprint_offset(
+    size_t slot)
+{
+    return bucket_offset(static_cast<Index>(slot / slots)) +
+        (slot % slots) * sizeof(fingerprint_type);
+}
+
+// static
+template <typename Manager, typename Index, typename Link, typename Key>
+file_offset hash_index<Manager, Index, Link, Key>::link_offset(size_t slot)
+{
+    return bucket_offset(static_cast<Index>(slot / slots)) +
+        slots * sizeof(fingerprint_type) + (slot % slots) * sizeof(Link);
+}
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -19,7 +19,11 @@
 #ifndef LIBBITCOIN_DATABASE_HASH_TABLE_IPP
 #define LIBBITCOIN_DATABASE_HASH_TABLE_IPP
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/memory/memory.hpp>
 #include <bitcoin/database/primitives/hash_table_header.hpp>
@@ -37,7 +41,10 @@ template <typename Manager, typename Index, typename Link, typename Key>
 hash_table<Manager, Index, Link, Key>::hash_table(storage& file,
     Index buckets)
   : header_(file, buckets),
-    manager_(file, hash_table_header<Index, Link>::size(buckets))
+    manager_(file, hash_table_header<Index, Link>::size(buckets)),
+    record_size_(0),
+    load_percent_(0),
+    metrics_(nullptr)
 {
 }
 
@@ -46,7 +53,10 @@ hash_table<Manager, Index, Link, Key>::hash_table(storage& file,
     Index buckets, size_t value_size)
   : header_(file, buckets),
     manager_(file, hash_table_header<Index, Link>::size(buckets),
-        value_type::size(value_size))
+        value_type::size(value_size)),
+    record_size_(value_type::size(value_size)),
+    load_percent_(0),
+    metrics_(nullptr)
 {
 }
 
@@ -62,10 +72,70 @@ bool hash_table<Manager, Index, Link, Key>::start()
     return header_.start() && manager_.start();
 }
 
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_table<Manager, Index, Link, Key>::recover()
+{
+    return header_.start() && manager_.recover();
+}
+
+// Repair is not executed concurrently with reads or writes.
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_table<Manager, Index, Link, Key>::repair(size_t& out_cut)
+{
+    out_cut = 0;
+    uint64_t elements = 0;
+    const auto count = buckets();
+    std::unordered_set<Link> visited;
+
+    for (size_t bucket = 0; bucket < count; ++bucket)
+    {
+        const auto index = static_cast<Index>(bucket);
+
+        if (index >= header_.buckets() &&
+            !manager_.contains(header_.segment(segment_row(index).first)))
+            return false;
+
+        visited.clear();
+        auto previous = not_found;
+        auto link = bucket_value(index);
+
+        while (link != not_found)
+        {
+            if (!manager_.contains(link) || !visited.insert(link).second)
+            {
+                if (previous == not_found)
+                    set_bucket_value(index, not_found);
+                else
+                    value_type(manager_, previous, list_mutex_).set_next(
+                        not_found);
+
+                ++out_cut;
+                break;
+            }
+
+            ++elements;
+            previous = link;
+            link = value_type(manager_, link, list_mutex_).next();
+        }
+    }
+
+    // The count is committed apart from the chains, so it is recounted.
+    const auto stored = header_.count();
+
+    if (elements > stored)
+        header_.increase_count(elements - stored);
+    else
+        header_.decrease_count(stored - elements);
+
+    header_.commit();
+    return true;
+}
+
 template <typename Manager, typename Index, typename Link, typename Key>
 void hash_table<Manager, Index, Link, Key>::commit()
 {
-    return manager_.commit();
+    header_.commit();
+    manager_.commit();
 }
 
 template <typename Manager, typename Index, typename Link, typename Key>
@@ -75,16 +145,39 @@ hash_table<Manager, Index, Link, Key>::allocator()
     return { manager_, list_mutex_ };
 }
 
+template <typename Manager, typename Index, typename Link, typename Key>
+Link hash_table<Manager, Index, Link, Key>::allocate(size_t size)
+{
+    return manager_.allocate(size);
+}
+
 template <typename Manager, typename Index, typename Link, typename Key>
 typename hash_table<Manager, Index, Link, Key>::const_value_type
 hash_table<Manager, Index, Link, Key>::find(const Key& key) const
 {
+    // A bucket cannot be split during the walk of its list.
+    const auto lock = split_lock();
+
     list<const Manager, Link, Key> list(manager_, bucket_value(key),
         list_mutex_);
 
+    size_t walked = 0;
+
     for (const auto item: list)
+    {
+        ++walked;
+
         if (item.match(key))
+        {
+            if (metrics_ != nullptr)
+                metrics_->lookup(true, walked);
+
             return item;
+        }
+    }
+
+    if (metrics_ != nullptr)
+        metrics_->lookup(false, walked);
 
     return *list.end();
 }
@@ -96,6 +189,44 @@ hash_table<Manager, Index, Link, Key>::find(Link link) const
     return { manager_, link, list_mutex_ };
 }
 
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_table<Manager, Index, Link, Key>::contains(Link link) const
+{
+    return manager_.contains(link);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+Index hash_table<Manager, Index, Link, Key>::bucket(const Key& key) const
+{
+    const auto lock = split_lock();
+    return bucket_index(key);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::prefetch(const Key& key) const
+{
+    const auto lock = split_lock();
+    const auto index = bucket_index(key);
+
+    // Rows of growth segments are not advised, they are usually resident.
+    if (index < header_.buckets())
+        header_.prefetch(index);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::prefetch(
+    const std::vector<Link>& links, size_t size) const
+{
+    manager_.prefetch(links, size);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+scan_guard::ptr hash_table<Manager, Index, Link, Key>::scan(Link link,
+    size_t size) const
+{
+    return manager_.scan(link, size);
+}
+
 template <typename Manager, typename Index, typename Link, typename Key>
 typename hash_table<Manager, Index, Link, Key>::const_value_type
 hash_table<Manager, Index, Link, Key>::terminator() const
@@ -106,17 +237,58 @@ hash_table<Manager, Index, Link, Key>::terminator() const
 template <typename Manager, typename Index, typename Link, typename Key>
 void hash_table<Manager, Index, Link, Key>::link(value_type& element)
 {
-    const auto index = bucket_index(element.key());
+    {
+        const auto lock = split_lock();
+        const auto index = bucket_index(element.key());
+        auto& root = root_mutex(index);
 
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    root_mutex_.lock_upgrade();
-    element.set_next(bucket_value(index));
-    root_mutex_.unlock_upgrade_and_lock();
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    header_.write(index, element.link());
-    root_mutex_.unlock();
-    ///////////////////////////////////////////////////////////////////////////
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        root.lock_upgrade();
+        element.set_next(bucket_value(index));
+        root.unlock_upgrade_and_lock();
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+        set_bucket_value(index, element.link());
+        root.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        header_.increase_count(1u);
+    }
+
+    // Growth is amortized over writes, one bucket per write.
+    if (overloaded())
+        split();
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::link(
+    std::vector<value_type>& elements)
+{
+    if (elements.empty())
+        return;
+
+    {
+        const auto lock = split_lock();
+
+        for (auto& element: elements)
+        {
+            const auto index = bucket_index(element.key());
+
+            // Critical Section
+            ///////////////////////////////////////////////////////////////////
+            unique_lock root(root_mutex(index));
+            element.set_next(bucket_value(index));
+            set_bucket_value(index, element.link());
+            ///////////////////////////////////////////////////////////////////
+        }
+
+        header_.increase_count(elements.size());
+    }
+
+    // Growth is amortized over writes, one bucket per element.
+    for (size_t splits = 0; splits < elements.size() && overloaded();
+        ++splits)
+        split();
 }
 
 // Unlink the first of matching key value.
@@ -124,17 +296,19 @@ void hash_table<Manager, Index, Link, Key>::link(value_type& element)
 template <typename Manager, typename Index, typename Link, typename Key>
 bool hash_table<Manager, Index, Link, Key>::unlink(const Key& key)
 {
+    const auto lock = split_lock();
     const auto index = bucket_index(key);
+    auto& root = root_mutex(index);
 
     // Critical Section.
     ///////////////////////////////////////////////////////////////////////////
-    root_mutex_.lock_upgrade();
+    root.lock_upgrade();
 
     list<Manager, Link, Key> list(manager_, bucket_value(index), list_mutex_);
 
     if (list.empty())
     {
-        root_mutex_.unlock_upgrade();
+        root.unlock_upgrade();
         //---------------------------------------------------------------------
         return false;
     }
@@ -146,24 +320,28 @@ bool hash_table<Manager, Index, Link, Key>::unlink(const Key& key)
     // TODO: implement -> overload.
     if ((*previous).match(key))
     {
-        root_mutex_.unlock_upgrade_and_lock();
+        root.unlock_upgrade_and_lock();
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-        header_.write(index, (*previous).next());
-        root_mutex_.unlock();
+        set_bucket_value(index, (*previous).next());
+        root.unlock();
         //---------------------------------------------------------------------
+        header_.decrease_count(1u);
         return true;
     }
 
-    root_mutex_.unlock_upgrade();
+    root.unlock_upgrade();
     ///////////////////////////////////////////////////////////////////////////
 
     // The linked list internally manages link update safety using list_mutex_.
-    for (auto item = ++previous; item != list.end(); item++)
+    // The previous item trails the item by one (iterators are not assignable).
+    auto item = previous;
+    for (++item; item != list.end(); ++item, ++previous)
     {
         // TODO: implement -> overloads.
         if ((*item).match(key))
         {
             (*previous).set_next((*item).next());
+            header_.decrease_count(1u);
             return true;
         }
     }
@@ -171,25 +349,304 @@ bool hash_table<Manager, Index, Link, Key>::unlink(const Key& key)
     return false;
 }
 
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::enable_growth(size_t load_percent)
+{
+    load_percent_ = load_percent;
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::enable_metrics(
+    table_metrics& metrics)
+{
+    metrics_ = &metrics;
+    manager_.enable_metrics(metrics);
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+uint64_t hash_table<Manager, Index, Link, Key>::count() const
+{
+    return header_.count();
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::walk(key_handler handler) const
+{
+    // Buckets cannot be split during the walk.
+    const auto lock = split_lock();
+    const auto count = buckets();
+
+    // The header rows are read in order, though element chains are not.
+    const auto scan = header_.scan();
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        list<const Manager, Link, Key> list(manager_,
+            bucket_value(static_cast<Index>(index)), list_mutex_);
+
+        for (const auto item: list)
+            handler(item.key());
+    }
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::walk(size_t first, size_t last,
+    link_handler handler) const
+{
+    // Buckets cannot be split during the walk.
+    const auto lock = split_lock();
+    last = std::min(last, buckets());
+
+    for (auto index = first; index < last; ++index)
+    {
+        list<const Manager, Link, Key> list(manager_,
+            bucket_value(static_cast<Index>(index)), list_mutex_);
+
+        for (const auto item: list)
+            handler(item.link());
+    }
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+size_t hash_table<Manager, Index, Link, Key>::buckets() const
+{
+    const auto level = header_.level();
+    return (static_cast<size_t>(header_.buckets()) << level) + header_.split();
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+size_t hash_table<Manager, Index, Link, Key>::header_size() const
+{
+    return hash_table_header<Index, Link>::size(header_.buckets());
+}
+
+template <typename Manager, typename Index, typename Link, typename Key>
+float hash_table<Manager, Index, Link, Key>::load_factor() const
+{
+    const auto count = buckets();
+    return count == 0 ? 0.0f : static_cast<float>(header_.count()) / count;
+}
+
 // private
 template <typename Manager, typename Index, typename Link, typename Key>
 Link hash_table<Manager, Index, Link, Key>::bucket_value(Index index) const
 {
-    return header_.read(index);
+    if (index < header_.buckets())
+        return header_.read(index);
+
+    const auto row = segment_row(index);
+    const auto memory = manager_.get(header_.segment(row.first));
+    memory->increment(row.second * sizeof(Link));
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(row_mutex(index));
+    return hash_table_header<Index, Link>::encode(
+        deserial.template read_little_endian<Link>());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::set_bucket_value(Index index,
+    Link value)
+{
+    if (index < header_.buckets())
+    {
+        header_.write(index, value);
+        return;
+    }
+
+    const auto row = segment_row(index);
+    const auto segment = header_.segment(row.first);
+    const auto offset = row.second * sizeof(Link);
+
+    // The accessor must remain in scope until the end of the block.
+    {
+        const auto memory = manager_.get(segment);
+        memory->increment(offset);
+        auto serial = make_unsafe_serializer(memory->buffer());
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(row_mutex(index));
+        serial.template write_little_endian<Link>(
+            hash_table_header<Index, Link>::encode(value));
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    manager_.journal(segment, offset, sizeof(Link));
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+shared_mutex& hash_table<Manager, Index, Link, Key>::root_mutex(
+    Index index) const
+{
+    return root_mutexes_[hash_table_header<Index, Link>::stripe(index)];
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+shared_mutex& hash_table<Manager, Index, Link, Key>::row_mutex(
+    Index index) const
+{
+    return row_mutexes_[hash_table_header<Index, Link>::stripe(index)];
+}
+
+// private
+// Segment n holds (buckets << (n - 1)) rows, following the rows of n - 1.
+template <typename Manager, typename Index, typename Link, typename Key>
+std::pair<size_t, size_t> hash_table<Manager, Index, Link, Key>::segment_row(
+    Index index) const
+{
+    const size_t position = index;
+    size_t segment = 1;
+    size_t start = header_.buckets();
+    size_t span = start;
+
+    while (position >= start + span)
+    {
+        start += span;
+        span *= 2;
+        ++segment;
+    }
+
+    return { segment, position - start };
+}
+
+// private
+// Buckets are split only if growth is enabled, which is set before use, so
+// otherwise lookups and writes take no table lock.
+template <typename Manager, typename Index, typename Link, typename Key>
+shared_lock hash_table<Manager, Index, Link, Key>::split_lock() const
+{
+    return load_percent_ == 0 ? shared_lock(split_mutex_, boost::defer_lock) :
+        shared_lock(split_mutex_);
+}
+
+// private
+template <typename Manager, typename Index, typename Link, typename Key>
+bool hash_table<Manager, Index, Link, Key>::overloaded() const
+{
+    return load_percent_ != 0 &&
+        header_.count() * 100u > load_percent_ * buckets();
+}
+
+// private
+// The segment is not reachable until a split of its level is published, so
+// it is allocated (which may remap the file) without excluding lookups.
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::reserve_segment()
+{
+    typedef hash_table_header<Index, Link> header;
+    const auto level = header_.level();
+    const auto span = static_cast<uint64_t>(header_.buckets()) << level;
+    const auto segment = static_cast<size_t>(level) + 1u;
+
+    if (segment > header::segments || span >= (Index)bc::max_uint64)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(segment_mutex_);
+
+    if (header_.segment(segment) != header::empty)
+        return;
+
+    const auto size = span * sizeof(Link);
+    const auto units = record_size_ == 0 ? size :
+        (size + record_size_ - 1u) / record_size_;
+    header_.set_segment(segment, manager_.allocate(units));
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Split the next bucket into itself and the bucket (buckets << level) above
+// it. Lookups are excluded while the list of the bucket is relinked.
+template <typename Manager, typename Index, typename Link, typename Key>
+void hash_table<Manager, Index, Link, Key>::split()
+{
+    typedef hash_table_header<Index, Link> header;
+
+    if (!overloaded())
+        return;
+
+    reserve_segment();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(split_mutex_);
+
+    if (!overloaded())
+        return;
+
+    const auto level = header_.level();
+    const auto split = header_.split();
+    const auto span = static_cast<uint64_t>(header_.buckets()) << level;
+    const auto segment = static_cast<size_t>(level) + 1u;
+
+    // The bucket count cannot exceed the index domain or the segments.
+    if (segment > header::segments || span + split >= (Index)bc::max_uint64)
+        return;
+
+    // The level advanced since the reservation, the next split reserves.
+    if (header_.segment(segment) == header::empty)
+        return;
+
+    const auto target = static_cast<Index>(span + split);
+    const auto next_split = static_cast<Index>(split + 1u);
+
+    if (next_split == span)
+        header_.set_growth(level + 1u, 0);
+    else
+        header_.set_growth(level, next_split);
+
+    // Partition the list by the bucket of each key in the new state.
+    std::vector<std::pair<Link, Link>> stay;
+    std::vector<std::pair<Link, Link>> move;
+    list<Manager, Link, Key> items(manager_, bucket_value(split), list_mutex_);
+
+    for (const auto item: items)
+    {
+        auto& to = header_.bucket(item.key()) == split ? stay : move;
+        to.push_back({ item.link(), item.next() });
+    }
+
+    // Preserve the order of each part, writing only changed links.
+    const auto relink = [this](const std::vector<std::pair<Link, Link>>& part)
+    {
+        for (size_t position = 0; position < part.size(); ++position)
+        {
+            const auto next = position + 1u < part.size() ?
+                part[position + 1u].first : header::empty;
+
+            if (part[position].second != next)
+                value_type(manager_, part[position].first, list_mutex_)
+                    .set_next(next);
+        }
+
+        return part.empty() ? header::empty : part.front().first;
+    };
+
+    set_bucket_value(split, relink(stay));
+    set_bucket_value(target, relink(move));
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 // private
 template <typename Manager, typename Index, typename Link, typename Key>
 Link hash_table<Manager, Index, Link, Key>::bucket_value(const Key& key) const
 {
-    return header_.read(bucket_index(key));
+    return bucket_value(bucket_index(key));
 }
 
 // private
 template <typename Manager, typename Index, typename Link, typename Key>
 Index hash_table<Manager, Index, Link, Key>::bucket_index(const Key& key) const
 {
-    return hash_table_header<Index, Link>::remainder(key, header_.buckets());
+    return header_.bucket(key);
 }
 
 } // namespace database
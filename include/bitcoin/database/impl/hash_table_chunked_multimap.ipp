@@ -0,0 +1,276 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_HASH_TABLE_CHUNKED_MULTIMAP_IPP
+#define LIBBITCOIN_DATABASE_HASH_TABLE_CHUNKED_MULTIMAP_IPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/primitives/chunk_element.hpp>
+#include <bitcoin/database/primitives/hash_table.hpp>
+#include <bitcoin/database/primitives/slab_manager.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// Offsets of the chunk header (see chunk_element).
+static constexpr size_t chunk_capacity_offset = sizeof(file_offset);
+static constexpr size_t chunk_count_offset = chunk_capacity_offset + 1u;
+
+template <typename Index, typename Link, typename Key>
+const size_t hash_table_chunked_multimap<Index, Link, Key>::
+    maximum_capacity = 16;
+
+template <typename Index, typename Link, typename Key>
+hash_table_chunked_multimap<Index, Link, Key>::hash_table_chunked_multimap(
+    table& map, manager& manager, size_t value_size)
+  : map_(map), manager_(manager), value_size_(value_size)
+{
+}
+
+template <typename Index, typename Link, typename Key>
+typename hash_table_chunked_multimap<Index, Link, Key>::const_value_type
+hash_table_chunked_multimap<Index, Link, Key>::find(const Key& key) const
+{
+    const auto root = map_.find(key);
+
+    if (!root)
+        return { manager_, value_size_, list_mutex_ };
+
+    link_type first;
+    const auto reader = [&](byte_deserializer& deserial)
+    {
+        // Critical Section.
+        ///////////////////////////////////////////////////////////////////////
+        shared_lock lock(root_mutex_);
+        first = deserial.template read_little_endian<link_type>();
+        ///////////////////////////////////////////////////////////////////////
+    };
+
+    root.read(reader);
+    return { manager_, value_size_, first, list_mutex_ };
+}
+
+template <typename Index, typename Link, typename Key>
+typename hash_table_chunked_multimap<Index, Link, Key>::const_value_type
+hash_table_chunked_multimap<Index, Link, Key>::element(
+    uint64_t position) const
+{
+    if (position == max_uint64)
+        return { manager_, value_size_, list_mutex_ };
+
+    const auto bits = const_value_type::slot_bits;
+    const auto chunk = static_cast<link_type>(position >> bits);
+    const auto slot = static_cast<size_t>(position & ((1u << bits) - 1u));
+    return { manager_, value_size_, chunk, slot, list_mutex_ };
+}
+
+// Free rows of the first chunk are filled before new chunks are linked in
+// front of it, and the key is then touched by at most one root update.
+template <typename Index, typename Link, typename Key>
+void hash_table_chunked_multimap<Index, Link, Key>::link(const Key& key,
+    size_t count, write_function write)
+{
+    if (count == 0)
+        return;
+
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    root_mutex_.lock_upgrade();
+
+    // Find the root element for this key in hash table.
+    auto root = map_.find(key);
+    auto first = read_root(root);
+    const auto linked = first;
+
+    root_mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+    size_t capacity = 0;
+    size_t written = 0;
+
+    if (first != const_value_type::not_found)
+    {
+        const auto memory = manager_.get(first);
+        const auto header = memory->buffer();
+        capacity = header[chunk_capacity_offset];
+        const size_t filled = header[chunk_count_offset];
+        written = std::min(capacity - filled, count);
+
+        if (written != 0)
+        {
+            // Rows are written before the count that publishes them.
+            write_rows(memory, 0, written, filled, write);
+            manager_.journal(first, const_value_type::header_size +
+                filled * value_size_, written * value_size_);
+
+            ///////////////////////////////////////////////////////////////////
+            unique_lock lock(list_mutex_);
+            header[chunk_count_offset] = static_cast<uint8_t>(filled +
+                written);
+            ///////////////////////////////////////////////////////////////////
+
+            manager_.journal(first, chunk_count_offset, sizeof(uint8_t));
+        }
+    }
+
+    while (written < count)
+    {
+        const auto remaining = count - written;
+        capacity = std::min(maximum_capacity, std::max(capacity * 2u,
+            remaining));
+        const auto rows = std::min(capacity, remaining);
+        const auto chunk = manager_.allocate(const_value_type::size(capacity,
+            value_size_));
+
+        // The chunk is not reachable until the root is written.
+        const auto memory = manager_.get(chunk);
+        auto serial = make_unsafe_serializer(memory->buffer());
+        serial.template write_little_endian<link_type>(first);
+        serial.write_byte(static_cast<uint8_t>(capacity));
+        serial.write_byte(static_cast<uint8_t>(rows));
+        write_rows(memory, written, rows, 0, write);
+
+        first = chunk;
+        written += rows;
+    }
+
+    if (first != linked)
+    {
+        const auto writer = [&](byte_serializer& serial)
+        {
+            serial.template write_little_endian<link_type>(first);
+        };
+
+        if (!root)
+        {
+            // Create and map new root and "link" from it to the first chunk.
+            auto new_root = map_.allocator();
+            new_root.create(key, writer);
+            map_.link(new_root);
+        }
+        else
+        {
+            // "link" existing root to the new first chunk.
+            root.write(writer);
+            root.journal(0, sizeof(link_type));
+        }
+    }
+
+    root_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+template <typename Index, typename Link, typename Key>
+bool hash_table_chunked_multimap<Index, Link, Key>::unlink(const Key& key)
+{
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    root_mutex_.lock_upgrade();
+
+    // Find the root element for this key in hash table.
+    auto root = map_.find(key);
+    const auto first = read_root(root);
+
+    // There is no root element or it is empty, nothing to unlink.
+    if (first == const_value_type::not_found)
+    {
+        root_mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    root_mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+    const auto memory = manager_.get(first);
+    const auto header = memory->buffer();
+    auto deserial = make_unsafe_deserializer(header);
+    const auto next = deserial.template read_little_endian<link_type>();
+    const size_t filled = header[chunk_count_offset];
+
+    if (filled > 1u)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(list_mutex_);
+        header[chunk_count_offset] = static_cast<uint8_t>(filled - 1u);
+        ///////////////////////////////////////////////////////////////////////
+
+        manager_.journal(first, chunk_count_offset, sizeof(uint8_t));
+    }
+    else
+    {
+        const auto writer = [&](byte_serializer& serial)
+        {
+            serial.template write_little_endian<link_type>(next);
+        };
+
+        // The emptied chunk is abandoned, "link" root to the next chunk.
+        root.write(writer);
+        root.journal(0, sizeof(link_type));
+    }
+
+    root_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+    return true;
+}
+
+// private
+// Read the first chunk of the root, to be called while writing is locked.
+template <typename Index, typename Link, typename Key>
+typename hash_table_chunked_multimap<Index, Link, Key>::link_type
+hash_table_chunked_multimap<Index, Link, Key>::read_root(
+    const typename table::const_value_type& root) const
+{
+    if (!root)
+        return const_value_type::not_found;
+
+    link_type first;
+    const auto reader = [&](byte_deserializer& deserial)
+    {
+        first = deserial.template read_little_endian<link_type>();
+    };
+
+    root.read(reader);
+    return first;
+}
+
+// private
+// Write count rows, values first to first + count, from the slot of chunk.
+template <typename Index, typename Link, typename Key>
+void hash_table_chunked_multimap<Index, Link, Key>::write_rows(
+    const memory_ptr& memory, size_t first, size_t count, size_t slot,
+    write_function write) const
+{
+    auto buffer = memory->buffer() + const_value_type::header_size +
+        slot * value_size_;
+
+    for (size_t row = 0; row < count; ++row, buffer += value_size_)
+    {
+        auto serial = make_unsafe_serializer(buffer);
+        write(serial, first + row);
+    }
+}
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
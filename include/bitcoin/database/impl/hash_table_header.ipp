@@ -19,20 +19,99 @@
 #ifndef LIBBITCOIN_DATABASE_HASH_TABLE_HEADER_IPP
 #define LIBBITCOIN_DATABASE_HASH_TABLE_HEADER_IPP
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
 #include <bitcoin/database/memory/storage.hpp>
 
 namespace libbitcoin {
 namespace database {
 
+// Fibonacci (golden ratio) multiplier for multiply-shift hashing.
+static constexpr uint64_t bucket_multiplier = 0x9e3779b97f4a7c15;
+
+// The leading bytes of a digest are uniform, so the first machine word is
+// used directly (block hashes are zero-padded at the other end). Multiplying
+// by an odd constant spreads it into the high bits, which are then scaled to
+// the divisor without a division. The result does not depend on the standard
+// library, so stores are portable across toolchains.
 template <typename Index, typename Link>
 template <typename Key>
 inline Index hash_table_header<Index, Link>::remainder(const Key& key,
     Index divisor)
 {
-    // TODO: implement std::hash replacement to prevent store drift.
-    return divisor == 0 ? 0 : std::hash<Key>()(key) % divisor;
+    const uint64_t buckets = divisor;
+    const auto mixed = hash(key) * bucket_multiplier;
+
+    // Divisors beyond 32 bits (not used by the stores) require a modulo.
+    if (buckets > max_uint32)
+        return static_cast<Index>(mixed % buckets);
+
+    return static_cast<Index>(((mixed >> 32) * buckets) >> 32);
+}
+
+// The remainder consumes the high bits, the fingerprint uses the next 16.
+// These are also the low bits of levels above 16 (see bucket), so the
+// fingerprint is not independent of the bucket of a table grown that far.
+template <typename Index, typename Link>
+template <typename Key>
+inline uint16_t hash_table_header<Index, Link>::fingerprint(const Key& key)
+{
+    const auto mixed = hash(key) * bucket_multiplier;
+    const auto value = static_cast<uint16_t>(mixed >> 16);
+    return value == 0 ? 1 : value;
+}
+
+// Levels refine the remainder by the low bits of the mixed hash, so that
+// splitting bucket b of a level moves only to b + (size << level). This
+// allows the bucket count to grow one bucket at a time.
+// The growth state is not locked, the caller must exclude splits.
+template <typename Index, typename Link>
+template <typename Key>
+Index hash_table_header<Index, Link>::bucket(const Key& key) const
+{
+    const auto mixed = static_cast<uint32_t>(hash(key) * bucket_multiplier);
+    const auto root = remainder(key, buckets_);
+    const auto level = level_.load(std::memory_order_relaxed);
+    const auto split = split_.load(std::memory_order_relaxed);
+    const auto low = static_cast<uint64_t>(mixed) & ((1ull << level) - 1u);
+    auto index = root + (static_cast<uint64_t>(buckets_) * low);
+
+    // Split buckets of the level are addressed with one more bit.
+    if (index < split && ((mixed >> level) & 1u) != 0)
+        index += static_cast<uint64_t>(buckets_) << level;
+
+    return static_cast<Index>(index);
+}
+
+template <typename Index, typename Link>
+template <size_t Size>
+inline uint64_t hash_table_header<Index, Link>::hash(
+    const byte_array<Size>& key)
+{
+    static constexpr auto bytes = Size < sizeof(uint64_t) ? Size :
+        sizeof(uint64_t);
+
+    uint64_t word = 0;
+    for (size_t byte = 0; byte < bytes; ++byte)
+        word |= static_cast<uint64_t>(key[byte]) << (byte * 8);
+
+    return word;
+}
+
+template <typename Index, typename Link>
+template <typename Key>
+inline uint64_t hash_table_header<Index, Link>::hash(const Key& key)
+{
+    return std::hash<Key>()(key);
 }
 
 // Link must be unsigned (see static assertions below).
@@ -40,10 +119,21 @@ inline Index hash_table_header<Index, Link>::remainder(const Key& key,
 template <typename Index, typename Link>
 const Link hash_table_header<Index, Link>::empty = (Link)bc::max_uint64;
 
+// Increment when the remainder function or the row encoding changes (stores
+// must be rebuilt).
+template <typename Index, typename Link>
+const Index hash_table_header<Index, Link>::version = 3;
+
+template <typename Index, typename Link>
+const size_t hash_table_header<Index, Link>::segments;
+
 template <typename Index, typename Link>
 hash_table_header<Index, Link>::hash_table_header(storage& file, Index buckets)
-  : file_(file), buckets_(buckets)
+  : file_(file), buckets_(buckets), level_(0), split_(0), count_(0)
 {
+    for (auto& segment: segments_)
+        segment.store(empty);
+
     static_assert(std::is_unsigned<Link>::value,
         "Hash table header requires unsigned value type.");
 
@@ -55,16 +145,33 @@ template <typename Index, typename Link>
 bool hash_table_header<Index, Link>::create()
 {
     const auto file_size = size(buckets_);
+    const auto prior = std::min(file_.logical_size(), file_size);
 
     // The accessor must remain in scope until the end of the block.
     const auto memory = file_.resize(file_size);
 
-    // Speed-optimized fill implementation.
-    memset(memory->buffer(), (uint8_t)empty, file_size);
+    // The file is extended with zeros (a sparse file where supported), which
+    // are empty rows, so only previously written bytes are cleared.
+    memset(memory->buffer(), 0, prior);
 
-    // Overwrite the start of the buffer with the bucket count.
+    // Write the bucket count, version, growth state and empty segments.
     auto serial = make_unsafe_serializer(memory->buffer());
     serial.template write_little_endian<Index>(buckets_);
+    serial.template write_little_endian<Index>(version);
+    serial.template write_little_endian<Index>(0);
+    serial.template write_little_endian<Index>(0);
+    serial.template write_little_endian<uint64_t>(0);
+
+    for (size_t segment = 0; segment < segments; ++segment)
+        serial.template write_little_endian<Link>(empty);
+
+    level_.store(0);
+    split_.store(0);
+    count_.store(0);
+
+    for (auto& segment: segments_)
+        segment.store(empty);
+
     return true;
 }
 
@@ -80,7 +187,20 @@ bool hash_table_header<Index, Link>::start()
 
     // Does not require atomicity (no concurrency during start).
     auto deserial = make_unsafe_deserializer(memory->buffer());
-    return deserial.template read_little_endian<Index>() == buckets_;
+    const auto buckets = deserial.template read_little_endian<Index>();
+
+    if (buckets != buckets_ ||
+        deserial.template read_little_endian<Index>() != version)
+        return false;
+
+    level_.store(deserial.template read_little_endian<Index>());
+    split_.store(deserial.template read_little_endian<Index>());
+    count_.store(deserial.template read_little_endian<uint64_t>());
+
+    for (auto& segment: segments_)
+        segment.store(deserial.template read_little_endian<Link>());
+
+    return level_.load() < segments;
 }
 
 template <typename Index, typename Link>
@@ -89,38 +209,156 @@ Link hash_table_header<Index, Link>::read(Index index) const
     BITCOIN_ASSERT(index < buckets_);
 
     // The accessor must remain in scope until the end of the block.
-    const auto memory = file_.access();
-    memory->increment(link(index));
-    auto deserial = make_unsafe_deserializer(memory->buffer());
+    auto memory = file_.pin();
+    memory.increment(link(index));
+    auto deserial = make_unsafe_deserializer(memory.buffer());
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
-    return deserial.template read_little_endian<Link>();
+    shared_lock lock(row_mutexes_[stripe(index)]);
+    return encode(deserial.template read_little_endian<Link>());
     ///////////////////////////////////////////////////////////////////////////
 }
 
+template <typename Index, typename Link>
+void hash_table_header<Index, Link>::prefetch(Index index) const
+{
+    BITCOIN_ASSERT(index < buckets_);
+    file_.prefetch(link(index), sizeof(Link));
+}
+
+template <typename Index, typename Link>
+scan_guard::ptr hash_table_header<Index, Link>::scan() const
+{
+    return std::make_shared<scan_guard>(file_, 0, size(buckets_));
+}
+
 template <typename Index, typename Link>
 void hash_table_header<Index, Link>::write(Index index, Link value)
 {
     BITCOIN_ASSERT(index < buckets_);
 
+    // The accessor must remain in scope until the end of the block.
+    auto memory = file_.pin();
+    memory.increment(link(index));
+    auto serial = make_unsafe_serializer(memory.buffer());
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(row_mutexes_[stripe(index)]);
+    serial.template write_little_endian<Link>(encode(value));
+    ///////////////////////////////////////////////////////////////////////////
+
+    file_.journal(link(index), sizeof(Link));
+}
+
+template <typename Index, typename Link>
+Index hash_table_header<Index, Link>::buckets() const
+{
+    return buckets_;
+}
+
+template <typename Index, typename Link>
+Index hash_table_header<Index, Link>::level() const
+{
+    return level_.load();
+}
+
+template <typename Index, typename Link>
+Index hash_table_header<Index, Link>::split() const
+{
+    return split_.load();
+}
+
+template <typename Index, typename Link>
+void hash_table_header<Index, Link>::set_growth(Index level, Index split)
+{
+    BITCOIN_ASSERT(level < segments);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    level_.store(level);
+    split_.store(split);
+    write_growth();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+template <typename Index, typename Link>
+uint64_t hash_table_header<Index, Link>::count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+// Writers of distinct stripes update the count concurrently, so it is not
+// written to the file until commit.
+template <typename Index, typename Link>
+void hash_table_header<Index, Link>::increase_count(uint64_t value)
+{
+    count_.fetch_add(value, std::memory_order_relaxed);
+}
+
+template <typename Index, typename Link>
+void hash_table_header<Index, Link>::decrease_count(uint64_t value)
+{
+    const auto prior = count_.fetch_sub(value, std::memory_order_relaxed);
+    BITCOIN_ASSERT(prior >= value);
+}
+
+template <typename Index, typename Link>
+void hash_table_header<Index, Link>::commit()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    write_growth();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+template <typename Index, typename Link>
+Link hash_table_header<Index, Link>::segment(size_t index) const
+{
+    BITCOIN_ASSERT(index > 0 && index <= segments);
+
+    return segments_[index - 1].load();
+}
+
+template <typename Index, typename Link>
+void hash_table_header<Index, Link>::set_segment(size_t index, Link value)
+{
+    BITCOIN_ASSERT(index > 0 && index <= segments);
+
     // The accessor must remain in scope until the end of the block.
     const auto memory = file_.access();
-    memory->increment(link(index));
+    memory->increment(segment_position(index));
     auto serial = make_unsafe_serializer(memory->buffer());
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(mutex_);
+    segments_[index - 1].store(value);
     serial.template write_little_endian<Link>(value);
     ///////////////////////////////////////////////////////////////////////////
+
+    file_.journal(segment_position(index), sizeof(Link));
 }
 
+// private
+// The growth state is contiguous and written together (caller must lock).
+// The count may be changed by writers while written, which commit persists.
 template <typename Index, typename Link>
-Index hash_table_header<Index, Link>::buckets() const
+void hash_table_header<Index, Link>::write_growth()
 {
-    return buckets_;
+    static const auto growth_size = 2 * sizeof(Index) + sizeof(uint64_t);
+
+    // The accessor must remain in scope until the end of the block.
+    const auto memory = file_.access();
+    memory->increment(growth_position());
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.template write_little_endian<Index>(level_.load());
+    serial.template write_little_endian<Index>(split_.load());
+    serial.template write_little_endian<uint64_t>(count_.load());
+    file_.journal(growth_position(), growth_size);
 }
 
 template <typename Index, typename Link>
@@ -136,6 +374,9 @@ size_t hash_table_header<Index, Link>::size(Index buckets)
     // Header byte size is file link of last bucket + 1:
     //
     //  [  size:buckets        ]
+    //  [  version             ]
+    //  [  growth state        ]
+    //  [ [ segment[1..32]   ] ]
     //  [ [ row[0]           ] ]
     //  [ [      ...         ] ]
     //  [ [ row[buckets - 1] ] ] <=
@@ -143,6 +384,21 @@ size_t hash_table_header<Index, Link>::size(Index buckets)
     return link(buckets);
 }
 
+// static
+template <typename Index, typename Link>
+inline Link hash_table_header<Index, Link>::encode(Link value)
+{
+    return static_cast<Link>(~value);
+}
+
+// static
+// Adjacent buckets map to distinct stripes.
+template <typename Index, typename Link>
+size_t hash_table_header<Index, Link>::stripe(Index index)
+{
+    return static_cast<size_t>(index) % stripes;
+}
+
 // static
 template <typename Index, typename Link>
 file_offset hash_table_header<Index, Link>::link(Index index)
@@ -150,11 +406,31 @@ file_offset hash_table_header<Index, Link>::link(Index index)
     // File link of indexed bucket is:
     //
     //     [  size       :Index  ]
+    //     [  version    :Index  ]
+    //     [  level      :Index  ]
+    //     [  split      :Index  ]
+    //     [  count      :uint64 ]
+    //     [ [ segment   :Link ] ]
+    //     [ [      ...        ] ]
     //     [ [ row[0]    :Link ] ]
     //     [ [      ...        ] ]
     //  => [ [ row[index]:Link ] ]
     //
-    return sizeof(Index) + index * sizeof(Link);
+    return segment_position(segments + 1) + index * sizeof(Link);
+}
+
+// static
+template <typename Index, typename Link>
+file_offset hash_table_header<Index, Link>::growth_position()
+{
+    return 2 * sizeof(Index);
+}
+
+// static
+template <typename Index, typename Link>
+file_offset hash_table_header<Index, Link>::segment_position(size_t index)
+{
+    return 4 * sizeof(Index) + sizeof(uint64_t) + (index - 1) * sizeof(Link);
 }
 
 } // namespace database
@@ -96,13 +96,28 @@ hash_table_multimap<Index, Link, Key>::find(Link link) const
     return { manager_, first, list_mutex_ };
 }
 
+template <typename Index, typename Link, typename Key>
+typename hash_table_multimap<Index, Link, Key>::const_value_type
+hash_table_multimap<Index, Link, Key>::element(Link link) const
+{
+    return { manager_, link, list_mutex_ };
+}
+
 template <typename Index, typename Link, typename Key>
 void hash_table_multimap<Index, Link, Key>::link(const Key& key,
     value_type& element)
+{
+    link(key, element, element);
+}
+
+// The chain is published by one root update, so the key is touched once.
+template <typename Index, typename Link, typename Key>
+void hash_table_multimap<Index, Link, Key>::link(const Key& key,
+    value_type& first, value_type& last)
 {
     const auto writer = [&](byte_serializer& serial)
     {
-        serial.template write_little_endian<Link>(element.link());
+        serial.template write_little_endian<Link>(first.link());
     };
 
     // Critical Section.
@@ -119,7 +134,7 @@ void hash_table_multimap<Index, Link, Key>::link(const Key& key,
     if (!root)
     {
         // Commit the termination of the new list.
-        element.set_next(element.not_found);
+        last.set_next(last.not_found);
 
         // Create and map new root and "link" from it to the new element.
         auto new_root = map_.allocator();
@@ -128,21 +143,22 @@ void hash_table_multimap<Index, Link, Key>::link(const Key& key,
     }
     else
     {
-        Link first;
+        Link next;
         const auto reader = [&](byte_deserializer& deserial)
         {
             // This could be a terminator if previously unlinked.
-            first = deserial.template read_little_endian<Link>();
+            next = deserial.template read_little_endian<Link>();
         };
 
         // Read the address of the existing first list element.
         root.read(reader);
 
         // Commit linkage to the existing first list element.
-        element.set_next(first);
+        last.set_next(next);
 
         // "link" existing root to the new first element.
         root.write(writer);
+        root.journal(0, sizeof(Link));
     }
 
     root_mutex_.unlock();
@@ -199,6 +215,7 @@ bool hash_table_multimap<Index, Link, Key>::unlink(const Key& key)
     root_mutex_.unlock_upgrade_and_lock();
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
     root.write(writer);
+    root.journal(0, sizeof(Link));
 
     root_mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
@@ -19,12 +19,12 @@
 #ifndef LIBBITCOIN_DATABASE_LIST_ELEMENT_IPP
 #define LIBBITCOIN_DATABASE_LIST_ELEMENT_IPP
 
-#include <algorithm>
 #include <cstddef>
-#include <tuple>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/primitives/element_traits.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -34,6 +34,8 @@ namespace database {
 // Elements form a forward-navigable linked list with 'not_found' terminator.
 // Elements of a common mutex support read/write concurrency, though updateable
 // portions of payload must be protected by caller within each reader/writer.
+// An aligned next link is published by release store, and read by acquire
+// load without the mutex, so traversal does not wait on linking writers.
 // [ Key  ]
 // [ Link ]
 // [ payload... ]
@@ -42,7 +44,7 @@ namespace database {
 template <typename Manager, typename Link, typename Key>
 size_t list_element<Manager, Link, Key>::size(size_t value_size)
 {
-    return std::tuple_size<Key>::value + sizeof(Link) + value_size;
+    return traits::size(value_size);
 }
 
 // Parameterizing Manager allows const and non-const.
@@ -67,7 +69,7 @@ void list_element<Manager, Link, Key>::initialize(const Key& key,
     write_function write)
 {
     const auto memory = data(0);
-    auto serial = make_unsafe_serializer(memory->buffer());
+    auto serial = make_unsafe_serializer(memory.buffer());
 
     // Limited to tuple|iterator Key types.
     serial.write_forward(key);
@@ -105,14 +107,51 @@ Link list_element<Manager, Link, Key>::create(const Key& key,
     return link_;
 }
 
+// The caller allocated the element (e.g. as part of a slab range).
 template <typename Manager, typename Link, typename Key>
-void list_element<Manager, Link, Key>::write(write_function writer) const
+Link list_element<Manager, Link, Key>::create(Link link, const Key& key,
+    write_function write)
+{
+    link_ = link;
+    initialize(key, write);
+    return link_;
+}
+
+template <typename Manager, typename Link, typename Key>
+template <typename Writer>
+void list_element<Manager, Link, Key>::write(Writer writer) const
 {
-    const auto memory = data(std::tuple_size<Key>::value + sizeof(Link));
-    auto serial = make_unsafe_serializer(memory->buffer());
+    const auto memory = data(traits::value_offset);
+    auto serial = make_unsafe_serializer(memory.buffer());
     writer(serial);
 }
 
+template <typename Manager, typename Link, typename Key>
+template <typename Integer>
+void list_element<Manager, Link, Key>::write_little_endian(size_t offset,
+    Integer value) const
+{
+    const auto memory = data(traits::value_offset + offset);
+    auto serial = make_unsafe_serializer(memory.buffer());
+    serial.template write_little_endian<Integer>(value);
+}
+
+template <typename Manager, typename Link, typename Key>
+void list_element<Manager, Link, Key>::journal(size_t offset,
+    size_t size) const
+{
+    BITCOIN_ASSERT(link_ != not_found);
+    manager_.journal(link_, traits::value_offset + offset, size);
+}
+
+template <typename Manager, typename Link, typename Key>
+void list_element<Manager, Link, Key>::release(size_t offset,
+    size_t size) const
+{
+    BITCOIN_ASSERT(link_ != not_found);
+    manager_.release(link_, traits::value_offset + offset, size);
+}
+
 // Jump to the next element in the list.
 template <typename Manager, typename Link, typename Key>
 bool list_element<Manager, Link, Key>::jump_next()
@@ -135,36 +174,75 @@ void list_element<Manager, Link, Key>::terminate()
 template <typename Manager, typename Link, typename Key>
 void list_element<Manager, Link, Key>::set_next(Link next) const
 {
-    const auto memory = data(std::tuple_size<Key>::value);
-    auto serial = make_unsafe_serializer(memory->buffer());
+    const auto memory = data(0);
+    const auto buffer = memory.buffer();
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(mutex_);
-    serial.template write_little_endian<Link>(next);
+    {
+        unique_lock lock(mutex_);
+
+        if (traits::atomic_next(buffer))
+            traits::store_next(buffer, next);
+        else
+            traits::write_next(buffer, next);
+    }
     ///////////////////////////////////////////////////////////////////////////
+
+    manager_.journal(link_, traits::next_offset, sizeof(Link));
 }
 
 template <typename Manager, typename Link, typename Key>
-void list_element<Manager, Link, Key>::read(read_function reader) const
+template <typename Reader>
+void list_element<Manager, Link, Key>::read(Reader reader) const
 {
-    const auto memory = data(std::tuple_size<Key>::value + sizeof(Link));
-    auto deserial = make_unsafe_deserializer(memory->buffer());
+    const auto memory = data(traits::value_offset);
+    auto deserial = make_unsafe_deserializer(memory.buffer());
     reader(deserial);
 }
 
+template <typename Manager, typename Link, typename Key>
+template <typename Integer>
+Integer list_element<Manager, Link, Key>::read_little_endian(
+    size_t offset) const
+{
+    const auto memory = data(traits::value_offset + offset);
+    auto deserial = make_unsafe_deserializer(memory.buffer());
+    return deserial.template read_little_endian<Integer>();
+}
+
+template <typename Manager, typename Link, typename Key>
+template <typename Record, typename Reader>
+void list_element<Manager, Link, Key>::read_record(Reader reader) const
+{
+    static_assert(alignof(Record) == 1, "record must be unaligned");
+    const auto memory = data(traits::value_offset);
+    reader(*reinterpret_cast<const Record*>(memory.buffer()));
+}
+
+template <typename Manager, typename Link, typename Key>
+memory_ptr list_element<Manager, Link, Key>::state() const
+{
+    BITCOIN_ASSERT(link_ != not_found);
+
+    // The state may be held beyond the element, so it is reference counted.
+    auto memory = manager_.get(link_);
+    memory->increment(traits::value_offset);
+    return memory;
+}
+
 template <typename Manager, typename Link, typename Key>
 bool list_element<Manager, Link, Key>::match(const Key& key) const
 {
     const auto memory = data(0);
-    return std::equal(key.begin(), key.end(), memory->buffer());
+    return traits::match(memory.buffer(), key);
 }
 
 template <typename Manager, typename Link, typename Key>
 Key list_element<Manager, Link, Key>::key() const
 {
     const auto memory = data(0);
-    auto deserial = make_unsafe_deserializer(memory->buffer());
+    auto deserial = make_unsafe_deserializer(memory.buffer());
 
     // Limited to tuple Key types (see deserializer to generalize).
     return deserial.template read_forward<Key>();
@@ -179,13 +257,16 @@ Link list_element<Manager, Link, Key>::link() const
 template <typename Manager, typename Link, typename Key>
 Link list_element<Manager, Link, Key>::next() const
 {
-    const auto memory = data(std::tuple_size<Key>::value);
-    auto deserial = make_unsafe_deserializer(memory->buffer());
+    const auto memory = data(0);
+    const auto buffer = memory.buffer();
+
+    if (traits::atomic_next(buffer))
+        return traits::load_next(buffer);
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     shared_lock lock(mutex_);
-    return deserial.template read_little_endian<Link>();
+    return traits::read_next(buffer);
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -196,6 +277,13 @@ list_element<Manager, Link, Key>::terminator() const
     return { manager_, mutex_ };
 }
 
+template <typename Manager, typename Link, typename Key>
+list_element<Manager, Link, Key>
+list_element<Manager, Link, Key>::at(Link link) const
+{
+    return { manager_, link, mutex_ };
+}
+
 template <typename Manager, typename Link, typename Key>
 bool list_element<Manager, Link, Key>::terminal() const
 {
@@ -222,11 +310,11 @@ bool list_element<Manager, Link, Key>::operator!=(list_element other) const
 
 // private
 template <typename Manager, typename Link, typename Key>
-memory_ptr list_element<Manager, Link, Key>::data(size_t bytes) const
+memory_handle list_element<Manager, Link, Key>::data(size_t bytes) const
 {
     BITCOIN_ASSERT(link_ != not_found);
-    auto memory = manager_.get(link_);
-    memory->increment(bytes);
+    auto memory = manager_.pin(link_);
+    memory.increment(bytes);
     return memory;
 }
 
@@ -19,9 +19,12 @@
 #ifndef LIBBITCOIN_DATABASE_RECORD_MANAGER_IPP
 #define LIBBITCOIN_DATABASE_RECORD_MANAGER_IPP
 
+#include <atomic>
 #include <cstddef>
+#include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
 #include <bitcoin/database/memory/storage.hpp>
 
 /// [ record_count ]
@@ -40,7 +43,10 @@ record_manager<Link>::record_manager(storage& file, size_t header_size,
   : file_(file),
     header_size_(header_size),
     record_size_(record_size),
-    record_count_(0)
+    record_count_(0),
+    capacity_(0),
+    reserved_(0),
+    metrics_(nullptr)
 {
 }
 
@@ -56,7 +62,9 @@ bool record_manager<Link>::create()
         return false;
 
     // This currently throws if there is insufficient space.
-    file_.resize(header_size_ + link_to_position(record_count_));
+    reserved_ = header_size_ + link_to_position(record_count_);
+    file_.resize(reserved_);
+    capacity_ = file_.size();
     write_count();
     return true;
     ///////////////////////////////////////////////////////////////////////////
@@ -71,9 +79,36 @@ bool record_manager<Link>::start()
 
     read_count();
     const auto minimum = header_size_ + link_to_position(record_count_);
+    reserved_ = file_.size();
+    capacity_ = reserved_;
 
     // Records size does not exceed file size.
-    return minimum <= file_.size();
+    return minimum <= reserved_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+template <typename Link>
+bool record_manager<Link>::recover()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    reserved_ = file_.size();
+    capacity_ = reserved_;
+
+    // The file does not hold the count.
+    if (reserved_ < header_size_ + sizeof(Link))
+        return false;
+
+    read_count();
+    const auto fits = position_to_link(reserved_ - header_size_);
+
+    // Records allocated beyond the file were never written.
+    if (record_count_ > fits)
+        record_count_ = fits;
+
+    return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -83,6 +118,7 @@ void record_manager<Link>::commit()
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(mutex_);
+    reserve_allocated();
     write_count();
     ///////////////////////////////////////////////////////////////////////////
 }
@@ -90,11 +126,7 @@ void record_manager<Link>::commit()
 template <typename Link>
 Link record_manager<Link>::count() const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
     return record_count_;
-    ///////////////////////////////////////////////////////////////////////////
 }
 
 template <typename Link>
@@ -108,26 +140,55 @@ void record_manager<Link>::set_count(Link value)
     ///////////////////////////////////////////////////////////////////////////
 }
 
+template <typename Link>
+bool record_manager<Link>::contains(Link link) const
+{
+    return link < record_count_;
+}
+
 // Return the next index, regardless of the number created.
-// The file is thread safe, the critical section is to protect record_count_.
+// Concurrent writers allocate by increment while the records fit the mapped
+// file. The records are not reserved (journaled) in the file until commit.
 template <typename Link>
 Link record_manager<Link>::allocate(size_t count)
 {
+    if (metrics_ != nullptr)
+        metrics_->allocate(count * record_size_);
+
+    // Always write after the last index.
+    auto next_record_index = record_count_.load();
+
+    while (header_size_ + link_to_position(next_record_index + count) <=
+        capacity_)
+        if (record_count_.compare_exchange_weak(next_record_index,
+            static_cast<Link>(next_record_index + count)))
+            return next_record_index;
+
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(mutex_);
 
-    // Always write after the last index.
-    const auto next_record_index = record_count_;
-    const size_t position = link_to_position(record_count_ + count);
-    const size_t required_size = header_size_ + position;
+    while (true)
+    {
+        next_record_index = record_count_;
+        const size_t position = link_to_position(next_record_index + count);
+        const size_t required_size = header_size_ + position;
 
-    // Currently throws runtime_error if insufficient space.
-    if (!file_.reserve(required_size))
-        return 0;
+        if (required_size > capacity_)
+        {
+            // Currently throws runtime_error if insufficient space.
+            if (!file_.reserve(required_size))
+                return 0;
+
+            reserved_ = required_size;
+            capacity_ = file_.size();
+        }
 
-    record_count_ += count;
-    return next_record_index;
+        // Fails only if a concurrent allocation took the space first.
+        if (record_count_.compare_exchange_weak(next_record_index,
+            static_cast<Link>(next_record_index + count)))
+            return next_record_index;
+    }
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -143,6 +204,47 @@ memory_ptr record_manager<Link>::get(Link link) const
     return memory;
 }
 
+template <typename Link>
+memory_handle record_manager<Link>::pin(Link link) const
+{
+    auto memory = file_.pin();
+    memory.increment(header_size_ + link_to_position(link));
+    return memory;
+}
+
+template <typename Link>
+void record_manager<Link>::journal(Link link, size_t offset,
+    size_t size) const
+{
+    file_.journal(header_size_ + link_to_position(link) + offset, size);
+}
+
+template <typename Link>
+void record_manager<Link>::release(Link link, size_t offset,
+    size_t size) const
+{
+    file_.release(header_size_ + link_to_position(link) + offset, size);
+}
+
+template <typename Link>
+void record_manager<Link>::prefetch(Link link, size_t size) const
+{
+    file_.prefetch(header_size_ + link_to_position(link), size);
+}
+
+template <typename Link>
+void record_manager<Link>::enable_metrics(table_metrics& metrics)
+{
+    metrics_ = &metrics;
+}
+
+template <typename Link>
+scan_guard::ptr record_manager<Link>::scan(Link link, size_t size) const
+{
+    return std::make_shared<scan_guard>(file_,
+        header_size_ + link_to_position(link), size);
+}
+
 // privates
 
 // Read the count value from the first 32 bits of the file after the header.
@@ -168,7 +270,24 @@ void record_manager<Link>::write_count()
     const auto memory = file_.access();
     memory->increment(header_size_);
     auto serial = make_unsafe_serializer(memory->buffer());
-    serial.template write_little_endian<Link>(record_count_);
+    serial.template write_little_endian<Link>(record_count_.load());
+    file_.journal(header_size_, sizeof(Link));
+}
+
+// Reserving within the mapped file does not remap, it extends the logical
+// size (and journal) over the records allocated since the last reservation.
+template <typename Link>
+void record_manager<Link>::reserve_allocated()
+{
+    const size_t allocated = header_size_ +
+        link_to_position(record_count_);
+
+    if (allocated <= reserved_)
+        return;
+
+    // Currently throws runtime_error if insufficient space.
+    file_.reserve(allocated);
+    reserved_ = allocated;
 }
 
 template <typename Link>
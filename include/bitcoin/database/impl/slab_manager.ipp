@@ -19,9 +19,14 @@
 #ifndef LIBBITCOIN_DATABASE_SLAB_MANAGER_IPP
 #define LIBBITCOIN_DATABASE_SLAB_MANAGER_IPP
 
+#include <atomic>
 #include <cstddef>
+#include <memory>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/prefetcher.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
 #include <bitcoin/database/memory/storage.hpp>
 
 /// [ payload_size ] (includes self)
@@ -38,7 +43,10 @@ template <typename Link>
 slab_manager<Link>::slab_manager(storage& file, size_t header_size)
   : file_(file),
     header_size_(header_size),
-    payload_size_(sizeof(Link))
+    payload_size_(sizeof(Link)),
+    capacity_(0),
+    reserved_(0),
+    metrics_(nullptr)
 {
 }
 
@@ -54,7 +62,9 @@ bool slab_manager<Link>::create()
         return false;
 
     // This currently throws if there is insufficient space.
-    file_.resize(header_size_ + payload_size_);
+    reserved_ = header_size_ + payload_size_;
+    file_.resize(reserved_);
+    capacity_ = file_.size();
     write_size();
     return true;
     ///////////////////////////////////////////////////////////////////////////
@@ -69,9 +79,36 @@ bool slab_manager<Link>::start()
 
     read_size();
     const auto minimum = header_size_ + payload_size_;
+    reserved_ = file_.size();
+    capacity_ = reserved_;
 
     // Slabs size does not exceed file size.
-    return minimum <= file_.size();
+    return minimum <= reserved_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+template <typename Link>
+bool slab_manager<Link>::recover()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    reserved_ = file_.size();
+    capacity_ = reserved_;
+
+    // The file does not hold the size.
+    if (reserved_ < header_size_ + sizeof(Link))
+        return false;
+
+    read_size();
+    const auto fits = reserved_ - header_size_;
+
+    // Slabs allocated beyond the file were never written.
+    if (payload_size_ > fits)
+        payload_size_ = fits;
+
+    return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -81,6 +118,7 @@ void slab_manager<Link>::commit()
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(mutex_);
+    reserve_allocated();
     write_size();
     ///////////////////////////////////////////////////////////////////////////
 }
@@ -88,32 +126,57 @@ void slab_manager<Link>::commit()
 template <typename Link>
 size_t slab_manager<Link>::payload_size() const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
     return payload_size_;
-    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The size prefix is not a slab.
+template <typename Link>
+bool slab_manager<Link>::contains(Link position) const
+{
+    return position >= sizeof(Link) && position < payload_size_;
 }
 
 // Return is offset by header but not size storage (embedded in data files).
-// The file is thread safe, the critical section is to protect payload_size_.
+// Concurrent writers allocate by increment while the slabs fit the mapped
+// file. The slab is not reserved (journaled) in the file until commit.
 template <typename Link>
 Link slab_manager<Link>::allocate(size_t size)
 {
+    if (metrics_ != nullptr)
+        metrics_->allocate(size);
+
+    // Always write after the last slab.
+    auto next_slab_position = payload_size_.load();
+
+    while (header_size_ + next_slab_position + size <= capacity_)
+        if (payload_size_.compare_exchange_weak(next_slab_position,
+            next_slab_position + size))
+            return static_cast<Link>(next_slab_position);
+
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(mutex_);
 
-    // Always write after the last slab.
-    const auto next_slab_position = payload_size_;
-    const size_t required_size = header_size_ + payload_size_ + size;
+    while (true)
+    {
+        next_slab_position = payload_size_;
+        const size_t required_size = header_size_ + next_slab_position + size;
 
-    // Currently throws runtime_error if insufficient space.
-    if (!file_.reserve(required_size))
-        return not_allocated;
+        if (required_size > capacity_)
+        {
+            // Currently throws runtime_error if insufficient space.
+            if (!file_.reserve(required_size))
+                return not_allocated;
 
-    payload_size_ += size;
-    return next_slab_position;
+            reserved_ = required_size;
+            capacity_ = file_.size();
+        }
+
+        // Fails only if a concurrent allocation took the space first.
+        if (payload_size_.compare_exchange_weak(next_slab_position,
+            next_slab_position + size))
+            return static_cast<Link>(next_slab_position);
+    }
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -130,6 +193,61 @@ memory_ptr slab_manager<Link>::get(Link link) const
     return memory;
 }
 
+template <typename Link>
+memory_handle slab_manager<Link>::pin(Link link) const
+{
+    BITCOIN_ASSERT_MSG(link < payload_size(), "Read past end of file.");
+
+    auto memory = file_.pin();
+    memory.increment(header_size_ + link);
+    return memory;
+}
+
+template <typename Link>
+void slab_manager<Link>::journal(Link position, size_t offset,
+    size_t size) const
+{
+    file_.journal(header_size_ + position + offset, size);
+}
+
+template <typename Link>
+void slab_manager<Link>::release(Link position, size_t offset,
+    size_t size) const
+{
+    file_.release(header_size_ + position + offset, size);
+}
+
+template <typename Link>
+void slab_manager<Link>::prefetch(Link position, size_t size) const
+{
+    file_.prefetch(header_size_ + position, size);
+}
+
+template <typename Link>
+void slab_manager<Link>::prefetch(const std::vector<Link>& positions,
+    size_t size) const
+{
+    prefetcher::offsets offsets;
+    offsets.reserve(positions.size());
+
+    for (const auto position: positions)
+        offsets.push_back(header_size_ + position);
+
+    prefetcher(file_).prefetch(offsets, size);
+}
+
+template <typename Link>
+void slab_manager<Link>::enable_metrics(table_metrics& metrics)
+{
+    metrics_ = &metrics;
+}
+
+template <typename Link>
+scan_guard::ptr slab_manager<Link>::scan(Link position, size_t size) const
+{
+    return std::make_shared<scan_guard>(file_, header_size_ + position, size);
+}
+
 // privates
 
 // Read the size value from the first 64 bits of the file after the header.
@@ -145,6 +263,21 @@ void slab_manager<Link>::read_size()
     payload_size_ = deserial.template read_little_endian<Link>();
 }
 
+// Reserving within the mapped file does not remap, it extends the logical
+// size (and journal) over the slabs allocated since the last reservation.
+template <typename Link>
+void slab_manager<Link>::reserve_allocated()
+{
+    const size_t allocated = header_size_ + payload_size_;
+
+    if (allocated <= reserved_)
+        return;
+
+    // Currently throws runtime_error if insufficient space.
+    file_.reserve(allocated);
+    reserved_ = allocated;
+}
+
 // Write the size value to the first 64 bits of the file after the header.
 template <typename Link>
 void slab_manager<Link>::write_size() const
@@ -155,7 +288,9 @@ void slab_manager<Link>::write_size() const
     const auto memory = file_.access();
     memory->increment(header_size_);
     auto serial = make_unsafe_serializer(memory->buffer());
-    serial.template write_little_endian<Link>(payload_size_);
+    serial.template write_little_endian<Link>(
+        static_cast<Link>(payload_size_.load()));
+    file_.journal(header_size_, sizeof(Link));
 }
 
 } // namespace database
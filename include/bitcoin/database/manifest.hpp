@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_MANIFEST_HPP
+#define LIBBITCOIN_DATABASE_MANIFEST_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is not thread safe.
+/// The state of a cleanly closed store (table sizes and cached values), so
+/// that open can restore rather than reread it. The file is checksummed and
+/// is consumed by load, so that it cannot be reused after an unclean
+/// shutdown (the store is not closed, so the manifest is not rewritten).
+class BCD_API manifest
+  : noncopyable
+{
+public:
+    typedef boost::filesystem::path path;
+
+    /// Construct an empty manifest (the file is not read).
+    manifest(const path& filename);
+
+    /// Set the value of the name.
+    void set(const std::string& name, const data_chunk& value);
+
+    /// Set the value of the name to the current size of the file.
+    void set_size(const path& file);
+
+    /// Get the value of the name, false if not set.
+    bool get(const std::string& name, data_chunk& out_value) const;
+
+    /// The file is the size set for it, false if not set.
+    bool matches_size(const path& file) const;
+
+    /// The manifest has no values.
+    bool empty() const;
+
+    /// Remove all values.
+    void clear();
+
+    /// Load the values from the file, and remove the file. False (and
+    /// empty) if there is no file or it is invalid.
+    bool load();
+
+    /// Save the values to the file.
+    bool save() const;
+
+private:
+    static std::string size_name(const path& file);
+
+    const path filename_;
+    std::map<std::string, data_chunk> values_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_MAP_ADVICE_HPP
+#define LIBBITCOIN_DATABASE_MAP_ADVICE_HPP
+
+#include <cstdint>
+
+namespace libbitcoin {
+namespace database {
+
+/// The NUMA memory policy of a memory map.
+enum class numa_policy : uint8_t
+{
+    /// The default policy of the process.
+    none = 0,
+
+    /// Pages are allocated only from the nodes.
+    bind = 1,
+
+    /// Pages are allocated round robin across the nodes.
+    interleave = 2
+};
+
+/// Advice for the memory map of a table file, applied on each (re)map.
+/// Advice is only a hint, so a failure to apply it is not an error.
+/// Value initialization (all zero) is no advice.
+struct map_advice
+{
+    /// Limit advice to the hash table header (bucket rows), if any.
+    bool header_only;
+
+    /// Back the map with transparent huge pages (MADV_HUGEPAGE).
+    bool huge_pages;
+
+    /// Fault the map in when mapped (MADV_POPULATE_READ or MADV_WILLNEED).
+    bool populate;
+
+    /// Lock the map into memory (mlock, subject to RLIMIT_MEMLOCK).
+    bool lock;
+
+    /// Mark the map beyond the header as first to be reclaimed (MADV_COLD),
+    /// so that payload is evicted before the pinned header (header_only).
+    bool cold;
+
+    /// The NUMA memory policy (mbind, linux only).
+    numa_policy numa;
+
+    /// The NUMA nodes of the policy, as a bit mask (node zero is bit zero).
+    uint64_t numa_nodes;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
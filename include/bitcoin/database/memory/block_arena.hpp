@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_BLOCK_ARENA_HPP
+#define LIBBITCOIN_DATABASE_BLOCK_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is not thread safe.
+/// A monotonic arena for the temporaries of a block write. Allocations are
+/// not freed individually, all are released by reset. Reset retains one chunk
+/// of the peak size, so a steady working set is allocated without heap calls.
+class BCD_API block_arena
+  : noncopyable
+{
+public:
+    /// The minimum size of a chunk.
+    static const size_t default_chunk_size;
+
+    /// Defers the reset of the arena until the outermost scope is destroyed.
+    class scope
+      : noncopyable
+    {
+    public:
+        scope(block_arena& arena);
+        ~scope();
+
+    private:
+        block_arena& arena_;
+    };
+
+    /// Construct an empty arena (allocates on first use).
+    block_arena(size_t chunk_size=default_chunk_size);
+
+    /// Allocate uninitialized memory, alignment must be a power of two.
+    /// Throws bad_alloc if a chunk cannot be allocated.
+    void* allocate(size_t size, size_t alignment);
+
+    /// Release all allocations (invalidates them), retaining the memory.
+    void reset();
+
+    /// The number of bytes allocated since reset (including padding).
+    size_t used() const;
+
+    /// The number of bytes held by the arena.
+    size_t capacity() const;
+
+private:
+    typedef std::unique_ptr<uint8_t[]> chunk;
+
+    void grow(size_t minimum);
+
+    const size_t chunk_size_;
+
+    // The full chunks, released (coalesced into one) by reset.
+    std::vector<std::pair<chunk, size_t>> full_;
+
+    chunk current_;
+    size_t current_size_;
+    size_t offset_;
+    size_t used_;
+    size_t depth_;
+};
+
+/// A standard allocator of the arena, deallocation is deferred to reset.
+template <typename Type>
+class arena_allocator
+{
+public:
+    typedef Type value_type;
+
+    arena_allocator(block_arena& arena)
+      : arena_(&arena)
+    {
+    }
+
+    template <typename Other>
+    arena_allocator(const arena_allocator<Other>& other)
+      : arena_(other.arena_)
+    {
+    }
+
+    Type* allocate(size_t count)
+    {
+        return static_cast<Type*>(arena_->allocate(count * sizeof(Type),
+            alignof(Type)));
+    }
+
+    void deallocate(Type*, size_t)
+    {
+    }
+
+    template <typename Other>
+    bool operator==(const arena_allocator<Other>& other) const
+    {
+        return arena_ == other.arena_;
+    }
+
+    template <typename Other>
+    bool operator!=(const arena_allocator<Other>& other) const
+    {
+        return arena_ != other.arena_;
+    }
+
+private:
+    template <typename Other>
+    friend class arena_allocator;
+
+    block_arena* arena_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
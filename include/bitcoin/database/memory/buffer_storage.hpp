@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_BUFFER_STORAGE_HPP
+#define LIBBITCOIN_DATABASE_BUFFER_STORAGE_HPP
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory_storage.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe, allowing concurent read and write.
+/// The table is held in a userspace buffer (see memory_storage) that is read
+/// from the file on open and written back with pwrite on flush and close,
+/// for platforms on which memory map scaling is poor. The file is required.
+class BCD_API buffer_storage
+  : public memory_storage
+{
+public:
+    /// Construct a table.
+    buffer_storage(const path& filename, size_t expansion);
+
+    /// Close the table.
+    ~buffer_storage();
+
+protected:
+    bool persist(size_t offset, size_t size, bool sync) const override;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -27,16 +27,24 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
 #include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/table_metrics.hpp>
 
 namespace libbitcoin {
 namespace database {
 
 /// This class is thread safe, allowing concurent read and write.
+/// Readers pin the current mapping with an atomic count (no mutex).
+/// A pin must be released on the thread that took it, and a thread that
+/// holds a pin may pin again (nest accessors) while a remap is pending.
 /// A change to the size of the memory map waits on and locks read and write.
 class BCD_API file_storage
   : public storage
@@ -49,6 +57,13 @@ public:
     file_storage(const path& filename);
     file_storage(const path& filename, size_t expansion);
 
+    /// Reserve address space so that growth within it never moves the map.
+    file_storage(const path& filename, size_t expansion, size_t reservation);
+
+    /// Map the file read only (a secondary of a file written elsewhere).
+    file_storage(const path& filename, size_t expansion, size_t reservation,
+        bool read_only);
+
     /// Close the database.
     ~file_storage();
 
@@ -58,18 +73,34 @@ public:
     /// Flush the memory map to disk, idempotent.
     bool flush() const;
 
+    /// Schedule asynchronous writeback of the dirty range, idempotent.
+    bool flush_dirty() const;
+
     /// Unmap and release files, restartable, idempotent.
     bool close();
 
     /// Determine if the database is closed.
     bool closed() const;
 
+    /// Map the growth of the file by its writer (read only).
+    bool refresh();
+
     /// The current physical (vs. logical) size of the map.
     size_t size() const;
 
-    /// Get protected shared access to memory, starting at first byte.
+    /// The current logical (vs. physical) size of the map.
+    size_t logical_size() const;
+
+    /// The number of bytes of the map resident in memory (mincore, zero if
+    /// not supported).
+    size_t resident_size() const;
+
+    /// Get pinned (lock-free) access to memory, starting at first byte.
     memory_ptr access();
 
+    /// Get pinned access to memory without allocation, at first byte.
+    memory_handle pin();
+
     /// Throws runtime_error if insufficient space.
     /// Resize the logical map to the specified size, return access.
     /// Increase or shrink the physical size to match the logical size.
@@ -80,19 +111,69 @@ public:
     /// Increase the physical size to at least the logical size.
     memory_ptr reserve(size_t size);
 
+    /// Record a range written in place, for inclusion in the next journal.
+    void journal(file_offset offset, size_t size);
+
+    /// Zero a range written in place, punching a hole over its whole pages
+    /// where supported (journaled as a write).
+    void release(file_offset offset, size_t size);
+
+    /// Advise that a range will soon be read (may be ignored).
+    void prefetch(file_offset offset, size_t size);
+
+    /// Advise a sequential read of a range, or revert it (may be ignored).
+    void scan(file_offset offset, size_t size, bool sequential);
+
+    /// Begin recording reserved and journaled ranges.
+    void enable_journal();
+
+    /// Apply the advice to the map on each (re)map, must be closed.
+    void enable_advice(const map_advice& advice, size_t header_size);
+
+    /// Apply the growth policy to each reservation, must be closed.
+    void enable_growth(const file_growth& growth);
+
+    /// Allocate the next growth if within the pregrow threshold of the
+    /// physical size, without changing the size of the file.
+    void pregrow();
+
+    /// The file is not segmented, so this is ignored.
+    size_t compress(size_t retain);
+
+    /// Write the after-image of recorded ranges to the log and clear them.
+    bool log_writes(commit_log& log);
+
+    /// Count remaps into the metrics (call before open).
+    void enable_metrics(table_metrics& metrics);
+
 private:
+    typedef std::pair<file_offset, size_t> range;
+
+    static void unpin(void* readers);
     static size_t file_size(int file_handle);
-    static int open_file(const boost::filesystem::path& filename);
+    static int open_file(const boost::filesystem::path& filename,
+        bool read_only);
     static bool handle_error(const std::string& context,
         const boost::filesystem::path& filename);
 
     size_t page() const;
+    int protection() const;
+    size_t mapped_size() const;
     bool unmap();
     bool map(size_t size);
+    bool map_reserved(size_t size);
+    bool map_extend(size_t size);
     bool remap(size_t size);
+    bool map_grown(size_t size);
+    size_t target(size_t size, size_t expansion) const;
+    bool allocate(size_t size);
     bool truncate(size_t size);
     bool truncate_mapped(size_t size);
     bool validate(size_t size);
+    void advise() const;
+    uint8_t* pin_readers();
+    void drain_readers();
+    void release_readers();
     memory_ptr reserve(size_t size, size_t growth_ratio);
 
     void log_mapping() const;
@@ -104,6 +185,8 @@ private:
     // File system.
     const int file_handle_;
     const size_t expansion_;
+    const size_t reservation_;
+    const bool read_only_;
     const boost::filesystem::path filename_;
 
     // Protected by mutex.
@@ -111,7 +194,28 @@ private:
     uint8_t* data_;
     size_t file_size_;
     size_t logical_size_;
+    size_t reserved_;
+    map_advice advice_;
+    size_t advice_size_;
+    file_growth growth_;
+    mutable size_t dirty_begin_;
+    mutable size_t dirty_end_;
     mutable upgrade_mutex mutex_;
+
+    // Mapping pins, drained (under exclusive mutex) before any remap.
+    std::atomic<size_t> readers_;
+    std::atomic<bool> remapping_;
+
+    // The end of the background allocation, beyond the physical size.
+    std::atomic<size_t> allocated_;
+
+    // Optional counters, set before open.
+    table_metrics* metrics_;
+
+    // Journaled ranges, protected by journal mutex.
+    bool journaled_;
+    std::vector<range> journal_;
+    mutable shared_mutex journal_mutex_;
 };
 
 } // namespace database
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_MEMORY_HANDLE_HPP
+#define LIBBITCOIN_DATABASE_MEMORY_HANDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is not thread safe.
+/// Move-only remap safe access to a memory map, held by value. The storage
+/// pins the map before construction and the handle calls the release handler
+/// upon destruction. Unlike memory_ptr this requires no heap allocation or
+/// reference counting, so it is used for short-lived element access.
+class BCD_API memory_handle
+{
+public:
+    typedef void (*release_handler)(void* context);
+
+    /// Construct a handle without access (releases nothing).
+    memory_handle();
+
+    /// Construct a handle of pinned data, released by handler(context).
+    memory_handle(uint8_t* data, release_handler release, void* context);
+
+    /// Transfer the pin, the other handle is left without access.
+    memory_handle(memory_handle&& other);
+    memory_handle& operator=(memory_handle&& other);
+
+    /// Release the pin.
+    ~memory_handle();
+
+    memory_handle(const memory_handle&) = delete;
+    memory_handle& operator=(const memory_handle&) = delete;
+
+    /// True if the handle provides access.
+    operator bool() const;
+
+    /// Get the buffer pointer.
+    uint8_t* buffer() const;
+
+    /// Advance the buffer pointer a specified number of bytes.
+    void increment(size_t value);
+
+private:
+    void release();
+
+    uint8_t* data_;
+    release_handler release_;
+    void* context_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
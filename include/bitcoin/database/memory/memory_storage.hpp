@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_MEMORY_STORAGE_HPP
+#define LIBBITCOIN_DATABASE_MEMORY_STORAGE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe, allowing concurent read and write.
+/// The table is held in anonymous memory (optionally huge pages). It is read
+/// from the file (if any) on open, but writes are not persisted (regtest and
+/// benchmarks). Readers pin the buffer with an atomic count (no mutex).
+/// A change to the size of the buffer waits on and locks read and write.
+class BCD_API memory_storage
+  : public storage
+{
+public:
+    typedef boost::filesystem::path path;
+
+    /// Construct a table, the file is read by open but is not required.
+    memory_storage(const path& filename, size_t expansion,
+        bool huge_pages=false);
+
+    /// Close the table.
+    ~memory_storage();
+
+    /// Allocate the buffer and read the file into it, must be closed.
+    bool open();
+
+    /// Write the buffer to the file (if persisted), idempotent.
+    bool flush() const;
+
+    /// Write the newly-allocated range to the file (if persisted).
+    bool flush_dirty() const;
+
+    /// Release the buffer and file, idempotent.
+    bool close();
+
+    /// Determine if the table is closed.
+    bool closed() const;
+
+    /// The buffer is not shared, so this is ignored.
+    bool refresh();
+
+    /// The current physical (vs. logical) size of the buffer.
+    size_t size() const;
+
+    /// The current logical (vs. physical) size of the buffer.
+    size_t logical_size() const;
+
+    /// The buffer is resident, so this is its physical size.
+    size_t resident_size() const;
+
+    /// Get pinned (lock-free) access to memory, starting at first byte.
+    memory_ptr access();
+
+    /// Get pinned access to memory without allocation, at first byte.
+    memory_handle pin();
+
+    /// Throws runtime_error if insufficient memory.
+    /// Resize the logical buffer to the specified size, return access.
+    /// Increase or shrink the physical size to match the logical size.
+    memory_ptr resize(size_t size);
+
+    /// Throws runtime_error if insufficient memory.
+    /// Resize the logical buffer to the specified size, return access.
+    /// Increase the physical size to at least the logical size.
+    memory_ptr reserve(size_t size);
+
+    /// Record a range written in place, for inclusion in the next journal.
+    void journal(file_offset offset, size_t size);
+
+    /// Zero a range written in place (the buffer is not released).
+    void release(file_offset offset, size_t size);
+
+    /// The buffer is resident, so this is ignored.
+    void prefetch(file_offset offset, size_t size);
+
+    /// The buffer is resident, so this is ignored.
+    void scan(file_offset offset, size_t size, bool sequential);
+
+    /// Begin recording reserved and journaled ranges.
+    void enable_journal();
+
+    /// The buffer is resident, so this is ignored.
+    void enable_advice(const map_advice& advice, size_t header_size);
+
+    /// The buffer is grown by the expansion rate, so this is ignored.
+    void enable_growth(const file_growth& growth);
+
+    /// The buffer is grown by the expansion rate, so this is ignored.
+    void pregrow();
+
+    /// The buffer is not segmented, so this is ignored.
+    size_t compress(size_t retain);
+
+    /// Write the after-image of recorded ranges to the log and clear them.
+    bool log_writes(commit_log& log);
+
+    /// Count remaps into the metrics (call before open).
+    void enable_metrics(table_metrics& metrics);
+
+protected:
+    /// Write a range of the buffer to the file, sync (and fit the file to
+    /// the logical size) if specified. Called under lock, does nothing here.
+    virtual bool persist(size_t offset, size_t size, bool sync) const;
+
+    /// Read or write a range of the file at the offset.
+    bool read_file(uint8_t* data, size_t offset, size_t size) const;
+    bool write_file(const uint8_t* data, size_t offset, size_t size) const;
+
+    /// Signal an error for logging.
+    bool handle_error(const std::string& context) const;
+
+    // File system.
+    const int file_handle_;
+    const path filename_;
+
+    // Protected by mutex.
+    uint8_t* data_;
+    size_t logical_size_;
+
+private:
+    typedef std::pair<file_offset, size_t> range;
+
+    static void unpin(void* readers);
+
+    uint8_t* allocate(size_t capacity) const;
+    void deallocate();
+    bool reallocate(size_t capacity);
+    uint8_t* pin_readers();
+    void drain_readers();
+    void release_readers();
+    memory_ptr reserve(size_t size, size_t growth_ratio);
+
+    const size_t expansion_;
+    const bool huge_pages_;
+
+    // Protected by mutex.
+    bool closed_;
+    size_t capacity_;
+    mutable size_t dirty_begin_;
+    mutable size_t dirty_end_;
+    mutable upgrade_mutex mutex_;
+
+    // Buffer pins, drained (under exclusive mutex) before any reallocation.
+    std::atomic<size_t> readers_;
+    std::atomic<bool> remapping_;
+
+    // Optional counters, set before open.
+    table_metrics* metrics_;
+
+    // Journaled ranges, protected by journal mutex.
+    bool journaled_;
+    std::vector<range> journal_;
+    mutable shared_mutex journal_mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_PINNED_ACCESSOR_HPP
+#define LIBBITCOIN_DATABASE_PINNED_ACCESSOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class provides lock-free read/write access to a memory buffer.
+/// The caller must have pinned the mapping by incrementing the reader count,
+/// which this class releases upon destruction. A remap waits on the count.
+/// Pins are recorded per thread, so a pin must be released on the thread
+/// that took it. A thread that holds a pin may pin again without waiting on a
+/// pending remap, which cannot proceed until the thread's pins are released.
+class BCD_API pinned_accessor
+  : public memory, noncopyable
+{
+public:
+    /// Assign a buffer pointer already pinned by the reader count.
+    pinned_accessor(std::atomic<size_t>& readers, uint8_t* data);
+
+    /// Release the mapping pin.
+    ~pinned_accessor();
+
+    /// Get the buffer pointer.
+    uint8_t* buffer();
+
+    /// Advance the buffer pointer a specified number of bytes.
+    void increment(size_t value);
+
+    /// True if the calling thread holds a pin of the reader count.
+    static bool held(const std::atomic<size_t>& readers);
+
+    /// Record a pin of the reader count taken by the calling thread.
+    static void hold(const std::atomic<size_t>& readers);
+
+    /// Release a pin of the reader count taken by the calling thread.
+    static void release(std::atomic<size_t>& readers);
+
+private:
+    std::atomic<size_t>& readers_;
+    uint8_t* data_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
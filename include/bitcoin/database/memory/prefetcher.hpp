@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_PREFETCHER_HPP
+#define LIBBITCOIN_DATABASE_PREFETCHER_HPP
+
+#include <cstddef>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// Advises the storage that a batch of ranges will soon be read, so that the
+/// subsequent mapped accesses hit the page cache. Nearby ranges are coalesced
+/// so that each run of pages is a single asynchronous read-ahead request.
+class BCD_API prefetcher
+  : noncopyable
+{
+public:
+    typedef std::vector<file_offset> offsets;
+
+    /// Ranges within the distance (bytes) of each other are coalesced.
+    static const size_t default_distance;
+
+    prefetcher(storage& file, size_t distance=default_distance);
+
+    /// Advise that size bytes at each offset will soon be read (reorders).
+    void prefetch(offsets& batch, size_t size) const;
+
+private:
+    // This class is thread and remap safe.
+    storage& file_;
+    const size_t distance_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
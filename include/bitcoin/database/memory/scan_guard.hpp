@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_SCAN_GUARD_HPP
+#define LIBBITCOIN_DATABASE_SCAN_GUARD_HPP
+
+#include <cstddef>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class advises a sequential read of a range of the storage for its
+/// lifetime, which is reverted upon destruction. Advice is only a hint, and
+/// concurrent guards over overlapping ranges are not reference counted.
+class BCD_API scan_guard
+  : noncopyable
+{
+public:
+    typedef std::shared_ptr<scan_guard> ptr;
+
+    /// Advise a sequential read of the range (read ahead).
+    scan_guard(storage& file, file_offset offset, size_t size);
+
+    /// Revert the range to the default access pattern.
+    ~scan_guard();
+
+private:
+    storage& file_;
+    const file_offset offset_;
+    const size_t size_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_SEGMENTED_STORAGE_HPP
+#define LIBBITCOIN_DATABASE_SEGMENTED_STORAGE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe, allowing concurent read and write.
+/// The table is a sequence of fixed-size segment files, each mapped at its
+/// offset into one reserved address range, so a link is the segment (link /
+/// segment size) and its offset (link % segment size). Growth maps a new
+/// segment, so the map never moves and readers are never drained. The first
+/// segment is the file itself, others are suffixed by their ordinal. Full
+/// segments that are not writable (e.g. moved to cold or compressed storage)
+/// are mapped read only, so must not be written in place.
+class BCD_API segmented_storage
+  : public storage
+{
+public:
+    typedef boost::filesystem::path path;
+    static const size_t default_segment_size;
+    static const size_t default_segments;
+
+    /// The file of the segment, the table file for the first segment.
+    static path segment_filename(const path& filename, size_t segment);
+
+    /// The segment size of a segmented table (the size of its first segment
+    /// if followed by another), zero if the table has only one segment.
+    static size_t segment_size(const path& filename);
+
+    /// Construct a table of segments of the page-aligned size, reserving
+    /// address space for the number of segments.
+    segmented_storage(const path& filename,
+        size_t segment_size=default_segment_size,
+        size_t segments=default_segments, bool read_only=false);
+
+    /// Close the table.
+    ~segmented_storage();
+
+    /// Open and map the segment files, must be closed.
+    bool open();
+
+    /// Flush the memory map to disk, idempotent.
+    bool flush() const;
+
+    /// Schedule asynchronous writeback of the dirty range, idempotent.
+    bool flush_dirty() const;
+
+    /// Unmap and release the segment files, fitting the last to the logical
+    /// size and removing any beyond it, restartable, idempotent.
+    bool close();
+
+    /// Determine if the table is closed.
+    bool closed() const;
+
+    /// Map the segments added by the writer (read only).
+    bool refresh();
+
+    /// The current physical (vs. logical) size of the map (whole segments).
+    size_t size() const;
+
+    /// The current logical (vs. physical) size of the map.
+    size_t logical_size() const;
+
+    /// The number of bytes of the map resident in memory (mincore, zero if
+    /// not supported).
+    size_t resident_size() const;
+
+    /// The number of mapped segments.
+    size_t segments() const;
+
+    /// Get pinned (lock-free) access to memory, starting at first byte.
+    memory_ptr access();
+
+    /// Get pinned access to memory without allocation, at first byte.
+    memory_handle pin();
+
+    /// Throws runtime_error if insufficient space or segments.
+    /// Resize the logical map to the specified size, return access.
+    /// Increase the physical size to whole segments covering the size.
+    memory_ptr resize(size_t size);
+
+    /// Throws runtime_error if insufficient space or segments.
+    /// Resize the logical map to the specified size, return access.
+    /// Increase the physical size to whole segments covering the size.
+    memory_ptr reserve(size_t size);
+
+    /// Record a range written in place, for inclusion in the next journal.
+    void journal(file_offset offset, size_t size);
+
+    /// Zero a range written in place, punching a hole over its whole pages
+    /// in each segment where supported (journaled as a write).
+    void release(file_offset offset, size_t size);
+
+    /// Advise that a range will soon be read (may be ignored).
+    void prefetch(file_offset offset, size_t size);
+
+    /// Advise a sequential read of a range, or revert it (may be ignored).
+    void scan(file_offset offset, size_t size, bool sequential);
+
+    /// Begin recording reserved and journaled ranges.
+    void enable_journal();
+
+    /// Apply the advice to each segment as it is mapped, must be closed.
+    void enable_advice(const map_advice& advice, size_t header_size);
+
+    /// Growth is by whole segments, so only preallocation is applied.
+    void enable_growth(const file_growth& growth);
+
+    /// Growth is by whole segments, so this is ignored.
+    void pregrow();
+
+    /// Compress the next full segment that is older than the retained most
+    /// recent segments, in place where the file system supports it (btrfs).
+    /// The first segment holds the table header and is never compressed.
+    size_t compress(size_t retain);
+
+    /// Write the after-image of recorded ranges to the log and clear them.
+    bool log_writes(commit_log& log);
+
+    /// Segments are mapped in place, so there are no remaps to count.
+    void enable_metrics(table_metrics& metrics);
+
+private:
+    typedef std::pair<file_offset, size_t> range;
+
+    static void unpin(void* readers);
+
+    size_t page() const;
+    bool map_segment(size_t segment, bool create, bool last);
+    bool fit(size_t size);
+    void advise(size_t start, size_t end) const;
+    uint8_t* pin_readers();
+    void drain_readers();
+    bool handle_error(const std::string& context) const;
+
+    // File system.
+    const size_t segment_size_;
+    const size_t segments_;
+    const bool read_only_;
+    const path filename_;
+
+    // Protected by mutex.
+    bool closed_;
+    uint8_t* data_;
+    std::vector<int> handles_;
+    size_t file_size_;
+    size_t logical_size_;
+    map_advice advice_;
+    size_t advice_size_;
+    file_growth growth_;
+    mutable size_t dirty_begin_;
+    mutable size_t dirty_end_;
+    mutable upgrade_mutex mutex_;
+
+    // Segment pins, drained (under exclusive mutex) only by close.
+    std::atomic<size_t> readers_;
+
+    // The next segment to compress, the first segment (header) is excluded.
+    std::atomic<size_t> compressed_;
+    std::atomic<bool> compressible_;
+
+    // Journaled ranges, protected by journal mutex.
+    bool journaled_;
+    std::vector<range> journal_;
+    mutable shared_mutex journal_mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -19,9 +19,18 @@
 #ifndef LIBBITCOIN_DATABASE_STORAGE_HPP
 #define LIBBITCOIN_DATABASE_STORAGE_HPP
 
+#include <cstddef>
+#include <memory>
+#include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/map_advice.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -31,24 +40,52 @@ class BCD_API storage
   : noncopyable
 {
 public:
+    typedef std::shared_ptr<storage> ptr;
+
+    /// Construct the storage of the file by backend (reservation is ignored
+    /// unless the file is mapped, segments are of the default size).
+    static ptr factory(storage_backend backend,
+        const boost::filesystem::path& filename, size_t expansion,
+        size_t reservation=0);
+
+    /// Add the logical, physical and resident sizes of the file to values.
+    static void footprint(table_metrics::values& values,
+        const storage& file);
+
     /// Open and map database files, must be closed.
     virtual bool open() = 0;
 
     /// Flush the memory map to disk, idempotent.
     virtual bool flush() const = 0;
 
+    /// Schedule asynchronous writeback of newly-allocated space.
+    virtual bool flush_dirty() const = 0;
+
     /// Unmap and release files, restartable, idempotent.
     virtual bool close() = 0;
 
     /// Determine if the database is closed.
     virtual bool closed() const = 0;
 
+    /// Map the growth of the file by its writer (read only, may be ignored).
+    virtual bool refresh() = 0;
+
     /// The current physical (vs. logical) size of the map.
     virtual size_t size() const = 0;
 
+    /// The current logical (vs. physical) size of the map.
+    virtual size_t logical_size() const = 0;
+
+    /// The number of bytes of the map resident in memory (may be estimated).
+    virtual size_t resident_size() const = 0;
+
     /// Get protected shared access to memory, starting at first byte.
     virtual memory_ptr access() = 0;
 
+    /// Get protected access to memory without allocation, at first byte.
+    /// Prefer this to access() for short-lived, scoped reads and writes.
+    virtual memory_handle pin() = 0;
+
     /// Resize the logical map to the specified size, return access.
     /// Increase or shrink the physical size to match the logical size.
     virtual memory_ptr resize(size_t size) = 0;
@@ -56,6 +93,43 @@ public:
     /// Resize the logical map to the specified size, return access.
     /// Increase the physical size to at least the logical size.
     virtual memory_ptr reserve(size_t size) = 0;
+
+    /// Record a range written in place, for inclusion in the next journal.
+    virtual void journal(file_offset offset, size_t size) = 0;
+
+    /// Zero a range written in place and return its whole pages to the file
+    /// system where supported (journaled as a write).
+    virtual void release(file_offset offset, size_t size) = 0;
+
+    /// Advise that a range will soon be read (may be ignored).
+    virtual void prefetch(file_offset offset, size_t size) = 0;
+
+    /// Advise a sequential read of a range, or revert it (may be ignored).
+    virtual void scan(file_offset offset, size_t size, bool sequential) = 0;
+
+    /// Begin recording reserved and journaled ranges.
+    virtual void enable_journal() = 0;
+
+    /// Apply the advice to the map (within the header if header_only).
+    virtual void enable_advice(const map_advice& advice,
+        size_t header_size) = 0;
+
+    /// Apply the growth policy to each reservation (may be ignored).
+    virtual void enable_growth(const file_growth& growth) = 0;
+
+    /// Allocate the next growth if within the pregrow threshold of the
+    /// physical size, without blocking readers or writer (may be ignored).
+    virtual void pregrow() = 0;
+
+    /// Compress the next cold segment, retaining the most recent segments
+    /// uncompressed, returns the number compressed (may be ignored).
+    virtual size_t compress(size_t retain) = 0;
+
+    /// Write the after-image of recorded ranges to the log and clear them.
+    virtual bool log_writes(commit_log& log) = 0;
+
+    /// Count remaps into the metrics (call before open, may be ignored).
+    virtual void enable_metrics(table_metrics& metrics) = 0;
 };
 
 } // namespace database
@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_PARALLEL_HPP
+#define LIBBITCOIN_DATABASE_PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// Handle the half-open range [first, last) of a partitioned sequence.
+typedef std::function<void(size_t first, size_t last)> partition_handler;
+
+/// The number of threads implied by a configured value (zero is all cores).
+BCD_API size_t parallelism(size_t configured);
+
+/// Partition [0, count) into contiguous ranges of at least minimum items and
+/// handle them concurrently, on up to threads threads (including the caller).
+/// Returns once all ranges are handled. Handlers must not throw.
+BCD_API void parallel_for(size_t count, size_t threads, size_t minimum,
+    const partition_handler& handler);
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_CHUNK_ELEMENT_HPP
+#define LIBBITCOIN_DATABASE_CHUNK_ELEMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// A row of an unrolled list, where rows are stored in linked chunks.
+/// Rows are navigated newest first, within a chunk and then to the next.
+/// The position of a row (chunk link and slot) is stable while it exists.
+template <typename Manager, typename Link>
+class chunk_element
+{
+public:
+    typedef byte_deserializer::functor read_function;
+    static const auto not_found = (Link)bc::max_uint64;
+
+    /// The offset of the first row in a chunk.
+    static const size_t header_size = sizeof(Link) + 2 * sizeof(uint8_t);
+
+    /// Slots are one byte, so a position is the chunk shifted by eight bits.
+    static const size_t slot_bits = 8;
+
+    /// The stored size of a chunk of rows with the given capacity.
+    static size_t size(size_t capacity, size_t value_size);
+
+    /// The position of the given chunk and slot (not_found if terminal).
+    static uint64_t position(Link chunk, size_t slot);
+
+    /// Construct a terminator.
+    chunk_element(Manager& manager, size_t value_size, shared_mutex& mutex);
+
+    /// Construct for the newest row of the chunk (terminal if chunk is).
+    chunk_element(Manager& manager, size_t value_size, Link chunk,
+        shared_mutex& mutex);
+
+    /// Construct for the row at the slot of the chunk.
+    chunk_element(Manager& manager, size_t value_size, Link chunk,
+        size_t slot, shared_mutex& mutex);
+
+    /// Update this element to the next older row (read from file).
+    bool jump_next();
+
+    /// Convert the instance into a terminator.
+    void terminate();
+
+    /// Read from the state of the row.
+    /// Reader is any callable of byte_deserializer&, inlined (not type erased).
+    template <typename Reader>
+    void read(Reader reader) const;
+
+    /// The chunk of this row.
+    Link chunk() const;
+
+    /// The position of this row (not_found if terminal).
+    uint64_t position() const;
+
+    /// A terminator for this instance.
+    chunk_element terminator() const;
+
+    /// The element is terminal (not found, cannot be read).
+    bool terminal() const;
+
+    /// Cast operator, true if element was found (not terminal).
+    operator bool() const;
+
+    /// Equality comparison operators, compares position only.
+    bool operator==(const chunk_element& other) const;
+    bool operator!=(const chunk_element& other) const;
+
+private:
+    void seek(Link chunk);
+
+    Link chunk_;
+    size_t slot_;
+    size_t value_size_;
+    Manager& manager_;
+    shared_mutex& mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#include <bitcoin/database/impl/chunk_element.ipp>
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_ELEMENT_TRAITS_HPP
+#define LIBBITCOIN_DATABASE_ELEMENT_TRAITS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// Key comparison of a fixed width, bytewise unless specialized.
+/// The hash widths of the store (hash_digest and short_hash) are specialized
+/// to compare in words without branching.
+template <size_t Size>
+struct key_compare
+{
+    static bool equal(const uint8_t* left, const uint8_t* right);
+};
+
+template <>
+struct key_compare<hash_size>
+{
+    static bool equal(const uint8_t* left, const uint8_t* right);
+};
+
+template <>
+struct key_compare<short_hash_size>
+{
+    static bool equal(const uint8_t* left, const uint8_t* right);
+};
+
+/// The layout of a list element, with offsets and widths as compile-time
+/// constants, so that element access compiles to straight-line code.
+///
+///   [ key:Key     ]
+///   [ next:Link   ]
+///   [ value...    ]
+///
+/// Link cannot exceed 64 bits. The next link is little-endian.
+/// A naturally aligned next link (on a little-endian platform) may also be
+/// accessed atomically, so that it is published to readers without a lock.
+template <typename Link, typename Key>
+struct element_traits
+{
+    static_assert(sizeof(Link) <= sizeof(uint64_t), "link too wide");
+    static_assert(sizeof(std::atomic<Link>) == sizeof(Link),
+        "atomic link must have the layout of the link");
+
+    static const size_t key_size = std::tuple_size<Key>::value;
+    static const size_t next_offset = key_size;
+    static const size_t value_offset = key_size + sizeof(Link);
+
+    /// The stored size of an element with a value of the given size.
+    static size_t size(size_t value_size);
+
+    /// True if the key of the element at the buffer matches the parameter.
+    static bool match(const uint8_t* element, const Key& key);
+
+    /// The next link of the element at the buffer.
+    static Link read_next(const uint8_t* element);
+
+    /// Set the next link of the element at the buffer.
+    static void write_next(uint8_t* element, Link next);
+
+    /// True if the next link of the element at the buffer may be accessed
+    /// with load_next and store_next.
+    static bool atomic_next(const uint8_t* element);
+
+    /// The next link of the element at the buffer (acquire).
+    static Link load_next(const uint8_t* element);
+
+    /// Publish the next link of the element at the buffer (release).
+    static void store_next(uint8_t* element, Link next);
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#include <bitcoin/database/impl/element_traits.ipp>
+
+#endif
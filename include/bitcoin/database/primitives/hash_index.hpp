@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_HASH_INDEX_HPP
+#define LIBBITCOIN_DATABASE_HASH_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/primitives/list_element.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/**
+ * An open addressing hash table with the interface of hash_table.
+ * Alternative to hash_table where chain walks (a page fault per hop on a
+ * cold map) dominate lookup cost. Elements remain list_elements in the
+ * manager, but are not linked (next is unused).
+ *
+ * Each bucket is a cache line of slots, each holding a 16 bit fingerprint
+ * of the key and the element link. A lookup probes buckets linearly from
+ * the key's remainder until an empty slot, reading the element (key) only
+ * for matching fingerprints. Removed slots are retained with a zero
+ * fingerprint so that probes continue past them. Links are stored as in
+ * hash_table_header (complemented), so that empty slots are zero.
+ *
+ *  [ size:Index    ]
+ *  [ version:Index ]
+ *  [ padding       ] (to the bucket size)
+ *  [ [ fingerprint:uint16_t ] * slots, [ link:Link ] * slots, padding ]
+ *  [ [               ...                                            ] ]
+ *  [ [ fingerprint:uint16_t ] * slots, [ link:Link ] * slots, padding ]
+ *
+ * The index cannot grow, so its buckets must be sized for the table.
+ * Link throws std::runtime_error if the index is full.
+ */
+template <typename Manager, typename Index, typename Link, typename Key>
+class hash_index
+{
+public:
+    typedef list_element<Manager, Link, Key> value_type;
+    typedef list_element<const Manager, Link, Key> const_value_type;
+
+    /// The bucket byte size (a common cache line size).
+    static const size_t bucket_size = 64;
+
+    /// The number of slots in a bucket.
+    static const size_t slots = bucket_size /
+        (sizeof(uint16_t) + sizeof(Link));
+
+    /// Empty slot (and not found element) sentinel.
+    static const Link not_found;
+
+    /// The hash index byte size for a given bucket count.
+    static size_t size(Index buckets);
+
+    /// Construct a hash index for variable size entries.
+    hash_index(storage& file, Index buckets);
+
+    /// Construct a hash index for fixed size entries.
+    hash_index(storage& file, Index buckets, size_t value_size);
+
+    /// Create hash index in the file (left in started state).
+    bool create();
+
+    /// Verify the size and version of the hash index in the file.
+    bool start();
+
+    /// Verify the size and version of the hash index in the file, truncating
+    /// elements beyond the end of the file (after an unclean shutdown).
+    bool recover();
+
+    /// Clear the slots and relink every element (after recover).
+    /// Throws std::runtime_error if the index is full.
+    void rebuild();
+
+    /// True if the link is within the elements of the index.
+    bool contains(Link link) const;
+
+    /// Commit table size to the file.
+    void commit();
+
+    /// Use to allocate an element in the hash index.
+    value_type allocator();
+
+    /// Allocate contiguous storage for multiple elements (manager units).
+    /// Create elements within the range using allocator().create(link, ...).
+    Link allocate(size_t size);
+
+    /// Find the last element added with the given key.
+    const_value_type find(const Key& key) const;
+
+    /// Get the element with the given link from the hash index.
+    const_value_type find(Link link) const;
+
+    /// A not found instance for this table, same as find(not_found).
+    const_value_type terminator() const;
+
+    /// Add the given element to the hash index.
+    void link(value_type& element);
+
+    /// Add the given elements to the hash index in one critical section.
+    void link(std::vector<value_type>& elements);
+
+    /// Remove the last element added with the given key.
+    bool unlink(const Key& key);
+
+    /// Count lookups (buckets probed) and allocations into the metrics.
+    void enable_metrics(table_metrics& metrics);
+
+private:
+    typedef uint16_t fingerprint_type;
+    typedef uint32_t slot_mask;
+
+    static_assert(slots <= sizeof(slot_mask) * 8, "slot mask too narrow");
+
+    // The zero fingerprint marks a removed slot.
+    static const fingerprint_type removed = 0;
+
+    // Verify the size and version of the hash index in the file.
+    bool verify() const;
+
+    // The slot and link of the last element added with the key.
+    // Returns max_size_t (and link is unchanged) if there is no such element.
+    // Probes is incremented for each bucket read.
+    size_t search(const Key& key, Link& link, size_t& probes) const;
+
+    // The first empty slot probed from the key's bucket (caller must lock).
+    // Returns max_size_t if the index is full.
+    size_t vacancy(const Key& key) const;
+
+    // Read the fingerprints and links of a bucket (caller must lock).
+    void read(Index bucket, fingerprint_type fingerprints[],
+        Link links[]) const;
+
+    // Write the fingerprint and link of a slot (caller must lock).
+    void write(size_t slot, fingerprint_type fingerprint, Link link);
+
+    Index next(Index bucket) const;
+
+    // Bitmasks (bit per slot) of a bucket, branch free so as to vectorize.
+    static slot_mask matches(const fingerprint_type fingerprints[],
+        fingerprint_type fingerprint);
+    static slot_mask empties(const Link links[]);
+
+    static file_offset bucket_offset(Index bucket);
+    static file_offset fingerprint_offset(size_t slot);
+    static file_offset link_offset(size_t slot);
+
+    storage& file_;
+    const Index buckets_;
+    Manager manager_;
+    mutable shared_mutex index_mutex_;
+    mutable shared_mutex list_mutex_;
+    table_metrics* metrics_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#include <bitcoin/database/impl/hash_index.ipp>
+
+#endif
@@ -19,15 +19,22 @@
 #ifndef LIBBITCOIN_DATABASE_HASH_TABLE_HPP
 #define LIBBITCOIN_DATABASE_HASH_TABLE_HPP
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
 #include <bitcoin/database/primitives/hash_table_header.hpp>
 #include <bitcoin/database/primitives/list_element.hpp>
 #include <bitcoin/database/primitives/slab_manager.hpp>
 #include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/table_metrics.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -53,6 +60,17 @@ namespace database {
  *   [ record:data ]
  *
  * The payload is prefixed with [ size:Link ].
+ *
+ * If growth is enabled the bucket count grows by linear hashing: when the
+ * load factor is exceeded a writer splits the next bucket of the level into
+ * itself and one new bucket. Rows of new buckets are stored in segments
+ * allocated from the manager, each doubling the size of the table. A split
+ * excludes lookups of the table only for the relinking of one chain. If
+ * growth is not enabled lookups and writes take no table lock.
+ *
+ * Bucket rows are locked by stripe (bucket index modulo the stripe count),
+ * so writers of buckets in distinct stripes do not exclude each other. The
+ * element count is updated without a lock and written to the file by commit.
  */
 template <typename Manager, typename Index, typename Link, typename Key>
 class hash_table
@@ -60,6 +78,8 @@ class hash_table
 public:
     typedef list_element<Manager, Link, Key> value_type;
     typedef list_element<const Manager, Link, Key> const_value_type;
+    typedef std::function<void(const Key& key)> key_handler;
+    typedef std::function<void(Link link)> link_handler;
 
     /// Construct a hash table for variable size entries.
     static const Link not_found;
@@ -76,36 +96,121 @@ public:
     /// Verify the size of the hash table in the file.
     bool start();
 
-    /// Commit table size to the file.
+    /// Verify the size of the hash table in the file, truncating elements
+    /// beyond the end of the file (after an unclean shutdown).
+    bool recover();
+
+    /// Cut each chain at its first link outside of the elements or at a
+    /// cycle, and recount the elements (after recover). Sets the number of
+    /// chains cut, returns false if bucket rows are outside of the elements.
+    bool repair(size_t& out_cut);
+
+    /// Commit table size and element count to the file.
     void commit();
 
     /// Use to allocate an element in the hash table. 
     value_type allocator();
 
+    /// Allocate contiguous storage for multiple elements (manager units).
+    /// Create elements within the range using allocator().create(link, ...).
+    Link allocate(size_t size);
+
     /// Find an element with the given key in the hash table.
     const_value_type find(const Key& key) const;
 
     /// Get the element with the given link from the hash table.
     const_value_type find(Link link) const;
 
+    /// True if the link is within the elements of the table.
+    bool contains(Link link) const;
+
+    /// The bucket of the key, for ordering lookups of many keys.
+    Index bucket(const Key& key) const;
+
+    /// Advise that the bucket row of the key will soon be read.
+    void prefetch(const Key& key) const;
+
+    /// Advise that the elements of the links will soon be read (batched).
+    void prefetch(const std::vector<Link>& links, size_t size) const;
+
+    /// Advise a sequential read of a range of elements from the link, for the
+    /// lifetime of the guard (size is in bytes).
+    scan_guard::ptr scan(Link link, size_t size) const;
+
     /// A not found instance for this table, same as find(not_found).
     const_value_type terminator() const;
 
     /// Add the given element to the hash table.
     void link(value_type& element);
 
+    /// Add the given elements to the hash table with one count update.
+    void link(std::vector<value_type>& elements);
+
     /// Remove an element with the given key from the hash table.
     bool unlink(const Key& key);
 
+    /// Split buckets while elements exceed this percentage of buckets.
+    /// Zero (the default) disables growth. Call before use.
+    void enable_growth(size_t load_percent);
+
+    /// Count lookups and allocations into the metrics (set before use).
+    void enable_metrics(table_metrics& metrics);
+
+    /// The number of buckets, including those added by growth.
+    size_t buckets() const;
+
+    /// The byte size of the header (with initial bucket rows) in the file.
+    size_t header_size() const;
+
+    /// The average number of elements per bucket.
+    float load_factor() const;
+
+    /// The number of elements in the table.
+    uint64_t count() const;
+
+    /// Call the handler with the key of each element (walks every bucket).
+    void walk(key_handler handler) const;
+
+    /// Call the handler with the link of each element of the buckets
+    /// [first, last), so that a walk may be partitioned (see buckets).
+    void walk(size_t first, size_t last, link_handler handler) const;
+
 private:
     Link bucket_value(Index index) const;
     Link bucket_value(const Key& key) const;
     Index bucket_index(const Key& key) const;
+    void set_bucket_value(Index index, Link value);
+
+    // The mutexes of the stripe of the bucket.
+    shared_mutex& root_mutex(Index index) const;
+    shared_mutex& row_mutex(Index index) const;
+
+    // Locate the row of a bucket beyond the header (segment and offset).
+    std::pair<size_t, size_t> segment_row(Index index) const;
+
+    // A shared lock of splits, not acquired unless growth is enabled.
+    shared_lock split_lock() const;
+
+    // Allocate the rows of the next level, if not yet allocated.
+    void reserve_segment();
+
+    // Split the next bucket of the level (linear hashing).
+    void split();
+
+    bool overloaded() const;
 
     hash_table_header<Index, Link> header_;
     Manager manager_;
-    mutable shared_mutex root_mutex_;
+    const size_t record_size_;
+    size_t load_percent_;
+    mutable std::array<shared_mutex, hash_table_header<Index, Link>::stripes>
+        root_mutexes_;
+    mutable std::array<shared_mutex, hash_table_header<Index, Link>::stripes>
+        row_mutexes_;
     mutable shared_mutex list_mutex_;
+    mutable shared_mutex split_mutex_;
+    mutable shared_mutex segment_mutex_;
+    table_metrics* metrics_;
 };
 
 } // namespace database
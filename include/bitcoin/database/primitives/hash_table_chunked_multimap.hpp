@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_HASH_TABLE_CHUNKED_MULTIMAP_HPP
+#define LIBBITCOIN_DATABASE_HASH_TABLE_CHUNKED_MULTIMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/primitives/chunk_element.hpp>
+#include <bitcoin/database/primitives/hash_table.hpp>
+#include <bitcoin/database/primitives/record_manager.hpp>
+#include <bitcoin/database/primitives/slab_manager.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/**
+ * A hash table where each key maps to a set of fixed size values.
+ *
+ * As hash_table_multimap, except that the values of a key are stored in
+ * chunks of rows (an unrolled list) on a slab file. The chunks of a key
+ * double in capacity up to a maximum, so that keys with few values remain
+ * small and keys with many values are read sequentially and linked rarely.
+ */
+template <typename Index, typename Link, typename Key>
+class hash_table_chunked_multimap
+{
+public:
+    typedef file_offset link_type;
+    typedef slab_manager<link_type> manager;
+    typedef chunk_element<const manager, link_type> const_value_type;
+    typedef hash_table<record_manager<Link>, Index, Link, Key> table;
+    typedef std::function<void(byte_serializer& serial, size_t index)>
+        write_function;
+
+    /// The most rows in one chunk.
+    static const size_t maximum_capacity;
+
+    /// Construct a new chunked multimap of values of the given size.
+    /// THIS ASSUMES MAP HAS VALUE SIZE == sizeof(link_type).
+    hash_table_chunked_multimap(table& map, manager& manager,
+        size_t value_size);
+
+    /// Find an iterator for the given multimap key (newest value first).
+    const_value_type find(const Key& key) const;
+
+    /// Get the iterator for the given row position (to resume iteration).
+    const_value_type element(uint64_t position) const;
+
+    /// Add count values to the key, written oldest first by index.
+    void link(const Key& key, size_t count, write_function write);
+
+    /// Remove the newest value of the given key.
+    bool unlink(const Key& key);
+
+private:
+    link_type read_root(const typename table::const_value_type& root) const;
+    void write_rows(const memory_ptr& memory, size_t first, size_t count,
+        size_t offset, write_function write) const;
+
+    table& map_;
+    manager& manager_;
+    const size_t value_size_;
+    mutable shared_mutex root_mutex_;
+    mutable shared_mutex list_mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#include <bitcoin/database/impl/hash_table_chunked_multimap.ipp>
+
+#endif
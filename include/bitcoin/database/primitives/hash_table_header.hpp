@@ -19,17 +19,32 @@
 #ifndef LIBBITCOIN_DATABASE_HASH_TABLE_HEADER_HPP
 #define LIBBITCOIN_DATABASE_HASH_TABLE_HEADER_HPP
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
 #include <bitcoin/database/memory/storage.hpp>
 
 namespace libbitcoin {
 namespace database {
 
 /// Size-prefixed array.
-/// Empty elements are represented by the value hash_table_header.empty.
+/// Empty elements are represented by the value hash_table_header.empty,
+/// which is stored as zero (rows are complemented), so that the rows of a
+/// new file are empty without being written.
+/// The version identifies the key hash function used to select buckets.
+/// The growth state supports linear hashing (see hash_table), where buckets
+/// beyond the size are stored in segments allocated by the table.
 ///
-///  [  size:Index  ]
+///  [  size:Index    ]
+///  [  version:Index ]
+///  [  level:Index   ] (completed doublings of size)
+///  [  split:Index   ] (next bucket to split)
+///  [  count:uint64  ] (element count)
+///  [ [ segment:Link ] ] * segments
 ///  [ [ row:Link ] ]
 ///  [ [      ...     ] ]
 ///  [ [ row:Link ] ]
@@ -43,19 +58,40 @@ public:
     template <typename Key>
     static Index remainder(const Key& key, Index divisor);
 
+    /// A short hash of the key, independent of its remainder (never zero).
+    /// It shares bits with the levels of a grown table (see bucket).
+    template <typename Key>
+    static uint16_t fingerprint(const Key& key);
+
     // Empty cell (null pointer) sentinel.
     static const Link empty;
 
+    // Format version of the bucket selection (remainder) function.
+    static const Index version;
+
+    /// The maximum number of growth segments (doublings of size).
+    static const size_t segments = 32;
+
+    /// The number of locks over which rows are striped.
+    static const size_t stripes = 64;
+
+    /// The stripe of the row of the given bucket.
+    static size_t stripe(Index index);
+
     /// The hash table header byte size for a given bucket count.
     static size_t size(Index buckets);
 
+    /// The stored form of a row link, and its inverse (the complement, so
+    /// that empty is stored as zero).
+    static Link encode(Link value);
+
     /// Construct a hash table header.
     hash_table_header(storage& file, Index buckets);
 
-    /// Allocate the hash table and populate with empty values.
+    /// Allocate the hash table, zero filled (sparse) for empty values.
     bool create();
 
-    /// Should be called before use. Validates the size from the file.
+    /// Should be called before use. Validates the size and version.
     bool start();
 
     /// Read item value.
@@ -64,19 +100,83 @@ public:
     /// Write value to item.
     void write(Index index, Link value);
 
+    /// Advise that the item will soon be read.
+    void prefetch(Index index) const;
+
+    /// Advise a sequential read of all rows, for the lifetime of the guard.
+    scan_guard::ptr scan() const;
+
     /// The hash table header bucket count.
     Index buckets() const;
 
+    /// The bucket of the key given the growth state (linear hashing).
+    /// Buckets below level doublings of size, plus split, are addressable.
+    /// The growth state is consistent only if splits are excluded.
+    template <typename Key>
+    Index bucket(const Key& key) const;
+
+    /// The number of completed doublings of the bucket count.
+    Index level() const;
+
+    /// The number of buckets split in the current level.
+    Index split() const;
+
+    /// Persist the growth state.
+    void set_growth(Index level, Index split);
+
+    /// The number of elements in the table.
+    uint64_t count() const;
+
+    /// Increase the number of elements in the table (persisted by commit).
+    void increase_count(uint64_t value);
+
+    /// Decrease the number of elements in the table (persisted by commit).
+    void decrease_count(uint64_t value);
+
+    /// Persist the number of elements in the table.
+    void commit();
+
+    /// The link of the rows of the given segment (starting at one).
+    Link segment(size_t index) const;
+
+    /// Persist the link of the rows of the given segment.
+    void set_segment(size_t index, Link value);
+
     /// The hash table header byte size.
     size_t size();
 
 private:
+    // A stable hash of a byte array key, read directly from its bytes.
+    template <size_t Size>
+    static uint64_t hash(const byte_array<Size>& key);
+
+    // Other key types fall back to the (toolchain-specific) std::hash.
+    template <typename Key>
+    static uint64_t hash(const Key& key);
+
     // Position in the memory map relative the header end.
     static file_offset link(Index index);
 
+    // Positions of the growth state in the memory map.
+    static file_offset growth_position();
+    static file_offset segment_position(size_t index);
+
+    void write_growth();
+
     storage& file_;
     Index buckets_;
+
+    // Growth state is written only while splits are excluded, so readers
+    // that exclude splits see it consistent. The count is updated without
+    // a lock and persisted at commit. Writes of the file are serialized.
+    std::atomic<Index> level_;
+    std::atomic<Index> split_;
+    std::atomic<uint64_t> count_;
+    std::array<std::atomic<Link>, segments> segments_;
     mutable shared_mutex mutex_;
+
+    // Rows are protected by the mutex of their stripe.
+    mutable std::array<shared_mutex, stripes> row_mutexes_;
 };
 
 } // namespace database
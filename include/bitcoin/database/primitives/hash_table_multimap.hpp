@@ -64,10 +64,16 @@ public:
     /// Get the iterator for the given link from a multimap.
     const_value_type find(Link link) const;
 
+    /// Get the iterator for the given list element (to resume iteration).
+    const_value_type element(Link link) const;
+
     /// Add the given element to a multimap.
     /// Multimap elements have empty internal key values.
     void link(const Key& key, value_type& element);
 
+    /// Add the given chain of elements (first linked through to last).
+    void link(const Key& key, value_type& first, value_type& last);
+
     /// Remove a multimap element with the given key.
     bool unlink(const Key& key);
 
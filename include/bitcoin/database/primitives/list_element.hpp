@@ -25,6 +25,8 @@
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/memory_handle.hpp>
+#include <bitcoin/database/primitives/element_traits.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -37,6 +39,7 @@ class list_element
 public:
     typedef byte_serializer::functor write_function;
     typedef byte_deserializer::functor read_function;
+    typedef element_traits<Link, Key> traits;
     static const auto not_found = (Link)bc::max_uint64;
 
     /// The stored size of a value with the given size.
@@ -57,6 +60,9 @@ public:
     /// Allocate and populate a new keyed slab element.
     Link create(const Key& key, write_function write, size_t value_size);
 
+    /// Populate a new keyed element at a link allocated by the caller.
+    Link create(Link link, const Key& key, write_function write);
+
     /// Update this element to the next element (read next from file).
     bool jump_next();
 
@@ -67,10 +73,36 @@ public:
     void set_next(Link next) const;
 
     /// Write to the state of the element (write to file).
-    void write(write_function writer) const;
+    /// Writer is any callable of byte_serializer&, inlined (not type erased).
+    template <typename Writer>
+    void write(Writer writer) const;
+
+    /// Write a fixed-width integer at the offset into the element state.
+    template <typename Integer>
+    void write_little_endian(size_t offset, Integer value) const;
+
+    /// Journal a range of the state written in place (see write).
+    void journal(size_t offset, size_t size) const;
+
+    /// Zero and release a range of the state (journaled).
+    void release(size_t offset, size_t size) const;
 
     /// Read from the state of the element.
-    void read(read_function reader) const;
+    /// Reader is any callable of byte_deserializer&, inlined (not type erased).
+    template <typename Reader>
+    void read(Reader reader) const;
+
+    /// Read a fixed-width integer at the offset into the element state.
+    template <typename Integer>
+    Integer read_little_endian(size_t offset) const;
+
+    /// Read the element state as a fixed-layout (unaligned) record type.
+    /// Reader is any callable of const Record&.
+    template <typename Record, typename Reader>
+    void read_record(Reader reader) const;
+
+    /// The memory of the state of the element, pinned while referenced.
+    memory_ptr state() const;
 
     /// True if the element key (read from file) matches the parameter.
     bool match(const Key& key) const;
@@ -87,6 +119,9 @@ public:
     /// A list terminator for this instance.
     list_element terminator() const;
 
+    /// An instance for the element at the link (of the same list).
+    list_element at(Link link) const;
+
     /// The element is terminal (not found, cannot be read).
     bool terminal() const;
 
@@ -98,7 +133,7 @@ public:
     bool operator!=(list_element other) const;
 
 private:
-    memory_ptr data(size_t bytes) const;
+    memory_handle data(size_t bytes) const;
     void initialize(const Key& key, write_function write);
 
     Link link_;
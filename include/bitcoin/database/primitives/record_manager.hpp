@@ -19,11 +19,14 @@
 #ifndef LIBBITCOIN_DATABASE_RECORD_MANAGER_HPP
 #define LIBBITCOIN_DATABASE_RECORD_MANAGER_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
 #include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/table_metrics.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -32,6 +35,8 @@ namespace database {
 /// data referenced by an index. The file will be resized accordingly
 /// and the total number of records updated so new chunks can be allocated.
 /// It also provides logical record mapping to the record memory address.
+/// Records within the mapped file are allocated by atomic increment, the file
+/// is locked only to grow it and on commit.
 template <typename Link>
 class record_manager
   : noncopyable
@@ -49,6 +54,10 @@ public:
     /// Prepare manager for usage.
     bool start();
 
+    /// Prepare manager for usage after an unclean shutdown, truncating a
+    /// count of records beyond the end of the file.
+    bool recover();
+
     /// Commit record count to the file.
     void commit();
 
@@ -58,12 +67,34 @@ public:
     /// Change the number of records of this container (truncation).
     void set_count(Link value);
 
+    /// True if the record index is within the count.
+    bool contains(Link link) const;
+
     /// Allocate records and return first logical index, commit after writing.
     Link allocate(size_t count);
 
     /// Return memory object for the record at the specified index.
     memory_ptr get(Link link) const;
 
+    /// Return allocation-free scoped access to the record at the index.
+    memory_handle pin(Link link) const;
+
+    /// Journal a range written in place, relative to the indexed record.
+    void journal(Link link, size_t offset, size_t size) const;
+
+    /// Zero and release a range, relative to the indexed record.
+    void release(Link link, size_t offset, size_t size) const;
+
+    /// Advise that the records starting at the index will soon be read.
+    void prefetch(Link link, size_t size) const;
+
+    /// Count allocations into the metrics.
+    void enable_metrics(table_metrics& metrics);
+
+    /// Advise a sequential read of the records from the index, for the
+    /// lifetime of the guard.
+    scan_guard::ptr scan(Link link, size_t size) const;
+
 private:
     // The record index of a disk position.
     Link position_to_link(file_offset position) const;
@@ -77,14 +108,24 @@ private:
     // Write the count of the records from the file.
     void write_count();
 
+    // Extend the logical file size over records allocated without the lock.
+    void reserve_allocated();
+
     // This class is thread and remap safe.
     storage& file_;
     const size_t header_size_;
     const size_t record_size_;
 
-    // Record count is protected by mutex.
-    Link record_count_;
+    // Record count is allocated by increment within the mapped capacity.
+    std::atomic<Link> record_count_;
+    std::atomic<size_t> capacity_;
+
+    // The logical file size reserved is protected by mutex, as is growth.
+    size_t reserved_;
     mutable shared_mutex mutex_;
+
+    // Optional counters, set before use.
+    table_metrics* metrics_;
 };
 
 } // namespace database
@@ -19,11 +19,16 @@
 #ifndef LIBBITCOIN_DATABASE_SLAB_MANAGER_HPP
 #define LIBBITCOIN_DATABASE_SLAB_MANAGER_HPP
 
+#include <atomic>
 #include <cstddef>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/prefetcher.hpp>
+#include <bitcoin/database/memory/scan_guard.hpp>
 #include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/table_metrics.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -31,6 +36,8 @@ namespace database {
 /// The slab manager represents a growing collection of various sized
 /// slabs of data on disk. It will resize the file accordingly and keep
 /// track of the current end pointer so new slabs can be allocated.
+/// Slabs within the mapped file are allocated by atomic increment, the file
+/// is locked only to grow it and on commit.
 template <typename Link>
 class slab_manager
   : noncopyable
@@ -48,18 +55,47 @@ public:
     /// Prepare manager for use.
     bool start();
 
+    /// Prepare manager for use after an unclean shutdown, truncating a
+    /// payload size beyond the end of the file.
+    bool recover();
+
     /// Commit total slabs size to the file.
     void commit();
 
     /// Get the size of all slabs and size prefix (excludes header).
     size_t payload_size() const;
 
+    /// True if the slab position is within the payload.
+    bool contains(Link position) const;
+
     /// Allocate a slab and return its position, commit after writing.
     Link allocate(size_t size);
 
     /// Return memory object for the slab at the specified position.
     memory_ptr get(Link position) const;
 
+    /// Return allocation-free scoped access to the slab at the position.
+    memory_handle pin(Link position) const;
+
+    /// Journal a range written in place, relative to the positioned slab.
+    void journal(Link position, size_t offset, size_t size) const;
+
+    /// Zero and release a range, relative to the positioned slab.
+    void release(Link position, size_t offset, size_t size) const;
+
+    /// Advise that the slab at the position will soon be read.
+    void prefetch(Link position, size_t size) const;
+
+    /// Advise that the slabs at the positions will soon be read (batched).
+    void prefetch(const std::vector<Link>& positions, size_t size) const;
+
+    /// Count allocations into the metrics.
+    void enable_metrics(table_metrics& metrics);
+
+    /// Advise a sequential read of the slabs from the position, for the
+    /// lifetime of the guard.
+    scan_guard::ptr scan(Link position, size_t size) const;
+
 private:
     // Read the size of the data from the file.
     void read_size();
@@ -67,13 +103,23 @@ private:
     // Write the size of the data from the file.
     void write_size() const;
 
+    // Extend the logical file size over slabs allocated without the lock.
+    void reserve_allocated();
+
     // This class is thread and remap safe.
     storage& file_;
     const size_t header_size_;
 
-    // Payload size is protected by mutex.
-    size_t payload_size_;
+    // Payload size is allocated by increment within the mapped capacity.
+    std::atomic<size_t> payload_size_;
+    std::atomic<size_t> capacity_;
+
+    // The logical file size reserved is protected by mutex, as is growth.
+    size_t reserved_;
     mutable shared_mutex mutex_;
+
+    // Optional counters, set before use.
+    table_metrics* metrics_;
 };
 
 } // namespace database
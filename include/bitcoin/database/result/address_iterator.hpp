@@ -22,8 +22,8 @@
 #include <cstddef>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
-#include <bitcoin/database/primitives/list_element.hpp>
-#include <bitcoin/database/primitives/record_manager.hpp>
+#include <bitcoin/database/primitives/chunk_element.hpp>
+#include <bitcoin/database/primitives/slab_manager.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -33,8 +33,8 @@ class BCD_API address_iterator
 public:
     // Definition for underlying type (avoids circular reference).
     //-------------------------------------------------------------------------
-    typedef list_element<const record_manager<array_index>, array_index,
-        empty_key> const_element;
+    typedef chunk_element<const slab_manager<file_offset>, file_offset>
+        const_element;
 
     // std::iterator_traits
     //-------------------------------------------------------------------------
@@ -50,7 +50,10 @@ public:
     // Constructors.
     //-------------------------------------------------------------------------
 
-    address_iterator(const const_element& element);
+    /// Iterate from the element, stopping after limit payments or at the
+    /// first payment indexed below from_height.
+    address_iterator(const const_element& element, size_t from_height=0,
+        size_t limit=max_size_t);
 
     // Operators.
     //-------------------------------------------------------------------------
@@ -62,11 +65,18 @@ public:
     bool operator==(const address_iterator& other) const;
     bool operator!=(const address_iterator& other) const;
 
+    /// The position of the current row, max_uint64 if none remain above the
+    /// height. Once the limit is reached this is the cursor of the next page.
+    uint64_t link() const;
+
 private:
+    bool exhausted() const;
     void populate();
 
     const_element element_;
     value_type payment_;
+    size_t from_height_;
+    size_t remaining_;
 };
 
 } // namespace database
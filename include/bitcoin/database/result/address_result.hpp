@@ -22,8 +22,8 @@
 #include <cstddef>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
-#include <bitcoin/database/primitives/list_element.hpp>
-#include <bitcoin/database/primitives/record_manager.hpp>
+#include <bitcoin/database/primitives/chunk_element.hpp>
+#include <bitcoin/database/primitives/slab_manager.hpp>
 #include <bitcoin/database/result/address_iterator.hpp>
 
 namespace libbitcoin {
@@ -33,12 +33,12 @@ namespace database {
 class BCD_API address_result
 {
 public:
-    typedef empty_key key_type;
-    typedef array_index link_type;
-    typedef record_manager<link_type> manager;
-    typedef list_element<const manager, link_type, key_type> const_value_type;
+    typedef file_offset link_type;
+    typedef slab_manager<link_type> manager;
+    typedef chunk_element<const manager, link_type> const_value_type;
 
-    address_result(const const_value_type& element, const short_hash& hash);
+    address_result(const const_value_type& element, const short_hash& hash,
+        size_t from_height=0, size_t limit=max_size_t);
 
     /// True if the requested block exists.
     operator bool() const;
@@ -46,12 +46,14 @@ public:
     /// The address hash of the query.
     const short_hash& hash() const;
 
-    /// Iterate over the address metadata set.
+    /// Iterate over the address metadata set, newest first, within bounds.
     address_iterator begin() const;
     address_iterator end() const;
 
 private:
     short_hash hash_;
+    size_t from_height_;
+    size_t limit_;
 
     // This class is thread safe.
     const_value_type element_;
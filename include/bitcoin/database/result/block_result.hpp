@@ -21,8 +21,10 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/sequence_lock.hpp>
 #include <bitcoin/database/primitives/list_element.hpp>
 #include <bitcoin/database/primitives/record_manager.hpp>
 #include <bitcoin/database/result/transaction_iterator.hpp>
@@ -41,9 +43,10 @@ public:
     typedef record_manager<link_type> manager;
     typedef list_element<const manager, link_type, key_type>
         const_element_type;
+    typedef std::vector<block_result> list;
 
     block_result(const const_element_type& element,
-        shared_mutex& metadata_mutex, const manager& index_manager);
+        const sequence_lock& metadata_lock, const manager& index_manager);
 
     /// True if the requested block exists.
     operator bool() const;
@@ -101,8 +104,8 @@ private:
     const const_element_type element_;
     const manager& index_manager_;
 
-    // Metadata values are kept consistent by mutex.
-    shared_mutex& metadata_mutex_;
+    // Metadata values are kept consistent by sequence lock.
+    const sequence_lock& metadata_lock_;
 };
 
 } // namespace database
@@ -63,9 +63,17 @@ public:
     bool operator==(const inpoint_iterator& other) const;
     bool operator!=(const inpoint_iterator& other) const;
 
+    // Properties.
+    //-------------------------------------------------------------------------
+
+    /// The link of the previous tx of the current point, not_found if the
+    /// point is not linked (resolve by hash).
+    file_offset parent() const;
+
 private:
     size_t index_;
     std::vector<value_type> inpoints_;
+    std::vector<file_offset> parents_;
 };
 
 } // namespace database
@@ -23,9 +23,12 @@
 #include <cstdint>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/sequence_lock.hpp>
 #include <bitcoin/database/primitives/list_element.hpp>
 #include <bitcoin/database/primitives/slab_manager.hpp>
 #include <bitcoin/database/result/inpoint_iterator.hpp>
+#include <bitcoin/database/result/transaction_view.hpp>
+#include <bitcoin/database/state_table.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -46,6 +49,27 @@ public:
     /// This is the store value for candidate false.
     static const uint8_t candidate_false;
 
+    /// This store flag is combined with candidate if outputs are indexed.
+    static const uint8_t outputs_indexed;
+
+    /// This store flag is combined with candidate if outputs are compact.
+    static const uint8_t outputs_compact;
+
+    /// This store flag is combined with candidate if input points are linked.
+    static const uint8_t inputs_linked;
+
+    /// This store flag is combined with candidate if the mutable state of the
+    /// transaction and its outputs is in the state table.
+    static const uint8_t state_split;
+
+    /// This store flag is combined with candidate if the outputs and inputs
+    /// of the transaction are pruned (metadata remains, as a tombstone).
+    static const uint8_t payload_pruned;
+
+    /// This store flag is combined with candidate if the record is followed
+    /// by its crc32c checksum (requires state_split, cleared by prune).
+    static const uint8_t payload_checked;
+
     /// This is unconfirmed tx height (forks) sentinel.
     static const uint32_t unverified;
 
@@ -53,7 +77,13 @@ public:
     static const uint16_t unconfirmed;
 
     transaction_result(const const_element_type& element,
-        shared_mutex& metadata_mutex);
+        const sequence_lock& metadata_lock, const state_table& state);
+
+    /// If not metadata only the stored transaction is read (as for block
+    /// composition), the metadata is defaulted and the lock is not taken.
+    transaction_result(const const_element_type& element,
+        const sequence_lock& metadata_lock, const state_table& state,
+        bool metadata);
 
     /// True if this transaction result is valid (found).
     operator bool() const;
@@ -76,30 +106,86 @@ public:
     /// The median time past of the block which includes the transaction.
     uint32_t median_time_past() const;
 
+    /// The transaction is a tombstone, read as without outputs or inputs.
+    bool pruned() const;
+
     /// All tx outputs confirmed below fork, or candidate as applicable.
     bool is_spent(size_t fork_height, bool candidate) const;
 
+    /// The output at the index is confirmed spent below fork, or candidate
+    /// spent as applicable, reading only its spend metadata. An index out of
+    /// range (as of a pruned tx) reads as spent.
+    bool is_spent(uint32_t index, size_t fork_height, bool candidate) const;
+
     /// The output at the specified index within this transaction.
     chain::output output(uint32_t index) const;
 
     /// The transaction, optionally including witness.
     chain::transaction transaction(bool witness=true) const;
 
+    /// A view of the stored transaction, without deserialization.
+    transaction_view view() const;
+
+    /// True unless the record is checked and its checksum does not match
+    /// (reads the entire record).
+    bool verify() const;
+
     /// Iterate over the input set.
     inpoint_iterator begin() const;
     inpoint_iterator end() const;
 
+    /// Advance a deserializer from the start of a record to its transaction.
+    /// Returns the format flags of the record (all state but candidate).
+    static uint8_t skip_metadata(byte_deserializer& deserial);
+
+    /// Read the state table ordinals of the record and of its first output,
+    /// from the start of the record. False if the state is not split.
+    static bool read_split(byte_deserializer& deserial,
+        file_offset& out_transaction, file_offset& out_outputs);
+
+    /// Advance a deserializer from the start of a record to the output at
+    /// index, or to the end of the outputs if not less than the output count.
+    /// Returns the output count and sets the record offset of the position.
+    static size_t seek_output(byte_deserializer& deserial, uint32_t index,
+        size_t& offset);
+
+    /// As above, also setting the format flags of the record.
+    static size_t seek_output(byte_deserializer& deserial, uint32_t index,
+        size_t& offset, uint8_t& flags);
+
+    /// Read a stored input point, returning the link of its previous tx.
+    /// A linked point's hash is not stored (left null) unless the link is
+    /// not_found, so the caller resolves the hash as the key of the link.
+    static file_offset read_point(byte_deserializer& deserial,
+        chain::output_point& point, bool linked);
+
+    /// Skip a stored input point, returning its stored size.
+    static size_t skip_point(byte_deserializer& deserial, bool linked);
+
 private:
+    bool read_spent(byte_deserializer& deserial, size_t index,
+        size_t fork_height, bool candidate) const;
+    data_chunk read_output(byte_deserializer& deserial, bool compact,
+        size_t index) const;
+    data_chunk expand(byte_deserializer& deserial, uint8_t flags) const;
+
     bool candidate_;
+    bool pruned_;
     uint32_t height_;
     uint16_t position_;
     uint32_t median_time_past_;
 
+    // The state table ordinal of the first output, if split.
+    file_offset outputs_;
+
     // This class is thread safe.
     const const_element_type element_;
 
-    // Metadata values are kept consistent by mutex.
-    shared_mutex& metadata_mutex_;
+    // Metadata values are kept consistent by sequence lock.
+    const sequence_lock& metadata_lock_;
+
+    // This class is thread safe.
+    const state_table& state_;
 };
 
 } // namespace database
@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_TRANSACTION_VIEW_HPP
+#define LIBBITCOIN_DATABASE_TRANSACTION_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/primitives/list_element.hpp>
+#include <bitcoin/database/primitives/slab_manager.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// Read view of a stored transaction, scripts are slices of the memory map.
+/// The view pins the map (delaying any remap), so it should be short-lived.
+/// Spender metadata is not guarded and is not exposed (see transaction_result).
+/// Output values and scripts of a compact transaction are decoded into the
+/// view on construction, so its output scripts are slices of the view.
+/// The previous tx hash of a linked input point is read from its link.
+class BCD_API transaction_view
+{
+public:
+    // Definition for constructor type (avoids circular reference).
+    typedef slab_manager<file_offset> manager;
+    typedef list_element<const manager, file_offset, hash_digest> const_element;
+
+    /// Construct a view of the transaction record of the element.
+    transaction_view(const const_element& element);
+
+    /// The stored (not wire) serialization of the transaction.
+    data_slice raw() const;
+
+    /// The stored size of the record, to the end of the transaction.
+    size_t record_size() const;
+
+    /// The transaction version.
+    uint32_t version() const;
+
+    /// The transaction locktime.
+    uint32_t locktime() const;
+
+    /// The number of outputs.
+    size_t outputs() const;
+
+    /// The value of the output at the index.
+    uint64_t value(uint32_t index) const;
+
+    /// The script of the output at the index (without size prefix).
+    data_slice output_script(uint32_t index) const;
+
+    /// The number of inputs.
+    size_t inputs() const;
+
+    /// The previous output of the input at the index.
+    chain::output_point previous_output(uint32_t index) const;
+
+    /// The link of the previous tx of the input at the index, not_found if
+    /// the input point is not linked.
+    file_offset previous_link(uint32_t index) const;
+
+    /// The script of the input at the index (without size prefix).
+    data_slice input_script(uint32_t index) const;
+
+    /// The sequence of the input at the index.
+    uint32_t sequence(uint32_t index) const;
+
+    /// The witness of the input at the index (with count prefix, as wire).
+    data_slice witness(uint32_t index) const;
+
+    /// True if the witness of any input is not empty.
+    bool segregated() const;
+
+    /// Write the wire serialization of the transaction, from slices of the
+    /// record (the transaction is not deserialized).
+    void to_data(writer& sink, bool witness) const;
+
+private:
+    data_slice slice(size_t offset) const;
+    size_t input_end(uint32_t index) const;
+
+    // The memory is pinned for the lifetime of the view.
+    const memory_ptr memory_;
+    const const_element element_;
+    bool linked_;
+
+    // Offsets are from the start of the record.
+    size_t transaction_;
+    size_t size_;
+    uint32_t version_;
+    uint32_t locktime_;
+    std::vector<size_t> outputs_;
+    std::vector<size_t> inputs_;
+
+    // Decoded outputs, populated only if the outputs are compact.
+    std::vector<uint64_t> values_;
+    std::vector<data_chunk> scripts_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_SEQUENCE_LOCK_HPP
+#define LIBBITCOIN_DATABASE_SEQUENCE_LOCK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// A sequence lock (seqlock) over small updatable values. Writers exclude
+/// each other and advance the sequence around the write, readers only load
+/// the sequence and repeat a read that overlaps a write. So readers never
+/// write the lock, and do not contend with each other for its cache line.
+class BCD_API sequence_lock
+  : noncopyable
+{
+public:
+    typedef std::function<void()> reader;
+
+    /// Holds the write lock for the lifetime of the instance.
+    class scope
+      : noncopyable
+    {
+    public:
+        scope(sequence_lock& lock);
+        ~scope();
+
+    private:
+        sequence_lock& lock_;
+    };
+
+    /// Construct with no write in progress.
+    sequence_lock();
+
+    /// Acquire exclusive write access.
+    void lock();
+
+    /// Release exclusive write access.
+    void unlock();
+
+    /// Invoke the reader until it does not overlap a write. The reader may
+    /// observe torn values, which are discarded, so it must only copy them.
+    /// The reader is invoked directly, so it is inlined into the caller.
+    template <typename Reader>
+    void read(const Reader& handler) const;
+
+    /// The total time writers have waited for the lock (nanoseconds).
+    uint64_t wait_ns() const;
+
+private:
+    std::mutex mutex_;
+    std::atomic<size_t> sequence_;
+    std::atomic<uint64_t> wait_ns_;
+};
+
+// The sequence is odd while a write is in progress (see sequence_lock.cpp).
+template <typename Reader>
+void sequence_lock::read(const Reader& handler) const
+{
+    while (true)
+    {
+        const auto sequence = sequence_.load(std::memory_order_acquire);
+
+        // Yield to the writer rather than read values it is changing.
+        if ((sequence & 1) != 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        handler();
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence_.load(std::memory_order_relaxed) == sequence)
+            return;
+    }
+}
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -22,6 +22,11 @@
 #include <cstdint>
 #include <boost/filesystem.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/eviction_policy.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/map_advice.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_directories.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -35,13 +40,53 @@ public:
 
     /// Properties.
     boost::filesystem::path directory;
+    table_directories table_placement;
     bool flush_writes;
+    uint32_t flush_interval_ms;
+    bool journal_writes;
+    bool read_only;
     bool index_addresses;
+    bool index_deferred;
+    bool index_filters;
+    bool index_spends;
     uint16_t file_growth_rate;
+    file_growth file_growth_policy;
+    uint32_t file_reservation_mb;
+    uint16_t table_load_percent;
+    uint32_t store_threads;
     uint32_t block_table_buckets;
+    storage_backend block_table_storage;
+    map_advice block_table_advice;
+    map_advice block_index_advice;
+    uint32_t header_cache_capacity;
     uint32_t transaction_table_buckets;
+    storage_backend transaction_table_storage;
+    map_advice transaction_table_advice;
+    bool transaction_compaction;
+    bool transaction_linked_inputs;
+    bool transaction_split_state;
+    bool transaction_checksums;
+    uint32_t transaction_verify_rate;
+    uint32_t transaction_warm_segments;
+    uint32_t transaction_filter_mb;
+    uint32_t transaction_filter_error_ppm;
+    uint32_t transaction_prune_depth;
+    uint32_t transaction_pool_mb;
+    uint32_t transaction_commit_window_ms;
     uint32_t address_table_buckets;
+    storage_backend address_table_storage;
+    map_advice address_table_advice;
+    uint32_t address_balance_buckets;
+    uint32_t address_filter_range;
+    uint32_t filter_table_buckets;
+    storage_backend filter_table_storage;
+    map_advice filter_table_advice;
+    uint32_t spend_table_buckets;
+    storage_backend spend_table_storage;
+    map_advice spend_table_advice;
     uint32_t cache_capacity;
+    uint32_t cache_budget_mb;
+    eviction_policy cache_eviction;
 };
 
 } // namespace database
@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_STATE_TABLE_HPP
+#define LIBBITCOIN_DATABASE_STATE_TABLE_HPP
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/file_growth.hpp>
+#include <bitcoin/database/map_advice.hpp>
+#include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/primitives/record_manager.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// The mutable state of stored transactions and of their outputs, in fixed
+/// width records by ordinal, so that split records of the transaction table
+/// are written only on store. Records have the layout of the fields that
+/// they replace in the transaction table, so each is read and written alike.
+class BCD_API state_table
+  : noncopyable
+{
+public:
+    typedef boost::filesystem::path path;
+    typedef file_offset link_type;
+
+    /// [ height:4 ][ position:2 ][ candidate:1 ][ median_time_past:4 ]
+    static const size_t transaction_size;
+
+    /// [ candidate_spent:1 ][ spender_height:4 ]
+    static const size_t output_size;
+
+    /// Construct the table.
+    state_table(const path& transactions_filename,
+        const path& outputs_filename, size_t expansion, size_t reservation=0,
+        storage_backend backend=storage_backend::file);
+
+    /// Close the table.
+    ~state_table();
+
+    // Startup and shutdown.
+    // ------------------------------------------------------------------------
+
+    /// Initialize a new table.
+    bool create();
+
+    /// Call before using the table.
+    bool open();
+
+    /// Follow the writes of another process (read only).
+    bool refresh();
+
+    /// Commit latest allocations.
+    void commit();
+
+    /// Flush the memory maps to disk.
+    bool flush() const;
+
+    /// Schedule asynchronous writeback of newly-allocated space.
+    bool flush_dirty() const;
+
+    /// Begin journaling writes to the memory maps.
+    void enable_journal();
+
+    /// Advise the memory maps of both files.
+    void enable_advice(const map_advice& advice);
+
+    /// Apply the growth policy to both files.
+    void enable_file_growth(const file_growth& growth);
+
+    /// Allocate the next growth of both files, if near full.
+    void pregrow();
+
+    /// Write journaled ranges to the commit log.
+    bool log_writes(commit_log& log);
+
+    /// Add the sizes of both files to the values.
+    void footprint(table_metrics::values& values) const;
+
+    /// Call to unload the memory maps.
+    bool close();
+
+    // Records.
+    // ------------------------------------------------------------------------
+
+    /// Allocate transaction records, returning the ordinal of the first.
+    link_type allocate_transactions(size_t count);
+
+    /// Allocate output records, returning the ordinal of the first.
+    link_type allocate_outputs(size_t count);
+
+    /// The memory of the transaction record at the ordinal.
+    memory_ptr transaction(link_type ordinal) const;
+
+    /// The memory of the output record at the ordinal.
+    memory_ptr output(link_type ordinal) const;
+
+    /// Journal a range of the transaction record written in place.
+    void journal_transaction(link_type ordinal, size_t offset,
+        size_t size) const;
+
+    /// Journal a range of the output record written in place.
+    void journal_output(link_type ordinal, size_t offset, size_t size) const;
+
+private:
+    typedef record_manager<link_type> manager;
+
+    storage::ptr transactions_file_;
+    manager transactions_;
+    storage::ptr outputs_file_;
+    manager outputs_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_STORAGE_BACKEND_HPP
+#define LIBBITCOIN_DATABASE_STORAGE_BACKEND_HPP
+
+#include <cstdint>
+
+namespace libbitcoin {
+namespace database {
+
+/// The implementation of the storage of the files of a table.
+enum class storage_backend : uint8_t
+{
+    /// Memory mapped file (file_storage).
+    file = 0,
+
+    /// Anonymous memory, read from the file but not written (memory_storage).
+    memory = 1,
+
+    /// Anonymous huge page memory, otherwise as memory (memory_storage).
+    huge_pages = 2,
+
+    /// Anonymous memory, read and written with pread/pwrite (buffer_storage).
+    buffered = 3,
+
+    /// Memory mapped file, read only (file_storage of a secondary store).
+    read_only = 4,
+
+    /// Memory mapped segment files, grown in place (segmented_storage).
+    segmented = 5,
+
+    /// Memory mapped segment files, read only (segmented_storage of a
+    /// secondary store).
+    segmented_read_only = 6
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -21,9 +21,14 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_counter.hpp>
+#include <bitcoin/database/commit_log.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/manifest.hpp>
+#include <bitcoin/database/table_directories.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -36,18 +41,34 @@ public:
 
     static const std::string FLUSH_LOCK;
     static const std::string EXCLUSIVE_LOCK;
+    static const std::string COMMIT_LOG;
+    static const std::string COMMIT_COUNTER;
+    static const std::string CLEAN_MANIFEST;
     static const std::string BLOCK_TABLE;
     static const std::string CANDIDATE_INDEX;
     static const std::string CONFIRMED_INDEX;
     static const std::string TRANSACTION_INDEX;
     static const std::string TRANSACTION_TABLE;
+    static const std::string TRANSACTION_FILTER;
+    static const std::string TRANSACTION_STATE;
+    static const std::string OUTPUT_STATE;
+    static const std::string OUTPUT_CACHE;
     static const std::string ADDRESS_TABLE;
     static const std::string ADDRESS_ROWS;
+    static const std::string ADDRESS_HEIGHT;
+    static const std::string ADDRESS_BALANCES;
+    static const std::string ADDRESS_FILTERS;
+    static const std::string FILTER_TABLE;
+    static const std::string SPEND_TABLE;
 
     // Construct.
     // ------------------------------------------------------------------------
 
-    store(const path& prefix, bool with_indexes, bool flush_each_write=false);
+    store(const path& prefix, bool with_indexes, bool flush_each_write=false,
+        bool journal_writes=false, bool with_filters=false,
+        bool with_split_state=false, bool read_only=false,
+        bool with_spends=false,
+        const table_directories& directories=table_directories());
 
     // Open and close.
     // ------------------------------------------------------------------------
@@ -55,12 +76,27 @@ public:
     /// Create database files.
     virtual bool create();
 
-    /// Acquire exclusive access.
+    /// Acquire exclusive access (shared if read only), the exclusive lock is
+    /// taken in each table directory (the flush lock covers all).
     virtual bool open();
 
-    /// Release exclusive access.
+    /// Release exclusive access (shared if read only).
     virtual bool close();
 
+    /// Acquire exclusive access to repair a store that was not closed
+    /// cleanly, false if read only or journaled (recovered on open).
+    virtual bool begin_repair();
+
+    /// Release exclusive access, clearing the flush lock if repaired (call
+    /// once the repaired tables are closed).
+    virtual bool end_repair(bool repaired);
+
+    /// True if opened as a read-only secondary of a store opened elsewhere.
+    virtual bool read_only() const;
+
+    /// The state last published by the writer (heights safe to read).
+    virtual bool published(commit_counter::state& out) const;
+
     // Write with flush detection.
     // ------------------------------------------------------------------------
 
@@ -73,32 +109,83 @@ public:
     /// True if write flushing is enabled.
     virtual bool flush_each_write() const;
 
+    /// True if writes are committed to the commit log.
+    virtual bool journal_writes() const;
+
     // File names.
     // ------------------------------------------------------------------------
 
+    /// Written on clean close, consumed on open.
+    const path clean_manifest;
+
     /// Content store.
     const path block_table;
     const path candidate_index;
     const path confirmed_index;
     const path transaction_index;
     const path transaction_table;
+    const path transaction_filter;
+    const path output_cache;
 
     /// Optional indexes.
     const path address_table;
     const path address_rows;
+    const path address_height;
+    const path address_balances;
+    const path address_filters;
+    const path filter_table;
+    const path spend_table;
+    const path transaction_state;
+    const path output_state;
 
 protected:
     // The implementation must flush all data to disk here.
     virtual bool flush() const = 0;
+
+    // The implementation must log all journaled table writes here.
+    virtual bool journal(commit_log& log) const = 0;
+
+    // The implementation must provide the tops published to secondaries.
+    virtual bool tops(size_t& candidate, size_t& confirmed) const = 0;
+
+    // Publish the tops to secondaries, called on open and each write.
+    bool publish() const;
+
+    // Set the sizes of the table files in the manifest (closed tables).
+    void set_sizes(manifest& clean) const;
+
+    // The table files are the sizes set in the manifest.
+    bool matches_sizes(const manifest& clean) const;
+
     // flush_lock_mutex_ is used in conditional locks in derived classes, can't be private.
     mutable shared_mutex flush_lock_mutex_;
 
 private:
+    typedef std::shared_ptr<interprocess_lock> lock_ptr;
+
+    std::vector<path> tables() const;
+    path locate(const std::string& table) const;
+    bool lock_directories() const;
+    bool unlock_directories() const;
+    bool commit_journal() const;
+    bool recover();
+
     const path prefix_;
     const bool with_indexes_;
+    const bool with_filters_;
+    const bool with_spends_;
+    const bool with_split_state_;
     const bool flush_each_write_;
+    const bool journal_writes_;
+    const bool read_only_;
+    mutable commit_log journal_;
+    mutable commit_counter counter_;
     mutable flush_lock flush_lock_;
     mutable interprocess_lock exclusive_lock_;
+
+    // The table directories other than the prefix, each with its lock.
+    const std::vector<path> directories_;
+    std::vector<lock_ptr> directory_locks_;
 };
 
 } // namespace database
@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_TABLE_DIRECTORIES_HPP
+#define LIBBITCOIN_DATABASE_TABLE_DIRECTORIES_HPP
+
+#include <boost/filesystem.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// The directories of groups of table files, for placement of hot tables and
+/// bulk payload on different devices. An empty path is the store directory,
+/// which always holds the locks, commit log, commit counter and manifest.
+struct table_directories
+{
+    typedef boost::filesystem::path path;
+
+    /// The block table and its transaction index.
+    path blocks;
+
+    /// The candidate and confirmed indexes.
+    path indexes;
+
+    /// The transaction table (bulk payload).
+    path transactions;
+
+    /// The transaction and output state tables, transaction filter and
+    /// output cache.
+    path state;
+
+    /// The address table, rows, height and balances.
+    path addresses;
+
+    /// The filter table.
+    path filters;
+
+    /// The spend table.
+    path spends;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
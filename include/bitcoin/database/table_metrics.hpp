@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_TABLE_METRICS_HPP
+#define LIBBITCOIN_DATABASE_TABLE_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// Always-on counters of the maps, managers and files of one table. Counts
+/// are relaxed atomic increments, and time is only measured while waiting,
+/// so the cost on an uncontended path is an uncontended atomic add.
+class BCD_API table_metrics
+  : noncopyable
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /// A copy of the counters, not atomic across counters.
+    struct values
+    {
+        uint64_t lookups;
+        uint64_t hits;
+        uint64_t links_walked;
+        uint64_t allocations;
+        uint64_t allocated_bytes;
+        uint64_t remaps;
+        uint64_t remap_wait_ns;
+
+        /// Writer wait for the table's metadata lock (set by the table).
+        uint64_t lock_wait_ns;
+
+        /// The logical, physical and resident sizes of the table's files
+        /// (set by the table).
+        uint64_t logical_bytes;
+        uint64_t physical_bytes;
+        uint64_t resident_bytes;
+
+        /// Records that failed checksum verification (set by the table).
+        uint64_t corruptions;
+
+        /// Lookups that did not find the key.
+        uint64_t misses() const;
+
+        /// The mean number of elements read per lookup.
+        double average_chain() const;
+    };
+
+    /// Construct with zero counts.
+    table_metrics();
+
+    /// Count a key lookup that read the number of elements.
+    void lookup(bool hit, size_t walked);
+
+    /// Count an allocation of the number of bytes.
+    void allocate(size_t bytes);
+
+    /// Count a remap (reader drain) that waited for the duration.
+    void remap(clock::duration wait);
+
+    /// A copy of the counters.
+    values get() const;
+
+private:
+    std::atomic<uint64_t> lookups_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> links_walked_;
+    std::atomic<uint64_t> allocations_;
+    std::atomic<uint64_t> allocated_bytes_;
+    std::atomic<uint64_t> remaps_;
+    std::atomic<uint64_t> remap_wait_ns_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
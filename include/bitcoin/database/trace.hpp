@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_TRACE_HPP
+#define LIBBITCOIN_DATABASE_TRACE_HPP
+
+#include <atomic>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe, except for setting the handler.
+/// Tracing of store operations. Trace messages are compiled only with
+/// BCD_TRACE (--enable-trace) and then logged (verbose) only while enabled,
+/// so that a disabled trace costs a relaxed load and formats nothing. Spans
+/// are always compiled and invoke the handler (if set) on entry and exit of
+/// a store operation, for attachment to an external tracing system.
+class BCD_API trace
+{
+public:
+    /// Invoked with the span name, true on entry and false on exit.
+    typedef std::function<void(const char* name, bool begin)> handler;
+
+    /// Invokes the handler (if set) over the lifetime of the instance.
+    class BCD_API span
+      : noncopyable
+    {
+    public:
+        span(const char* name);
+        ~span();
+
+    private:
+        const char* name_;
+        const bool active_;
+    };
+
+    /// Enable or disable trace messages (if compiled).
+    static void enable(bool enabled);
+
+    /// True if trace messages are enabled.
+    static bool enabled();
+
+    /// Set the span handler, an empty handler clears it.
+    /// Not thread safe, set before starting the store.
+    static void set_handler(handler span_handler);
+
+private:
+    static std::atomic<bool> enabled_;
+    static std::atomic<bool> handled_;
+    static handler handler_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#ifdef BCD_TRACE
+    #define DATABASE_TRACE(message) \
+        do { \
+            if (bc::database::trace::enabled()) \
+                LOG_VERBOSE(LOG_DATABASE) \
+                    << boost::this_thread::get_id() << " " << message; \
+        } while (false)
+#else
+    #define DATABASE_TRACE(message) do {} while (false)
+#endif
+
+#define DATABASE_SPAN(name) bc::database::trace::span database_span_(name)
+
+#endif
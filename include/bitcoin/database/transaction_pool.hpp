@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_TRANSACTION_POOL_HPP
+#define LIBBITCOIN_DATABASE_TRANSACTION_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// A circular-by-age map of unconfirmed transactions, bounded by a memory
+/// budget. Pooled txs are kept out of the transaction table until stored with
+/// a block, so that txs which never confirm do not grow the table. The oldest
+/// txs are dropped when the budget is reached (as is a pool restart).
+class BCD_API transaction_pool
+  : noncopyable
+{
+public:
+    typedef std::shared_ptr<const chain::transaction> transaction_ptr;
+
+    /// Construct a pool with the specified memory budget (bytes).
+    transaction_pool(size_t budget);
+
+    /// The pool budget is zero.
+    bool disabled() const;
+
+    /// The number of txs in the pool.
+    size_t size() const;
+
+    /// The approximate memory used by the pool (bytes).
+    size_t bytes() const;
+
+    /// Add the tx validated at the forks, false if it exists.
+    bool add(const chain::transaction& tx, uint32_t forks);
+
+    /// Remove the tx (it has been stored with a block).
+    void remove(const hash_digest& hash);
+
+    /// Get the tx and the forks at which it was validated, null if missing.
+    transaction_ptr get(const hash_digest& hash, uint32_t& out_forks) const;
+
+    /// Remove all txs.
+    void clear();
+
+private:
+    typedef std::list<hash_digest> age_list;
+
+    struct pooled_transaction
+    {
+        transaction_ptr tx;
+        uint32_t forks;
+        size_t cost;
+        age_list::iterator age;
+    };
+
+    typedef std::unordered_map<hash_digest, pooled_transaction>
+        transaction_map;
+
+    static size_t cost(const chain::transaction& tx);
+    void erase(transaction_map::iterator it);
+
+    // This is thread safe.
+    const size_t budget_;
+
+    // These are protected by mutex.
+    size_t bytes_;
+    age_list ages_;
+    transaction_map transactions_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -22,38 +22,50 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
-#include <boost/bimap.hpp>
-#include <boost/bimap/set_of.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
-#include <bitcoin/database/unspent_transaction.hpp>
+#include <bitcoin/database/eviction_policy.hpp>
 
 namespace libbitcoin {
 namespace database {
 
 /// This class is thread safe.
-/// A circular-by-age hash table of [point, output].
+/// A circular-by-age hash table of [point, output], bounded by a memory budget.
+/// Entries are partitioned by tx hash into shards with independent locks and
+/// eviction sequences, so that concurrent populate calls do not contend.
 class BCD_API unspent_outputs
   : noncopyable
 {
 public:
-    // Construct a cache with the specified transaction count limit.
-    unspent_outputs(size_t capacity);
+    typedef boost::filesystem::path path;
 
-    /// The cache capacity is zero.
+    // Construct a cache with the specified memory budget (bytes).
+    unspent_outputs(size_t budget, size_t shards=16,
+        eviction_policy policy=eviction_policy::fifo);
+
+    /// The cache budget is zero.
     bool disabled() const;
 
     /// The cache has no elements.
     size_t empty() const;
 
-    /// The number of elements in the cache.
+    /// The number of outputs in the cache.
     size_t size() const;
 
-    /// The cache performance as a ratio of hits to accesses.
+    /// The approximate memory used by the cache (bytes).
+    size_t bytes() const;
+
+    /// The policy used to evict entries when the budget is reached.
+    eviction_policy policy() const;
+
+    /// The cache performance (under its policy) as a ratio of hits to accesses.
     float hit_rate() const;
 
-    /// Add outputs to cache, unconfirmed height is forks (purges matching tx).
+    /// Add outputs to cache, unconfirmed height is forks (replaces matching).
     void add(const chain::transaction& tx, size_t height,
         uint32_t median_time_past, bool confirmed);
 
@@ -67,22 +79,67 @@ public:
     bool populate(const chain::output_point& point,
         size_t fork_height=max_size_t) const;
 
+    /// Remove all outputs from the cache.
+    void clear();
+
+    /// Save the cache (oldest first) as valid at the confirmed top height.
+    bool save(const path& filename, size_t top_height) const;
+
+    /// Load a cache saved at the confirmed top height and remove the file, so
+    /// that it cannot be reloaded after later (unsaved) writes.
+    bool load(const path& filename, size_t top_height);
+
 private:
-    // A bidirection map is used for efficient output and position retrieval.
-    // This produces the effect of a circular buffer tx hash table of outputs.
-    typedef boost::bimaps::bimap<
-        boost::bimaps::unordered_set_of<unspent_transaction>,
-        boost::bimaps::set_of<uint32_t>> unspent_transactions;
+    typedef std::list<chain::point> age_list;
+
+    // The compact value of one output, the script is kept serialized.
+    struct unspent_output
+    {
+        unspent_output(uint64_t value, data_chunk&& script, uint32_t height,
+            uint32_t median_time_past, bool coinbase, bool confirmed);
+        unspent_output(unspent_output&& other);
+
+        uint64_t value;
+        data_chunk script;
+        uint32_t height;
+        uint32_t median_time_past;
+        bool coinbase;
+        bool confirmed;
+        age_list::iterator age;
+
+        // Hits since last passed by eviction (clock), set under shared lock.
+        mutable std::atomic<uint8_t> references;
+    };
+
+    typedef std::unordered_map<chain::point, unspent_output> output_map;
+
+    // The circular buffer of one shard, budget is fixed at construct.
+    struct shard
+    {
+        size_t budget;
+
+        // These are protected by mutex.
+        size_t bytes;
+        age_list ages;
+        output_map outputs;
+        mutable upgrade_mutex mutex;
+    };
+
+    static size_t cost(const unspent_output& output);
+    static void erase(shard& shard, output_map::iterator output);
+    void evict(shard& shard) const;
+    void insert(shard& shard, const chain::point& key,
+        unspent_output&& value) const;
+
+    shard& partition(const hash_digest& tx_hash);
+    const shard& partition(const hash_digest& tx_hash) const;
 
     // These are thread safe.
-    const size_t capacity_;
+    const size_t budget_;
+    const eviction_policy policy_;
     mutable std::atomic<size_t> hits_;
     mutable std::atomic<size_t> queries_;
-
-    // These are protected by mutex.
-    uint32_t sequence_;
-    unspent_transactions unspent_;
-    mutable upgrade_mutex mutex_;
+    std::vector<shard> shards_;
 };
 
 } // namespace database
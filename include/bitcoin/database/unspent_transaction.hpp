@@ -22,7 +22,6 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <unordered_map>
 #include <boost/functional/hash_fwd.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/define.hpp>
@@ -31,12 +30,11 @@ namespace libbitcoin {
 namespace database {
 
 /// This class is not thread safe.
+/// The outputs are held in one allocation (shared by copies), with the value
+/// and script end of each output, the scripts, and a bitmap of spentness.
 class BCD_API unspent_transaction
 {
 public:
-    typedef std::unordered_map<uint32_t, chain::output> output_map;
-    typedef std::shared_ptr<output_map> output_map_ptr;
-
     // Move/copy constructors.
     unspent_transaction(unspent_transaction&& other);
     unspent_transaction(const unspent_transaction& other);
@@ -54,8 +52,22 @@ public:
     bool is_confirmed() const;
     const hash_digest& hash() const;
 
-    /// Access to outputs is mutable and unprotected (not thread safe).
-    output_map_ptr outputs() const;
+    /// The number of outputs (zero if not constructed from a tx).
+    uint32_t output_count() const;
+
+    /// The size of the allocation of the outputs.
+    size_t output_bytes() const;
+
+    /// The value of the output, the index must be within the count.
+    uint64_t value(uint32_t index) const;
+
+    /// Populate the output if the index is within the count.
+    bool output(chain::output& out, uint32_t index) const;
+
+    /// Spentness is mutable and unprotected (not thread safe), and is shared
+    /// by copies. The index must be within the count.
+    bool is_spent(uint32_t index) const;
+    void spend(uint32_t index) const;
 
     /// Operators.
     bool operator==(const unspent_transaction& other) const;
@@ -63,6 +75,8 @@ public:
     unspent_transaction& operator=(const unspent_transaction& other);
 
 private:
+    size_t script_start(uint32_t index) const;
+    size_t script_end(uint32_t index) const;
 
     // These are thread safe (non-const only for assignment operator).
     size_t height_;
@@ -70,10 +84,11 @@ private:
     bool is_coinbase_;
     bool is_confirmed_;
     hash_digest hash_;
+    uint32_t output_count_;
 
-    // This is not thead safe and is publicly reachable.
+    // Spentness is not thead safe and is publicly reachable.
     // The outputs can be changed without affecting the bimapping.
-    mutable output_map_ptr outputs_;
+    std::shared_ptr<data_chunk> outputs_;
 };
 
 } // namespace database
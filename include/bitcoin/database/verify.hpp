@@ -43,6 +43,10 @@ code verify_missing(const transaction_database& transactions,
 code verify_push(const block_database& blocks,  chain::header& header,
     size_t height);
 
+/// Hash a header batch on up to threads threads (outside of any critical
+/// section), and verify that each header links to its predecessor.
+code verify_batch(const header_const_ptr_list& headers, size_t threads);
+
 code verify_push(const block_database& blocks,  chain::block& block,
     size_t height);
 
@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_WRITE_SEQUENCE_HPP
+#define LIBBITCOIN_DATABASE_WRITE_SEQUENCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+/// This class is thread safe.
+/// Counts the writes of a store so that a reader can validate that a multi
+/// step read did not overlap a write, without taking the write lock. Writes
+/// may nest (a reorganization spans many block writes) and a reader sees the
+/// outermost write as one.
+class BCD_API write_sequence
+  : noncopyable
+{
+public:
+    typedef std::function<void()> reader;
+
+    /// Marks a write for the lifetime of the instance.
+    class scope
+      : noncopyable
+    {
+    public:
+        scope(write_sequence& sequence);
+        ~scope();
+
+    private:
+        write_sequence& sequence_;
+    };
+
+    /// Construct with no write in progress.
+    write_sequence();
+
+    /// Start a write, may be nested.
+    void begin_write();
+
+    /// End a write, must follow begin_write.
+    void end_write();
+
+    /// Capture the sequence, false if a write is in progress.
+    bool begin_read(size_t& out_sequence) const;
+
+    /// True if no write has started since the sequence was captured.
+    bool end_read(size_t sequence) const;
+
+    /// Invoke the reader until it does not overlap a write, false if each of
+    /// the attempts overlaps a write. The reader must tolerate discard.
+    bool read(const reader& handler, size_t attempts) const;
+
+private:
+    std::atomic<size_t> writers_;
+    std::atomic<size_t> sequence_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,346 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/block_filter.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+// Filter format (BIP158):
+// ----------------------------------------------------------------------------
+// [ count:varint ] (the number of elements in the set)
+// [ deltas:bits  ] (sorted hashed elements, Golomb-Rice coded, zero padded)
+
+namespace libbitcoin {
+namespace database {
+
+using namespace bc::chain;
+using namespace bc::machine;
+
+const uint8_t block_filter::rice_bits = 19;
+const uint64_t block_filter::inverse_rate = 784931;
+
+// SipHash-2-4.
+// ----------------------------------------------------------------------------
+
+static inline uint64_t rotate(uint64_t value, size_t bits)
+{
+    return (value << bits) | (value >> (64u - bits));
+}
+
+static inline void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2,
+    uint64_t& v3)
+{
+    v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+    v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+}
+
+static uint64_t sip_hash(uint64_t k0, uint64_t k1, const data_chunk& data)
+{
+    auto v0 = k0 ^ 0x736f6d6570736575;
+    auto v1 = k1 ^ 0x646f72616e646f6d;
+    auto v2 = k0 ^ 0x6c7967656e657261;
+    auto v3 = k1 ^ 0x7465646279746573;
+
+    const auto size = data.size();
+    const auto words = size / sizeof(uint64_t);
+    auto it = data.begin();
+
+    for (size_t word = 0; word < words; ++word)
+    {
+        const auto value = from_little_endian_unsafe<uint64_t>(it);
+        it += sizeof(uint64_t);
+        v3 ^= value;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= value;
+    }
+
+    // The final word is the remaining bytes and the low byte of the size.
+    auto last = static_cast<uint64_t>(size) << 56;
+    for (size_t byte = 0; it != data.end(); ++it, ++byte)
+        last |= static_cast<uint64_t>(*it) << (8u * byte);
+
+    v3 ^= last;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// The high word of the product, mapping a hash uniformly onto [0, range).
+static uint64_t multiply_high(uint64_t left, uint64_t right)
+{
+    const auto left_low = left & max_uint32;
+    const auto left_high = left >> 32;
+    const auto right_low = right & max_uint32;
+    const auto right_high = right >> 32;
+
+    const auto low_low = left_low * right_low;
+    const auto high_low = left_high * right_low;
+    const auto low_high = left_low * right_high;
+    const auto high_high = left_high * right_high;
+
+    const auto cross = (low_low >> 32) + (high_low & max_uint32) + low_high;
+    return high_high + (high_low >> 32) + (cross >> 32);
+}
+
+// Bits are written most significant first, the last byte is zero padded.
+class bit_writer
+{
+public:
+    bit_writer(data_chunk& out)
+      : out_(out), byte_(0), bits_(0)
+    {
+    }
+
+    void write(uint64_t value, size_t bits)
+    {
+        while (bits-- != 0)
+        {
+            byte_ = static_cast<uint8_t>((byte_ << 1) | ((value >> bits) & 1));
+
+            if (++bits_ == byte_bits)
+                flush();
+        }
+    }
+
+    void flush()
+    {
+        if (bits_ == 0)
+            return;
+
+        out_.push_back(static_cast<uint8_t>(byte_ << (byte_bits - bits_)));
+        byte_ = 0;
+        bits_ = 0;
+    }
+
+private:
+    data_chunk& out_;
+    uint8_t byte_;
+    size_t bits_;
+};
+
+// Bits are read most significant first, reads past the end are zero.
+class bit_reader
+{
+public:
+    bit_reader(data_slice::const_iterator begin,
+        data_slice::const_iterator end)
+      : it_(begin), end_(end), bits_(0), valid_(true)
+    {
+    }
+
+    uint64_t read(size_t bits)
+    {
+        uint64_t value = 0;
+
+        while (bits-- != 0)
+        {
+            if (it_ == end_)
+            {
+                valid_ = false;
+                return value;
+            }
+
+            value = (value << 1) | ((*it_ >> (byte_bits - 1u - bits_)) & 1);
+
+            if (++bits_ == byte_bits)
+            {
+                bits_ = 0;
+                ++it_;
+            }
+        }
+
+        return value;
+    }
+
+    operator bool() const
+    {
+        return valid_;
+    }
+
+private:
+    data_slice::const_iterator it_;
+    const data_slice::const_iterator end_;
+    size_t bits_;
+    bool valid_;
+};
+
+// Filter.
+// ----------------------------------------------------------------------------
+
+data_chunk block_filter::compute(const block& block)
+{
+    data_stack elements;
+    const auto return_ = static_cast<uint8_t>(opcode::return_);
+
+    for (const auto& tx: block.transactions())
+    {
+        for (const auto& output: tx.outputs())
+        {
+            auto script = output.script().to_data(false);
+
+            if (!script.empty() && script.front() != return_)
+                elements.push_back(std::move(script));
+        }
+
+        if (tx.is_coinbase())
+            continue;
+
+        for (const auto& input: tx.inputs())
+        {
+            const auto& prevout = input.previous_output().metadata.cache;
+            BITCOIN_ASSERT(prevout.is_valid());
+            auto script = prevout.script().to_data(false);
+
+            if (!script.empty())
+                elements.push_back(std::move(script));
+        }
+    }
+
+    std::sort(elements.begin(), elements.end());
+    elements.erase(std::unique(elements.begin(), elements.end()),
+        elements.end());
+
+    return encode(block.hash(), elements);
+}
+
+data_chunk block_filter::encode(const hash_digest& block_hash,
+    const data_stack& elements)
+{
+    std::vector<uint64_t> hashes;
+    hashes.reserve(elements.size());
+
+    for (const auto& element: elements)
+        hashes.push_back(hash(block_hash, element));
+
+    return encode(hashes);
+}
+
+// The key is the first half of the hash (internal byte order).
+uint64_t block_filter::hash(const hash_digest& key, const data_chunk& element)
+{
+    const auto k0 = from_little_endian_unsafe<uint64_t>(key.begin());
+    const auto k1 = from_little_endian_unsafe<uint64_t>(key.begin() +
+        sizeof(uint64_t));
+
+    return sip_hash(k0, k1, element);
+}
+
+// The mapping onto the range is monotonic, so sorted hashes map in order.
+data_chunk block_filter::encode(std::vector<uint64_t>& hashes)
+{
+    const auto count = hashes.size();
+    const auto range = count * inverse_rate;
+    std::sort(hashes.begin(), hashes.end());
+
+    data_chunk out(variable_uint_size(count));
+    auto serial = make_unsafe_serializer(out.begin());
+    serial.write_variable_little_endian(count);
+
+    // Each delta is a unary quotient and a remainder of rice_bits.
+    bit_writer writer(out);
+    uint64_t previous = 0;
+
+    for (const auto hash: hashes)
+    {
+        const auto value = multiply_high(hash, range);
+        const auto delta = value - previous;
+        previous = value;
+
+        for (auto quotient = delta >> rice_bits; quotient != 0; --quotient)
+            writer.write(1, 1);
+
+        writer.write(0, 1);
+        writer.write(delta, rice_bits);
+    }
+
+    writer.flush();
+    return out;
+}
+
+// The filter and the hashes are walked together, as both are in order.
+bool block_filter::match(const data_slice& filter,
+    const std::vector<uint64_t>& hashes)
+{
+    if (filter.empty() || hashes.empty())
+        return false;
+
+    // The count is canonically encoded, so its size follows from its prefix.
+    const auto first = filter.front();
+    const size_t prefix = first < 0xfd ? 1u : first == 0xfd ? 3u :
+        first == 0xfe ? 5u : 9u;
+
+    if (filter.size() < prefix)
+        return false;
+
+    auto deserial = make_unsafe_deserializer(filter.begin());
+    const auto count = deserial.read_variable_little_endian();
+    const auto range = count * inverse_rate;
+
+    bit_reader reader(filter.begin() + prefix, filter.end());
+    auto hash = hashes.begin();
+    auto query = multiply_high(*hash, range);
+    uint64_t value = 0;
+
+    for (uint64_t element = 0; element < count; ++element)
+    {
+        uint64_t quotient = 0;
+        while (reader.read(1) == 1)
+            ++quotient;
+
+        value += (quotient << rice_bits) + reader.read(rice_bits);
+
+        if (!reader)
+            return false;
+
+        while (query < value)
+        {
+            if (++hash == hashes.end())
+                return false;
+
+            query = multiply_high(*hash, range);
+        }
+
+        if (query == value)
+            return true;
+    }
+
+    return false;
+}
+
+hash_digest block_filter::header(const data_chunk& filter,
+    const hash_digest& previous_header)
+{
+    return bitcoin_hash(build_chunk({ bitcoin_hash(filter), previous_header }));
+}
+
+} // namespace database
+} // namespace libbitcoin
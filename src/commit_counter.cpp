@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/commit_counter.hpp>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+// Record format:
+// ----------------------------------------------------------------------------
+// [ sequence:8         ] (zero if never published)
+// [ candidate_height:8 ]
+// [ confirmed_height:8 ]
+// [ checksum:4         ] (bitcoin checksum of the above)
+
+namespace libbitcoin {
+namespace database {
+
+#define FAIL -1
+#define INVALID_HANDLE -1
+
+static constexpr size_t payload_size = 3u * sizeof(uint64_t);
+static constexpr size_t record_size = payload_size + sizeof(uint32_t);
+
+// A read that overlaps a publish fails its checksum, so it is retried.
+static constexpr size_t read_attempts = 8;
+
+commit_counter::commit_counter(const path& filename)
+  : filename_(filename),
+    file_handle_(INVALID_HANDLE),
+    writer_(false),
+    sequence_(0)
+{
+}
+
+commit_counter::~commit_counter()
+{
+    close();
+}
+
+bool commit_counter::open(bool writer)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (file_handle_ != INVALID_HANDLE)
+        return false;
+
+    const auto flags = writer ? (O_RDWR | O_CREAT) : O_RDONLY;
+
+#ifdef _WIN32
+    file_handle_ = _wopen(filename_.wstring().c_str(), (flags | _O_BINARY),
+        (_S_IREAD | _S_IWRITE));
+#else
+    file_handle_ = ::open(filename_.string().c_str(), flags,
+        (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH));
+#endif
+
+    if (file_handle_ == INVALID_HANDLE)
+        return false;
+
+    // The sequence continues across restarts of the writer.
+    state last;
+    writer_ = writer;
+    sequence_ = read_state(last) ? last.sequence : 0;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool commit_counter::close()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (file_handle_ == INVALID_HANDLE)
+        return true;
+
+    const auto handle = file_handle_;
+    file_handle_ = INVALID_HANDLE;
+    return ::close(handle) != FAIL;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The record is not synced, since secondaries share the page cache, and the
+// tables it describes are no more durable than it is.
+bool commit_counter::publish(size_t candidate_height, size_t confirmed_height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (file_handle_ == INVALID_HANDLE || !writer_)
+        return false;
+
+    data_chunk record(record_size);
+    auto serial = make_unsafe_serializer(record.begin());
+    serial.write_8_bytes_little_endian(sequence_ + 1u);
+    serial.write_8_bytes_little_endian(candidate_height);
+    serial.write_8_bytes_little_endian(confirmed_height);
+    serial.write_4_bytes_little_endian(bitcoin_checksum(
+        data_slice(record.data(), record.data() + payload_size)));
+
+#ifdef _WIN32
+    const auto written = _lseeki64(file_handle_, 0, SEEK_SET) == FAIL ? FAIL :
+        _write(file_handle_, record.data(), record_size);
+#else
+    const auto written = pwrite(file_handle_, record.data(), record_size, 0);
+#endif
+
+    if (written != static_cast<decltype(written)>(record_size))
+        return false;
+
+    ++sequence_;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool commit_counter::read(state& out) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (file_handle_ == INVALID_HANDLE)
+        return false;
+
+    for (size_t attempt = 0; attempt < read_attempts; ++attempt)
+        if (read_state(out))
+            return out.sequence != 0;
+
+    return false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+bool commit_counter::read_state(state& out) const
+{
+    data_chunk record(record_size);
+
+#ifdef _WIN32
+    const auto count = _lseeki64(file_handle_, 0, SEEK_SET) == FAIL ? FAIL :
+        _read(file_handle_, record.data(), record_size);
+#else
+    const auto count = pread(file_handle_, record.data(), record_size, 0);
+#endif
+
+    if (count != static_cast<decltype(count)>(record_size))
+        return false;
+
+    auto deserial = make_unsafe_deserializer(record.begin());
+    out.sequence = deserial.read_8_bytes_little_endian();
+    out.candidate_height = deserial.read_8_bytes_little_endian();
+    out.confirmed_height = deserial.read_8_bytes_little_endian();
+
+    return deserial.read_4_bytes_little_endian() == bitcoin_checksum(
+        data_slice(record.data(), record.data() + payload_size));
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,293 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/commit_log.hpp>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <iterator>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+// Batch format:
+// ----------------------------------------------------------------------------
+// [ payload_size:4 ]
+// [ checksum:4     ] (bitcoin checksum of payload)
+// [
+//   [ table_size:1 ]
+//   [ table:table_size ]
+//   [ offset:8     ]
+//   [ size:4       ]
+//   [ data:size    ]
+// ]...
+
+namespace libbitcoin {
+namespace database {
+
+#define FAIL -1
+#define INVALID_HANDLE -1
+
+static constexpr auto batch_header_size = sizeof(uint32_t) +
+    sizeof(uint32_t);
+
+commit_log::commit_log(const path& filename)
+  : filename_(filename),
+    file_handle_(INVALID_HANDLE),
+    file_size_(0)
+{
+}
+
+commit_log::~commit_log()
+{
+    close();
+}
+
+bool commit_log::open()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (file_handle_ != INVALID_HANDLE)
+        return false;
+
+#ifdef _WIN32
+    file_handle_ = _wopen(filename_.wstring().c_str(),
+        (O_RDWR | O_CREAT | O_APPEND | _O_BINARY), (_S_IREAD | _S_IWRITE));
+#else
+    file_handle_ = ::open(filename_.string().c_str(),
+        (O_RDWR | O_CREAT | O_APPEND), (S_IRUSR | S_IWUSR));
+#endif
+
+    if (file_handle_ == INVALID_HANDLE)
+        return false;
+
+    struct stat sbuf;
+    if (fstat(file_handle_, &sbuf) == FAIL)
+        return false;
+
+    file_size_ = static_cast<size_t>(sbuf.st_size);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool commit_log::close()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (file_handle_ == INVALID_HANDLE)
+        return true;
+
+    const auto handle = file_handle_;
+    file_handle_ = INVALID_HANDLE;
+    buffer_.clear();
+    return ::close(handle) != FAIL;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void commit_log::write(const std::string& table, file_offset offset,
+    const uint8_t* data, size_t size)
+{
+    BITCOIN_ASSERT(table.size() <= max_uint8);
+    BITCOIN_ASSERT(size <= max_uint32);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // Reserve the batch header on the first entry of the batch.
+    if (buffer_.empty())
+        buffer_.resize(batch_header_size);
+
+    const auto start = buffer_.size();
+    buffer_.resize(start + sizeof(uint8_t) + table.size() +
+        sizeof(uint64_t) + sizeof(uint32_t) + size);
+
+    auto serial = make_unsafe_serializer(buffer_.begin() + start);
+    serial.write_byte(static_cast<uint8_t>(table.size()));
+    serial.write_bytes(reinterpret_cast<const uint8_t*>(table.data()),
+        table.size());
+    serial.write_8_bytes_little_endian(offset);
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(size));
+    serial.write_bytes(data, size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t commit_log::pending() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return buffer_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void commit_log::discard()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    buffer_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool commit_log::commit()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (buffer_.empty())
+        return true;
+
+    if (file_handle_ == INVALID_HANDLE)
+        return false;
+
+    const auto payload_size = buffer_.size() - batch_header_size;
+    BITCOIN_ASSERT(payload_size <= max_uint32);
+
+    const data_chunk payload(buffer_.begin() + batch_header_size,
+        buffer_.end());
+
+    auto serial = make_unsafe_serializer(buffer_.begin());
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(payload_size));
+    serial.write_4_bytes_little_endian(bitcoin_checksum(payload));
+
+    // A torn batch is detected (and ignored) by replay.
+    auto remaining = buffer_.size();
+    auto data = buffer_.data();
+
+    while (remaining != 0)
+    {
+        const auto written = ::write(file_handle_, data, remaining);
+
+        if (written == FAIL)
+            return false;
+
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+
+#ifdef _WIN32
+    const auto synced = _commit(file_handle_) != FAIL;
+#else
+    const auto synced = fsync(file_handle_) != FAIL;
+#endif
+
+    file_size_ += buffer_.size();
+    buffer_.clear();
+    return synced;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t commit_log::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return file_size_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool commit_log::reset()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    buffer_.clear();
+
+    if (file_handle_ == INVALID_HANDLE)
+        return false;
+
+    if (ftruncate(file_handle_, 0) == FAIL)
+        return false;
+
+#ifdef _WIN32
+    const auto synced = _commit(file_handle_) != FAIL;
+#else
+    const auto synced = fsync(file_handle_) != FAIL;
+#endif
+
+    file_size_ = 0;
+    return synced;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool commit_log::replay(replay_handler handler) const
+{
+    bc::ifstream file(filename_.string(), std::ios::in | std::ios::binary);
+
+    // A missing log is an empty log.
+    if (!file.good())
+        return true;
+
+    const data_chunk log((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+
+    size_t position = 0;
+
+    while (log.size() - position >= batch_header_size)
+    {
+        auto deserial = make_unsafe_deserializer(log.begin() + position);
+        const size_t payload_size = deserial.read_4_bytes_little_endian();
+        const auto checksum = deserial.read_4_bytes_little_endian();
+        const auto start = position + batch_header_size;
+
+        // This is a torn batch, which was never committed.
+        if (log.size() - start < payload_size)
+            break;
+
+        const data_chunk payload(log.begin() + start,
+            log.begin() + start + payload_size);
+
+        // This is a corrupted batch, which was never committed.
+        if (bitcoin_checksum(payload) != checksum)
+            break;
+
+        auto source = make_safe_deserializer(payload.begin(), payload.end());
+
+        while (!source.is_exhausted())
+        {
+            const auto table = source.read_string(source.read_byte());
+            const auto offset = source.read_8_bytes_little_endian();
+            const auto data = source.read_bytes(
+                source.read_4_bytes_little_endian());
+
+            if (!source || !handler(table, offset, data))
+                return false;
+        }
+
+        position = start + payload_size;
+    }
+
+    return true;
+}
+
+} // namespace database
+} // namespace libbitcoin
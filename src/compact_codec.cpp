@@ -0,0 +1,349 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/compact_codec.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+
+// Compact output format:
+// ----------------------------------------------------------------------------
+// [ candidate_spent:1 ]
+// [ spender_height:4  ]
+// [ value:varint      ] (compressed amount)
+// [ script:template   ] (code:varint, then hash, key or script bytes)
+
+// Script templates:
+// ----------------------------------------------------------------------------
+// [ 0 ][ hash:20 ] (p2pkh)
+// [ 1 ][ hash:20 ] (p2sh)
+// [ 2 ][ hash:20 ] (p2wpkh)
+// [ 3 ][ hash:32 ] (p2wsh)
+// [ 4 ][ key:33  ] (p2pk, compressed key)
+// [ size + 5 ][ script:size ] (any other script)
+
+namespace libbitcoin {
+namespace database {
+
+using namespace bc::chain;
+
+static constexpr auto candidate_spent_size = sizeof(uint8_t);
+static constexpr auto height_size = sizeof(uint32_t);
+static constexpr auto value_size = sizeof(uint64_t);
+static constexpr auto spend_size = candidate_spent_size + height_size;
+
+static constexpr auto point_size = hash_size + sizeof(uint16_t);
+static constexpr auto sequence_size = sizeof(uint32_t);
+
+// Larger amounts would overflow compression (and are not valid outputs).
+static constexpr uint64_t maximum_amount = 21000000ull * 100000000ull;
+
+enum script_template : uint8_t
+{
+    pay_key_hash,
+    pay_script_hash,
+    pay_witness_key_hash,
+    pay_witness_script_hash,
+    pay_compressed_key,
+    templates
+};
+
+static const size_t template_sizes[templates] = { 20, 20, 20, 32, 33 };
+
+// The template of the script, or templates if it is not a template.
+static uint8_t to_template(const data_chunk& script)
+{
+    const auto size = script.size();
+
+    if (size == 25 && script[0] == 0x76 && script[1] == 0xa9 &&
+        script[2] == 0x14 && script[23] == 0x88 && script[24] == 0xac)
+        return pay_key_hash;
+
+    if (size == 23 && script[0] == 0xa9 && script[1] == 0x14 &&
+        script[22] == 0x87)
+        return pay_script_hash;
+
+    if (size == 22 && script[0] == 0x00 && script[1] == 0x14)
+        return pay_witness_key_hash;
+
+    if (size == 34 && script[0] == 0x00 && script[1] == 0x20)
+        return pay_witness_script_hash;
+
+    if (size == 35 && script[0] == 0x21 &&
+        (script[1] == 0x02 || script[1] == 0x03) && script[34] == 0xac)
+        return pay_compressed_key;
+
+    return templates;
+}
+
+// The offset of the template payload within the script.
+static size_t payload_offset(uint8_t code)
+{
+    return code == pay_key_hash ? 3 : code == pay_compressed_key ? 1 : 2;
+}
+
+static size_t script_size(const data_chunk& script)
+{
+    const auto code = to_template(script);
+
+    if (code != templates)
+        return 1u + template_sizes[code];
+
+    const auto size = script.size();
+    return variable_uint_size(size + templates) + size;
+}
+
+static void write_script(byte_serializer& serial, const data_chunk& script)
+{
+    const auto code = to_template(script);
+
+    if (code == templates)
+    {
+        serial.write_variable_little_endian(script.size() + templates);
+        serial.write_bytes(script);
+        return;
+    }
+
+    const auto begin = script.begin() + payload_offset(code);
+    serial.write_byte(code);
+    serial.write_bytes({ begin, begin + template_sizes[code] });
+}
+
+static void append_variable(data_chunk& out, uint64_t value)
+{
+    data_chunk buffer(variable_uint_size(value));
+    auto serial = make_unsafe_serializer(buffer.begin());
+    serial.write_variable_little_endian(value);
+    extend_data(out, buffer);
+}
+
+static void append_sized(data_chunk& out, byte_deserializer& deserial)
+{
+    const auto size = deserial.read_size_little_endian();
+    append_variable(out, size);
+    extend_data(out, deserial.read_bytes(size));
+}
+
+// Codec.
+// ----------------------------------------------------------------------------
+
+bool compact_codec::compactable(const transaction& tx)
+{
+    for (const auto& output: tx.outputs())
+        if (output.value() > maximum_amount)
+            return false;
+
+    return true;
+}
+
+size_t compact_codec::size(const transaction& tx)
+{
+    auto size = tx.serialized_size(false, true);
+
+    for (const auto& output: tx.outputs())
+        size = size - output.serialized_size(false) + output_size(output);
+
+    return size;
+}
+
+size_t compact_codec::output_size(const output& output)
+{
+    return spend_size + variable_uint_size(compress(output.value())) +
+        script_size(output.script().to_data(false));
+}
+
+// The full encoding is transcoded so that spend metadata is written as is.
+void compact_codec::write(byte_serializer& serial, const transaction& tx)
+{
+    const auto& outputs = tx.outputs();
+    serial.write_variable_little_endian(outputs.size());
+    auto offset = variable_uint_size(outputs.size());
+
+    for (const auto& output: outputs)
+    {
+        write_output(serial, output);
+        offset += output.serialized_size(false);
+    }
+
+    // Inputs, locktime and version are not changed.
+    const auto data = tx.to_data(false, true);
+    serial.write_bytes({ data.begin() + offset, data.end() });
+}
+
+void compact_codec::write_output(byte_serializer& serial,
+    const output& output)
+{
+    const auto data = output.to_data(false);
+    auto deserial = make_unsafe_deserializer(data.begin());
+
+    serial.write_bytes(deserial.read_bytes(spend_size));
+    serial.write_variable_little_endian(compress(
+        deserial.read_8_bytes_little_endian()));
+
+    const auto size = deserial.read_size_little_endian();
+    write_script(serial, deserial.read_bytes(size));
+}
+
+size_t compact_codec::skip_output(byte_deserializer& deserial)
+{
+    deserial.skip(spend_size);
+    return spend_size + skip_payload(deserial);
+}
+
+size_t compact_codec::skip_payload(byte_deserializer& deserial)
+{
+    const auto value = deserial.read_variable_little_endian();
+    const auto code = deserial.read_variable_little_endian();
+    const auto size = code < templates ? template_sizes[code] :
+        code - templates;
+
+    deserial.skip(size);
+    return variable_uint_size(value) + variable_uint_size(code) + size;
+}
+
+uint64_t compact_codec::read_value(byte_deserializer& deserial)
+{
+    return decompress(deserial.read_variable_little_endian());
+}
+
+data_chunk compact_codec::read_script(byte_deserializer& deserial)
+{
+    const auto code = deserial.read_variable_little_endian();
+
+    if (code >= templates)
+        return deserial.read_bytes(code - templates);
+
+    const auto payload = deserial.read_bytes(template_sizes[code]);
+
+    switch (code)
+    {
+        case pay_key_hash:
+            return build_chunk({ data_chunk{ 0x76, 0xa9, 0x14 }, payload,
+                data_chunk{ 0x88, 0xac } });
+        case pay_script_hash:
+            return build_chunk({ data_chunk{ 0xa9, 0x14 }, payload,
+                data_chunk{ 0x87 } });
+        case pay_witness_key_hash:
+            return build_chunk({ data_chunk{ 0x00, 0x14 }, payload });
+        case pay_witness_script_hash:
+            return build_chunk({ data_chunk{ 0x00, 0x20 }, payload });
+        default:
+            return build_chunk({ data_chunk{ 0x21 }, payload,
+                data_chunk{ 0xac } });
+    }
+}
+
+data_chunk compact_codec::expand_output(byte_deserializer& deserial)
+{
+    const auto spend = deserial.read_bytes(spend_size);
+    const auto value = read_value(deserial);
+    const auto script = read_script(deserial);
+
+    data_chunk out(spend_size + value_size +
+        variable_uint_size(script.size()) + script.size());
+
+    auto serial = make_unsafe_serializer(out.begin());
+    serial.write_bytes(spend);
+    serial.write_8_bytes_little_endian(value);
+    serial.write_variable_little_endian(script.size());
+    serial.write_bytes(script);
+    return out;
+}
+
+// Inputs are walked (not copied as a block) as the record size is not known.
+data_chunk compact_codec::expand(byte_deserializer& deserial)
+{
+    data_chunk out;
+    const auto outputs = deserial.read_size_little_endian();
+    append_variable(out, outputs);
+
+    for (size_t output = 0; output < outputs; ++output)
+        extend_data(out, expand_output(deserial));
+
+    const auto inputs = deserial.read_size_little_endian();
+    append_variable(out, inputs);
+
+    for (size_t input = 0; input < inputs; ++input)
+    {
+        extend_data(out, deserial.read_bytes(point_size));
+        append_sized(out, deserial);
+
+        const auto witnesses = deserial.read_size_little_endian();
+        append_variable(out, witnesses);
+
+        for (size_t witness = 0; witness < witnesses; ++witness)
+            append_sized(out, deserial);
+
+        extend_data(out, deserial.read_bytes(sequence_size));
+    }
+
+    // Locktime and version.
+    append_variable(out, deserial.read_variable_little_endian());
+    append_variable(out, deserial.read_variable_little_endian());
+    return out;
+}
+
+// This is the amount compression of the satoshi client (utxo set).
+uint64_t compact_codec::compress(uint64_t amount)
+{
+    if (amount == 0)
+        return 0;
+
+    uint64_t exponent = 0;
+    for (; (amount % 10) == 0 && exponent < 9; ++exponent)
+        amount /= 10;
+
+    if (exponent == 9)
+        return 1 + (amount - 1) * 10 + 9;
+
+    const auto digit = amount % 10;
+    amount /= 10;
+    return 1 + (amount * 9 + digit - 1) * 10 + exponent;
+}
+
+uint64_t compact_codec::decompress(uint64_t value)
+{
+    if (value == 0)
+        return 0;
+
+    --value;
+    auto exponent = value % 10;
+    value /= 10;
+
+    uint64_t amount;
+    if (exponent < 9)
+    {
+        const auto digit = (value % 9) + 1;
+        value /= 9;
+        amount = value * 10 + digit;
+    }
+    else
+    {
+        amount = value + 1;
+    }
+
+    for (; exponent > 0; --exponent)
+        amount *= 10;
+
+    return amount;
+}
+
+} // namespace database
+} // namespace libbitcoin
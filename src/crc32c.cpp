@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/crc32c.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define CRC32C_SSE42
+#elif defined(__ARM_FEATURE_CRC32)
+    #include <arm_acle.h>
+    #define CRC32C_ARMV8
+#endif
+
+namespace libbitcoin {
+namespace database {
+
+// The reflected Castagnoli polynomial.
+static constexpr uint32_t polynomial = 0x82f63b78;
+
+static std::array<uint32_t, 256> make_table()
+{
+    std::array<uint32_t, 256> table;
+
+    for (uint32_t byte = 0; byte < table.size(); ++byte)
+    {
+        auto crc = byte;
+        for (size_t bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ ((crc & 1u) != 0 ? polynomial : 0);
+
+        table[byte] = crc;
+    }
+
+    return table;
+}
+
+static uint32_t software(const uint8_t* data, size_t size, uint32_t crc)
+{
+    static const auto table = make_table();
+
+    for (size_t byte = 0; byte < size; ++byte)
+        crc = table[(crc ^ data[byte]) & 0xff] ^ (crc >> 8);
+
+    return crc;
+}
+
+#ifdef CRC32C_SSE42
+// Compiled for the instruction, called only if the processor supports it.
+__attribute__((target("sse4.2")))
+static uint32_t hardware(const uint8_t* data, size_t size, uint32_t crc)
+{
+#ifdef __x86_64__
+    uint64_t wide = crc;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        wide = __builtin_ia32_crc32di(wide, word);
+        data += sizeof(word);
+    }
+
+    crc = static_cast<uint32_t>(wide);
+#endif
+
+    for (; size != 0; --size)
+        crc = __builtin_ia32_crc32qi(crc, *data++);
+
+    return crc;
+}
+
+static bool supported()
+{
+    static const auto sse42 = __builtin_cpu_supports("sse4.2") != 0;
+    return sse42;
+}
+#elif defined(CRC32C_ARMV8)
+static uint32_t hardware(const uint8_t* data, size_t size, uint32_t crc)
+{
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+        data += sizeof(word);
+    }
+
+    for (; size != 0; --size)
+        crc = __crc32cb(crc, *data++);
+
+    return crc;
+}
+
+static bool supported()
+{
+    return true;
+}
+#endif
+
+uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc)
+{
+    crc = ~crc;
+
+#if defined(CRC32C_SSE42) || defined(CRC32C_ARMV8)
+    if (supported())
+        return ~hardware(data, size, crc);
+#endif
+
+    return ~software(data, size, crc);
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -19,18 +19,28 @@
 #include <bitcoin/database/data_base.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstddef>
 #include <functional>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/block_filter.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/manifest.hpp>
+#include <bitcoin/database/parallel.hpp>
 #include <bitcoin/database/result/block_result.hpp>
 #include <bitcoin/database/settings.hpp>
 #include <bitcoin/database/store.hpp>
+#include <bitcoin/database/trace.hpp>
 #include <bitcoin/database/verify.hpp>
+#include <bitcoin/database/write_sequence.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -43,6 +53,47 @@ using namespace bc::wallet;
 
 #define NAME "data_base"
 
+// The approximate cache cost of a transaction (two outputs), for capacity.
+static constexpr size_t legacy_tx_cost = 2 * 160;
+
+static uint64_t nanoseconds_since(std::chrono::steady_clock::time_point start)
+{
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<uint64_t>(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(elapsed).count());
+}
+
+// Populate the prevouts created by earlier txs of the block from the block,
+// as these are not found in the store until the block's txs are stored.
+static void populate_internal(const block& block)
+{
+    const auto& txs = block.transactions();
+    std::unordered_map<hash_digest, size_t> positions;
+
+    for (size_t position = 0; position < txs.size(); ++position)
+    {
+        const auto& tx = txs[position];
+
+        for (const auto& input: tx.inputs())
+        {
+            const auto& point = input.previous_output();
+
+            if (point.is_null() || point.metadata.cache.is_valid())
+                continue;
+
+            const auto it = positions.find(point.hash());
+            if (it == positions.end())
+                continue;
+
+            const auto& outputs = txs[it->second].outputs();
+            if (point.index() < outputs.size())
+                point.metadata.cache = outputs[point.index()];
+        }
+
+        positions.emplace(tx.hash(), position);
+    }
+}
+
 // TODO: replace spends with complex query, output gets inpoint:
 // (1) transactions_.get(outpoint, require_confirmed)->spender_height.
 // (2) blocks_.get(spender_height)->transactions().
@@ -50,6 +101,7 @@ using namespace bc::wallet;
 // This has the same average cost as 1 output-query + 1/2 block-query.
 // This will reduce server indexing by 30% (address indexing only).
 // Could make index optional, redirecting queries if not present.
+// The optional spend index (index_spends) resolves the inpoint in O(1).
 
 // A failure after begin_write is returned without calling end_write.
 // This leaves the local flush lock enabled, preventing usage after restart.
@@ -60,25 +112,29 @@ using namespace bc::wallet;
 data_base::data_base(const settings& settings)
   : closed_(true),
     settings_(settings),
+    write_wait_ns_(0),
+    flushes_(0),
+    flush_ns_(0),
+    flusher_stopped_(true),
+    indexer_stopped_(true),
+    indexer_pending_(false),
+    writer_stopped_(true),
     database::store(settings.directory, settings.index_addresses,
-        settings.flush_writes)
+        settings.flush_writes, settings.journal_writes,
+        settings.index_filters, settings.transaction_split_state,
+        settings.read_only, settings.index_spends, settings.table_placement)
 {
-    const auto this_id = boost::this_thread::get_id();
-
     LOG_DEBUG(LOG_DATABASE)
-        << this_id
-        << " Buckets: "
+        << "Buckets: "
         << "block [" << settings.block_table_buckets << "], "
         << "transaction [" << settings.transaction_table_buckets << "], "
-        << "address [" << settings.address_table_buckets << "]";
+        << "address [" << settings.address_table_buckets << "], "
+        << "balance [" << settings.address_balance_buckets << "]";
 }
 
 data_base::~data_base()
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::~data_base() calling close()";
+    DATABASE_TRACE("data_base::~data_base() calling close()");
 
     close();
 }
@@ -89,10 +145,7 @@ data_base::~data_base()
 // Throws if there is insufficient disk space, not idempotent.
 bool data_base::create( chain::block& genesis)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::create(chain::block& genesis) called.";
+    DATABASE_TRACE("data_base::create(chain::block& genesis) called.");
 
     ///////////////////////////////////////////////////////////////////////////
     // Lock exclusive file access.
@@ -111,21 +164,31 @@ bool data_base::create( chain::block& genesis)
     if (settings_.index_addresses)
         created = created && addresses_->create();
 
+    if (settings_.index_filters)
+        created = created && filters_->create();
+
+    if (settings_.index_spends)
+        created = created && spends_->create();
+
     created = created && push(genesis) == error::success;
 
     if (!created)
         return false;
 
+    // The genesis block is not indexed, as when indexing is not deferred.
+    if (deferred())
+        addresses_->set_indexed_height(0);
+
+    start_flusher();
+    start_indexer();
+    start_writer();
     closed_ = false;
     return created;
 }
 
 bool data_base::create( config::block& genesis)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::create(config::block& genesis) called.";
+    DATABASE_TRACE("data_base::create(config::block& genesis) called.");
 
     return create(*(chain::block *)&(genesis)); // cast config::block to chain::block
 }
@@ -134,10 +197,8 @@ bool data_base::create( config::block& genesis)
 // May be called after stop and/or after close in order to reopen.
 bool data_base::open()
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::open() called.";
+    DATABASE_SPAN("data_base::open()");
+    DATABASE_TRACE("data_base::open() called.");
 
     ///////////////////////////////////////////////////////////////////////////
     // Lock exclusive file access and conditionally the global flush lock.
@@ -146,64 +207,291 @@ bool data_base::open()
 
     start();
 
-    bool opened = blocks_->open() && transactions_->open();
+    // The manifest of a clean shutdown is consumed, and is used only if the
+    // tables are unchanged since it was saved.
+    manifest clean(clean_manifest);
+    if (!read_only() && clean.load() && !matches_sizes(clean))
+        clean.clear();
+
+    bool opened = blocks_->open(clean) && transactions_->open();
 
     if (settings_.index_addresses)
         opened = opened && addresses_->open();
 
+    if (settings_.index_filters)
+        opened = opened && filters_->open();
+
+    if (settings_.index_spends)
+        opened = opened && spends_->open();
+
     if (!opened)
         return false;
 
+    LOG_DEBUG(LOG_DATABASE)
+        << "Hash table load factors: "
+        << "transaction [" << transactions_->load_factor() << "], "
+        << "address [" << (settings_.index_addresses ?
+            addresses_->load_factor() : 0.0f) << "]";
+
+    LOG_DEBUG(LOG_DATABASE)
+        << "Transaction filter false positive rate: "
+        << transactions_->filter_false_positive_rate();
+
+    // A secondary only reads, it neither warms caches nor indexes.
+    if (read_only())
+    {
+        closed_ = false;
+        return true;
+    }
+
+    // Warm the output cache if saved at the current confirmed top.
+    size_t top;
+    if (blocks_->top(top, false) &&
+        transactions_->load_cache(output_cache, top))
+    {
+        LOG_DEBUG(LOG_DATABASE)
+            << "Loaded output cache at height [" << top << "].";
+    }
+
+    // Payments are indexed as blocks are connected unless indexing is
+    // deferred, in which case the indexer resumes from its height.
+    size_t indexed;
+    if (settings_.index_addresses && blocks_->top(top, false))
+    {
+        const auto tracked = addresses_->indexed_height(indexed);
+
+        if (deferred() && !tracked)
+        {
+            addresses_->set_indexed_height(top);
+        }
+        else if (!deferred() && tracked)
+        {
+            if (indexed < top)
+                LOG_WARNING(LOG_DATABASE)
+                    << "Payments are not indexed above height ["
+                    << indexed << "].";
+
+            addresses_->reset_indexed_height();
+        }
+    }
+
+    start_flusher();
+    start_indexer();
+    start_writer();
     closed_ = false;
-    return opened;
+    return opened && publish();
 }
 
 // protected
 void data_base::start()
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::start() called.";
+    DATABASE_SPAN("data_base::start()");
+    DATABASE_TRACE("data_base::start() called.");
+
+    // The address space reserved for each file (zero disables reservation).
+    const auto reservation = static_cast<size_t>(
+        settings_.file_reservation_mb) * 1024 * 1024;
+
+    // A secondary maps every table read only and disables its caches and
+    // filter, which are not shared with (or refreshed from) the writer.
+    const auto secondary = read_only();
+    const auto backend = [secondary](storage_backend table)
+    {
+        if (!secondary)
+            return table;
+
+        return table == storage_backend::segmented ?
+            storage_backend::segmented_read_only : storage_backend::read_only;
+    };
 
     blocks_ = std::make_shared<block_database>(block_table, candidate_index,
         confirmed_index, transaction_index, settings_.block_table_buckets,
-        settings_.file_growth_rate);
+        settings_.file_growth_rate, reservation,
+        secondary ? 0 : settings_.header_cache_capacity,
+        backend(settings_.block_table_storage));
+
+    // The output cache budget, with capacity (txs) as a legacy fallback.
+    const auto configured_budget = settings_.cache_budget_mb != 0 ?
+        static_cast<size_t>(settings_.cache_budget_mb) * 1024 * 1024 :
+        static_cast<size_t>(settings_.cache_capacity) * legacy_tx_cost;
+    const auto cache_budget = secondary ? 0 : configured_budget;
+
+    // The transaction filter size (zero disables the filter).
+    const auto filter_size = secondary ? 0 : static_cast<size_t>(
+        settings_.transaction_filter_mb) * 1024 * 1024;
+
+    // The unconfirmed transaction pool size (zero stores txs in the table).
+    const auto pool_budget = secondary ? 0 : static_cast<size_t>(
+        settings_.transaction_pool_mb) * 1024 * 1024;
 
     transactions_ = std::make_shared<transaction_database>(transaction_table,
         settings_.transaction_table_buckets, settings_.file_growth_rate,
-        settings_.cache_capacity);
+        cache_budget, reservation, transaction_filter, filter_size,
+        settings_.transaction_filter_error_ppm, settings_.cache_eviction,
+        transaction_state, output_state,
+        backend(settings_.transaction_table_storage), pool_budget);
 
     if (settings_.index_addresses)
     {
         addresses_ = std::make_shared<address_database>(address_table,
-            address_rows, settings_.address_table_buckets,
-            settings_.file_growth_rate);
+            address_rows, address_height, address_balances, address_filters,
+            settings_.address_table_buckets,
+            settings_.address_balance_buckets,
+            settings_.address_filter_range, settings_.file_growth_rate,
+            reservation, backend(settings_.address_table_storage));
+    }
+
+    if (settings_.index_filters)
+    {
+        filters_ = std::make_shared<filter_database>(filter_table,
+            settings_.filter_table_buckets, settings_.file_growth_rate,
+            reservation, backend(settings_.filter_table_storage));
+    }
+
+    if (settings_.index_spends)
+    {
+        spends_ = std::make_shared<spend_database>(spend_table,
+            settings_.spend_table_buckets, settings_.file_growth_rate,
+            *transactions_, reservation,
+            backend(settings_.spend_table_storage));
+    }
+
+    blocks_->enable_advice(settings_.block_table_advice,
+        settings_.block_index_advice);
+    transactions_->enable_advice(settings_.transaction_table_advice);
+
+    if (settings_.index_addresses)
+        addresses_->enable_advice(settings_.address_table_advice);
+
+    if (settings_.index_filters)
+        filters_->enable_advice(settings_.filter_table_advice);
+
+    if (settings_.index_spends)
+        spends_->enable_advice(settings_.spend_table_advice);
+
+    const auto& growth = settings_.file_growth_policy;
+    blocks_->enable_file_growth(growth);
+    transactions_->enable_file_growth(growth);
+
+    if (settings_.index_addresses)
+        addresses_->enable_file_growth(growth);
+
+    if (settings_.index_filters)
+        filters_->enable_file_growth(growth);
+
+    if (settings_.index_spends)
+        spends_->enable_file_growth(growth);
+
+    if (settings_.table_load_percent != 0)
+    {
+        transactions_->enable_growth(settings_.table_load_percent);
+
+        if (settings_.index_addresses)
+            addresses_->enable_growth(settings_.table_load_percent);
+
+        if (settings_.index_filters)
+            filters_->enable_growth(settings_.table_load_percent);
+
+        if (settings_.index_spends)
+            spends_->enable_growth(settings_.table_load_percent);
+    }
+
+    transactions_->enable_parallel(settings_.store_threads);
+
+    if (settings_.transaction_compaction)
+        transactions_->enable_compaction();
+
+    if (settings_.transaction_linked_inputs)
+        transactions_->enable_linked_inputs();
+
+    if (settings_.transaction_split_state)
+        transactions_->enable_split_state();
+
+    if (settings_.transaction_checksums)
+        transactions_->enable_checksums();
+
+    transactions_->enable_verification(settings_.transaction_verify_rate);
+
+    if (settings_.index_addresses)
+        addresses_->enable_parallel(settings_.store_threads);
+
+    if (settings_.journal_writes && !secondary)
+    {
+        blocks_->enable_journal();
+        transactions_->enable_journal();
+
+        if (settings_.index_addresses)
+            addresses_->enable_journal();
+
+        if (settings_.index_filters)
+            filters_->enable_journal();
+
+        if (settings_.index_spends)
+            spends_->enable_journal();
     }
 }
 
 // protected
 void data_base::commit()
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::commit() called.";
+    DATABASE_SPAN("data_base::commit()");
+    DATABASE_TRACE("data_base::commit() called.");
 
     if (settings_.index_addresses)
         addresses_->commit();
 
+    if (settings_.index_filters)
+        filters_->commit();
+
+    if (settings_.index_spends)
+        spends_->commit();
+
     transactions_->commit();
     blocks_->commit();
 }
 
+// The state is read before the tables are remapped, since the writer grows
+// its files before it publishes the writes within them.
+bool data_base::refresh(commit_counter::state& out)
+{
+    if (closed_ || !read_only() || !published(out))
+        return false;
+
+    bool refreshed = blocks_->refresh() && transactions_->refresh();
+
+    if (settings_.index_addresses)
+        refreshed = refreshed && addresses_->refresh();
+
+    if (settings_.index_filters)
+        refreshed = refreshed && filters_->refresh();
+
+    if (settings_.index_spends)
+        refreshed = refreshed && spends_->refresh();
+
+    return refreshed;
+}
+
+// Readers are not blocked by the writer, a read that overlaps any write is
+// discarded and repeated.
+bool data_base::snapshot(const write_sequence::reader& reader,
+    size_t attempts) const
+{
+    return sequence_.read(reader, attempts);
+}
+
+// protected
+bool data_base::tops(size_t& candidate, size_t& confirmed) const
+{
+    return blocks_ && blocks_->top(candidate, true) &&
+        blocks_->top(confirmed, false);
+}
+
 // protected
 bool data_base::flush() const
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " data_base::flush() calling blocks_->flush() transactions_->flush()";
+    DATABASE_SPAN("data_base::flush()");
+    DATABASE_TRACE(
+        "data_base::flush() calling blocks_->flush() transactions_->flush()");
 
     // Avoid a race between flush and close whereby flush is skipped because
     // close is true and therefore the flush lock file is deleted before close
@@ -212,49 +500,537 @@ bool data_base::flush() const
     ////if (closed_)
     ////    return true;
 
+    const auto start = std::chrono::steady_clock::now();
     bool flushed = blocks_->flush() && transactions_->flush();
 
     if (settings_.index_addresses)
     {
-        LOG_DEBUG(LOG_DATABASE)
-        << this_id
-        << " data_base::flush() and calling addresses_->flush()";
+        DATABASE_TRACE("data_base::flush() and calling addresses_->flush()");
 
         flushed = flushed && addresses_->flush();
     }
 
-    LOG_DEBUG(LOG_DATABASE)
-        << this_id
-        << " data_base::flush() flushed to disk: "
-        << code(flushed ? error::success : error::operation_failed).message();
+    if (settings_.index_filters)
+        flushed = flushed && filters_->flush();
 
+    if (settings_.index_spends)
+        flushed = flushed && spends_->flush();
+
+    DATABASE_TRACE("data_base::flush() flushed to disk: "
+        << code(flushed ? error::success : error::operation_failed).message());
+
+    flushes_.fetch_add(1, std::memory_order_relaxed);
+    flush_ns_.fetch_add(nanoseconds_since(start), std::memory_order_relaxed);
     return flushed;
 }
 
+// protected
+bool data_base::journal(commit_log& log) const
+{
+    bool logged = blocks_->log_writes(log) && transactions_->log_writes(log);
+
+    if (settings_.index_addresses)
+        logged = logged && addresses_->log_writes(log);
+
+    if (settings_.index_filters)
+        logged = logged && filters_->log_writes(log);
+
+    if (settings_.index_spends)
+        logged = logged && spends_->log_writes(log);
+
+    return logged;
+}
+
+// private
+// Write back newly-allocated space on an interval, so that the synchronous
+// flush at each commit point has less to write. Allocate the next growth of
+// nearly full files on the same interval, so that the writer does not wait on
+// the allocation when it reserves beyond the end of a file. Compress the next
+// cold segment of the transaction table on the same interval.
+void data_base::start_flusher()
+{
+    static const uint32_t default_pregrow_interval_ms = 1000;
+    const auto flush = settings_.flush_interval_ms != 0;
+    const auto grow = !read_only() &&
+        settings_.file_growth_policy.pregrow_percent != 0;
+    const auto compress = !read_only() &&
+        settings_.transaction_warm_segments != 0;
+
+    if (!flush && !grow && !compress)
+        return;
+
+    const auto interval = std::chrono::milliseconds(flush ?
+        settings_.flush_interval_ms : default_pregrow_interval_ms);
+
+    flusher_stopped_ = false;
+    flusher_ = std::thread([this, interval, flush, grow, compress]()
+    {
+        std::unique_lock<std::mutex> lock(flusher_mutex_);
+
+        while (!flusher_condition_.wait_for(lock, interval,
+            [this]() { return flusher_stopped_; }))
+        {
+            if (flush)
+                flush_dirty();
+
+            if (grow)
+                pregrow();
+
+            if (compress)
+                transactions_->compress(settings_.transaction_warm_segments);
+        }
+    });
+}
+
+// private
+void data_base::stop_flusher()
+{
+    if (!flusher_.joinable())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(flusher_mutex_);
+        flusher_stopped_ = true;
+    }
+
+    flusher_condition_.notify_one();
+    flusher_.join();
+}
+
+// private
+unique_lock data_base::lock_write() const
+{
+    // The wait is only timed when the lock is contended.
+    unique_lock lock(write_mutex_, boost::try_to_lock);
+
+    if (!lock.owns_lock())
+    {
+        const auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        write_wait_ns_.fetch_add(nanoseconds_since(start),
+            std::memory_order_relaxed);
+    }
+
+    return lock;
+}
+
+// private
+void data_base::flush_dirty()
+{
+    bool flushed = blocks_->flush_dirty() && transactions_->flush_dirty();
+
+    if (settings_.index_addresses)
+        flushed = flushed && addresses_->flush_dirty();
+
+    if (settings_.index_filters)
+        flushed = flushed && filters_->flush_dirty();
+
+    if (settings_.index_spends)
+        flushed = flushed && spends_->flush_dirty();
+
+    if (!flushed)
+    {
+        LOG_ERROR(LOG_DATABASE)
+            << "Background writeback failed.";
+    }
+}
+
+// private
+void data_base::pregrow()
+{
+    blocks_->pregrow();
+    transactions_->pregrow();
+
+    if (settings_.index_addresses)
+        addresses_->pregrow();
+
+    if (settings_.index_filters)
+        filters_->pregrow();
+
+    if (settings_.index_spends)
+        spends_->pregrow();
+}
+
+// private
+bool data_base::deferred() const
+{
+    return settings_.index_addresses && settings_.index_deferred;
+}
+
+// private
+// Index confirmed blocks in order behind the confirmed top, so that block
+// connection does not wait on payment indexing.
+void data_base::start_indexer()
+{
+    if (!deferred())
+        return;
+
+    indexer_stopped_ = false;
+    indexer_pending_ = true;
+    indexer_ = std::thread([this]()
+    {
+        std::unique_lock<std::mutex> lock(indexer_mutex_);
+
+        while (true)
+        {
+            indexer_condition_.wait(lock, [this]()
+            {
+                return indexer_stopped_ || indexer_pending_;
+            });
+
+            if (indexer_stopped_)
+                break;
+
+            indexer_pending_ = false;
+            lock.unlock();
+
+            while (!indexer_stopped_ && index_next());
+
+            lock.lock();
+        }
+    });
+}
+
+// private
+void data_base::stop_indexer()
+{
+    if (!indexer_.joinable())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(indexer_mutex_);
+        indexer_stopped_ = true;
+    }
+
+    indexer_condition_.notify_one();
+    indexer_.join();
+}
+
+// private
+void data_base::notify_indexer()
+{
+    if (!deferred())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(indexer_mutex_);
+        indexer_pending_ = true;
+    }
+
+    indexer_condition_.notify_one();
+}
+
+// private
+// Queued writes are executed in order until the writer is stopped and the
+// queue is drained, so that each handler is invoked once.
+void data_base::start_writer()
+{
+    if (read_only())
+        return;
+
+    const auto window = std::chrono::milliseconds(
+        settings_.transaction_commit_window_ms);
+
+    writer_stopped_ = false;
+    writer_ = std::thread([this, window]()
+    {
+        write_requests requests;
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+
+        while (true)
+        {
+            writer_condition_.wait(lock, [this]()
+            {
+                return writer_stopped_ || !writes_.empty();
+            });
+
+            if (writes_.empty())
+                break;
+
+            // A run of tx stores is held open for the commit window, unless
+            // another write is queued behind it.
+            if (window.count() != 0 && writes_.front().tx)
+            {
+                writer_condition_.wait_for(lock, window, [this]()
+                {
+                    return writer_stopped_ || !writes_.back().tx;
+                });
+            }
+
+            requests.swap(writes_);
+            lock.unlock();
+
+            execute(requests);
+            requests.clear();
+
+            lock.lock();
+        }
+    });
+}
+
+// private
+void data_base::stop_writer()
+{
+    if (!writer_.joinable())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        writer_stopped_ = true;
+    }
+
+    writer_condition_.notify_one();
+    writer_.join();
+}
+
+// private
+void data_base::enqueue(write_request&& request)
+{
+    {
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+
+        if (!writer_stopped_)
+        {
+            writes_.push_back(std::move(request));
+            writer_condition_.notify_one();
+            return;
+        }
+    }
+
+    request.handler(error::service_stopped);
+}
+
+// private
+// Each run of consecutive tx stores is group committed.
+void data_base::execute(write_requests& requests)
+{
+    const auto not_store = [](const write_request& request)
+    {
+        return !request.tx;
+    };
+
+    for (auto it = requests.begin(); it != requests.end();)
+    {
+        if (!it->tx)
+        {
+            it->handler(it->write());
+            ++it;
+            continue;
+        }
+
+        const auto last = std::find_if(it, requests.end(), not_store);
+        store(it, last);
+        it = last;
+    }
+}
+
+// private
+// The txs are stored in one write, so the store is flushed once for all.
+void data_base::store(write_requests::iterator first,
+    write_requests::iterator last)
+{
+    DATABASE_SPAN("data_base::store(group)");
+
+    std::vector<code> results;
+    results.reserve(std::distance(first, last));
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(lock_write());
+        write_sequence::scope write(sequence_);
+
+        //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+        conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
+
+        if (!begin_write())
+        {
+            results.assign(std::distance(first, last),
+                error::store_lock_failure);
+        }
+        else
+        {
+            for (auto it = first; it != last; ++it)
+            {
+                // Verified within the write, as a tx may be queued twice.
+                auto ec = verify_missing(*transactions_, *it->tx);
+
+                if (!ec && !transactions_->store(*it->tx, it->forks))
+                    ec = error::operation_failed;
+
+                results.push_back(ec);
+            }
+
+            // As with the store of one tx, a failed store ends the write. The
+            // txs of the group are stored independently, so those stored are
+            // committed and each request has its own result.
+            transactions_->commit();
+
+            if (!end_write())
+                for (auto& ec: results)
+                    if (!ec)
+                        ec = error::store_lock_failure;
+        }
+        //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    auto result = results.begin();
+    for (auto it = first; it != last; ++it)
+        it->handler(*result++);
+}
+
+// private
+// The block is read and its payments extracted outside of the write lock,
+// which is then held only to write the rows and the new indexed height.
+bool data_base::index_next()
+{
+    size_t indexed;
+    size_t top;
+    if (!addresses_->indexed_height(indexed) || !blocks_->top(top, false) ||
+        indexed >= top)
+        return false;
+
+    const auto height = indexed + 1u;
+    const auto result = blocks_->get(height, false);
+
+    if (!result)
+        return false;
+
+    const chain::block block(result.header(), to_transactions(result));
+    transactions_->get_outputs(block, height, false);
+    const auto payments = addresses_->extract(block.transactions(), height);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
+
+    // The block may have been popped while its payments were extracted.
+    size_t current;
+    if (!addresses_->indexed_height(current) || current != indexed)
+        return true;
+
+    const auto confirmed = blocks_->get(height, false);
+
+    if (!confirmed)
+        return false;
+
+    if (confirmed.hash() != result.hash())
+        return true;
+
+    //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+    conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
+
+    if (!begin_write())
+    {
+        LOG_ERROR(LOG_DATABASE)
+            << "Payment indexing failed to start a write.";
+        return false;
+    }
+
+    addresses_->index(payments);
+    addresses_->set_indexed_height(height);
+    addresses_->commit();
+
+    if (!end_write())
+    {
+        LOG_ERROR(LOG_DATABASE)
+            << "Payment indexing failed to end a write.";
+        return false;
+    }
+
+    return true;
+    //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 // Close is idempotent and thread safe.
 // Optional as the database will close on destruct.
 bool data_base::close()
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::close() called.";
+    DATABASE_SPAN("data_base::close()");
+    DATABASE_TRACE("data_base::close() called.");
 
     if (closed_)
         return true;
 
     closed_ = true;
+    stop_writer();
+    stop_indexer();
+    stop_flusher();
+
+    // Save the output cache for a warm restart (writers are stopped).
+    size_t top;
+    if (!read_only() && blocks_->top(top, false))
+        transactions_->save_cache(output_cache, top);
+
+    manifest clean(clean_manifest);
+    blocks_->save(clean);
 
     bool closed = blocks_->close() && transactions_->close();
 
     if (settings_.index_addresses)
         closed = closed && addresses_->close();
 
+    if (settings_.index_filters)
+        closed = closed && filters_->close();
+
+    if (settings_.index_spends)
+        closed = closed && spends_->close();
+
+    // The manifest is saved once the tables are closed (at final size).
+    if (closed && !read_only())
+    {
+        set_sizes(clean);
+        clean.save();
+    }
+
     return closed && store::close();
     // Unlock exclusive file access and conditionally the global flush lock.
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Address and filter tables are not repaired, and the output cache (saved
+// by height alone) is discarded.
+bool data_base::repair()
+{
+    DATABASE_SPAN("data_base::repair()");
+
+    if (!closed_ || !begin_repair())
+        return false;
+
+    start();
+
+    size_t cut;
+    const auto threads = parallelism(settings_.store_threads);
+    const auto repaired = transactions_->recover(cut) &&
+        blocks_->recover(*transactions_, threads);
+
+    if (repaired)
+    {
+        size_t candidate;
+        size_t confirmed;
+        const auto indexed = blocks_->top(candidate, true) &&
+            blocks_->top(confirmed, false);
+
+        LOG_INFO(LOG_DATABASE)
+            << "Repaired store to candidate height ["
+            << (indexed ? candidate : 0) << "] and confirmed height ["
+            << (indexed ? confirmed : 0) << "], cutting ["
+            << cut << "] transaction chains.";
+
+        blocks_->commit();
+        transactions_->commit();
+
+        boost::system::error_code ec;
+        boost::filesystem::remove(output_cache, ec);
+    }
+
+    const auto closed = blocks_->close() && transactions_->close();
+    return end_repair(repaired && closed) && repaired && closed;
+}
+
 // Reader interfaces.
 // ----------------------------------------------------------------------------
 // public
@@ -276,37 +1052,128 @@ bool data_base::close()
     return *addresses_;
 }
 
+// Invalid if filters not initialized.
+ filter_database& data_base::filters() const
+{
+    return *filters_;
+}
+
+// Invalid if spends not initialized.
+ spend_database& data_base::spends() const
+{
+    return *spends_;
+}
+
+bool data_base::get_block_data(data_chunk& out_data, const hash_digest& hash,
+    bool witness) const
+{
+    const auto result = blocks_->get(hash);
+    return result && transactions_->get_block_data(out_data, result, witness);
+}
+
+bool data_base::export_unspent(const path& filename) const
+{
+    DATABASE_SPAN("data_base::export_unspent()");
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(lock_write());
+
+    size_t height;
+    if (!blocks_->top(height, false))
+        return false;
+
+    const auto result = blocks_->get(height, false);
+
+    if (!result)
+        return false;
+
+    return transactions_->export_unspent(filename, height, result.hash());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+store_metrics data_base::metrics() const
+{
+    static const table_metrics::values none{};
+    const auto relaxed = std::memory_order_relaxed;
+
+    return
+    {
+        blocks_->metrics(),
+        transactions_->metrics(),
+        settings_.index_addresses ? addresses_->metrics() : none,
+        settings_.index_filters ? filters_->metrics() : none,
+        settings_.index_spends ? spends_->metrics() : none,
+        transactions_->cache_hit_rate(),
+        write_wait_ns_.load(relaxed),
+        flushes_.load(relaxed),
+        flush_ns_.load(relaxed)
+    };
+}
+
 // Public writers.
 // ----------------------------------------------------------------------------
 
+bool data_base::import_unspent(const path& filename)
+{
+    DATABASE_SPAN("data_base::import_unspent()");
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
+
+    //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+    conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
+
+    if (!begin_write())
+        return false;
+
+    if (!transactions_->import_unspent(filename))
+        return false;
+
+    transactions_->commit();
+    return end_write();
+    //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 code data_base::index( transaction& tx)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::index(tx) called.";
+    DATABASE_SPAN("data_base::index(tx)");
+    DATABASE_TRACE("data_base::index(tx) called.");
 
     code ec;
 
     // Existence check prevents duplicated indexing.
-    if (!settings_.index_addresses || tx.metadata.existed)
+    if (!settings_.index_addresses || deferred() || tx.metadata.existed)
+        return ec;
+
+    // A pooled tx is not linked, so it is indexed when stored with a block.
+    if (tx.metadata.link == transaction::validation::unlinked)
         return ec;
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
 
     if ((ec = verify_exists(*transactions_, tx)))
         return ec;
 
+    // Spent values are taken from the prevouts, populated if not cached.
+    for (const auto& input: tx.inputs())
+        if (!input.previous_output().metadata.cache.is_valid())
+            transactions_->get_output(input.previous_output(), max_size_t,
+                false);
+
     //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
     conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::index begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::index begin_write error::store_lock_failure");
 
         return error::store_lock_failure;
     }
@@ -320,9 +1187,7 @@ code data_base::index( transaction& tx)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::index end_write error::store_lock_failure";
+        DATABASE_TRACE("data_base::index end_write error::store_lock_failure");
         return error::store_lock_failure;
     }
 
@@ -332,38 +1197,44 @@ code data_base::index( transaction& tx)
 
 code data_base::index( block& block)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::index(block) called.";
+    DATABASE_SPAN("data_base::index(block)");
+    DATABASE_TRACE("data_base::index(block) called.");
 
     code ec;
-    if (!settings_.index_addresses)
+    // Confirmed blocks are indexed by the indexer when deferred.
+    if (!settings_.index_addresses || deferred())
         return ec;
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
     
     if ((ec = verify_exists(*blocks_, block.header())))
         return ec;
 
+    // Rows carry the height of the block so queries may be height bounded.
+    const auto result = blocks_->get(block.hash());
+
+    if (!result)
+        return error::not_found;
+
+    // Spent values are taken from the prevouts, populated if not cached.
+    populate_prevouts(block, result.height());
+
     //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
     conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::index(block) begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::index(block) begin_write error::store_lock_failure");
 
         return error::store_lock_failure;
     }
     
     // Existence check prevents duplicated indexing.
-    for ( auto tx: block.transactions())
-        if (!tx.metadata.existed)
-            addresses_->index(tx);
+    addresses_->index(block.transactions(), result.height());
 
     addresses_->commit();
 
@@ -373,9 +1244,8 @@ code data_base::index( block& block)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::index(block) end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::index(block) end_write error::store_lock_failure");
 
         return error::store_lock_failure;
     }
@@ -385,16 +1255,31 @@ code data_base::index( block& block)
 
 code data_base::store( transaction& tx, uint32_t forks)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::store called. tx: " << &tx;
+    DATABASE_SPAN("data_base::store");
+    DATABASE_TRACE("data_base::store called. tx: " << &tx);
 
     code ec;
 
+    // Stores within the window are group committed by the writer thread.
+    if (settings_.transaction_commit_window_ms != 0 && !read_only())
+    {
+        std::promise<code> result;
+        // The caller waits on the result, so the tx is not owned.
+        const std::shared_ptr<transaction> unowned(
+            std::shared_ptr<transaction>(), &tx);
+
+        enqueue({ nullptr, unowned, forks, [&result](const code& ec)
+        {
+            result.set_value(ec);
+        }});
+
+        return result.get_future().get();
+    }
+
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
     
     // Returns error::duplicate_transaction if tx with same hash exists.
     if ((ec = verify_missing(*transactions_, tx)))
@@ -405,9 +1290,8 @@ code data_base::store( transaction& tx, uint32_t forks)
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::store begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::store begin_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -417,9 +1301,8 @@ code data_base::store( transaction& tx, uint32_t forks)
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::store store end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::store store end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -434,9 +1317,8 @@ code data_base::store( transaction& tx, uint32_t forks)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::index(block) end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::index(block) end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -448,15 +1330,15 @@ code data_base::reorganize(const config::checkpoint& fork_point,
     header_const_ptr_list_const_ptr incoming,
     header_const_ptr_list_ptr outgoing)
 {
-    const auto this_id = boost::this_thread::get_id();
-
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::reorganize() called.";
+    DATABASE_SPAN("data_base::reorganize()");
+    DATABASE_TRACE("data_base::reorganize() called.");
 
     if (fork_point.height() > max_size_t - incoming->size())
         return error::operation_failed;
 
+    // Readers see the reorganization as one write.
+    write_sequence::scope write(sequence_);
+
     const auto result =
         pop_above(outgoing, fork_point) &&
         push_all(incoming, fork_point);
@@ -465,31 +1347,33 @@ code data_base::reorganize(const config::checkpoint& fork_point,
 }
 
 // Add missing transactions for an existing block header.
-// This allows parallel write when write flushing is not enabled.
 code data_base::update( chain::block& block, size_t height)
 {
-    code ec;
-    const auto this_id = boost::this_thread::get_id();
+    return update(block, height, false);
+}
 
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::update() called. instantiating conditional_lock lock()";
+// Add missing transactions for an existing block header.
+// This allows parallel write when write flushing is not enabled.
+code data_base::update( chain::block& block, size_t height, bool linked)
+{
+    code ec;
+    DATABASE_SPAN("data_base::update()");
+    DATABASE_TRACE(
+        "data_base::update() called. instantiating conditional_lock lock()");
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
     
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::update() conditional_lock lock() instantiated successfully";
+    DATABASE_TRACE(
+        "data_base::update() conditional_lock lock() instantiated successfully");
 
     if ((ec = verify_update(*blocks_, block, height)))
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " error data_base::update() verify_update()"
-        << " block height: " << height
-        << " error_code: " << ec << ec.message();
+        DATABASE_TRACE("error data_base::update() verify_update()"
+            << " block height: " << height << " error_code: " << ec
+            << ec.message());
         
         return ec;
     }
@@ -502,20 +1386,18 @@ code data_base::update( chain::block& block, size_t height)
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " error data_base::update() begin_write() error_code: error::store_lock_failure";
+        DATABASE_TRACE(
+            "error data_base::update() begin_write() error_code: error::store_lock_failure");
         return error::store_lock_failure;
     }
     
     // Store the missing transactions and set tx link metadata for all.
-    if (!transactions_->store(block.transactions()))
+    if (!transactions_->store(block.transactions(), linked))
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::update store end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::update store end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -525,9 +1407,8 @@ code data_base::update( chain::block& block, size_t height)
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::update update end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::update update end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -540,9 +1421,8 @@ code data_base::update( chain::block& block, size_t height)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::update() end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::update() end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -553,16 +1433,16 @@ code data_base::update( chain::block& block, size_t height)
 // Promote unvalidated block to valid|invalid based on error value.
 code data_base::invalidate( header& header, const code& error)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::invalidate() called. instantiating conditional_lock";
+    DATABASE_SPAN("data_base::invalidate()");
+    DATABASE_TRACE(
+        "data_base::invalidate() called. instantiating conditional_lock");
 
     code ec;
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
     
     if ((ec = verify_exists(*blocks_, header)))
         return ec;
@@ -572,9 +1452,8 @@ code data_base::invalidate( header& header, const code& error)
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::invalidate begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::invalidate begin_write error::store_lock_failure");
 
         return error::store_lock_failure;
     }
@@ -583,9 +1462,8 @@ code data_base::invalidate( header& header, const code& error)
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::invalidate validate end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::invalidate validate end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -599,9 +1477,8 @@ code data_base::invalidate( header& header, const code& error)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::invalidate() end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::invalidate() end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -611,16 +1488,15 @@ code data_base::invalidate( header& header, const code& error)
 // Mark candidate as valid, and txs and outputs spent by them as candidate.
 code data_base::candidate( block& block)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::candidate() called";
+    DATABASE_SPAN("data_base::candidate()");
+    DATABASE_TRACE("data_base::candidate() called");
 
     code ec;
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
     
     if ((ec = verify_not_failed(*blocks_, block)))
         return ec;
@@ -633,9 +1509,8 @@ code data_base::candidate( block& block)
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::candidate begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::candidate begin_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -645,25 +1520,22 @@ code data_base::candidate( block& block)
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::candidate validate end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::candidate validate end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
     
     // Mark candidate block txs and outputs spent by them as candidate.
-    for (const auto& tx: block.transactions())
-        if (!transactions_->candidate(tx.metadata.link))
+    if (!transactions_->candidate(block.transactions()))
+    {
+        if (!end_write())
         {
-            if (!end_write())
-            {
-                LOG_VERBOSE(LOG_DATABASE)
-                << this_id
-                << " data_base::candidate candidate end_write error::store_lock_failure";
-            }
-            return error::operation_failed;
+            DATABASE_TRACE(
+                "data_base::candidate candidate end_write error::store_lock_failure");
         }
+        return error::operation_failed;
+    }
 
     header.metadata.error = error::success;
     header.metadata.validated = true;
@@ -674,9 +1546,8 @@ code data_base::candidate( block& block)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::candidate end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::candidate end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -688,14 +1559,36 @@ code data_base::reorganize(const config::checkpoint& fork_point,
     block_const_ptr_list_const_ptr incoming,
     block_const_ptr_list_ptr outgoing)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::reorganize() called";
+    DATABASE_SPAN("data_base::reorganize()");
+    DATABASE_TRACE("data_base::reorganize() called");
+
+    if (fork_point.height() > max_size_t - incoming->size())
+        return error::operation_failed;
+
+    // Readers see the reorganization as one write.
+    write_sequence::scope write(sequence_);
+
+    const auto result =
+        pop_above(outgoing, fork_point) &&
+        push_all(incoming, fork_point);
+
+    return result ? error::success : error::operation_failed;
+}
+
+// Reorganize blocks, outgoing txs are not read.
+code data_base::reorganize(const config::checkpoint& fork_point,
+    block_const_ptr_list_const_ptr incoming,
+    block_result::list& outgoing)
+{
+    DATABASE_SPAN("data_base::reorganize()");
+    DATABASE_TRACE("data_base::reorganize() called");
 
     if (fork_point.height() > max_size_t - incoming->size())
         return error::operation_failed;
 
+    // Readers see the reorganization as one write.
+    write_sequence::scope write(sequence_);
+
     const auto result =
         pop_above(outgoing, fork_point) &&
         push_all(incoming, fork_point);
@@ -708,23 +1601,23 @@ code data_base::reorganize(const config::checkpoint& fork_point,
 code data_base::push( block& block, size_t height,
     uint32_t median_time_past)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::push() called";
+    DATABASE_SPAN("data_base::push()");
+    DATABASE_TRACE("data_base::push() called");
+
+    const auto filter = compute_filter(block, height);
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
 
     //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
     conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::push begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::push begin_write error::store_lock_failure");
 
         return error::store_lock_failure;
     }
@@ -737,9 +1630,8 @@ code data_base::push( block& block, size_t height,
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::push index candidate end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::push index candidate end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -749,9 +1641,8 @@ code data_base::push( block& block, size_t height,
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::push store end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::push store end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -761,9 +1652,8 @@ code data_base::push( block& block, size_t height,
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::push update end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::push update end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -773,48 +1663,40 @@ code data_base::push( block& block, size_t height,
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::push confirm end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::push confirm end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
 
-    // Promote validation state to valid (presumed valid).
-    if (!blocks_->validate(block.hash(), error::success))
-    {
-        if (!end_write())
-        {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::push validate end_write error::store_lock_failure";
-        }
-        return error::operation_failed;
-    }
-    
-    // Push header reference onto the confirmed index and set confirmed state.
-    if (!blocks_->index(block.hash(), height, false))
+    if (settings_.index_spends)
+        spends_->index(block.transactions());
+
+    // Promote to valid (presumed valid), push header reference onto the
+    // confirmed index and set confirmed state, in one state transition.
+    if (!blocks_->index({ block.hash() }, height, false, true))
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::push index confirmed end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::push index confirmed end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
-    
+
+    store_filter(block, filter);
+    prune(height);
     commit();
 
     if (end_write())
     {
+        // Blocks confirmed one at a time are also indexed in background.
+        notify_indexer();
         return error::success;
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::push end_write error::store_lock_failure";
+        DATABASE_TRACE("data_base::push end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -822,6 +1704,51 @@ code data_base::push( block& block, size_t height,
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Asynchronous writers.
+// ----------------------------------------------------------------------------
+// The request objects are retained by the queued write until it completes.
+
+void data_base::push(block_ptr block, size_t height,
+    uint32_t median_time_past, result_handler handler)
+{
+    enqueue({ [=]() { return push(*block, height, median_time_past); },
+        nullptr, 0, handler });
+}
+
+void data_base::update(block_ptr block, size_t height,
+    result_handler handler)
+{
+    enqueue({ [=]() { return update(*block, height); }, nullptr, 0,
+        handler });
+}
+
+void data_base::candidate(block_ptr block, result_handler handler)
+{
+    enqueue({ [=]() { return candidate(*block); }, nullptr, 0, handler });
+}
+
+void data_base::reorganize(const config::checkpoint& fork_point,
+    header_const_ptr_list_const_ptr incoming,
+    header_const_ptr_list_ptr outgoing, result_handler handler)
+{
+    enqueue({ [=]() { return reorganize(fork_point, incoming, outgoing); },
+        nullptr, 0, handler });
+}
+
+void data_base::reorganize(const config::checkpoint& fork_point,
+    block_const_ptr_list_const_ptr incoming,
+    block_const_ptr_list_ptr outgoing, result_handler handler)
+{
+    enqueue({ [=]() { return reorganize(fork_point, incoming, outgoing); },
+        nullptr, 0, handler });
+}
+
+void data_base::store(transaction_ptr tx, uint32_t forks,
+    result_handler handler)
+{
+    enqueue({ nullptr, tx, forks, handler });
+}
+
 // Header reorganization.
 // ----------------------------------------------------------------------------
 // protected
@@ -829,33 +1756,61 @@ code data_base::push( block& block, size_t height,
 bool data_base::push_all(header_const_ptr_list_const_ptr headers,
     const config::checkpoint& fork_point)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::push_all() called";
+    DATABASE_SPAN("data_base::push_all()");
+    DATABASE_TRACE("data_base::push_all() called");
 
     code ec;
     const auto first_height = fork_point.height() + 1;
 
-    // Push all headers onto the fork point.
-    for (size_t index = 0; index < headers->size(); ++index)
+    if (headers->empty())
+        return true;
+
+    // Hash and link the batch concurrently, before blocking other writers.
+    if ((ec = verify_batch(*headers, parallelism(settings_.store_threads))))
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
+
+    // The batch is contiguous, so only its first header links to the store.
+    if ((ec = verify_push(*blocks_, *headers->front(), first_height)))
+        return false;
+
+    //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+    conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
+
+    if (!begin_write())
     {
-         auto& header = *((*headers)[index]);
-        const auto median_time_past = header.metadata.median_time_past;
-        if ((ec = push_header(header, first_height + index, median_time_past)))
-            return false;
+        DATABASE_TRACE(
+            "data_base::push_all begin_write error::store_lock_failure");
+
+        return false;
     }
 
-    return true;
+    // Push all headers onto the fork point in one store and index pass.
+    const auto pushed = blocks_->push(*headers, first_height);
+    blocks_->commit();
+
+    if (!end_write())
+    {
+        DATABASE_TRACE(
+            "data_base::push_all end_write error::store_lock_failure");
+
+        return false;
+    }
+
+    return pushed;
+    //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 bool data_base::pop_above(header_const_ptr_list_ptr headers,
     const config::checkpoint& fork_point)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::pop_above() called";
+    DATABASE_SPAN("data_base::pop_above()");
+    DATABASE_TRACE("data_base::pop_above() called");
 
     code ec;
     headers->clear();
@@ -890,16 +1845,15 @@ bool data_base::pop_above(header_const_ptr_list_ptr headers,
 code data_base::push_header( chain::header& header, size_t height,
     uint32_t median_time_past)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::push_header() called";
+    DATABASE_SPAN("data_base::push_header()");
+    DATABASE_TRACE("data_base::push_header() called");
 
     code ec;
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
 
     if ((ec = verify_push(*blocks_, header, height)))
         return ec;
@@ -909,9 +1863,8 @@ code data_base::push_header( chain::header& header, size_t height,
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::push_header begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::push_header begin_write error::store_lock_failure");
 
         return error::store_lock_failure;
     }
@@ -928,9 +1881,8 @@ code data_base::push_header( chain::header& header, size_t height,
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::push_header end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::push_header end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -941,16 +1893,15 @@ code data_base::push_header( chain::header& header, size_t height,
 // Expects header exists at the top of the candidate index.
 code data_base::pop_header(chain::header& out_header, size_t height)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::pop_header() called";
+    DATABASE_SPAN("data_base::pop_header()");
+    DATABASE_TRACE("data_base::pop_header() called");
 
     code ec;
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
 
     if ((verify_top(*blocks_, height, true)))
         return ec;
@@ -965,9 +1916,8 @@ code data_base::pop_header(chain::header& out_header, size_t height)
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::pop_header begin_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::pop_header begin_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -978,9 +1928,8 @@ code data_base::pop_header(chain::header& out_header, size_t height)
         {
             if (!end_write())
             {
-                LOG_VERBOSE(LOG_DATABASE)
-                << this_id
-                << " data_base::pop_header uncandidate end_write error::store_lock_failure";
+                DATABASE_TRACE(
+                    "data_base::pop_header uncandidate end_write error::store_lock_failure");
             }
             return error::operation_failed;
         }
@@ -990,9 +1939,8 @@ code data_base::pop_header(chain::header& out_header, size_t height)
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::pop_header unindex end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::pop_header unindex end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -1008,9 +1956,8 @@ code data_base::pop_header(chain::header& out_header, size_t height)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::pop_header end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::pop_header end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -1025,148 +1972,160 @@ code data_base::pop_header(chain::header& out_header, size_t height)
 bool data_base::push_all(block_const_ptr_list_const_ptr blocks,
     const config::checkpoint& fork_point)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::push_all() called";
+    DATABASE_SPAN("data_base::push_all()");
+    DATABASE_TRACE("data_base::push_all() called");
 
     code ec;
     const auto first_height = fork_point.height() + 1;
 
-    // Push all blocks onto the fork point.
-    for (size_t index = 0; index < blocks->size(); ++index)
-    {
-         auto& block = *((*blocks)[index]);
-        if ((ec = push_block(block, first_height + index)))
-            return false;
-    }
-
-    return true;
-}
-
-bool data_base::pop_above(block_const_ptr_list_ptr blocks,
-    const config::checkpoint& fork_point)
-{
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::pop_above() called";
-
-    code ec;
-    blocks->clear();
-    if ((ec = verify(*blocks_, fork_point, false)))
-        return false;
-
-    size_t top;
-    if (!blocks_->top(top, false))
-        return false;
-
-    const auto fork = fork_point.height();
-    const auto depth = top - fork;
-    blocks->reserve(depth);
-    if (depth == 0)
+    if (blocks->empty())
         return true;
 
-    // Pop all blocks above the fork point.
-    for (size_t height = top; height > fork; --height)
-    {
-        const auto next = std::make_shared<message::block>();
-        if ((ec = pop_block(*next, height)))
-            return false;
-
-        blocks->insert(blocks->begin(), next);
-    }
-
-    return true;
-}
-
-code data_base::push_block( block& block, size_t height)
-{
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::push_block() called";
-
-    code ec;
-    BITCOIN_ASSERT(block.header().metadata.state);
-    auto median_time_past = block.header().metadata.state->median_time_past();
-
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
 
-    if ((ec = verify_push(*blocks_, block, height)))
-        return ec;
+    // The batch is contiguous, so only its first block links to the store.
+    if ((ec = verify_push(*blocks_, *blocks->front(), first_height)))
+        return false;
 
     //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
     conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::push_block error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::push_all begin_write error::store_lock_failure");
 
-        return error::store_lock_failure;
+        return false;
     }
 
-    // Confirm txs (and thereby also address indexes), spend prevouts.
-    uint32_t position = 0;
-    for (const auto& tx: block.transactions())
-        if (!transactions_->confirm(tx.metadata.link, height, median_time_past,
-            position++))
+    hash_list hashes;
+    hashes.reserve(blocks->size());
+
+    // Confirm the txs of each block in order, as each may spend the last.
+    for (size_t index = 0; index < blocks->size(); ++index)
+    {
+         auto& block = *((*blocks)[index]);
+        const auto height = first_height + index;
+        BITCOIN_ASSERT(block.header().metadata.state);
+        const auto median_time_past =
+            block.header().metadata.state->median_time_past();
+
+        // The filter is computed before the block's prevouts are spent.
+        const auto filter = compute_filter(block, height);
+
+        // Confirm txs (and thereby also address indexes), spend prevouts.
+        if (!transactions_->confirm(block.transactions(), height,
+            median_time_past))
         {
             if (!end_write())
             {
-                LOG_VERBOSE(LOG_DATABASE)
-                << this_id
-                << " data_base::push_block confirm end_write error::store_lock_failure";
+                DATABASE_TRACE(
+                    "data_base::push_all confirm end_write error::store_lock_failure");
             }
-            return error::operation_failed;
+            return false;
         }
 
-    // Confirm candidate block (candidate index unchanged).
-    if (!blocks_->index(block.hash(), height, false))
+        if (settings_.index_spends)
+            spends_->index(block.transactions());
+
+        store_filter(block, filter);
+        hashes.push_back(block.hash());
+    }
+
+    // Confirm all candidate blocks in one state and index pass.
+    if (!blocks_->index(hashes, first_height, false, false))
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::push_block index end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::push_all index end_write error::store_lock_failure");
         }
-        return error::operation_failed;
+        return false;
     }
-    
+
+    for (size_t index = 0; index < blocks->size(); ++index)
+        prune(first_height + index);
+
     commit();
 
-    if (end_write())
+    if (!end_write())
     {
-        return error::success;
+        DATABASE_TRACE(
+            "data_base::push_all end_write error::store_lock_failure");
+
+        return false;
     }
-    else
+
+    notify_indexer();
+    return true;
+    //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool data_base::pop_above(block_const_ptr_list_ptr blocks,
+    const config::checkpoint& fork_point)
+{
+    DATABASE_SPAN("data_base::pop_above()");
+    DATABASE_TRACE("data_base::pop_above() called");
+
+    blocks->clear();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
+
+    block_result::list results;
+    if (!read_above(results, fork_point))
+        return false;
+
+    // The blocks are built before their txs are demoted.
+    blocks->reserve(results.size());
+    for (const auto& result: results)
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::push_block end_write error::store_lock_failure";
-        
-        return error::store_lock_failure;
+        const auto next = std::make_shared<message::block>();
+        chain::block& block = *next;
+        block = chain::block(result.header(), to_transactions(result));
+        BITCOIN_ASSERT(block.hash() == result.hash());
+        blocks->push_back(next);
     }
-    //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+
+    return unconfirm_above(results, fork_point);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool data_base::pop_above(block_result::list& results,
+    const config::checkpoint& fork_point)
+{
+    DATABASE_SPAN("data_base::pop_above()");
+    DATABASE_TRACE("data_base::pop_above() called");
+
+    results.clear();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
+
+    return read_above(results, fork_point) &&
+        unconfirm_above(results, fork_point);
     ///////////////////////////////////////////////////////////////////////////
 }
 
 code data_base::pop_block(chain::block& out_block, size_t height)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::pop_block() called";
+    DATABASE_SPAN("data_base::pop_block()");
+    DATABASE_TRACE("data_base::pop_block() called");
 
     code ec;
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(write_mutex_);
+    unique_lock lock(lock_write());
+    write_sequence::scope write(sequence_);
 
     if ((ec = verify_top(*blocks_, height, false)))
         return ec;
@@ -1185,22 +2144,35 @@ code data_base::pop_block(chain::block& out_block, size_t height)
 
     if (!begin_write())
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::pop_block error::store_lock_failure";
+        DATABASE_TRACE("data_base::pop_block error::store_lock_failure");
 
         return error::store_lock_failure;
     }
     
+    // Unwind deferred payment indexing of the block, while still confirmed.
+    size_t indexed;
+    if (deferred() && addresses_->indexed_height(indexed) &&
+        indexed >= height)
+    {
+        transactions_->get_outputs(out_block, height, false);
+        addresses_->unindex(addresses_->extract(out_block.transactions(),
+            height));
+        addresses_->set_indexed_height(height - 1u);
+    }
+
+    // Unindex spends of the txs, while their inputs are readable.
+    if (settings_.index_spends)
+        for (const auto& tx: out_block.transactions())
+            spends_->unindex(tx.metadata.link);
+
     // Deconfirm txs (and thereby also address indexes), unspend prevouts.
     for (const auto& tx: out_block.transactions())
         if (!transactions_->unconfirm(tx.metadata.link))
         {
             if (!end_write())
             {
-                LOG_VERBOSE(LOG_DATABASE)
-                << this_id
-                << " data_base::pop_block unconfirm end_write error::store_lock_failure";
+                DATABASE_TRACE(
+                    "data_base::pop_block unconfirm end_write error::store_lock_failure");
             }
             return error::operation_failed;
         }
@@ -1210,9 +2182,8 @@ code data_base::pop_block(chain::block& out_block, size_t height)
     {
         if (!end_write())
         {
-            LOG_VERBOSE(LOG_DATABASE)
-            << this_id
-            << " data_base::pop_block unindex end_write error::store_lock_failure";
+            DATABASE_TRACE(
+                "data_base::pop_block unindex end_write error::store_lock_failure");
         }
         return error::operation_failed;
     }
@@ -1227,9 +2198,8 @@ code data_base::pop_block(chain::block& out_block, size_t height)
     }
     else
     {
-        LOG_VERBOSE(LOG_DATABASE)
-        << this_id
-        << " data_base::pop_block end_write error::store_lock_failure";
+        DATABASE_TRACE(
+            "data_base::pop_block end_write error::store_lock_failure");
         
         return error::store_lock_failure;
     }
@@ -1239,77 +2209,197 @@ code data_base::pop_block(chain::block& out_block, size_t height)
 
 // Utilities.
 // ----------------------------------------------------------------------------
-// protected
 
-////// TODO: add segwit address indexing.
-////void data_base::push_inputs(const transaction& tx)
-////{
-////    if (tx.is_coinbase())
-////        return;
-////
-////    uint32_t index = 0;
-////    const auto& inputs = tx.inputs();
-////    const auto link = tx.metadata.link;
-////
-////    for (const auto& input: inputs)
-////    {
-////        const auto& prevout = input.previous_output();
-////        const payment_record in{ link, index++, prevout.checksum(), false };
-////
-////        if (prevout.metadata.cache.is_valid())
-////        {
-////            // This results in a complete and unambiguous history for the
-////            // address since standard outputs contain unambiguous address data.
-////            for (const auto& address: prevout.metadata.cache.addresses())
-////                addresses_->store(address.hash(), in);
-////        }
-////        else
-////        {
-////            // For any p2pk spend this creates no record (insufficient data).
-////            // For any p2kh spend this creates the ambiguous p2sh address,
-////            // which significantly expands the size of the history store.
-////            // These are tradeoffs when no prevout is cached (checkpoint sync).
-////            for (const auto& address: input.addresses())
-////                addresses_->store(address.hash(), in);
-////        }
-////    }
-////}
-
-////// TODO: add segwit address indexing.
-////void data_base::push_outputs(const transaction& tx)
-////{
-////    uint32_t index = 0;
-////    const auto& outputs = tx.outputs();
-////    const auto link = tx.metadata.link;
-////
-////    for (const auto& output: outputs)
-////    {
-////        const payment_record out{ link, index++, output.value(), true };
-////
-////        // Standard outputs contain unambiguous address data.
-////        for (const auto& address: output.addresses())
-////            addresses_->store(address.hash(), out);
-////    }
-////}
+// private
+// Prevouts not cached by validation are populated from the store, or from
+// the block itself when spent within the block.
+void data_base::populate_prevouts(const block& block, size_t height) const
+{
+    const auto uncached = [](const transaction& tx)
+    {
+        const auto& inputs = tx.inputs();
+        return !tx.is_coinbase() && std::any_of(inputs.begin(), inputs.end(),
+            [](const input& input)
+            {
+                return !input.previous_output().metadata.cache.is_valid();
+            });
+    };
 
-// Private (assumes valid result links).
-transaction::list data_base::to_transactions(const block_result& result) const
+    const auto& txs = block.transactions();
+    if (std::any_of(txs.begin(), txs.end(), uncached))
+    {
+        transactions_->get_outputs(block, height, false);
+        populate_internal(block);
+    }
+}
+
+// private
+data_chunk data_base::compute_filter(const block& block, size_t height) const
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_VERBOSE(LOG_DATABASE)
-    << this_id
-    << " data_base::to_transactions() called";
+    if (!settings_.index_filters)
+        return {};
 
-    transaction::list txs;
-    txs.reserve(result.transaction_count());
+    populate_prevouts(block, height);
+    return block_filter::compute(block);
+}
+
+// private
+// A filter cannot be stored without that of its previous block.
+void data_base::store_filter(const block& block, const data_chunk& filter)
+{
+    if (!settings_.index_filters)
+        return;
+
+    const auto& header = block.header();
+    if (!filters_->store(block.hash(), header.previous_block_hash(), filter))
+    {
+        LOG_WARNING(LOG_DATABASE)
+            << "Filter of previous block is missing, filter of block ["
+            << encode_hash(block.hash()) << "] not stored.";
+    }
+}
+
+// private
+// Prune the txs spent by the confirmed block buried at the prune depth.
+// The depth must exceed that of any reorganization, as pruned txs read empty.
+// The deferred payment indexer reads the previous outputs of confirmed txs.
+void data_base::prune(size_t height)
+{
+    const auto depth = settings_.transaction_prune_depth;
+
+    if (depth == 0 || deferred() || height < depth)
+        return;
+
+    const auto buried = height - depth;
+    const auto result = blocks_->get(buried, false);
 
+    if (!result)
+        return;
+
+    std::vector<file_offset> links;
     for (const auto link: result)
+        links.push_back(link);
+
+    const auto pruned = transactions_->prune(links, buried);
+
+    if (pruned != 0)
+    {
+        LOG_DEBUG(LOG_DATABASE)
+            << "Pruned " << pruned << " transactions spent at height ["
+            << buried << "].";
+    }
+}
+
+// private
+// The results of the confirmed blocks above the fork point, in height order.
+bool data_base::read_above(block_result::list& out_results,
+    const config::checkpoint& fork_point) const
+{
+    code ec;
+    if ((ec = verify(*blocks_, fork_point, false)))
+        return false;
+
+    size_t top;
+    if (!blocks_->top(top, false))
+        return false;
+
+    const auto fork = fork_point.height();
+    out_results.reserve(top - fork);
+
+    for (auto height = fork + 1u; height <= top; ++height)
+    {
+        auto result = blocks_->get(height, false);
+
+        if (!result)
+            return false;
+
+        out_results.push_back(std::move(result));
+    }
+
+    return true;
+}
+
+// private
+// Deconfirm the blocks from their stored tx links, under one write.
+bool data_base::unconfirm_above(const block_result::list& results,
+    const config::checkpoint& fork_point)
+{
+    if (results.empty())
+        return true;
+
+    std::vector<file_offset> links;
+    for (const auto& result: results)
+        for (const auto link: result)
+            links.push_back(link);
+
+    //vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+    conditional_lock flushlock(flush_each_write(), &flush_lock_mutex_);
+
+    if (!begin_write())
+    {
+        DATABASE_TRACE("data_base::unconfirm_above error::store_lock_failure");
+
+        return false;
+    }
+
+    // Unwind deferred payment indexing of the blocks, while still confirmed.
+    // Only these blocks require their txs, and these are read top down.
+    const auto fork = fork_point.height();
+    size_t indexed;
+    if (deferred() && addresses_->indexed_height(indexed) && indexed > fork)
+    {
+        const auto top = fork + results.size();
+
+        for (auto height = std::min(indexed, top); height > fork; --height)
+        {
+            const auto& result = results[height - fork - 1u];
+            const chain::block block(result.header(), to_transactions(result));
+            transactions_->get_outputs(block, height, false);
+            addresses_->unindex(addresses_->extract(block.transactions(),
+                height));
+        }
+
+        addresses_->set_indexed_height(fork);
+    }
+
+    if (settings_.index_spends)
+        for (const auto link: links)
+            spends_->unindex(link);
+
+    // Deconfirm all txs and unspend their prevouts, then truncate the index.
+    if (!transactions_->unconfirm(links) || !blocks_->unindex_above(fork, false))
+    {
+        if (!end_write())
+        {
+            DATABASE_TRACE(
+                "data_base::unconfirm_above unindex end_write error::store_lock_failure");
+        }
+        return false;
+    }
+
+    commit();
+
+    if (!end_write())
     {
-        const auto tx = transactions_->get(link);
-        BITCOIN_ASSERT(tx);
-        txs.push_back(tx.transaction());
+        DATABASE_TRACE(
+            "data_base::unconfirm_above end_write error::store_lock_failure");
+
+        return false;
     }
 
+    return true;
+    //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+}
+
+// Private (assumes valid result links).
+transaction::list data_base::to_transactions(const block_result& result) const
+{
+    DATABASE_SPAN("data_base::to_transactions()");
+    DATABASE_TRACE("data_base::to_transactions() called");
+
+    // The txs of a stored block are not missing (unless pruned, as empty).
+    transaction::list txs;
+    transactions_->get_transactions(txs, result);
     return txs;
 }
 
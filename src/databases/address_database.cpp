@@ -18,13 +18,18 @@
  */
 #include <bitcoin/database/databases/address_database.hpp>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
+#include <map>
 #include <tuple>
 #include <utility>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/block_filter.hpp>
 #include <bitcoin/database/memory/memory.hpp>
-#include <bitcoin/database/primitives/hash_table_multimap.hpp>
+#include <bitcoin/database/parallel.hpp>
+#include <bitcoin/database/primitives/hash_table_chunked_multimap.hpp>
 
 // Record format (v4/v3) [47 bytes, 71 with key/link]:
 // ----------------------------------------------------------------------------
@@ -39,25 +44,118 @@ namespace database {
 
 using namespace bc::chain;
 
-// Total size of address storage (using tx link vs. hash for point).
-static const auto value_size = payment_record::satoshi_fixed_size(false);
+// Total size of address storage (using tx link vs. hash for point), with
+// the height of indexing so that newest-first traversal can stop early.
+static const auto height_prefix = sizeof(uint32_t);
+static const auto value_size = height_prefix +
+    payment_record::satoshi_fixed_size(false);
+
+// Smaller blocks are not worth the cost of a thread.
+static constexpr size_t minimum_partition = 64;
+
+// The height file holds one height, untracked unless indexing is deferred.
+static constexpr uint64_t untracked = max_uint64;
+static constexpr size_t height_size = sizeof(uint64_t);
+
+// Filter format (appended, a later filter of a range replaces the earlier):
+// ----------------------------------------------------------------------------
+// [ range:4 ][ size:4 ][ filter:size ] (zero size if the range is unfiltered)
+
+// [ received:8 ][ spent:8 ][ transactions:4 ][ height:4 ]
+static constexpr size_t totals_size = 2 * sizeof(uint64_t) +
+    2 * sizeof(uint32_t);
+
+// The balance file holds one placeholder byte until its table is created.
+static constexpr size_t unused_size = 1;
+
+// A range is filtered once buried by this many blocks. A reorganization of a
+// filtered range leaves the range unfiltered, as its hashes are not retained.
+static constexpr size_t filter_depth = 100;
+static constexpr size_t filter_prefix = 2 * sizeof(uint32_t);
+static constexpr size_t incomplete = max_size_t;
+
+// Address hashes are filtered by one key, so that a query is hashed once.
+static uint64_t filter_hash(const short_hash& hash)
+{
+    return block_filter::hash(null_hash, to_chunk(hash));
+}
+
+template <typename Element>
+static address_database::aggregate read_totals(const Element& element)
+{
+    address_database::aggregate totals;
+    element.read([&](byte_deserializer& deserial)
+    {
+        totals.received = deserial.read_8_bytes_little_endian();
+        totals.spent = deserial.read_8_bytes_little_endian();
+        totals.transactions = deserial.read_4_bytes_little_endian();
+        totals.height = deserial.read_4_bytes_little_endian();
+    });
+
+    return totals;
+}
+
+static void write_totals(byte_serializer& serial,
+    const address_database::aggregate& totals)
+{
+    serial.write_8_bytes_little_endian(totals.received);
+    serial.write_8_bytes_little_endian(totals.spent);
+    serial.write_4_bytes_little_endian(totals.transactions);
+    serial.write_4_bytes_little_endian(totals.height);
+}
+
+const size_t address_database::unconfirmed = max_uint32;
+const uint64_t address_database::not_found = max_uint64;
+const uint64_t address_database::unvalued = max_uint64;
 
 // History uses a hash table index, O(1).
 // The hash table stores indexes to the first element of unkeyed linked lists.
 address_database::address_database(const path& lookup_filename,
-    const path& rows_filename, size_t buckets, size_t expansion)
-  : hash_table_file_(lookup_filename, expansion),
+    const path& rows_filename, const path& height_filename,
+    const path& balances_filename, const path& filters_filename,
+    size_t buckets, size_t balance_buckets, size_t filter_range,
+    size_t expansion, size_t reservation, storage_backend backend)
+  : hash_table_file_(storage::factory(backend, lookup_filename,
+        expansion, reservation)),
+
+    // THIS sizeof(link_type) IS ASSUMED BY hash_table_chunked_multimap.
+    hash_table_(*hash_table_file_, buckets,
+        sizeof(record_multimap::link_type)),
+
+    // Chunked-list storage for multimap.
+    address_index_file_(storage::factory(backend, rows_filename,
+        expansion, reservation)),
+    address_index_(*address_index_file_, 0),
 
-    // THIS sizeof(link_type) IS ASSUMED BY hash_table_multimap.
-    hash_table_(hash_table_file_, buckets, sizeof(link_type)),
+    address_multimap_(hash_table_, address_index_, value_size),
 
-    // Linked-list storage for multimap.
-    address_index_file_(rows_filename, expansion),
-    address_index_(address_index_file_, 0,
-        hash_table_multimap<key_type, index_type, link_type>::size(value_size)),
+    // Indexed height.
+    height_file_(storage::factory(backend, height_filename,
+        file_storage::default_expansion)),
+    height_(untracked),
 
-    address_multimap_(hash_table_, address_index_)
+    // Totals by address hash (the file remains closed unless enabled).
+    balances_enabled_(balance_buckets != 0),
+    balance_file_(storage::factory(backend, balances_filename, expansion)),
+    balances_(*balance_file_, balance_buckets, totals_size),
+
+    // Filters by range of blocks (the file remains closed unless enabled).
+    filters_enabled_(filter_range != 0),
+    filter_range_(filter_range),
+    filter_file_(storage::factory(backend, filters_filename, expansion)),
+    filters_(*filter_file_, 0),
+    complete_range_(incomplete),
+    top_height_(0),
+    threads_(1)
 {
+    hash_table_file_->enable_metrics(metrics_);
+    address_index_file_->enable_metrics(metrics_);
+    height_file_->enable_metrics(metrics_);
+    balance_file_->enable_metrics(metrics_);
+    filter_file_->enable_metrics(metrics_);
+    hash_table_.enable_metrics(metrics_);
+    address_index_.enable_metrics(metrics_);
+    balances_.enable_metrics(metrics_);
 }
 
 address_database::~address_database()
@@ -70,10 +168,26 @@ address_database::~address_database()
 
 bool address_database::create()
 {
-    if (!hash_table_file_.open() ||
-        !address_index_file_.open())
+    if (!hash_table_file_->open() ||
+        !address_index_file_->open() ||
+        !height_file_->open())
+        return false;
+
+    write_height(untracked);
+
+    if (balances_enabled_ &&
+        (!balance_file_->open() || !balances_.create()))
         return false;
 
+    // A new store indexes every payment, so every range is complete.
+    if (filters_enabled_)
+    {
+        if (!filter_file_->open() || !filters_.create())
+            return false;
+
+        complete_range_ = 0;
+    }
+
     // No need to call open after create.
     return
         hash_table_.create() &&
@@ -82,9 +196,82 @@ bool address_database::create()
 
 bool address_database::open()
 {
+    if (!hash_table_file_->open() ||
+        !address_index_file_->open() ||
+        !height_file_->open())
+        return false;
+
+    // A height file without a height was added to an existing store.
+    if (height_file_->size() < height_size)
+    {
+        write_height(untracked);
+    }
+    else
+    {
+        const auto memory = height_file_->access();
+        auto deserial = make_unsafe_deserializer(memory->buffer());
+        height_ = deserial.read_8_bytes_little_endian();
+    }
+
+    if (balances_enabled_)
+    {
+        if (!balance_file_->open())
+            return false;
+
+        // Balances enabled on an existing store cover only new payments.
+        if (balance_file_->size() <= unused_size)
+        {
+            if (!balances_.create())
+                return false;
+        }
+        else if (!balances_.start())
+        {
+            return false;
+        }
+    }
+
+    // The hashes of the range open at last close are lost, so the ranges
+    // through that of the next payment are unfiltered (see add_filters).
+    if (filters_enabled_)
+    {
+        if (!filter_file_->open())
+            return false;
+
+        if (filter_file_->size() <= unused_size)
+        {
+            if (!filters_.create())
+                return false;
+        }
+        else if (!filters_.start() || !read_filters())
+        {
+            return false;
+        }
+    }
+
+    return
+        hash_table_.start() &&
+        address_index_.start();
+}
+
+bool address_database::refresh()
+{
+    if (!hash_table_file_->refresh() ||
+        !address_index_file_->refresh() ||
+        !height_file_->refresh() ||
+        (balances_enabled_ && !balance_file_->refresh()) ||
+        (filters_enabled_ && !filter_file_->refresh()))
+        return false;
+
+    if (height_file_->size() >= height_size)
+    {
+        const auto memory = height_file_->access();
+        auto deserial = make_unsafe_deserializer(memory->buffer());
+        height_ = deserial.read_8_bytes_little_endian();
+    }
+
     return
-        hash_table_file_.open() &&
-        address_index_file_.open() &&
+        (!balances_enabled_ || balances_.start()) &&
+        (!filters_enabled_ || (filters_.start() && read_filters())) &&
         hash_table_.start() &&
         address_index_.start();
 }
@@ -93,20 +280,115 @@ void address_database::commit()
 {
     hash_table_.commit();
     address_index_.commit();
+
+    if (balances_enabled_)
+        balances_.commit();
+
+    if (filters_enabled_)
+        filters_.commit();
 }
 
 bool address_database::flush() const
 {
     return
-        hash_table_file_.flush() &&
-        address_index_file_.flush();
+        hash_table_file_->flush() &&
+        address_index_file_->flush() &&
+        height_file_->flush() &&
+        balance_file_->flush() &&
+        filter_file_->flush();
+}
+
+bool address_database::flush_dirty() const
+{
+    return
+        hash_table_file_->flush_dirty() &&
+        address_index_file_->flush_dirty() &&
+        height_file_->flush_dirty() &&
+        balance_file_->flush_dirty() &&
+        filter_file_->flush_dirty();
+}
+
+void address_database::enable_journal()
+{
+    hash_table_file_->enable_journal();
+    address_index_file_->enable_journal();
+    height_file_->enable_journal();
+    balance_file_->enable_journal();
+    filter_file_->enable_journal();
+}
+
+void address_database::enable_advice(const map_advice& advice)
+{
+    hash_table_file_->enable_advice(advice, hash_table_.header_size());
+    address_index_file_->enable_advice(advice, 0);
+    height_file_->enable_advice(advice, 0);
+    balance_file_->enable_advice(advice, 0);
+    filter_file_->enable_advice(advice, 0);
+}
+
+void address_database::enable_file_growth(const file_growth& growth)
+{
+    hash_table_file_->enable_growth(growth);
+    address_index_file_->enable_growth(growth);
+    height_file_->enable_growth(growth);
+    balance_file_->enable_growth(growth);
+    filter_file_->enable_growth(growth);
+}
+
+void address_database::pregrow()
+{
+    hash_table_file_->pregrow();
+    address_index_file_->pregrow();
+    height_file_->pregrow();
+    balance_file_->pregrow();
+    filter_file_->pregrow();
+}
+
+bool address_database::log_writes(commit_log& log)
+{
+    return
+        hash_table_file_->log_writes(log) &&
+        address_index_file_->log_writes(log) &&
+        height_file_->log_writes(log) &&
+        balance_file_->log_writes(log) &&
+        filter_file_->log_writes(log);
+}
+
+table_metrics::values address_database::metrics() const
+{
+    auto values = metrics_.get();
+    storage::footprint(values, *hash_table_file_);
+    storage::footprint(values, *address_index_file_);
+    storage::footprint(values, *height_file_);
+    storage::footprint(values, *balance_file_);
+    storage::footprint(values, *filter_file_);
+    return values;
+}
+
+void address_database::enable_growth(size_t load_percent)
+{
+    hash_table_.enable_growth(load_percent);
+    balances_.enable_growth(load_percent);
+}
+
+float address_database::load_factor() const
+{
+    return hash_table_.load_factor();
+}
+
+void address_database::enable_parallel(size_t threads)
+{
+    threads_ = parallelism(threads);
 }
 
 bool address_database::close()
 {
     return
-        hash_table_file_.close() &&
-        address_index_file_.close();
+        hash_table_file_->close() &&
+        address_index_file_->close() &&
+        height_file_->close() &&
+        balance_file_->close() &&
+        filter_file_->close();
 }
 
 // Queries.
@@ -118,22 +400,644 @@ address_result address_database::get(const short_hash& hash) const
     return { address_multimap_.find(hash), hash };
 }
 
+// The cursor is not validated, it must be a link returned by this query.
+address_result address_database::get(const short_hash& hash,
+    size_t from_height, size_t limit, uint64_t cursor) const
+{
+    const auto element = cursor == not_found ? address_multimap_.find(hash) :
+        address_multimap_.element(cursor);
+
+    return { element, hash, from_height, limit };
+}
+
+// The rows of each hash are newest first, so the histories are merged by
+// taking the newest current row of any hash until the limit is reached.
+address_database::history_rows address_database::get(
+    const std::vector<short_hash>& hashes, size_t from_height,
+    size_t limit) const
+{
+    typedef std::pair<size_t, short_hash> keyed;
+    std::vector<keyed> keys;
+    keys.reserve(hashes.size());
+
+    for (const auto& hash: hashes)
+    {
+        keys.emplace_back(hash_table_.bucket(hash), hash);
+        hash_table_.prefetch(hash);
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<address_result> results;
+    results.reserve(keys.size());
+
+    for (const auto& key: keys)
+        results.emplace_back(address_multimap_.find(key.second), key.second,
+            from_height, limit);
+
+    std::vector<address_iterator> cursors;
+    cursors.reserve(results.size());
+
+    // The heap holds the index of each cursor that is not at its end.
+    std::vector<size_t> heap;
+    heap.reserve(results.size());
+
+    for (size_t index = 0; index < results.size(); ++index)
+    {
+        cursors.push_back(results[index].begin());
+
+        if (cursors.back() != results[index].end())
+            heap.push_back(index);
+    }
+
+    // Newer rows first, and rows of the same height in order of key.
+    const auto older = [&](size_t left, size_t right)
+    {
+        const auto left_height = (*cursors[left]).height();
+        const auto right_height = (*cursors[right]).height();
+        return left_height < right_height ||
+            (left_height == right_height && left > right);
+    };
+
+    std::make_heap(heap.begin(), heap.end(), older);
+
+    history_rows out;
+    while (!heap.empty() && out.size() < limit)
+    {
+        std::pop_heap(heap.begin(), heap.end(), older);
+        const auto index = heap.back();
+        auto& cursor = cursors[index];
+        out.push_back({ results[index].hash(), *cursor });
+
+        if (++cursor == results[index].end())
+            heap.pop_back();
+        else
+            std::push_heap(heap.begin(), heap.end(), older);
+    }
+
+    return out;
+}
+
+bool address_database::get(aggregate& out_totals,
+    const short_hash& hash) const
+{
+    if (!balances_enabled_)
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(balance_mutex_);
+
+    const auto element = balances_.find(hash);
+
+    if (!element)
+        return false;
+
+    out_totals = read_totals(element);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool address_database::indexed_height(size_t& out_height) const
+{
+    const uint64_t height = height_;
+
+    if (height == untracked)
+        return false;
+
+    out_height = static_cast<size_t>(height);
+    return true;
+}
+
+size_t address_database::filtered_height() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(filter_mutex_);
+    return filter_slabs_.size() * filter_range_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Each range is tested for all of the hashes in one pass of its filter, and
+// the ranges are tested concurrently. Written filters are not modified.
+address_database::heights address_database::match(
+    const std::vector<short_hash>& hashes, size_t from_height) const
+{
+    if (!filters_enabled_ || hashes.empty())
+        return {};
+
+    std::vector<uint64_t> values;
+    values.reserve(hashes.size());
+
+    for (const auto& hash: hashes)
+        values.push_back(filter_hash(hash));
+
+    std::sort(values.begin(), values.end());
+
+    std::vector<filter_slab> slabs;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(filter_mutex_);
+        slabs = filter_slabs_;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto first = from_height / filter_range_;
+
+    if (first >= slabs.size())
+        return {};
+
+    const auto count = slabs.size() - first;
+    std::vector<uint8_t> matched(count, 0);
+
+    const auto tester = [&](size_t begin, size_t end)
+    {
+        for (auto index = begin; index < end; ++index)
+        {
+            const auto& slab = slabs[first + index];
+
+            if (slab.size == 0)
+            {
+                matched[index] = 1;
+                continue;
+            }
+
+            // The accessor must remain in scope until the end of the block.
+            const auto memory = filters_.get(slab.position);
+            const auto filter = memory->buffer() + filter_prefix;
+            matched[index] = block_filter::match({ filter,
+                filter + slab.size }, values);
+        }
+    };
+
+    parallel_for(count, threads_, minimum_partition, tester);
+
+    heights out;
+    for (size_t index = 0; index < count; ++index)
+        if (matched[index] != 0)
+            out.push_back((first + index) * filter_range_);
+
+    return out;
+}
+
 // Store.
 // ----------------------------------------------------------------------------
 
 // Confirmation of payment is dynamically derived from current tx state.
-void address_database::index( chain::transaction& tx)
-{
-    // TODO: loop over payments, relying only on output scripts, adding rows.
-    ////const auto writer = [&](byte_serializer& serial)
-    ////{
-    ////    payment.to_data(serial, false);
-    ////};
-
-    ////// Write the new payment history.
-    ////auto next = address_multimap_.allocator();
-    ////next.create(writer);
-    ////address_multimap_.link(hash, next);
+void address_database::index(const transaction& tx)
+{
+    payments rows;
+    extract(rows, tx, unconfirmed);
+    index(rows);
+}
+
+// Existing transactions were indexed when first stored.
+void address_database::index(const transaction::list& transactions,
+    size_t height)
+{
+    index(extract(transactions, height, false));
+}
+
+address_database::payments address_database::extract(
+    const transaction::list& transactions, size_t height) const
+{
+    return extract(transactions, height, true);
+}
+
+// Rows are removed newest first, so this reverses the indexing of payments
+// that were the last indexed. A row that does not match is left in place.
+void address_database::unindex(const payments& payments)
+{
+    // The totals removed by address hash, with the link of the last row.
+    std::map<short_hash, std::pair<aggregate, file_offset>> removed;
+
+    for (auto it = payments.rbegin(); it != payments.rend(); ++it)
+    {
+        const auto head = address_multimap_.find(it->hash);
+
+        if (!head)
+            continue;
+
+        payment_record row;
+        head.read([&](byte_deserializer& deserial)
+        {
+            deserial.skip(height_prefix);
+            row.from_data(deserial, false);
+        });
+
+        const auto& payment = it->record;
+        if (row.link() != payment.link() || row.index() != payment.index() ||
+            row.is_output() != payment.is_output())
+            continue;
+
+        address_multimap_.unlink(it->hash);
+
+        if (!balances_enabled_ || it->value == unvalued)
+            continue;
+
+        auto& entry = removed.emplace(it->hash, std::make_pair(
+            aggregate{ 0, 0, 0, 0 }, transaction::validation::unlinked))
+            .first->second;
+
+        auto& totals = entry.first;
+        (payment.is_output() ? totals.received : totals.spent) += it->value;
+
+        if (payment.link() != entry.second)
+            ++totals.transactions;
+
+        entry.second = payment.link();
+    }
+
+    for (const auto& entry: removed)
+        subtract_totals(entry.first, entry.second.first);
+}
+
+void address_database::set_indexed_height(size_t height)
+{
+    write_height(height);
+}
+
+void address_database::reset_indexed_height()
+{
+    write_height(untracked);
+}
+
+// private
+// TODO: add segwit address indexing.
+void address_database::extract(payments& out, const transaction& tx,
+    size_t height)
+{
+    const auto link = tx.metadata.link;
+
+    if (!tx.is_coinbase())
+    {
+        uint32_t index = 0;
+        for (const auto& input: tx.inputs())
+        {
+            const auto& prevout = input.previous_output();
+            payment_record in{ link, index++, prevout.checksum(), false };
+            in.set_height(height);
+
+            // This results in a complete and unambiguous history for the
+            // address since standard outputs contain unambiguous address data.
+            // For any p2pk spend without a cached prevout this creates no
+            // record, and for any p2kh spend it creates the ambiguous p2sh
+            // address (checkpoint sync tradeoffs).
+            const auto addresses = prevout.metadata.cache.is_valid() ?
+                prevout.metadata.cache.addresses() : input.addresses();
+
+            // The row is kept, but its value is excluded from the totals.
+            const auto value = prevout.metadata.cache.is_valid() ?
+                prevout.metadata.cache.value() : unvalued;
+
+            for (const auto& address: addresses)
+                out.push_back({ address.hash(), in, value });
+        }
+    }
+
+    uint32_t index = 0;
+    for (const auto& output: tx.outputs())
+    {
+        payment_record out_payment{ link, index++, output.value(), true };
+        out_payment.set_height(height);
+
+        // Standard outputs contain unambiguous address data.
+        for (const auto& address: output.addresses())
+            out.push_back({ address.hash(), out_payment, output.value() });
+    }
+}
+
+// Rows are grouped by key, so that each key is linked once with its rows
+// appended to its chunks in order.
+void address_database::index(const payments& payments)
+{
+    const auto count = payments.size();
+
+    if (count == 0)
+        return;
+
+    if (filters_enabled_)
+        add_filters(payments);
+
+    // Group rows by key, preserving order within each key.
+    std::vector<size_t> order(count);
+    for (size_t index = 0; index < count; ++index)
+        order[index] = index;
+
+    const auto by_key = [&](size_t left, size_t right)
+    {
+        return payments[left].hash < payments[right].hash;
+    };
+
+    std::stable_sort(order.begin(), order.end(), by_key);
+
+    for (size_t first = 0, last = 0; first < count; first = last)
+    {
+        const auto& key = payments[order[first]].hash;
+        for (last = first + 1u; last < count &&
+            payments[order[last]].hash == key; ++last);
+
+        const auto writer = [&](byte_serializer& serial, size_t row)
+        {
+            const auto& payment = payments[order[first + row]].record;
+            serial.write_4_bytes_little_endian(
+                static_cast<uint32_t>(payment.height()));
+            payment.to_data(serial, false);
+        };
+
+        address_multimap_.link(key, last - first, writer);
+
+        if (!balances_enabled_)
+            continue;
+
+        // The rows of a transaction are adjacent within the rows of a key.
+        aggregate totals{ 0, 0, 0, 0 };
+        auto link = transaction::validation::unlinked;
+
+        for (auto row = first; row < last; ++row)
+        {
+            const auto& payment = payments[order[row]];
+            const auto& record = payment.record;
+
+            if (payment.value == unvalued)
+                continue;
+
+            (record.is_output() ? totals.received : totals.spent) +=
+                payment.value;
+
+            if (record.link() != link)
+                ++totals.transactions;
+
+            if (record.height() != unconfirmed)
+                totals.height = std::max(totals.height,
+                    static_cast<uint32_t>(record.height()));
+
+            link = record.link();
+        }
+
+        // A key of only unvalued rows has no totals.
+        if (totals.transactions != 0)
+            add_totals(key, totals);
+    }
+}
+
+// private
+void address_database::write_height(uint64_t height)
+{
+    // The accessor must remain in scope until the end of the block.
+    const auto memory = height_file_->reserve(height_size);
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_little_endian(height);
+    height_file_->journal(0, height_size);
+    height_ = height;
+}
+
+// private
+void address_database::add_totals(const short_hash& hash,
+    const aggregate& totals)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(balance_mutex_);
+    const auto element = balances_.find(hash);
+
+    if (!element)
+    {
+        auto next = balances_.allocator();
+        next.create(hash, [&](byte_serializer& serial)
+        {
+            write_totals(serial, totals);
+        });
+
+        balances_.link(next);
+        return;
+    }
+
+    auto current = read_totals(element);
+    current.received = ceiling_add(current.received, totals.received);
+    current.spent = ceiling_add(current.spent, totals.spent);
+    current.transactions = ceiling_add(current.transactions,
+        totals.transactions);
+    current.height = std::max(current.height, totals.height);
+
+    element.write([&](byte_serializer& serial)
+    {
+        write_totals(serial, current);
+    });
+
+    element.journal(0, totals_size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// The height becomes that of the newest remaining confirmed row, or zero.
+void address_database::subtract_totals(const short_hash& hash,
+    const aggregate& totals)
+{
+    uint32_t height = unconfirmed;
+    for (auto row = address_multimap_.find(hash);
+        row && height == unconfirmed; row.jump_next())
+    {
+        row.read([&](byte_deserializer& deserial)
+        {
+            height = deserial.read_4_bytes_little_endian();
+        });
+    }
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(balance_mutex_);
+    const auto element = balances_.find(hash);
+
+    if (!element)
+        return;
+
+    auto current = read_totals(element);
+    current.received = floor_subtract(current.received, totals.received);
+    current.spent = floor_subtract(current.spent, totals.spent);
+    current.transactions = floor_subtract(current.transactions,
+        totals.transactions);
+    current.height = height == unconfirmed ? 0 : height;
+
+    element.write([&](byte_serializer& serial)
+    {
+        write_totals(serial, current);
+    });
+
+    element.journal(0, totals_size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// A range is filtered when a payment is first indexed at the filter depth
+// above it. Hashes are compacted as their buffer fills, as there are usually
+// many payments to each address hash within a range.
+void address_database::add_filters(const payments& payments)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(filter_mutex_);
+
+    for (const auto& payment: payments)
+    {
+        const size_t height = payment.record.height();
+
+        if (height == unconfirmed)
+            continue;
+
+        const auto range = height / filter_range_;
+
+        // The first payment of an opened store may follow payments of its
+        // range that were indexed before it was opened.
+        if (complete_range_ == incomplete)
+            complete_range_ = range + 1u;
+
+        if (range < filter_slabs_.size())
+        {
+            if (filter_slabs_[range].size != 0)
+                write_filter(range, {});
+
+            continue;
+        }
+
+        auto& hashes = pending_[range];
+
+        if (!hashes.empty() && hashes.size() == hashes.capacity())
+        {
+            std::sort(hashes.begin(), hashes.end());
+            hashes.erase(std::unique(hashes.begin(), hashes.end()),
+                hashes.end());
+        }
+
+        hashes.push_back(filter_hash(payment.hash));
+        top_height_ = std::max(top_height_, height);
+    }
+
+    for (auto range = filter_slabs_.size(); (range + 1u) * filter_range_ +
+        filter_depth <= top_height_; range = filter_slabs_.size())
+    {
+        const auto it = pending_.find(range);
+
+        if (range < complete_range_)
+        {
+            write_filter(range, {});
+        }
+        else if (it == pending_.end())
+        {
+            std::vector<uint64_t> none;
+            write_filter(range, block_filter::encode(none));
+        }
+        else
+        {
+            auto& hashes = it->second;
+            std::sort(hashes.begin(), hashes.end());
+            hashes.erase(std::unique(hashes.begin(), hashes.end()),
+                hashes.end());
+            write_filter(range, block_filter::encode(hashes));
+        }
+
+        if (it != pending_.end())
+            pending_.erase(it);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// An empty filter marks the range as unfiltered.
+void address_database::write_filter(size_t range, const data_chunk& filter)
+{
+    BITCOIN_ASSERT(range <= max_uint32);
+    BITCOIN_ASSERT(filter.size() <= max_uint32);
+
+    const auto size = static_cast<uint32_t>(filter.size());
+    const auto position = filters_.allocate(filter_prefix + size);
+
+    // The accessor must remain in scope until the end of the block.
+    {
+        const auto memory = filters_.get(position);
+        auto serial = make_unsafe_serializer(memory->buffer());
+        serial.write_4_bytes_little_endian(static_cast<uint32_t>(range));
+        serial.write_4_bytes_little_endian(size);
+        serial.write_bytes(filter);
+    }
+
+    if (range == filter_slabs_.size())
+        filter_slabs_.push_back({ position, size });
+    else
+        filter_slabs_[range] = { position, size };
+}
+
+// private
+// The filters are few (one per range of blocks), so are read in one pass.
+bool address_database::read_filters()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(filter_mutex_);
+    filter_slabs_.clear();
+
+    const auto end = filters_.payload_size();
+    for (file_offset position = sizeof(file_offset); position < end;)
+    {
+        if (position + filter_prefix > end)
+            return false;
+
+        uint32_t range;
+        uint32_t size;
+
+        // The accessor must remain in scope until the end of the block.
+        {
+            const auto memory = filters_.get(position);
+            auto deserial = make_unsafe_deserializer(memory->buffer());
+            range = deserial.read_4_bytes_little_endian();
+            size = deserial.read_4_bytes_little_endian();
+        }
+
+        if (range > filter_slabs_.size())
+            return false;
+
+        if (range == filter_slabs_.size())
+            filter_slabs_.push_back({ position, size });
+        else
+            filter_slabs_[range] = { position, size };
+
+        position += filter_prefix + size;
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+address_database::payments address_database::extract(
+    const transaction::list& transactions, size_t height, bool existed) const
+{
+    const auto count = transactions.size();
+    std::vector<payments> extracted(count);
+
+    const auto extractor = [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+            if (existed || !transactions[index].metadata.existed)
+                extract(extracted[index], transactions[index], height);
+    };
+
+    parallel_for(count, threads_, minimum_partition, extractor);
+
+    size_t total = 0;
+    for (const auto& rows: extracted)
+        total += rows.size();
+
+    payments rows;
+    rows.reserve(total);
+
+    for (const auto& tx_rows: extracted)
+        rows.insert(rows.end(), tx_rows.begin(), tx_rows.end());
+
+    return rows;
 }
 
 } // namespace database
@@ -18,14 +18,21 @@
  */
 #include <bitcoin/database/databases/block_database.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
+#include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/block_record.hpp>
 #include <bitcoin/database/block_state.hpp>
 #include <bitcoin/database/databases/transaction_database.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/manifest.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/parallel.hpp>
 #include <bitcoin/database/primitives/list_element.hpp>
 #include <bitcoin/database/result/block_result.hpp>
 
@@ -54,43 +61,101 @@ namespace database {
 
 using namespace bc::chain;
 
-static const auto header_size = header::satoshi_fixed_size();
-static constexpr auto median_time_past_size = sizeof(uint32_t);
-static constexpr auto height_size = sizeof(uint32_t);
-static constexpr auto state_size = sizeof(uint8_t);
-static constexpr auto checksum_size = sizeof(uint32_t);
-static constexpr auto tx_start_size = sizeof(uint32_t);
-static constexpr auto tx_count_size = sizeof(uint16_t);
+static constexpr auto state_size = sizeof(block_record::state);
+static constexpr auto checksum_size = sizeof(block_record::checksum);
+static constexpr auto tx_start_size = sizeof(block_record::tx_start);
+static constexpr auto tx_count_size = sizeof(block_record::tx_count);
 
-static const auto height_offset = header_size + median_time_past_size;
-static const auto state_offset = height_offset + height_size;
-static const auto checksum_offset = state_offset + state_size;
-static const auto transactions_offset = checksum_offset + checksum_size;
+static constexpr auto height_offset = block_record_height_offset;
+static constexpr auto state_offset = block_record_state_offset;
+static constexpr auto checksum_offset = block_record_checksum_offset;
+static constexpr auto transactions_offset = block_record_transactions_offset;
+
+// The fewest heights verified by one thread of a repair.
+static constexpr size_t minimum_partition = 64;
+
+// Manifest names of the header caches.
+static const std::string candidate_headers_name = "candidate_headers";
+static const std::string confirmed_headers_name = "confirmed_headers";
 
 // Total size of block header and metadata storage.
-static const auto block_size = header_size + median_time_past_size +
-    height_size + state_size + checksum_size + tx_start_size + tx_count_size;
+static constexpr auto block_size = sizeof(block_record);
+
+// The merkle root of the transaction hashes (as of the block).
+static hash_digest merkle_root(hash_list&& hashes)
+{
+    if (hashes.empty())
+        return null_hash;
+
+    while (hashes.size() > 1u)
+    {
+        // An odd row is completed with a copy of its last hash.
+        if (hashes.size() % 2u != 0u)
+            hashes.push_back(hashes.back());
+
+        for (size_t row = 0, pair = 0; pair < hashes.size(); ++row, pair += 2)
+            hashes[row] = bitcoin_hash(splice(hashes[pair], hashes[pair + 1]));
+
+        hashes.resize(hashes.size() / 2u);
+    }
+
+    return hashes.front();
+}
+
+// The cached values of the header of the block result.
+static cached_header summarize(const block_result& result)
+{
+    const auto& header = result.header();
+    return
+    {
+        result.hash(),
+        header.bits(),
+        header.timestamp(),
+        header.version(),
+        result.median_time_past(),
+        static_cast<uint32_t>(result.height()),
+        result.state()
+    };
+}
 
 // Blocks uses a hash table and two array indexes, all O(1).
 // The block database keys off of block hash and has block value.
 block_database::block_database(const path& map_filename,
     const path& candidate_index_filename, const path& confirmed_index_filename,
-    const path& tx_index_filename, size_t buckets, size_t expansion)
-  : hash_table_file_(map_filename, expansion),
-    hash_table_(hash_table_file_, buckets, block_size),
+    const path& tx_index_filename, size_t buckets, size_t expansion,
+    size_t reservation, size_t header_cache_capacity,
+    storage_backend backend)
+  : hash_table_file_(storage::factory(backend, map_filename,
+        expansion, reservation)),
+    hash_table_(*hash_table_file_, buckets, block_size),
 
     // Array storage.
-    candidate_index_file_(candidate_index_filename, expansion),
-    candidate_index_(candidate_index_file_, 0, sizeof(link_type)),
+    candidate_index_file_(storage::factory(backend, candidate_index_filename,
+        expansion, reservation)),
+    candidate_index_(*candidate_index_file_, 0, sizeof(link_type)),
 
     // Array storage.
-    confirmed_index_file_(confirmed_index_filename, expansion),
-    confirmed_index_(confirmed_index_file_, 0, sizeof(link_type)),
+    confirmed_index_file_(storage::factory(backend, confirmed_index_filename,
+        expansion, reservation)),
+    confirmed_index_(*confirmed_index_file_, 0, sizeof(link_type)),
 
     // Array storage.
-    tx_index_file_(tx_index_filename, expansion),
-    tx_index_(tx_index_file_, 0, sizeof(file_offset))
+    tx_index_file_(storage::factory(backend, tx_index_filename,
+        expansion, reservation)),
+    tx_index_(*tx_index_file_, 0, sizeof(file_offset)),
+
+    // Header caches.
+    candidate_headers_(header_cache_capacity),
+    confirmed_headers_(header_cache_capacity)
 {
+    hash_table_file_->enable_metrics(metrics_);
+    candidate_index_file_->enable_metrics(metrics_);
+    confirmed_index_file_->enable_metrics(metrics_);
+    tx_index_file_->enable_metrics(metrics_);
+    hash_table_.enable_metrics(metrics_);
+    candidate_index_.enable_metrics(metrics_);
+    confirmed_index_.enable_metrics(metrics_);
+    tx_index_.enable_metrics(metrics_);
 }
 
 block_database::~block_database()
@@ -103,10 +168,10 @@ block_database::~block_database()
 
 bool block_database::create()
 {
-    if (!hash_table_file_.open() ||
-        !candidate_index_file_.open() ||
-        !confirmed_index_file_.open() ||
-        !tx_index_file_.open())
+    if (!hash_table_file_->open() ||
+        !candidate_index_file_->open() ||
+        !confirmed_index_file_->open() ||
+        !tx_index_file_->open())
         return false;
 
     // No need to call open after create.
@@ -118,12 +183,49 @@ bool block_database::create()
 }
 
 bool block_database::open()
+{
+    return open(manifest(manifest::path()));
+}
+
+bool block_database::open(const manifest& clean)
+{
+    const auto opened =
+        hash_table_file_->open() &&
+        candidate_index_file_->open() &&
+        confirmed_index_file_->open() &&
+        tx_index_file_->open() &&
+
+        hash_table_.start() &&
+        candidate_index_.start() &&
+        confirmed_index_.start() &&
+        tx_index_.start();
+
+    if (!opened)
+        return false;
+
+    if (!restore(candidate_headers_, true, clean))
+        warm(candidate_headers_, true);
+
+    if (!restore(confirmed_headers_, false, clean))
+        warm(confirmed_headers_, false);
+
+    return true;
+}
+
+void block_database::save(manifest& clean) const
+{
+    clean.set(candidate_headers_name, candidate_headers_.to_data());
+    clean.set(confirmed_headers_name, confirmed_headers_.to_data());
+}
+
+// Header caches are not refreshed, so a secondary should disable them.
+bool block_database::refresh()
 {
     return
-        hash_table_file_.open() &&
-        candidate_index_file_.open() &&
-        confirmed_index_file_.open() &&
-        tx_index_file_.open() &&
+        hash_table_file_->refresh() &&
+        candidate_index_file_->refresh() &&
+        confirmed_index_file_->refresh() &&
+        tx_index_file_->refresh() &&
 
         hash_table_.start() &&
         candidate_index_.start() &&
@@ -142,19 +244,84 @@ void block_database::commit()
 bool block_database::flush() const
 {
     return
-        hash_table_file_.flush() &&
-        candidate_index_file_.flush() &&
-        confirmed_index_file_.flush() &&
-        tx_index_file_.flush();
+        hash_table_file_->flush() &&
+        candidate_index_file_->flush() &&
+        confirmed_index_file_->flush() &&
+        tx_index_file_->flush();
+}
+
+bool block_database::flush_dirty() const
+{
+    return
+        hash_table_file_->flush_dirty() &&
+        candidate_index_file_->flush_dirty() &&
+        confirmed_index_file_->flush_dirty() &&
+        tx_index_file_->flush_dirty();
+}
+
+void block_database::enable_journal()
+{
+    hash_table_file_->enable_journal();
+    candidate_index_file_->enable_journal();
+    confirmed_index_file_->enable_journal();
+    tx_index_file_->enable_journal();
+}
+
+void block_database::enable_advice(const map_advice& table,
+    const map_advice& index)
+{
+    hash_table_file_->enable_advice(table, hash_table_.header_size());
+    candidate_index_file_->enable_advice(index, 0);
+    confirmed_index_file_->enable_advice(index, 0);
+    tx_index_file_->enable_advice(index, 0);
+}
+
+void block_database::enable_file_growth(const file_growth& growth)
+{
+    hash_table_file_->enable_growth(growth);
+    candidate_index_file_->enable_growth(growth);
+    confirmed_index_file_->enable_growth(growth);
+    tx_index_file_->enable_growth(growth);
+}
+
+void block_database::pregrow()
+{
+    hash_table_file_->pregrow();
+    candidate_index_file_->pregrow();
+    confirmed_index_file_->pregrow();
+    tx_index_file_->pregrow();
+}
+
+bool block_database::log_writes(commit_log& log)
+{
+    return
+        hash_table_file_->log_writes(log) &&
+        candidate_index_file_->log_writes(log) &&
+        confirmed_index_file_->log_writes(log) &&
+        tx_index_file_->log_writes(log);
+}
+
+table_metrics::values block_database::metrics() const
+{
+    auto values = metrics_.get();
+    values.lock_wait_ns = metadata_lock_.wait_ns();
+    storage::footprint(values, *hash_table_file_);
+    storage::footprint(values, *candidate_index_file_);
+    storage::footprint(values, *confirmed_index_file_);
+    storage::footprint(values, *tx_index_file_);
+    return values;
 }
 
 bool block_database::close()
 {
+    candidate_headers_.clear();
+    confirmed_headers_.clear();
+
     return
-        hash_table_file_.close() &&
-        candidate_index_file_.close() &&
-        confirmed_index_file_.close() &&
-        tx_index_file_.close();
+        hash_table_file_->close() &&
+        candidate_index_file_->close() &&
+        confirmed_index_file_->close() &&
+        tx_index_file_->close();
 }
 
 // Queries.
@@ -175,18 +342,68 @@ block_result block_database::get(size_t height, bool candidate) const
     return
     {
         hash_table_.find(link),
-        metadata_mutex_,
+        metadata_lock_,
         tx_index_
     };
 }
 
+bool block_database::get_transaction(file_offset& out_link, size_t height,
+    size_t position, bool candidate) const
+{
+    auto& manager = candidate ? candidate_index_ : confirmed_index_;
+
+    if (height >= manager.count())
+        return false;
+
+    const auto element = hash_table_.find(read_index(height, manager));
+
+    if (!element)
+        return false;
+
+    uint32_t tx_start;
+    uint16_t tx_count;
+
+    // The start and count are atomic, as populated by update.
+    metadata_lock_.read([&]()
+    {
+        tx_start = element.read_little_endian<uint32_t>(transactions_offset);
+        tx_count = element.read_little_endian<uint16_t>(transactions_offset +
+            tx_start_size);
+    });
+
+    if (position >= tx_count)
+        return false;
+
+    const auto record = tx_index_.get(static_cast<array_index>(tx_start +
+        position));
+    out_link = from_little_endian_unsafe<file_offset>(record->buffer());
+    return true;
+}
+
+bool block_database::get(cached_header& out_header, size_t height,
+    bool candidate) const
+{
+    auto& cache = candidate ? candidate_headers_ : confirmed_headers_;
+
+    if (cache.get(out_header, height))
+        return true;
+
+    const auto result = get(height, candidate);
+
+    if (!result)
+        return false;
+
+    out_header = summarize(result);
+    return true;
+}
+
 // Returns any state, including invalid and empty.
 block_result block_database::get(const hash_digest& hash) const
 {
     return
     {
         hash_table_.find(hash),
-        metadata_mutex_,
+        metadata_lock_,
         tx_index_
     };
 }
@@ -213,25 +430,41 @@ void block_database::get_header_metadata(const chain::header& header) const
 // Store.
 // ----------------------------------------------------------------------------
 
+// The record of a new block (excluding key and link).
+static void write_block( chain::header& header, block_record& record,
+    size_t height, uint32_t median_time_past, uint32_t checksum,
+    uint32_t tx_start, size_t tx_count, uint8_t state)
+{
+    BITCOIN_ASSERT(height <= max_uint32);
+    BITCOIN_ASSERT(tx_count <= max_uint16);
+    BITCOIN_ASSERT(header.serialized_size(false) == block_record::header_size);
+
+    auto serial = make_unsafe_serializer(&record.header[0]);
+    header.to_data(serial, false);
+    block_record::store(record.median_time_past, median_time_past);
+    block_record::store(record.height, static_cast<uint32_t>(height));
+    block_record::store(record.state, state);
+    block_record::store(record.checksum, checksum);
+    block_record::store(record.tx_start, tx_start);
+    block_record::store(record.tx_count, static_cast<uint16_t>(tx_count));
+}
+
 // private
 void block_database::store( chain::header& header, size_t height,
     uint32_t median_time_past, uint32_t checksum, link_type tx_start,
     size_t tx_count, uint8_t state)
 {
-    BITCOIN_ASSERT(height <= max_uint32);
     BITCOIN_ASSERT(tx_start <= max_uint32);
-    BITCOIN_ASSERT(tx_count <= max_uint16);
     BITCOIN_ASSERT(!header.metadata.exists);
 
+    block_record record;
+    write_block(header, record, height, median_time_past, checksum,
+        static_cast<uint32_t>(tx_start), tx_count, state);
+
     const auto writer = [&](byte_serializer& serial)
     {
-        header.to_data(serial, false);
-        serial.write_4_bytes_little_endian(median_time_past);
-        serial.write_4_bytes_little_endian(static_cast<uint32_t>(height));
-        serial.write_byte(state);
-        serial.write_4_bytes_little_endian(checksum);
-        serial.write_4_bytes_little_endian(static_cast<uint32_t>(tx_start));
-        serial.write_2_bytes_little_endian(static_cast<uint16_t>(tx_count));
+        serial.write_bytes(reinterpret_cast<const uint8_t*>(&record),
+            sizeof(record));
     };
 
     auto next = hash_table_.allocator();
@@ -264,6 +497,7 @@ block_database::link_type block_database::associate(
     for (const auto& tx: transactions)
         serial.write_8_bytes_little_endian(tx.metadata.link);
 
+    tx_index_.journal(start, 0, transactions.size() * sizeof(file_offset));
     return start;
 }
 
@@ -286,19 +520,18 @@ bool block_database::update( chain::block& block)
     BITCOIN_ASSERT(tx_start <= max_uint32);
     BITCOIN_ASSERT(tx_count <= max_uint16);
 
-    const auto updater = [&](byte_serializer& serial)
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
     {
-        serial.skip(transactions_offset);
-
-        // Critical Section.
-        ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(metadata_mutex_);
-        serial.write_4_bytes_little_endian(static_cast<uint32_t>(tx_start));
-        serial.write_2_bytes_little_endian(static_cast<uint16_t>(tx_count));
-        ///////////////////////////////////////////////////////////////////////
-    };
-
-    element.write(updater);
+        sequence_lock::scope lock(metadata_lock_);
+        element.write_little_endian(transactions_offset,
+            static_cast<uint32_t>(tx_start));
+        element.write_little_endian(transactions_offset + tx_start_size,
+            static_cast<uint16_t>(tx_count));
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    element.journal(transactions_offset, tx_start_size + tx_count_size);
     return true;
 }
 
@@ -324,36 +557,31 @@ bool block_database::validate(const hash_digest& hash, const code& error)
     if (!element)
         return false;
 
+    uint32_t height;
     uint8_t state;
-    const auto reader = [&](byte_deserializer& deserial)
+    metadata_lock_.read([&]()
     {
-        deserial.skip(state_offset);
+        height = element.read_little_endian<uint32_t>(height_offset);
+        state = element.read_little_endian<uint8_t>(state_offset);
+    });
 
-        // Critical Section.
-        ///////////////////////////////////////////////////////////////////////
-        shared_lock lock(metadata_mutex_);
-        state = deserial.read_byte();
-        ///////////////////////////////////////////////////////////////////////
-    };
+    const auto updated = update_validation_state(state, !error);
 
-    const auto updater = [&](byte_serializer& serial)
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
     {
-        serial.skip(state_offset);
-        const auto updated = update_validation_state(state, !error);
-
-        // Critical Section.
-        ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(metadata_mutex_);
-        serial.write_byte(updated);
+        sequence_lock::scope lock(metadata_lock_);
+        element.write_little_endian(state_offset, updated);
 
         // Do not overwrite checksum with error code unless block is invalid.
         if (error)
-            serial.write_4_bytes_little_endian(error.value());
-        ///////////////////////////////////////////////////////////////////////
-    };
+            element.write_little_endian(checksum_offset,
+                static_cast<uint32_t>(error.value()));
+    }
+    ///////////////////////////////////////////////////////////////////////////
 
-    element.read(reader);
-    element.write(updater);
+    element.journal(state_offset, state_size + (error ? checksum_size : 0));
+    set_state(hash, height, updated);
     return true;
 }
 
@@ -388,33 +616,27 @@ static uint8_t update_confirmation_state(uint8_t original, bool positive,
 uint8_t block_database::index(const_element& element, bool positive,
     bool candidate)
 {
+    uint32_t height;
     uint8_t original;
-    const auto reader = [&](byte_deserializer& deserial)
+    metadata_lock_.read([&]()
     {
-        deserial.skip(state_offset);
+        height = element.read_little_endian<uint32_t>(height_offset);
+        original = element.read_little_endian<uint8_t>(state_offset);
+    });
 
-        // Critical Section.
-        ///////////////////////////////////////////////////////////////////////
-        shared_lock lock(metadata_mutex_);
-        original = deserial.read_byte();
-        ///////////////////////////////////////////////////////////////////////
-    };
+    const auto updated = update_confirmation_state(original, positive,
+        candidate);
 
-    uint8_t updated;
-    const auto updater = [&](byte_serializer& serial)
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
     {
-        serial.skip(state_offset);
-        updated = update_confirmation_state(original, positive, candidate);
-
-        // Critical Section.
-        ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(metadata_mutex_);
-        serial.write_byte(updated);
-        ///////////////////////////////////////////////////////////////////////
-    };
+        sequence_lock::scope lock(metadata_lock_);
+        element.write_little_endian(state_offset, updated);
+    }
+    ///////////////////////////////////////////////////////////////////////////
 
-    element.read(reader);
-    element.write(updater);
+    element.journal(state_offset, state_size);
+    set_state(element.key(), height, updated);
     return positive ? updated : original;
 }
 
@@ -435,6 +657,185 @@ bool block_database::index(const hash_digest& hash, size_t height,
 
      auto updated = index(element, true, candidate);
     push_index(element.link(), height, manager);
+
+    auto& cache = candidate ? candidate_headers_ : confirmed_headers_;
+    if (!cache.disabled())
+        cache.push(summarize({ element, metadata_lock_, tx_index_ }));
+
+    return true;
+}
+
+// The states are read and written in one critical section each, and the
+// index is extended by one range, so a reorganization takes the lock once.
+bool block_database::index(const hash_list& hashes, size_t first_height,
+    bool candidate, bool validate)
+{
+    const auto count = hashes.size();
+    BITCOIN_ASSERT(first_height + count <= max_uint32);
+    auto& manager = candidate ? candidate_index_ : confirmed_index_;
+
+    // Can only add to the top of an index (push).
+    if (first_height != manager.count())
+        return false;
+
+    if (count == 0)
+        return true;
+
+    std::vector<const_element> elements;
+    elements.reserve(count);
+
+    for (const auto& hash: hashes)
+    {
+        elements.push_back(hash_table_.find(hash));
+
+        if (!elements.back())
+            return false;
+    }
+
+    std::vector<uint8_t> states(count);
+    metadata_lock_.read([&]()
+    {
+        for (size_t offset = 0; offset < count; ++offset)
+            states[offset] = elements[offset].read_little_endian<uint8_t>(
+                state_offset);
+    });
+
+    for (auto& state: states)
+        state = update_confirmation_state(validate ?
+            update_validation_state(state, true) : state, true, candidate);
+
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        sequence_lock::scope lock(metadata_lock_);
+
+        for (size_t offset = 0; offset < count; ++offset)
+            elements[offset].write_little_endian(state_offset,
+                states[offset]);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (size_t offset = 0; offset < count; ++offset)
+    {
+        elements[offset].journal(state_offset, state_size);
+        set_state(hashes[offset], first_height + offset, states[offset]);
+    }
+
+    // Write all of the index links in one contiguous range.
+    const auto first = manager.allocate(count);
+    BITCOIN_ASSERT(first == first_height);
+
+    // The accessor must remain in scope until the end of the block.
+    {
+        const auto record = manager.get(first);
+        auto serial = make_unsafe_serializer(record->buffer());
+
+        for (const auto& element: elements)
+            serial.write_4_bytes_little_endian(element.link());
+    }
+
+    manager.journal(first, 0, count * sizeof(link_type));
+
+    auto& cache = candidate ? candidate_headers_ : confirmed_headers_;
+    if (!cache.disabled())
+        for (const auto& element: elements)
+            cache.push(summarize({ element, metadata_lock_, tx_index_ }));
+
+    return true;
+}
+
+// New headers are written to one record range and linked in one pass, and
+// the candidate index is extended by one range for all headers.
+bool block_database::push(const header_const_ptr_list& headers,
+    size_t first_height)
+{
+    static constexpr auto tx_start = 0u;
+    static constexpr auto tx_count = 0u;
+    static constexpr auto no_checksum = 0u;
+
+    const auto count = headers.size();
+    BITCOIN_ASSERT(first_height + count <= max_uint32);
+
+    // Can only add to the top of the index (push).
+    if (first_height != candidate_index_.count())
+        return false;
+
+    if (count == 0)
+        return true;
+
+    const auto is_new = [](const header_const_ptr& header)
+    {
+        return !header->metadata.exists;
+    };
+
+    const auto new_headers = static_cast<size_t>(std::count_if(
+        headers.begin(), headers.end(), is_new));
+
+    std::vector<record_map::value_type> elements;
+    elements.reserve(new_headers);
+    auto next = new_headers == 0 ? 0 : hash_table_.allocate(new_headers);
+
+    std::vector<link_type> links;
+    links.reserve(count);
+
+    for (size_t offset = 0; offset < count; ++offset)
+    {
+        auto& header = *headers[offset];
+
+        if (header.metadata.exists)
+        {
+            auto element = hash_table_.find(header.hash());
+
+            if (!element)
+                return false;
+
+            // Existing headers are promoted as in index(hash, height, true).
+            index(element, true, true);
+            links.push_back(element.link());
+            continue;
+        }
+
+        // New headers are only accepted in the candidate state, which is
+        // therefore also their indexed state.
+        const auto height = first_height + offset;
+        block_record record;
+        write_block(header, record, height, header.metadata.median_time_past,
+            no_checksum, tx_start, tx_count, block_state::candidate);
+
+        const auto writer = [&](byte_serializer& serial)
+        {
+            serial.write_bytes(reinterpret_cast<const uint8_t*>(&record),
+                sizeof(record));
+        };
+
+        auto element = hash_table_.allocator();
+        element.create(next++, header.hash(), writer);
+        elements.push_back(element);
+        links.push_back(element.link());
+    }
+
+    hash_table_.link(elements);
+
+    // Write all of the candidate index links in one contiguous range.
+    const auto first = candidate_index_.allocate(count);
+    BITCOIN_ASSERT(first == first_height);
+
+    // The accessor must remain in scope until the end of the block.
+    {
+        const auto record = candidate_index_.get(first);
+        auto serial = make_unsafe_serializer(record->buffer());
+
+        for (const auto link: links)
+            serial.write_4_bytes_little_endian(link);
+    }
+
+    candidate_index_.journal(first, 0, count * sizeof(link_type));
+
+    if (!candidate_headers_.disabled())
+        for (const auto link: links)
+            candidate_headers_.push(summarize({ hash_table_.find(link),
+                metadata_lock_, tx_index_ }));
+
     return true;
 }
 
@@ -456,9 +857,256 @@ bool block_database::unindex(const hash_digest& hash, size_t height,
 
      auto original = index(element, false, candidate);
     pop_index(height, manager);
+    (candidate ? candidate_headers_ : confirmed_headers_).pop(height);
+    return true;
+}
+
+bool block_database::unindex_above(size_t fork_height, bool candidate)
+{
+    BITCOIN_ASSERT(fork_height < max_uint32);
+    auto& manager = candidate ? candidate_index_ : confirmed_index_;
+    auto& cache = candidate ? candidate_headers_ : confirmed_headers_;
+    const size_t count = manager.count();
+
+    // The fork point must be indexed.
+    if (fork_height >= count)
+        return false;
+
+    for (auto height = count - 1u; height > fork_height; --height)
+    {
+        auto element = hash_table_.find(read_index(height, manager));
+
+        if (!element)
+            return false;
+
+        index(element, false, candidate);
+        cache.pop(height);
+    }
+
+    manager.set_count(static_cast<uint32_t>(fork_height + 1u));
     return true;
 }
 
+// Repair.
+// ----------------------------------------------------------------------------
+
+// Records beyond the end of a file are truncated by recover, after which the
+// hash index is rebuilt from the records that remain.
+bool block_database::recover(const transaction_database& transactions,
+    size_t threads)
+{
+    const auto opened =
+        hash_table_file_->open() &&
+        candidate_index_file_->open() &&
+        confirmed_index_file_->open() &&
+        tx_index_file_->open() &&
+
+        hash_table_.recover() &&
+        candidate_index_.recover() &&
+        confirmed_index_.recover() &&
+        tx_index_.recover();
+
+    if (!opened)
+        return false;
+
+    hash_table_.rebuild();
+
+    // Blocks demoted from the confirmed index are no longer in the candidate
+    // index state, so the candidate index is verified after the truncation.
+    truncate(verify(transactions, false, threads), false);
+    truncate(verify(transactions, true, threads), true);
+
+    warm(candidate_headers_, true);
+    warm(confirmed_headers_, false);
+    return true;
+}
+
+size_t block_database::verify(const transaction_database& transactions,
+    bool candidate, size_t threads) const
+{
+    const auto& manager = candidate ? candidate_index_ : confirmed_index_;
+    const size_t count = manager.count();
+    std::atomic<size_t> first_failure(count);
+
+    // A partition stops at its first failure, or above a lower one.
+    const auto check = [&](size_t first, size_t last)
+    {
+        for (auto height = first; height < last && height < first_failure;
+            ++height)
+        {
+            if (consistent(height, candidate, transactions))
+                continue;
+
+            auto lowest = first_failure.load();
+            while (height < lowest &&
+                !first_failure.compare_exchange_weak(lowest, height));
+
+            return;
+        }
+    };
+
+    parallel_for(count, threads, minimum_partition, check);
+    return first_failure;
+}
+
+// The header record is within the table, hashes to its key, is at the height
+// and in the index state, and links to the header below. Its transactions, if
+// any, are within the tables and hash to its merkle root. A candidate header
+// may be unpopulated, but a confirmed block cannot be.
+bool block_database::consistent(size_t height, bool candidate,
+    const transaction_database& transactions) const
+{
+    const auto& manager = candidate ? candidate_index_ : confirmed_index_;
+    const auto link = read_index(height, manager);
+
+    if (!hash_table_.contains(link))
+        return false;
+
+    const auto element = hash_table_.find(link);
+    chain::header header;
+    hash_digest hash;
+    uint32_t record_height;
+    uint8_t state;
+    link_type tx_start;
+    size_t tx_count;
+
+    const auto reader = [&](const block_record& record)
+    {
+        hash = bitcoin_hash(data_slice(&record.header[0],
+            &record.header[0] + block_record::header_size));
+        auto deserial = make_unsafe_deserializer(&record.header[0]);
+        header.from_data(deserial, hash, false);
+        record_height = block_record::load<uint32_t>(record.height);
+        state = block_record::load<uint8_t>(record.state);
+        tx_start = block_record::load<uint32_t>(record.tx_start);
+        tx_count = block_record::load<uint16_t>(record.tx_count);
+    };
+
+    metadata_lock_.read([&]()
+    {
+        element.read_record<block_record>(reader);
+    });
+
+    const auto indexed = is_confirmed(state) ||
+        (candidate && is_candidate(state));
+
+    if (hash != element.key() || record_height != height || !indexed)
+        return false;
+
+    if (height != 0)
+    {
+        const auto parent = read_index(height - 1u, manager);
+
+        if (!hash_table_.contains(parent) ||
+            hash_table_.find(parent).key() != header.previous_block_hash())
+            return false;
+    }
+
+    if (tx_count == 0)
+        return candidate;
+
+    if (static_cast<size_t>(tx_start) + tx_count > tx_index_.count())
+        return false;
+
+    hash_list hashes;
+    hashes.reserve(tx_count);
+
+    // The accessor must remain in scope until the end of the block.
+    const auto record = tx_index_.get(tx_start);
+    auto deserial = make_unsafe_deserializer(record->buffer());
+
+    for (size_t tx = 0; tx < tx_count; ++tx)
+    {
+        const auto tx_link = deserial.read_8_bytes_little_endian();
+
+        if (!transactions.contains(tx_link))
+            return false;
+
+        hashes.push_back(transactions.get(tx_link).hash());
+    }
+
+    return merkle_root(std::move(hashes)) == header.merkle();
+}
+
+// Demote the headers above the count that remain in the index state, and
+// truncate the index to the count.
+void block_database::truncate(size_t count, bool candidate)
+{
+    BITCOIN_ASSERT(count < max_uint32);
+    auto& manager = candidate ? candidate_index_ : confirmed_index_;
+
+    for (size_t height = manager.count(); height > count; --height)
+    {
+        const auto link = read_index(height - 1u, manager);
+
+        if (!hash_table_.contains(link))
+            continue;
+
+        auto element = hash_table_.find(link);
+        const auto state = element.read_little_endian<uint8_t>(state_offset);
+
+        if (candidate ? is_candidate(state) : is_confirmed(state))
+            index(element, false, candidate);
+    }
+
+    manager.set_count(static_cast<uint32_t>(count));
+}
+
+// Header cache utilities.
+// ----------------------------------------------------------------------------
+
+// Populate the cache from the top of the index.
+// The saved headers are valid only if they end at the top of the index.
+bool block_database::restore(header_cache& cache, bool candidate,
+    const manifest& clean)
+{
+    data_chunk data;
+    const auto& manager = candidate ? candidate_index_ : confirmed_index_;
+    const auto name = candidate ? candidate_headers_name :
+        confirmed_headers_name;
+
+    if (cache.disabled() || !clean.get(name, data) || !cache.from_data(data))
+        return false;
+
+    cached_header top;
+    cached_header above;
+    const size_t count = manager.count();
+
+    // The top is also checked against the table, which costs one read.
+    if (count == 0 || !cache.get(top, count - 1u) || cache.get(above, count) ||
+        (cache.size() < cache.capacity() && cache.size() != count) ||
+        get(count - 1u, candidate).hash() != top.hash)
+    {
+        cache.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void block_database::warm(header_cache& cache, bool candidate)
+{
+    cache.clear();
+    auto& manager = candidate ? candidate_index_ : confirmed_index_;
+    const size_t count = manager.count();
+
+    if (cache.disabled() || count == 0)
+        return;
+
+    const auto start = count > cache.capacity() ? count - cache.capacity() : 0;
+
+    for (auto height = start; height < count; ++height)
+        cache.push(summarize(get(height, candidate)));
+}
+
+// A state change applies to the block in both indexes.
+void block_database::set_state(const hash_digest& hash, size_t height,
+    uint8_t state)
+{
+    candidate_headers_.set_state(hash, height, state);
+    confirmed_headers_.set_state(hash, height, state);
+}
+
 // Index Utilities.
 // ----------------------------------------------------------------------------
 
@@ -506,6 +1154,7 @@ void block_database::push_index(link_type index, size_t height,
     const auto record = manager.get(height32);
     auto serial = make_unsafe_serializer(record->buffer());
     serial.write_4_bytes_little_endian(index);
+    manager.journal(height32, 0, sizeof(link_type));
 }
 
 } // namespace database
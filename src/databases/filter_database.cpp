@@ -0,0 +1,208 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/databases/filter_database.hpp>
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/block_filter.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+
+// Record format:
+// ----------------------------------------------------------------------------
+// [ header:32          ] (the filter header)
+// [ filter:varint+data ] (the BIP158 basic filter)
+
+namespace libbitcoin {
+namespace database {
+
+// Filters use a hash table index, O(1).
+filter_database::filter_database(const path& map_filename, size_t buckets,
+    size_t expansion, size_t reservation, storage_backend backend)
+  : hash_table_file_(storage::factory(backend, map_filename,
+        expansion, reservation)),
+    hash_table_(*hash_table_file_, buckets)
+{
+    hash_table_file_->enable_metrics(metrics_);
+    hash_table_.enable_metrics(metrics_);
+}
+
+filter_database::~filter_database()
+{
+    close();
+}
+
+// Startup and shutdown.
+// ----------------------------------------------------------------------------
+
+bool filter_database::create()
+{
+    if (!hash_table_file_->open())
+        return false;
+
+    // No need to call open after create.
+    return hash_table_.create();
+}
+
+bool filter_database::open()
+{
+    return
+        hash_table_file_->open() &&
+        hash_table_.start();
+}
+
+bool filter_database::refresh()
+{
+    return
+        hash_table_file_->refresh() &&
+        hash_table_.start();
+}
+
+void filter_database::commit()
+{
+    hash_table_.commit();
+}
+
+bool filter_database::flush() const
+{
+    return hash_table_file_->flush();
+}
+
+bool filter_database::flush_dirty() const
+{
+    return hash_table_file_->flush_dirty();
+}
+
+void filter_database::enable_journal()
+{
+    hash_table_file_->enable_journal();
+}
+
+void filter_database::enable_advice(const map_advice& advice)
+{
+    hash_table_file_->enable_advice(advice, hash_table_.header_size());
+}
+
+void filter_database::enable_file_growth(const file_growth& growth)
+{
+    hash_table_file_->enable_growth(growth);
+}
+
+void filter_database::pregrow()
+{
+    hash_table_file_->pregrow();
+}
+
+bool filter_database::log_writes(commit_log& log)
+{
+    return hash_table_file_->log_writes(log);
+}
+
+table_metrics::values filter_database::metrics() const
+{
+    auto values = metrics_.get();
+    storage::footprint(values, *hash_table_file_);
+    return values;
+}
+
+void filter_database::enable_growth(size_t load_percent)
+{
+    hash_table_.enable_growth(load_percent);
+}
+
+bool filter_database::close()
+{
+    return hash_table_file_->close();
+}
+
+// Queries.
+// ----------------------------------------------------------------------------
+
+bool filter_database::get(hash_digest& out_header,
+    const hash_digest& block_hash) const
+{
+    const auto element = hash_table_.find(block_hash);
+
+    if (!element)
+        return false;
+
+    element.read([&](byte_deserializer& deserial)
+    {
+        out_header = deserial.read_hash();
+    });
+
+    return true;
+}
+
+bool filter_database::get(data_chunk& out_filter, hash_digest& out_header,
+    const hash_digest& block_hash) const
+{
+    const auto element = hash_table_.find(block_hash);
+
+    if (!element)
+        return false;
+
+    element.read([&](byte_deserializer& deserial)
+    {
+        out_header = deserial.read_hash();
+        const auto size = deserial.read_size_little_endian();
+        out_filter = deserial.read_bytes(size);
+    });
+
+    return true;
+}
+
+// Store.
+// ----------------------------------------------------------------------------
+
+bool filter_database::store(const hash_digest& block_hash,
+    const hash_digest& previous_block_hash, const data_chunk& filter)
+{
+    hash_digest header;
+
+    // The filter of a block is the same on each branch that contains it.
+    if (get(header, block_hash))
+        return true;
+
+    // The genesis block commits to a null previous header.
+    auto previous_header = null_hash;
+    if (previous_block_hash != null_hash &&
+        !get(previous_header, previous_block_hash))
+        return false;
+
+    header = block_filter::header(filter, previous_header);
+
+    const auto writer = [&](byte_serializer& serial)
+    {
+        serial.write_hash(header);
+        serial.write_variable_little_endian(filter.size());
+        serial.write_bytes(filter);
+    };
+
+    const auto size = hash_size + variable_uint_size(filter.size()) +
+        filter.size();
+
+    auto next = hash_table_.allocator();
+    next.create(block_hash, writer, size);
+    hash_table_.link(next);
+    return true;
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/databases/spend_database.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/result/transaction_result.hpp>
+
+// Record format:
+// ----------------------------------------------------------------------------
+// [ spender_link:8  ] (not_spent if vacant)
+// [ spender_index:4 ] (the input index of the spender tx)
+
+namespace libbitcoin {
+namespace database {
+
+using namespace bc::chain;
+
+static constexpr auto spender_size = sizeof(file_offset) + sizeof(uint32_t);
+
+// The spender link of a vacant (unwound) row.
+static constexpr file_offset not_spent = max_uint64;
+
+// The link of an input point not linked to its previous tx.
+static constexpr auto not_linked =
+    transaction_result::const_element_type::not_found;
+
+// Multipliers that spread the output index and probe over the fingerprint.
+static constexpr uint64_t index_multiplier = 0x9e3779b97f4a7c15;
+static constexpr uint64_t probe_multiplier = 0xc2b2ae3d27d4eb4f;
+
+// Fingerprints are 64 bits, so a probe beyond this is not expected.
+static constexpr size_t maximum_probes = 16;
+
+template <typename Element>
+static void read_spender(const Element& element, file_offset& out_link,
+    uint32_t& out_input)
+{
+    element.read([&](byte_deserializer& deserial)
+    {
+        out_link = deserial.read_8_bytes_little_endian();
+        out_input = deserial.read_4_bytes_little_endian();
+    });
+}
+
+template <typename Element>
+static void write_spender(const Element& element, file_offset link,
+    uint32_t input)
+{
+    element.write([&](byte_serializer& serial)
+    {
+        serial.write_8_bytes_little_endian(link);
+        serial.write_4_bytes_little_endian(input);
+    });
+
+    element.journal(0, spender_size);
+}
+
+// Spends use a hash table index, O(1).
+spend_database::spend_database(const path& map_filename, size_t buckets,
+    size_t expansion, const transaction_database& transactions,
+    size_t reservation, storage_backend backend)
+  : hash_table_file_(storage::factory(backend, map_filename,
+        expansion, reservation)),
+    hash_table_(*hash_table_file_, buckets, spender_size),
+    transactions_(transactions)
+{
+    hash_table_file_->enable_metrics(metrics_);
+    hash_table_.enable_metrics(metrics_);
+}
+
+spend_database::~spend_database()
+{
+    close();
+}
+
+// Startup and shutdown.
+// ----------------------------------------------------------------------------
+
+bool spend_database::create()
+{
+    if (!hash_table_file_->open())
+        return false;
+
+    // No need to call open after create.
+    return hash_table_.create();
+}
+
+bool spend_database::open()
+{
+    return
+        hash_table_file_->open() &&
+        hash_table_.start();
+}
+
+bool spend_database::refresh()
+{
+    return
+        hash_table_file_->refresh() &&
+        hash_table_.start();
+}
+
+void spend_database::commit()
+{
+    hash_table_.commit();
+}
+
+bool spend_database::flush() const
+{
+    return hash_table_file_->flush();
+}
+
+bool spend_database::flush_dirty() const
+{
+    return hash_table_file_->flush_dirty();
+}
+
+void spend_database::enable_journal()
+{
+    hash_table_file_->enable_journal();
+}
+
+void spend_database::enable_advice(const map_advice& advice)
+{
+    hash_table_file_->enable_advice(advice, hash_table_.header_size());
+}
+
+void spend_database::enable_file_growth(const file_growth& growth)
+{
+    hash_table_file_->enable_growth(growth);
+}
+
+void spend_database::pregrow()
+{
+    hash_table_file_->pregrow();
+}
+
+bool spend_database::log_writes(commit_log& log)
+{
+    return hash_table_file_->log_writes(log);
+}
+
+table_metrics::values spend_database::metrics() const
+{
+    auto values = metrics_.get();
+    storage::footprint(values, *hash_table_file_);
+    return values;
+}
+
+void spend_database::enable_growth(size_t load_percent)
+{
+    hash_table_.enable_growth(load_percent);
+}
+
+bool spend_database::close()
+{
+    return hash_table_file_->close();
+}
+
+// Queries.
+// ----------------------------------------------------------------------------
+
+bool spend_database::get(input_point& out_spender,
+    const output_point& outpoint) const
+{
+    for (size_t probe = 0; probe < maximum_probes; ++probe)
+    {
+        const auto element = hash_table_.find(fingerprint(outpoint, probe));
+
+        if (!element)
+            return false;
+
+        file_offset link;
+        uint32_t input;
+        read_spender(element, link, input);
+
+        if (link != not_spent && spends(out_spender, link, input, outpoint))
+            return true;
+    }
+
+    return false;
+}
+
+// Store.
+// ----------------------------------------------------------------------------
+
+void spend_database::index(const transaction::list& transactions)
+{
+    for (const auto& tx: transactions)
+    {
+        const auto link = tx.metadata.link;
+
+        if (tx.is_coinbase() || link == transaction::validation::unlinked)
+            continue;
+
+        const auto& inputs = tx.inputs();
+        for (uint32_t input = 0; input < inputs.size(); ++input)
+            index(inputs[input].previous_output(), link, input);
+    }
+}
+
+void spend_database::unindex(file_offset link)
+{
+    const auto result = transactions_.get(link);
+
+    if (!result || result.pruned())
+        return;
+
+    uint32_t input = 0;
+    for (auto it = result.begin(); it != result.end(); ++it, ++input)
+    {
+        const auto point = *it;
+
+        if (point.is_null())
+            continue;
+
+        // A linked point's hash is not stored, so it is the key of its parent.
+        const auto hash = it.parent() == not_linked ? point.hash() :
+            transactions_.get(it.parent()).hash();
+
+        unindex({ hash, point.index() }, link, input);
+    }
+}
+
+// private
+// The hash is uniformly distributed, so its leading bytes suffice.
+spend_database::key_type spend_database::fingerprint(
+    const output_point& outpoint, size_t probe)
+{
+    auto deserial = make_unsafe_deserializer(outpoint.hash().begin());
+    const auto value = deserial.read_8_bytes_little_endian() +
+        (outpoint.index() + uint64_t(1)) * index_multiplier +
+        probe * probe_multiplier;
+
+    key_type key;
+    auto serial = make_unsafe_serializer(key.begin());
+    serial.write_8_bytes_little_endian(value);
+    return key;
+}
+
+// private
+bool spend_database::spends(input_point& out_spender, file_offset link,
+    uint32_t input, const output_point& outpoint) const
+{
+    const auto result = transactions_.get(link);
+
+    if (!result || result.pruned())
+        return false;
+
+    auto it = result.begin();
+    const auto end = result.end();
+    for (uint32_t index = 0; index < input && it != end; ++index, ++it);
+
+    if (it == end)
+        return false;
+
+    const auto point = *it;
+
+    if (point.index() != outpoint.index())
+        return false;
+
+    // A linked point's hash is not stored, so compare to the parent's key.
+    if (it.parent() == not_linked ? point.hash() != outpoint.hash() :
+        transactions_.get(it.parent()).hash() != outpoint.hash())
+        return false;
+
+    out_spender = { result.hash(), input };
+    return true;
+}
+
+// private
+// A row of the outpoint that is not the spender's was not unwound (its spender
+// is not confirmed) and is replaced, otherwise the first vacant row is reused.
+void spend_database::index(const output_point& outpoint, file_offset link,
+    uint32_t input)
+{
+    auto vacant = maximum_probes;
+    size_t probe = 0;
+
+    for (; probe < maximum_probes; ++probe)
+    {
+        const auto element = hash_table_.find(fingerprint(outpoint, probe));
+
+        if (!element)
+            break;
+
+        file_offset spender;
+        uint32_t spender_input;
+        read_spender(element, spender, spender_input);
+
+        if (spender == link && spender_input == input)
+            return;
+
+        if (spender == not_spent)
+        {
+            if (vacant == maximum_probes)
+                vacant = probe;
+
+            continue;
+        }
+
+        input_point point;
+        if (spends(point, spender, spender_input, outpoint))
+        {
+            write_spender(element, link, input);
+            return;
+        }
+    }
+
+    if (vacant != maximum_probes)
+    {
+        write_spender(hash_table_.find(fingerprint(outpoint, vacant)), link,
+            input);
+        return;
+    }
+
+    if (probe == maximum_probes)
+        return;
+
+    auto next = hash_table_.allocator();
+    next.create(fingerprint(outpoint, probe), [&](byte_serializer& serial)
+    {
+        serial.write_8_bytes_little_endian(link);
+        serial.write_4_bytes_little_endian(input);
+    });
+
+    hash_table_.link(next);
+}
+
+// private
+void spend_database::unindex(const output_point& outpoint, file_offset link,
+    uint32_t input)
+{
+    for (size_t probe = 0; probe < maximum_probes; ++probe)
+    {
+        const auto element = hash_table_.find(fingerprint(outpoint, probe));
+
+        if (!element)
+            return;
+
+        file_offset spender;
+        uint32_t spender_input;
+        read_spender(element, spender, spender_input);
+
+        if (spender == link && spender_input == input)
+        {
+            write_spender(element, not_spent, 0);
+            return;
+        }
+    }
+}
+
+} // namespace database
+} // namespace libbitcoin
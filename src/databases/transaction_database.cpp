@@ -18,12 +18,21 @@
  */
 #include <bitcoin/database/databases/transaction_database.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <atomic>
 #include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/compact_codec.hpp>
+#include <bitcoin/database/crc32c.hpp>
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/parallel.hpp>
 #include <bitcoin/database/result/transaction_result.hpp>
 
 namespace libbitcoin {
@@ -36,8 +45,11 @@ using namespace bc::machine;
 // ----------------------------------------------------------------------------
 // [ height/forks/code:4 - atomic1  ] (code if invalid)
 // [ position:2          - atomic1  ] (unconfirmed sentinel, could store state)
-// [ candidate:1         - atomic1  ] (candidate(1))
+// [ candidate:1         - atomic1  ] (candidate(1), indexed(2), compact(4),
+//                                     linked(8))
 // [ median_time_past:4  - atomic1  ] (zero if unconfirmed)
+// [ entry_count:varint  - const    ] (only if outputs_indexed)
+// [ [ offset:4          - const  ] ]... (output_count + 1 entries)
 // [ output_count:varint - const    ] (tx starts here)
 // [
 //   [ candidate_spent:1 - atomic2 ]
@@ -55,6 +67,41 @@ using namespace bc::machine;
 // [ locktime:varint      - const    ]
 // [ version:varint       - const    ]
 
+// Record format (v4.1) differs from v4 only in outputs (if outputs_compact):
+// ----------------------------------------------------------------------------
+// [
+//   [ candidate_spent:1 - atomic2 ]
+//   [ spender_height:4  - atomic2 ]
+//   [ value:varint      - const   ] (compressed amount)
+//   [ script:template   - const   ] (see compact_codec)
+// ]...
+
+// Record format (v4.2) differs from v4 only in input points (if linked):
+// ----------------------------------------------------------------------------
+// [
+//   [ link:8             - const  ] (not_found if tx not stored or null)
+//   [ hash:32            - const  ] (only if link is not_found)
+//   [ index:2            - const  ]
+//   ...
+// ]...
+
+// Record format (v4.3) differs from v4 only in metadata (if state_split):
+// ----------------------------------------------------------------------------
+// [ height/forks/code:4 - const    ] (as stored, see state table)
+// [ position:2          - const    ] (as stored, see state table)
+// [ candidate:1         - const    ] (format flags, split(16))
+// [ median_time_past:4  - const    ] (as stored, see state table)
+// [ state_ordinal:4     - const    ] (transaction record of state table)
+// [ outputs_ordinal:8   - const    ] (first output record of state table)
+// ...
+// [
+//   [ candidate_spent:1 - const   ] (as stored, see state table)
+//   [ spender_height:4  - const   ] (as stored, see state table)
+//   ...
+// ]...
+// ...
+// [ checksum:4          - const    ] (crc32c of record, if payload_checked)
+
 // Record format (v3.3):
 // ----------------------------------------------------------------------------
 // [ height/forks:4         - atomic1 ]
@@ -73,23 +120,254 @@ static constexpr auto candidate_size = sizeof(uint8_t);
 static constexpr auto median_time_past_size = sizeof(uint32_t);
 
 static constexpr auto candidate_spent_size = sizeof(uint8_t);
-////static constexpr auto height_size = sizeof(uint32_t);
-static constexpr auto value_size = sizeof(uint64_t);
-
-static constexpr auto spend_size = candidate_spent_size + height_size +
-    value_size;
 static constexpr auto metadata_size = height_size + position_size +
     candidate_size + median_time_past_size;
+static constexpr auto split_size = sizeof(uint32_t) + sizeof(uint64_t);
+static constexpr auto checksum_size = sizeof(uint32_t);
 
 static constexpr auto no_time = 0u;
 
+// The output cache is partitioned to reduce lock contention.
+static constexpr size_t default_cache_shards = 16;
+
+// Smaller blocks are not worth the cost of a thread.
+static constexpr size_t minimum_partition = 256;
+
+// The remembered links of outputs found for validation are cleared at this.
+static constexpr size_t maximum_spent_links = 131072;
+
+// The bytes advised at each prevout tx (key, metadata and leading outputs).
+static constexpr size_t prevout_prefetch_size = 512;
+
+// Transactions with fewer outputs are not worth the cost of an output table.
+static constexpr size_t minimum_indexed_outputs = 16;
+static constexpr auto table_offset_size = sizeof(uint32_t);
+static constexpr auto link_size = sizeof(file_offset);
+
+// The link of an input point of a tx not stored (or null), with its hash.
+static constexpr auto not_linked =
+    transaction_result::const_element_type::not_found;
+
+// The state ordinal of a spend target of a tx that is not split.
+static constexpr auto not_split =
+    transaction_result::const_element_type::not_found;
+
+// The format flags of a state byte, set only on store (and prune).
+static constexpr uint8_t format_flags = transaction_result::outputs_indexed |
+    transaction_result::outputs_compact | transaction_result::inputs_linked |
+    transaction_result::state_split | transaction_result::payload_pruned |
+    transaction_result::payload_checked;
+
+// The format flags of a record that are cleared by prune, as the released
+// (zeroed) record reads as a tx without outputs or inputs (and unchecked).
+static constexpr uint8_t payload_flags = transaction_result::outputs_indexed |
+    transaction_result::outputs_compact | transaction_result::inputs_linked |
+    transaction_result::payload_checked;
+
+// Unspent output snapshot format (see export_unspent).
+static constexpr uint32_t snapshot_magic = 0x6f747875;
+static constexpr uint32_t snapshot_version = 1;
+static constexpr size_t snapshot_header_size = 3u * sizeof(uint32_t) +
+    hash_size + 2u * sizeof(uint64_t);
+static constexpr size_t chunk_header_size = 3u * sizeof(uint32_t);
+
+// The payload size at which a snapshot chunk is written (and read limit).
+static constexpr size_t snapshot_chunk_size = 1024u * 1024u;
+static constexpr size_t maximum_chunk_size = 64u * snapshot_chunk_size;
+
+// The stored size of a variable length integer (for journaling offsets).
+static size_t variable_size(uint64_t value)
+{
+    return value < 0xfd ? 1 : value <= max_uint16 ? 3 :
+        value <= max_uint32 ? 5 : 9;
+}
+
+static bool is_indexed(const transaction& tx)
+{
+    return tx.outputs().size() >= minimum_indexed_outputs;
+}
+
+// The stored size of the output offset table of the transaction.
+static size_t table_size(const transaction& tx)
+{
+    if (!is_indexed(tx))
+        return 0;
+
+    const auto entries = tx.outputs().size() + 1u;
+    return variable_size(entries) + entries * table_offset_size;
+}
+
+// The stored size of the transaction (from its output count).
+// Each linked point replaces its hash with a link, others are prefixed.
+static size_t payload_size(const transaction& tx, bool compact,
+    const std::vector<file_offset>& parents)
+{
+    auto size = compact ? compact_codec::size(tx) :
+        tx.serialized_size(false, true);
+
+    for (const auto parent: parents)
+        size = size + link_size -
+            (parent == not_linked ? 0 : hash_size);
+
+    return size;
+}
+
+// The stored size of the metadata, with state ordinals if split.
+static size_t header_size(bool split)
+{
+    return metadata_size + (split ? split_size : 0);
+}
+
+// The stored size of the checksum trailer, if checked.
+static size_t trailer_size(bool checked)
+{
+    return checked ? checksum_size : 0;
+}
+
+// Write the state byte.
+static void write_state(byte_serializer& serial, const transaction& tx,
+    bool compact, bool linked, bool split, bool checked)
+{
+    auto state = transaction_result::candidate_false;
+
+    if (is_indexed(tx))
+        state |= transaction_result::outputs_indexed;
+
+    if (compact)
+        state |= transaction_result::outputs_compact;
+
+    if (linked)
+        state |= transaction_result::inputs_linked;
+
+    if (split)
+        state |= transaction_result::state_split;
+
+    if (checked)
+        state |= transaction_result::payload_checked;
+
+    serial.write_byte(state);
+}
+
+// Write the checksum of the new record, following the record.
+// The record is not yet linked, so this is not guarded (or journaled).
+template <typename Element>
+static void write_checksum(const Element& element, size_t record_size)
+{
+    const auto memory = element.state();
+    element.write_little_endian(record_size,
+        crc32c(memory->buffer(), record_size));
+}
+
+// Write the state ordinals, following the metadata.
+static void write_split(byte_serializer& serial, file_offset transaction,
+    file_offset outputs)
+{
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(transaction));
+    serial.write_8_bytes_little_endian(outputs);
+}
+
+static void write_table(byte_serializer& serial, const transaction& tx,
+    bool compact)
+{
+    if (!is_indexed(tx))
+        return;
+
+    const auto& outputs = tx.outputs();
+    auto offset = variable_size(outputs.size());
+    serial.write_size_little_endian(outputs.size() + 1u);
+
+    for (const auto& output: outputs)
+    {
+        serial.write_4_bytes_little_endian(static_cast<uint32_t>(offset));
+        offset += compact ? compact_codec::output_size(output) :
+            output.serialized_size(false);
+    }
+
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(offset));
+}
+
+static void write_inputs(byte_serializer& serial, const transaction& tx,
+    const std::vector<file_offset>& parents)
+{
+    const auto& inputs = tx.inputs();
+    serial.write_size_little_endian(inputs.size());
+
+    for (size_t index = 0; index < inputs.size(); ++index)
+    {
+        const auto& input = inputs[index];
+        const auto& prevout = input.previous_output();
+        serial.write_8_bytes_little_endian(parents[index]);
+
+        if (parents[index] == not_linked)
+            prevout.to_data(serial, false);
+        else
+            serial.write_2_bytes_little_endian(
+                static_cast<uint16_t>(prevout.index()));
+
+        input.script().to_data(serial, true);
+        input.witness().to_data(serial, true);
+        serial.write_4_bytes_little_endian(input.sequence());
+    }
+}
+
+// Parents are empty unless linked (one for each input).
+static void write_payload(byte_serializer& serial, const transaction& tx,
+    bool compact, const std::vector<file_offset>& parents)
+{
+    if (parents.empty())
+    {
+        if (compact)
+            compact_codec::write(serial, tx);
+        else
+            tx.to_data(serial, false, true);
+
+        return;
+    }
+
+    const auto& outputs = tx.outputs();
+    serial.write_size_little_endian(outputs.size());
+
+    for (const auto& output: outputs)
+    {
+        if (compact)
+            compact_codec::write_output(serial, output);
+        else
+            output.to_data(serial, false);
+    }
+
+    write_inputs(serial, tx, parents);
+    serial.write_variable_little_endian(tx.locktime());
+    serial.write_variable_little_endian(tx.version());
+}
+
 // Transactions uses a hash table index, O(1).
 transaction_database::transaction_database(const path& map_filename,
-    size_t buckets, size_t expansion, size_t cache_capacity)
-  : hash_table_file_(map_filename, expansion),
-    hash_table_(hash_table_file_, buckets),
-    cache_(cache_capacity)
+    size_t buckets, size_t expansion, size_t cache_budget,
+    size_t reservation, const path& filter_filename, size_t filter_size,
+    size_t filter_error_ppm, eviction_policy cache_policy,
+    const path& transaction_state_filename,
+    const path& output_state_filename, storage_backend backend,
+    size_t pool_budget)
+  : hash_table_file_(storage::factory(backend, map_filename,
+        expansion, reservation)),
+    hash_table_(*hash_table_file_, buckets),
+    threads_(1),
+    compact_(false),
+    linked_(false),
+    split_(false),
+    checksums_(false),
+    sample_rate_(0),
+    reads_(0),
+    corruptions_(0),
+    state_(transaction_state_filename, output_state_filename, expansion,
+        reservation, backend),
+    filter_filename_(filter_filename),
+    filter_(filter_size, filter_error_ppm),
+    cache_(cache_budget, default_cache_shards, cache_policy),
+    pool_(pool_budget)
 {
+    hash_table_file_->enable_metrics(metrics_);
+    hash_table_.enable_metrics(metrics_);
 }
 
 transaction_database::~transaction_database()
@@ -102,48 +380,340 @@ transaction_database::~transaction_database()
 
 bool transaction_database::create()
 {
-    if (!hash_table_file_.open())
+    if (!hash_table_file_->open())
         return false;
 
     // No need to call open after create.
-    return
-        hash_table_.create();
+    if (!hash_table_.create() || (split_ && !state_.create()))
+        return false;
+
+    filter_.create();
+    return true;
 }
 
 bool transaction_database::open()
 {
-    return
-        hash_table_file_.open() &&
-        hash_table_.start();
+    if (!hash_table_file_->open() || !hash_table_.start() ||
+        (split_ && !state_.open()))
+        return false;
+
+    // The filter is saved only on close, otherwise rebuild it from the table.
+    if (!filter_.disabled() &&
+        !filter_.load(filter_filename_, hash_table_.count()))
+    {
+        filter_.create();
+        hash_table_.walk([this](const hash_digest& hash)
+        {
+            filter_.insert(hash);
+        });
+    }
+
+    return true;
+}
+
+// The filter of an unclean shutdown may be stale, so it is rebuilt.
+bool transaction_database::recover(size_t& out_cut)
+{
+    if (!hash_table_file_->open() || !hash_table_.recover() ||
+        !hash_table_.repair(out_cut) || (split_ && !state_.open()))
+        return false;
+
+    if (!filter_.disabled())
+    {
+        filter_.create();
+        hash_table_.walk([this](const hash_digest& hash)
+        {
+            filter_.insert(hash);
+        });
+    }
+
+    return true;
+}
+
+// The filter and output cache are not refreshed, so a secondary should
+// disable them.
+bool transaction_database::refresh()
+{
+    return hash_table_file_->refresh() && hash_table_.start() &&
+        (!split_ || state_.refresh());
 }
 
 void transaction_database::commit()
 {
     hash_table_.commit();
+
+    if (split_)
+        state_.commit();
 }
 
 bool transaction_database::flush() const
 {
-    return hash_table_file_.flush();
+    return hash_table_file_->flush() && (!split_ || state_.flush());
+}
+
+bool transaction_database::flush_dirty() const
+{
+    return hash_table_file_->flush_dirty() && (!split_ || state_.flush_dirty());
+}
+
+void transaction_database::enable_journal()
+{
+    hash_table_file_->enable_journal();
+
+    if (split_)
+        state_.enable_journal();
+}
+
+void transaction_database::enable_advice(const map_advice& advice)
+{
+    hash_table_file_->enable_advice(advice, hash_table_.header_size());
+    state_.enable_advice(advice);
+}
+
+void transaction_database::enable_file_growth(const file_growth& growth)
+{
+    hash_table_file_->enable_growth(growth);
+    state_.enable_file_growth(growth);
+}
+
+void transaction_database::pregrow()
+{
+    hash_table_file_->pregrow();
+
+    if (split_)
+        state_.pregrow();
+}
+
+// The state table is small and frequently written, so it is not compressed.
+size_t transaction_database::compress(size_t retain)
+{
+    return hash_table_file_->compress(retain);
+}
+
+bool transaction_database::log_writes(commit_log& log)
+{
+    return hash_table_file_->log_writes(log) &&
+        (!split_ || state_.log_writes(log));
+}
+
+table_metrics::values transaction_database::metrics() const
+{
+    auto values = metrics_.get();
+    values.lock_wait_ns = metadata_lock_.wait_ns();
+    values.corruptions = corruptions_.load(std::memory_order_relaxed);
+    storage::footprint(values, *hash_table_file_);
+
+    if (split_)
+        state_.footprint(values);
+
+    return values;
+}
+
+float transaction_database::cache_hit_rate() const
+{
+    return cache_.hit_rate();
+}
+
+void transaction_database::enable_growth(size_t load_percent)
+{
+    hash_table_.enable_growth(load_percent);
+}
+
+void transaction_database::enable_parallel(size_t threads)
+{
+    threads_ = parallelism(threads);
+}
+
+void transaction_database::enable_compaction()
+{
+    compact_ = true;
+}
+
+void transaction_database::enable_linked_inputs()
+{
+    linked_ = true;
+}
+
+void transaction_database::enable_split_state()
+{
+    split_ = true;
+}
+
+void transaction_database::enable_checksums()
+{
+    checksums_ = true;
+}
+
+void transaction_database::enable_verification(size_t sample_rate)
+{
+    sample_rate_ = sample_rate;
+}
+
+float transaction_database::load_factor() const
+{
+    return hash_table_.load_factor();
+}
+
+float transaction_database::filter_false_positive_rate() const
+{
+    return filter_.false_positive_rate();
+}
+
+bool transaction_database::save_cache(const path& filename,
+    size_t top_height) const
+{
+    return cache_.save(filename, top_height);
+}
+
+bool transaction_database::load_cache(const path& filename,
+    size_t top_height)
+{
+    return cache_.load(filename, top_height);
 }
 
 bool transaction_database::close()
 {
-    return hash_table_file_.close();
+    // A filter that fails to save is rebuilt on open.
+    filter_.save(filter_filename_);
+    return hash_table_file_->close() && state_.close();
 }
 
 // Queries.
 // ----------------------------------------------------------------------------
 
+bool transaction_database::contains(file_offset link) const
+{
+    return hash_table_.contains(link);
+}
+
 transaction_result transaction_database::get(file_offset offset) const
 {
     // This is not guarded for an invalid offset.
-    return { hash_table_.find(offset), metadata_mutex_ };
+    return verified({ hash_table_.find(offset), metadata_lock_, state_ });
+}
+
+// The size of the last tx is not known, but read-ahead covers its page(s).
+scan_guard::ptr transaction_database::scan(file_offset first,
+    file_offset last) const
+{
+    BITCOIN_ASSERT(first <= last);
+    return hash_table_.scan(first, static_cast<size_t>(last - first) + 1u);
 }
 
 transaction_result transaction_database::get(const hash_digest& hash) const
 {
-    return { hash_table_.find(hash), metadata_mutex_ };
+    if (!filter_.contains(hash))
+        return { hash_table_.terminator(), metadata_lock_, state_ };
+
+    return verified({ hash_table_.find(hash), metadata_lock_, state_ });
+}
+
+// private
+// Sampling is by relaxed count, so concurrent reads may share a sample.
+transaction_result transaction_database::verified(
+    transaction_result&& result) const
+{
+    if (sample_rate_ == 0 || !result ||
+        reads_.fetch_add(1, std::memory_order_relaxed) % sample_rate_ != 0 ||
+        result.verify())
+        return std::move(result);
+
+    LOG_ERROR(LOG_DATABASE)
+        << "Transaction record checksum mismatch at link ["
+        << result.link() << "].";
+
+    corruptions_.fetch_add(1, std::memory_order_relaxed);
+    return { hash_table_.terminator(), metadata_lock_, state_ };
+}
+
+// The txs of a block are stored together, so are read ahead in bulk. The
+// stored transaction is const, so only the metadata read requires the lock.
+bool transaction_database::get_transactions(transaction::list& out_transactions,
+    const block_result& block, bool witness) const
+{
+    out_transactions.clear();
+    out_transactions.reserve(block.transaction_count());
+
+    if (block.transaction_count() == 0)
+        return true;
+
+    file_offset first = max_uint64;
+    file_offset last = 0;
+    for (const auto link: block)
+    {
+        first = std::min(first, link);
+        last = std::max(last, link);
+    }
+
+    const auto guard = scan(first, last);
+
+    for (const auto link: block)
+    {
+        const transaction_result result(hash_table_.find(link),
+            metadata_lock_, state_, false);
+
+        if (!result)
+            return false;
+
+        out_transactions.push_back(result.transaction(witness));
+    }
+
+    return true;
+}
+
+// Each tx is transcoded to wire from slices of its record, without
+// deserialization. A pruned tx has no payload, so its block is not served.
+bool transaction_database::get_block_data(data_chunk& out_data,
+    const block_result& block, bool witness) const
+{
+    if (!block || block.transaction_count() == 0)
+        return false;
+
+    file_offset first = max_uint64;
+    file_offset last = 0;
+    for (const auto link: block)
+    {
+        first = std::min(first, link);
+        last = std::max(last, link);
+    }
+
+    const auto guard = scan(first, last);
+    const auto start = out_data.size();
+    auto served = true;
+
+    {
+        data_sink ostream(out_data);
+        ostream_writer sink(ostream);
+        block.header().to_data(sink, true);
+        sink.write_variable_little_endian(block.transaction_count());
+
+        for (const auto link: block)
+        {
+            const transaction_result result(hash_table_.find(link),
+                metadata_lock_, state_, false);
+
+            if (!result || result.pruned())
+            {
+                served = false;
+                break;
+            }
+
+            result.view().to_data(sink, witness);
+        }
+
+        ostream.flush();
+    }
+
+    if (!served)
+        out_data.resize(start);
+
+    return served;
+}
+
+transaction_pool::transaction_ptr transaction_database::get_pooled(
+    const hash_digest& hash, uint32_t& out_forks) const
+{
+    return pool_.get(hash, out_forks);
 }
 
 void transaction_database::get_block_metadata( chain::transaction& tx,
@@ -153,7 +723,14 @@ void transaction_database::get_block_metadata( chain::transaction& tx,
 
     // Default values are correct for indication of not found.
     if (!result)
+    {
+        // A pooled tx is unlinked until stored with the block.
+        uint32_t pooled_forks;
+        if (pool_.get(tx.hash(), pooled_forks))
+            tx.metadata.verified = pooled_forks == forks;
+
         return;
+    }
 
     const auto bip34 = chain::script::is_enabled(forks,
         machine::rule_fork::bip34_rule);
@@ -189,7 +766,14 @@ void transaction_database::get_pool_metadata( chain::transaction& tx,
 
     // Default values presumed correct for indication of not found.
     if (!result)
+    {
+        // A pooled tx is unlinked, as it is not in the table.
+        uint32_t pooled_forks;
+        if (pool_.get(tx.hash(), pooled_forks))
+            tx.metadata.verified = pooled_forks == forks;
+
         return;
+    }
 
     tx.metadata.existed = tx.metadata.link !=
         transaction::validation::unlinked;
@@ -219,27 +803,238 @@ bool transaction_database::get_output(const output_point& point,
     const auto result = get(point.hash());
 
     if (!result)
-        return false;
+        return populate_pooled(point);
 
-    //*************************************************************************
-    // CONSENSUS: The genesis block coinbase output may not be spent. This is
-    // the consequence of satoshi not including it in the utxo set for block
-    // database initialization. Only he knows why, probably an oversight.
-    //*************************************************************************
-    const auto height = result.height();
-    if (height == 0)
-        return false;
+    remember(point.hash(), result.link());
+    return populate(point, result, fork_height, candidate);
+}
 
-    // Find the output at the specified index for the found tx.
-    prevout.cache = result.output(point.index());
-    if (!prevout.cache.is_valid())
+// This serves the double spend check without decoding the prevout, so the
+// spend state is as populated by get_output for the same context.
+bool transaction_database::is_spent(const output_point& point,
+    size_t fork_height, bool candidate) const
+{
+    if (point.is_null())
         return false;
 
-    // Populate the output metadata.
-    const auto position = result.position();
-    prevout.candidate = result.candidate();
-    prevout.coinbase = position == 0;
-    prevout.confirmed = position != transaction_result::unconfirmed &&
+    const auto result = get(point.hash());
+    return result && result.is_spent(point.index(), fork_height, candidate);
+}
+
+// Prevouts are resolved in phases so that each is a parallel pass: cache
+// probes, one hash lookup for each distinct previous tx (with its bucket row
+// advised ahead of the walk), then population in order of tx link so that
+// the slab file is read front to back.
+size_t transaction_database::get_outputs(const block& block,
+    size_t fork_height, bool candidate) const
+{
+    std::vector<const output_point*> points;
+
+    for (const auto& tx: block.transactions())
+        for (const auto& input: tx.inputs())
+            if (!input.previous_output().is_null())
+                points.push_back(&input.previous_output());
+
+    const auto count = points.size();
+    std::vector<uint8_t> cached(count, 0);
+
+    const auto probe = [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+        {
+            auto& prevout = points[index]->metadata;
+            prevout.height = 0;
+            prevout.median_time_past = 0;
+            prevout.spent = false;
+            cached[index] = cache_.populate(*points[index], fork_height);
+        }
+    };
+
+    parallel_for(count, threads_, minimum_partition, probe);
+
+    // Group the remaining points by previous tx hash.
+    std::vector<const output_point*> missed;
+    for (size_t index = 0; index < count; ++index)
+        if (cached[index] == 0)
+            missed.push_back(points[index]);
+
+    const auto by_hash = [](const output_point* left,
+        const output_point* right)
+    {
+        return left->hash() < right->hash();
+    };
+
+    std::sort(missed.begin(), missed.end(), by_hash);
+
+    // Each group is [first, last) of missed, with the link of its tx.
+    struct group
+    {
+        size_t first;
+        size_t last;
+        file_offset link;
+    };
+
+    std::vector<group> groups;
+    for (size_t index = 0; index < missed.size(); ++index)
+    {
+        if (groups.empty() || missed[index]->hash() !=
+            missed[groups.back().first]->hash())
+        {
+            groups.push_back({ index, index + 1, slab_map::not_found });
+            hash_table_.prefetch(missed[index]->hash());
+        }
+        else
+        {
+            groups.back().last = index + 1;
+        }
+    }
+
+    const auto find = [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+        {
+            auto& entry = groups[index];
+            const auto& hash = missed[entry.first]->hash();
+            const auto result = get(hash);
+
+            if (result)
+            {
+                entry.link = result.link();
+                remember(hash, entry.link);
+            }
+        }
+    };
+
+    parallel_for(groups.size(), threads_, minimum_partition, find);
+
+    const auto by_link = [](const group& left, const group& right)
+    {
+        return left.link < right.link;
+    };
+
+    std::sort(groups.begin(), groups.end(), by_link);
+
+    // Not found groups sort last and are populated from the pool, if any.
+    size_t pooled = 0;
+    while (!groups.empty() && groups.back().link == slab_map::not_found)
+    {
+        const auto& entry = groups.back();
+
+        for (auto point = entry.first; point < entry.last; ++point)
+            if (populate_pooled(*missed[point]))
+                ++pooled;
+
+        groups.pop_back();
+    }
+
+    // The links are known up front, so fault their slabs in as one batch.
+    std::vector<link_type> links;
+    links.reserve(groups.size());
+
+    for (const auto& entry: groups)
+        links.push_back(entry.link);
+
+    hash_table_.prefetch(links, prevout_prefetch_size);
+
+    std::vector<size_t> found(groups.size(), 0);
+
+    const auto fill = [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+        {
+            const auto& entry = groups[index];
+            const auto result = get(entry.link);
+
+            for (auto point = entry.first; point < entry.last; ++point)
+                if (populate(*missed[point], result, fork_height, candidate))
+                    ++found[index];
+        }
+    };
+
+    parallel_for(groups.size(), threads_, minimum_partition, fill);
+
+    size_t populated = count - missed.size() + pooled;
+    for (const auto value: found)
+        populated += value;
+
+    return populated;
+}
+
+// private
+// Validation precedes candidacy and confirmation of the block, so the txs of
+// its prevouts are usually found here moments before they are spent.
+void transaction_database::remember(const hash_digest& hash,
+    link_type link) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(spent_links_mutex_);
+
+    if (spent_links_.size() >= maximum_spent_links)
+        spent_links_.clear();
+
+    spent_links_.emplace(hash, link);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// The tx of a linked input point is remembered by its link (pointer chase).
+void transaction_database::remember(const inpoint_iterator& inpoint) const
+{
+    if (inpoint.parent() != not_linked)
+        remember((*inpoint).hash(), inpoint.parent());
+}
+
+// private
+// Links are never invalidated, so a remembered link is found without search.
+transaction_database::slab_map::const_value_type
+transaction_database::find_spent(const hash_digest& hash) const
+{
+    link_type link = slab_map::not_found;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(spent_links_mutex_);
+        const auto it = spent_links_.find(hash);
+
+        if (it != spent_links_.end())
+            link = it->second;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    return link == slab_map::not_found ? hash_table_.find(hash) :
+        hash_table_.find(link);
+}
+
+// private
+bool transaction_database::populate(const output_point& point,
+    const transaction_result& result, size_t fork_height, bool candidate) const
+{
+    auto& prevout = point.metadata;
+
+    if (!result)
+        return false;
+
+    //*************************************************************************
+    // CONSENSUS: The genesis block coinbase output may not be spent. This is
+    // the consequence of satoshi not including it in the utxo set for block
+    // database initialization. Only he knows why, probably an oversight.
+    //*************************************************************************
+    const auto height = result.height();
+    if (height == 0)
+        return false;
+
+    // Find the output at the specified index for the found tx.
+    prevout.cache = result.output(point.index());
+    if (!prevout.cache.is_valid())
+        return false;
+
+    // Populate the output metadata.
+    const auto position = result.position();
+    prevout.candidate = result.candidate();
+    prevout.coinbase = position == 0;
+    prevout.confirmed = position != transaction_result::unconfirmed &&
         height <= fork_height;
     prevout.height = height;
     prevout.median_time_past = result.median_time_past();
@@ -249,34 +1044,221 @@ bool transaction_database::get_output(const output_point& point,
     return true;
 }
 
+// private
+// A pooled tx is unconfirmed and its outputs are not marked as spent (as in
+// the table), its height is the forks at which it was validated.
+bool transaction_database::populate_pooled(const output_point& point) const
+{
+    uint32_t forks;
+    const auto tx = pool_.get(point.hash(), forks);
+
+    if (!tx || point.index() >= tx->outputs().size())
+        return false;
+
+    auto& prevout = point.metadata;
+    prevout.cache = tx->outputs()[point.index()];
+    prevout.candidate = false;
+    prevout.coinbase = false;
+    prevout.confirmed = false;
+    prevout.height = forks;
+    prevout.median_time_past = 0;
+    prevout.spent = false;
+    return true;
+}
+
 // Store.
 // ----------------------------------------------------------------------------
 
 // Store new unconfirmed tx and set tx link metadata in any case.
+// If pooled the tx is held in memory and remains unlinked until it is stored
+// with a block, at which point it is written to the table (in block order).
 bool transaction_database::store( chain::transaction& tx, uint32_t forks)
 {
-    return storize(tx, forks, no_time, transaction_result::unconfirmed);
+    if (pool_.disabled())
+        return storize(tx, forks, no_time, transaction_result::unconfirmed);
+
+    if (tx.metadata.link == transaction::validation::unlinked)
+    {
+        const auto result = get(tx.hash());
+
+        if (result)
+            tx.metadata.link = result.link();
+    }
+
+    tx.metadata.existed = tx.metadata.link != transaction::validation::unlinked;
+
+    if (!tx.metadata.existed)
+        pool_.add(tx, forks);
+
+    return true;
 }
 
 // Store each new tx of the unconfirmed block and set tx link metadata for all.
 bool transaction_database::store( transaction::list& transactions)
 {
-    for ( auto& tx: transactions)
-        if (!storize(tx, rule_fork::unverified, no_time,
-            transaction_result::unconfirmed))
-            return false;
+    return storize(transactions, rule_fork::unverified, no_time, false,
+        false);
+}
 
-    return true;
+// Store each unlinked tx of the unconfirmed block without existence lookup,
+// as the caller has linked those that are stored (e.g. from its tx pool).
+bool transaction_database::store( transaction::list& transactions,
+    bool linked)
+{
+    return storize(transactions, rule_fork::unverified, no_time, false,
+        linked);
 }
 
 // Store each new tx of the confirmed block and set tx link metadata for all.
 bool transaction_database::store( chain::transaction::list& transactions,
     size_t height, uint32_t median_time_past)
 {
-    size_t position = 0;
-    for ( auto& tx: transactions)
-        if (!storize(tx, height, median_time_past, position++))
-            return false;
+    return storize(transactions, height, median_time_past, true, false);
+}
+
+// private
+// The new transactions of the block are allocated as one slab range and
+// linked in one critical section, instead of once for each transaction.
+// Existence probes and serialization are independent for each transaction
+// and are partitioned across store threads, only linking is serial.
+bool transaction_database::storize( transaction::list& transactions,
+    size_t height, uint32_t median_time_past, bool confirmed, bool linked)
+{
+    BITCOIN_ASSERT(height <= max_uint32);
+    BITCOIN_ASSERT(transactions.size() <= max_uint16);
+
+    const auto count = transactions.size();
+    const auto checked = checksums_ && split_;
+    std::vector<size_t> sizes(count, 0);
+    std::vector<size_t> records(count, 0);
+    std::vector<std::vector<link_type>> parents(count);
+
+    const auto probe = [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+        {
+            auto& tx = transactions[index];
+
+            // Assume the caller has not tested for existence unless linked.
+            if (!linked &&
+                tx.metadata.link == transaction::validation::unlinked)
+            {
+                const auto result = get(tx.hash());
+
+                if (result)
+                    tx.metadata.link = result.link();
+            }
+
+            // This allows address indexer to bypass indexing despite existence.
+            tx.metadata.existed = tx.metadata.link !=
+                transaction::validation::unlinked;
+
+            // Existing transactions are not stored (zero size).
+            if (!tx.metadata.existed)
+            {
+                parents[index] = link_inputs(tx);
+                records[index] = header_size(split_) + table_size(tx) +
+                    payload_size(tx, compact(tx), parents[index]);
+                sizes[index] = slab_map::value_type::size(records[index] +
+                    trailer_size(checked));
+            }
+        }
+    };
+
+    parallel_for(count, threads_, minimum_partition, probe);
+
+    // Assign each new transaction its offset within the range.
+    size_t total = 0;
+    std::vector<size_t> stored;
+    std::vector<link_type> offsets;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        if (sizes[index] == 0)
+            continue;
+
+        stored.push_back(index);
+        offsets.push_back(total);
+        total += sizes[index];
+    }
+
+    if (stored.empty())
+        return true;
+
+    const auto base = hash_table_.allocate(total);
+    std::vector<slab_map::value_type> elements(stored.size(),
+        hash_table_.allocator());
+
+    // Assign each new transaction its state ordinals, if split.
+    link_type first_state = 0;
+    std::vector<link_type> outputs;
+
+    if (split_)
+    {
+        link_type next = 0;
+        for (const auto index: stored)
+        {
+            outputs.push_back(next);
+            next += transactions[index].outputs().size();
+        }
+
+        first_state = state_.allocate_transactions(stored.size());
+        const auto first_output = state_.allocate_outputs(next);
+
+        for (auto& output: outputs)
+            output += first_output;
+    }
+
+    const auto serialize = [&](size_t first, size_t last)
+    {
+        for (auto slot = first; slot < last; ++slot)
+        {
+            const auto index = stored[slot];
+            auto& tx = transactions[index];
+            const auto position = confirmed ? index :
+                transaction_result::unconfirmed;
+            const auto compacted = compact(tx);
+            const auto& links = parents[index];
+
+            if (split_)
+                store_state(tx, first_state + slot, outputs[slot], height,
+                    position, median_time_past);
+
+            const auto writer = [&](byte_serializer& serial)
+            {
+                serial.write_4_bytes_little_endian(
+                    static_cast<uint32_t>(height));
+                serial.write_2_bytes_little_endian(
+                    static_cast<uint16_t>(position));
+                write_state(serial, tx, compacted, !links.empty(), split_,
+                    checked);
+                serial.write_4_bytes_little_endian(median_time_past);
+
+                if (split_)
+                    write_split(serial, first_state + slot, outputs[slot]);
+
+                write_table(serial, tx, compacted);
+                write_payload(serial, tx, compacted, links);
+            };
+
+            tx.metadata.link = elements[slot].create(base + offsets[slot],
+                tx.hash(), writer);
+
+            if (checked)
+                write_checksum(elements[slot], records[index]);
+        }
+    };
+
+    parallel_for(stored.size(), threads_, minimum_partition, serialize);
+
+    for (const auto index: stored)
+        filter_.insert(transactions[index].hash());
+
+    hash_table_.link(elements);
+
+    // Pooled txs are promoted to the table by store, so are no longer pooled.
+    for (const auto index: stored)
+        pool_.remove(transactions[index].hash());
 
     return true;
 }
@@ -305,23 +1287,125 @@ bool transaction_database::storize( chain::transaction& tx, size_t height,
     if (tx.metadata.existed)
         return true;
 
+    tx.metadata.link = write(tx.hash(), tx, height, median_time_past,
+        position);
+    return true;
+}
+
+// private
+// Write and link a new record of the tx under the key (its hash).
+transaction_database::link_type transaction_database::write(
+    const hash_digest& key, const transaction& tx, size_t height,
+    uint32_t median_time_past, size_t position)
+{
+    const auto compacted = compact(tx);
+    const auto links = link_inputs(tx);
+    const auto checked = checksums_ && split_;
+
+    link_type state = 0;
+    link_type outputs = 0;
+
+    if (split_)
+    {
+        state = state_.allocate_transactions(1);
+        outputs = state_.allocate_outputs(tx.outputs().size());
+        store_state(tx, state, outputs, height, position, median_time_past);
+    }
+
     const auto writer = [&](byte_serializer& serial)
     {
         serial.write_4_bytes_little_endian(static_cast<uint32_t>(height));
         serial.write_2_bytes_little_endian(static_cast<uint16_t>(position));
-        serial.write_byte(transaction_result::candidate_false);
+        write_state(serial, tx, compacted, !links.empty(), split_, checked);
         serial.write_4_bytes_little_endian(median_time_past);
-        tx.to_data(serial, false, true);
+
+        if (split_)
+            write_split(serial, state, outputs);
+
+        write_table(serial, tx, compacted);
+        write_payload(serial, tx, compacted, links);
     };
 
     // Transactions are variable-sized.
-    const auto size = metadata_size + tx.serialized_size(false, true);
+    const auto size = header_size(split_) + table_size(tx) +
+        payload_size(tx, compacted, links);
 
     // Write the new transaction.
     auto next = hash_table_.allocator();
-    tx.metadata.link = next.create(tx.hash(), writer, size);
+    const auto link = next.create(key, writer, size + trailer_size(checked));
+
+    if (checked)
+        write_checksum(next, size);
+
+    filter_.insert(key);
     hash_table_.link(next);
-    return true;
+    return link;
+}
+
+// private
+// New state records are journaled by allocation, so are not journaled here.
+void transaction_database::store_state(const transaction& tx,
+    link_type state, link_type outputs, size_t height, size_t position,
+    uint32_t median_time_past) const
+{
+    const auto memory = state_.transaction(state);
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(height));
+    serial.write_2_bytes_little_endian(static_cast<uint16_t>(position));
+    serial.write_byte(transaction_result::candidate_false);
+    serial.write_4_bytes_little_endian(median_time_past);
+
+    // The stored encoding of each output begins with its spend metadata.
+    for (const auto& output: tx.outputs())
+    {
+        const auto data = output.to_data(false);
+        const auto spend = state_.output(outputs++);
+        std::copy_n(data.begin(), state_table::output_size, spend->buffer());
+    }
+}
+
+// private
+// The format flags and ordinals are set only on store, so are not guarded.
+bool transaction_database::find_state(const slab_map::const_value_type& element,
+    link_type& out_state, link_type& out_outputs) const
+{
+    auto split = false;
+    const auto reader = [&](byte_deserializer& deserial)
+    {
+        split = transaction_result::read_split(deserial, out_state,
+            out_outputs);
+    };
+
+    element.read(reader);
+    return split;
+}
+
+// private
+bool transaction_database::compact(const transaction& tx) const
+{
+    return compact_ && compact_codec::compactable(tx);
+}
+
+// private
+// Previous txs are usually remembered from validation, so found by link.
+// A previous tx in the same block is not yet stored, so is not linked.
+std::vector<transaction_database::link_type>
+transaction_database::link_inputs(const transaction& tx) const
+{
+    if (!linked_)
+        return {};
+
+    std::vector<link_type> parents;
+    parents.reserve(tx.inputs().size());
+
+    for (const auto& input: tx.inputs())
+    {
+        const auto& prevout = input.previous_output();
+        parents.push_back(prevout.is_null() ? not_linked :
+            find_spent(prevout.hash()).link());
+    }
+
+    return parents;
 }
 
 // Candidate/Uncandidate.
@@ -341,9 +1425,13 @@ bool transaction_database::candidate(file_offset link, bool positive)
         return false;
 
     // Spend or unspend the candidate tx's previous outputs.
-    for ( auto inpoint: result)
-        if (!candidate_spend(inpoint, positive))
+    for (auto it = result.begin(); it != result.end(); ++it)
+    {
+        remember(it);
+
+        if (!candidate_spend(*it, positive))
             return false;
+    }
 
     return true;
 }
@@ -353,57 +1441,219 @@ bool transaction_database::uncandidate(file_offset link)
     return candidate(link, false);
 }
 
+// The txs are marked before spends, so spends within the block locate txs of
+// the block. Spends of one tx fall in one group, so writes do not overlap.
+bool transaction_database::candidate(const transaction::list& transactions)
+{
+    block_arena::scope release(arena_);
+
+    for (const auto& tx: transactions)
+        if (!candidize(tx.metadata.link, true))
+            return false;
+
+    return candidate_spend(transactions, true);
+}
+
 // private
-bool transaction_database::candidate_spend(const chain::output_point& point,
-    bool positive)
+// Spent outputs are located first, grouped by spent tx, so that each spent
+// tx is found once. All outputs are then written in one critical section.
+bool transaction_database::locate_spends(const transaction::list& transactions,
+    bool confirmed, size_t spender_height, spend_targets& targets) const
 {
-    // This just simplifies calling by allowing coinbase to be included.
-    if (point.is_null())
-        return true;
+    point_list points(arena_);
+
+    for (const auto& tx: transactions)
+        for (const auto& input: tx.inputs())
+            if (!input.previous_output().is_null())
+                points.push_back(&input.previous_output());
+
+    return locate_spends(points, confirmed, spender_height, targets);
+}
+
+// private
+// Each spent tx is located by one thread, which writes the targets of its
+// points in place, so the targets remain in order of spent tx.
+bool transaction_database::locate_spends(point_list& points,
+    bool confirmed, size_t spender_height, spend_targets& targets) const
+{
+    const auto by_hash = [](const output_point* left,
+        const output_point* right)
+    {
+        return left->hash() < right->hash();
+    };
 
-    const auto element = hash_table_.find(point.hash());
+    std::sort(points.begin(), points.end(), by_hash);
+
+    spend_groups groups(arena_);
+    for (size_t first = 0, last = 0; first < points.size(); first = last)
+    {
+        const auto& hash = points[first]->hash();
+        for (last = first + 1u; last < points.size() &&
+            points[last]->hash() == hash; ++last);
+
+        groups.push_back({ first, last });
+    }
+
+    const auto base = targets.size();
+    targets.resize(base + points.size());
+    std::atomic<bool> located(true);
+
+    const auto locate = [&](size_t first, size_t last)
+    {
+        for (auto group = first; group < last && located; ++group)
+            if (!locate_spends(points, groups[group], confirmed,
+                spender_height, &targets[base]))
+                located = false;
+    };
+
+    parallel_for(groups.size(), threads_, minimum_partition, locate);
+    return located;
+}
+
+// private
+bool transaction_database::locate_spends(const point_list& points,
+    const spend_group& group, bool confirmed, size_t spender_height,
+    spend_target* targets) const
+{
+    const auto element = find_spent(points[group.first]->hash());
 
     if (!element)
         return false;
 
-    size_t outputs;
-    const auto reader = [&](byte_deserializer& deserial)
+    // The memory is pinned while the outputs of the tx are located.
+    const auto memory = element.state();
+
+    link_type ordinal;
+    link_type outputs;
+    auto header = make_unsafe_deserializer(memory->buffer());
+    const auto split = transaction_result::read_split(header, ordinal,
+        outputs);
+
+    if (confirmed)
     {
-        // Critical Section
-        ///////////////////////////////////////////////////////////////////////
-        shared_lock lock(metadata_mutex_);
-        deserial.skip(metadata_size);
-        outputs = deserial.read_size_little_endian();
-        ///////////////////////////////////////////////////////////////////////
-    };
+        // The state of a split tx is read from its state record.
+        const auto state = split ? state_.transaction(ordinal) : memory;
+        uint32_t height;
+        uint16_t position;
 
-    element.read(reader);
+        metadata_lock_.read([&]()
+        {
+            auto deserial = make_unsafe_deserializer(state->buffer());
+            height = deserial.read_4_bytes_little_endian();
+            position = deserial.read_2_bytes_little_endian();
+        });
+
+        // Limit to confirmed transactions at or below the spender height.
+        if (position == transaction_result::unconfirmed ||
+            height > spender_height)
+            return false;
+    }
+
+    for (auto point = group.first; point < group.last; ++point)
+    {
+        const auto index = points[point]->index();
+        auto deserial = make_unsafe_deserializer(memory->buffer());
+
+        size_t offset;
+        const auto count = transaction_result::seek_output(deserial,
+            index, offset);
+
+        // The index is not in the transaction.
+        if (index >= count)
+            return false;
+
+        targets[point] = { element.link(), offset,
+            split ? outputs + index : not_split };
+    }
+
+    return true;
+}
 
-    // The index is not in the transaction.
-    if (point.index() >= outputs)
+// private
+bool transaction_database::candidate_spend(
+    const transaction::list& transactions, bool positive)
+{
+    block_arena::scope release(arena_);
+    spend_targets targets(arena_);
+    if (!locate_spends(transactions, false, 0, targets))
         return false;
 
-    const auto writer = [&](byte_serializer& serial)
+    candidate_spend(targets, positive);
+    return true;
+}
+
+// private
+// The spend state of a split tx is written to its output state record. The
+// targets of each spent tx are contiguous, and are written by one thread, so
+// no two threads write the same record. The lock is held across the writes.
+void transaction_database::candidate_spend(const spend_targets& targets,
+    bool positive)
+{
+    const auto spent = positive ? transaction_result::candidate_true :
+        transaction_result::candidate_false;
+
+    spend_groups groups(arena_);
+    for (size_t first = 0, last = 0; first < targets.size(); first = last)
     {
-        serial.skip(metadata_size);
-        serial.read_size_little_endian();
+        const auto link = targets[first].link;
+        for (last = first + 1u; last < targets.size() &&
+            targets[last].link == link; ++last);
+
+        groups.push_back({ first, last });
+    }
 
-        // Skip outputs until the target output.
-        for (auto output = 0u; output < point.index(); ++output)
+    const auto write = [&](size_t first, size_t last)
+    {
+        for (auto group = first; group < last; ++group)
         {
-            serial.skip(spend_size);
-            serial.skip(serial.read_size_little_endian());
+            const auto& entry = groups[group];
+            const auto element = hash_table_.find(targets[entry.first].link);
+
+            for (auto index = entry.first; index < entry.last; ++index)
+            {
+                const auto& target = targets[index];
+
+                if (target.state != not_split)
+                    *state_.output(target.state)->buffer() = spent;
+                else
+                    element.write_little_endian(target.offset, spent);
+            }
         }
-
-        // Critical Section
-        ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(metadata_mutex_);
-        serial.write_byte(positive ? transaction_result::candidate_true :
-            transaction_result::candidate_false);
-        ///////////////////////////////////////////////////////////////////////
     };
 
-    element.write(writer);
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        sequence_lock::scope lock(metadata_lock_);
+        parallel_for(groups.size(), threads_, minimum_partition, write);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& target: targets)
+    {
+        if (target.state != not_split)
+            state_.journal_output(target.state, 0, candidate_spent_size);
+        else
+            hash_table_.find(target.link).journal(target.offset,
+                candidate_spent_size);
+    }
+}
+
+// private
+bool transaction_database::candidate_spend(const chain::output_point& point,
+    bool positive)
+{
+    // This just simplifies calling by allowing coinbase to be included.
+    if (point.is_null())
+        return true;
+
+    block_arena::scope release(arena_);
+    spend_targets targets(arena_);
+    point_list points(1, &point, arena_);
+    if (!locate_spends(points, false, 0, targets))
+        return false;
+
+    candidate_spend(targets, positive);
     return true;
 }
 
@@ -415,32 +1665,71 @@ bool transaction_database::candidize(link_type link, bool candidate)
     if (!element)
         return false;
 
-    const auto writer = [&](byte_serializer& serial)
+    link_type state;
+    link_type outputs;
+    if (find_state(element, state, outputs))
     {
+        const auto memory = state_.transaction(state);
+        auto serial = make_unsafe_serializer(memory->buffer());
+        serial.skip(height_size + position_size);
+
         // Critical Section
         ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(metadata_mutex_);
-        serial.skip(height_size + position_size);
-        serial.write_byte(candidate ? transaction_result::candidate_true :
-            transaction_result::candidate_false);
+        {
+            sequence_lock::scope lock(metadata_lock_);
+            serial.write_byte(candidate ? transaction_result::candidate_true :
+                transaction_result::candidate_false);
+        }
         ///////////////////////////////////////////////////////////////////////
-    };
 
-    element.write(writer);
+        state_.journal_transaction(state, height_size + position_size,
+            candidate_size);
+        return true;
+    }
+
+    // The format flags are set only on store, so this read is not guarded.
+    const auto flags = element.read_little_endian<uint8_t>(height_size +
+        position_size) & format_flags;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        sequence_lock::scope lock(metadata_lock_);
+        element.write_little_endian(height_size + position_size,
+            static_cast<uint8_t>(flags | (candidate ?
+                transaction_result::candidate_true :
+                transaction_result::candidate_false)));
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    element.journal(height_size + position_size, candidate_size);
     return true;
 }
 
 // Confirm/Unconfirm.
 // ----------------------------------------------------------------------------
 
-bool transaction_database::confirm( transaction::list& transactions,
+// The txs are promoted before spends so that spends within the block are of
+// confirmed txs. Spent outputs are not cached as spends precede caching.
+bool transaction_database::confirm(const transaction::list& transactions,
     size_t height, uint32_t median_time_past)
 {
+    block_arena::scope release(arena_);
     uint32_t position = 0;
     for (const auto& tx: transactions)
-        if (!confirm(tx.metadata.link, height, median_time_past, position++))
+        if (!confirmize(tx.metadata.link, height, median_time_past,
+            position++))
             return false;
 
+    if (!confirmed_spend(transactions, height))
+        return false;
+
+    // TODO: It may be more costly to populate the tx than the cache benefit.
+    if (!cache_.disabled())
+        for (const auto& tx: transactions)
+            cache_.add(get(tx.metadata.link).transaction(), height,
+                median_time_past, true);
+
     return true;
 }
 
@@ -453,9 +1742,13 @@ bool transaction_database::confirm(file_offset link, size_t height,
         return false;
 
     // Spend or unspend the tx's previous outputs.
-    for ( auto inpoint: result)
-        if (!confirmed_spend(inpoint, height))
+    for (auto it = result.begin(); it != result.end(); ++it)
+    {
+        remember(it);
+
+        if (!confirmed_spend(*it, height))
             return false;
+    }
 
     const auto confirmed = position != transaction_result::unconfirmed;
 
@@ -474,6 +1767,61 @@ bool transaction_database::unconfirm(file_offset link)
         transaction_result::unconfirmed);
 }
 
+// Spends are reset before any tx is demoted, as the txs may spend each other
+// and only confirmed spent txs are located. Outputs of the txs are removed
+// from the cache rather than reread to cache them as unconfirmed.
+bool transaction_database::unconfirm(const std::vector<file_offset>& links)
+{
+    output_point::list inpoints;
+
+    for (const auto link: links)
+    {
+        const auto result = get(link);
+
+        if (!result)
+            return false;
+
+        for (auto it = result.begin(); it != result.end(); ++it)
+        {
+            if ((*it).is_null())
+                continue;
+
+            remember(it);
+            inpoints.push_back(*it);
+        }
+
+        if (!cache_.disabled())
+            cache_.remove(result.hash());
+    }
+
+    block_arena::scope release(arena_);
+    point_list points(arena_);
+    points.reserve(inpoints.size());
+
+    for (const auto& inpoint: inpoints)
+    {
+        // When unspending could restore the spend to the cache, but not worth it.
+        if (!cache_.disabled())
+            cache_.remove(inpoint);
+
+        points.push_back(&inpoint);
+    }
+
+    spend_targets targets(arena_);
+    if (!locate_spends(points, true, rule_fork::unverified, targets))
+        return false;
+
+    // The txs were verified under a now unknown chain state, so unverified.
+    confirmed_spend(targets, rule_fork::unverified);
+
+    for (const auto link: links)
+        if (!confirmize(link, rule_fork::unverified, no_time,
+            transaction_result::unconfirmed))
+            return false;
+
+    return true;
+}
+
 // private
 bool transaction_database::confirmed_spend(const output_point& point,
     size_t spender_height)
@@ -488,59 +1836,67 @@ bool transaction_database::confirmed_spend(const output_point& point,
     if (unspend && !cache_.disabled())
         cache_.remove(point);
 
-    const auto element = hash_table_.find(point.hash());
-
-    if (!element)
+    // Limited to confirmed transactions at or below the spender height.
+    block_arena::scope release(arena_);
+    spend_targets targets(arena_);
+    point_list points(1, &point, arena_);
+    if (!locate_spends(points, true, spender_height, targets))
         return false;
 
-    size_t outputs;
-    uint32_t height;
-    uint16_t position;
-    const auto reader = [&](byte_deserializer& deserial)
-    {
-        // Critical Section
-        ///////////////////////////////////////////////////////////////////////
-        shared_lock lock(metadata_mutex_);
-        height = deserial.read_4_bytes_little_endian();
-        position = deserial.read_2_bytes_little_endian();
-        deserial.skip(candidate_size + median_time_past_size);
-        outputs = deserial.read_size_little_endian();
-        ///////////////////////////////////////////////////////////////////////
-    };
-
-    element.read(reader);
+    confirmed_spend(targets, spender_height);
+    return true;
+}
 
-    // Limit to confirmed transactions at or below the spender height.
-    if (position == transaction_result::unconfirmed || height > spender_height)
+// private
+bool transaction_database::confirmed_spend(
+    const transaction::list& transactions, size_t spender_height)
+{
+    block_arena::scope release(arena_);
+    spend_targets targets(arena_);
+    if (!locate_spends(transactions, true, spender_height, targets))
         return false;
 
-    // The index is not in the transaction.
-    if (point.index() >= outputs)
-        return false;
+    confirmed_spend(targets, spender_height);
+    return true;
+}
 
-    const auto writer = [&](byte_serializer& serial)
+// private
+void transaction_database::confirmed_spend(const spend_targets& targets,
+    size_t spender_height)
+{
+    const auto height = static_cast<uint32_t>(spender_height);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
     {
-        serial.skip(metadata_size);
-        serial.read_size_little_endian();
+        sequence_lock::scope lock(metadata_lock_);
 
-        // Skip outputs until the target output.
-        for (auto output = 0u; output < point.index(); ++output)
+        for (const auto& target: targets)
         {
-            serial.skip(spend_size);
-            serial.skip(serial.read_size_little_endian());
+            if (target.state != not_split)
+            {
+                const auto memory = state_.output(target.state);
+                auto serial = make_unsafe_serializer(memory->buffer());
+                serial.skip(candidate_spent_size);
+                serial.write_4_bytes_little_endian(height);
+                continue;
+            }
+
+            hash_table_.find(target.link).write_little_endian(target.offset +
+                candidate_spent_size, height);
         }
+    }
+    ///////////////////////////////////////////////////////////////////////////
 
-        serial.skip(candidate_spent_size);
-
-        // Critical Section
-        ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(metadata_mutex_);
-        serial.write_4_bytes_little_endian(spender_height);
-        ///////////////////////////////////////////////////////////////////////
-    };
-
-    element.write(writer);
-    return true;
+    for (const auto& target: targets)
+    {
+        if (target.state != not_split)
+            state_.journal_output(target.state, candidate_spent_size,
+                height_size);
+        else
+            hash_table_.find(target.link).journal(target.offset +
+                candidate_spent_size, height_size);
+    }
 }
 
 // private
@@ -554,21 +1910,398 @@ bool transaction_database::confirmize(link_type link, size_t height,
     if (!element)
         return false;
 
+    link_type state;
+    link_type outputs;
+    if (find_state(element, state, outputs))
+    {
+        const auto memory = state_.transaction(state);
+        auto serial = make_unsafe_serializer(memory->buffer());
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        {
+            sequence_lock::scope lock(metadata_lock_);
+            serial.write_4_bytes_little_endian(static_cast<uint32_t>(height));
+            serial.write_2_bytes_little_endian(
+                static_cast<uint16_t>(position));
+            serial.write_byte(transaction_result::candidate_false);
+            serial.write_4_bytes_little_endian(median_time_past);
+        }
+        ///////////////////////////////////////////////////////////////////////
+
+        state_.journal_transaction(state, 0, metadata_size);
+        return true;
+    }
+
+    // The format flags are set only on store, so this read is not guarded.
+    uint8_t flags;
+    const auto reader = [&](byte_deserializer& deserial)
+    {
+        deserial.skip(height_size + position_size);
+        flags = deserial.read_byte() & format_flags;
+    };
+
+    element.read(reader);
+
     const auto writer = [&](byte_serializer& serial)
     {
         // Critical Section
         ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(metadata_mutex_);
+        sequence_lock::scope lock(metadata_lock_);
         serial.write_4_bytes_little_endian(static_cast<uint32_t>(height));
         serial.write_2_bytes_little_endian(static_cast<uint16_t>(position));
-        serial.write_byte(transaction_result::candidate_false);
+        serial.write_byte(flags | transaction_result::candidate_false);
         serial.write_4_bytes_little_endian(median_time_past);
         ///////////////////////////////////////////////////////////////////////
     };
 
     element.write(writer);
+    element.journal(0, metadata_size);
+    return true;
+}
+
+// Prune.
+// ----------------------------------------------------------------------------
+
+// A tx is pruned as the last of its spends is confirmed at the height, so the
+// parents of the txs confirmed at each height are visited once.
+size_t transaction_database::prune(const std::vector<file_offset>& links,
+    size_t height)
+{
+    std::unordered_set<link_type> parents;
+
+    for (const auto link: links)
+    {
+        const auto result = get(link);
+
+        if (!result)
+            continue;
+
+        for (auto it = result.begin(); it != result.end(); ++it)
+        {
+            if ((*it).is_null())
+                continue;
+
+            const auto parent = it.parent() != not_linked ? it.parent() :
+                hash_table_.find((*it).hash()).link();
+
+            if (parent != slab_map::not_found)
+                parents.insert(parent);
+        }
+    }
+
+    size_t pruned = 0;
+    for (const auto parent: parents)
+        if (prune(parent, height))
+            ++pruned;
+
+    return pruned;
+}
+
+// private
+// The state ordinals are retained, so the state of a split tx is unchanged.
+// A pruned tx is read only as spent, so its spends must not be reorganized.
+bool transaction_database::prune(link_type link, size_t height)
+{
+    const auto result = get(link);
+
+    if (!result || result.pruned() || !result.is_spent(height, false))
+        return false;
+
+    const auto element = hash_table_.find(link);
+
+    // The format flags are set only on store, so this read is not guarded.
+    const auto state = element.read_little_endian<uint8_t>(height_size +
+        position_size);
+    const auto split = (state & transaction_result::state_split) != 0;
+    const auto first = header_size(split);
+    const auto last = result.view().record_size();
+
+    // The released range reads as zero outputs, inputs, locktime and version.
+    element.release(first, last - first);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        sequence_lock::scope lock(metadata_lock_);
+        element.write_little_endian(height_size + position_size,
+            static_cast<uint8_t>((state & ~payload_flags) |
+                transaction_result::payload_pruned));
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    element.journal(height_size + position_size, candidate_size);
     return true;
 }
 
+// Snapshot.
+// ----------------------------------------------------------------------------
+// [ magic:4 ][ version:4 ][ height:4 ][ block_hash:32 ]
+// [ transactions:8 ][ outputs:8 ]
+// [
+//   [ transactions:4 ][ size:4 ][ checksum:4 ] (zero transactions terminates)
+//   [
+//     [ hash:32 ][ height:4 ][ position:2 ][ median_time_past:4 ]
+//     [ output_count:varint ][ unspent_count:varint ]
+//     [ [ index:varint ][ output (wire) ] ]...
+//   ]...
+// ]...
+
+static void write_snapshot_header(bc::ofstream& file, size_t height,
+    const hash_digest& block_hash, uint64_t transactions, uint64_t outputs)
+{
+    byte_array<snapshot_header_size> header;
+    auto serial = make_unsafe_serializer(header.begin());
+    serial.write_4_bytes_little_endian(snapshot_magic);
+    serial.write_4_bytes_little_endian(snapshot_version);
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(height));
+    serial.write_hash(block_hash);
+    serial.write_8_bytes_little_endian(transactions);
+    serial.write_8_bytes_little_endian(outputs);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+static void write_chunk(bc::ofstream& file, uint32_t transactions,
+    const data_chunk& payload)
+{
+    byte_array<chunk_header_size> header;
+    auto serial = make_unsafe_serializer(header.begin());
+    serial.write_4_bytes_little_endian(transactions);
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(payload.size()));
+    serial.write_4_bytes_little_endian(bitcoin_checksum(payload));
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+}
+
+bool transaction_database::read_snapshot(const path& filename,
+    size_t& out_height, hash_digest& out_block_hash,
+    uint64_t& out_transactions)
+{
+    bc::ifstream file(filename.string(), std::ios::binary);
+
+    if (!file.good())
+        return false;
+
+    byte_array<snapshot_header_size> header;
+    file.read(reinterpret_cast<char*>(header.data()), header.size());
+
+    if (!file.good())
+        return false;
+
+    auto deserial = make_unsafe_deserializer(header.begin());
+    const auto magic = deserial.read_4_bytes_little_endian();
+    const auto version = deserial.read_4_bytes_little_endian();
+    out_height = deserial.read_4_bytes_little_endian();
+    out_block_hash = deserial.read_hash();
+    out_transactions = deserial.read_8_bytes_little_endian();
+    return magic == snapshot_magic && version == snapshot_version;
+}
+
+// Each thread walks a partition of the buckets, writing a chunk as its payload
+// fills, so chunk order (and so the file) varies from export to export.
+// Writes must not be concurrent, as spentness is read unguarded.
+bool transaction_database::export_unspent(const path& filename,
+    size_t height, const hash_digest& block_hash) const
+{
+    bc::ofstream file(filename.string(), std::ios::binary);
+
+    if (!file.good())
+        return false;
+
+    // The counts are not known until the walk completes.
+    write_snapshot_header(file, height, block_hash, 0, 0);
+
+    std::mutex file_mutex;
+    std::atomic<uint64_t> transactions(0);
+    std::atomic<uint64_t> outputs(0);
+
+    const auto flush = [&](uint32_t count, data_chunk& payload)
+    {
+        if (count == 0)
+            return;
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        {
+            std::unique_lock<std::mutex> lock(file_mutex);
+            write_chunk(file, count, payload);
+        }
+        ///////////////////////////////////////////////////////////////////////
+
+        payload.clear();
+    };
+
+    const auto partition = [&](size_t first, size_t last)
+    {
+        data_chunk payload;
+        payload.reserve(snapshot_chunk_size);
+        uint32_t count = 0;
+
+        const auto exporter = [&](link_type link)
+        {
+            const auto result = get(link);
+
+            // Only confirmed txs at or below the height have unspent outputs.
+            // Genesis is stored on create (and its output is unspendable).
+            if (!result || result.pruned() || result.height() == 0 ||
+                result.position() == transaction_result::unconfirmed ||
+                result.height() > height)
+                return;
+
+            const auto tx = result.transaction(false);
+            const auto& tx_outputs = tx.outputs();
+            std::vector<uint32_t> unspent;
+
+            for (uint32_t index = 0; index < tx_outputs.size(); ++index)
+                if (!tx_outputs[index].metadata.spent(height, false))
+                    unspent.push_back(index);
+
+            if (unspent.empty())
+                return;
+
+            data_sink ostream(payload);
+            ostream_writer sink(ostream);
+            sink.write_hash(result.hash());
+            sink.write_4_bytes_little_endian(
+                static_cast<uint32_t>(result.height()));
+            sink.write_2_bytes_little_endian(
+                static_cast<uint16_t>(result.position()));
+            sink.write_4_bytes_little_endian(result.median_time_past());
+            sink.write_variable_little_endian(tx_outputs.size());
+            sink.write_variable_little_endian(unspent.size());
+
+            for (const auto index: unspent)
+            {
+                sink.write_variable_little_endian(index);
+                tx_outputs[index].to_data(sink, true);
+            }
+
+            ostream.flush();
+            transactions += 1;
+            outputs += unspent.size();
+
+            if (++count == max_uint32 || payload.size() >= snapshot_chunk_size)
+            {
+                flush(count, payload);
+                count = 0;
+            }
+        };
+
+        hash_table_.walk(first, last, exporter);
+        flush(count, payload);
+    };
+
+    parallel_for(hash_table_.buckets(), threads_, minimum_partition,
+        partition);
+
+    // Terminate the chunks and write the counts to the header.
+    write_chunk(file, 0, {});
+    file.seekp(0);
+    write_snapshot_header(file, height, block_hash, transactions, outputs);
+    return file.good();
+}
+
+// Each chunk is stored as it is read, with the outputs not in the snapshot
+// (gaps) spent at the snapshot height, so the snapshot txs read as unspent
+// only at the snapshot outputs. Writes must not be concurrent.
+bool transaction_database::import_unspent(const path& filename)
+{
+    size_t height;
+    hash_digest block_hash;
+    uint64_t expected;
+
+    if (!read_snapshot(filename, height, block_hash, expected))
+        return false;
+
+    bc::ifstream file(filename.string(), std::ios::binary);
+    file.seekg(snapshot_header_size);
+    uint64_t imported = 0;
+
+    while (file.good())
+    {
+        byte_array<chunk_header_size> header;
+        file.read(reinterpret_cast<char*>(header.data()), header.size());
+
+        if (!file.good())
+            return false;
+
+        auto deserial = make_unsafe_deserializer(header.begin());
+        const auto count = deserial.read_4_bytes_little_endian();
+        const auto size = deserial.read_4_bytes_little_endian();
+        const auto checksum = deserial.read_4_bytes_little_endian();
+
+        if (count == 0)
+            return imported == expected;
+
+        // Guard against allocation for a corrupted file.
+        if (size > maximum_chunk_size)
+            return false;
+
+        data_chunk payload(size);
+        file.read(reinterpret_cast<char*>(payload.data()), payload.size());
+
+        if (!file.good() || bitcoin_checksum(payload) != checksum)
+            return false;
+
+        std::vector<output_point> gaps;
+        auto source = make_safe_deserializer(payload.begin(), payload.end());
+
+        for (uint32_t entry = 0; entry < count; ++entry)
+        {
+            const auto hash = source.read_hash();
+            const auto tx_height = source.read_4_bytes_little_endian();
+            const auto position = source.read_2_bytes_little_endian();
+            const auto median_time_past = source.read_4_bytes_little_endian();
+            const auto output_count = source.read_size_little_endian();
+            const auto unspent_count = source.read_size_little_endian();
+
+            // Guard against allocation for a corrupted chunk.
+            if (!source || tx_height > height || output_count > size ||
+                unspent_count > output_count)
+                return false;
+
+            output::list outputs(output_count);
+            std::vector<bool> unspent(output_count, false);
+
+            for (size_t out = 0; out < unspent_count; ++out)
+            {
+                const auto index = source.read_size_little_endian();
+
+                if (!source || index >= output_count || unspent[index] ||
+                    !outputs[index].from_data(source, true))
+                    return false;
+
+                unspent[index] = true;
+            }
+
+            for (uint32_t index = 0; index < output_count; ++index)
+                if (!unspent[index])
+                    gaps.emplace_back(hash, index);
+
+            const transaction tx(0, 0, {}, std::move(outputs));
+            write(hash, tx, tx_height, median_time_past, position);
+            ++imported;
+        }
+
+        if (!source.is_exhausted())
+            return false;
+
+        block_arena::scope release(arena_);
+        point_list points(arena_);
+        points.reserve(gaps.size());
+
+        for (const auto& gap: gaps)
+            points.push_back(&gap);
+
+        spend_targets targets(arena_);
+        if (!locate_spends(points, true, height, targets))
+            return false;
+
+        confirmed_spend(targets, height);
+    }
+
+    return false;
+}
+
 } // namespace database
 } // namespace libbitcoin
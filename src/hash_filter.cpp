@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/hash_filter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+// File format:
+// ----------------------------------------------------------------------------
+// [ count:8  ] (the number of hashes in the set)
+// [ hashes:8 ]
+// [ blocks:8 ]
+// [ word:8   ]... (blocks * block_words, little endian)
+
+namespace libbitcoin {
+namespace database {
+
+using namespace boost::filesystem;
+
+static constexpr size_t block_words = 8;
+static constexpr size_t block_bits = block_words * 64;
+static constexpr size_t maximum_hashes = 16;
+static constexpr uint64_t one = 1;
+
+// Each bit of hash is about -log2(p) bits of discrimination.
+static size_t optimal_hashes(size_t error_ppm)
+{
+    if (error_ppm == 0 || error_ppm >= 1000000)
+        return 1;
+
+    const auto bits = std::ceil(std::log2(1000000.0 / error_ppm));
+    return std::min(static_cast<size_t>(bits), maximum_hashes);
+}
+
+hash_filter::hash_filter(size_t size, size_t error_ppm)
+  : hashes_(optimal_hashes(error_ppm)),
+    blocks_(size / (block_words * sizeof(uint64_t))),
+    valid_(false),
+    count_(0),
+    words_(blocks_ * block_words)
+{
+}
+
+bool hash_filter::disabled() const
+{
+    return blocks_ == 0;
+}
+
+bool hash_filter::valid() const
+{
+    return valid_;
+}
+
+void hash_filter::create()
+{
+    if (disabled())
+        return;
+
+    for (auto& word: words_)
+        word.store(0, std::memory_order_relaxed);
+
+    count_ = 0;
+    valid_ = true;
+}
+
+bool hash_filter::load(const path& filename, uint64_t count)
+{
+    if (disabled())
+        return false;
+
+    bc::ifstream file(filename.string(), std::ios::binary);
+
+    if (!file.good())
+        return false;
+
+    const auto read = [&file]()
+    {
+        byte_array<sizeof(uint64_t)> bytes;
+        file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+        return from_little_endian_unsafe<uint64_t>(bytes.begin());
+    };
+
+    auto loaded = read() == count && read() == hashes_ && read() == blocks_;
+
+    for (auto word = words_.begin(); loaded && word != words_.end(); ++word)
+    {
+        word->store(read(), std::memory_order_relaxed);
+        loaded = file.good();
+    }
+
+    file.close();
+
+    // The file is consumed whether or not it is usable.
+    boost::system::error_code ec;
+    remove(filename, ec);
+
+    if (!loaded || ec)
+        return false;
+
+    count_ = count;
+    valid_ = true;
+    return true;
+}
+
+bool hash_filter::save(const path& filename) const
+{
+    if (!valid())
+        return false;
+
+    bc::ofstream file(filename.string(), std::ios::binary);
+
+    if (!file.good())
+        return false;
+
+    const auto write = [&file](uint64_t value)
+    {
+        const auto bytes = to_little_endian(value);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    };
+
+    write(count_);
+    write(hashes_);
+    write(blocks_);
+
+    for (const auto& word: words_)
+        write(word.load(std::memory_order_relaxed));
+
+    return file.good();
+}
+
+// Bitcoin hashes are uniform, so independent slices of the digest are used
+// for the block and (by double hashing) the bits within it.
+size_t hash_filter::block(const hash_digest& hash) const
+{
+    const auto value = from_little_endian_unsafe<uint64_t>(hash.begin());
+    return static_cast<size_t>(value % blocks_) * block_words;
+}
+
+void hash_filter::insert(const hash_digest& hash)
+{
+    if (!valid())
+        return;
+
+    const auto base = block(hash);
+    auto bit = from_little_endian_unsafe<uint64_t>(hash.begin() + 8);
+    const auto step = from_little_endian_unsafe<uint64_t>(hash.begin() + 16) | 1;
+
+    for (size_t index = 0; index < hashes_; ++index, bit += step)
+    {
+        const auto position = bit % block_bits;
+        words_[base + position / 64].fetch_or(one << (position % 64),
+            std::memory_order_release);
+    }
+
+    ++count_;
+}
+
+bool hash_filter::contains(const hash_digest& hash) const
+{
+    if (!valid())
+        return true;
+
+    const auto base = block(hash);
+    auto bit = from_little_endian_unsafe<uint64_t>(hash.begin() + 8);
+    const auto step = from_little_endian_unsafe<uint64_t>(hash.begin() + 16) | 1;
+
+    for (size_t index = 0; index < hashes_; ++index, bit += step)
+    {
+        const auto position = bit % block_bits;
+        const auto word = words_[base + position / 64].load(
+            std::memory_order_acquire);
+
+        if ((word & (one << (position % 64))) == 0)
+            return false;
+    }
+
+    return true;
+}
+
+size_t hash_filter::hashes() const
+{
+    return hashes_;
+}
+
+size_t hash_filter::size() const
+{
+    return words_.size() * sizeof(uint64_t);
+}
+
+// This is the standard Bloom estimate, which understates a blocked filter.
+float hash_filter::false_positive_rate() const
+{
+    if (!valid())
+        return 1.0f;
+
+    const auto bits = static_cast<double>(size() * 8);
+    const auto exponent = -static_cast<double>(hashes_) * count_ / bits;
+    return static_cast<float>(std::pow(1.0 - std::exp(exponent), hashes_));
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/header_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// [ height:4 ][ hash:32 ][ bits:4 ][ timestamp:4 ][ version:4 ]
+// [ median_time_past:4 ][ state:1 ]
+const size_t header_cache::serialized_size = 5u * sizeof(uint32_t) +
+    hash_size + sizeof(uint8_t);
+
+header_cache::header_cache(size_t capacity)
+  : headers_(capacity), first_(0), top_(0)
+{
+}
+
+bool header_cache::disabled() const
+{
+    return headers_.empty();
+}
+
+size_t header_cache::capacity() const
+{
+    return headers_.size();
+}
+
+size_t header_cache::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return top_ - first_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_cache::get(cached_header& out_header, size_t height) const
+{
+    if (disabled())
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (height < first_ || height >= top_)
+        return false;
+
+    out_header = headers_[height % headers_.size()];
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_cache::push(const cached_header& header)
+{
+    if (disabled())
+        return;
+
+    const size_t height = header.height;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // A header that does not extend the window restarts it.
+    if (height != top_)
+        first_ = height;
+
+    headers_[height % headers_.size()] = header;
+    top_ = height + 1u;
+
+    // The lowest header is overwritten when the window is full.
+    if (top_ - first_ > headers_.size())
+        first_ = top_ - headers_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_cache::pop(size_t height)
+{
+    if (disabled())
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // A header that is not the top of the window empties it.
+    if (height + 1u != top_ || first_ == top_)
+    {
+        first_ = top_ = height;
+        return;
+    }
+
+    --top_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_cache::set_state(const hash_digest& hash, size_t height,
+    uint8_t state)
+{
+    if (disabled())
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (height < first_ || height >= top_)
+        return;
+
+    auto& header = headers_[height % headers_.size()];
+
+    if (header.hash == hash)
+        header.state = state;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_cache::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    first_ = top_ = 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+data_chunk header_cache::to_data() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    data_chunk data((top_ - first_) * serialized_size);
+    auto serial = make_unsafe_serializer(data.begin());
+
+    for (auto height = first_; height < top_; ++height)
+    {
+        const auto& header = headers_[height % headers_.size()];
+        serial.write_4_bytes_little_endian(header.height);
+        serial.write_hash(header.hash);
+        serial.write_4_bytes_little_endian(header.bits);
+        serial.write_4_bytes_little_endian(header.timestamp);
+        serial.write_4_bytes_little_endian(header.version);
+        serial.write_4_bytes_little_endian(header.median_time_past);
+        serial.write_byte(header.state);
+    }
+
+    return data;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_cache::from_data(const data_chunk& data)
+{
+    clear();
+
+    if (disabled() || data.size() % serialized_size != 0)
+        return false;
+
+    const auto count = data.size() / serialized_size;
+    const auto skip = count > capacity() ? count - capacity() : 0;
+    auto deserial = make_unsafe_deserializer(data.begin() +
+        skip * serialized_size);
+    size_t next = 0;
+
+    for (auto index = skip; index < count; ++index)
+    {
+        cached_header header;
+        header.height = deserial.read_4_bytes_little_endian();
+        header.hash = deserial.read_hash();
+        header.bits = deserial.read_4_bytes_little_endian();
+        header.timestamp = deserial.read_4_bytes_little_endian();
+        header.version = deserial.read_4_bytes_little_endian();
+        header.median_time_past = deserial.read_4_bytes_little_endian();
+        header.state = deserial.read_byte();
+
+        // The headers must be consecutive.
+        if (index != skip && header.height != next)
+        {
+            clear();
+            return false;
+        }
+
+        next = header.height + 1u;
+        push(header);
+    }
+
+    return true;
+}
+
+} // namespace database
+} // namespace libbitcoin
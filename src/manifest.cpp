@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/manifest.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+// File format:
+// ----------------------------------------------------------------------------
+// [ version:4 ]
+// [ count:4   ]
+// [ [ name_size:1 ][ name ][ value_size:4 ][ value ] ] * count
+// [ checksum:4 ] (bitcoin checksum of the above)
+
+namespace libbitcoin {
+namespace database {
+
+using namespace boost::filesystem;
+
+static constexpr uint32_t version = 1;
+
+manifest::manifest(const path& filename)
+  : filename_(filename)
+{
+}
+
+void manifest::set(const std::string& name, const data_chunk& value)
+{
+    values_[name] = value;
+}
+
+void manifest::set_size(const path& file)
+{
+    boost::system::error_code ec;
+    const auto size = file_size(file, ec);
+
+    if (!ec)
+        set(size_name(file), to_chunk(to_little_endian<uint64_t>(size)));
+}
+
+bool manifest::get(const std::string& name, data_chunk& out_value) const
+{
+    const auto value = values_.find(name);
+
+    if (value == values_.end())
+        return false;
+
+    out_value = value->second;
+    return true;
+}
+
+bool manifest::matches_size(const path& file) const
+{
+    data_chunk value;
+    if (!get(size_name(file), value) || value.size() != sizeof(uint64_t))
+        return false;
+
+    boost::system::error_code ec;
+    const auto size = file_size(file, ec);
+    return !ec && size == from_little_endian_unsafe<uint64_t>(value.begin());
+}
+
+bool manifest::empty() const
+{
+    return values_.empty();
+}
+
+void manifest::clear()
+{
+    values_.clear();
+}
+
+bool manifest::load()
+{
+    clear();
+    data_chunk data;
+
+    // The file is closed before it is removed.
+    {
+        bc::ifstream file(filename_.string(), std::ios::binary);
+
+        if (!file.good())
+            return false;
+
+        data.assign(std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>());
+    }
+
+    // The file is consumed whether or not it is usable.
+    boost::system::error_code ec;
+    remove(filename_, ec);
+
+    if (ec || data.size() < 3u * sizeof(uint32_t))
+        return false;
+
+    const auto payload = data.size() - sizeof(uint32_t);
+    const auto checksum = from_little_endian_unsafe<uint32_t>(
+        data.begin() + payload);
+
+    if (checksum != bitcoin_checksum(
+        data_slice(data.data(), data.data() + payload)))
+        return false;
+
+    auto deserial = make_safe_deserializer(data.begin(),
+        data.begin() + payload);
+
+    if (deserial.read_4_bytes_little_endian() != version)
+        return false;
+
+    const auto count = deserial.read_4_bytes_little_endian();
+
+    for (uint32_t index = 0; deserial && index < count; ++index)
+    {
+        const auto name = deserial.read_string(deserial.read_byte());
+        const auto value = deserial.read_bytes(
+            deserial.read_4_bytes_little_endian());
+
+        if (deserial)
+            values_[name] = value;
+    }
+
+    if (!deserial || !deserial.is_exhausted())
+    {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool manifest::save() const
+{
+    size_t size = 3u * sizeof(uint32_t);
+
+    for (const auto& value: values_)
+        size += sizeof(uint8_t) + value.first.size() + sizeof(uint32_t) +
+            value.second.size();
+
+    data_chunk data(size);
+    auto serial = make_unsafe_serializer(data.begin());
+    serial.write_4_bytes_little_endian(version);
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(values_.size()));
+
+    for (const auto& value: values_)
+    {
+        BITCOIN_ASSERT(value.first.size() <= max_uint8);
+        serial.write_byte(static_cast<uint8_t>(value.first.size()));
+        serial.write_string(value.first, value.first.size());
+        serial.write_4_bytes_little_endian(
+            static_cast<uint32_t>(value.second.size()));
+        serial.write_bytes(value.second);
+    }
+
+    const auto payload = size - sizeof(uint32_t);
+    serial.write_4_bytes_little_endian(bitcoin_checksum(
+        data_slice(data.data(), data.data() + payload)));
+
+    bc::ofstream file(filename_.string(), std::ios::binary);
+
+    if (!file.good())
+        return false;
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return file.good();
+}
+
+// private
+std::string manifest::size_name(const path& file)
+{
+    return "size:" + file.filename().string();
+}
+
+} // namespace database
+} // namespace libbitcoin
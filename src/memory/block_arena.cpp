@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/block_arena.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// The spend targets and points of a typical block fit one chunk.
+const size_t block_arena::default_chunk_size = 256 * 1024;
+
+block_arena::scope::scope(block_arena& arena)
+  : arena_(arena)
+{
+    ++arena_.depth_;
+}
+
+block_arena::scope::~scope()
+{
+    if (--arena_.depth_ == 0)
+        arena_.reset();
+}
+
+block_arena::block_arena(size_t chunk_size)
+  : chunk_size_(std::max(chunk_size, size_t(1))),
+    current_size_(0),
+    offset_(0),
+    used_(0),
+    depth_(0)
+{
+}
+
+void* block_arena::allocate(size_t size, size_t alignment)
+{
+    BITCOIN_ASSERT(alignment != 0 && (alignment & (alignment - 1u)) == 0);
+
+    const auto padding = [&]()
+    {
+        const auto address = reinterpret_cast<uintptr_t>(current_.get()) +
+            offset_;
+        return (alignment - address % alignment) % alignment;
+    };
+
+    if (!current_ || offset_ + padding() + size > current_size_)
+        grow(size + alignment);
+
+    const auto pad = padding();
+    const auto start = current_.get() + offset_ + pad;
+    offset_ += pad + size;
+    used_ += pad + size;
+    return start;
+}
+
+// The full chunks are coalesced, so the arena converges on one chunk.
+void block_arena::reset()
+{
+    if (!full_.empty())
+    {
+        auto size = current_size_;
+
+        for (const auto& full: full_)
+            size += full.second;
+
+        full_.clear();
+        current_.reset();
+        current_.reset(new uint8_t[size]);
+        current_size_ = size;
+    }
+
+    offset_ = 0;
+    used_ = 0;
+}
+
+size_t block_arena::used() const
+{
+    return used_;
+}
+
+size_t block_arena::capacity() const
+{
+    auto size = current_size_;
+
+    for (const auto& full: full_)
+        size += full.second;
+
+    return size;
+}
+
+// private
+void block_arena::grow(size_t minimum)
+{
+    if (current_)
+        full_.emplace_back(std::move(current_), current_size_);
+
+    // Chunks double, so that the number of chunks is logarithmic.
+    const auto size = std::max({ minimum, chunk_size_, current_size_ * 2u });
+    current_.reset(new uint8_t[size]);
+    current_size_ = size;
+    offset_ = 0;
+}
+
+} // namespace database
+} // namespace libbitcoin
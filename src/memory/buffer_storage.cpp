@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/buffer_storage.hpp>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+#define FAIL -1
+#define INVALID_HANDLE -1
+
+buffer_storage::buffer_storage(const path& filename, size_t expansion)
+  : memory_storage(filename, expansion)
+{
+}
+
+// The base close would not persist, as the override is gone by then.
+buffer_storage::~buffer_storage()
+{
+    close();
+}
+
+// protected
+// The file is fit to the logical size on sync, as the buffer may have shrunk.
+bool buffer_storage::persist(size_t offset, size_t size, bool sync) const
+{
+    if (file_handle_ == INVALID_HANDLE)
+        return false;
+
+    if (!write_file(data_ + offset, offset, size))
+        return false;
+
+    if (!sync)
+        return true;
+
+#ifdef _WIN32
+    return _chsize_s(file_handle_, logical_size_) == 0 &&
+        _commit(file_handle_) != FAIL;
+#else
+    return ftruncate(file_handle_, logical_size_) != FAIL &&
+        fsync(file_handle_) != FAIL;
+#endif
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -28,18 +28,27 @@
     #include <stddef.h>
     #include <sys/mman.h>
 #endif
+#ifdef __linux__
+    #include <sys/syscall.h>
+#endif
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fcntl.h>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <thread>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/memory/accessor.hpp>
 #include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/pinned_accessor.hpp>
+#include <bitcoin/database/trace.hpp>
 
 // file_storage is able to support 32 bit, but because the database
 // requires a larger file this is neither validated nor supported.
@@ -83,14 +92,16 @@ size_t file_storage::file_size(int file_handle)
     return static_cast<size_t>(sbuf.st_size);
 }
 
-int file_storage::open_file(const path& filename)
+int file_storage::open_file(const path& filename, bool read_only)
 {
+    const auto access = read_only ? O_RDONLY : O_RDWR;
+
 #ifdef _WIN32
     int handle = _wopen(filename.wstring().c_str(),
-        (O_RDWR | _O_BINARY | _O_RANDOM), (_S_IREAD | _S_IWRITE));
+        (access | _O_BINARY | _O_RANDOM), (_S_IREAD | _S_IWRITE));
 #else
     int handle = ::open(filename.string().c_str(),
-        (O_RDWR), (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH));
+        (access), (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH));
 #endif
     return handle;
 }
@@ -118,9 +129,7 @@ void file_storage::log_mapping() const
 
 void file_storage::log_resizing(size_t size) const
 {
-    const auto this_id = boost::this_thread::get_id();
     LOG_DEBUG(LOG_DATABASE)
-        << this_id
         << "Resizing: " << filename_ << " [" << size << "]";
 }
 
@@ -148,21 +157,42 @@ file_storage::file_storage(const path& filename)
 {
 }
 
-// mmap documentation: tinyurl.com/hnbw8t5
 file_storage::file_storage(const path& filename, size_t expansion)
-  : file_handle_(open_file(filename)),
+  : file_storage(filename, expansion, 0)
+{
+}
+
+// mmap documentation: tinyurl.com/hnbw8t5
+file_storage::file_storage(const path& filename, size_t expansion,
+    size_t reservation)
+  : file_storage(filename, expansion, reservation, false)
+{
+}
+
+file_storage::file_storage(const path& filename, size_t expansion,
+    size_t reservation, bool read_only)
+  : file_handle_(open_file(filename, read_only)),
     expansion_(expansion),
+    reservation_(reservation),
+    read_only_(read_only),
     filename_(filename),
     closed_(true),
     data_(nullptr),
     file_size_(file_size(file_handle_)),
-    logical_size_(file_size_)
+    logical_size_(file_size_),
+    reserved_(0),
+    advice_(),
+    advice_size_(0),
+    growth_(),
+    dirty_begin_(max_size_t),
+    dirty_end_(0),
+    readers_(0),
+    remapping_(false),
+    allocated_(0),
+    metrics_(nullptr),
+    journaled_(false)
 {
-    const auto this_id = boost::this_thread::get_id();
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " file_storage() "
-    << filename;
+    DATABASE_TRACE("file_storage() " << filename);
 }
 
 // Database threads must be joined before close is called (or destruct).
@@ -180,49 +210,37 @@ bool file_storage::open()
 {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    const auto this_id = boost::this_thread::get_id();
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " file_storage::open() calling lock_upgrade() for mutex_ of "
-    << &mutex_;
+    DATABASE_TRACE("file_storage::open() calling lock_upgrade() for mutex_ of "
+        << &mutex_);
 
     mutex_.lock_upgrade();
 
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " file_storage::open() called lock_upgrade() successfully for mutex_ of "
-    << &mutex_;
+    DATABASE_TRACE("file_storage::open() called lock_upgrade() successfully for mutex_ of "
+        << &mutex_);
 
     if (!closed_)
     {
-        LOG_DEBUG(LOG_DATABASE)
-        << this_id
-        << " file_storage::open() calling unlock_upgrade() for mutex_ of "
-        << &mutex_;
+        DATABASE_TRACE("file_storage::open() calling unlock_upgrade() for mutex_ of "
+            << &mutex_);
 
         mutex_.unlock_upgrade();
 
-        LOG_DEBUG(LOG_DATABASE)
-        << this_id
-        << " file_storage::open() called unlock_upgrade() successfully for mutex_ of "
-        << &mutex_;
+        DATABASE_TRACE("file_storage::open() called unlock_upgrade() successfully for mutex_ of "
+            << &mutex_);
         //---------------------------------------------------------------------
         return false;
     }
 
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " file_storage::open() calling unlock_upgrade_and_lock() for mutex_ of "
-    << &mutex_;
+    DATABASE_TRACE("file_storage::open() calling unlock_upgrade_and_lock() for mutex_ of "
+        << &mutex_);
 
     mutex_.unlock_upgrade_and_lock();
 
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " file_storage::open() called unlock_upgrade_and_lock() successfully for mutex_ of "
-    << &mutex_;
+    DATABASE_TRACE("file_storage::open() called unlock_upgrade_and_lock() successfully for mutex_ of "
+        << &mutex_);
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
     std::string error_name;
+    drain_readers();
 
     // Initialize data_.
     if (!map(file_size_))
@@ -230,19 +248,21 @@ bool file_storage::open()
     else if (madvise(data_, 0, MADV_RANDOM) == FAIL)
         error_name = "madvise";
     else
+    {
+        advise();
+        allocated_.store(0);
         closed_ = false;
+    }
 
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " file_storage::open() calling unlock() for mutex_ of "
-    << &mutex_;
+    release_readers();
+
+    DATABASE_TRACE("file_storage::open() calling unlock() for mutex_ of "
+        << &mutex_);
 
     mutex_.unlock();
 
-    LOG_DEBUG(LOG_DATABASE)
-    << this_id
-    << " file_storage::open() called unlock() successfully for mutex_ of "
-    << &mutex_;
+    DATABASE_TRACE("file_storage::open() called unlock() successfully for mutex_ of "
+        << &mutex_);
     ///////////////////////////////////////////////////////////////////////////
 
     // Keep logging out of the critical section.
@@ -261,7 +281,7 @@ bool file_storage::flush() const
     ///////////////////////////////////////////////////////////////////////////
     mutex_.lock_upgrade();
 
-    if (closed_)
+    if (closed_ || read_only_)
     {
         mutex_.unlock_upgrade();
         //---------------------------------------------------------------------
@@ -274,6 +294,10 @@ bool file_storage::flush() const
     if (msync(data_, logical_size_, MS_SYNC) == FAIL)
         error_name = "flush";
 
+    // The full synchronous flush covers the dirty range.
+    dirty_begin_ = max_size_t;
+    dirty_end_ = 0;
+
     mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
@@ -285,6 +309,51 @@ bool file_storage::flush() const
     return true;
 }
 
+// The dirty range is fed by reserve, so it covers newly-allocated space only.
+// In-place writes to previously allocated space are covered by flush().
+bool file_storage::flush_dirty() const
+{
+    std::string error_name;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    if (closed_ || dirty_end_ <= dirty_begin_)
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return true;
+    }
+
+    // The msync address must be page aligned.
+    const auto page_size = page();
+    const auto start = page_size == 0 ? 0 :
+        dirty_begin_ - dirty_begin_ % page_size;
+    const auto length = std::min(dirty_end_, file_size_) - start;
+
+    dirty_begin_ = max_size_t;
+    dirty_end_ = 0;
+
+    if (msync(data_ + start, length, MS_ASYNC) == FAIL)
+        error_name = "msync";
+#ifdef SYNC_FILE_RANGE_WRITE
+    // MS_ASYNC does not initiate writeback on linux, so start it explicitly.
+    else if (sync_file_range(file_handle_, start, length,
+        SYNC_FILE_RANGE_WRITE) == FAIL)
+        error_name = "sync_file_range";
+#endif
+
+    mutex_.unlock_upgrade();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Keep logging out of the critical section.
+    if (!error_name.empty())
+        return handle_error(error_name, filename_);
+
+    return true;
+}
+
 // Close is idempotent and thread safe.
 bool file_storage::close()
 {
@@ -307,13 +376,24 @@ bool file_storage::close()
     mutex_.unlock_upgrade_and_lock();
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+    drain_readers();
     closed_ = true;
+    dirty_begin_ = max_size_t;
+    dirty_end_ = 0;
 
-    if (logical_size_ > file_size_)
+    // A secondary neither writes nor fits the file, it only releases the map.
+    if (read_only_)
+    {
+        if (!unmap())
+            error_name = "munmap";
+        else if (::close(file_handle_) == FAIL)
+            error_name = "close";
+    }
+    else if (logical_size_ > file_size_)
         error_name = "fit";
     else if (msync(data_, logical_size_, MS_SYNC) == FAIL)
         error_name = "msync";
-    else if (munmap(data_, file_size_) == FAIL)
+    else if (!unmap())
         error_name = "munmap";
     else if (ftruncate(file_handle_, logical_size_) == FAIL)
         error_name = "ftruncate";
@@ -322,6 +402,7 @@ bool file_storage::close()
     else if (::close(file_handle_) == FAIL)
         error_name = "close";
 
+    release_readers();
     mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
@@ -342,6 +423,67 @@ bool file_storage::closed() const
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// The writer only grows the file while open, so mapping it to its current
+// size covers all that has been published. A file shrunk by its writer (on
+// close) cannot be followed, so the secondary must be closed first.
+bool file_storage::refresh()
+{
+    std::string error_name;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    if (closed_ || !read_only_)
+    {
+        const auto opened = !closed_;
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return opened;
+    }
+
+    const auto size = file_size(file_handle_);
+
+    if (size <= file_size_)
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return size == file_size_ || handle_error("follow", filename_);
+    }
+
+    mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+    // Growth within reserved address space does not move the map.
+    const auto in_place = size <= reserved_;
+
+    if (!in_place)
+        drain_readers();
+
+    if (!map_grown(size))
+    {
+        error_name = "refresh";
+    }
+    else
+    {
+        logical_size_ = size;
+        advise();
+    }
+
+    if (!in_place)
+        release_readers();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Keep logging out of the critical section.
+    if (!error_name.empty())
+        return handle_error(error_name, filename_);
+
+    log_mapping();
+    return true;
+}
+
 // Operations.
 // ----------------------------------------------------------------------------
 
@@ -354,23 +496,120 @@ size_t file_storage::size() const
     ///////////////////////////////////////////////////////////////////////////
 }
 
-memory_ptr file_storage::access()
+size_t file_storage::logical_size() const
 {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    // accessor constructor calls mutex_.lock_upgrade();
-    auto memory = std::make_shared<accessor>(mutex_);
+    shared_lock lock(mutex_);
+    return logical_size_;
+    ///////////////////////////////////////////////////////////////////////////
+}
 
-    // assign() calls mutex_.unlock_upgrade_and_lock_shared();
-    memory->assign(data_);
+// The page vector is bounded, so a large map is measured in chunks.
+size_t file_storage::resident_size() const
+{
+#ifdef _WIN32
+    return 0;
+#else
+    static const size_t chunk_pages = 64 * 1024;
+    const auto page_size = page();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (data_ == nullptr || page_size == 0)
+        return 0;
+
+    const auto pages = (file_size_ + page_size - 1) / page_size;
+#ifdef __linux__
+    std::vector<unsigned char> residency(std::min(pages, chunk_pages));
+#else
+    std::vector<char> residency(std::min(pages, chunk_pages));
+#endif
+    size_t resident = 0;
+
+    for (size_t first = 0; first < pages; first += chunk_pages)
+    {
+        const auto count = std::min(pages - first, chunk_pages);
+        const auto offset = first * page_size;
+        const auto length = std::min(count * page_size, file_size_ - offset);
+
+        // The low bit of each page byte is set if the page is resident.
+        if (mincore(data_ + offset, length, residency.data()) == FAIL)
+            return 0;
+
+        for (size_t index = 0; index < count; ++index)
+            if ((residency[index] & 1) != 0)
+                ++resident;
+    }
+
+    return std::min(resident * page_size, file_size_);
+    ///////////////////////////////////////////////////////////////////////////
+#endif
+}
+
+memory_ptr file_storage::access()
+{
+    const auto data = pin_readers();
+
+    // The pin is not released until the memory shared pointer is freed.
+    return std::make_shared<pinned_accessor>(readers_, data);
+}
+
+memory_handle file_storage::pin()
+{
+    const auto data = pin_readers();
+
+    // The pin is not released until the handle is destroyed.
+    return memory_handle(data, &file_storage::unpin, &readers_);
+}
+
+// private
+uint8_t* file_storage::pin_readers()
+{
+    // A thread that holds a pin does not wait on a pending remap, which cannot
+    // proceed until that pin is released (or nested pins deadlock).
+    if (pinned_accessor::held(readers_))
+    {
+        readers_.fetch_add(1);
+    }
+    else
+    {
+        // Pin the mapping. If a remap is pending the pin is backed out and
+        // the reader waits on the mutex, which the writer holds until remap
+        // is done.
+        while (true)
+        {
+            readers_.fetch_add(1);
+
+            if (!remapping_.load())
+                break;
+
+            readers_.fetch_sub(1);
+
+            // Critical Section
+            ///////////////////////////////////////////////////////////////////
+            shared_lock lock(mutex_);
+            ///////////////////////////////////////////////////////////////////
+        }
+    }
 
     // The store should only have been closed after all threads terminated.
     if (closed_)
+    {
+        readers_.fetch_sub(1);
         throw std::runtime_error("Access failure, store closed.");
+    }
 
-    // Always return in shared lock state. (see above, assign() sets this state)
-    // The critical section does not end until the memory shared pointer is freed.
-    return memory;
+    pinned_accessor::hold(readers_);
+    return data_;
+}
+
+// private
+void file_storage::unpin(void* readers)
+{
+    pinned_accessor::release(*static_cast<std::atomic<size_t>*>(readers));
 }
 
 // Throws runtime_error if insufficient space.
@@ -408,29 +647,55 @@ memory_ptr file_storage::reserve(size_t size, size_t expansion)
         throw std::runtime_error("Resize failure, store already closed.");
     }
 
+    if (read_only_)
+    {
+        memory->assign(data_);
+        throw std::runtime_error("Resize failure, store is read only.");
+    }
+
     if (size > file_size_)
     {
-        // TODO: manage overflow (requires ceiling_multiply).
-        // Expansion is an integral number that represents a real number factor.
-        const size_t target = size * ((expansion + 100.0) / 100.0);
+        const auto target = this->target(size, expansion);
 
         mutex_.unlock_upgrade_and_lock();
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+        // Growth within reserved address space does not move the map, so
+        // pinned readers are not drained.
+        const auto in_place = target <= reserved_;
+
+        if (!in_place)
+            drain_readers();
+
         // TODO: isolate cause and if recoverable (disk size) return nullptr.
-        // All existing database pointers are invalidated by this call.
+        // Unless in place, all existing database pointers are invalidated.
         if (!truncate_mapped(target))
         {
+            release_readers();
+            mutex_.unlock();
             handle_error("resize", filename_);
             throw std::runtime_error("Resize failure, disk space may be low.");
         }
 
+        // Advice does not carry over to a new or extended map.
+        advise();
+
+        if (!in_place)
+            release_readers();
         //---------------------------------------------------------------------
         mutex_.unlock_and_lock_upgrade();
     }
 
+    // Track the newly-allocated range for background writeback.
+    if (size > logical_size_)
+    {
+        dirty_begin_ = std::min(dirty_begin_, logical_size_);
+        dirty_end_ = std::max(dirty_end_, size);
+        journal(logical_size_, size - logical_size_);
+    }
+
     logical_size_ = size;
-    
+
     // assign() calls mutex_.unlock_upgrade_and_lock_shared();
     memory->assign(data_);
 
@@ -440,6 +705,229 @@ memory_ptr file_storage::reserve(size_t size, size_t expansion)
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Journal.
+// ----------------------------------------------------------------------------
+
+void file_storage::journal(file_offset offset, size_t size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(journal_mutex_);
+
+    if (journaled_ && size != 0)
+        journal_.emplace_back(offset, size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Pages partially within the range are zeroed and written back as usual.
+void file_storage::release(file_offset offset, size_t size)
+{
+    // Pin the mapping (at its first byte) so that it cannot be remapped.
+    const auto memory = access();
+
+    if (size == 0 || offset >= file_size_)
+        return;
+
+    const auto end = std::min(offset + size, file_size_);
+    std::memset(memory->buffer() + offset, 0x00, end - offset);
+    journal(offset, end - offset);
+
+#ifdef FALLOC_FL_PUNCH_HOLE
+    // The hole must be page aligned, and reads as zeros when faulted back.
+    const auto page_size = page();
+
+    if (page_size == 0)
+        return;
+
+    const auto first = (offset + page_size - 1u) / page_size * page_size;
+    const auto last = end - end % page_size;
+
+    // Release only reclaims space, so failure is not an error.
+    if (first < last)
+        fallocate(file_handle_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+            first, last - first);
+#endif
+}
+
+// The read-ahead is asynchronous, so this only costs a system call.
+void file_storage::prefetch(file_offset offset, size_t size)
+{
+    // Pin the mapping (at its first byte) so that it cannot be remapped.
+    const auto memory = access();
+
+    if (size == 0 || offset >= file_size_)
+        return;
+
+    // The madvise address must be page aligned.
+    const auto page_size = page();
+    const auto start = page_size == 0 ? 0 : offset - offset % page_size;
+    const auto length = std::min(offset + size, file_size_) - start;
+
+    // Advice is only a hint, so failure is not an error.
+    madvise(memory->buffer() + start, length, MADV_WILLNEED);
+}
+
+// The map is otherwise left to default read-ahead, which is reverted to here.
+void file_storage::scan(file_offset offset, size_t size, bool sequential)
+{
+    // Pin the mapping (at its first byte) so that it cannot be remapped.
+    const auto memory = access();
+
+    if (size == 0 || offset >= file_size_)
+        return;
+
+    // The madvise address must be page aligned.
+    const auto page_size = page();
+    const auto start = page_size == 0 ? 0 : offset - offset % page_size;
+    const auto length = std::min(offset + size, file_size_) - start;
+    const auto buffer = memory->buffer() + start;
+
+    // Advice is only a hint, so failure is not an error.
+#ifdef MADV_SEQUENTIAL
+    madvise(buffer, length, sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+#endif
+
+    if (sequential)
+        madvise(buffer, length, MADV_WILLNEED);
+}
+
+void file_storage::enable_advice(const map_advice& advice,
+    size_t header_size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    advice_ = advice;
+    advice_size_ = advice.header_only ? header_size : 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void file_storage::enable_growth(const file_growth& growth)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    growth_ = growth;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The allocation is outside of the lock, as it does not change the size of
+// the file (or the map), so the next growth by the writer does not wait on it.
+void file_storage::pregrow()
+{
+#ifdef FALLOC_FL_KEEP_SIZE
+    size_t start;
+    size_t end;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+
+        if (closed_ || read_only_ || growth_.pregrow_percent == 0 ||
+            logical_size_ * 100.0 < file_size_ * growth_.pregrow_percent)
+            return;
+
+        // The growth of a reservation beyond the physical size.
+        start = std::max(file_size_, allocated_.load());
+        end = target(file_size_ + 1, expansion_);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (start >= end)
+        return;
+
+    // Allocation is only a hint, so failure is not an error.
+    if (fallocate(file_handle_, FALLOC_FL_KEEP_SIZE, start, end - start) !=
+        FAIL)
+        allocated_.store(end);
+#endif
+}
+
+size_t file_storage::compress(size_t)
+{
+    return 0;
+}
+
+void file_storage::enable_journal()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(journal_mutex_);
+    journaled_ = true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Overlapping and adjacent ranges are coalesced, and each range is limited to
+// the logical size, since a range may have been popped after it was written.
+bool file_storage::log_writes(commit_log& log)
+{
+    std::vector<range> ranges;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(journal_mutex_);
+        ranges.swap(journal_);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (ranges.empty())
+        return true;
+
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<range> merged;
+    merged.reserve(ranges.size());
+
+    for (const auto& item: ranges)
+    {
+        if (!merged.empty() &&
+            item.first <= merged.back().first + merged.back().second)
+        {
+            auto& last = merged.back();
+            const auto end = std::max(last.first + last.second,
+                item.first + item.second);
+            last.second = static_cast<size_t>(end - last.first);
+        }
+        else
+        {
+            merged.push_back(item);
+        }
+    }
+
+    size_t logical_size;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+        logical_size = logical_size_;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto table = filename_.filename().string();
+    const auto memory = access();
+
+    for (const auto& item: merged)
+    {
+        if (item.first >= logical_size)
+            continue;
+
+        const auto size = std::min(item.second,
+            static_cast<size_t>(logical_size - item.first));
+
+        log.write(table, item.first, memory->buffer() + item.first, size);
+    }
+
+    return true;
+}
+
+void file_storage::enable_metrics(table_metrics& metrics)
+{
+    metrics_ = &metrics;
+}
+
 // privates
 // ----------------------------------------------------------------------------
 
@@ -462,10 +950,22 @@ size_t file_storage::page() const
 #endif
 }
 
+int file_storage::protection() const
+{
+    return read_only_ ? PROT_READ : (PROT_READ | PROT_WRITE);
+}
+
+// The reserved address space is released along with the file mapping.
+size_t file_storage::mapped_size() const
+{
+    return reserved_ == 0 ? file_size_ : reserved_;
+}
+
 bool file_storage::unmap()
 {
-    const auto success = (munmap(data_, file_size_) != FAIL);
+    const auto success = (munmap(data_, mapped_size()) != FAIL);
     file_size_ = 0;
+    reserved_ = 0;
     data_ = nullptr;
     return success;
 }
@@ -475,12 +975,61 @@ bool file_storage::map(size_t size)
     if (size == 0)
         return false;
 
-    data_ = reinterpret_cast<uint8_t*>(mmap(0, size, PROT_READ | PROT_WRITE,
+    if (size <= reservation_)
+        return map_reserved(size);
+
+    data_ = reinterpret_cast<uint8_t*>(mmap(0, size, protection(),
+        MAP_SHARED, file_handle_, 0));
+
+    return validate(size);
+}
+
+// Reserve the full inaccessible address range and map the file over its head.
+bool file_storage::map_reserved(size_t size)
+{
+#ifdef MAP_NORESERVE
+    const auto base = mmap(0, reservation_, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, INVALID_HANDLE, 0);
+
+    if (base == MAP_FAILED)
+    {
+        data_ = reinterpret_cast<uint8_t*>(MAP_FAILED);
+        return validate(size);
+    }
+
+    data_ = reinterpret_cast<uint8_t*>(mmap(base, size,
+        protection(), MAP_SHARED | MAP_FIXED, file_handle_, 0));
+
+    if (data_ == MAP_FAILED)
+        munmap(base, reservation_);
+    else
+        reserved_ = reservation_;
+#else
+    data_ = reinterpret_cast<uint8_t*>(mmap(0, size, protection(),
         MAP_SHARED, file_handle_, 0));
+#endif
 
     return validate(size);
 }
 
+// Extend the file mapping in place, within the reserved address range.
+// The mapped offset must be page aligned, so remap from the last mapped page.
+bool file_storage::map_extend(size_t size)
+{
+    const auto page_size = page();
+    const auto start = page_size == 0 ? 0 : file_size_ - file_size_ % page_size;
+
+    const auto tail = mmap(data_ + start, size - start,
+        protection(), MAP_SHARED | MAP_FIXED, file_handle_,
+        static_cast<off_t>(start));
+
+    if (tail == MAP_FAILED)
+        return false;
+
+    file_size_ = size;
+    return true;
+}
+
 bool file_storage::remap(size_t size)
 {
 #ifdef MREMAP_MAYMOVE
@@ -493,8 +1042,67 @@ bool file_storage::remap(size_t size)
 #endif
 }
 
+// Map the file grown by another process, as truncate_mapped without truncate.
+bool file_storage::map_grown(size_t size)
+{
+    if (size <= reserved_)
+        return map_extend(size);
+
+    if (reserved_ != 0)
+        return unmap() && map(size);
+
+    return remap(size);
+}
+
+// Expansion is an integral number that represents a real number factor.
+size_t file_storage::target(size_t size, size_t expansion) const
+{
+    // TODO: manage overflow (requires ceiling_multiply).
+    const size_t geometric = size * ((expansion + 100.0) / 100.0);
+
+    // An exact reservation (no expansion) is not subject to the policy.
+    if (expansion == 0 || growth_.chunk == 0)
+        return geometric;
+
+    const auto chunked = size + static_cast<size_t>(growth_.chunk);
+
+    switch (growth_.policy)
+    {
+        case growth_policy::fixed:
+            return chunked;
+        case growth_policy::capped:
+            return std::min(geometric, chunked);
+        case growth_policy::geometric:
+        default:
+            return geometric;
+    }
+}
+
+// Allocate the growth on disk before the file is extended, so that a full
+// disk fails the reservation instead of a later write to the map.
+bool file_storage::allocate(size_t size)
+{
+#ifdef FALLOC_FL_KEEP_SIZE
+    const auto start = std::max(file_size_, allocated_.load());
+
+    if (!growth_.preallocate || size <= start)
+        return true;
+
+    if (fallocate(file_handle_, FALLOC_FL_KEEP_SIZE, start, size - start) ==
+        FAIL)
+        return errno == EOPNOTSUPP || errno == ENOSYS;
+
+    allocated_.store(size);
+#endif
+    return true;
+}
+
 bool file_storage::truncate(size_t size)
 {
+    // A shrink releases any allocation beyond the end of the file.
+    if (size < file_size(file_handle_))
+        allocated_.store(0);
+
     return ftruncate(file_handle_, size) != FAIL;
 }
 
@@ -502,6 +1110,17 @@ bool file_storage::truncate_mapped(size_t size)
 {
     log_resizing(size);
 
+    if (!allocate(size))
+        return false;
+
+    // The base pointer does not move, so existing pointers remain valid.
+    if (size <= reserved_)
+        return truncate(size) && map_extend(size);
+
+    // The reservation is exhausted, so release it for an unreserved map.
+    if (reserved_ != 0)
+        return unmap() && truncate(size) && map(size);
+
 #ifndef MREMAP_MAYMOVE
     if (!unmap())
         return false;
@@ -530,5 +1149,78 @@ bool file_storage::validate(size_t size)
     return true;
 }
 
+// Must be called under exclusive lock, with the file mapped.
+// Advice is only a hint, so failure is not an error (and is not logged here,
+// since this is always a critical section).
+void file_storage::advise() const
+{
+    // The advice is limited to the header, unless there is none (zero).
+    const auto size = advice_size_ == 0 ? file_size_ :
+        std::min(advice_size_, file_size_);
+
+    if (data_ == nullptr || size == 0)
+        return;
+
+#ifdef MADV_HUGEPAGE
+    if (advice_.huge_pages)
+        madvise(data_, size, MADV_HUGEPAGE);
+#endif
+
+#ifdef __NR_mbind
+    // The libnuma mbind wrapper is not required, so call it directly.
+    // MPOL_BIND (2) and MPOL_INTERLEAVE (3), see linux/mempolicy.h.
+    if (advice_.numa != numa_policy::none && advice_.numa_nodes != 0)
+    {
+        const unsigned long mode = advice_.numa == numa_policy::bind ? 2 : 3;
+        const unsigned long nodes = advice_.numa_nodes;
+        const unsigned long max_node = sizeof(nodes) * 8 + 1;
+        syscall(__NR_mbind, data_, size, mode, &nodes, max_node, 0);
+    }
+#endif
+
+    // Populate follows placement, so that faulted pages honor the policy.
+#ifdef MADV_POPULATE_READ
+    if (advice_.populate)
+        madvise(data_, size, MADV_POPULATE_READ);
+#elif defined(MADV_WILLNEED)
+    if (advice_.populate)
+        madvise(data_, size, MADV_WILLNEED);
+#endif
+
+    if (advice_.lock)
+        mlock(data_, size);
+
+#ifdef MADV_COLD
+    // Only the map beyond the (page aligned) header is cold, so the header
+    // remains in the active set, and may be locked there.
+    const auto page_size = page();
+    const auto start = page_size == 0 ? size :
+        (size + page_size - 1) / page_size * page_size;
+
+    if (advice_.cold && advice_size_ != 0 && start < file_size_)
+        madvise(data_ + start, file_size_ - start, MADV_COLD);
+#endif
+}
+
+// Must be called under exclusive lock, so there can be only one drainer.
+// Signal the pending remap and wait for all pinned readers to release.
+void file_storage::drain_readers()
+{
+    remapping_.store(true);
+    const auto start = table_metrics::clock::now();
+
+    while (readers_.load() != 0)
+        std::this_thread::yield();
+
+    if (metrics_ != nullptr)
+        metrics_->remap(table_metrics::clock::now() - start);
+}
+
+// Must be called under exclusive lock, before it is released.
+void file_storage::release_readers()
+{
+    remapping_.store(false);
+}
+
 } // namespace database
 } // namespace libbitcoin
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/memory_handle.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+memory_handle::memory_handle()
+  : data_(nullptr), release_(nullptr), context_(nullptr)
+{
+}
+
+memory_handle::memory_handle(uint8_t* data, release_handler release,
+    void* context)
+  : data_(data), release_(release), context_(context)
+{
+}
+
+memory_handle::memory_handle(memory_handle&& other)
+  : data_(other.data_), release_(other.release_), context_(other.context_)
+{
+    other.data_ = nullptr;
+    other.release_ = nullptr;
+    other.context_ = nullptr;
+}
+
+memory_handle& memory_handle::operator=(memory_handle&& other)
+{
+    if (this == &other)
+        return *this;
+
+    release();
+    data_ = other.data_;
+    release_ = other.release_;
+    context_ = other.context_;
+    other.data_ = nullptr;
+    other.release_ = nullptr;
+    other.context_ = nullptr;
+    return *this;
+}
+
+memory_handle::~memory_handle()
+{
+    release();
+}
+
+memory_handle::operator bool() const
+{
+    return release_ != nullptr;
+}
+
+uint8_t* memory_handle::buffer() const
+{
+    return data_;
+}
+
+void memory_handle::increment(size_t value)
+{
+    BITCOIN_ASSERT_MSG(data_ != nullptr, "Buffer not assigned.");
+    BITCOIN_ASSERT((size_t)data_ <= bc::max_size_t - value);
+
+    data_ += value;
+}
+
+// private
+void memory_handle::release()
+{
+    if (release_ != nullptr)
+        release_(context_);
+
+    release_ = nullptr;
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,684 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/memory_storage.hpp>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/accessor.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/pinned_accessor.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+#define FAIL -1
+#define INVALID_HANDLE -1
+
+// Huge page buffers are allocated in multiples of the (common) huge page.
+static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+// The file is optional, so a missing file is not an error.
+static int open_file(const boost::filesystem::path& filename)
+{
+#ifdef _WIN32
+    return _wopen(filename.wstring().c_str(), (O_RDWR | _O_BINARY),
+        (_S_IREAD | _S_IWRITE));
+#else
+    return ::open(filename.string().c_str(), (O_RDWR),
+        (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH));
+#endif
+}
+
+static size_t file_size(int file_handle)
+{
+    if (file_handle == INVALID_HANDLE)
+        return 0;
+
+#ifdef _WIN32
+    struct _stat64 sbuf;
+    if (_fstat64(file_handle, &sbuf) == FAIL)
+        return 0;
+#else
+    struct stat sbuf;
+    if (fstat(file_handle, &sbuf) == FAIL)
+        return 0;
+#endif
+
+    return static_cast<size_t>(sbuf.st_size);
+}
+
+memory_storage::memory_storage(const path& filename, size_t expansion,
+    bool huge_pages)
+  : file_handle_(open_file(filename)),
+    filename_(filename),
+    data_(nullptr),
+    logical_size_(0),
+    expansion_(expansion),
+    huge_pages_(huge_pages),
+    closed_(true),
+    capacity_(0),
+    dirty_begin_(max_size_t),
+    dirty_end_(0),
+    readers_(0),
+    remapping_(false),
+    metrics_(nullptr),
+    journaled_(false)
+{
+}
+
+// Database threads must be joined before close is called (or destruct).
+memory_storage::~memory_storage()
+{
+    close();
+}
+
+// Startup and shutdown.
+// ----------------------------------------------------------------------------
+
+// Open is not idempotent (should be called on single thread).
+bool memory_storage::open()
+{
+    std::string error_name;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (!closed_)
+            return false;
+
+        const auto size = file_size(file_handle_);
+
+        if (size != 0 && !reallocate(size))
+            error_name = "allocate";
+        else if (!read_file(data_, 0, size))
+            error_name = "read";
+        else
+        {
+            logical_size_ = size;
+            closed_ = false;
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Keep logging out of the critical section.
+    if (!error_name.empty())
+        return handle_error(error_name);
+
+    return true;
+}
+
+bool memory_storage::flush() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (closed_)
+        return true;
+
+    // The full synchronous flush covers the dirty range.
+    dirty_begin_ = max_size_t;
+    dirty_end_ = 0;
+    return persist(0, logical_size_, true);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The dirty range is fed by reserve, so it covers newly-allocated space only.
+bool memory_storage::flush_dirty() const
+{
+    size_t start;
+    size_t end;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (closed_ || dirty_end_ <= dirty_begin_)
+            return true;
+
+        start = dirty_begin_;
+        end = dirty_end_;
+        dirty_begin_ = max_size_t;
+        dirty_end_ = 0;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    // The table may have been closed or popped since the range was taken.
+    end = std::min(end, logical_size_);
+    return closed_ || end <= start || persist(start, end - start, false);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Close is idempotent and thread safe.
+bool memory_storage::close()
+{
+    std::string error_name;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (closed_)
+            return true;
+
+        drain_readers();
+        closed_ = true;
+        dirty_begin_ = max_size_t;
+        dirty_end_ = 0;
+
+        if (!persist(0, logical_size_, true))
+            error_name = "persist";
+        else if (file_handle_ != INVALID_HANDLE &&
+            ::close(file_handle_) == FAIL)
+            error_name = "close";
+
+        deallocate();
+        release_readers();
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Keep logging out of the critical section.
+    if (!error_name.empty())
+        return handle_error(error_name);
+
+    return true;
+}
+
+bool memory_storage::closed() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return closed_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Operations.
+// ----------------------------------------------------------------------------
+
+size_t memory_storage::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return capacity_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t memory_storage::logical_size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return logical_size_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t memory_storage::resident_size() const
+{
+    return size();
+}
+
+memory_ptr memory_storage::access()
+{
+    const auto data = pin_readers();
+
+    // The pin is not released until the memory shared pointer is freed.
+    return std::make_shared<pinned_accessor>(readers_, data);
+}
+
+memory_handle memory_storage::pin()
+{
+    const auto data = pin_readers();
+
+    // The pin is not released until the handle is destroyed.
+    return memory_handle(data, &memory_storage::unpin, &readers_);
+}
+
+// private
+uint8_t* memory_storage::pin_readers()
+{
+    // A thread that holds a pin does not wait on a pending reallocation, which
+    // cannot proceed until that pin is released (or nested pins deadlock).
+    if (pinned_accessor::held(readers_))
+    {
+        readers_.fetch_add(1);
+    }
+    else
+    {
+        // Pin the buffer. If a reallocation is pending the pin is backed out
+        // and the reader waits on the mutex, which the writer holds until it
+        // is done.
+        while (true)
+        {
+            readers_.fetch_add(1);
+
+            if (!remapping_.load())
+                break;
+
+            readers_.fetch_sub(1);
+
+            // Critical Section
+            ///////////////////////////////////////////////////////////////////
+            shared_lock lock(mutex_);
+            ///////////////////////////////////////////////////////////////////
+        }
+    }
+
+    // The store should only have been closed after all threads terminated.
+    if (closed_)
+    {
+        readers_.fetch_sub(1);
+        throw std::runtime_error("Access failure, store closed.");
+    }
+
+    pinned_accessor::hold(readers_);
+    return data_;
+}
+
+// private
+void memory_storage::unpin(void* readers)
+{
+    pinned_accessor::release(*static_cast<std::atomic<size_t>*>(readers));
+}
+
+// Throws runtime_error if insufficient memory.
+memory_ptr memory_storage::resize(size_t size)
+{
+    return reserve(size, 0);
+}
+
+// Throws runtime_error if insufficient memory.
+memory_ptr memory_storage::reserve(size_t size)
+{
+    return reserve(size, expansion_);
+}
+
+// Throws runtime_error if insufficient memory (see file_storage).
+memory_ptr memory_storage::reserve(size_t size, size_t expansion)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    // accessor constructor calls mutex_.lock_upgrade();
+    auto memory = std::make_shared<accessor>(mutex_);
+
+    // The store should only have been closed after all threads terminated.
+    if (closed_)
+    {
+        memory->assign(data_);
+        throw std::runtime_error("Resize failure, store already closed.");
+    }
+
+    if (size > capacity_)
+    {
+        // Expansion is an integral number that represents a real number factor.
+        const size_t target = size * ((expansion + 100.0) / 100.0);
+
+        mutex_.unlock_upgrade_and_lock();
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+        drain_readers();
+
+        // All existing database pointers are invalidated.
+        if (!reallocate(target))
+        {
+            release_readers();
+            mutex_.unlock();
+            handle_error("allocate");
+            throw std::runtime_error("Resize failure, memory may be low.");
+        }
+
+        release_readers();
+        //---------------------------------------------------------------------
+        mutex_.unlock_and_lock_upgrade();
+    }
+
+    // Track the newly-allocated range for background writeback.
+    if (size > logical_size_)
+    {
+        dirty_begin_ = std::min(dirty_begin_, logical_size_);
+        dirty_end_ = std::max(dirty_end_, size);
+        journal(logical_size_, size - logical_size_);
+    }
+
+    logical_size_ = size;
+
+    // assign() calls mutex_.unlock_upgrade_and_lock_shared();
+    memory->assign(data_);
+
+    // Always return in shared lock state. (see above, assign() sets this state)
+    // The critical section does not end until the memory shared pointer is freed.
+    return memory;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Journal.
+// ----------------------------------------------------------------------------
+
+void memory_storage::journal(file_offset offset, size_t size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(journal_mutex_);
+
+    if (journaled_ && size != 0)
+        journal_.emplace_back(offset, size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void memory_storage::release(file_offset offset, size_t size)
+{
+    // Pin the buffer so that it cannot be reallocated.
+    const auto memory = access();
+
+    const auto capacity = this->size();
+
+    if (size == 0 || offset >= capacity)
+        return;
+
+    const auto length = std::min(offset + size, capacity) - offset;
+    std::memset(memory->buffer() + offset, 0x00, length);
+    journal(offset, length);
+}
+
+void memory_storage::prefetch(file_offset, size_t)
+{
+}
+
+bool memory_storage::refresh()
+{
+    return true;
+}
+
+void memory_storage::scan(file_offset, size_t, bool)
+{
+}
+
+void memory_storage::enable_advice(const map_advice&, size_t)
+{
+}
+
+void memory_storage::enable_growth(const file_growth&)
+{
+}
+
+void memory_storage::pregrow()
+{
+}
+
+size_t memory_storage::compress(size_t)
+{
+    return 0;
+}
+
+void memory_storage::enable_journal()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(journal_mutex_);
+    journaled_ = true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Ranges are limited to the logical size, since a range may have been popped
+// after it was written. Overlapping ranges are not coalesced (see file_storage).
+bool memory_storage::log_writes(commit_log& log)
+{
+    std::vector<range> ranges;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(journal_mutex_);
+        ranges.swap(journal_);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (ranges.empty())
+        return true;
+
+    size_t logical_size;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+        logical_size = logical_size_;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto table = filename_.filename().string();
+    const auto memory = access();
+
+    for (const auto& item: ranges)
+    {
+        if (item.first >= logical_size)
+            continue;
+
+        const auto size = std::min(item.second,
+            static_cast<size_t>(logical_size - item.first));
+
+        log.write(table, item.first, memory->buffer() + item.first, size);
+    }
+
+    return true;
+}
+
+void memory_storage::enable_metrics(table_metrics& metrics)
+{
+    metrics_ = &metrics;
+}
+
+// protected
+// ----------------------------------------------------------------------------
+
+bool memory_storage::persist(size_t, size_t, bool) const
+{
+    return true;
+}
+
+bool memory_storage::read_file(uint8_t* data, size_t offset,
+    size_t size) const
+{
+    while (size != 0)
+    {
+#ifdef _WIN32
+        const auto count = _lseeki64(file_handle_, offset, SEEK_SET) == FAIL ?
+            FAIL : _read(file_handle_, data, static_cast<unsigned>(
+                std::min(size, size_t(INT_MAX))));
+#else
+        const auto count = pread(file_handle_, data, size,
+            static_cast<off_t>(offset));
+#endif
+
+        if (count <= 0)
+            return false;
+
+        data += count;
+        offset += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+bool memory_storage::write_file(const uint8_t* data, size_t offset,
+    size_t size) const
+{
+    while (size != 0)
+    {
+#ifdef _WIN32
+        const auto count = _lseeki64(file_handle_, offset, SEEK_SET) == FAIL ?
+            FAIL : _write(file_handle_, data, static_cast<unsigned>(
+                std::min(size, size_t(INT_MAX))));
+#else
+        const auto count = pwrite(file_handle_, data, size,
+            static_cast<off_t>(offset));
+#endif
+
+        if (count <= 0)
+            return false;
+
+        data += count;
+        offset += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+bool memory_storage::handle_error(const std::string& context) const
+{
+#ifdef _WIN32
+    const auto error = GetLastError();
+#else
+    const auto error = errno;
+#endif
+    LOG_FATAL(LOG_DATABASE)
+        << "The table failed to " << context << ": " << filename_ << " : "
+        << error;
+    return false;
+}
+
+// privates
+// ----------------------------------------------------------------------------
+
+// Huge pages fall back to transparent huge pages, and then to base pages.
+// New memory is zero filled, as is the growth of a truncated file.
+uint8_t* memory_storage::allocate(size_t capacity) const
+{
+#ifndef _WIN32
+    if (huge_pages_)
+    {
+        void* data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        data = mmap(0, capacity, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, INVALID_HANDLE, 0);
+#endif
+        if (data == MAP_FAILED)
+        {
+            data = mmap(0, capacity, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, INVALID_HANDLE, 0);
+
+            if (data == MAP_FAILED)
+                return nullptr;
+#ifdef MADV_HUGEPAGE
+            // Advice is only a hint, so failure is not an error.
+            madvise(data, capacity, MADV_HUGEPAGE);
+#endif
+        }
+
+        return reinterpret_cast<uint8_t*>(data);
+    }
+#endif
+
+    return reinterpret_cast<uint8_t*>(std::calloc(capacity, 1));
+}
+
+void memory_storage::deallocate()
+{
+    if (data_ != nullptr)
+    {
+#ifndef _WIN32
+        if (huge_pages_)
+            munmap(data_, capacity_);
+        else
+#endif
+            std::free(data_);
+    }
+
+    data_ = nullptr;
+    capacity_ = 0;
+    logical_size_ = 0;
+}
+
+// Must be called under exclusive lock, with readers drained.
+bool memory_storage::reallocate(size_t capacity)
+{
+#ifndef _WIN32
+    if (huge_pages_)
+        capacity += (huge_page_size - capacity % huge_page_size) %
+            huge_page_size;
+#endif
+
+    const auto data = allocate(capacity);
+
+    if (data == nullptr)
+        return false;
+
+    const auto logical_size = std::min(logical_size_, capacity);
+
+    if (data_ != nullptr)
+        std::memcpy(data, data_, logical_size);
+
+    deallocate();
+    data_ = data;
+    capacity_ = capacity;
+    logical_size_ = logical_size;
+    return true;
+}
+
+// Must be called under exclusive lock, so there can be only one drainer.
+// Signal the pending reallocation and wait for all pinned readers to release.
+void memory_storage::drain_readers()
+{
+    remapping_.store(true);
+    const auto start = table_metrics::clock::now();
+
+    while (readers_.load() != 0)
+        std::this_thread::yield();
+
+    if (metrics_ != nullptr)
+        metrics_->remap(table_metrics::clock::now() - start);
+}
+
+// Must be called under exclusive lock, before it is released.
+void memory_storage::release_readers()
+{
+    remapping_.store(false);
+}
+
+} // namespace database
+} // namespace libbitcoin
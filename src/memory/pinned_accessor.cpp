@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/pinned_accessor.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// The reader counts of the pins held by this thread, one entry per pin.
+static thread_local std::vector<const std::atomic<size_t>*> held_pins;
+
+// The reader count has been incremented by the caller (see file_storage).
+pinned_accessor::pinned_accessor(std::atomic<size_t>& readers, uint8_t* data)
+  : readers_(readers), data_(data)
+{
+}
+
+uint8_t* pinned_accessor::buffer()
+{
+    return data_;
+}
+
+void pinned_accessor::increment(size_t value)
+{
+    BITCOIN_ASSERT_MSG(data_ != nullptr, "Buffer not assigned.");
+    BITCOIN_ASSERT((size_t)data_ <= bc::max_size_t - value);
+
+    data_ += value;
+}
+
+// The mapping may be moved by a remap once all pins are released.
+pinned_accessor::~pinned_accessor()
+{
+    release(readers_);
+}
+
+// static
+bool pinned_accessor::held(const std::atomic<size_t>& readers)
+{
+    return std::find(held_pins.begin(), held_pins.end(), &readers) !=
+        held_pins.end();
+}
+
+// static
+void pinned_accessor::hold(const std::atomic<size_t>& readers)
+{
+    held_pins.push_back(&readers);
+}
+
+// static
+void pinned_accessor::release(std::atomic<size_t>& readers)
+{
+    BITCOIN_ASSERT(readers.load() > 0);
+    const auto pin = std::find(held_pins.rbegin(), held_pins.rend(),
+        &readers);
+
+    BITCOIN_ASSERT_MSG(pin != held_pins.rend(), "Pin released off thread.");
+    if (pin != held_pins.rend())
+        held_pins.erase(std::next(pin).base());
+
+    readers.fetch_sub(1);
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/prefetcher.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// One typical page, so adjacent records share a request.
+const size_t prefetcher::default_distance = 4096;
+
+prefetcher::prefetcher(storage& file, size_t distance)
+  : file_(file), distance_(distance)
+{
+}
+
+// Each request only queues read-ahead, so the batch costs one system call
+// per run and the reads proceed concurrently in the kernel.
+void prefetcher::prefetch(offsets& batch, size_t size) const
+{
+    if (batch.empty() || size == 0)
+        return;
+
+    std::sort(batch.begin(), batch.end());
+
+    auto start = batch.front();
+    auto end = start + size;
+
+    for (const auto offset: batch)
+    {
+        if (offset <= end + distance_)
+        {
+            end = std::max(end, offset + size);
+            continue;
+        }
+
+        file_.prefetch(start, static_cast<size_t>(end - start));
+        start = offset;
+        end = offset + size;
+    }
+
+    file_.prefetch(start, static_cast<size_t>(end - start));
+}
+
+} // namespace database
+} // namespace libbitcoin
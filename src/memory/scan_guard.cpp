@@ -0,0 +1,40 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/scan_guard.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/storage.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+scan_guard::scan_guard(storage& file, file_offset offset, size_t size)
+  : file_(file), offset_(offset), size_(size)
+{
+    file_.scan(offset_, size_, true);
+}
+
+scan_guard::~scan_guard()
+{
+    file_.scan(offset_, size_, false);
+}
+
+} // namespace database
+} // namespace libbitcoin
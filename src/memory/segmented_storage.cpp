@@ -0,0 +1,1011 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/segmented_storage.hpp>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include "../mman-win32/mman.h"
+#else
+    #include <unistd.h>
+    #include <stddef.h>
+    #include <sys/mman.h>
+#endif
+#ifdef __linux__
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <linux/btrfs.h>
+    #include <linux/fs.h>
+#endif
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/accessor.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/memory/pinned_accessor.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+using namespace boost::filesystem;
+using namespace boost::system;
+
+#define FAIL -1
+#define INVALID_HANDLE -1
+
+// 4GB segments, within 4TB of address space for each table.
+const size_t segmented_storage::default_segment_size = 4ull << 30;
+const size_t segmented_storage::default_segments = 1024;
+
+#ifdef BTRFS_IOC_DEFRAG_RANGE
+// BTRFS_COMPRESS_ZSTD, see the btrfs compression type enumeration.
+static const uint32_t compress_zstd = 3;
+#endif
+
+segmented_storage::path segmented_storage::segment_filename(
+    const path& filename, size_t segment)
+{
+    if (segment == 0)
+        return filename;
+
+    return filename.string() + "." + std::to_string(segment);
+}
+
+size_t segmented_storage::segment_size(const path& filename)
+{
+    error_code ec;
+    if (!exists(segment_filename(filename, 1), ec))
+        return 0;
+
+    const auto size = file_size(filename, ec);
+    return ec ? 0 : static_cast<size_t>(size);
+}
+
+segmented_storage::segmented_storage(const path& filename,
+    size_t segment_size, size_t segments, bool read_only)
+  : segment_size_(segment_size),
+    segments_(segments),
+    read_only_(read_only),
+    filename_(filename),
+    closed_(true),
+    data_(nullptr),
+    file_size_(0),
+    logical_size_(0),
+    advice_(),
+    advice_size_(0),
+    growth_(),
+    dirty_begin_(max_size_t),
+    dirty_end_(0),
+    readers_(0),
+    compressed_(1),
+    compressible_(true),
+    journaled_(false)
+{
+}
+
+// Database threads must be joined before close is called (or destruct).
+segmented_storage::~segmented_storage()
+{
+    close();
+}
+
+// Startup and shutdown.
+// ----------------------------------------------------------------------------
+
+// Each segment but the last must be full, and the last is extended to a full
+// segment (sparse), so the logical size is that of the files on open.
+bool segmented_storage::open()
+{
+    std::string error_name;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (!closed_)
+            return false;
+
+        std::vector<size_t> sizes;
+        error_code ec;
+
+        while (sizes.size() < segments_)
+        {
+            const auto file = segment_filename(filename_, sizes.size());
+
+            if (!exists(file, ec))
+                break;
+
+            sizes.push_back(static_cast<size_t>(file_size(file, ec)));
+        }
+
+        const auto page_size = page();
+        const auto full = [&](size_t size) { return size == segment_size_; };
+
+        if (page_size == 0 || segment_size_ == 0 ||
+            segment_size_ % page_size != 0 || sizes.empty() ||
+            sizes.back() == 0 || sizes.back() > segment_size_ ||
+            !std::all_of(sizes.begin(), sizes.end() - 1, full))
+        {
+            error_name = "segment";
+        }
+        else
+        {
+#ifdef MAP_NORESERVE
+            const auto base = mmap(0, segment_size_ * segments_, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, INVALID_HANDLE,
+                0);
+
+            data_ = base == MAP_FAILED ? nullptr :
+                reinterpret_cast<uint8_t*>(base);
+#endif
+            if (data_ == nullptr)
+                error_name = "reserve";
+        }
+
+        for (size_t segment = 0; error_name.empty() &&
+            segment < sizes.size(); ++segment)
+            if (!map_segment(segment, false, segment + 1 == sizes.size()))
+                error_name = "map";
+
+        if (error_name.empty())
+        {
+            logical_size_ = (sizes.size() - 1u) * segment_size_ +
+                sizes.back();
+            closed_ = false;
+        }
+        else if (data_ != nullptr)
+        {
+            munmap(data_, segment_size_ * segments_);
+
+            for (const auto handle: handles_)
+                ::close(handle);
+
+            handles_.clear();
+            file_size_ = 0;
+            data_ = nullptr;
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Keep logging out of the critical section.
+    if (!error_name.empty())
+        return handle_error(error_name);
+
+    LOG_DEBUG(LOG_DATABASE)
+        << "Mapping: " << filename_ << " [" << handles_.size() << " x "
+        << segment_size_ << "]";
+    return true;
+}
+
+bool segmented_storage::flush() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (closed_ || read_only_)
+            return true;
+
+        // The full synchronous flush covers the dirty range.
+        dirty_begin_ = max_size_t;
+        dirty_end_ = 0;
+
+        if (msync(data_, logical_size_, MS_SYNC) != FAIL)
+            return true;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    return handle_error("flush");
+}
+
+// The dirty range is fed by reserve, so it covers newly-allocated space only.
+// In-place writes to previously allocated space are covered by flush().
+bool segmented_storage::flush_dirty() const
+{
+    std::string error_name;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (closed_ || dirty_end_ <= dirty_begin_)
+            return true;
+
+        // The msync address must be page aligned.
+        const auto page_size = page();
+        const auto start = page_size == 0 ? 0 :
+            dirty_begin_ - dirty_begin_ % page_size;
+        const auto end = std::min(dirty_end_, file_size_);
+
+        dirty_begin_ = max_size_t;
+        dirty_end_ = 0;
+
+        if (msync(data_ + start, end - start, MS_ASYNC) == FAIL)
+            error_name = "msync";
+
+#ifdef SYNC_FILE_RANGE_WRITE
+        // MS_ASYNC does not initiate writeback on linux, so start it
+        // explicitly for the range of each segment.
+        for (auto offset = start; error_name.empty() && offset < end;)
+        {
+            const auto segment = offset / segment_size_;
+            const auto first = segment * segment_size_;
+            const auto last = std::min(end, first + segment_size_);
+
+            if (sync_file_range(handles_[segment], offset - first,
+                last - offset, SYNC_FILE_RANGE_WRITE) == FAIL)
+                error_name = "sync_file_range";
+
+            offset = last;
+        }
+#endif
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Keep logging out of the critical section.
+    if (!error_name.empty())
+        return handle_error(error_name);
+
+    return true;
+}
+
+// Close is idempotent and thread safe.
+bool segmented_storage::close()
+{
+    std::string error_name;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (closed_)
+            return true;
+
+        drain_readers();
+        closed_ = true;
+        dirty_begin_ = max_size_t;
+        dirty_end_ = 0;
+
+        // The segment of the last logical byte, later segments are unused.
+        const auto last = logical_size_ == 0 ? 0 :
+            (logical_size_ - 1u) / segment_size_;
+
+        if (!read_only_ && msync(data_, logical_size_, MS_SYNC) == FAIL)
+            error_name = "msync";
+
+        if (munmap(data_, segment_size_ * segments_) == FAIL &&
+            error_name.empty())
+            error_name = "munmap";
+
+        for (size_t segment = 0; segment < handles_.size(); ++segment)
+        {
+            const auto handle = handles_[segment];
+
+            if (!read_only_ && error_name.empty() && segment == last)
+            {
+                if (ftruncate(handle, logical_size_ - last * segment_size_) ==
+                    FAIL)
+                    error_name = "ftruncate";
+                else if (fsync(handle) == FAIL)
+                    error_name = "fsync";
+            }
+
+            if (::close(handle) == FAIL && error_name.empty())
+                error_name = "close";
+
+            if (!read_only_ && error_name.empty() && segment > last)
+            {
+                error_code ec;
+                remove(segment_filename(filename_, segment), ec);
+            }
+        }
+
+        handles_.clear();
+        file_size_ = 0;
+        data_ = nullptr;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Keep logging out of the critical section.
+    if (!error_name.empty())
+        return handle_error(error_name);
+
+    LOG_DEBUG(LOG_DATABASE)
+        << "Unmapped: " << filename_ << " [" << logical_size_ << "]";
+    return true;
+}
+
+bool segmented_storage::closed() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return closed_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The writer adds only whole segments, each in place, so the segments added
+// since open (or the last refresh) are mapped without draining readers.
+bool segmented_storage::refresh()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(mutex_);
+
+        if (closed_ || !read_only_)
+            return !closed_;
+
+        error_code ec;
+        while (handles_.size() < segments_ &&
+            exists(segment_filename(filename_, handles_.size()), ec))
+        {
+            if (!map_segment(handles_.size(), false, false))
+                break;
+        }
+
+        // The logical size is that of the files, as on open.
+        const auto last = handles_.size() - 1u;
+        const auto size = last * segment_size_ + static_cast<size_t>(
+            file_size(segment_filename(filename_, last), ec));
+
+        if (ec || size <= logical_size_)
+            return !ec;
+
+        logical_size_ = size;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    LOG_DEBUG(LOG_DATABASE)
+        << "Mapping: " << filename_ << " [" << handles_.size() << " x "
+        << segment_size_ << "]";
+    return true;
+}
+
+// Operations.
+// ----------------------------------------------------------------------------
+
+size_t segmented_storage::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return file_size_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t segmented_storage::logical_size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return logical_size_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The page vector is bounded, so a large map is measured in chunks.
+size_t segmented_storage::resident_size() const
+{
+#ifdef _WIN32
+    return 0;
+#else
+    static const size_t chunk_pages = 64 * 1024;
+    const auto page_size = page();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (data_ == nullptr || page_size == 0)
+        return 0;
+
+    const auto pages = file_size_ / page_size;
+#ifdef __linux__
+    std::vector<unsigned char> residency(std::min(pages, chunk_pages));
+#else
+    std::vector<char> residency(std::min(pages, chunk_pages));
+#endif
+    size_t resident = 0;
+
+    for (size_t first = 0; first < pages; first += chunk_pages)
+    {
+        const auto count = std::min(pages - first, chunk_pages);
+
+        // The low bit of each page byte is set if the page is resident.
+        if (mincore(data_ + first * page_size, count * page_size,
+            residency.data()) == FAIL)
+            return 0;
+
+        for (size_t index = 0; index < count; ++index)
+            if ((residency[index] & 1) != 0)
+                ++resident;
+    }
+
+    return resident * page_size;
+    ///////////////////////////////////////////////////////////////////////////
+#endif
+}
+
+size_t segmented_storage::segments() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return handles_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+memory_ptr segmented_storage::access()
+{
+    const auto data = pin_readers();
+
+    // The pin is not released until the memory shared pointer is freed.
+    return std::make_shared<pinned_accessor>(readers_, data);
+}
+
+memory_handle segmented_storage::pin()
+{
+    const auto data = pin_readers();
+
+    // The pin is not released until the handle is destroyed.
+    return memory_handle(data, &segmented_storage::unpin, &readers_);
+}
+
+// private
+// The map never moves, so the pin only defers close.
+uint8_t* segmented_storage::pin_readers()
+{
+    readers_.fetch_add(1);
+
+    // The store should only have been closed after all threads terminated.
+    if (closed_)
+    {
+        readers_.fetch_sub(1);
+        throw std::runtime_error("Access failure, store closed.");
+    }
+
+    pinned_accessor::hold(readers_);
+    return data_;
+}
+
+// private
+void segmented_storage::unpin(void* readers)
+{
+    pinned_accessor::release(*static_cast<std::atomic<size_t>*>(readers));
+}
+
+// Throws runtime_error if insufficient space or segments.
+memory_ptr segmented_storage::resize(size_t size)
+{
+    return reserve(size);
+}
+
+// Throws runtime_error if insufficient space or segments.
+// Growth is by whole segments, each mapped in place, so existing pointers
+// remain valid and pinned readers are not drained.
+memory_ptr segmented_storage::reserve(size_t size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    // accessor constructor calls mutex_.lock_upgrade();
+    auto memory = std::make_shared<accessor>(mutex_);
+
+    // The store should only have been closed after all threads terminated.
+    if (closed_)
+    {
+        memory->assign(data_);
+        throw std::runtime_error("Resize failure, store already closed.");
+    }
+
+    if (read_only_)
+    {
+        memory->assign(data_);
+        throw std::runtime_error("Resize failure, store is read only.");
+    }
+
+    if (size > file_size_)
+    {
+        mutex_.unlock_upgrade_and_lock();
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+        LOG_DEBUG(LOG_DATABASE)
+            << "Resizing: " << filename_ << " [" << size << "]";
+
+        if (!fit(size))
+        {
+            // The accessor releases the (shared) lock as it is destroyed.
+            mutex_.unlock_and_lock_upgrade();
+            memory->assign(data_);
+            handle_error("resize");
+            throw std::runtime_error(
+                "Resize failure, disk space or segments may be low.");
+        }
+
+        //---------------------------------------------------------------------
+        mutex_.unlock_and_lock_upgrade();
+    }
+
+    // Track the newly-allocated range for background writeback.
+    if (size > logical_size_)
+    {
+        dirty_begin_ = std::min(dirty_begin_, logical_size_);
+        dirty_end_ = std::max(dirty_end_, size);
+        journal(logical_size_, size - logical_size_);
+    }
+
+    logical_size_ = size;
+
+    // assign() calls mutex_.unlock_upgrade_and_lock_shared();
+    memory->assign(data_);
+
+    // Always return in shared lock state. (see above, assign() sets this state)
+    // The critical section does not end until the memory shared pointer is freed.
+    return memory;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Journal.
+// ----------------------------------------------------------------------------
+
+void segmented_storage::journal(file_offset offset, size_t size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(journal_mutex_);
+
+    if (journaled_ && size != 0)
+        journal_.emplace_back(offset, size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Pages partially within the range are zeroed and written back as usual.
+void segmented_storage::release(file_offset offset, size_t size)
+{
+    // Pin the map so that it cannot be closed.
+    const auto memory = access();
+
+    if (size == 0 || offset >= file_size_)
+        return;
+
+    const auto end = std::min(offset + size, file_size_);
+    std::memset(memory->buffer() + offset, 0x00, end - offset);
+    journal(offset, end - offset);
+
+#ifdef FALLOC_FL_PUNCH_HOLE
+    // The hole must be page aligned, and reads as zeros when faulted back.
+    const auto page_size = page();
+
+    if (page_size == 0)
+        return;
+
+    const auto first = (offset + page_size - 1u) / page_size * page_size;
+    const auto last = end - end % page_size;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    // Segments are page aligned, so the hole is punched in each segment.
+    for (auto start = first; start < last;)
+    {
+        const auto segment = static_cast<size_t>(start / segment_size_);
+        const auto base = segment * segment_size_;
+        const auto stop = std::min(static_cast<size_t>(last),
+            base + segment_size_);
+
+        // Release only reclaims space, so failure is not an error.
+        fallocate(handles_[segment], FALLOC_FL_PUNCH_HOLE |
+            FALLOC_FL_KEEP_SIZE, start - base, stop - start);
+
+        start = stop;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+#endif
+}
+
+// The read-ahead is asynchronous, so this only costs a system call.
+void segmented_storage::prefetch(file_offset offset, size_t size)
+{
+    // Pin the map so that it cannot be closed.
+    const auto memory = access();
+
+    if (size == 0 || offset >= file_size_)
+        return;
+
+    // The madvise address must be page aligned.
+    const auto page_size = page();
+    const auto start = page_size == 0 ? 0 : offset - offset % page_size;
+    const auto length = std::min(offset + size, file_size_) - start;
+
+    // Advice is only a hint, so failure is not an error.
+    madvise(memory->buffer() + start, length, MADV_WILLNEED);
+}
+
+// The map is otherwise left to default read-ahead, which is reverted to here.
+void segmented_storage::scan(file_offset offset, size_t size,
+    bool sequential)
+{
+    // Pin the map so that it cannot be closed.
+    const auto memory = access();
+
+    if (size == 0 || offset >= file_size_)
+        return;
+
+    // The madvise address must be page aligned.
+    const auto page_size = page();
+    const auto start = page_size == 0 ? 0 : offset - offset % page_size;
+    const auto length = std::min(offset + size, file_size_) - start;
+    const auto buffer = memory->buffer() + start;
+
+    // Advice is only a hint, so failure is not an error.
+#ifdef MADV_SEQUENTIAL
+    madvise(buffer, length, sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+#endif
+
+    if (sequential)
+        madvise(buffer, length, MADV_WILLNEED);
+}
+
+void segmented_storage::enable_journal()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(journal_mutex_);
+    journaled_ = true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void segmented_storage::enable_advice(const map_advice& advice,
+    size_t header_size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    advice_ = advice;
+    advice_size_ = advice.header_only ? header_size : 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void segmented_storage::enable_growth(const file_growth& growth)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    growth_ = growth;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void segmented_storage::pregrow()
+{
+}
+
+// The file system compresses in extents of 128KB, so the map remains randomly
+// addressable at little cost, and the page cache holds decompressed pages.
+// The segment is flagged so that later writes in place remain compressed.
+// One segment is compressed per call, which bounds the cost of the caller.
+size_t segmented_storage::compress(size_t retain)
+{
+#if defined(BTRFS_IOC_DEFRAG_RANGE) && defined(FS_IOC_SETFLAGS)
+    if (!compressible_.load())
+        return 0;
+
+    // Pin the map so that it cannot be closed.
+    const auto memory = access();
+    size_t segment;
+    int handle;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+
+        if (read_only_)
+            return 0;
+
+        // Only full segments older than those retained are candidates.
+        const auto full = logical_size_ / segment_size_;
+        segment = compressed_.load();
+
+        if (segment + retain >= full || segment >= handles_.size())
+            return 0;
+
+        handle = handles_[segment];
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    int flags = 0;
+    if (ioctl(handle, FS_IOC_GETFLAGS, &flags) == FAIL)
+    {
+        compressible_.store(false);
+        return 0;
+    }
+
+    if ((flags & FS_COMPR_FL) == 0)
+    {
+        btrfs_ioctl_defrag_range_args args;
+        std::memset(&args, 0, sizeof(args));
+        args.len = static_cast<uint64_t>(-1);
+        args.flags = BTRFS_DEFRAG_RANGE_COMPRESS |
+            BTRFS_DEFRAG_RANGE_START_IO;
+        args.compress_type = compress_zstd;
+
+        // Other file systems do not support the ioctl, so stop trying.
+        if (ioctl(handle, BTRFS_IOC_DEFRAG_RANGE, &args) == FAIL)
+        {
+            if (errno == ENOTTY || errno == EOPNOTSUPP || errno == EINVAL)
+                compressible_.store(false);
+            else
+                handle_error("compress");
+
+            return 0;
+        }
+
+        // The flag is only a hint for later writes, so failure is ignored.
+        flags |= FS_COMPR_FL;
+        ioctl(handle, FS_IOC_SETFLAGS, &flags);
+    }
+
+#ifdef MADV_COLD
+    // The segment is no longer expected to be read often.
+    madvise(memory->buffer() + segment * segment_size_, segment_size_,
+        MADV_COLD);
+#endif
+
+    compressed_.store(segment + 1u);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// Overlapping and adjacent ranges are coalesced, and each range is limited to
+// the logical size, since a range may have been popped after it was written.
+// Offsets are of the table (not the segment), as the map is contiguous.
+bool segmented_storage::log_writes(commit_log& log)
+{
+    std::vector<range> ranges;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        unique_lock lock(journal_mutex_);
+        ranges.swap(journal_);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (ranges.empty())
+        return true;
+
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<range> merged;
+    merged.reserve(ranges.size());
+
+    for (const auto& item: ranges)
+    {
+        if (!merged.empty() &&
+            item.first <= merged.back().first + merged.back().second)
+        {
+            auto& last = merged.back();
+            const auto end = std::max(last.first + last.second,
+                item.first + item.second);
+            last.second = static_cast<size_t>(end - last.first);
+        }
+        else
+        {
+            merged.push_back(item);
+        }
+    }
+
+    size_t logical_size;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        shared_lock lock(mutex_);
+        logical_size = logical_size_;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto table = filename_.filename().string();
+    const auto memory = access();
+
+    for (const auto& item: merged)
+    {
+        if (item.first >= logical_size)
+            continue;
+
+        const auto size = std::min(item.second,
+            static_cast<size_t>(logical_size - item.first));
+
+        log.write(table, item.first, memory->buffer() + item.first, size);
+    }
+
+    return true;
+}
+
+void segmented_storage::enable_metrics(table_metrics&)
+{
+}
+
+// privates
+// ----------------------------------------------------------------------------
+
+size_t segmented_storage::page() const
+{
+#ifdef _WIN32
+    SYSTEM_INFO configuration;
+    GetSystemInfo(&configuration);
+    return configuration.dwPageSize;
+#else
+    const auto page_size = sysconf(_SC_PAGESIZE);
+    return static_cast<size_t>(page_size == -1 ? 0 : page_size);
+#endif
+}
+
+// Must be called under exclusive lock, with the address range reserved.
+// A full segment (not last) that is not writable is mapped read only.
+bool segmented_storage::map_segment(size_t segment, bool create, bool last)
+{
+    const auto filename = segment_filename(filename_, segment).string();
+    const auto mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    auto writable = !read_only_;
+    auto handle = ::open(filename.c_str(), writable ?
+        (O_RDWR | (create ? O_CREAT : 0)) : O_RDONLY, mode);
+
+    if (handle == INVALID_HANDLE && writable && !create && !last)
+    {
+        handle = ::open(filename.c_str(), O_RDONLY);
+        writable = false;
+    }
+
+    if (handle == INVALID_HANDLE)
+        return false;
+
+#ifdef FALLOC_FL_KEEP_SIZE
+    // Allocate a new segment on disk, so that a full disk fails the growth.
+    if (create && growth_.preallocate &&
+        fallocate(handle, FALLOC_FL_KEEP_SIZE, 0, segment_size_) == FAIL &&
+        errno != EOPNOTSUPP && errno != ENOSYS)
+    {
+        ::close(handle);
+        return false;
+    }
+#endif
+
+    // The segment is extended (sparse) to its full size, so that it is
+    // mapped whole. Only the last segment is fit to the logical size.
+    const auto protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    const auto start = data_ + segment * segment_size_;
+
+    if ((writable && ftruncate(handle, segment_size_) == FAIL) ||
+        mmap(start, segment_size_, protection, MAP_SHARED | MAP_FIXED, handle,
+            0) == MAP_FAILED)
+    {
+        ::close(handle);
+        return false;
+    }
+
+    handles_.push_back(handle);
+    file_size_ += segment_size_;
+    advise(file_size_ - segment_size_, file_size_);
+    return true;
+}
+
+// Must be called under exclusive lock.
+bool segmented_storage::fit(size_t size)
+{
+    while (file_size_ < size)
+        if (handles_.size() == segments_ ||
+            !map_segment(handles_.size(), true, true))
+            return false;
+
+    return true;
+}
+
+// Must be called under exclusive lock, with the range mapped.
+// Advice is only a hint, so failure is not an error (and is not logged here,
+// since this is always a critical section).
+void segmented_storage::advise(size_t start, size_t end) const
+{
+    // The advice is limited to the header, unless there is none (zero).
+    const auto limit = advice_size_ == 0 ? end : std::min(advice_size_, end);
+    const auto buffer = data_ + start;
+    const auto size = limit > start ? limit - start : 0;
+
+    if (size != 0)
+    {
+#ifdef MADV_HUGEPAGE
+        if (advice_.huge_pages)
+            madvise(buffer, size, MADV_HUGEPAGE);
+#endif
+
+#ifdef __NR_mbind
+        // MPOL_BIND (2) and MPOL_INTERLEAVE (3), see linux/mempolicy.h.
+        if (advice_.numa != numa_policy::none && advice_.numa_nodes != 0)
+        {
+            const unsigned long mode = advice_.numa == numa_policy::bind ?
+                2 : 3;
+            const unsigned long nodes = advice_.numa_nodes;
+            const unsigned long max_node = sizeof(nodes) * 8 + 1;
+            syscall(__NR_mbind, buffer, size, mode, &nodes, max_node, 0);
+        }
+#endif
+
+#ifdef MADV_POPULATE_READ
+        if (advice_.populate)
+            madvise(buffer, size, MADV_POPULATE_READ);
+#elif defined(MADV_WILLNEED)
+        if (advice_.populate)
+            madvise(buffer, size, MADV_WILLNEED);
+#endif
+
+        if (advice_.lock)
+            mlock(buffer, size);
+    }
+
+#ifdef MADV_COLD
+    // Only the map beyond the (page aligned) header is cold.
+    const auto page_size = page();
+    const auto header = page_size == 0 ? advice_size_ :
+        (advice_size_ + page_size - 1) / page_size * page_size;
+    const auto cold = std::max(start, header);
+
+    if (advice_.cold && advice_size_ != 0 && cold < end)
+        madvise(data_ + cold, end - cold, MADV_COLD);
+#endif
+}
+
+// Must be called under exclusive lock, so there can be only one drainer.
+// The map never moves, so this waits for pinned readers only on close.
+void segmented_storage::drain_readers()
+{
+    while (readers_.load() != 0)
+        std::this_thread::yield();
+}
+
+bool segmented_storage::handle_error(const std::string& context) const
+{
+#ifdef _WIN32
+    const auto error = GetLastError();
+#else
+    const auto error = errno;
+#endif
+    LOG_FATAL(LOG_DATABASE)
+        << "The file failed to " << context << ": " << filename_ << " : "
+        << error;
+    return false;
+}
+
+} // namespace database
+} // namespace libbitcoin
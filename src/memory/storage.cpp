@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/memory/storage.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <boost/filesystem.hpp>
+#include <bitcoin/database/memory/buffer_storage.hpp>
+#include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/memory_storage.hpp>
+#include <bitcoin/database/memory/segmented_storage.hpp>
+#include <bitcoin/database/storage_backend.hpp>
+#include <bitcoin/database/table_metrics.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+storage::ptr storage::factory(storage_backend backend,
+    const boost::filesystem::path& filename, size_t expansion,
+    size_t reservation)
+{
+    switch (backend)
+    {
+        case storage_backend::memory:
+            return std::make_shared<memory_storage>(filename, expansion);
+        case storage_backend::huge_pages:
+            return std::make_shared<memory_storage>(filename, expansion, true);
+        case storage_backend::buffered:
+            return std::make_shared<buffer_storage>(filename, expansion);
+        case storage_backend::read_only:
+            return std::make_shared<file_storage>(filename, expansion, 0,
+                true);
+        case storage_backend::segmented:
+            return std::make_shared<segmented_storage>(filename);
+        case storage_backend::segmented_read_only:
+            return std::make_shared<segmented_storage>(filename,
+                segmented_storage::default_segment_size,
+                segmented_storage::default_segments, true);
+        case storage_backend::file:
+        default:
+            return std::make_shared<file_storage>(filename, expansion,
+                reservation);
+    }
+}
+
+void storage::footprint(table_metrics::values& values, const storage& file)
+{
+    values.logical_bytes += file.logical_size();
+    values.physical_bytes += file.size();
+    values.resident_bytes += file.resident_size();
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/parallel.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace libbitcoin {
+namespace database {
+
+size_t parallelism(size_t configured)
+{
+    if (configured != 0)
+        return configured;
+
+    // hardware_concurrency may return zero if not computable.
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void parallel_for(size_t count, size_t threads, size_t minimum,
+    const partition_handler& handler)
+{
+    if (count == 0)
+        return;
+
+    const auto ranges = std::max(std::min(threads,
+        count / std::max(minimum, size_t(1))), size_t(1));
+
+    if (ranges == 1)
+    {
+        handler(0, count);
+        return;
+    }
+
+    // The first range is handled on the calling thread.
+    const auto size = (count + ranges - 1) / ranges;
+    std::vector<std::thread> workers;
+    workers.reserve(ranges - 1);
+
+    for (auto first = size; first < count; first += size)
+        workers.emplace_back(handler, first, std::min(first + size, count));
+
+    handler(0, size);
+
+    for (auto& worker: workers)
+        worker.join();
+}
+
+} // namespace database
+} // namespace libbitcoin
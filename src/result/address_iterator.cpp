@@ -23,12 +23,19 @@ namespace database {
 
 using namespace bc::chain;
 
-address_iterator::address_iterator(const const_element& element)
-  : element_(element)
+address_iterator::address_iterator(const const_element& element,
+    size_t from_height, size_t limit)
+  : element_(element), from_height_(from_height), remaining_(limit)
 {
     populate();
 }
 
+bool address_iterator::exhausted() const
+{
+    return element_.terminal() || remaining_ == 0;
+}
+
+// Rows are newest first, each prefixed by the height at which it was indexed.
 void address_iterator::populate()
 {
     // Because it is common to not return all addresses, based on a total count
@@ -37,13 +44,26 @@ void address_iterator::populate()
     // this behavior can be modified within this iterator as desired.
     if (!element_.terminal())
     {
+        size_t height;
         element_.read([&](byte_deserializer& deserial)
         {
+            height = deserial.read_4_bytes_little_endian();
             payment_.from_data(deserial, false);
         });
+
+        payment_.set_height(height);
+
+        // Older rows were indexed at the same or lower heights.
+        if (height < from_height_)
+            element_.terminate();
     }
 }
 
+uint64_t address_iterator::link() const
+{
+    return element_.position();
+}
+
 address_iterator::pointer address_iterator::operator->() const
 {
     return payment_;
@@ -57,6 +77,7 @@ address_iterator::reference address_iterator::operator*() const
 address_iterator::iterator& address_iterator::operator++()
 {
     element_.jump_next();
+    --remaining_;
     populate();
     return *this;
 }
@@ -65,14 +86,19 @@ address_iterator::iterator address_iterator::operator++(int)
 {
     auto it = *this;
     element_.jump_next();
+    --remaining_;
     populate();
     return it;
 }
 
 bool address_iterator::operator==(const address_iterator& other) const
 {
-    // This is sufficient due to the behavior of the list_element equality
-    // operator override. Only the link values are compared.
+    // All exhausted iterators are equal to the end iterator.
+    if (exhausted() || other.exhausted())
+        return exhausted() && other.exhausted();
+
+    // This is sufficient due to the behavior of the chunk_element equality
+    // operator override. Only the positions are compared.
     return element_ == other.element_;
 }
 
@@ -28,8 +28,8 @@ namespace libbitcoin {
 namespace database {
 
 address_result::address_result(const const_value_type& element,
-    const short_hash& hash)
-  : hash_(hash), element_(element)
+    const short_hash& hash, size_t from_height, size_t limit)
+  : hash_(hash), from_height_(from_height), limit_(limit), element_(element)
 {
 }
 
@@ -45,7 +45,7 @@ const short_hash& address_result::hash() const
 
 address_iterator address_result::begin() const
 {
-    return { element_ };
+    return { element_, from_height_, limit_ };
 }
 
 address_iterator address_result::end() const
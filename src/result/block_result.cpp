@@ -22,6 +22,7 @@
 #include <cstddef>
 #include <utility>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/block_record.hpp>
 #include <bitcoin/database/block_state.hpp>
 #include <bitcoin/database/memory/memory.hpp>
 #include <bitcoin/database/primitives/record_manager.hpp>
@@ -32,24 +33,11 @@ namespace database {
 
 using namespace bc::chain;
 
-static const auto header_size = header::satoshi_fixed_size();
-static constexpr auto median_time_past_size = sizeof(uint32_t);
-static constexpr auto height_size = sizeof(uint32_t);
-static constexpr auto state_size = sizeof(uint8_t);
-static constexpr auto checksum_size = sizeof(uint32_t);
-static constexpr auto tx_start_size = sizeof(uint32_t);
-static constexpr auto tx_count_size = sizeof(uint16_t);
-
-static const auto height_offset = header_size + median_time_past_size;
-static const auto state_offset = height_offset + height_size;
-static const auto checksum_offset = state_offset + state_size;
-static const auto transactions_offset = checksum_offset + checksum_size;
-
 // Placeholder for unimplemented checksum caching.
 static constexpr auto no_checksum = 0u;
 
 block_result::block_result(const const_element_type& element,
-    shared_mutex& metadata_mutex, const manager& index_manager)
+    const sequence_lock& metadata_lock, const manager& index_manager)
   : height_(0),
     median_time_past_(0),
     state_(block_state::missing),
@@ -58,7 +46,7 @@ block_result::block_result(const const_element_type& element,
     tx_count_(0),
     element_(element),
     index_manager_(index_manager),
-    metadata_mutex_(metadata_mutex)
+    metadata_lock_(metadata_lock)
 {
     if (!element_)
         return;
@@ -66,23 +54,25 @@ block_result::block_result(const const_element_type& element,
     auto hash = element_.key();
 
     // Each of the three atomic sets could be guarded independently.
-    const auto reader = [&](byte_deserializer& deserial)
+    const auto reader = [&](const block_record& record)
     {
-        // Critical Section.
-        ///////////////////////////////////////////////////////////////////////
-        shared_lock lock(metadata_mutex_);
-        header_.from_data(deserial, std::move(hash), false);
-        median_time_past_ = deserial.read_4_bytes_little_endian();
-        height_ = deserial.read_4_bytes_little_endian();
-        state_ = deserial.read_byte();
-        checksum_ = deserial.read_4_bytes_little_endian();
-        tx_start_ = deserial.read_4_bytes_little_endian();
-        tx_count_ = deserial.read_2_bytes_little_endian();
-        ///////////////////////////////////////////////////////////////////////
+        auto deserial = make_unsafe_deserializer(&record.header[0]);
+        header_.from_data(deserial, hash, false);
+        median_time_past_ = block_record::load<uint32_t>(
+            record.median_time_past);
+        height_ = block_record::load<uint32_t>(record.height);
+        state_ = block_record::load<uint8_t>(record.state);
+        checksum_ = block_record::load<uint32_t>(record.checksum);
+        tx_start_ = block_record::load<uint32_t>(record.tx_start);
+        tx_count_ = block_record::load<uint16_t>(record.tx_count);
     };
 
-     // Reads are not deferred for updatable values as atomicity is required.
-     element.read(reader);
+    // Reads are not deferred for updatable values as atomicity is required.
+    // The read is repeated if it overlaps a write of the metadata.
+    metadata_lock_.read([&]()
+    {
+        element.read_record<block_record>(reader);
+    });
 }
 
 block_result::operator bool() const
@@ -19,25 +19,13 @@
 #include <bitcoin/database/result/inpoint_iterator.hpp>
 
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/result/transaction_result.hpp>
 
 namespace libbitcoin {
 namespace database {
 
 using namespace bc::chain;
 
-static constexpr auto height_size = sizeof(uint32_t);
-static constexpr auto position_size = sizeof(uint16_t);
-static constexpr auto state_size = sizeof(uint8_t);
-static constexpr auto median_time_past_size = sizeof(uint32_t);
-
-static constexpr auto index_spend_size = sizeof(uint8_t);
-////static constexpr auto height_size = sizeof(uint32_t);
-static constexpr auto value_size = sizeof(uint64_t);
-
-static constexpr auto spend_size = index_spend_size + height_size + value_size;
-static constexpr auto metadata_size = height_size + position_size +
-    state_size + median_time_past_size;
-
 static constexpr auto sequence_size = sizeof(uint32_t);
 
 inpoint_iterator::inpoint_iterator(const const_element& element)
@@ -49,23 +37,30 @@ inpoint_iterator::inpoint_iterator(const const_element& element)
     {
         element.read([&](byte_deserializer& deserial)
         {
-            deserial.skip(metadata_size);
-            const auto outputs = deserial.read_size_little_endian();
-
             // Skip outputs.
-            for (auto output = 0u; output < outputs; ++output)
-            {
-                deserial.skip(spend_size);
-                deserial.skip(deserial.read_size_little_endian());
-            }
+            size_t offset;
+            uint8_t flags;
+            transaction_result::seek_output(deserial, max_uint32, offset,
+                flags);
 
+            const auto linked = (flags & transaction_result::inputs_linked)
+                != 0;
              auto inputs = deserial.read_size_little_endian();
             inpoints_.resize(inputs);
+            parents_.resize(inputs);
 
             for (auto input = 0u; input < inputs; ++input)
             {
-                // Read input point.
-                inpoints_[input].from_data(deserial, false);
+                // Read input point, the hash of a linked point is its key.
+                output_point point;
+                const auto parent = transaction_result::read_point(deserial,
+                    point, linked);
+
+                if (parent != const_element::not_found)
+                    point = { element.at(parent).key(), point.index() };
+
+                inpoints_[input] = point;
+                parents_[input] = parent;
 
                 // Skip script.
                 deserial.skip(deserial.read_size_little_endian());
@@ -105,6 +100,11 @@ inpoint_iterator::iterator inpoint_iterator::operator++(int)
     return it;
 }
 
+file_offset inpoint_iterator::parent() const
+{
+    return parents_[index_];
+}
+
 bool inpoint_iterator::operator==(const inpoint_iterator& other) const
 {
     // Cannot compare vectors iterators because they are from different vectors.
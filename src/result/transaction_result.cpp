@@ -18,10 +18,13 @@
  */
 #include <bitcoin/database/result/transaction_result.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <utility>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/compact_codec.hpp>
+#include <bitcoin/database/crc32c.hpp>
 #include <bitcoin/database/databases/transaction_database.hpp>
 #include <bitcoin/database/memory/memory.hpp>
 
@@ -44,38 +47,126 @@ static constexpr auto spend_size = index_spend_size + height_size + value_size;
 static constexpr auto metadata_size = height_size + position_size +
     state_size + median_time_past_size;
 
+static constexpr auto table_offset_size = sizeof(uint32_t);
+
+static constexpr auto link_size = sizeof(file_offset);
+static constexpr auto index_size = sizeof(uint16_t);
+static constexpr auto point_size = hash_size + index_size;
+static constexpr auto sequence_size = sizeof(uint32_t);
+
+static constexpr auto split_size = sizeof(uint32_t) + sizeof(uint64_t);
+static constexpr auto not_split =
+    transaction_result::const_element_type::not_found;
+
+// The format flags of a state byte (all but candidate).
+static uint8_t to_flags(uint8_t state)
+{
+    return state & ~transaction_result::candidate_true;
+}
+
+// The stored size of a variable length integer.
+static size_t variable_size(uint64_t value)
+{
+    return value < 0xfd ? 1 : value <= max_uint16 ? 3 :
+        value <= max_uint32 ? 5 : 9;
+}
+
 const uint8_t transaction_result::candidate_true = 1;
 const uint8_t transaction_result::candidate_false = 0;
+const uint8_t transaction_result::outputs_indexed = 2;
+const uint8_t transaction_result::outputs_compact = 4;
+const uint8_t transaction_result::inputs_linked = 8;
+const uint8_t transaction_result::state_split = 16;
+const uint8_t transaction_result::payload_pruned = 32;
+const uint8_t transaction_result::payload_checked = 64;
 const uint16_t transaction_result::unconfirmed = max_uint16;
 const uint32_t transaction_result::unverified = rule_fork::unverified;
 
 transaction_result::transaction_result(const const_element_type& element,
-    shared_mutex& metadata_mutex)
+    const sequence_lock& metadata_lock, const state_table& state)
+  : transaction_result(element, metadata_lock, state, true)
+{
+}
+
+transaction_result::transaction_result(const const_element_type& element,
+    const sequence_lock& metadata_lock, const state_table& state,
+    bool metadata)
   : candidate_(false),
+    pruned_(false),
     height_(0),
     position_(unconfirmed),
     median_time_past_(0),
+    outputs_(not_split),
     element_(element),
-    metadata_mutex_(metadata_mutex)
+    metadata_lock_(metadata_lock),
+    state_(state)
 {
     if (!element_)
         return;
 
+    // The format flags and ordinals are set only on store, so are not guarded.
+    // The pruned flag is set once (below any reorganization), so neither.
+    if (!metadata)
+    {
+        element.read([&](byte_deserializer& deserial)
+        {
+            deserial.skip(height_size + position_size);
+            const auto state = deserial.read_byte();
+            pruned_ = (state & payload_pruned) != 0;
+            deserial.skip(median_time_past_size);
+
+            if ((state & state_split) != 0)
+            {
+                deserial.skip(sizeof(uint32_t));
+                outputs_ = deserial.read_8_bytes_little_endian();
+            }
+        });
+
+        return;
+    }
+
     // There is only one atomic set here.
-    const auto reader = [&](byte_deserializer& deserial)
+    const auto read = [&](byte_deserializer& deserial)
     {
-        // Critical Section
-        ///////////////////////////////////////////////////////////////////////
-        shared_lock lock(metadata_mutex_);
         height_ = deserial.read_4_bytes_little_endian();
         position_ = deserial.read_2_bytes_little_endian();
-        candidate_ = deserial.read_byte() == candidate_true;
+        const auto state = deserial.read_byte();
+        candidate_ = (state & candidate_true) != 0;
         median_time_past_ = deserial.read_4_bytes_little_endian();
-        ///////////////////////////////////////////////////////////////////////
+        return state;
+    };
+
+    file_offset ordinal = 0;
+    const auto reader = [&](byte_deserializer& deserial)
+    {
+        const auto state = read(deserial);
+        pruned_ = (state & payload_pruned) != 0;
+
+        // The ordinals are set only on store, so are not guarded.
+        if ((state & state_split) != 0)
+        {
+            ordinal = deserial.read_4_bytes_little_endian();
+            outputs_ = deserial.read_8_bytes_little_endian();
+        }
     };
 
     // Metadata reads not deferred for updatable values as atomicity required.
-    element.read(reader);
+    // The read is repeated if it overlaps a write of the metadata.
+    metadata_lock_.read([&]()
+    {
+        element.read(reader);
+    });
+
+    if (outputs_ == not_split)
+        return;
+
+    // The state of a split record is not updated in the record.
+    const auto memory = state_.transaction(ordinal);
+    metadata_lock_.read([&]()
+    {
+        auto deserial = make_unsafe_deserializer(memory->buffer());
+        read(deserial);
+    });
 }
 
 transaction_result::operator bool() const
@@ -116,6 +207,11 @@ uint32_t transaction_result::median_time_past() const
     return median_time_past_;
 }
 
+bool transaction_result::pruned() const
+{
+    return pruned_;
+}
+
 bool transaction_result::is_spent(size_t fork_height, bool candidate) const
 {
     const auto confirmed = position_ != unconfirmed && height_ <= fork_height;
@@ -130,15 +226,23 @@ bool transaction_result::is_spent(size_t fork_height, bool candidate) const
     // Spentness is unguarded and will be inconsistent during write.
     const auto reader = [&](byte_deserializer& deserial)
     {
-        deserial.skip(metadata_size);
+        const auto compact = (skip_metadata(deserial) & outputs_compact) != 0;
         const auto outputs = deserial.read_size_little_endian();
 
-        // Search all outputs for an unspent indication.
-        for (auto out = 0u; spent && out < outputs; ++out)
+        // Search all outputs for an unspent indication (spends only).
+        for (size_t out = 0; spent && out < outputs; ++out)
         {
-            // TODO: This reads full output, which is simple but not optimial.
-            const auto output = output::factory(deserial, false);
-            spent = output.metadata.spent(fork_height, candidate_ && candidate);
+            spent = read_spent(deserial, out, fork_height,
+                candidate_ && candidate);
+
+            if (compact)
+            {
+                compact_codec::skip_payload(deserial);
+                continue;
+            }
+
+            deserial.skip(value_size);
+            deserial.skip(deserial.read_size_little_endian());
         }
     };
 
@@ -146,6 +250,24 @@ bool transaction_result::is_spent(size_t fork_height, bool candidate) const
     return spent;
 }
 
+bool transaction_result::is_spent(uint32_t index, size_t fork_height,
+    bool candidate) const
+{
+    BITCOIN_ASSERT(element_);
+    auto spent = true;
+
+    // Spentness is unguarded and will be inconsistent during write.
+    const auto reader = [&](byte_deserializer& deserial)
+    {
+        size_t offset;
+        if (index < seek_output(deserial, index, offset))
+            spent = read_spent(deserial, index, fork_height, candidate);
+    };
+
+    element_.read(reader);
+    return spent;
+}
+
 // If index is out of range returns default/invalid output (.value not_found).
 chain::output transaction_result::output(uint32_t index) const
 {
@@ -155,21 +277,17 @@ chain::output transaction_result::output(uint32_t index) const
     // Spentness is unguarded and will be inconsistent during write.
     const auto reader = [&](byte_deserializer& deserial)
     {
-        deserial.skip(metadata_size);
-        const auto outputs = deserial.read_size_little_endian();
-
-        if (index >= outputs)
+        size_t offset;
+        uint8_t flags;
+        if (index >= seek_output(deserial, index, offset, flags))
             return;
 
-        // Skip outputs until the target output.
-        for (auto out = 0u; out < index; ++out)
-        {
-            deserial.skip(spend_size);
-            deserial.skip(deserial.read_size_little_endian());
-        }
-
         // Read the target output.
-        output.from_data(deserial, false);
+        if ((flags & (outputs_compact | state_split)) != 0)
+            output.from_data(read_output(deserial,
+                (flags & outputs_compact) != 0, index), false);
+        else
+            output.from_data(deserial, false);
     };
 
     // Read and return the target output (including spender height).
@@ -186,8 +304,17 @@ chain::transaction transaction_result::transaction(bool witness) const
 
     const auto reader = [&](byte_deserializer& deserial)
     {
-        deserial.skip(metadata_size);
-        tx.from_data(deserial, std::move(key), false, witness);
+        const auto flags = skip_metadata(deserial);
+
+        if ((flags & (outputs_compact | inputs_linked | state_split)) == 0)
+        {
+            tx.from_data(deserial, std::move(key), false, witness);
+            return;
+        }
+
+        const auto data = expand(deserial, flags);
+        auto expanded = make_unsafe_deserializer(data.begin());
+        tx.from_data(expanded, std::move(key), false, witness);
     };
 
     element_.read(reader);
@@ -198,6 +325,29 @@ chain::transaction transaction_result::transaction(bool witness) const
     return tx;
 }
 
+transaction_view transaction_result::view() const
+{
+    BITCOIN_ASSERT(element_);
+    return { element_ };
+}
+
+// The flags are set only on store, so the state byte read is not guarded.
+// A checked record is split, so it is const and the checksum covers it all.
+bool transaction_result::verify() const
+{
+    BITCOIN_ASSERT(element_);
+    const auto state = element_.read_little_endian<uint8_t>(
+        height_size + position_size);
+
+    if ((state & payload_checked) == 0)
+        return true;
+
+    const auto size = view().record_size();
+    const auto memory = element_.state();
+    const auto checksum = crc32c(memory->buffer(), size);
+    return element_.read_little_endian<uint32_t>(size) == checksum;
+}
+
 inpoint_iterator transaction_result::begin() const
 {
     return { element_ };
@@ -208,5 +358,255 @@ inpoint_iterator transaction_result::end() const
     return { element_.terminator() };
 }
 
+// private
+// Read the spend metadata of the output, positioned at the output, leaving
+// the deserializer at its value. The value and script are not read.
+// Spentness is unguarded and will be inconsistent during write.
+bool transaction_result::read_spent(byte_deserializer& deserial, size_t index,
+    size_t fork_height, bool candidate) const
+{
+    output::validation metadata;
+
+    if (outputs_ == not_split)
+    {
+        metadata.candidate_spent = deserial.read_byte() == candidate_true;
+        metadata.spender_height = deserial.read_4_bytes_little_endian();
+        return metadata.spent(fork_height, candidate);
+    }
+
+    // The spend metadata of a split record is not updated in the record.
+    deserial.skip(index_spend_size + height_size);
+    const auto memory = state_.output(outputs_ + index);
+    auto state = make_unsafe_deserializer(memory->buffer());
+    metadata.candidate_spent = state.read_byte() == candidate_true;
+    metadata.spender_height = state.read_4_bytes_little_endian();
+    return metadata.spent(fork_height, candidate);
+}
+
+// private
+// The full stored encoding of the output, with its state if split.
+// Spentness is unguarded and will be inconsistent during write.
+data_chunk transaction_result::read_output(byte_deserializer& deserial,
+    bool compact, size_t index) const
+{
+    data_chunk data;
+
+    if (compact)
+    {
+        data = compact_codec::expand_output(deserial);
+    }
+    else
+    {
+        data_sink ostream(data);
+        ostream_writer sink(ostream);
+        sink.write_bytes(deserial.read_bytes(spend_size));
+        const auto size = deserial.read_size_little_endian();
+        sink.write_variable_little_endian(size);
+        sink.write_bytes(deserial.read_bytes(size));
+        ostream.flush();
+    }
+
+    if (outputs_ == not_split)
+        return data;
+
+    const auto memory = state_.output(outputs_ + index);
+    std::copy_n(memory->buffer(), state_table::output_size, data.begin());
+    return data;
+}
+
+// private
+// The full stored encoding of a compact, linked or split transaction, from
+// its output count. The hash of each linked point is the key of its link.
+data_chunk transaction_result::expand(byte_deserializer& deserial,
+    uint8_t flags) const
+{
+    if ((flags & (inputs_linked | state_split)) == 0)
+        return compact_codec::expand(deserial);
+
+    const auto compact = (flags & outputs_compact) != 0;
+    const auto linked = (flags & inputs_linked) != 0;
+    const auto copy_sized = [&](writer& sink)
+    {
+        const auto size = deserial.read_size_little_endian();
+        sink.write_variable_little_endian(size);
+        sink.write_bytes(deserial.read_bytes(size));
+    };
+
+    data_chunk data;
+    data_sink ostream(data);
+    ostream_writer sink(ostream);
+
+    const auto outputs = deserial.read_size_little_endian();
+    sink.write_variable_little_endian(outputs);
+
+    for (size_t output = 0; output < outputs; ++output)
+        sink.write_bytes(read_output(deserial, compact, output));
+
+    const auto inputs = deserial.read_size_little_endian();
+    sink.write_variable_little_endian(inputs);
+
+    for (size_t input = 0; input < inputs; ++input)
+    {
+        output_point point;
+        const auto parent = read_point(deserial, point, linked);
+
+        if (parent != const_element_type::not_found)
+            point = { element_.at(parent).key(), point.index() };
+
+        point.to_data(sink, false);
+        copy_sized(sink);
+
+        const auto witnesses = deserial.read_size_little_endian();
+        sink.write_variable_little_endian(witnesses);
+
+        for (size_t witness = 0; witness < witnesses; ++witness)
+            copy_sized(sink);
+
+        sink.write_bytes(deserial.read_bytes(sequence_size));
+    }
+
+    // Locktime and version.
+    sink.write_variable_little_endian(deserial.read_variable_little_endian());
+    sink.write_variable_little_endian(deserial.read_variable_little_endian());
+    ostream.flush();
+    return data;
+}
+
+// static
+// The flags are set only on store, so the state byte read is not guarded.
+uint8_t transaction_result::skip_metadata(byte_deserializer& deserial)
+{
+    deserial.skip(height_size + position_size);
+    const auto state = deserial.read_byte();
+    deserial.skip(median_time_past_size);
+
+    if ((state & state_split) != 0)
+        deserial.skip(split_size);
+
+    if ((state & outputs_indexed) != 0)
+        deserial.skip(deserial.read_size_little_endian() * table_offset_size);
+
+    return to_flags(state);
+}
+
+// static
+// The flags and ordinals are set only on store, so are not guarded.
+bool transaction_result::read_split(byte_deserializer& deserial,
+    file_offset& out_transaction, file_offset& out_outputs)
+{
+    deserial.skip(height_size + position_size);
+    const auto state = deserial.read_byte();
+    deserial.skip(median_time_past_size);
+
+    if ((state & state_split) == 0)
+        return false;
+
+    out_transaction = deserial.read_4_bytes_little_endian();
+    out_outputs = deserial.read_8_bytes_little_endian();
+    return true;
+}
+
+// static
+size_t transaction_result::seek_output(byte_deserializer& deserial,
+    uint32_t index, size_t& offset)
+{
+    uint8_t flags;
+    return seek_output(deserial, index, offset, flags);
+}
+
+// static
+// The flags are set only on store, so the state byte read is not guarded.
+size_t transaction_result::seek_output(byte_deserializer& deserial,
+    uint32_t index, size_t& offset, uint8_t& flags)
+{
+    deserial.skip(height_size + position_size);
+    const auto state = deserial.read_byte();
+    const auto indexed = (state & outputs_indexed) != 0;
+    const auto compact = (state & outputs_compact) != 0;
+    flags = to_flags(state);
+    deserial.skip(median_time_past_size);
+    offset = metadata_size;
+
+    if ((state & state_split) != 0)
+    {
+        deserial.skip(split_size);
+        offset += split_size;
+    }
+
+    if (!indexed)
+    {
+        const auto outputs = deserial.read_size_little_endian();
+        const auto target = std::min(static_cast<size_t>(index), outputs);
+        offset += variable_size(outputs);
+
+        // Skip outputs until the target output.
+        for (size_t out = 0; out < target; ++out)
+        {
+            if (compact)
+            {
+                offset += compact_codec::skip_output(deserial);
+                continue;
+            }
+
+            deserial.skip(spend_size);
+            const auto script_size = deserial.read_size_little_endian();
+            deserial.skip(script_size);
+            offset += spend_size + variable_size(script_size) + script_size;
+        }
+
+        return outputs;
+    }
+
+    // The table holds the offset of each output and of the end of outputs,
+    // relative to the start of the transaction (its output count).
+    const auto entries = deserial.read_size_little_endian();
+    const auto outputs = entries - 1u;
+    const auto target = std::min(static_cast<size_t>(index), outputs);
+    deserial.skip(target * table_offset_size);
+    const size_t relative = deserial.read_4_bytes_little_endian();
+    deserial.skip((outputs - target) * table_offset_size + relative);
+    offset += variable_size(entries) + entries * table_offset_size + relative;
+    return outputs;
+}
+
+// static
+// A linked point is [ link:8 ][ hash:32 if link not_found ][ index:2 ].
+file_offset transaction_result::read_point(byte_deserializer& deserial,
+    output_point& point, bool linked)
+{
+    const auto parent = linked ? deserial.read_8_bytes_little_endian() :
+        const_element_type::not_found;
+
+    if (parent == const_element_type::not_found)
+    {
+        point.from_data(deserial, false);
+        return parent;
+    }
+
+    // A linked point is never null, so its index has no sentinel.
+    point = { null_hash, deserial.read_2_bytes_little_endian() };
+    return parent;
+}
+
+// static
+size_t transaction_result::skip_point(byte_deserializer& deserial,
+    bool linked)
+{
+    if (!linked)
+    {
+        deserial.skip(point_size);
+        return point_size;
+    }
+
+    if (deserial.read_8_bytes_little_endian() == const_element_type::not_found)
+    {
+        deserial.skip(point_size);
+        return link_size + point_size;
+    }
+
+    deserial.skip(index_size);
+    return link_size + index_size;
+}
+
 } // namespace database
 } // namespace libbitcoin
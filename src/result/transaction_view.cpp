@@ -0,0 +1,316 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/result/transaction_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/compact_codec.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+#include <bitcoin/database/result/transaction_result.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+using namespace bc::chain;
+
+static constexpr auto candidate_spent_size = sizeof(uint8_t);
+static constexpr auto height_size = sizeof(uint32_t);
+static constexpr auto value_size = sizeof(uint64_t);
+static constexpr auto spend_size = candidate_spent_size + height_size +
+    value_size;
+
+static constexpr auto sequence_size = sizeof(uint32_t);
+
+// The wire marker and flag of a segregated transaction (bip144).
+static constexpr uint8_t segregated_marker = 0x00;
+static constexpr uint8_t segregated_flag = 0x01;
+
+// The stored size of a variable length integer.
+static size_t variable_size(uint64_t value)
+{
+    return value < 0xfd ? 1 : value <= max_uint16 ? 3 :
+        value <= max_uint32 ? 5 : 9;
+}
+
+// The record is walked once, recording the offset of each output and input.
+transaction_view::transaction_view(const const_element& element)
+  : memory_(element.state()), element_(element), linked_(false),
+    transaction_(0), size_(0), version_(0), locktime_(0)
+{
+    auto deserial = make_unsafe_deserializer(memory_->buffer());
+
+    size_t offset;
+    uint8_t flags;
+    const auto outputs = transaction_result::seek_output(deserial, 0, offset,
+        flags);
+    const auto compact = (flags & transaction_result::outputs_compact) != 0;
+    linked_ = (flags & transaction_result::inputs_linked) != 0;
+    transaction_ = offset - variable_size(outputs);
+    outputs_.reserve(outputs);
+
+    if (compact)
+    {
+        values_.reserve(outputs);
+        scripts_.reserve(outputs);
+    }
+
+    for (size_t output = 0; output < outputs; ++output)
+    {
+        outputs_.push_back(offset);
+
+        if (compact)
+        {
+            auto decoder = deserial;
+            offset += compact_codec::skip_output(deserial);
+            decoder.skip(candidate_spent_size + height_size);
+            values_.push_back(compact_codec::read_value(decoder));
+            scripts_.push_back(compact_codec::read_script(decoder));
+            continue;
+        }
+
+        deserial.skip(spend_size);
+        const auto script_size = deserial.read_size_little_endian();
+        deserial.skip(script_size);
+        offset += spend_size + variable_size(script_size) + script_size;
+    }
+
+    const auto inputs = deserial.read_size_little_endian();
+    offset += variable_size(inputs);
+    inputs_.reserve(inputs);
+
+    for (size_t input = 0; input < inputs; ++input)
+    {
+        inputs_.push_back(offset);
+        offset += transaction_result::skip_point(deserial, linked_);
+        const auto script_size = deserial.read_size_little_endian();
+        deserial.skip(script_size);
+        offset += variable_size(script_size) + script_size;
+
+        const auto witnesses = deserial.read_size_little_endian();
+        offset += variable_size(witnesses);
+
+        for (size_t witness = 0; witness < witnesses; ++witness)
+        {
+            const auto witness_size = deserial.read_size_little_endian();
+            deserial.skip(witness_size);
+            offset += variable_size(witness_size) + witness_size;
+        }
+
+        deserial.skip(sequence_size);
+        offset += sequence_size;
+    }
+
+    const auto locktime = deserial.read_variable_little_endian();
+    const auto version = deserial.read_variable_little_endian();
+    offset += variable_size(locktime) + variable_size(version);
+
+    locktime_ = static_cast<uint32_t>(locktime);
+    version_ = static_cast<uint32_t>(version);
+    size_ = offset - transaction_;
+}
+
+data_slice transaction_view::raw() const
+{
+    const auto begin = memory_->buffer() + transaction_;
+    return { begin, begin + size_ };
+}
+
+size_t transaction_view::record_size() const
+{
+    return transaction_ + size_;
+}
+
+uint32_t transaction_view::version() const
+{
+    return version_;
+}
+
+uint32_t transaction_view::locktime() const
+{
+    return locktime_;
+}
+
+size_t transaction_view::outputs() const
+{
+    return outputs_.size();
+}
+
+uint64_t transaction_view::value(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < outputs_.size());
+
+    if (!values_.empty())
+        return values_[index];
+
+    const auto offset = outputs_[index] + candidate_spent_size + height_size;
+    auto deserial = make_unsafe_deserializer(memory_->buffer() + offset);
+    return deserial.read_8_bytes_little_endian();
+}
+
+data_slice transaction_view::output_script(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < outputs_.size());
+
+    if (!scripts_.empty())
+        return scripts_[index];
+
+    return slice(outputs_[index] + spend_size);
+}
+
+size_t transaction_view::inputs() const
+{
+    return inputs_.size();
+}
+
+output_point transaction_view::previous_output(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < inputs_.size());
+    auto deserial = make_unsafe_deserializer(memory_->buffer() +
+        inputs_[index]);
+
+    output_point point;
+    const auto parent = transaction_result::read_point(deserial, point,
+        linked_);
+
+    if (parent == const_element::not_found)
+        return point;
+
+    return { element_.at(parent).key(), point.index() };
+}
+
+file_offset transaction_view::previous_link(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < inputs_.size());
+    auto deserial = make_unsafe_deserializer(memory_->buffer() +
+        inputs_[index]);
+
+    output_point point;
+    return transaction_result::read_point(deserial, point, linked_);
+}
+
+data_slice transaction_view::input_script(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < inputs_.size());
+    auto deserial = make_unsafe_deserializer(memory_->buffer() +
+        inputs_[index]);
+
+    const auto point_size = transaction_result::skip_point(deserial, linked_);
+    return slice(inputs_[index] + point_size);
+}
+
+uint32_t transaction_view::sequence(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < inputs_.size());
+
+    // The sequence follows the script and witness of the input.
+    auto deserial = make_unsafe_deserializer(memory_->buffer() +
+        input_end(index) - sequence_size);
+    return deserial.read_4_bytes_little_endian();
+}
+
+data_slice transaction_view::witness(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < inputs_.size());
+
+    // The witness follows the script of the input and precedes its sequence.
+    const auto script = input_script(index);
+    const auto begin = script.end();
+    const auto end = memory_->buffer() + input_end(index) - sequence_size;
+    return { begin, end };
+}
+
+bool transaction_view::segregated() const
+{
+    // An empty witness is its zero count.
+    for (uint32_t index = 0; index < inputs_.size(); ++index)
+        if (witness(index).size() > 1u)
+            return true;
+
+    return false;
+}
+
+// The stored transaction differs from wire in order (outputs first, version
+// and locktime last), output spend metadata and (if linked or compact) input
+// points and output encoding. Each field is written from its slice.
+void transaction_view::to_data(writer& sink, bool witness) const
+{
+    const auto segregated = witness && this->segregated();
+    sink.write_4_bytes_little_endian(version_);
+
+    if (segregated)
+    {
+        sink.write_byte(segregated_marker);
+        sink.write_byte(segregated_flag);
+    }
+
+    sink.write_variable_little_endian(inputs_.size());
+
+    for (uint32_t index = 0; index < inputs_.size(); ++index)
+    {
+        const auto script = input_script(index);
+        previous_output(index).to_data(sink, true);
+        sink.write_variable_little_endian(script.size());
+        sink.write_bytes(script.data(), script.size());
+        sink.write_4_bytes_little_endian(sequence(index));
+    }
+
+    sink.write_variable_little_endian(outputs_.size());
+
+    for (uint32_t index = 0; index < outputs_.size(); ++index)
+    {
+        const auto script = output_script(index);
+        sink.write_8_bytes_little_endian(value(index));
+        sink.write_variable_little_endian(script.size());
+        sink.write_bytes(script.data(), script.size());
+    }
+
+    if (segregated)
+    {
+        for (uint32_t index = 0; index < inputs_.size(); ++index)
+        {
+            const auto data = this->witness(index);
+            sink.write_bytes(data.data(), data.size());
+        }
+    }
+
+    sink.write_4_bytes_little_endian(locktime_);
+}
+
+// private
+// The record offset of the end of the input (that of its sequence).
+size_t transaction_view::input_end(uint32_t index) const
+{
+    return index + 1u < inputs_.size() ? inputs_[index + 1u] :
+        transaction_ + size_ - variable_size(locktime_) -
+            variable_size(version_);
+}
+
+// private
+// The slice of a size-prefixed field at the record offset.
+data_slice transaction_view::slice(size_t offset) const
+{
+    auto deserial = make_unsafe_deserializer(memory_->buffer() + offset);
+    const auto size = deserial.read_size_little_endian();
+    const auto begin = memory_->buffer() + offset + variable_size(size);
+    return { begin, begin + size };
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/sequence_lock.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// The sequence is odd while a write is in progress. The fences order the
+// sequence against the unsynchronized value accesses of writer and reader.
+
+sequence_lock::scope::scope(sequence_lock& lock)
+  : lock_(lock)
+{
+    lock_.lock();
+}
+
+sequence_lock::scope::~scope()
+{
+    lock_.unlock();
+}
+
+sequence_lock::sequence_lock()
+  : sequence_(0),
+    wait_ns_(0)
+{
+}
+
+void sequence_lock::lock()
+{
+    // The wait is only timed when the lock is contended.
+    if (!mutex_.try_lock())
+    {
+        const auto start = std::chrono::steady_clock::now();
+        mutex_.lock();
+        const auto wait = std::chrono::steady_clock::now() - start;
+        wait_ns_.fetch_add(std::chrono::duration_cast<
+            std::chrono::nanoseconds>(wait).count(),
+            std::memory_order_relaxed);
+    }
+
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void sequence_lock::unlock()
+{
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_release);
+    mutex_.unlock();
+}
+
+uint64_t sequence_lock::wait_ns() const
+{
+    return wait_ns_.load(std::memory_order_relaxed);
+}
+
+} // namespace database
+} // namespace libbitcoin
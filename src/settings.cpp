@@ -27,14 +27,53 @@ using namespace boost::filesystem;
 
 settings::settings()
   : index_addresses(true),
+    index_deferred(false),
+    index_filters(false),
+    index_spends(false),
     flush_writes(false),
+    flush_interval_ms(0),
+    journal_writes(false),
+    read_only(false),
     file_growth_rate(5),
+    file_growth_policy(),
+    file_reservation_mb(0),
+    table_load_percent(0),
+    store_threads(0),
 
     // Hash table sizes (must be configured).
     block_table_buckets(0),
+    block_table_storage(storage_backend::file),
+    block_table_advice(),
+    block_index_advice(),
+    header_cache_capacity(0),
     transaction_table_buckets(0),
+    transaction_table_storage(storage_backend::file),
+    transaction_table_advice(),
+    transaction_compaction(false),
+    transaction_linked_inputs(false),
+    transaction_split_state(false),
+    transaction_checksums(false),
+    transaction_verify_rate(0),
+    transaction_warm_segments(0),
+    transaction_filter_mb(0),
+    transaction_filter_error_ppm(1000),
+    transaction_prune_depth(0),
+    transaction_pool_mb(0),
+    transaction_commit_window_ms(0),
     address_table_buckets(0),
-    cache_capacity(0)
+    address_table_storage(storage_backend::file),
+    address_table_advice(),
+    address_balance_buckets(0),
+    address_filter_range(0),
+    filter_table_buckets(0),
+    filter_table_storage(storage_backend::file),
+    filter_table_advice(),
+    spend_table_buckets(0),
+    spend_table_storage(storage_backend::file),
+    spend_table_advice(),
+    cache_capacity(0),
+    cache_budget_mb(0),
+    cache_eviction(eviction_policy::fifo)
 {
 }
 
@@ -49,6 +88,8 @@ settings::settings(config::settings context)
             block_table_buckets = 650000;
             transaction_table_buckets = 110000000;
             address_table_buckets = 107000000;
+            filter_table_buckets = 650000;
+            spend_table_buckets = 107000000;
             break;
         }
 
@@ -59,6 +100,8 @@ settings::settings(config::settings context)
             block_table_buckets = 650000;
             transaction_table_buckets = 110000000;
             address_table_buckets = 107000000;
+            filter_table_buckets = 650000;
+            spend_table_buckets = 107000000;
             break;
         }
 
@@ -69,6 +112,8 @@ settings::settings(config::settings context)
             block_table_buckets = 650000;
             transaction_table_buckets = 110000000;
             address_table_buckets = 107000000;
+            filter_table_buckets = 650000;
+            spend_table_buckets = 107000000;
             break;
         }
 
@@ -78,6 +123,8 @@ settings::settings(config::settings context)
             block_table_buckets = 650000;
             transaction_table_buckets = 110000000;
             address_table_buckets = 107000000;
+            filter_table_buckets = 650000;
+            spend_table_buckets = 107000000;
             break;
         }
             
@@ -88,6 +135,8 @@ settings::settings(config::settings context)
             block_table_buckets = 650000;
             transaction_table_buckets = 110000000;
             address_table_buckets = 107000000;
+            filter_table_buckets = 650000;
+            spend_table_buckets = 107000000;
             break;
         }
             
@@ -98,6 +147,8 @@ settings::settings(config::settings context)
             block_table_buckets = 650000;
             transaction_table_buckets = 110000000;
             address_table_buckets = 107000000;
+            filter_table_buckets = 650000;
+            spend_table_buckets = 107000000;
             break;
         }
 
@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/state_table.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/memory/memory.hpp>
+
+// Transaction record format:
+// ----------------------------------------------------------------------------
+// [ height/forks/code:4 - atomic1 ]
+// [ position:2          - atomic1 ]
+// [ candidate:1         - atomic1 ]
+// [ median_time_past:4  - atomic1 ]
+
+// Output record format:
+// ----------------------------------------------------------------------------
+// [ candidate_spent:1   - atomic2 ]
+// [ spender_height:4    - atomic2 ]
+
+namespace libbitcoin {
+namespace database {
+
+const size_t state_table::transaction_size = sizeof(uint32_t) +
+    sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint32_t);
+
+const size_t state_table::output_size = sizeof(uint8_t) + sizeof(uint32_t);
+
+// Records are fixed width and allocated in order of store, O(1).
+state_table::state_table(const path& transactions_filename,
+    const path& outputs_filename, size_t expansion, size_t reservation,
+    storage_backend backend)
+  : transactions_file_(storage::factory(backend, transactions_filename,
+        expansion, reservation)),
+    transactions_(*transactions_file_, 0, transaction_size),
+    outputs_file_(storage::factory(backend, outputs_filename,
+        expansion, reservation)),
+    outputs_(*outputs_file_, 0, output_size)
+{
+}
+
+state_table::~state_table()
+{
+    close();
+}
+
+// Startup and shutdown.
+// ----------------------------------------------------------------------------
+
+bool state_table::create()
+{
+    if (!transactions_file_->open() || !outputs_file_->open())
+        return false;
+
+    // No need to call open after create.
+    return transactions_.create() && outputs_.create();
+}
+
+bool state_table::open()
+{
+    return
+        transactions_file_->open() &&
+        outputs_file_->open() &&
+        transactions_.start() &&
+        outputs_.start();
+}
+
+bool state_table::refresh()
+{
+    return
+        transactions_file_->refresh() &&
+        outputs_file_->refresh() &&
+        transactions_.start() &&
+        outputs_.start();
+}
+
+void state_table::commit()
+{
+    transactions_.commit();
+    outputs_.commit();
+}
+
+bool state_table::flush() const
+{
+    return transactions_file_->flush() && outputs_file_->flush();
+}
+
+bool state_table::flush_dirty() const
+{
+    return transactions_file_->flush_dirty() && outputs_file_->flush_dirty();
+}
+
+void state_table::enable_advice(const map_advice& advice)
+{
+    transactions_file_->enable_advice(advice, 0);
+    outputs_file_->enable_advice(advice, 0);
+}
+
+void state_table::enable_file_growth(const file_growth& growth)
+{
+    transactions_file_->enable_growth(growth);
+    outputs_file_->enable_growth(growth);
+}
+
+void state_table::pregrow()
+{
+    transactions_file_->pregrow();
+    outputs_file_->pregrow();
+}
+
+void state_table::enable_journal()
+{
+    transactions_file_->enable_journal();
+    outputs_file_->enable_journal();
+}
+
+bool state_table::log_writes(commit_log& log)
+{
+    return transactions_file_->log_writes(log) && outputs_file_->log_writes(log);
+}
+
+void state_table::footprint(table_metrics::values& values) const
+{
+    storage::footprint(values, *transactions_file_);
+    storage::footprint(values, *outputs_file_);
+}
+
+bool state_table::close()
+{
+    return transactions_file_->close() && outputs_file_->close();
+}
+
+// Records.
+// ----------------------------------------------------------------------------
+
+state_table::link_type state_table::allocate_transactions(size_t count)
+{
+    return transactions_.allocate(count);
+}
+
+state_table::link_type state_table::allocate_outputs(size_t count)
+{
+    return outputs_.allocate(count);
+}
+
+memory_ptr state_table::transaction(link_type ordinal) const
+{
+    return transactions_.get(ordinal);
+}
+
+memory_ptr state_table::output(link_type ordinal) const
+{
+    return outputs_.get(ordinal);
+}
+
+void state_table::journal_transaction(link_type ordinal, size_t offset,
+    size_t size) const
+{
+    transactions_.journal(ordinal, offset, size);
+}
+
+void state_table::journal_output(link_type ordinal, size_t offset,
+    size_t size) const
+{
+    outputs_.journal(ordinal, offset, size);
+}
+
+} // namespace database
+} // namespace libbitcoin
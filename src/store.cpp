@@ -18,10 +18,20 @@
  */
 #include <bitcoin/database/store.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database/commit_log.hpp>
+#include <bitcoin/database/manifest.hpp>
+#include <bitcoin/database/memory/file_storage.hpp>
+#include <bitcoin/database/memory/segmented_storage.hpp>
+#include <bitcoin/database/memory/storage.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -34,13 +44,56 @@ using namespace boost::system;
 // Database file names.
 const std::string store::FLUSH_LOCK = "flush_lock";
 const std::string store::EXCLUSIVE_LOCK = "exclusive_lock";
+const std::string store::COMMIT_LOG = "commit_log";
+const std::string store::COMMIT_COUNTER = "commit_counter";
+const std::string store::CLEAN_MANIFEST = "clean_manifest";
+
 const std::string store::BLOCK_TABLE = "block_table";
 const std::string store::CANDIDATE_INDEX = "candidate_index";
 const std::string store::CONFIRMED_INDEX = "confirmed_index";
 const std::string store::TRANSACTION_INDEX = "transaction_index";
 const std::string store::TRANSACTION_TABLE = "transaction_table";
+const std::string store::TRANSACTION_FILTER = "transaction_filter";
+const std::string store::TRANSACTION_STATE = "transaction_state";
+const std::string store::OUTPUT_STATE = "output_state";
+const std::string store::OUTPUT_CACHE = "output_cache";
 const std::string store::ADDRESS_TABLE = "address_table";
 const std::string store::ADDRESS_ROWS = "address_rows";
+const std::string store::ADDRESS_HEIGHT = "address_height";
+const std::string store::ADDRESS_BALANCES = "address_balances";
+const std::string store::ADDRESS_FILTERS = "address_filters";
+const std::string store::FILTER_TABLE = "filter_table";
+const std::string store::SPEND_TABLE = "spend_table";
+
+// The commit log is checkpointed (tables flushed) when it exceeds this size.
+static constexpr size_t checkpoint_size = 256 * 1024 * 1024;
+
+// The directory of a group of tables, the prefix if not overridden.
+static path place(const path& prefix, const path& directory)
+{
+    return directory.empty() ? prefix : directory;
+}
+
+// The distinct table directories other than the prefix.
+static std::vector<path> distinct(const path& prefix,
+    const table_directories& directories)
+{
+    const std::vector<path> all
+    {
+        directories.blocks, directories.indexes, directories.transactions,
+        directories.state, directories.addresses, directories.filters,
+        directories.spends
+    };
+
+    std::vector<path> out;
+
+    for (const auto& directory: all)
+        if (!directory.empty() && directory != prefix &&
+            std::find(out.begin(), out.end(), directory) == out.end())
+            out.push_back(directory);
+
+    return out;
+}
 
 // Create a single file with one byte of arbitrary data.
 static bool create_file(const path& file_path)
@@ -62,24 +115,50 @@ static bool create_file(const path& file_path)
 // Construct.
 // ------------------------------------------------------------------------
 
-store::store(const path& prefix, bool with_indexes, bool flush_each_write)
+store::store(const path& prefix, bool with_indexes, bool flush_each_write,
+    bool journal_writes, bool with_filters, bool with_split_state,
+    bool read_only, bool with_spends, const table_directories& directories)
   : prefix_(prefix),
     with_indexes_(with_indexes),
+    with_filters_(with_filters),
+    with_spends_(with_spends),
+    with_split_state_(with_split_state),
     flush_each_write_(flush_each_write),
+    journal_writes_(journal_writes),
+    read_only_(read_only),
+    journal_(prefix / COMMIT_LOG),
+    counter_(prefix / COMMIT_COUNTER),
     flush_lock_(prefix / FLUSH_LOCK),
     exclusive_lock_(prefix / EXCLUSIVE_LOCK),
+    clean_manifest(prefix / CLEAN_MANIFEST),
 
     // Content store.
-    block_table(prefix / BLOCK_TABLE),
-    candidate_index(prefix / CANDIDATE_INDEX),
-    confirmed_index(prefix / CONFIRMED_INDEX),
-    transaction_index(prefix / TRANSACTION_INDEX),
-    transaction_table(prefix / TRANSACTION_TABLE),
+    block_table(place(prefix, directories.blocks) / BLOCK_TABLE),
+    candidate_index(place(prefix, directories.indexes) / CANDIDATE_INDEX),
+    confirmed_index(place(prefix, directories.indexes) / CONFIRMED_INDEX),
+    transaction_index(place(prefix, directories.blocks) / TRANSACTION_INDEX),
+    transaction_table(place(prefix, directories.transactions) /
+        TRANSACTION_TABLE),
+    transaction_filter(place(prefix, directories.state) /
+        TRANSACTION_FILTER),
+    output_cache(place(prefix, directories.state) / OUTPUT_CACHE),
 
     // Optional indexes.
-    address_table(prefix / ADDRESS_TABLE),
-    address_rows(prefix / ADDRESS_ROWS)
+    address_table(place(prefix, directories.addresses) / ADDRESS_TABLE),
+    address_rows(place(prefix, directories.addresses) / ADDRESS_ROWS),
+    address_height(place(prefix, directories.addresses) / ADDRESS_HEIGHT),
+    address_balances(place(prefix, directories.addresses) /
+        ADDRESS_BALANCES),
+    address_filters(place(prefix, directories.addresses) / ADDRESS_FILTERS),
+    filter_table(place(prefix, directories.filters) / FILTER_TABLE),
+    spend_table(place(prefix, directories.spends) / SPEND_TABLE),
+    transaction_state(place(prefix, directories.state) / TRANSACTION_STATE),
+    output_state(place(prefix, directories.state) / OUTPUT_STATE),
+    directories_(distinct(prefix, directories))
 {
+    for (const auto& directory: directories_)
+        directory_locks_.push_back(std::make_shared<interprocess_lock>(
+            directory / EXCLUSIVE_LOCK));
 }
 
 // Open and close.
@@ -88,15 +167,26 @@ store::store(const path& prefix, bool with_indexes, bool flush_each_write)
 // Create files.
 bool store::create()
 {
+    if (read_only_)
+        return false;
+
     error_code ec;
     create_directories(prefix_, ec);
 
+    for (const auto& directory: directories_)
+        if (!ec)
+            create_directories(directory, ec);
+
     const auto created = !ec &&
         create_file(block_table) &&
         create_file(candidate_index) &&
         create_file(confirmed_index) &&
         create_file(transaction_index) &&
-        create_file(transaction_table);
+        create_file(transaction_table) &&
+        (!with_filters_ || create_file(filter_table)) &&
+        (!with_spends_ || create_file(spend_table)) &&
+        (!with_split_state_ || (create_file(transaction_state) &&
+            create_file(output_state)));
 
     if (!with_indexes_)
         return created;
@@ -104,23 +194,93 @@ bool store::create()
     return
         created &&
         create_file(address_table) &&
-        create_file(address_rows);
+        create_file(address_rows) &&
+        create_file(address_height) &&
+        create_file(address_balances) &&
+        create_file(address_filters);
 }
 
+// A journaled store holds the flush lock until close, and if it is found on
+// open the tables are recovered from the commit log. A read-only secondary
+// takes no lock, it requires only the commit counter of the writer.
 bool store::open()
 {
-    return exclusive_lock_.lock() && flush_lock_.try_lock() &&
-        (flush_each_write() || flush_lock_.lock_shared());
+    if (read_only_)
+        return counter_.open(false);
+
+    // Stores created without the address height, balances or filters file
+    // are given them (balances and filters then cover only payments indexed
+    // from this open).
+    error_code ec;
+    if (with_indexes_ &&
+        ((!exists(address_height, ec) && !create_file(address_height)) ||
+        (!exists(address_balances, ec) && !create_file(address_balances)) ||
+        (!exists(address_filters, ec) && !create_file(address_filters))))
+        return false;
+
+    if (journal_writes())
+        return exclusive_lock_.lock() && lock_directories() &&
+            (flush_lock_.try_lock() || recover()) &&
+            flush_lock_.lock_shared() && journal_.open() &&
+            counter_.open(true);
+
+    return exclusive_lock_.lock() && lock_directories() &&
+        flush_lock_.try_lock() &&
+        (flush_each_write() || flush_lock_.lock_shared()) &&
+        counter_.open(true);
 }
 
+// The tables must be closed (flushed) before the commit log is reset.
 bool store::close()
 {
+    if (read_only_)
+        return counter_.close();
+
+    if (journal_writes())
+        return journal_.reset() && journal_.close() && counter_.close() &&
+            flush_lock_.unlock_shared() && unlock_directories() &&
+            exclusive_lock_.unlock();
+
     return (flush_each_write() || flush_lock_.unlock_shared()) &&
-        exclusive_lock_.unlock();
+        counter_.close() && unlock_directories() && exclusive_lock_.unlock();
+}
+
+// A secondary never writes, and a journaled store replays its commit log.
+bool store::begin_repair()
+{
+    if (read_only_ || journal_writes())
+        return false;
+
+    return exclusive_lock_.lock() && lock_directories();
+}
+
+// The flush lock of the unclean shutdown is taken and released (deleted).
+bool store::end_repair(bool repaired)
+{
+    return (!repaired ||
+        (flush_lock_.lock_shared() && flush_lock_.unlock_shared())) &&
+        unlock_directories() && exclusive_lock_.unlock();
+}
+
+bool store::read_only() const
+{
+    return read_only_;
 }
 
+bool store::published(commit_counter::state& out) const
+{
+    return counter_.read(out);
+}
+
+// A secondary never writes.
 bool store::begin_write() const
 {
+    if (read_only_)
+        return false;
+
+    if (journal_writes())
+        return true;
+
     if (flush_each_write())
     {
         return flush_lock_.lock_shared();
@@ -130,6 +290,9 @@ bool store::begin_write() const
 
 bool store::end_write() const
 {
+    if (journal_writes())
+        return commit_journal() && publish();
+
     if (flush_each_write())
     {
         if (flush())
@@ -149,7 +312,7 @@ bool store::end_write() const
             return false;
         }
     }
-    return true;
+    return publish();
 }
 
 bool store::flush_each_write() const
@@ -157,5 +320,184 @@ bool store::flush_each_write() const
     return flush_each_write_;
 }
 
+bool store::journal_writes() const
+{
+    return journal_writes_;
+}
+
+// protected
+// The tables are published after they are committed, so that a secondary
+// never reads above what has been written. An empty store is not published.
+bool store::publish() const
+{
+    size_t candidate;
+    size_t confirmed;
+    return !tops(candidate, confirmed) ||
+        counter_.publish(candidate, confirmed);
+}
+
+// protected
+void store::set_sizes(manifest& clean) const
+{
+    for (const auto& table: tables())
+        clean.set_size(table);
+}
+
+// protected
+bool store::matches_sizes(const manifest& clean) const
+{
+    for (const auto& table: tables())
+        if (!clean.matches_size(table))
+            return false;
+
+    return true;
+}
+
+// private
+// The table files of the configuration.
+std::vector<path> store::tables() const
+{
+    std::vector<path> files
+    {
+        block_table, candidate_index, confirmed_index, transaction_index,
+        transaction_table
+    };
+
+    if (with_filters_)
+        files.push_back(filter_table);
+
+    if (with_spends_)
+        files.push_back(spend_table);
+
+    if (with_split_state_)
+    {
+        files.push_back(transaction_state);
+        files.push_back(output_state);
+    }
+
+    if (with_indexes_)
+    {
+        files.push_back(address_table);
+        files.push_back(address_rows);
+        files.push_back(address_height);
+        files.push_back(address_balances);
+        files.push_back(address_filters);
+    }
+
+    return files;
+}
+
+// private
+// The path of the table file named in the commit log, in its directory.
+path store::locate(const std::string& table) const
+{
+    for (const auto& file: tables())
+        if (file.filename().string() == table)
+            return file;
+
+    return prefix_ / table;
+}
+
+// private
+// A table directory is held by one store, as is the store directory.
+bool store::lock_directories() const
+{
+    for (const auto& lock: directory_locks_)
+        if (!lock->lock())
+            return false;
+
+    return true;
+}
+
+// private
+bool store::unlock_directories() const
+{
+    auto result = true;
+
+    for (const auto& lock: directory_locks_)
+        result = lock->unlock() && result;
+
+    return result;
+}
+
+// private
+// Commit the write to the log with one sync. If the log (or the write) is
+// large, flush all tables instead and empty the log (checkpoint).
+bool store::commit_journal() const
+{
+    if (!journal(journal_))
+        return false;
+
+    if (journal_.pending() > checkpoint_size)
+    {
+        journal_.discard();
+        return flush() && journal_.reset();
+    }
+
+    if (!journal_.commit())
+        return false;
+
+    return journal_.size() <= checkpoint_size ||
+        (flush() && journal_.reset());
+}
+
+// private
+// Apply the committed writes of the log to the (closed) tables, flush them
+// and remove the flush lock. The log is reset once the tables are opened.
+bool store::recover()
+{
+    LOG_INFO(LOG_DATABASE)
+        << "Recovering store from commit log.";
+
+    std::map<std::string, storage::ptr> tables;
+    std::map<std::string, size_t> sizes;
+
+    const auto apply = [&](const std::string& table, file_offset offset,
+        const data_chunk& data)
+    {
+        auto& file = tables[table];
+
+        if (!file)
+        {
+            const auto table_path = locate(table);
+
+            if (!exists(table_path))
+                return false;
+
+            // A table grown beyond one segment is recovered as segmented.
+            const auto segment = segmented_storage::segment_size(table_path);
+
+            if (segment == 0)
+                file = std::make_shared<file_storage>(table_path);
+            else
+                file = std::make_shared<segmented_storage>(table_path,
+                    segment);
+
+            if (!file->open())
+                return false;
+
+            sizes[table] = file->size();
+        }
+
+        // Writes beyond the flushed size of the table extend the table.
+        auto& size = sizes[table];
+        size = std::max(size, static_cast<size_t>(offset + data.size()));
+        const auto memory = file->reserve(size);
+        std::memcpy(memory->buffer() + offset, data.data(), data.size());
+        return true;
+    };
+
+    if (!journal_.replay(apply))
+        return false;
+
+    for (const auto& table: tables)
+        if (!table.second->close())
+            return false;
+
+    error_code ec;
+    remove(prefix_ / FLUSH_LOCK, ec);
+    return !ec;
+}
+
 } // namespace database
 } // namespace libbitcoin
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/table_metrics.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+static constexpr auto relaxed = std::memory_order_relaxed;
+
+uint64_t table_metrics::values::misses() const
+{
+    return lookups - hits;
+}
+
+double table_metrics::values::average_chain() const
+{
+    return lookups == 0 ? 0.0 : static_cast<double>(links_walked) / lookups;
+}
+
+table_metrics::table_metrics()
+  : lookups_(0),
+    hits_(0),
+    links_walked_(0),
+    allocations_(0),
+    allocated_bytes_(0),
+    remaps_(0),
+    remap_wait_ns_(0)
+{
+}
+
+void table_metrics::lookup(bool hit, size_t walked)
+{
+    lookups_.fetch_add(1, relaxed);
+    links_walked_.fetch_add(walked, relaxed);
+
+    if (hit)
+        hits_.fetch_add(1, relaxed);
+}
+
+void table_metrics::allocate(size_t bytes)
+{
+    allocations_.fetch_add(1, relaxed);
+    allocated_bytes_.fetch_add(bytes, relaxed);
+}
+
+void table_metrics::remap(clock::duration wait)
+{
+    const auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+
+    remaps_.fetch_add(1, relaxed);
+    remap_wait_ns_.fetch_add(static_cast<uint64_t>(nanoseconds), relaxed);
+}
+
+table_metrics::values table_metrics::get() const
+{
+    return
+    {
+        lookups_.load(relaxed),
+        hits_.load(relaxed),
+        links_walked_.load(relaxed),
+        allocations_.load(relaxed),
+        allocated_bytes_.load(relaxed),
+        remaps_.load(relaxed),
+        remap_wait_ns_.load(relaxed),
+        0, 0, 0, 0, 0
+    };
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/trace.hpp>
+
+#include <atomic>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+std::atomic<bool> trace::enabled_(false);
+std::atomic<bool> trace::handled_(false);
+trace::handler trace::handler_;
+
+trace::span::span(const char* name)
+  : name_(name),
+    active_(handled_.load(std::memory_order_relaxed))
+{
+    if (active_)
+        handler_(name_, true);
+}
+
+trace::span::~span()
+{
+    if (active_)
+        handler_(name_, false);
+}
+
+void trace::enable(bool enabled)
+{
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool trace::enabled()
+{
+    return enabled_.load(std::memory_order_relaxed);
+}
+
+void trace::set_handler(handler span_handler)
+{
+    handled_.store(false, std::memory_order_relaxed);
+    handler_ = std::move(span_handler);
+    handled_.store(static_cast<bool>(handler_), std::memory_order_relaxed);
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/transaction_pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+using namespace bc::chain;
+
+// The approximate cost of the map node, age node and shared control block.
+static constexpr size_t entry_overhead = 128;
+
+transaction_pool::transaction_pool(size_t budget)
+  : budget_(budget), bytes_(0)
+{
+}
+
+bool transaction_pool::disabled() const
+{
+    return budget_ == 0;
+}
+
+size_t transaction_pool::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return transactions_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t transaction_pool::bytes() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return bytes_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A tx larger than the budget is not pooled (reported as added).
+bool transaction_pool::add(const transaction& tx, uint32_t forks)
+{
+    if (disabled())
+        return false;
+
+    const auto hash = tx.hash();
+    const auto size = cost(tx);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (transactions_.find(hash) != transactions_.end())
+        return false;
+
+    if (size > budget_)
+        return true;
+
+    while (bytes_ + size > budget_)
+        erase(transactions_.find(ages_.front()));
+
+    ages_.push_back(hash);
+    transactions_.emplace(hash, pooled_transaction
+    {
+        std::make_shared<const transaction>(tx), forks, size,
+        std::prev(ages_.end())
+    });
+
+    bytes_ += size;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_pool::remove(const hash_digest& hash)
+{
+    if (disabled())
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    const auto it = transactions_.find(hash);
+
+    if (it != transactions_.end())
+        erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+transaction_pool::transaction_ptr transaction_pool::get(
+    const hash_digest& hash, uint32_t& out_forks) const
+{
+    if (disabled())
+        return nullptr;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    const auto it = transactions_.find(hash);
+
+    if (it == transactions_.end())
+        return nullptr;
+
+    out_forks = it->second.forks;
+    return it->second.tx;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_pool::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    transactions_.clear();
+    ages_.clear();
+    bytes_ = 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+size_t transaction_pool::cost(const transaction& tx)
+{
+    return tx.serialized_size(true) + entry_overhead;
+}
+
+// private
+// Called under the unique lock.
+void transaction_pool::erase(transaction_map::iterator it)
+{
+    bytes_ -= it->second.cost;
+    ages_.erase(it->second.age);
+    transactions_.erase(it);
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -18,44 +18,220 @@
  */
 #include <bitcoin/database/unspent_outputs.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
 #include <bitcoin/bitcoin.hpp>
 
+// File format:
+// ----------------------------------------------------------------------------
+// [ top_height:8 ]
+// [ count:8      ]
+// [
+//   [ hash:32             ]
+//   [ index:4             ]
+//   [ value:8             ]
+//   [ height:4            ]
+//   [ median_time_past:4  ]
+//   [ flags:1             ] (coinbase(1) | confirmed(2))
+//   [ script_size:4       ]
+//   [ script:script_size  ]
+// ]...
+
 namespace libbitcoin {
 namespace database {
 
 using namespace bc::chain;
 
+// Smaller budgets are not divided, so that entries are not starved.
+static constexpr size_t minimum_shard_budget = 64 * 1024;
+
+// The approximate allocation overhead of a map node and age list node.
+static constexpr size_t node_overhead = 64;
+
+static constexpr size_t file_header_size = 2 * sizeof(uint64_t);
+static constexpr size_t file_entry_size = std::tuple_size<hash_digest>::value +
+    sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t) +
+    sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t);
+static constexpr uint32_t maximum_script_size = 4000000;
+static constexpr uint8_t coinbase_flag = 1;
+static constexpr uint8_t confirmed_flag = 2;
+
+// The number of eviction passes that hits can buy an entry (clock).
+static constexpr uint8_t maximum_references = 3;
+
+unspent_outputs::unspent_output::unspent_output(uint64_t value,
+    data_chunk&& script, uint32_t height, uint32_t median_time_past,
+    bool coinbase, bool confirmed)
+  : value(value),
+    script(std::move(script)),
+    height(height),
+    median_time_past(median_time_past),
+    coinbase(coinbase),
+    confirmed(confirmed),
+    references(0)
+{
+}
+
+unspent_outputs::unspent_output::unspent_output(unspent_output&& other)
+  : value(other.value),
+    script(std::move(other.script)),
+    height(other.height),
+    median_time_past(other.median_time_past),
+    coinbase(other.coinbase),
+    confirmed(other.confirmed),
+    age(other.age),
+    references(other.references.load())
+{
+}
+
 // This does not differentiate indexed-block transactions. These are treated as
 // unconfirmed, so this optimizes only for a top height fork point and tx pool.
-unspent_outputs::unspent_outputs(size_t capacity)
-  : capacity_(capacity), hits_(1), queries_(1), sequence_(0)
+unspent_outputs::unspent_outputs(size_t budget, size_t shards,
+    eviction_policy policy)
+  : budget_(budget), policy_(policy), hits_(1), queries_(1),
+    shards_(std::max(std::min(shards, budget / minimum_shard_budget),
+        size_t(1)))
+{
+    const auto count = shards_.size();
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        auto& shard = shards_[index];
+        shard.budget = budget / count + (index < budget % count ? 1 : 0);
+        shard.bytes = 0;
+    }
+}
+
+// private
+// Tx hashes are uniform, so the leading bytes select the shard.
+unspent_outputs::shard& unspent_outputs::partition(const hash_digest& tx_hash)
+{
+    const auto value = from_little_endian_unsafe<uint64_t>(tx_hash.begin());
+    return shards_[value % shards_.size()];
+}
+
+// private
+const unspent_outputs::shard& unspent_outputs::partition(
+    const hash_digest& tx_hash) const
+{
+    const auto value = from_little_endian_unsafe<uint64_t>(tx_hash.begin());
+    return shards_[value % shards_.size()];
+}
+
+// private
+size_t unspent_outputs::cost(const unspent_output& output)
+{
+    return sizeof(point) + sizeof(unspent_output) + output.script.size() +
+        node_overhead;
+}
+
+// private
+// The shard must be exclusively locked by the caller.
+void unspent_outputs::erase(shard& shard, output_map::iterator output)
+{
+    shard.bytes -= cost(output->second);
+    shard.ages.erase(output->second.age);
+    shard.outputs.erase(output);
+}
+
+// private
+// The shard must be exclusively locked by the caller and must not be empty.
+// Under clock an entry with references is passed over (to the back of the
+// age list) once for each reference, so one-shot entries are evicted first.
+void unspent_outputs::evict(shard& shard) const
 {
+    while (true)
+    {
+        const auto output = shard.outputs.find(shard.ages.front());
+        auto& references = output->second.references;
+
+        if (policy_ == eviction_policy::clock && references > 0)
+        {
+            --references;
+            shard.ages.splice(shard.ages.end(), shard.ages,
+                shard.ages.begin());
+            continue;
+        }
+
+        erase(shard, output);
+        return;
+    }
+}
+
+// private
+// The shard must be exclusively locked by the caller.
+void unspent_outputs::insert(shard& shard, const point& key,
+    unspent_output&& value) const
+{
+    const auto size = cost(value);
+
+    if (size > shard.budget)
+        return;
+
+    const auto existing = shard.outputs.find(key);
+    if (existing != shard.outputs.end())
+        erase(shard, existing);
+
+    // Evict entries until the new entry fits the budget.
+    while (shard.bytes + size > shard.budget)
+        evict(shard);
+
+    value.age = shard.ages.insert(shard.ages.end(), key);
+    shard.outputs.emplace(key, std::move(value));
+    shard.bytes += size;
 }
 
 bool unspent_outputs::disabled() const
 {
-    return capacity_ == 0;
+    return budget_ == 0;
 }
 
 size_t unspent_outputs::empty() const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
-
-    return unspent_.empty();
-    ///////////////////////////////////////////////////////////////////////////
+    return size() == 0;
 }
 
+// The shards are not locked together, so this is a moving total.
 size_t unspent_outputs::size() const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
+    size_t total = 0;
 
-    return unspent_.size();
-    ///////////////////////////////////////////////////////////////////////////
+    for (const auto& shard: shards_)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        shared_lock lock(shard.mutex);
+
+        total += shard.outputs.size();
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    return total;
+}
+
+// The shards are not locked together, so this is a moving total.
+size_t unspent_outputs::bytes() const
+{
+    size_t total = 0;
+
+    for (const auto& shard: shards_)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        shared_lock lock(shard.mutex);
+
+        total += shard.bytes;
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    return total;
+}
+
+eviction_policy unspent_outputs::policy() const
+{
+    return policy_;
 }
 
 float unspent_outputs::hit_rate() const
@@ -73,59 +249,59 @@ void unspent_outputs::add(const transaction& tx, size_t height,
     if (tx.is_coinbase())
     {
         LOG_DEBUG(LOG_DATABASE)
-            << "Output cache hit rate: " << hit_rate() << ", size: " << size();
+            << "Output cache hit rate ("
+            << (policy_ == eviction_policy::clock ? "clock" : "fifo")
+            << "): " << hit_rate() << ", size: " << size()
+            << ", bytes: " << bytes();
     }
 
+    const auto hash = tx.hash();
+    const auto coinbase = tx.is_coinbase();
+    const auto& outputs = tx.outputs();
+    auto& shard = partition(hash);
+
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(mutex_);
+    unique_lock lock(shard.mutex);
 
-    // It's been a long time since the last restart (~16 years).
-    if (sequence_ == max_uint32)
-        unspent_.clear();
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+    {
+        const auto& output = outputs[index];
 
-    // Remove the oldest entry if the buffer is at capacity.
-    if (unspent_.size() >= capacity_)
-        unspent_.right.erase(unspent_.right.begin());
+        // Spent outputs are never cached.
+        if (output.metadata.spender_height != output::validation::unspent)
+            continue;
 
-    // TODO: promote the unconfirmed tx cache instead of replacing it.
-    // A confirmed tx may replace the same unconfirmed tx here.
-    unspent_.insert(
-    {
-        unspent_transaction{ tx, height, median_time_past, confirmed },
-        ++sequence_
-    });
+        // TODO: promote the unconfirmed tx cache instead of replacing it.
+        // A confirmed tx may replace the same unconfirmed tx here.
+        insert(shard, { hash, index }, { output.value(),
+            output.script().to_data(false), static_cast<uint32_t>(height),
+            median_time_past, coinbase, confirmed });
+    }
     ///////////////////////////////////////////////////////////////////////////
 }
 
 // This is confirmation-independent, since the conflict is extrememly rare and
 // the difference is simply an optimization. This avoids dual key indexing.
+// Reorganization is rare, so the age list of the shard is scanned for the tx.
 void unspent_outputs::remove(const hash_digest& tx_hash)
 {
     if (disabled())
         return;
 
-    const unspent_transaction key{ tx_hash };
+    auto& shard = partition(tx_hash);
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock_upgrade();
+    unique_lock lock(shard.mutex);
 
-    // Find the unspent tx entry.
-    const auto tx = unspent_.left.find(key);
-
-    if (tx == unspent_.left.end())
+    for (auto age = shard.ages.begin(); age != shard.ages.end();)
     {
-        mutex_.unlock_upgrade();
-        //---------------------------------------------------------------------
-        return;
-    }
+        const auto current = age++;
 
-    mutex_.unlock_upgrade_and_lock();
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    unspent_.left.erase(tx);
-
-    mutex_.unlock();
+        if (current->hash() == tx_hash)
+            erase(shard, shard.outputs.find(*current));
+    }
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -135,34 +311,28 @@ void unspent_outputs::remove(const output_point& point)
     if (disabled())
         return;
 
-     unspent_transaction key{ point };
+    const chain::point key{ point.hash(), point.index() };
+    auto& shard = partition(point.hash());
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock_upgrade();
+    shard.mutex.lock_upgrade();
 
-    // Find the unspent tx entry that may contain the output.
-    auto tx = unspent_.left.find(key);
+    // Find the unspent output entry.
+    const auto output = shard.outputs.find(key);
 
-    if (tx == unspent_.left.end())
+    if (output == shard.outputs.end())
     {
-        mutex_.unlock_upgrade();
+        shard.mutex.unlock_upgrade();
         //---------------------------------------------------------------------
         return;
     }
 
-    const auto outputs = tx->first.outputs();
-    mutex_.unlock_upgrade_and_lock();
+    shard.mutex.unlock_upgrade_and_lock();
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    erase(shard, output);
 
-    // Erase the output if found at the specified index for the found tx.
-    outputs->erase(point.index());
-
-    // Erase the unspent transaction if it is now fully spent.
-    if (outputs->empty())
-        unspent_.left.erase(tx);
-
-    mutex_.unlock();
+    shard.mutex.unlock();
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -175,39 +345,175 @@ bool unspent_outputs::populate(const output_point& point,
 
     ++queries_;
     auto& prevout = point.metadata;
-     unspent_transaction key{ point };
+    const chain::point key{ point.hash(), point.index() };
+    const auto& shard = partition(point.hash());
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(mutex_);
-
-    // Find the unspent tx entry.
-     auto tx = unspent_.left.find(key);
-    if (tx == unspent_.left.end())
-        return false;
+    shared_lock lock(shard.mutex);
 
-    // Find the output at the specified index for the found unspent tx.
-     auto& transaction = tx->first;
-     auto outputs = transaction.outputs();
-     auto output = outputs->find(point.index());
-    if (output == outputs->end())
+    // Find the unspent output entry.
+    const auto output = shard.outputs.find(key);
+    if (output == shard.outputs.end())
         return false;
 
     ++hits_;
-     auto height = transaction.height();
+    const auto& unspent = output->second;
+
+    // Racing hits may pass the maximum slightly, which is okay.
+    if (policy_ == eviction_policy::clock &&
+        unspent.references < maximum_references)
+        ++unspent.references;
+    const size_t height = unspent.height;
 
     // Populate the output metadata.
     prevout.spent = false;
     prevout.candidate = false;
-    prevout.confirmed = transaction.is_confirmed() && height <= fork_height;
-    prevout.coinbase = transaction.is_coinbase();
+    prevout.confirmed = unspent.confirmed && height <= fork_height;
+    prevout.coinbase = unspent.coinbase;
     prevout.height = height;
-    prevout.median_time_past = transaction.median_time_past();
-    prevout.cache = output->second;
+    prevout.median_time_past = unspent.median_time_past;
+    prevout.cache = chain::output{ unspent.value,
+        chain::script{ unspent.script, false } };
 
     return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
+void unspent_outputs::clear()
+{
+    for (auto& shard: shards_)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(shard.mutex);
+
+        shard.outputs.clear();
+        shard.ages.clear();
+        shard.bytes = 0;
+        ///////////////////////////////////////////////////////////////////////
+    }
+}
+
+// The shards are not locked together, so writes must not be concurrent.
+bool unspent_outputs::save(const path& filename, size_t top_height) const
+{
+    if (disabled())
+        return false;
+
+    bc::ofstream file(filename.string(), std::ios::binary);
+
+    if (!file.good())
+        return false;
+
+    byte_array<file_header_size> header;
+    auto serial = make_unsafe_serializer(header.begin());
+    serial.write_8_bytes_little_endian(top_height);
+    serial.write_8_bytes_little_endian(size());
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    byte_array<file_entry_size> entry;
+
+    for (const auto& shard: shards_)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        shared_lock lock(shard.mutex);
+
+        for (const auto& key: shard.ages)
+        {
+            const auto& value = shard.outputs.find(key)->second;
+            const auto flags = static_cast<uint8_t>(
+                (value.coinbase ? coinbase_flag : 0) |
+                (value.confirmed ? confirmed_flag : 0));
+
+            auto serial = make_unsafe_serializer(entry.begin());
+            serial.write_hash(key.hash());
+            serial.write_4_bytes_little_endian(key.index());
+            serial.write_8_bytes_little_endian(value.value);
+            serial.write_4_bytes_little_endian(value.height);
+            serial.write_4_bytes_little_endian(value.median_time_past);
+            serial.write_byte(flags);
+            serial.write_4_bytes_little_endian(
+                static_cast<uint32_t>(value.script.size()));
+
+            file.write(reinterpret_cast<const char*>(entry.data()),
+                entry.size());
+            file.write(reinterpret_cast<const char*>(value.script.data()),
+                value.script.size());
+        }
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    return file.good();
+}
+
+// The outputs are reinserted oldest first, so relative age is retained.
+bool unspent_outputs::load(const path& filename, size_t top_height)
+{
+    if (disabled())
+        return false;
+
+    bc::ifstream file(filename.string(), std::ios::binary);
+
+    if (!file.good())
+        return false;
+
+    byte_array<file_header_size> header;
+    file.read(reinterpret_cast<char*>(header.data()), header.size());
+    auto deserial = make_unsafe_deserializer(header.begin());
+    const auto height = deserial.read_8_bytes_little_endian();
+    const auto count = deserial.read_8_bytes_little_endian();
+    auto loaded = file.good() && height == top_height;
+
+    byte_array<file_entry_size> entry;
+
+    for (uint64_t index = 0; loaded && index < count; ++index)
+    {
+        file.read(reinterpret_cast<char*>(entry.data()), entry.size());
+        auto deserial = make_unsafe_deserializer(entry.begin());
+        const auto hash = deserial.read_hash();
+        const auto output_index = deserial.read_4_bytes_little_endian();
+        const auto value = deserial.read_8_bytes_little_endian();
+        const auto output_height = deserial.read_4_bytes_little_endian();
+        const auto median_time_past = deserial.read_4_bytes_little_endian();
+        const auto flags = deserial.read_byte();
+        const auto script_size = deserial.read_4_bytes_little_endian();
+
+        // Guard against allocation for a corrupted file.
+        if (!(loaded = file.good() && script_size <= maximum_script_size))
+            break;
+
+        data_chunk script(script_size);
+        file.read(reinterpret_cast<char*>(script.data()), script.size());
+
+        if (!(loaded = file.good()))
+            break;
+
+        auto& shard = partition(hash);
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(shard.mutex);
+
+        insert(shard, { hash, output_index }, { value, std::move(script),
+            output_height, median_time_past, (flags & coinbase_flag) != 0,
+            (flags & confirmed_flag) != 0 });
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    file.close();
+
+    // The file is consumed whether or not it is usable.
+    boost::system::error_code ec;
+    boost::filesystem::remove(filename, ec);
+
+    if (loaded && !ec)
+        return true;
+
+    clear();
+    return false;
+}
+
 } // namespace database
 } // namespace libbitcoin
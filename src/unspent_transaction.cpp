@@ -20,6 +20,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <utility>
 #include <bitcoin/bitcoin.hpp>
 
@@ -29,12 +30,34 @@ namespace database {
 using namespace bc::chain;
 using namespace bc::machine;
 
+// Outputs format:
+// ----------------------------------------------------------------------------
+// [ spent:(count + 7) / 8 ] (bit per output, low bit first)
+// [
+//   [ value:8             ]
+//   [ script_end:4        ] (relative to the first script)
+// ]...
+// [ script... ]
+
+static constexpr size_t entry_size = sizeof(uint64_t) + sizeof(uint32_t);
+
+static size_t bitmap_size(uint32_t count)
+{
+    return (static_cast<size_t>(count) + 7u) / 8u;
+}
+
+static size_t entry_offset(uint32_t count, uint32_t index)
+{
+    return bitmap_size(count) + index * entry_size;
+}
+
 unspent_transaction::unspent_transaction(unspent_transaction&& other)
   : height_(other.height_),
     median_time_past_(other.median_time_past_),
     is_coinbase_(other.is_coinbase_),
     is_confirmed_(other.is_confirmed_),
     hash_(std::move(other.hash_)),
+    output_count_(other.output_count_),
     outputs_(other.outputs_)
 {
 }
@@ -45,6 +68,7 @@ unspent_transaction::unspent_transaction(const unspent_transaction& other)
     is_coinbase_(other.is_coinbase_),
     is_confirmed_(other.is_confirmed_),
     hash_(other.hash_),
+    output_count_(other.output_count_),
     outputs_(other.outputs_)
 {
 }
@@ -55,7 +79,8 @@ unspent_transaction::unspent_transaction(const hash_digest& hash)
     is_coinbase_(false),
     is_confirmed_(false),
     hash_(hash),
-    outputs_(std::make_shared<output_map>())
+    output_count_(0),
+    outputs_(std::make_shared<data_chunk>())
 {
 }
 
@@ -71,15 +96,39 @@ unspent_transaction::unspent_transaction(const chain::transaction& tx,
     is_coinbase_(tx.is_coinbase()),
     is_confirmed_(confirmed),
     hash_(tx.hash()),
-    outputs_(std::make_shared<output_map>())
+    output_count_(safe_unsigned<uint32_t>(tx.outputs().size())),
+    outputs_(std::make_shared<data_chunk>())
 {
     const auto& outputs = tx.outputs();
-    const auto size = safe_unsigned<uint32_t>(outputs.size());
-    outputs_->reserve(size);
+    const auto prefix = entry_offset(output_count_, output_count_);
+    size_t scripts = 0;
+
+    for (const auto& output: outputs)
+        scripts += output.script().serialized_size(false);
+
+    // The buffer is allocated once, so the scripts are appended in place.
+    auto& buffer = *outputs_;
+    buffer.reserve(prefix + scripts);
+    buffer.resize(prefix, 0x00);
 
-    // TODO: consider eliminating the byte buffer in favor of ops::list only.
-    for (auto index = 0u; index < size; ++index)
-        (*outputs_)[index] = outputs[index];
+    auto serial = make_unsafe_serializer(buffer.data() +
+        bitmap_size(output_count_));
+    size_t end = 0;
+
+    for (const auto& output: outputs)
+    {
+        end += output.script().serialized_size(false);
+        serial.write_8_bytes_little_endian(output.value());
+        serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(end));
+    }
+
+    data_sink ostream(buffer);
+
+    for (const auto& output: outputs)
+        output.script().to_data(ostream, false);
+
+    ostream.flush();
+    BITCOIN_ASSERT(buffer.size() == prefix + scripts);
 }
 
 const hash_digest& unspent_transaction::hash() const
@@ -107,9 +156,48 @@ bool unspent_transaction::is_confirmed() const
     return is_confirmed_;
 }
 
-unspent_transaction::output_map_ptr unspent_transaction::outputs() const
+uint32_t unspent_transaction::output_count() const
+{
+    return output_count_;
+}
+
+size_t unspent_transaction::output_bytes() const
+{
+    return outputs_->capacity();
+}
+
+uint64_t unspent_transaction::value(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < output_count_);
+    const auto offset = entry_offset(output_count_, index);
+    return from_little_endian_unsafe<uint64_t>(outputs_->begin() + offset);
+}
+
+bool unspent_transaction::output(chain::output& out, uint32_t index) const
+{
+    if (index >= output_count_)
+        return false;
+
+    const auto scripts = outputs_->begin() +
+        entry_offset(output_count_, output_count_);
+
+    out = chain::output{ value(index), chain::script{ data_chunk{
+        scripts + script_start(index), scripts + script_end(index) },
+        false } };
+
+    return true;
+}
+
+bool unspent_transaction::is_spent(uint32_t index) const
 {
-    return outputs_;
+    BITCOIN_ASSERT(index < output_count_);
+    return ((*outputs_)[index / 8u] & (1u << (index % 8u))) != 0;
+}
+
+void unspent_transaction::spend(uint32_t index) const
+{
+    BITCOIN_ASSERT(index < output_count_);
+    (*outputs_)[index / 8u] |= static_cast<uint8_t>(1u << (index % 8u));
 }
 
 // For the purpose of bimap identity only the tx hash matters.
@@ -126,6 +214,7 @@ unspent_transaction& unspent_transaction::operator=(
     is_coinbase_ = other.is_coinbase_;
     is_confirmed_ = other.is_confirmed_;
     hash_ = std::move(other.hash_);
+    output_count_ = other.output_count_;
     outputs_ = other.outputs_;
     return *this;
 }
@@ -138,9 +227,23 @@ unspent_transaction& unspent_transaction::operator=(
     is_coinbase_ = other.is_coinbase_;
     is_confirmed_ = other.is_confirmed_;
     hash_ = other.hash_;
+    output_count_ = other.output_count_;
     outputs_ = other.outputs_;
     return *this;
 }
 
+// private
+size_t unspent_transaction::script_start(uint32_t index) const
+{
+    return index == 0 ? 0 : script_end(index - 1u);
+}
+
+// private
+size_t unspent_transaction::script_end(uint32_t index) const
+{
+    const auto offset = entry_offset(output_count_, index) + sizeof(uint64_t);
+    return from_little_endian_unsafe<uint32_t>(outputs_->begin() + offset);
+}
+
 } // namespace database
 } // namespace libbitcoin
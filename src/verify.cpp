@@ -18,9 +18,12 @@
  */
 #include <bitcoin/database/verify.hpp>
 
+#include <atomic>
+#include <cstddef>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database/databases/block_database.hpp>
 #include <bitcoin/database/databases/transaction_database.hpp>
+#include <bitcoin/database/parallel.hpp>
 
 namespace libbitcoin {
 namespace database {
@@ -112,7 +115,9 @@ code verify_missing(const transaction_database& transactions,
      transaction& tx)
 {
 #ifdef NDEBUG
-    if (transactions.get(tx.hash()))
+    uint32_t forks;
+    if (transactions.get(tx.hash()) ||
+        transactions.get_pooled(tx.hash(), forks))
         return error::duplicate_transaction;
 #endif
 
@@ -135,6 +140,29 @@ code verify_push(const block_database& blocks,  header& header,
     return error::success;
 }
 
+// The header hash is cached, so the writer does not hash the batch again.
+code verify_batch(const header_const_ptr_list& headers, size_t threads)
+{
+    static constexpr size_t minimum_partition = 64;
+    std::atomic<bool> linked(true);
+
+    const auto verify = [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+        {
+            const auto& header = *headers[index];
+            const auto hash = header.hash();
+
+            if (index + 1 < headers.size() &&
+                headers[index + 1]->previous_block_hash() != hash)
+                linked.store(false);
+        }
+    };
+
+    parallel_for(headers.size(), threads, minimum_partition, verify);
+    return linked.load() ? error::success : error::store_block_missing_parent;
+}
+
 // Blocks are pushed to the confirmed chain.
 code verify_push(const block_database& blocks,  block& block,
     size_t height)
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/write_sequence.hpp>
+
+#include <cstddef>
+#include <thread>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+// A writer is counted before the sequence is advanced at its start, and the
+// sequence is advanced before it is uncounted at its end. So a reader that
+// finds no writers after capturing the sequence, and the same sequence at the
+// end of its read, did not overlap any write.
+
+write_sequence::scope::scope(write_sequence& sequence)
+  : sequence_(sequence)
+{
+    sequence_.begin_write();
+}
+
+write_sequence::scope::~scope()
+{
+    sequence_.end_write();
+}
+
+write_sequence::write_sequence()
+  : writers_(0), sequence_(0)
+{
+}
+
+void write_sequence::begin_write()
+{
+    ++writers_;
+    ++sequence_;
+}
+
+void write_sequence::end_write()
+{
+    BITCOIN_ASSERT(writers_ > 0);
+    ++sequence_;
+    --writers_;
+}
+
+bool write_sequence::begin_read(size_t& out_sequence) const
+{
+    out_sequence = sequence_;
+    return writers_ == 0;
+}
+
+bool write_sequence::end_read(size_t sequence) const
+{
+    return sequence_ == sequence;
+}
+
+bool write_sequence::read(const reader& handler, size_t attempts) const
+{
+    size_t sequence;
+
+    for (size_t attempt = 0; attempt < attempts; ++attempt)
+    {
+        // Yield to the writer rather than read state it is changing.
+        if (!begin_read(sequence))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        handler();
+
+        if (end_read(sequence))
+            return true;
+    }
+
+    return false;
+}
+
+} // namespace database
+} // namespace libbitcoin
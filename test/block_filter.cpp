@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+// BIP158 test vectors (testnet).
+#define GENESIS_HASH "000000000933ea01ad0ee984209779baaec3ced90fa3f408719526f8d77f4943"
+#define GENESIS_SCRIPT "4104678afdb0fe5548271967f1a67130b7105cd6a828e03909a67962e0ea1f61deb649f6bc3f4cef38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac"
+#define GENESIS_FILTER "019dfca8"
+#define GENESIS_HEADER "21584579b7eb08997773e5aeff3a7f932700042d0ed2a6129012b7d7ae81b750"
+
+BOOST_AUTO_TEST_SUITE(block_filter_tests)
+
+BOOST_AUTO_TEST_CASE(block_filter__encode__empty__zero_count)
+{
+    const auto filter = block_filter::encode(hash_literal(GENESIS_HASH), {});
+    BOOST_REQUIRE_EQUAL(filter.size(), 1u);
+    BOOST_REQUIRE_EQUAL(filter[0], 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__encode__genesis__expected)
+{
+    data_chunk script;
+    data_chunk expected;
+    BOOST_REQUIRE(decode_base16(script, GENESIS_SCRIPT));
+    BOOST_REQUIRE(decode_base16(expected, GENESIS_FILTER));
+
+    const auto filter = block_filter::encode(hash_literal(GENESIS_HASH),
+        { script });
+
+    BOOST_REQUIRE(filter == expected);
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__header__genesis__expected)
+{
+    data_chunk filter;
+    BOOST_REQUIRE(decode_base16(filter, GENESIS_FILTER));
+
+    const auto header = block_filter::header(filter, null_hash);
+    BOOST_REQUIRE(header == hash_literal(GENESIS_HEADER));
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__encode__distinct_elements__count_prefix)
+{
+    const data_stack elements{ { 0x01 }, { 0x02 }, { 0x03 } };
+    const auto filter = block_filter::encode(hash_literal(GENESIS_HASH),
+        elements);
+
+    // Three deltas of at least twenty bits each (zero padded).
+    BOOST_REQUIRE_EQUAL(filter[0], 3u);
+    BOOST_REQUIRE_GE(filter.size(), 1u + (3u * 20u + 7u) / 8u);
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__match__genesis_script__true)
+{
+    data_chunk script;
+    data_chunk filter;
+    BOOST_REQUIRE(decode_base16(script, GENESIS_SCRIPT));
+    BOOST_REQUIRE(decode_base16(filter, GENESIS_FILTER));
+
+    const std::vector<uint64_t> hashes
+    {
+        block_filter::hash(hash_literal(GENESIS_HASH), script)
+    };
+
+    BOOST_REQUIRE(block_filter::match(filter, hashes));
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__match__empty_filter__false)
+{
+    std::vector<uint64_t> none;
+    const auto filter = block_filter::encode(none);
+    const std::vector<uint64_t> hashes{ 42 };
+
+    BOOST_REQUIRE_EQUAL(filter.size(), 1u);
+    BOOST_REQUIRE(!block_filter::match(filter, hashes));
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__match__any_encoded_hash__true)
+{
+    std::vector<uint64_t> hashes;
+    for (uint64_t value = 1; value <= 1000; ++value)
+        hashes.push_back(value * 0x9e3779b97f4a7c15);
+
+    auto encoded = hashes;
+    const auto filter = block_filter::encode(encoded);
+
+    for (const auto hash: hashes)
+        BOOST_REQUIRE(block_filter::match(filter, { hash }));
+
+    // The hashes are sorted by encode.
+    BOOST_REQUIRE(block_filter::match(filter, encoded));
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__match__truncated_filter__false)
+{
+    std::vector<uint64_t> hashes{ 1, 2, 3 };
+    auto filter = block_filter::encode(hashes);
+    filter.resize(1);
+
+    BOOST_REQUIRE(!block_filter::match(filter, { max_uint64 }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
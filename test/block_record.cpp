@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(block_record_tests)
+
+BOOST_AUTO_TEST_CASE(block_record__offsets__v4_layout__expected)
+{
+    BOOST_REQUIRE_EQUAL(sizeof(block_record), 99u);
+    BOOST_REQUIRE_EQUAL(block_record_height_offset, 84u);
+    BOOST_REQUIRE_EQUAL(block_record_state_offset, 88u);
+    BOOST_REQUIRE_EQUAL(block_record_checksum_offset, 89u);
+    BOOST_REQUIRE_EQUAL(block_record_transactions_offset, 93u);
+}
+
+BOOST_AUTO_TEST_CASE(block_record__store__integers__little_endian)
+{
+    block_record record;
+    block_record::store(record.height, uint32_t(0x01020304));
+    block_record::store(record.tx_count, uint16_t(0x0506));
+    BOOST_REQUIRE_EQUAL(record.height[0], 0x04u);
+    BOOST_REQUIRE_EQUAL(record.height[3], 0x01u);
+    BOOST_REQUIRE_EQUAL(record.tx_count[0], 0x06u);
+    BOOST_REQUIRE_EQUAL(record.tx_count[1], 0x05u);
+}
+
+BOOST_AUTO_TEST_CASE(block_record__load__stored__round_trips)
+{
+    block_record record;
+    block_record::store(record.median_time_past, uint32_t(42));
+    block_record::store(record.state, uint8_t(7));
+    block_record::store(record.tx_start, uint32_t(0xfffffffe));
+    BOOST_REQUIRE_EQUAL(block_record::load<uint32_t>(record.median_time_past), 42u);
+    BOOST_REQUIRE_EQUAL(block_record::load<uint8_t>(record.state), 7u);
+    BOOST_REQUIRE_EQUAL(block_record::load<uint32_t>(record.tx_start), 0xfffffffeu);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
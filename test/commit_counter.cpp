@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <bitcoin/database.hpp>
+#include "utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Test directory
+#define DIRECTORY "commit_counter"
+
+struct commit_counter_directory_setup_fixture
+{
+    commit_counter_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(commit_counter_tests, commit_counter_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(commit_counter__open__reader_missing_file__false)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    commit_counter instance(file);
+    BOOST_REQUIRE(!instance.open(false));
+}
+
+BOOST_AUTO_TEST_CASE(commit_counter__read__unpublished__false)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    commit_counter instance(file);
+    BOOST_REQUIRE(instance.open(true));
+
+    commit_counter::state state;
+    BOOST_REQUIRE(!instance.read(state));
+}
+
+BOOST_AUTO_TEST_CASE(commit_counter__publish__reader__expected)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    commit_counter writer(file);
+    BOOST_REQUIRE(writer.open(true));
+    BOOST_REQUIRE(writer.publish(42, 24));
+    BOOST_REQUIRE(writer.publish(43, 25));
+
+    commit_counter reader(file);
+    BOOST_REQUIRE(reader.open(false));
+    BOOST_REQUIRE(!reader.publish(44, 26));
+
+    commit_counter::state state;
+    BOOST_REQUIRE(reader.read(state));
+    BOOST_REQUIRE_EQUAL(state.sequence, 2u);
+    BOOST_REQUIRE_EQUAL(state.candidate_height, 43u);
+    BOOST_REQUIRE_EQUAL(state.confirmed_height, 25u);
+}
+
+BOOST_AUTO_TEST_CASE(commit_counter__publish__reopened_writer__sequence_continues)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    commit_counter instance(file);
+    BOOST_REQUIRE(instance.open(true));
+    BOOST_REQUIRE(instance.publish(1, 1));
+    BOOST_REQUIRE(instance.close());
+    BOOST_REQUIRE(instance.open(true));
+    BOOST_REQUIRE(instance.publish(2, 2));
+
+    commit_counter::state state;
+    BOOST_REQUIRE(instance.read(state));
+    BOOST_REQUIRE_EQUAL(state.sequence, 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <bitcoin/database.hpp>
+#include "utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Test directory
+#define DIRECTORY "commit_log"
+
+struct commit_log_directory_setup_fixture
+{
+    commit_log_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+struct entry
+{
+    std::string table;
+    file_offset offset;
+    data_chunk data;
+};
+
+static std::vector<entry> replay(const commit_log& log)
+{
+    std::vector<entry> entries;
+    const auto handler = [&](const std::string& table, file_offset offset,
+        const data_chunk& data)
+    {
+        entries.push_back({ table, offset, data });
+        return true;
+    };
+
+    BOOST_REQUIRE(log.replay(handler));
+    return entries;
+}
+
+BOOST_FIXTURE_TEST_SUITE(commit_log_tests, commit_log_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(commit_log__replay__committed__expected)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    const data_chunk first{ 0x01, 0x02, 0x03 };
+    const data_chunk second{ 0x42 };
+    commit_log instance(file);
+    BOOST_REQUIRE(instance.open());
+    instance.write("alpha", 7, first.data(), first.size());
+    instance.write("beta", 0, second.data(), second.size());
+    BOOST_REQUIRE_GT(instance.pending(), 0u);
+    BOOST_REQUIRE(instance.commit());
+    BOOST_REQUIRE_EQUAL(instance.pending(), 0u);
+    BOOST_REQUIRE_GT(instance.size(), 0u);
+
+    const auto entries = replay(instance);
+    BOOST_REQUIRE_EQUAL(entries.size(), 2u);
+    BOOST_REQUIRE_EQUAL(entries[0].table, "alpha");
+    BOOST_REQUIRE_EQUAL(entries[0].offset, 7u);
+    BOOST_REQUIRE(entries[0].data == first);
+    BOOST_REQUIRE_EQUAL(entries[1].table, "beta");
+    BOOST_REQUIRE_EQUAL(entries[1].offset, 0u);
+    BOOST_REQUIRE(entries[1].data == second);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(commit_log__replay__discarded__empty)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    const data_chunk data{ 0x01 };
+    commit_log instance(file);
+    BOOST_REQUIRE(instance.open());
+    instance.write("alpha", 0, data.data(), data.size());
+    instance.discard();
+    BOOST_REQUIRE(instance.commit());
+    BOOST_REQUIRE(replay(instance).empty());
+}
+
+BOOST_AUTO_TEST_CASE(commit_log__reset__committed__empty)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    const data_chunk data{ 0x01 };
+    commit_log instance(file);
+    BOOST_REQUIRE(instance.open());
+    instance.write("alpha", 0, data.data(), data.size());
+    BOOST_REQUIRE(instance.commit());
+    BOOST_REQUIRE(instance.reset());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(replay(instance).empty());
+}
+
+BOOST_AUTO_TEST_CASE(commit_log__replay__torn_tail__ignored)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    const data_chunk data{ 0x01, 0x02 };
+    commit_log instance(file);
+    BOOST_REQUIRE(instance.open());
+    instance.write("alpha", 0, data.data(), data.size());
+    BOOST_REQUIRE(instance.commit());
+    BOOST_REQUIRE(instance.close());
+
+    // Simulate a batch interrupted before it was fully written.
+    {
+        bc::ofstream stream(file, std::ios::binary | std::ios::app);
+        stream.put(0x42);
+        stream.put(0x00);
+    }
+
+    const auto entries = replay(instance);
+    BOOST_REQUIRE_EQUAL(entries.size(), 1u);
+    BOOST_REQUIRE(entries[0].data == data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
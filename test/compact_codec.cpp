@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+
+#define P2PKH_SCRIPT "76a91418c0bd8d1818f1bf99cb1df2269c645318ef7b7388ac"
+#define OTHER_SCRIPT "6a0401020304"
+
+static transaction make_transaction(uint64_t value)
+{
+    data_chunk p2pkh;
+    data_chunk other;
+    BOOST_REQUIRE(decode_base16(p2pkh, P2PKH_SCRIPT));
+    BOOST_REQUIRE(decode_base16(other, OTHER_SCRIPT));
+
+    const input::list inputs
+    {
+        { { null_hash, 0 }, script{ { 0x51 }, false }, 42 }
+    };
+
+    const output::list outputs
+    {
+        { value, script{ p2pkh, false } },
+        { 0, script{ other, false } }
+    };
+
+    return { 1, 0, inputs, outputs };
+}
+
+BOOST_AUTO_TEST_SUITE(compact_codec_tests)
+
+BOOST_AUTO_TEST_CASE(compact_codec__compress__amounts__round_trips)
+{
+    static const uint64_t amounts[] =
+    {
+        0, 1, 9, 10, 1234, 100000000, 5000000000, 2100000000000000
+    };
+
+    for (const auto amount: amounts)
+        BOOST_REQUIRE_EQUAL(compact_codec::decompress(
+            compact_codec::compress(amount)), amount);
+}
+
+BOOST_AUTO_TEST_CASE(compact_codec__compress__whole_coins__one_byte)
+{
+    BOOST_REQUIRE_EQUAL(compact_codec::compress(0), 0u);
+    BOOST_REQUIRE_EQUAL(compact_codec::compress(100000000), 9u);
+}
+
+BOOST_AUTO_TEST_CASE(compact_codec__compactable__overflow__false)
+{
+    BOOST_REQUIRE(compact_codec::compactable(make_transaction(50)));
+    BOOST_REQUIRE(!compact_codec::compactable(make_transaction(max_uint64)));
+}
+
+BOOST_AUTO_TEST_CASE(compact_codec__output_size__p2pkh__template)
+{
+    const auto tx = make_transaction(5000000000);
+
+    // Spend metadata (5), compressed value (1) and template (1 + 20).
+    BOOST_REQUIRE_EQUAL(compact_codec::output_size(tx.outputs()[0]), 27u);
+}
+
+BOOST_AUTO_TEST_CASE(compact_codec__write__expand__round_trips)
+{
+    const auto tx = make_transaction(5000000000);
+    const auto size = compact_codec::size(tx);
+    BOOST_REQUIRE_LT(size, tx.serialized_size(false, true));
+
+    data_chunk compact(size);
+    auto serial = make_unsafe_serializer(compact.data());
+    compact_codec::write(serial, tx);
+
+    auto deserial = make_unsafe_deserializer(compact.data());
+    BOOST_REQUIRE(compact_codec::expand(deserial) == tx.to_data(false, true));
+}
+
+BOOST_AUTO_TEST_CASE(compact_codec__skip_output__outputs__expected_sizes)
+{
+    const auto tx = make_transaction(5000000000);
+    data_chunk compact(compact_codec::size(tx));
+    auto serial = make_unsafe_serializer(compact.data());
+    compact_codec::write(serial, tx);
+
+    auto deserial = make_unsafe_deserializer(compact.data());
+    BOOST_REQUIRE_EQUAL(deserial.read_size_little_endian(), 2u);
+    BOOST_REQUIRE_EQUAL(compact_codec::skip_output(deserial),
+        compact_codec::output_size(tx.outputs()[0]));
+    BOOST_REQUIRE_EQUAL(compact_codec::skip_output(deserial),
+        compact_codec::output_size(tx.outputs()[1]));
+}
+
+BOOST_AUTO_TEST_CASE(compact_codec__skip_payload__after_spend__expected_sizes)
+{
+    const auto tx = make_transaction(5000000000);
+    data_chunk compact(compact_codec::size(tx));
+    auto serial = make_unsafe_serializer(compact.data());
+    compact_codec::write(serial, tx);
+
+    static const size_t spend_size = sizeof(uint8_t) + sizeof(uint32_t);
+    auto deserial = make_unsafe_deserializer(compact.data());
+    BOOST_REQUIRE_EQUAL(deserial.read_size_little_endian(), 2u);
+    deserial.skip(spend_size);
+    BOOST_REQUIRE_EQUAL(compact_codec::skip_payload(deserial),
+        compact_codec::output_size(tx.outputs()[0]) - spend_size);
+    deserial.skip(spend_size);
+    BOOST_REQUIRE_EQUAL(compact_codec::skip_payload(deserial),
+        compact_codec::output_size(tx.outputs()[1]) - spend_size);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(crc32c_tests)
+
+BOOST_AUTO_TEST_CASE(crc32c__empty__zero)
+{
+    BOOST_REQUIRE_EQUAL(crc32c(nullptr, 0), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(crc32c__check_string__expected)
+{
+    const std::string check = "123456789";
+    const auto data = reinterpret_cast<const uint8_t*>(check.data());
+    BOOST_REQUIRE_EQUAL(crc32c(data, check.size()), 0xe3069283u);
+}
+
+BOOST_AUTO_TEST_CASE(crc32c__zeros__expected)
+{
+    const data_chunk zeros(32, 0x00);
+    BOOST_REQUIRE_EQUAL(crc32c(zeros.data(), zeros.size()), 0x8a9136aau);
+}
+
+BOOST_AUTO_TEST_CASE(crc32c__continued__same_as_whole)
+{
+    data_chunk data(1000);
+    for (size_t index = 0; index < data.size(); ++index)
+        data[index] = static_cast<uint8_t>(index * 7);
+
+    const auto whole = crc32c(data.data(), data.size());
+    const auto first = crc32c(data.data(), 333);
+    BOOST_REQUIRE_EQUAL(crc32c(data.data() + 333, data.size() - 333, first),
+        whole);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,462 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <bitcoin/database.hpp>
+#include "utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+
+#define DIRECTORY "data_base_push"
+
+static const short_hash payee
+{
+    {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+        0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14
+    }
+};
+
+// The hash of a transaction that is not stored.
+static const hash_digest unknown = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000042");
+
+struct data_base_push_fixture
+{
+    data_base_push_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+static database::settings make_settings()
+{
+    database::settings settings;
+    settings.directory = DIRECTORY;
+    settings.flush_writes = false;
+    settings.file_growth_rate = 42;
+    settings.block_table_buckets = 42;
+    settings.transaction_table_buckets = 42;
+    settings.address_table_buckets = 42;
+    settings.filter_table_buckets = 42;
+    settings.spend_table_buckets = 42;
+    return settings;
+}
+
+// A block at height one of which the second tx spends the coinbase output.
+static block make_block(const hash_digest& previous)
+{
+    const script paid(script::to_pay_key_hash_pattern(payee));
+    const script change(data_chunk{ 0x51 }, false);
+
+    transaction coinbase(1, 0,
+    {
+        { output_point{ null_hash, point::null_index },
+            script(data_chunk{ 0x51, 0x51 }, false), 0 }
+    },
+    {
+        { 5000000000, paid }
+    });
+
+    transaction spend(1, 0,
+    {
+        { output_point{ coinbase.hash(), 0 }, script{}, 0 }
+    },
+    {
+        { 4000000000, change }
+    });
+
+    const chain::header header(1, previous, null_hash, 0, 0x1d00ffff, 0);
+    return block(header, { coinbase, spend });
+}
+
+// A block paying the value to the payee, of which the second tx spends an
+// output that is not stored, signed by the key.
+static block make_unknown_spend(const hash_digest& previous, size_t height,
+    uint64_t value, const data_chunk& key)
+{
+    const script paid(script::to_pay_key_hash_pattern(payee));
+    const script change(data_chunk{ 0x51 }, false);
+    const data_chunk endorsement(9, 0x42);
+
+    transaction coinbase(1, 0,
+    {
+        { output_point{ null_hash, point::null_index },
+            script(data_chunk{ 0x51, static_cast<uint8_t>(height) }, false),
+            0 }
+    },
+    {
+        { value, paid }
+    });
+
+    const machine::operation::list sign
+    {
+        machine::operation(endorsement),
+        machine::operation(key)
+    };
+
+    transaction spend(1, 0,
+    {
+        { output_point{ unknown, 0 }, script(sign), 0 }
+    },
+    {
+        { 1000, change }
+    });
+
+    const chain::header header(1, previous, null_hash, 0, 0x1d00ffff,
+        static_cast<uint32_t>(height));
+    return block(header, { coinbase, spend });
+}
+
+// A pool transaction, made distinct by its locktime.
+static transaction make_pooled(uint32_t locktime)
+{
+    return transaction(1, locktime,
+    {
+        { output_point{ unknown, 0 }, script{}, 0 }
+    },
+    {
+        { 1000, script(data_chunk{ 0x51 }, false) }
+    });
+}
+
+// The results of queued writes in order of handling.
+struct handled
+{
+    std::mutex mutex;
+    std::vector<size_t> order;
+    std::vector<code> results;
+    std::promise<void> done;
+    size_t expected;
+
+    data_base::result_handler handler(size_t index)
+    {
+        return [this, index](const code& ec)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            order.push_back(index);
+            results.push_back(ec);
+
+            if (order.size() == expected)
+                done.set_value();
+        };
+    }
+};
+
+static bool wait_indexed(const data_base& instance, size_t height)
+{
+    size_t indexed = 0;
+    for (size_t poll = 0; poll < 1000; ++poll)
+    {
+        if (instance.addresses().indexed_height(indexed) && indexed == height)
+            return true;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return false;
+}
+
+static size_t count_rows(const data_base& instance, const short_hash& hash)
+{
+    const auto result = instance.addresses().get(hash);
+    size_t rows = 0;
+    for (auto it = result.begin(); it != result.end(); ++it)
+        ++rows;
+
+    return rows;
+}
+
+BOOST_FIXTURE_TEST_SUITE(data_base_push_tests, data_base_push_fixture)
+
+BOOST_AUTO_TEST_CASE(data_base__push__internal_spend__filter_of_spent_script)
+{
+    auto settings = make_settings();
+    settings.index_filters = true;
+
+    data_base instance(settings);
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    auto block = make_block(genesis.hash());
+    BOOST_REQUIRE_EQUAL(instance.push(block, 1), error::success);
+
+    // The prevout is populated from the block, as it is not yet stored.
+    const auto& point = block.transactions()[1].inputs()[0].previous_output();
+    BOOST_REQUIRE(point.metadata.cache.is_valid());
+
+    data_chunk filter;
+    hash_digest filter_header;
+    BOOST_REQUIRE(instance.filters().get(filter, filter_header,
+        block.hash()));
+
+    const auto spent = block.transactions()[0].outputs()[0].script()
+        .to_data(false);
+    const auto created = block.transactions()[1].outputs()[0].script()
+        .to_data(false);
+
+    data_stack elements{ spent, created };
+    std::sort(elements.begin(), elements.end());
+    BOOST_REQUIRE(filter == block_filter::encode(block.hash(), elements));
+
+    const std::vector<uint64_t> hashes
+    {
+        block_filter::hash(block.hash(), spent)
+    };
+
+    BOOST_REQUIRE(block_filter::match(filter, hashes));
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(data_base__push__deferred_index__indexes_block)
+{
+    auto settings = make_settings();
+    settings.index_addresses = true;
+    settings.index_deferred = true;
+
+    data_base instance(settings);
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    auto block = make_block(genesis.hash());
+    BOOST_REQUIRE_EQUAL(instance.push(block, 1), error::success);
+
+    // The block is indexed in background, without a further write.
+    BOOST_REQUIRE(wait_indexed(instance, 1));
+
+    // The coinbase output and its spend within the block.
+    BOOST_REQUIRE_EQUAL(count_rows(instance, payee), 2u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(data_base__writers__queued__handled_in_call_order)
+{
+    data_base instance(make_settings());
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    handled writes;
+    writes.expected = 4;
+    const auto block = std::make_shared<message::block>(
+        make_block(genesis.hash()));
+
+    instance.store(std::make_shared<message::transaction>(make_pooled(1)), 0,
+        writes.handler(0));
+    instance.push(block, 1, 0, writes.handler(1));
+    instance.store(std::make_shared<message::transaction>(make_pooled(2)), 0,
+        writes.handler(2));
+    instance.store(std::make_shared<message::transaction>(make_pooled(3)), 0,
+        writes.handler(3));
+    writes.done.get_future().wait();
+
+    const std::vector<size_t> order{ 0, 1, 2, 3 };
+    BOOST_REQUIRE(writes.order == order);
+    BOOST_REQUIRE(std::all_of(writes.results.begin(), writes.results.end(),
+        [](const code& ec) { return ec == error::success; }));
+
+    size_t top;
+    BOOST_REQUIRE(instance.blocks().top(top, false));
+    BOOST_REQUIRE_EQUAL(top, 1u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(data_base__writers__closed__service_stopped)
+{
+    data_base instance(make_settings());
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+    BOOST_REQUIRE(instance.close());
+
+    // The handler is invoked on the calling thread once stopped.
+    handled writes;
+    writes.expected = 2;
+    instance.store(std::make_shared<message::transaction>(make_pooled(1)), 0,
+        writes.handler(0));
+    instance.push(std::make_shared<message::block>(
+        make_block(genesis.hash())), 1, 0, writes.handler(1));
+
+    BOOST_REQUIRE_EQUAL(writes.results.size(), 2u);
+    BOOST_REQUIRE_EQUAL(writes.results[0], error::service_stopped);
+    BOOST_REQUIRE_EQUAL(writes.results[1], error::service_stopped);
+}
+
+BOOST_AUTO_TEST_CASE(data_base__writers__group_with_duplicate__result_per_request)
+{
+    auto settings = make_settings();
+    settings.transaction_commit_window_ms = 100;
+
+    data_base instance(settings);
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    handled writes;
+    writes.expected = 3;
+    const auto first = make_pooled(1);
+    const auto second = make_pooled(2);
+
+    // Queued within the window, so committed as one group.
+    instance.store(std::make_shared<message::transaction>(first), 0,
+        writes.handler(0));
+    instance.store(std::make_shared<message::transaction>(first), 0,
+        writes.handler(1));
+    instance.store(std::make_shared<message::transaction>(second), 0,
+        writes.handler(2));
+    writes.done.get_future().wait();
+
+    const std::vector<size_t> order{ 0, 1, 2 };
+    BOOST_REQUIRE(writes.order == order);
+    BOOST_REQUIRE_EQUAL(writes.results[0], error::success);
+    BOOST_REQUIRE_EQUAL(writes.results[2], error::success);
+
+    // Duplicates are rejected only in release builds (see verify_missing).
+#ifdef NDEBUG
+    BOOST_REQUIRE_EQUAL(writes.results[1], error::duplicate_transaction);
+#else
+    BOOST_REQUIRE_EQUAL(writes.results[1], error::success);
+#endif
+
+    // The failure of one store does not fail the others of the group.
+    BOOST_REQUIRE(instance.transactions().get(first.hash()));
+    BOOST_REQUIRE(instance.transactions().get(second.hash()));
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(data_base__store__commit_window__stored_before_return)
+{
+    auto settings = make_settings();
+    settings.transaction_commit_window_ms = 10;
+
+    data_base instance(settings);
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    // Stored through the writer, the call blocks until committed.
+    auto tx = make_pooled(1);
+    BOOST_REQUIRE_EQUAL(instance.store(tx, 0), error::success);
+
+    BOOST_REQUIRE(instance.transactions().get(tx.hash()));
+
+    // Concurrent blocking stores share the writer.
+    auto tx2 = make_pooled(2);
+    auto tx3 = make_pooled(3);
+    code ec2;
+    code ec3;
+    std::thread store2([&]() { ec2 = instance.store(tx2, 0); });
+    std::thread store3([&]() { ec3 = instance.store(tx3, 0); });
+    store2.join();
+    store3.join();
+
+    BOOST_REQUIRE_EQUAL(ec2, error::success);
+    BOOST_REQUIRE_EQUAL(ec3, error::success);
+    BOOST_REQUIRE(instance.transactions().get(tx2.hash()));
+    BOOST_REQUIRE(instance.transactions().get(tx3.hash()));
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(data_base__index__uncached_prevout__spent_value_from_store)
+{
+    auto settings = make_settings();
+    settings.index_addresses = true;
+    settings.address_balance_buckets = 42;
+
+    data_base instance(settings);
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    auto block = make_block(genesis.hash());
+    BOOST_REQUIRE_EQUAL(instance.push(block, 1), error::success);
+
+    // The prevout of the spend is not cached, so it is read from the store.
+    const auto& point = block.transactions()[1].inputs()[0].previous_output();
+    BOOST_REQUIRE(!point.metadata.cache.is_valid());
+    BOOST_REQUIRE_EQUAL(instance.index(block), error::success);
+
+    address_database::aggregate totals;
+    BOOST_REQUIRE(instance.addresses().get(totals, payee));
+    BOOST_REQUIRE_EQUAL(totals.received, 5000000000u);
+    BOOST_REQUIRE_EQUAL(totals.spent, 5000000000u);
+    BOOST_REQUIRE_EQUAL(totals.transactions, 2u);
+    BOOST_REQUIRE_EQUAL(totals.height, 1u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(data_base__reorganize__deferred_index__balances_follow_blocks)
+{
+    auto settings = make_settings();
+    settings.index_addresses = true;
+    settings.index_deferred = true;
+    settings.address_balance_buckets = 42;
+
+    data_base instance(settings);
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    const auto key = to_chunk(base16_literal(
+        "0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798"));
+    const auto signer = bitcoin_short_hash(key);
+
+    auto block1 = make_block(genesis.hash());
+    BOOST_REQUIRE_EQUAL(instance.push(block1, 1), error::success);
+    BOOST_REQUIRE(wait_indexed(instance, 1));
+
+    address_database::aggregate totals;
+    BOOST_REQUIRE(instance.addresses().get(totals, payee));
+    BOOST_REQUIRE_EQUAL(totals.received, 5000000000u);
+    BOOST_REQUIRE_EQUAL(totals.spent, 5000000000u);
+    BOOST_REQUIRE_EQUAL(totals.transactions, 2u);
+    BOOST_REQUIRE_EQUAL(totals.height, 1u);
+
+    auto block2 = make_unknown_spend(block1.hash(), 2, 1000000000, key);
+    BOOST_REQUIRE_EQUAL(instance.push(block2, 2), error::success);
+    BOOST_REQUIRE(wait_indexed(instance, 2));
+
+    BOOST_REQUIRE(instance.addresses().get(totals, payee));
+    BOOST_REQUIRE_EQUAL(totals.received, 6000000000u);
+    BOOST_REQUIRE_EQUAL(totals.spent, 5000000000u);
+    BOOST_REQUIRE_EQUAL(totals.transactions, 3u);
+    BOOST_REQUIRE_EQUAL(totals.height, 2u);
+
+    // The spend of an output not stored has a row but no value to total.
+    BOOST_REQUIRE_EQUAL(count_rows(instance, signer), 1u);
+    BOOST_REQUIRE(!instance.addresses().get(totals, signer));
+
+    const auto incoming = std::make_shared<const block_const_ptr_list>();
+    const auto outgoing = std::make_shared<block_const_ptr_list>();
+    BOOST_REQUIRE_EQUAL(instance.reorganize({ block1.hash(), 1 }, incoming,
+        outgoing), error::success);
+    BOOST_REQUIRE_EQUAL(outgoing->size(), 1u);
+
+    BOOST_REQUIRE(instance.addresses().get(totals, payee));
+    BOOST_REQUIRE_EQUAL(totals.received, 5000000000u);
+    BOOST_REQUIRE_EQUAL(totals.spent, 5000000000u);
+    BOOST_REQUIRE_EQUAL(totals.transactions, 2u);
+    BOOST_REQUIRE_EQUAL(totals.height, 1u);
+    BOOST_REQUIRE_EQUAL(count_rows(instance, signer), 0u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+#include <bitcoin/database.hpp>
+#include "../utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+
+#define DIRECTORY "spend_database"
+
+struct spend_database_directory_setup_fixture
+{
+    spend_database_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+// Spenders are verified against stored txs, so the store is used to index.
+static database::settings make_settings()
+{
+    database::settings settings;
+    settings.directory = DIRECTORY;
+    settings.flush_writes = false;
+    settings.file_growth_rate = 42;
+    settings.block_table_buckets = 42;
+    settings.transaction_table_buckets = 42;
+    settings.address_table_buckets = 42;
+    settings.filter_table_buckets = 42;
+    settings.spend_table_buckets = 42;
+    settings.index_spends = true;
+    settings.transaction_linked_inputs = true;
+    return settings;
+}
+
+static transaction make_coinbase(uint8_t height)
+{
+    return transaction(1, 0,
+    {
+        { output_point{ null_hash, point::null_index },
+            script(data_chunk{ 0x51, height }, false), 0 }
+    },
+    {
+        { 1000, script(data_chunk{ 0x51 }, false) },
+        { 2000, script(data_chunk{ 0x51 }, false) }
+    });
+}
+
+// A tx spending the outpoint, made distinct by its locktime.
+static transaction make_spend(const output_point& outpoint,
+    uint32_t locktime=0)
+{
+    return transaction(1, locktime,
+    {
+        { outpoint, script{}, 0 }
+    },
+    {
+        { 500, script(data_chunk{ 0x51 }, false) }
+    });
+}
+
+static block make_block(const hash_digest& previous, uint32_t nonce,
+    const transaction::list& transactions)
+{
+    const chain::header header(1, previous, null_hash, 0, 0x1d00ffff, nonce);
+    return block(header, transactions);
+}
+
+BOOST_FIXTURE_TEST_SUITE(spend_database_tests,
+    spend_database_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(spend_database__get__indexed__round_trip)
+{
+    data_base instance(make_settings());
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    const auto coinbase1 = make_coinbase(1);
+    const auto spend1 = make_spend({ coinbase1.hash(), 0 });
+    auto block1 = make_block(genesis.hash(), 1, { coinbase1, spend1 });
+    BOOST_REQUIRE_EQUAL(instance.push(block1, 1), error::success);
+
+    // The parent of the spend is stored, so its input point is linked.
+    const auto coinbase2 = make_coinbase(2);
+    const auto spend2 = make_spend({ coinbase1.hash(), 1 });
+    auto block2 = make_block(block1.hash(), 2, { coinbase2, spend2 });
+    BOOST_REQUIRE_EQUAL(instance.push(block2, 2), error::success);
+
+    const auto stored = instance.transactions().get(spend2.hash());
+    BOOST_REQUIRE(stored);
+    BOOST_REQUIRE_EQUAL(stored.begin().parent(),
+        instance.transactions().get(coinbase1.hash()).link());
+
+    input_point spender;
+    BOOST_REQUIRE(instance.spends().get(spender, { coinbase1.hash(), 0 }));
+    BOOST_REQUIRE(spender.hash() == spend1.hash());
+    BOOST_REQUIRE_EQUAL(spender.index(), 0u);
+
+    BOOST_REQUIRE(instance.spends().get(spender, { coinbase1.hash(), 1 }));
+    BOOST_REQUIRE(spender.hash() == spend2.hash());
+    BOOST_REQUIRE_EQUAL(spender.index(), 0u);
+
+    BOOST_REQUIRE(!instance.spends().get(spender, { coinbase2.hash(), 0 }));
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(spend_database__get__reorganized__not_found)
+{
+    data_base instance(make_settings());
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    const auto coinbase1 = make_coinbase(1);
+    auto block1 = make_block(genesis.hash(), 1, { coinbase1 });
+    BOOST_REQUIRE_EQUAL(instance.push(block1, 1), error::success);
+
+    const auto spend2 = make_spend({ coinbase1.hash(), 1 });
+    auto block2 = make_block(block1.hash(), 2, { make_coinbase(2), spend2 });
+    BOOST_REQUIRE_EQUAL(instance.push(block2, 2), error::success);
+
+    input_point spender;
+    BOOST_REQUIRE(instance.spends().get(spender, { coinbase1.hash(), 1 }));
+
+    const auto incoming = std::make_shared<const block_const_ptr_list>();
+    const auto outgoing = std::make_shared<block_const_ptr_list>();
+    BOOST_REQUIRE_EQUAL(instance.reorganize({ block1.hash(), 1 }, incoming,
+        outgoing), error::success);
+
+    BOOST_REQUIRE(!instance.spends().get(spender, { coinbase1.hash(), 1 }));
+
+    // The vacant row is reused when the outpoint is spent again.
+    transaction::list respenders{ make_spend({ coinbase1.hash(), 1 }, 42) };
+    BOOST_REQUIRE_EQUAL(instance.store(respenders.front(), 0),
+        error::success);
+    instance.spends().index(respenders);
+    BOOST_REQUIRE(instance.spends().get(spender, { coinbase1.hash(), 1 }));
+    BOOST_REQUIRE(spender.hash() == respenders.front().hash());
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(spend_database__index__second_spender__replaces_row)
+{
+    data_base instance(make_settings());
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    const auto coinbase1 = make_coinbase(1);
+    const auto spend1 = make_spend({ coinbase1.hash(), 0 });
+    auto block1 = make_block(genesis.hash(), 1, { coinbase1, spend1 });
+    BOOST_REQUIRE_EQUAL(instance.push(block1, 1), error::success);
+
+    // A stored spender of which the prior spend was not unwound.
+    transaction::list spenders{ make_spend({ coinbase1.hash(), 0 }, 42) };
+    BOOST_REQUIRE_EQUAL(instance.store(spenders.front(), 0), error::success);
+    instance.spends().index(spenders);
+
+    input_point spender;
+    BOOST_REQUIRE(instance.spends().get(spender, { coinbase1.hash(), 0 }));
+    BOOST_REQUIRE(spender.hash() == spenders.front().hash());
+
+    // The row is replaced, so indexing the prior spender replaces it back.
+    instance.spends().index(block1.transactions());
+    BOOST_REQUIRE(instance.spends().get(spender, { coinbase1.hash(), 0 }));
+    BOOST_REQUIRE(spender.hash() == spend1.hash());
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(spend_database__index__fingerprint_collisions__maximum_probes)
+{
+    data_base instance(make_settings());
+    auto genesis = block::genesis_mainnet();
+    BOOST_REQUIRE(instance.create(genesis));
+
+    // Outpoints of hashes with the same leading bytes share fingerprints.
+    const size_t maximum_probes = 16;
+    transaction::list spenders;
+    std::vector<output_point> outpoints;
+
+    for (size_t index = 0; index <= maximum_probes; ++index)
+    {
+        auto hash = null_hash;
+        hash.back() = static_cast<uint8_t>(index + 1u);
+        outpoints.push_back({ hash, 0 });
+
+        spenders.push_back(make_spend(outpoints.back()));
+        BOOST_REQUIRE_EQUAL(instance.store(spenders.back(), 0),
+            error::success);
+    }
+
+    instance.spends().index(spenders);
+
+    input_point spender;
+    for (size_t index = 0; index < maximum_probes; ++index)
+    {
+        BOOST_REQUIRE(instance.spends().get(spender, outpoints[index]));
+        BOOST_REQUIRE(spender.hash() == spenders[index].hash());
+    }
+
+    // A spend beyond the probe limit is not indexed.
+    BOOST_REQUIRE(!instance.spends().get(spender, outpoints.back()));
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
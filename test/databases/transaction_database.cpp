@@ -18,6 +18,9 @@
  */
 #include <boost/test/unit_test.hpp>
 
+#include <memory>
+#include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/database.hpp>
 #include "../utility/utility.hpp"
@@ -32,6 +35,10 @@ using namespace bc::database;
 #define TRANSACTION1 "0100000001537c9d05b5f7d67b09e5108e3bd5e466909cc9403ddd98bc42973f366fe729410600000000ffffffff0163000000000000001976a914fe06e7b4c88a719e92373de489c08244aee4520b88ac00000000"
 #define TRANSACTION2 "010000000147811c3fc0c0e750af5d0ea7343b16ea2d0c291c002e3db778669216eb689de80000000000ffffffff0118ddf505000000001976a914575c2f0ea88fcbad2389a372d942dea95addc25b88ac00000000"
 
+// The hash of a transaction that is not stored.
+static const hash_digest unknown = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000042");
+
 struct transaction_database_directory_setup_fixture
 {
     transaction_database_directory_setup_fixture()
@@ -40,6 +47,42 @@ struct transaction_database_directory_setup_fixture
     }
 };
 
+// A tx of p2pkh outputs spending the previous outputs, made distinct by its
+// locktime.
+static transaction make_tx(const output_point::list& previous,
+    uint32_t locktime, size_t outputs=2)
+{
+    input::list inputs;
+    for (const auto& point: previous)
+        inputs.emplace_back(point, script(data_chunk{ 0x51 }, false),
+            max_input_sequence);
+
+    output::list payments;
+    for (size_t index = 0; index < outputs; ++index)
+    {
+        short_hash payee = null_short_hash;
+        payee.front() = static_cast<uint8_t>(index + 1u);
+        payments.emplace_back(1000 * (index + 1u),
+            script(script::to_pay_key_hash_pattern(payee)));
+    }
+
+    return transaction(1, locktime, std::move(inputs), std::move(payments));
+}
+
+static data_chunk copy_slice(const data_slice& slice)
+{
+    return data_chunk(slice.begin(), slice.end());
+}
+
+// Create the table file and the database on it.
+static std::shared_ptr<transaction_database> make_database(
+    const std::string& name)
+{
+    const auto path = DIRECTORY "/" + name;
+    BOOST_REQUIRE(test::create(path));
+    return std::make_shared<transaction_database>(path, 42, 50, 0);
+}
+
 BOOST_FIXTURE_TEST_SUITE(database_tests, transaction_database_directory_setup_fixture)
 
 // TODO: reimplement.
@@ -85,4 +128,271 @@ BOOST_AUTO_TEST_CASE(transaction_database__test)
     ////db.commit();
 }
 
+BOOST_AUTO_TEST_CASE(transaction_database__store__linked_input__point_round_trip)
+{
+    const auto instance = make_database("linked");
+    instance->enable_linked_inputs();
+    BOOST_REQUIRE(instance->create());
+
+    // The previous tx of the parent is not stored, so its input is unlinked.
+    transaction::list parents{ make_tx({ { unknown, 0 } }, 1) };
+    BOOST_REQUIRE(instance->store(parents, 1, 0));
+
+    const output_point previous{ parents.front().hash(), 1 };
+    transaction::list children{ make_tx({ previous }, 2) };
+    BOOST_REQUIRE(instance->store(children, 2, 0));
+
+    const auto parent_link = parents.front().metadata.link;
+    const auto result = instance->get(children.front().hash());
+    BOOST_REQUIRE(result);
+
+    auto it = result.begin();
+    BOOST_REQUIRE(it != result.end());
+    BOOST_REQUIRE_EQUAL(it.parent(), parent_link);
+    BOOST_REQUIRE_EQUAL((*it).index(), 1u);
+    BOOST_REQUIRE(instance->get(it.parent()).hash() == previous.hash());
+
+    const auto tx = result.transaction();
+    BOOST_REQUIRE(tx.hash() == children.front().hash());
+    BOOST_REQUIRE(tx.inputs().front().previous_output() == previous);
+
+    const auto view = result.view();
+    BOOST_REQUIRE_EQUAL(view.inputs(), 1u);
+    BOOST_REQUIRE_EQUAL(view.previous_link(0), parent_link);
+    BOOST_REQUIRE(view.previous_output(0) == previous);
+
+    const auto parent = instance->get(parent_link).view();
+    BOOST_REQUIRE_EQUAL(parent.previous_link(0),
+        transaction_result::const_element_type::not_found);
+    BOOST_REQUIRE(parent.previous_output(0) == output_point(unknown, 0));
+    BOOST_REQUIRE(instance->close());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_database__view__compact_linked__reads_stored_tx)
+{
+    const auto instance = make_database("view");
+    instance->enable_compaction();
+    instance->enable_linked_inputs();
+    BOOST_REQUIRE(instance->create());
+
+    transaction::list parents{ make_tx({ { unknown, 0 } }, 1) };
+    BOOST_REQUIRE(instance->store(parents, 1, 0));
+
+    transaction::list children
+    {
+        make_tx({ { parents.front().hash(), 0 }, { unknown, 1 } }, 2, 3)
+    };
+
+    BOOST_REQUIRE(instance->store(children, 2, 0));
+
+    const auto& tx = children.front();
+    const auto view = instance->get(tx.hash()).view();
+    BOOST_REQUIRE_EQUAL(view.version(), tx.version());
+    BOOST_REQUIRE_EQUAL(view.locktime(), tx.locktime());
+    BOOST_REQUIRE(!view.segregated());
+
+    // Outputs are decoded from the compact encoding.
+    BOOST_REQUIRE_EQUAL(view.outputs(), 3u);
+    for (uint32_t index = 0; index < view.outputs(); ++index)
+    {
+        const auto& output = tx.outputs()[index];
+        BOOST_REQUIRE_EQUAL(view.value(index), output.value());
+        BOOST_REQUIRE(copy_slice(view.output_script(index)) ==
+            output.script().to_data(false));
+    }
+
+    // The first input is linked, the second is not.
+    BOOST_REQUIRE_EQUAL(view.inputs(), 2u);
+    BOOST_REQUIRE_EQUAL(view.previous_link(0), parents.front().metadata.link);
+    BOOST_REQUIRE_EQUAL(view.previous_link(1),
+        transaction_result::const_element_type::not_found);
+
+    for (uint32_t index = 0; index < view.inputs(); ++index)
+    {
+        const auto& input = tx.inputs()[index];
+        BOOST_REQUIRE(view.previous_output(index) == input.previous_output());
+        BOOST_REQUIRE(copy_slice(view.input_script(index)) ==
+            input.script().to_data(false));
+        BOOST_REQUIRE_EQUAL(view.sequence(index), input.sequence());
+    }
+
+    // The wire encoding is written from the view without deserialization.
+    data_chunk wire;
+    data_sink ostream(wire);
+    ostream_writer sink(ostream);
+    view.to_data(sink, true);
+    ostream.flush();
+    BOOST_REQUIRE(wire == tx.to_data(true));
+    BOOST_REQUIRE(instance->close());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_database__view__pruned__reads_empty)
+{
+    const auto instance = make_database("pruned");
+    BOOST_REQUIRE(instance->create());
+
+    transaction::list parents{ make_tx({ { unknown, 0 } }, 1) };
+    BOOST_REQUIRE(instance->store(parents, 1, 0));
+
+    // Both outputs of the parent are spent in a confirmed block.
+    const auto& parent = parents.front();
+    transaction::list children
+    {
+        make_tx({ { parent.hash(), 0 }, { parent.hash(), 1 } }, 2)
+    };
+
+    BOOST_REQUIRE(instance->store(children));
+    BOOST_REQUIRE(instance->confirm(children, 2, 0));
+    BOOST_REQUIRE_EQUAL(instance->prune({ children.front().metadata.link },
+        2), 1u);
+
+    const auto result = instance->get(parent.hash());
+    BOOST_REQUIRE(result);
+    BOOST_REQUIRE(result.pruned());
+    BOOST_REQUIRE_EQUAL(result.height(), 1u);
+
+    const auto view = result.view();
+    BOOST_REQUIRE_EQUAL(view.version(), 0u);
+    BOOST_REQUIRE_EQUAL(view.locktime(), 0u);
+    BOOST_REQUIRE_EQUAL(view.outputs(), 0u);
+    BOOST_REQUIRE_EQUAL(view.inputs(), 0u);
+
+    // The spender is not pruned.
+    const auto child = instance->get(children.front().hash());
+    BOOST_REQUIRE(!child.pruned());
+    BOOST_REQUIRE_EQUAL(child.view().inputs(), 2u);
+    BOOST_REQUIRE(instance->close());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_database__import_unspent__exported__inputless_txs)
+{
+    const auto source = make_database("export");
+    BOOST_REQUIRE(source->create());
+
+    transaction::list parents{ make_tx({ { unknown, 0 } }, 1, 3) };
+    BOOST_REQUIRE(source->store(parents, 1, 0));
+
+    // The second output of the parent is spent at the snapshot height.
+    const auto& parent = parents.front();
+    transaction::list children{ make_tx({ { parent.hash(), 1 } }, 2) };
+    BOOST_REQUIRE(source->store(children));
+    BOOST_REQUIRE(source->confirm(children, 2, 0));
+
+    const auto snapshot = DIRECTORY "/snapshot";
+    BOOST_REQUIRE(source->export_unspent(snapshot, 2, unknown));
+    BOOST_REQUIRE(source->close());
+
+    size_t height;
+    hash_digest block_hash;
+    uint64_t count;
+    BOOST_REQUIRE(transaction_database::read_snapshot(snapshot, height,
+        block_hash, count));
+    BOOST_REQUIRE_EQUAL(height, 2u);
+    BOOST_REQUIRE(block_hash == unknown);
+    BOOST_REQUIRE_EQUAL(count, 2u);
+
+    const auto target = make_database("import");
+    BOOST_REQUIRE(target->create());
+    BOOST_REQUIRE(target->import_unspent(snapshot));
+
+    const auto result = target->get(parent.hash());
+    BOOST_REQUIRE(result);
+    BOOST_REQUIRE_EQUAL(result.height(), 1u);
+    BOOST_REQUIRE_EQUAL(result.position(), 0u);
+
+    // The tx is stored without inputs, with version and locktime zero.
+    const auto view = result.view();
+    BOOST_REQUIRE_EQUAL(view.version(), 0u);
+    BOOST_REQUIRE_EQUAL(view.locktime(), 0u);
+    BOOST_REQUIRE_EQUAL(view.inputs(), 0u);
+    BOOST_REQUIRE_EQUAL(view.outputs(), 3u);
+
+    // Outputs not in the snapshot read as spent at its height.
+    BOOST_REQUIRE(!result.is_spent(0, 2, false));
+    BOOST_REQUIRE(result.is_spent(1, 2, false));
+    BOOST_REQUIRE(!result.is_spent(2, 2, false));
+    BOOST_REQUIRE_EQUAL(result.output(0).value(), parent.outputs()[0].value());
+    BOOST_REQUIRE_EQUAL(result.output(2).value(), parent.outputs()[2].value());
+    BOOST_REQUIRE(result.output(2).script() == parent.outputs()[2].script());
+
+    BOOST_REQUIRE(target->get(children.front().hash()));
+    BOOST_REQUIRE(target->close());
+}
+
+// The candidate spend state of each output of the txs, in order.
+static std::vector<bool> candidate_spent(const transaction_database& instance,
+    const transaction::list& transactions)
+{
+    std::vector<bool> spent;
+    for (const auto& tx: transactions)
+    {
+        const auto result = instance.get(tx.hash());
+        BOOST_REQUIRE(result);
+
+        for (uint32_t index = 0; index < tx.outputs().size(); ++index)
+            spent.push_back(result.is_spent(index, 0, true));
+    }
+
+    return spent;
+}
+
+// Enough spent txs that spends are located and written on several threads.
+BOOST_AUTO_TEST_CASE(transaction_database__candidate__parallel__matches_serial)
+{
+    const size_t count = 1200;
+    const auto serial = make_database("serial");
+    const auto parallel = make_database("parallel");
+    serial->enable_parallel(1);
+    parallel->enable_parallel(4);
+    BOOST_REQUIRE(serial->create());
+    BOOST_REQUIRE(parallel->create());
+
+    transaction::list parents;
+    for (uint32_t index = 0; index < count; ++index)
+        parents.push_back(make_tx({ { unknown, index } }, index));
+
+    // Each child spends one or two parent outputs, and the last spends the
+    // output of a child (within the block).
+    transaction::list children;
+    std::vector<bool> expected(2u * count, false);
+    for (uint32_t index = 0; index < count; ++index)
+    {
+        output_point::list spent{ { parents[index].hash(), 0 } };
+        expected[2u * index] = true;
+
+        if (index % 3u == 0u)
+        {
+            const auto next = (index + 1u) % count;
+            spent.push_back({ parents[next].hash(), 1 });
+            expected[2u * next + 1u] = true;
+        }
+
+        children.push_back(make_tx(spent, index));
+    }
+
+    children.push_back(make_tx({ { children.front().hash(), 1 } }, count));
+    expected.resize(expected.size() + 2u * count + 2u, false);
+    expected[2u * count + 1u] = true;
+
+    auto serial_parents = parents;
+    auto serial_children = children;
+    BOOST_REQUIRE(serial->store(serial_parents, 1, 0));
+    BOOST_REQUIRE(serial->store(serial_children));
+    BOOST_REQUIRE(serial->candidate(serial_children));
+
+    BOOST_REQUIRE(parallel->store(parents, 1, 0));
+    BOOST_REQUIRE(parallel->store(children));
+    BOOST_REQUIRE(parallel->candidate(children));
+
+    auto all = parents;
+    all.insert(all.end(), children.begin(), children.end());
+    const auto serial_spent = candidate_spent(*serial, all);
+    const auto parallel_spent = candidate_spent(*parallel, all);
+
+    BOOST_REQUIRE(serial_spent == expected);
+    BOOST_REQUIRE(parallel_spent == serial_spent);
+    BOOST_REQUIRE(serial->close());
+    BOOST_REQUIRE(parallel->close());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
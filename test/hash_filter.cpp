@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <bitcoin/database.hpp>
+#include "utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Test directory
+#define DIRECTORY "hash_filter"
+
+struct hash_filter_directory_setup_fixture
+{
+    hash_filter_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+// Spread the value over the digest with splitmix64, as a uniform hash.
+static hash_digest make_hash(uint64_t value)
+{
+    hash_digest hash;
+    for (size_t word = 0; word < hash.size() / sizeof(uint64_t); ++word)
+    {
+        auto mix = (value += 0x9e3779b97f4a7c15);
+        mix = (mix ^ (mix >> 30)) * 0xbf58476d1ce4e5b9;
+        mix = (mix ^ (mix >> 27)) * 0x94d049bb133111eb;
+        mix ^= mix >> 31;
+        const auto bytes = to_little_endian(mix);
+        std::copy(bytes.begin(), bytes.end(),
+            hash.begin() + word * sizeof(uint64_t));
+    }
+
+    return hash;
+}
+
+BOOST_FIXTURE_TEST_SUITE(hash_filter_tests, hash_filter_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__zero_size__disabled_true)
+{
+    hash_filter filter(0, 1000);
+    filter.create();
+    BOOST_REQUIRE(filter.disabled());
+    BOOST_REQUIRE(!filter.valid());
+    BOOST_REQUIRE(filter.contains(make_hash(42)));
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__not_created__true)
+{
+    hash_filter filter(4096, 1000);
+    BOOST_REQUIRE(!filter.valid());
+    BOOST_REQUIRE(filter.contains(make_hash(42)));
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__hashes__error_ppm__expected)
+{
+    BOOST_REQUIRE_EQUAL(hash_filter(64, 1000).hashes(), 10u);
+    BOOST_REQUIRE_EQUAL(hash_filter(64, 500000).hashes(), 1u);
+    BOOST_REQUIRE_EQUAL(hash_filter(64, 1).hashes(), 16u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__contains__inserted__no_false_negatives)
+{
+    hash_filter filter(64 * 1024, 1000);
+    filter.create();
+    BOOST_REQUIRE_EQUAL(filter.size(), 64u * 1024u);
+
+    for (uint64_t value = 0; value < 10000; ++value)
+        filter.insert(make_hash(value));
+
+    for (uint64_t value = 0; value < 10000; ++value)
+        BOOST_REQUIRE(filter.contains(make_hash(value)));
+
+    size_t positives = 0;
+    for (uint64_t value = 10000; value < 20000; ++value)
+        positives += filter.contains(make_hash(value)) ? 1 : 0;
+
+    // About 8 bits per hash, so well under ten percent.
+    BOOST_REQUIRE_LT(positives, 1000u);
+    BOOST_REQUIRE_GT(filter.false_positive_rate(), 0.0f);
+    BOOST_REQUIRE_LT(filter.false_positive_rate(), 0.1f);
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__load__saved__round_trips_and_consumed)
+{
+    const auto path = DIRECTORY "/filter";
+    hash_filter filter(4096, 1000);
+    filter.create();
+    filter.insert(make_hash(1));
+    filter.insert(make_hash(2));
+    BOOST_REQUIRE(filter.save(path));
+
+    hash_filter loaded(4096, 1000);
+    BOOST_REQUIRE(loaded.load(path, 2));
+    BOOST_REQUIRE(loaded.valid());
+    BOOST_REQUIRE(loaded.contains(make_hash(1)));
+    BOOST_REQUIRE(loaded.contains(make_hash(2)));
+
+    // The file is removed when loaded.
+    hash_filter reloaded(4096, 1000);
+    BOOST_REQUIRE(!reloaded.load(path, 2));
+}
+
+BOOST_AUTO_TEST_CASE(hash_filter__load__count_mismatch__false)
+{
+    const auto path = DIRECTORY "/filter";
+    hash_filter filter(4096, 1000);
+    filter.create();
+    filter.insert(make_hash(1));
+    BOOST_REQUIRE(filter.save(path));
+
+    hash_filter loaded(4096, 1000);
+    BOOST_REQUIRE(!loaded.load(path, 2));
+    BOOST_REQUIRE(!loaded.valid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
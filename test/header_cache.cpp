@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+static cached_header make_header(size_t height)
+{
+    cached_header header{};
+    header.hash = hash_digest{ { static_cast<uint8_t>(height),
+        static_cast<uint8_t>(height >> 8) } };
+    header.bits = 0x1d00ffff;
+    header.timestamp = static_cast<uint32_t>(1000 + height);
+    header.version = 4;
+    header.height = static_cast<uint32_t>(height);
+    return header;
+}
+
+BOOST_AUTO_TEST_SUITE(header_cache_tests)
+
+BOOST_AUTO_TEST_CASE(header_cache__construct__capacity_0__disabled)
+{
+    header_cache cache(0);
+    BOOST_REQUIRE(cache.disabled());
+    cache.push(make_header(0));
+    cached_header out;
+    BOOST_REQUIRE(!cache.get(out, 0));
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__push__consecutive__all_found)
+{
+    header_cache cache(16);
+    BOOST_REQUIRE(!cache.disabled());
+
+    for (size_t height = 0; height < 10; ++height)
+        cache.push(make_header(height));
+
+    BOOST_REQUIRE_EQUAL(cache.size(), 10u);
+
+    cached_header out;
+    for (size_t height = 0; height < 10; ++height)
+    {
+        BOOST_REQUIRE(cache.get(out, height));
+        BOOST_REQUIRE(out.hash == make_header(height).hash);
+        BOOST_REQUIRE_EQUAL(out.timestamp, 1000u + height);
+    }
+
+    BOOST_REQUIRE(!cache.get(out, 10));
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__push__beyond_capacity__lowest_evicted)
+{
+    header_cache cache(4);
+
+    for (size_t height = 0; height < 10; ++height)
+        cache.push(make_header(height));
+
+    BOOST_REQUIRE_EQUAL(cache.size(), 4u);
+
+    cached_header out;
+    BOOST_REQUIRE(!cache.get(out, 5));
+    BOOST_REQUIRE(cache.get(out, 6));
+    BOOST_REQUIRE_EQUAL(out.height, 6u);
+    BOOST_REQUIRE(cache.get(out, 9));
+    BOOST_REQUIRE_EQUAL(out.height, 9u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__pop__top__retains_lower)
+{
+    header_cache cache(8);
+
+    for (size_t height = 0; height < 5; ++height)
+        cache.push(make_header(height));
+
+    cache.pop(4);
+    cache.pop(3);
+    BOOST_REQUIRE_EQUAL(cache.size(), 3u);
+
+    cached_header out;
+    BOOST_REQUIRE(!cache.get(out, 3));
+    BOOST_REQUIRE(cache.get(out, 2));
+
+    // A reorganization pushes replacements onto the retained window.
+    auto replacement = make_header(3);
+    replacement.version = 42;
+    cache.push(replacement);
+    BOOST_REQUIRE(cache.get(out, 3));
+    BOOST_REQUIRE_EQUAL(out.version, 42u);
+    BOOST_REQUIRE(cache.get(out, 0));
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__push__gap__restarts_window)
+{
+    header_cache cache(8);
+    cache.push(make_header(0));
+    cache.push(make_header(1));
+    cache.push(make_header(5));
+
+    cached_header out;
+    BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE(!cache.get(out, 1));
+    BOOST_REQUIRE(cache.get(out, 5));
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__set_state__matching_hash__updated)
+{
+    header_cache cache(8);
+    cache.push(make_header(0));
+    cache.push(make_header(1));
+
+    cache.set_state(make_header(0).hash, 1, 7);
+    cache.set_state(make_header(1).hash, 1, 9);
+
+    cached_header out;
+    BOOST_REQUIRE(cache.get(out, 1));
+    BOOST_REQUIRE_EQUAL(out.state, 9u);
+    BOOST_REQUIRE(cache.get(out, 0));
+    BOOST_REQUIRE_EQUAL(out.state, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__from_data__to_data__round_trips)
+{
+    header_cache cache(16);
+
+    for (size_t height = 0; height < 20; ++height)
+        cache.push(make_header(height));
+
+    header_cache copy(16);
+    BOOST_REQUIRE(copy.from_data(cache.to_data()));
+    BOOST_REQUIRE_EQUAL(copy.size(), 16u);
+
+    cached_header out;
+    BOOST_REQUIRE(!copy.get(out, 3));
+    BOOST_REQUIRE(copy.get(out, 19));
+    BOOST_REQUIRE(out.hash == make_header(19).hash);
+    BOOST_REQUIRE_EQUAL(out.timestamp, make_header(19).timestamp);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__from_data__above_capacity__lowest_dropped)
+{
+    header_cache cache(16);
+
+    for (size_t height = 0; height < 16; ++height)
+        cache.push(make_header(height));
+
+    header_cache smaller(4);
+    BOOST_REQUIRE(smaller.from_data(cache.to_data()));
+    BOOST_REQUIRE_EQUAL(smaller.size(), 4u);
+
+    cached_header out;
+    BOOST_REQUIRE(!smaller.get(out, 11));
+    BOOST_REQUIRE(smaller.get(out, 12));
+    BOOST_REQUIRE(smaller.get(out, 15));
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__from_data__truncated__false_empty)
+{
+    header_cache cache(16);
+    cache.push(make_header(0));
+    auto data = cache.to_data();
+    data.pop_back();
+
+    header_cache copy(16);
+    copy.push(make_header(0));
+    BOOST_REQUIRE(!copy.from_data(data));
+    BOOST_REQUIRE_EQUAL(copy.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <bitcoin/database.hpp>
+#include "utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace boost::filesystem;
+
+// Test directory
+#define DIRECTORY "manifest"
+
+struct manifest_directory_setup_fixture
+{
+    manifest_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(manifest_tests, manifest_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(manifest__load__no_file__false)
+{
+    manifest instance(DIRECTORY "/manifest");
+    BOOST_REQUIRE(!instance.load());
+    BOOST_REQUIRE(instance.empty());
+}
+
+BOOST_AUTO_TEST_CASE(manifest__save_load__values__round_trips_and_consumed)
+{
+    const auto filename = DIRECTORY "/manifest";
+    const data_chunk value{ 0x01, 0x02, 0x03 };
+
+    manifest saved(filename);
+    saved.set("value", value);
+    saved.set("empty", data_chunk{});
+    BOOST_REQUIRE(saved.save());
+
+    manifest loaded(filename);
+    BOOST_REQUIRE(loaded.load());
+    BOOST_REQUIRE(!exists(filename));
+
+    data_chunk out;
+    BOOST_REQUIRE(loaded.get("value", out));
+    BOOST_REQUIRE(out == value);
+    BOOST_REQUIRE(loaded.get("empty", out));
+    BOOST_REQUIRE(out.empty());
+    BOOST_REQUIRE(!loaded.get("missing", out));
+
+    // A consumed manifest cannot be reloaded.
+    manifest reloaded(filename);
+    BOOST_REQUIRE(!reloaded.load());
+}
+
+BOOST_AUTO_TEST_CASE(manifest__load__corrupted__false_empty)
+{
+    const auto filename = DIRECTORY "/manifest";
+
+    manifest saved(filename);
+    saved.set("value", data_chunk{ 0x42 });
+    BOOST_REQUIRE(saved.save());
+
+    // Flip a byte of the payload, so that the checksum fails.
+    {
+        std::fstream file(filename, std::ios::in | std::ios::out |
+            std::ios::binary);
+        file.seekp(9);
+        file.put('x');
+    }
+
+    manifest loaded(filename);
+    BOOST_REQUIRE(!loaded.load());
+    BOOST_REQUIRE(loaded.empty());
+}
+
+BOOST_AUTO_TEST_CASE(manifest__matches_size__changed_file__false)
+{
+    const auto table = path(DIRECTORY "/table");
+    {
+        bc::ofstream file(table.string());
+        file << "abc";
+    }
+
+    manifest instance(DIRECTORY "/manifest");
+    BOOST_REQUIRE(!instance.matches_size(table));
+    instance.set_size(table);
+    BOOST_REQUIRE(instance.matches_size(table));
+
+    {
+        bc::ofstream file(table.string(), std::ios::app);
+        file << "d";
+    }
+
+    BOOST_REQUIRE(!instance.matches_size(table));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(block_arena_tests)
+
+BOOST_AUTO_TEST_CASE(block_arena__construct__default__empty)
+{
+    const block_arena instance;
+    BOOST_REQUIRE_EQUAL(instance.used(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.capacity(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_arena__allocate__alignment__aligned)
+{
+    block_arena instance(64);
+    BOOST_REQUIRE(instance.allocate(1, 1) != nullptr);
+    const auto address = reinterpret_cast<uintptr_t>(instance.allocate(8, 8));
+    BOOST_REQUIRE_EQUAL(address % 8u, 0u);
+    BOOST_REQUIRE_GE(instance.used(), 9u);
+}
+
+BOOST_AUTO_TEST_CASE(block_arena__allocate__beyond_chunk__grows)
+{
+    block_arena instance(64);
+    instance.allocate(48, 1);
+    instance.allocate(48, 1);
+    BOOST_REQUIRE_GE(instance.capacity(), 128u);
+    BOOST_REQUIRE_EQUAL(instance.used(), 96u);
+}
+
+BOOST_AUTO_TEST_CASE(block_arena__reset__after_growth__retains_peak_capacity)
+{
+    block_arena instance(64);
+    instance.allocate(48, 1);
+    instance.allocate(48, 1);
+    const auto capacity = instance.capacity();
+    instance.reset();
+    BOOST_REQUIRE_EQUAL(instance.used(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.capacity(), capacity);
+
+    // The working set now fits the one (coalesced) chunk.
+    instance.allocate(48, 1);
+    instance.allocate(48, 1);
+    BOOST_REQUIRE_EQUAL(instance.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(block_arena__scope__nested__reset_by_outermost)
+{
+    block_arena instance;
+    {
+        block_arena::scope outer(instance);
+        {
+            block_arena::scope inner(instance);
+            instance.allocate(42, 1);
+        }
+
+        BOOST_REQUIRE_EQUAL(instance.used(), 42u);
+    }
+
+    BOOST_REQUIRE_EQUAL(instance.used(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_arena__arena_allocator__vector__expected)
+{
+    block_arena instance;
+    std::vector<uint64_t, arena_allocator<uint64_t>> values(instance);
+
+    for (uint64_t value = 0; value < 1000; ++value)
+        values.push_back(value);
+
+    BOOST_REQUIRE_EQUAL(values.size(), 1000u);
+    BOOST_REQUIRE_EQUAL(values[999], 999u);
+    BOOST_REQUIRE_GE(instance.used(), 1000u * sizeof(uint64_t));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
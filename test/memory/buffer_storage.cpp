@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database.hpp>
+#include "../utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Test directory
+#define DIRECTORY "buffer_storage"
+
+struct buffer_storage_directory_setup_fixture
+{
+    buffer_storage_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+        log::initialize();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(buffer_storage_tests, buffer_storage_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(buffer_storage__open__one_byte_file__1)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    buffer_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_storage__flush__missing_file__failure)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    buffer_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(!instance.flush());
+}
+
+BOOST_AUTO_TEST_CASE(buffer_storage__close__written__reopens_expected)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+
+    {
+        buffer_storage instance(file, 50);
+        BOOST_REQUIRE(instance.open());
+        auto memory = instance.resize(sizeof(uint64_t));
+        auto serial = make_unsafe_serializer(memory->buffer());
+        serial.write_8_bytes_big_endian(expected);
+        memory.reset();
+        BOOST_REQUIRE(instance.close());
+    }
+
+    buffer_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.size(), sizeof(uint64_t));
+    const auto memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_storage__flush_dirty__reserved__success)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    buffer_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(instance.reserve(42));
+    BOOST_REQUIRE(instance.flush_dirty());
+    BOOST_REQUIRE(instance.flush_dirty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -17,6 +17,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <boost/test/unit_test.hpp>
+#include <cstring>
 
 #include <bitcoin/database.hpp>
 #include "../utility/utility.hpp"
@@ -160,6 +161,25 @@ BOOST_AUTO_TEST_CASE(file_storage__flush__open__success)
     BOOST_REQUIRE(instance.flush());
 }
 
+BOOST_AUTO_TEST_CASE(file_storage__flush_dirty__closed__success)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+    BOOST_REQUIRE(instance.flush_dirty());
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__flush_dirty__reserved__success)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(instance.reserve(42));
+    BOOST_REQUIRE(instance.flush_dirty());
+    BOOST_REQUIRE(instance.flush_dirty());
+}
+
 BOOST_AUTO_TEST_CASE(file_storage__write__read__expected)
 {
     const uint64_t expected = 0x0102030405060708;
@@ -178,4 +198,238 @@ BOOST_AUTO_TEST_CASE(file_storage__write__read__expected)
     BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
 }
 
+BOOST_AUTO_TEST_CASE(file_storage__access__after_reserve__expected)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    BOOST_REQUIRE(memory);
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    // Both pins are released before the remap, which would otherwise wait.
+    auto reader1 = instance.access();
+    auto reader2 = instance.access();
+    BOOST_REQUIRE(reader1->buffer() == reader2->buffer());
+    reader1.reset();
+    reader2.reset();
+
+    BOOST_REQUIRE(instance.reserve(1024 * 1024));
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__reserve__within_reservation__buffer_unmoved)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file, 0, 16 * 1024 * 1024);
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    const auto buffer = memory->buffer();
+    auto serial = make_unsafe_serializer(buffer);
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    // The pinned reader survives growth within the reservation.
+    const auto reader = instance.access();
+    BOOST_REQUIRE(instance.reserve(1024 * 1024));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1024u * 1024u);
+    BOOST_REQUIRE(reader->buffer() == buffer);
+    auto deserial = make_unsafe_deserializer(reader->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__prefetch__beyond_size__contents_unchanged)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    // Advice is clamped to the file and has no visible effect.
+    instance.prefetch(0, 1024 * 1024);
+    instance.prefetch(3, sizeof(uint64_t));
+    instance.prefetch(instance.size(), 1);
+    instance.prefetch(0, 0);
+
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__enable_advice__reserve__contents_unchanged)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+
+    // Advice is only a hint, so it cannot fail open or reserve.
+    map_advice advice{};
+    advice.huge_pages = true;
+    advice.populate = true;
+    advice.lock = true;
+    advice.numa = numa_policy::interleave;
+    advice.numa_nodes = 1;
+    instance.enable_advice(advice, 0);
+
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    BOOST_REQUIRE(instance.reserve(1024 * 1024));
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__enable_advice__cold_header_only__contents_unchanged)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+
+    map_advice advice{};
+    advice.header_only = true;
+    advice.cold = true;
+    instance.enable_advice(advice, sizeof(uint64_t));
+
+    BOOST_REQUIRE(instance.open());
+    const auto offset = 1024 * 1024 - sizeof(uint64_t);
+    auto memory = instance.reserve(1024 * 1024);
+    auto serial = make_unsafe_serializer(memory->buffer() + offset);
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    BOOST_REQUIRE(instance.reserve(2 * 1024 * 1024));
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer() + offset);
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__enable_growth__fixed__chunk_beyond_size)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file, 50);
+
+    file_growth growth{};
+    growth.policy = growth_policy::fixed;
+    growth.chunk = 4096;
+    instance.enable_growth(growth);
+
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(instance.reserve(10000));
+    BOOST_REQUIRE_EQUAL(instance.size(), 10000u + 4096u);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__enable_growth__capped__limited_to_chunk)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file, 50);
+
+    file_growth growth{};
+    growth.policy = growth_policy::capped;
+    growth.chunk = 10;
+    instance.enable_growth(growth);
+
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(instance.reserve(1000));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1010u);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__pregrow__preallocate__contents_unchanged)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file, 50);
+
+    file_growth growth{};
+    growth.preallocate = true;
+    growth.pregrow_percent = 1;
+    instance.enable_growth(growth);
+
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    // Pregrow does not change the size of the file.
+    const auto size = instance.size();
+    instance.pregrow();
+    BOOST_REQUIRE_EQUAL(instance.size(), size);
+
+    BOOST_REQUIRE(instance.reserve(1024 * 1024));
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__logical_size__reserve__reserved)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(instance.reserve(42));
+    BOOST_REQUIRE_EQUAL(instance.logical_size(), 42u);
+    BOOST_REQUIRE_GE(instance.size(), instance.logical_size());
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__resident_size__written__not_above_size)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(1024 * 1024);
+    std::memset(memory->buffer(), 0x42, 1024 * 1024);
+    memory.reset();
+    BOOST_REQUIRE_GT(instance.resident_size(), 0u);
+    BOOST_REQUIRE_LE(instance.resident_size(), instance.size());
+}
+
+BOOST_AUTO_TEST_CASE(file_storage__scan_guard__beyond_size__contents_unchanged)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    file_storage instance(file);
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    // Advice is clamped to the file, reverted on release, and has no visible
+    // effect. The guard does not pin the mapping, so growth is not blocked.
+    {
+        const scan_guard whole(instance, 0, 1024 * 1024);
+        const scan_guard empty(instance, instance.size(), 1);
+        BOOST_REQUIRE(instance.reserve(1024 * 1024));
+    }
+
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <cstddef>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(memory_handle_tests)
+
+static void release(void* context)
+{
+    --(*static_cast<size_t*>(context));
+}
+
+BOOST_AUTO_TEST_CASE(memory_handle_constructor__default__no_access)
+{
+    memory_handle instance;
+    BOOST_REQUIRE(!instance);
+}
+
+BOOST_AUTO_TEST_CASE(memory_handle_constructor__nonzero__expected_buffer)
+{
+    uint8_t value;
+    size_t pins = 1;
+    memory_handle instance(&value, release, &pins);
+    BOOST_REQUIRE(instance);
+    BOOST_REQUIRE_EQUAL(instance.buffer(), &value);
+}
+
+BOOST_AUTO_TEST_CASE(memory_handle_increment__nonzero__expected_offset)
+{
+    uint8_t value;
+    size_t pins = 1;
+    memory_handle instance(&value, release, &pins);
+    const auto offset = 42u;
+    instance.increment(offset);
+    BOOST_REQUIRE_EQUAL(instance.buffer(), &value + offset);
+}
+
+BOOST_AUTO_TEST_CASE(memory_handle_destructor__pinned__releases_once)
+{
+    uint8_t value;
+    size_t pins = 2;
+    {
+        memory_handle instance(&value, release, &pins);
+    }
+    BOOST_REQUIRE_EQUAL(pins, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_handle_move__pinned__transfers_pin)
+{
+    uint8_t value;
+    size_t pins = 2;
+    {
+        memory_handle instance(&value, release, &pins);
+        memory_handle moved(std::move(instance));
+        BOOST_REQUIRE(!instance);
+        BOOST_REQUIRE(moved);
+        BOOST_REQUIRE_EQUAL(moved.buffer(), &value);
+    }
+    BOOST_REQUIRE_EQUAL(pins, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_handle_move_assign__pinned__releases_previous)
+{
+    uint8_t value;
+    size_t first = 1;
+    size_t second = 1;
+    memory_handle instance(&value, release, &first);
+    instance = memory_handle(&value, release, &second);
+    BOOST_REQUIRE_EQUAL(first, 0u);
+    BOOST_REQUIRE_EQUAL(second, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database.hpp>
+#include "../utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Test directory
+#define DIRECTORY "memory_storage"
+
+struct memory_storage_directory_setup_fixture
+{
+    memory_storage_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+        log::initialize();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(memory_storage_tests, memory_storage_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(memory_storage__open__missing_file__empty)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    memory_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_storage__open__from_opened__failure)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    memory_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(!instance.open());
+}
+
+BOOST_AUTO_TEST_CASE(memory_storage__open__one_byte_file__1)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    memory_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_storage__reserve__closed__throws_runtime_error)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    memory_storage instance(file, 50);
+    BOOST_REQUIRE_THROW(instance.reserve(42), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(memory_storage__reserve__growth__contents_retained)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    memory_storage instance(file, 0);
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    BOOST_REQUIRE(instance.reserve(1024 * 1024));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1024u * 1024u);
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(memory_storage__close__written__file_unchanged)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+
+    {
+        memory_storage instance(file, 50);
+        BOOST_REQUIRE(instance.open());
+        BOOST_REQUIRE(instance.resize(42));
+        BOOST_REQUIRE(instance.flush());
+        BOOST_REQUIRE(instance.close());
+    }
+
+    file_storage instance(file);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(memory_storage__reserve__huge_pages__contents_retained)
+{
+    const uint64_t expected = 0x0102030405060708;
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    memory_storage instance(file, 0, true);
+    BOOST_REQUIRE(instance.open());
+    auto memory = instance.reserve(sizeof(uint64_t));
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_8_bytes_big_endian(expected);
+    memory.reset();
+
+    // The physical size is a multiple of the huge page.
+    BOOST_REQUIRE(instance.reserve(3 * 1024 * 1024));
+#ifndef _WIN32
+    BOOST_REQUIRE_EQUAL(instance.size() % (2 * 1024 * 1024), 0u);
+#endif
+    memory = instance.access();
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_8_bytes_big_endian(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(memory_storage__pin__released__resizes)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    memory_storage instance(file, 50);
+    BOOST_REQUIRE(instance.open());
+    instance.resize(42);
+    {
+        const auto memory = instance.pin();
+        BOOST_REQUIRE(memory);
+    }
+
+    // Resize drains pins, so this would not return if the pin were held.
+    BOOST_REQUIRE(instance.resize(84));
+    BOOST_REQUIRE_EQUAL(instance.size(), 84u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
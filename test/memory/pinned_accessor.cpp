@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(pinned_accessor_tests)
+
+BOOST_AUTO_TEST_CASE(pinned_accessor_constructor__nonzero__expected_buffer)
+{
+    uint8_t value;
+    auto expected = &value;
+    std::atomic<size_t> readers(1);
+    pinned_accessor instance(readers, expected);
+    BOOST_REQUIRE_EQUAL(instance.buffer(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(pinned_accessor_increment__nonzero__expected_offset)
+{
+    uint8_t value;
+    auto buffer = &value;
+    std::atomic<size_t> readers(1);
+    pinned_accessor instance(readers, buffer);
+    const auto offset = 42u;
+    instance.increment(offset);
+    BOOST_REQUIRE_EQUAL(instance.buffer(), buffer + offset);
+}
+
+BOOST_AUTO_TEST_CASE(pinned_accessor_destructor__pinned__releases_pin)
+{
+    uint8_t value;
+    std::atomic<size_t> readers(2);
+    {
+        pinned_accessor instance(readers, &value);
+    }
+    BOOST_REQUIRE_EQUAL(readers.load(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <bitcoin/database.hpp>
+#include "../utility/storage.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Record the advised ranges of the fake storage.
+class recording_storage
+  : public test::storage
+{
+public:
+    typedef std::vector<std::pair<file_offset, size_t>> ranges;
+
+    void prefetch(file_offset offset, size_t size)
+    {
+        advised.emplace_back(offset, size);
+    }
+
+    ranges advised;
+};
+
+BOOST_AUTO_TEST_SUITE(prefetcher_tests)
+
+BOOST_AUTO_TEST_CASE(prefetcher__prefetch__empty__none)
+{
+    recording_storage file;
+    prefetcher instance(file);
+    prefetcher::offsets batch;
+    instance.prefetch(batch, 42);
+    BOOST_REQUIRE(file.advised.empty());
+}
+
+BOOST_AUTO_TEST_CASE(prefetcher__prefetch__zero_size__none)
+{
+    recording_storage file;
+    prefetcher instance(file);
+    prefetcher::offsets batch{ 1, 2, 3 };
+    instance.prefetch(batch, 0);
+    BOOST_REQUIRE(file.advised.empty());
+}
+
+BOOST_AUTO_TEST_CASE(prefetcher__prefetch__unordered_nearby__coalesced)
+{
+    recording_storage file;
+    prefetcher instance(file, 100);
+    prefetcher::offsets batch{ 200, 0, 120 };
+    instance.prefetch(batch, 10);
+    BOOST_REQUIRE_EQUAL(file.advised.size(), 1u);
+    BOOST_REQUIRE_EQUAL(file.advised[0].first, 0u);
+    BOOST_REQUIRE_EQUAL(file.advised[0].second, 210u);
+}
+
+BOOST_AUTO_TEST_CASE(prefetcher__prefetch__distant__separate)
+{
+    recording_storage file;
+    prefetcher instance(file, 100);
+    prefetcher::offsets batch{ 1000, 0, 50 };
+    instance.prefetch(batch, 10);
+    BOOST_REQUIRE_EQUAL(file.advised.size(), 2u);
+    BOOST_REQUIRE_EQUAL(file.advised[0].first, 0u);
+    BOOST_REQUIRE_EQUAL(file.advised[0].second, 60u);
+    BOOST_REQUIRE_EQUAL(file.advised[1].first, 1000u);
+    BOOST_REQUIRE_EQUAL(file.advised[1].second, 10u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+
+#include <bitcoin/database.hpp>
+#include "../utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Test directory
+#define DIRECTORY "segmented_storage"
+
+// Segments must be page aligned, this is a multiple of common page sizes.
+static const size_t segment = 64 * 1024;
+static const size_t segments = 4;
+
+struct segmented_storage_directory_setup_fixture
+{
+    segmented_storage_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+        log::initialize();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(segmented_storage_tests, segmented_storage_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(segmented_storage__segment_filename__first__table_file)
+{
+    const segmented_storage::path file = DIRECTORY "/table";
+    BOOST_REQUIRE_EQUAL(segmented_storage::segment_filename(file, 0).string(), file.string());
+    BOOST_REQUIRE_EQUAL(segmented_storage::segment_filename(file, 2).string(), file.string() + ".2");
+}
+
+BOOST_AUTO_TEST_CASE(segmented_storage__open__created_file__one_segment)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    segmented_storage instance(file, segment, segments);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(!instance.open());
+    BOOST_REQUIRE_EQUAL(instance.segments(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.size(), segment);
+    BOOST_REQUIRE_EQUAL(instance.logical_size(), 1u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(segmented_storage__open__missing_file__failure)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    segmented_storage instance(file, segment, segments);
+    BOOST_REQUIRE(!instance.open());
+}
+
+BOOST_AUTO_TEST_CASE(segmented_storage__reserve__beyond_segment__adds_segment_in_place)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    segmented_storage instance(file, segment, segments);
+    BOOST_REQUIRE(instance.open());
+
+    const auto before = instance.access()->buffer();
+    BOOST_REQUIRE(instance.reserve(segment + 42));
+    BOOST_REQUIRE_EQUAL(instance.segments(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u * segment);
+    BOOST_REQUIRE_EQUAL(instance.logical_size(), segment + 42u);
+    BOOST_REQUIRE(instance.access()->buffer() == before);
+    BOOST_REQUIRE(test::exists(file + ".1"));
+    BOOST_REQUIRE_EQUAL(segmented_storage::segment_size(file), segment);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(segmented_storage__reserve__beyond_segments__throws_runtime_error)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    segmented_storage instance(file, segment, segments);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE_THROW(instance.reserve(segments * segment + 1u), std::runtime_error);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(segmented_storage__compress__retained_segments__none)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    segmented_storage instance(file, segment, segments);
+    BOOST_REQUIRE(instance.open());
+    BOOST_REQUIRE(instance.reserve(3u * segment));
+
+    // The first segment is never compressed, and the others are retained.
+    BOOST_REQUIRE_EQUAL(instance.compress(2), 0u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(segmented_storage__close__reopen__expected_across_segments)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    static const std::string data = "spanning";
+    const auto offset = segment - data.size() / 2u;
+    BOOST_REQUIRE(test::create(file));
+
+    segmented_storage writer(file, segment, segments);
+    BOOST_REQUIRE(writer.open());
+    std::memcpy(writer.reserve(3u * segment)->buffer() + offset, data.data(), data.size());
+    BOOST_REQUIRE_EQUAL(writer.segments(), 3u);
+    writer.resize(offset + data.size());
+    BOOST_REQUIRE(writer.close());
+
+    // The last used segment is fit to the logical size, others are removed.
+    BOOST_REQUIRE(test::exists(file + ".1"));
+    BOOST_REQUIRE(!test::exists(file + ".2"));
+    BOOST_REQUIRE_EQUAL(segmented_storage::segment_size(file), segment);
+
+    segmented_storage reader(file, segment, segments);
+    BOOST_REQUIRE(reader.open());
+    BOOST_REQUIRE_EQUAL(reader.logical_size(), offset + data.size());
+    const auto memory = reader.access();
+    BOOST_REQUIRE_EQUAL(std::string(reinterpret_cast<const char*>(memory->buffer() + offset), data.size()), data);
+}
+
+BOOST_AUTO_TEST_CASE(segmented_storage__refresh__read_only__maps_added_segments)
+{
+    static const std::string file = DIRECTORY "/" + TEST_NAME;
+    BOOST_REQUIRE(test::create(file));
+    segmented_storage writer(file, segment, segments);
+    BOOST_REQUIRE(writer.open());
+
+    segmented_storage reader(file, segment, segments, true);
+    BOOST_REQUIRE(reader.open());
+    BOOST_REQUIRE_EQUAL(reader.segments(), 1u);
+
+    writer.reserve(segment + 1u)->buffer()[segment] = 42;
+    BOOST_REQUIRE(reader.refresh());
+    BOOST_REQUIRE_EQUAL(reader.segments(), 2u);
+    BOOST_REQUIRE_EQUAL(reader.access()->buffer()[segment], 42u);
+    BOOST_REQUIRE_THROW(reader.reserve(1), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(parallel_tests)
+
+BOOST_AUTO_TEST_CASE(parallel__parallelism__configured__configured)
+{
+    BOOST_REQUIRE_EQUAL(parallelism(3), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(parallel__parallelism__zero__nonzero)
+{
+    BOOST_REQUIRE_GT(parallelism(0), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(parallel__parallel_for__zero_count__not_called)
+{
+    auto called = false;
+    parallel_for(0, 4, 1, [&](size_t, size_t) { called = true; });
+    BOOST_REQUIRE(!called);
+}
+
+BOOST_AUTO_TEST_CASE(parallel__parallel_for__below_minimum__one_range)
+{
+    size_t calls = 0;
+    parallel_for(10, 4, 100, [&](size_t first, size_t last)
+    {
+        BOOST_REQUIRE_EQUAL(first, 0u);
+        BOOST_REQUIRE_EQUAL(last, 10u);
+        ++calls;
+    });
+
+    BOOST_REQUIRE_EQUAL(calls, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(parallel__parallel_for__threads__covers_each_once)
+{
+    static const size_t count = 1001;
+    std::vector<std::atomic<size_t>> hits(count);
+    std::atomic<size_t> ranges(0);
+
+    for (auto& hit: hits)
+        hit = 0;
+
+    parallel_for(count, 4, 10, [&](size_t first, size_t last)
+    {
+        ++ranges;
+        for (auto index = first; index < last; ++index)
+            ++hits[index];
+    });
+
+    BOOST_REQUIRE_EQUAL(ranges.load(), 4u);
+
+    for (const auto& hit: hits)
+        BOOST_REQUIRE_EQUAL(hit.load(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
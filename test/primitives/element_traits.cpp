@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(element_traits_tests)
+
+typedef element_traits<array_index, hash_digest> block_traits;
+typedef element_traits<file_offset, hash_digest> transaction_traits;
+typedef element_traits<array_index, short_hash> address_traits;
+
+BOOST_AUTO_TEST_CASE(element_traits__offsets__instantiations__expected)
+{
+    BOOST_REQUIRE_EQUAL(block_traits::next_offset, 32u);
+    BOOST_REQUIRE_EQUAL(block_traits::value_offset, 36u);
+    BOOST_REQUIRE_EQUAL(transaction_traits::next_offset, 32u);
+    BOOST_REQUIRE_EQUAL(transaction_traits::value_offset, 40u);
+    BOOST_REQUIRE_EQUAL(address_traits::next_offset, 20u);
+    BOOST_REQUIRE_EQUAL(address_traits::value_offset, 24u);
+    BOOST_REQUIRE_EQUAL(address_traits::size(8), 32u);
+}
+
+BOOST_AUTO_TEST_CASE(element_traits__match__hash_digest__expected)
+{
+    data_chunk element(transaction_traits::size(0), 0x00);
+    auto key = null_hash;
+    BOOST_REQUIRE(transaction_traits::match(element.data(), key));
+
+    // A difference in any word of the key is a mismatch.
+    for (size_t byte = 0; byte < hash_size; ++byte)
+    {
+        key = null_hash;
+        key[byte] = 0x42;
+        BOOST_REQUIRE(!transaction_traits::match(element.data(), key));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(element_traits__match__short_hash__expected)
+{
+    data_chunk element(address_traits::size(0), 0x00);
+    auto key = null_short_hash;
+    BOOST_REQUIRE(address_traits::match(element.data(), key));
+
+    // The link follows the key and is not compared.
+    element[address_traits::next_offset] = 0x42;
+    BOOST_REQUIRE(address_traits::match(element.data(), key));
+
+    for (size_t byte = 0; byte < short_hash_size; ++byte)
+    {
+        key = null_short_hash;
+        key[byte] = 0x42;
+        BOOST_REQUIRE(!address_traits::match(element.data(), key));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(element_traits__match__other_width__expected)
+{
+    typedef std::array<uint8_t, 3> key_type;
+    typedef element_traits<array_index, key_type> traits;
+    data_chunk element{ 1, 2, 3, 0, 0, 0, 0 };
+    BOOST_REQUIRE(traits::match(element.data(), key_type{ { 1, 2, 3 } }));
+    BOOST_REQUIRE(!traits::match(element.data(), key_type{ { 1, 2, 4 } }));
+}
+
+BOOST_AUTO_TEST_CASE(element_traits__write_next__file_offset__little_endian)
+{
+    data_chunk element(transaction_traits::size(0), 0x00);
+    transaction_traits::write_next(element.data(), 0x0807060504030201);
+    BOOST_REQUIRE_EQUAL(element[transaction_traits::next_offset], 0x01);
+    BOOST_REQUIRE_EQUAL(element[transaction_traits::next_offset + 7], 0x08);
+    BOOST_REQUIRE_EQUAL(transaction_traits::read_next(element.data()), 0x0807060504030201u);
+}
+
+BOOST_AUTO_TEST_CASE(element_traits__read_next__array_index__not_found)
+{
+    data_chunk element(block_traits::size(1), 0xff);
+    BOOST_REQUIRE_EQUAL(block_traits::read_next(element.data()), max_uint32);
+    block_traits::write_next(element.data(), 42);
+    BOOST_REQUIRE_EQUAL(block_traits::read_next(element.data()), 42u);
+    BOOST_REQUIRE_EQUAL(element[block_traits::next_offset - 1], 0xff);
+    BOOST_REQUIRE_EQUAL(element[block_traits::value_offset], 0xff);
+}
+
+BOOST_AUTO_TEST_CASE(element_traits__store_next__aligned__round_trips)
+{
+    // The buffer is aligned to the link, and so is the next link offset.
+    std::vector<uint64_t> words(transaction_traits::size(0) /
+        sizeof(uint64_t), 0);
+    const auto element = reinterpret_cast<uint8_t*>(words.data());
+    BOOST_REQUIRE(transaction_traits::atomic_next(element));
+
+    transaction_traits::store_next(element, 0x0807060504030201);
+    BOOST_REQUIRE_EQUAL(transaction_traits::load_next(element), 0x0807060504030201u);
+    BOOST_REQUIRE_EQUAL(transaction_traits::read_next(element), 0x0807060504030201u);
+}
+
+BOOST_AUTO_TEST_CASE(element_traits__atomic_next__misaligned__false)
+{
+    std::vector<uint64_t> words(transaction_traits::size(1) /
+        sizeof(uint64_t) + 1u, 0);
+    const auto element = reinterpret_cast<uint8_t*>(words.data()) + 1;
+    BOOST_REQUIRE(!transaction_traits::atomic_next(element));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,367 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <bitcoin/database.hpp>
+#include "../utility/storage.hpp"
+#include "../utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(hash_index_tests)
+
+BOOST_AUTO_TEST_CASE(hash_index__slots__32_and_64_bit__fill_bucket)
+{
+    typedef test::tiny_hash key_type;
+    typedef hash_index<record_manager<uint32_t>, uint32_t, uint32_t, key_type> index32;
+    typedef hash_index<record_manager<uint64_t>, uint32_t, uint64_t, key_type> index64;
+
+    BOOST_REQUIRE_EQUAL(index32::slots, 10u);
+    BOOST_REQUIRE_EQUAL(index64::slots, 6u);
+    BOOST_REQUIRE_EQUAL(index32::size(10u), 11u * index32::bucket_size);
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__slab__one_element__round_trips)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_index<slab_manager<link_type>, index_type, link_type, key_type> slab_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    slab_map table(file, 100u);
+    BOOST_REQUIRE(table.create());
+    BOOST_REQUIRE(table.start());
+
+    const key_type key{ { 0xde, 0xad, 0xbe, 0xef } };
+
+    const auto writer = [](byte_serializer& serial)
+    {
+        serial.write_byte(110);
+        serial.write_byte(4);
+        serial.write_byte(99);
+    };
+
+    auto element = table.allocator();
+    const auto link = element.create(key, writer, 3);
+    table.link(element);
+
+    const auto reader = [](byte_deserializer& deserial)
+    {
+        BOOST_REQUIRE_EQUAL(deserial.read_byte(), 110u);
+        BOOST_REQUIRE_EQUAL(deserial.read_byte(), 4u);
+        BOOST_REQUIRE_EQUAL(deserial.read_byte(), 99u);
+    };
+
+    const auto const_element = table.find(key);
+    BOOST_REQUIRE(const_element);
+    BOOST_REQUIRE_EQUAL(const_element.link(), link);
+    BOOST_REQUIRE(const_element.match(key));
+    const_element.read(reader);
+    table.commit();
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__record__one_bucket__probes_all_slots)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_index<record_manager<link_type>, index_type, link_type, key_type> record_map;
+
+    // Two buckets force probing into the next bucket.
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 2u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    auto element = table.allocator();
+
+    for (uint8_t value = 0; value < 2 * record_map::slots; ++value)
+    {
+        const key_type key{ { value, 0x00, 0x00, 0x00 } };
+        const auto writer = [value](byte_serializer& serial)
+        {
+            serial.write_byte(value);
+        };
+
+        element.create(key, writer);
+        table.link(element);
+    }
+
+    for (uint8_t value = 0; value < 2 * record_map::slots; ++value)
+    {
+        const key_type key{ { value, 0x00, 0x00, 0x00 } };
+        const auto reader = [value](byte_deserializer& deserial)
+        {
+            BOOST_REQUIRE_EQUAL(deserial.read_byte(), value);
+        };
+
+        const auto const_element = table.find(key);
+        BOOST_REQUIRE(const_element);
+        const_element.read(reader);
+    }
+
+    // The index is full.
+    const key_type key{ { 0xff, 0x00, 0x00, 0x00 } };
+    element.create(key, [](byte_serializer&) {});
+    BOOST_REQUIRE_THROW(table.link(element), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__record__duplicate_key__finds_last)
+{
+    typedef test::little_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint64_t link_type;
+    typedef hash_index<record_manager<link_type>, index_type, link_type, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 2u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    const key_type key1{ { 0xde, 0xad, 0xbe, 0xef, 0xde, 0xad, 0xbe, 0xef } };
+    const key_type key2{ { 0xb0, 0x0b, 0xb0, 0x0b, 0xb0, 0x0b, 0xb0, 0x0b } };
+    const key_type invalid{ { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 } };
+    const auto writer = [](byte_serializer&) {};
+
+    auto element = table.allocator();
+    element.create(key1, writer);
+    table.link(element);
+    const auto link2 = element.create(key2, writer);
+    table.link(element);
+    const auto link3 = element.create(key2, writer);
+    table.link(element);
+
+    BOOST_REQUIRE(!table.find(invalid));
+    BOOST_REQUIRE_EQUAL(table.find(key2).link(), link3);
+
+    BOOST_REQUIRE(table.unlink(key1));
+    BOOST_REQUIRE(!table.unlink(key1));
+    BOOST_REQUIRE(table.unlink(key2));
+    BOOST_REQUIRE(!table.unlink(invalid));
+
+    // The removed slots do not terminate probing.
+    BOOST_REQUIRE(!table.find(key1));
+    BOOST_REQUIRE(table.find(link3));
+    BOOST_REQUIRE_EQUAL(table.find(key2).link(), link2);
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__record__bulk_link__finds_all)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_index<record_manager<link_type>, index_type, link_type, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 10u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    auto link = table.allocate(16u);
+    std::vector<record_map::value_type> elements;
+
+    for (uint8_t value = 0; value < 16; ++value)
+    {
+        const key_type key{ { value, 0x00, 0x00, value } };
+        const auto writer = [value](byte_serializer& serial)
+        {
+            serial.write_byte(value);
+        };
+
+        auto element = table.allocator();
+        BOOST_REQUIRE_EQUAL(element.create(link, key, writer), link);
+        elements.push_back(element);
+        ++link;
+    }
+
+    table.link(elements);
+
+    for (uint8_t value = 0; value < 16; ++value)
+    {
+        const key_type key{ { value, 0x00, 0x00, value } };
+        const auto reader = [value](byte_deserializer& deserial)
+        {
+            BOOST_REQUIRE_EQUAL(deserial.read_byte(), value);
+        };
+
+        const auto const_element = table.find(key);
+        BOOST_REQUIRE(const_element);
+        const_element.read(reader);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__record__full_bucket__probes_next_bucket)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_index<record_manager<link_type>, index_type, link_type, key_type> record_map;
+    typedef hash_table_header<index_type, link_type> header;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 4u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    // Keys of the first bucket, one more than its slots and one not linked.
+    std::vector<key_type> keys;
+    for (uint32_t value = 0; keys.size() < record_map::slots + 2u; ++value)
+    {
+        const key_type key{ { uint8_t(value), uint8_t(value >> 8), 0x00,
+            0x00 } };
+
+        if (header::remainder(key, 4u) == 0u)
+            keys.push_back(key);
+    }
+
+    auto element = table.allocator();
+    for (size_t index = 0; index <= record_map::slots; ++index)
+    {
+        const auto value = static_cast<uint8_t>(index);
+        element.create(keys[index], [value](byte_serializer& serial)
+        {
+            serial.write_byte(value);
+        });
+
+        table.link(element);
+    }
+
+    // The last key overflows the full bucket into the next.
+    for (size_t index = 0; index <= record_map::slots; ++index)
+    {
+        const auto value = static_cast<uint8_t>(index);
+        const auto const_element = table.find(keys[index]);
+        BOOST_REQUIRE(const_element);
+        const_element.read([value](byte_deserializer& deserial)
+        {
+            BOOST_REQUIRE_EQUAL(deserial.read_byte(), value);
+        });
+    }
+
+    BOOST_REQUIRE(!table.find(keys.back()));
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__record__fingerprint_of_other_key__not_found)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_index<record_manager<link_type>, index_type, link_type, key_type> record_map;
+    typedef hash_table_header<index_type, link_type> header;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 1u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    // Another key of the same fingerprint (16 bits, so one is near).
+    const key_type key{ { 0xde, 0xad, 0xbe, 0xef } };
+    const auto fingerprint = header::fingerprint(key);
+    key_type other = key;
+
+    for (uint32_t value = 0; value <= max_uint16 * 64u; ++value)
+    {
+        const key_type candidate{ { uint8_t(value), uint8_t(value >> 8),
+            uint8_t(value >> 16), 0x00 } };
+
+        if (candidate != key && header::fingerprint(candidate) == fingerprint)
+        {
+            other = candidate;
+            break;
+        }
+    }
+
+    BOOST_REQUIRE(other != key);
+
+    auto element = table.allocator();
+    const auto link = element.create(key, [](byte_serializer&) {});
+    table.link(element);
+
+    // The fingerprint matches, but the element is not of the key.
+    BOOST_REQUIRE(!table.find(other));
+    BOOST_REQUIRE(!table.unlink(other));
+    BOOST_REQUIRE_EQUAL(table.find(key).link(), link);
+
+    const auto other_link = element.create(other, [](byte_serializer&) {});
+    table.link(element);
+    BOOST_REQUIRE_EQUAL(table.find(other).link(), other_link);
+    BOOST_REQUIRE_EQUAL(table.find(key).link(), link);
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__start__other_bucket_count__failure)
+{
+    typedef test::tiny_hash key_type;
+    typedef hash_index<record_manager<uint32_t>, uint32_t, uint32_t, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table1(file, 10u, 1u);
+    BOOST_REQUIRE(table1.create());
+    BOOST_REQUIRE(table1.start());
+
+    record_map table2(file, 11u, 1u);
+    BOOST_REQUIRE(!table2.start());
+}
+
+BOOST_AUTO_TEST_CASE(hash_index__rebuild__unlinked_elements__finds_all)
+{
+    typedef test::tiny_hash key_type;
+    typedef hash_index<record_manager<uint32_t>, uint32_t, uint32_t, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 10u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    // Elements stored but not linked (as of an unclean shutdown).
+    for (uint8_t value = 0; value < 16; ++value)
+    {
+        const key_type key{ { value, 0x00, 0x00, value } };
+        const auto writer = [value](byte_serializer& serial)
+        {
+            serial.write_byte(value);
+        };
+
+        auto element = table.allocator();
+        element.create(key, writer);
+    }
+
+    const key_type first{ { 0x00, 0x00, 0x00, 0x00 } };
+    BOOST_REQUIRE(!table.find(first));
+    BOOST_REQUIRE(table.contains(15u));
+    BOOST_REQUIRE(!table.contains(16u));
+
+    table.rebuild();
+
+    for (uint8_t value = 0; value < 16; ++value)
+    {
+        const key_type key{ { value, 0x00, 0x00, value } };
+        const auto const_element = table.find(key);
+        BOOST_REQUIRE(const_element);
+        BOOST_REQUIRE_EQUAL(const_element.link(), value);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -18,6 +18,9 @@
  */
 #include <boost/test/unit_test.hpp>
 
+#include <cstddef>
+#include <thread>
+#include <vector>
 #include <bitcoin/database.hpp>
 #include "../utility/storage.hpp"
 #include "../utility/utility.hpp"
@@ -344,4 +347,328 @@ BOOST_AUTO_TEST_CASE(hash_table__record__multiple_elements_64_bit__round_trips)
     const_element.read(reader);
 }
 
+BOOST_AUTO_TEST_CASE(hash_table__record__growth__splits_and_finds_all)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_table<record_manager<link_type>, index_type, link_type, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 3u, 1u);
+    BOOST_REQUIRE(table.create());
+    table.enable_growth(100);
+
+    auto element = table.allocator();
+
+    for (uint16_t value = 0; value < 500; ++value)
+    {
+        const key_type key{ { uint8_t(value), uint8_t(value >> 8), 0x42, 0x42 } };
+        element.create(key, [value](byte_serializer& serial)
+        {
+            serial.write_byte(uint8_t(value));
+        });
+
+        table.link(element);
+    }
+
+    // Elements do not exceed buckets by more than the one being split.
+    BOOST_REQUIRE_GE(table.buckets(), 500u);
+    BOOST_REQUIRE_LE(table.load_factor(), 1.0f);
+
+    // Commit and restart to verify that the growth state persists.
+    table.commit();
+    record_map restarted(file, 3u, 1u);
+    BOOST_REQUIRE(restarted.start());
+    BOOST_REQUIRE_EQUAL(restarted.buckets(), table.buckets());
+
+    for (uint16_t value = 0; value < 500; ++value)
+    {
+        const key_type key{ { uint8_t(value), uint8_t(value >> 8), 0x42, 0x42 } };
+        const auto found = restarted.find(key);
+        BOOST_REQUIRE(found);
+        found.read([value](byte_deserializer& deserial)
+        {
+            BOOST_REQUIRE_EQUAL(deserial.read_byte(), uint8_t(value));
+        });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_table__record__bucket__within_buckets)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_table<record_manager<link_type>, index_type, link_type, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 3u, 1u);
+    BOOST_REQUIRE(table.create());
+    table.enable_growth(100);
+
+    auto element = table.allocator();
+
+    for (uint16_t value = 0; value < 100; ++value)
+    {
+        const key_type key{ { uint8_t(value), 0x00, 0x42, 0x42 } };
+        element.create(key, [value](byte_serializer& serial)
+        {
+            serial.write_byte(uint8_t(value));
+        });
+
+        table.link(element);
+    }
+
+    for (uint16_t value = 0; value < 100; ++value)
+    {
+        const key_type key{ { uint8_t(value), 0x00, 0x42, 0x42 } };
+        BOOST_REQUIRE_LT(table.bucket(key), table.buckets());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_table__slab__growth_unlink__expected)
+{
+    typedef test::little_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint64_t link_type;
+    typedef hash_table<slab_manager<link_type>, index_type, link_type, key_type> slab_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    slab_map table(file, 1u);
+    BOOST_REQUIRE(table.create());
+    table.enable_growth(200);
+
+    auto element = table.allocator();
+    const auto writer = [](byte_serializer& serial) { serial.write_byte(42); };
+
+    for (uint8_t value = 0; value < 64; ++value)
+    {
+        const key_type key{ { value, 0, 0, 0, 0, 0, 0, value } };
+        element.create(key, writer, 1);
+        table.link(element);
+    }
+
+    BOOST_REQUIRE_EQUAL(table.buckets(), 32u);
+
+    for (uint8_t value = 0; value < 64; value += 2)
+    {
+        const key_type key{ { value, 0, 0, 0, 0, 0, 0, value } };
+        BOOST_REQUIRE(table.unlink(key));
+    }
+
+    BOOST_REQUIRE_EQUAL(table.load_factor(), 1.0f);
+
+    for (uint8_t value = 0; value < 64; ++value)
+    {
+        const key_type key{ { value, 0, 0, 0, 0, 0, 0, value } };
+        BOOST_REQUIRE_EQUAL(bool(table.find(key)), (value % 2) != 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_table__slab__bulk_link__finds_all)
+{
+    typedef test::little_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint64_t link_type;
+    typedef hash_table<slab_manager<link_type>, index_type, link_type, key_type> slab_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    slab_map table(file, 10u);
+    BOOST_REQUIRE(table.create());
+
+    const auto element_size = slab_map::value_type::size(1);
+    auto link = table.allocate(element_size * 16u);
+    std::vector<slab_map::value_type> elements;
+
+    for (uint8_t value = 0; value < 16; ++value)
+    {
+        const key_type key{ { value, 0, 0, 0, 0, 0, 0, value } };
+        const auto writer = [=](byte_serializer& serial)
+        {
+            serial.write_byte(value);
+        };
+
+        auto element = table.allocator();
+        BOOST_REQUIRE_EQUAL(element.create(link, key, writer), link);
+        elements.push_back(element);
+        link += element_size;
+    }
+
+    table.link(elements);
+
+    for (uint8_t value = 0; value < 16; ++value)
+    {
+        const key_type key{ { value, 0, 0, 0, 0, 0, 0, value } };
+        const auto element = table.find(key);
+        BOOST_REQUIRE(element);
+        element.read([=](byte_deserializer& deserial)
+        {
+            BOOST_REQUIRE_EQUAL(deserial.read_byte(), value);
+        });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_table__record__concurrent_link__counts_and_finds_all)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef hash_table<record_manager<link_type>, index_type, link_type, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 1000u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    const size_t threads = 4;
+    const size_t elements = 500;
+    std::vector<std::thread> writers;
+
+    // Writers of distinct buckets share only the (lock free) element count.
+    for (size_t thread = 0; thread < threads; ++thread)
+        writers.emplace_back([&, thread]()
+        {
+            auto element = table.allocator();
+
+            for (size_t value = 0; value < elements; ++value)
+            {
+                const key_type key{ { uint8_t(thread), uint8_t(value),
+                    uint8_t(value >> 8), 0x42 } };
+
+                element.create(key, [value](byte_serializer& serial)
+                {
+                    serial.write_byte(uint8_t(value));
+                });
+
+                table.link(element);
+            }
+        });
+
+    for (auto& writer: writers)
+        writer.join();
+
+    BOOST_REQUIRE_EQUAL(table.count(), threads * elements);
+
+    for (size_t thread = 0; thread < threads; ++thread)
+    {
+        for (size_t value = 0; value < elements; ++value)
+        {
+            const key_type key{ { uint8_t(thread), uint8_t(value),
+                uint8_t(value >> 8), 0x42 } };
+
+            BOOST_REQUIRE(table.find(key));
+        }
+    }
+
+    // The count is written to the file by commit.
+    table.commit();
+    record_map restarted(file, 1000u, 1u);
+    BOOST_REQUIRE(restarted.start());
+    BOOST_REQUIRE_EQUAL(restarted.count(), threads * elements);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table__record__walk__visits_all)
+{
+    typedef test::little_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef record_manager<link_type> manager_type;
+    typedef hash_table<manager_type, index_type, link_type, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 3u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    auto element = table.allocator();
+    const auto writer = [](byte_serializer& serial) { serial.write_byte(42); };
+
+    for (uint8_t value = 0; value < 10; ++value)
+    {
+        const key_type key{ { value, 0, 0, 0, 0, 0, 0, 0 } };
+        element.create(key, writer);
+        table.link(element);
+    }
+
+    size_t sum = 0;
+    size_t visits = 0;
+    table.walk([&](const key_type& key)
+    {
+        sum += key[0];
+        ++visits;
+    });
+
+    BOOST_REQUIRE_EQUAL(table.count(), 10u);
+    BOOST_REQUIRE_EQUAL(visits, 10u);
+    BOOST_REQUIRE_EQUAL(sum, 45u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table__repair__link_beyond_elements__cut)
+{
+    typedef test::tiny_hash key_type;
+    typedef hash_table<record_manager<uint32_t>, uint32_t, uint32_t, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 1u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    const key_type key1{ { 0x01, 0x02, 0x03, 0x04 } };
+    const key_type key2{ { 0x05, 0x06, 0x07, 0x08 } };
+    const auto writer = [](byte_serializer& serial) { serial.write_byte(42); };
+
+    auto element1 = table.allocator();
+    element1.create(key1, writer);
+    table.link(element1);
+    auto element2 = table.allocator();
+    element2.create(key2, writer);
+    table.link(element2);
+
+    // The end of the chain links beyond the elements.
+    element1.set_next(42u);
+
+    size_t cut;
+    BOOST_REQUIRE(table.repair(cut));
+    BOOST_REQUIRE_EQUAL(cut, 1u);
+    BOOST_REQUIRE_EQUAL(table.count(), 2u);
+    BOOST_REQUIRE(table.find(key2));
+    BOOST_REQUIRE(table.find(key1));
+    BOOST_REQUIRE_EQUAL(table.find(key1).next(), record_map::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table__repair__cycle__cut)
+{
+    typedef test::tiny_hash key_type;
+    typedef hash_table<record_manager<uint32_t>, uint32_t, uint32_t, key_type> record_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    record_map table(file, 1u, 1u);
+    BOOST_REQUIRE(table.create());
+
+    const key_type key1{ { 0x01, 0x02, 0x03, 0x04 } };
+    const key_type key2{ { 0x05, 0x06, 0x07, 0x08 } };
+    const auto writer = [](byte_serializer& serial) { serial.write_byte(42); };
+
+    auto element1 = table.allocator();
+    element1.create(key1, writer);
+    table.link(element1);
+    auto element2 = table.allocator();
+    const auto link2 = element2.create(key2, writer);
+    table.link(element2);
+
+    // The end of the chain links back to its start.
+    element1.set_next(link2);
+
+    size_t cut;
+    BOOST_REQUIRE(table.repair(cut));
+    BOOST_REQUIRE_EQUAL(cut, 1u);
+    BOOST_REQUIRE_EQUAL(table.count(), 2u);
+    BOOST_REQUIRE_EQUAL(table.find(key1).next(), record_map::not_found);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
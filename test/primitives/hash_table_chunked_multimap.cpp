@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <bitcoin/database.hpp>
+#include "../utility/storage.hpp"
+#include "../utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+typedef test::tiny_hash key_type;
+typedef hash_table_chunked_multimap<uint32_t, uint32_t, key_type>
+    record_multimap;
+typedef record_multimap::table record_map;
+typedef record_multimap::manager slab_type;
+
+static const key_type key1{ { 0xde, 0xad, 0xbe, 0xef } };
+static const key_type key2{ { 0xba, 0xad, 0xf0, 0x0d } };
+
+// Values of the key newest first.
+static std::vector<uint8_t> values(const record_multimap& multimap,
+    const key_type& key)
+{
+    std::vector<uint8_t> out;
+    for (auto it = multimap.find(key); it; it.jump_next())
+    {
+        it.read([&](byte_deserializer& deserial)
+        {
+            out.push_back(deserial.read_byte());
+        });
+    }
+
+    return out;
+}
+
+// Link count values to the key, continuing from the given value.
+static void link_values(record_multimap& multimap, const key_type& key,
+    size_t count, uint8_t first)
+{
+    multimap.link(key, count, [=](byte_serializer& serial, size_t index)
+    {
+        serial.write_byte(static_cast<uint8_t>(first + index));
+    });
+}
+
+BOOST_AUTO_TEST_SUITE(hash_table_chunked_multimap_tests)
+
+BOOST_AUTO_TEST_CASE(hash_table_chunked_multimap__link__across_chunks__newest_first)
+{
+    test::storage table_file;
+    BOOST_REQUIRE(table_file.open());
+    record_map table(table_file, 10u, sizeof(file_offset));
+    BOOST_REQUIRE(table.create());
+
+    test::storage rows_file;
+    BOOST_REQUIRE(rows_file.open());
+    slab_type rows(rows_file, 0);
+    BOOST_REQUIRE(rows.create());
+    record_multimap multimap(table, rows, 1u);
+
+    BOOST_REQUIRE(!multimap.find(key1));
+    BOOST_REQUIRE(!multimap.unlink(key1));
+
+    // Singly and in batches spanning chunks of growing capacity.
+    size_t count = 0;
+    for (const auto batch: { 1u, 1u, 3u, 20u, 15u })
+    {
+        link_values(multimap, key1, batch, static_cast<uint8_t>(count));
+        count += batch;
+    }
+
+    link_values(multimap, key2, 2, 100);
+
+    const auto result = values(multimap, key1);
+    BOOST_REQUIRE_EQUAL(result.size(), count);
+
+    for (size_t index = 0; index < count; ++index)
+        BOOST_REQUIRE_EQUAL(result[index], count - index - 1u);
+
+    const auto other = values(multimap, key2);
+    BOOST_REQUIRE_EQUAL(other.size(), 2u);
+    BOOST_REQUIRE_EQUAL(other[0], 101u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_chunked_multimap__unlink__newest__removed_and_refilled)
+{
+    test::storage table_file;
+    BOOST_REQUIRE(table_file.open());
+    record_map table(table_file, 10u, sizeof(file_offset));
+    BOOST_REQUIRE(table.create());
+
+    test::storage rows_file;
+    BOOST_REQUIRE(rows_file.open());
+    slab_type rows(rows_file, 0);
+    BOOST_REQUIRE(rows.create());
+    record_multimap multimap(table, rows, 1u);
+
+    link_values(multimap, key1, 1, 0);
+    link_values(multimap, key1, 3, 1);
+
+    // Empties the newest chunk (1, 2, 3) and then the first (0).
+    BOOST_REQUIRE(multimap.unlink(key1));
+    BOOST_REQUIRE_EQUAL(values(multimap, key1).size(), 3u);
+    BOOST_REQUIRE(multimap.unlink(key1));
+    BOOST_REQUIRE(multimap.unlink(key1));
+    BOOST_REQUIRE_EQUAL(values(multimap, key1).front(), 0u);
+
+    // Fills the free rows again.
+    link_values(multimap, key1, 2, 7);
+    auto result = values(multimap, key1);
+    BOOST_REQUIRE_EQUAL(result.size(), 3u);
+    BOOST_REQUIRE_EQUAL(result[0], 8u);
+    BOOST_REQUIRE_EQUAL(result[2], 0u);
+
+    BOOST_REQUIRE(multimap.unlink(key1));
+    BOOST_REQUIRE(multimap.unlink(key1));
+    BOOST_REQUIRE(multimap.unlink(key1));
+    BOOST_REQUIRE(!multimap.find(key1));
+    BOOST_REQUIRE(!multimap.unlink(key1));
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_chunked_multimap__element__position__resumes)
+{
+    test::storage table_file;
+    BOOST_REQUIRE(table_file.open());
+    record_map table(table_file, 10u, sizeof(file_offset));
+    BOOST_REQUIRE(table.create());
+
+    test::storage rows_file;
+    BOOST_REQUIRE(rows_file.open());
+    slab_type rows(rows_file, 0);
+    BOOST_REQUIRE(rows.create());
+    record_multimap multimap(table, rows, 1u);
+
+    link_values(multimap, key1, 40, 0);
+
+    auto it = multimap.find(key1);
+    for (size_t index = 0; index < 20; ++index)
+        it.jump_next();
+
+    auto resumed = multimap.element(it.position());
+    BOOST_REQUIRE(resumed == it);
+
+    uint8_t value = 0;
+    resumed.read([&](byte_deserializer& deserial)
+    {
+        value = deserial.read_byte();
+    });
+
+    BOOST_REQUIRE_EQUAL(value, 19u);
+    BOOST_REQUIRE(!multimap.element(it.terminator().position()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
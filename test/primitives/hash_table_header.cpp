@@ -36,7 +36,8 @@ BOOST_AUTO_TEST_CASE(hash_table_header__size__always__expected)
 
     test::storage file;
     const auto buckets = 42u;
-    const auto expected = sizeof(index_type) + sizeof(link_type) * buckets;
+    const auto expected = 4 * sizeof(index_type) + sizeof(uint64_t) +
+        sizeof(link_type) * (header_type::segments + buckets);
     header_type header(file, buckets);
     BOOST_REQUIRE_EQUAL(header.size(), expected);
 }
@@ -68,6 +69,22 @@ BOOST_AUTO_TEST_CASE(hash_table_header__create__always__sets_bucket_count)
     BOOST_REQUIRE_EQUAL(deserial.template read_little_endian<index_type>(), expected);
 }
 
+BOOST_AUTO_TEST_CASE(hash_table_header__create__always__sets_version)
+{
+    typedef uint32_t index_type;
+    typedef uint64_t link_type;
+    typedef hash_table_header<index_type, link_type> header_type;
+
+    test::storage file;
+    header_type header(file, 42u);
+    BOOST_REQUIRE(file.open());
+    BOOST_REQUIRE(header.create());
+
+    auto deserial = make_unsafe_deserializer(file.access()->buffer());
+    deserial.skip(sizeof(index_type));
+    BOOST_REQUIRE_EQUAL(deserial.template read_little_endian<index_type>(), header_type::version);
+}
+
 BOOST_AUTO_TEST_CASE(hash_table_header__create__always__fills_empty_buckets)
 {
     typedef uint32_t index_type;
@@ -79,10 +96,47 @@ BOOST_AUTO_TEST_CASE(hash_table_header__create__always__fills_empty_buckets)
     BOOST_REQUIRE(file.open());
     BOOST_REQUIRE(header.create());
 
+    // Empty rows are stored as zero, so a new file may be sparse.
     const auto buffer = file.access()->buffer();
-    const auto start = buffer + sizeof(index_type);
-    const auto empty = [](uint8_t byte) { return byte == (uint8_t)header_type::empty; };
-    BOOST_REQUIRE(std::all_of(start, buffer + header.size(), empty));
+    const auto start = buffer + header.size() - sizeof(link_type) * 10u;
+    const auto zero = [](uint8_t byte) { return byte == 0x00; };
+    BOOST_REQUIRE(std::all_of(start, buffer + header.size(), zero));
+
+    for (index_type index = 0; index < 10u; ++index)
+        BOOST_REQUIRE_EQUAL(header.read(index), header_type::empty);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_header__create__written_file__clears_rows)
+{
+    typedef uint32_t index_type;
+    typedef uint64_t link_type;
+    typedef hash_table_header<index_type, link_type> header_type;
+
+    test::storage file(data_chunk(header_type::size(10u), 0x42));
+    header_type header(file, 10u);
+    BOOST_REQUIRE(file.open());
+    BOOST_REQUIRE(header.create());
+
+    for (index_type index = 0; index < 10u; ++index)
+        BOOST_REQUIRE_EQUAL(header.read(index), header_type::empty);
+
+    for (size_t segment = 1; segment <= header_type::segments; ++segment)
+        BOOST_REQUIRE_EQUAL(header.segment(segment), header_type::empty);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_header__write__read__expected)
+{
+    typedef uint32_t index_type;
+    typedef uint64_t link_type;
+    typedef hash_table_header<index_type, link_type> header_type;
+
+    test::storage file;
+    header_type header(file, 10u);
+    BOOST_REQUIRE(file.open());
+    BOOST_REQUIRE(header.create());
+    header.write(3u, 42u);
+    BOOST_REQUIRE_EQUAL(header.read(3u), 42u);
+    BOOST_REQUIRE_EQUAL(header.read(4u), header_type::empty);
 }
 
 BOOST_AUTO_TEST_CASE(hash_table_header__start__default_file__success)
@@ -94,6 +148,20 @@ BOOST_AUTO_TEST_CASE(hash_table_header__start__default_file__success)
     BOOST_REQUIRE(header.start());
 }
 
+BOOST_AUTO_TEST_CASE(hash_table_header__start__other_version__failure)
+{
+    typedef uint32_t index_type;
+    test::storage file;
+    hash_table_header<index_type, uint32_t> header(file, 10u);
+    BOOST_REQUIRE(file.open());
+    BOOST_REQUIRE(header.create());
+
+    auto serial = make_unsafe_serializer(file.access()->buffer());
+    serial.skip(sizeof(index_type));
+    serial.template write_little_endian<index_type>(0);
+    BOOST_REQUIRE(!header.start());
+}
+
 BOOST_AUTO_TEST_CASE(hash_table_header__start__undersized_file__failure)
 {
     test::storage file;
@@ -147,7 +215,8 @@ BOOST_AUTO_TEST_CASE(hash_table_header__size1__32bit__expected)
     typedef hash_table_header<index_type, link_type> header_type;
 
     const auto buckets = 10u;
-    const auto expected = sizeof(index_type) + sizeof(link_type) * buckets;
+    const auto expected = 4 * sizeof(index_type) + sizeof(uint64_t) +
+        sizeof(link_type) * (header_type::segments + buckets);
     BOOST_REQUIRE_EQUAL(header_type::size(buckets), expected);
 }
 
@@ -158,7 +227,8 @@ BOOST_AUTO_TEST_CASE(hash_table_header__size1__8bit_and_64bit__expected)
     typedef hash_table_header<index_type, link_type> header_type;
 
     const auto buckets = 10u;
-    const auto expected = sizeof(index_type) + sizeof(link_type) * buckets;
+    const auto expected = 4 * sizeof(index_type) + sizeof(uint64_t) +
+        sizeof(link_type) * (header_type::segments + buckets);
     BOOST_REQUIRE_EQUAL(header_type::size(buckets), expected);
 }
 
@@ -170,7 +240,8 @@ BOOST_AUTO_TEST_CASE(hash_table_header__size2__default__expected)
 
     test::storage file;
     const auto buckets = 10u;
-    const auto expected = sizeof(index_type) + sizeof(link_type) * buckets;
+    const auto expected = 4 * sizeof(index_type) + sizeof(uint64_t) +
+        sizeof(link_type) * (header_type::segments + buckets);
     header_type header(file, buckets);
     BOOST_REQUIRE_EQUAL(header.size(), expected);
 }
@@ -183,7 +254,8 @@ BOOST_AUTO_TEST_CASE(hash_table_header__size2__create__expected)
 
     test::storage file;
     const auto buckets = 10u;
-    const auto expected = sizeof(index_type) + sizeof(link_type) * buckets;
+    const auto expected = 4 * sizeof(index_type) + sizeof(uint64_t) +
+        sizeof(link_type) * (header_type::segments + buckets);
     header_type header(file, buckets);
     BOOST_REQUIRE(header.create());
     BOOST_REQUIRE_EQUAL(header.size(), expected);
@@ -215,4 +287,81 @@ BOOST_AUTO_TEST_CASE(hash_table_header__read_write__64_bit_value__success)
     BOOST_REQUIRE_EQUAL(header.read(0), 24u);
 }
 
+BOOST_AUTO_TEST_CASE(hash_table_header__remainder__hash_digest__stable)
+{
+    typedef hash_table_header<uint32_t, uint32_t> header_type;
+    const hash_digest key
+    {
+        {
+            0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+            0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+            0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+            0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20
+        }
+    };
+
+    // The bucket must not vary by platform or standard library.
+    BOOST_REQUIRE_EQUAL(header_type::remainder(key, 1000u), 657u);
+    BOOST_REQUIRE_EQUAL(header_type::remainder(key, 0u), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_header__remainder__short_hash__within_divisor)
+{
+    typedef hash_table_header<uint32_t, uint32_t> header_type;
+    short_hash key{};
+
+    for (uint8_t byte = 0; byte < 100; ++byte)
+    {
+        key[0] = byte;
+        BOOST_REQUIRE_LT(header_type::remainder(key, 7u), 7u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_header__stripe__adjacent_buckets__distinct)
+{
+    typedef hash_table_header<uint32_t, uint32_t> header_type;
+    BOOST_REQUIRE_NE(header_type::stripe(0u), header_type::stripe(1u));
+    BOOST_REQUIRE_EQUAL(header_type::stripe(0u),
+        header_type::stripe(header_type::stripes));
+    BOOST_REQUIRE_LT(header_type::stripe(max_uint32), header_type::stripes);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_header__increase_count__decrease_count__expected)
+{
+    test::storage file;
+    hash_table_header<uint32_t, uint32_t> header(file, 10u);
+    BOOST_REQUIRE(file.open());
+    BOOST_REQUIRE(header.create());
+
+    header.increase_count(5u);
+    header.increase_count(1u);
+    header.decrease_count(2u);
+    BOOST_REQUIRE_EQUAL(header.count(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_table_header__commit__restart__count_persisted)
+{
+    test::storage file;
+    hash_table_header<uint32_t, uint32_t> header(file, 10u);
+    BOOST_REQUIRE(file.open());
+    BOOST_REQUIRE(header.create());
+
+    // The growth state is written with the count as of its change.
+    header.increase_count(5u);
+    header.set_growth(1u, 2u);
+
+    // The count is otherwise not written until commit.
+    header.increase_count(2u);
+    hash_table_header<uint32_t, uint32_t> stale(file, 10u);
+    BOOST_REQUIRE(stale.start());
+    BOOST_REQUIRE_EQUAL(stale.count(), 5u);
+
+    header.commit();
+    hash_table_header<uint32_t, uint32_t> restarted(file, 10u);
+    BOOST_REQUIRE(restarted.start());
+    BOOST_REQUIRE_EQUAL(restarted.count(), 7u);
+    BOOST_REQUIRE_EQUAL(restarted.level(), 1u);
+    BOOST_REQUIRE_EQUAL(restarted.split(), 2u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -74,4 +74,62 @@ BOOST_AUTO_TEST_CASE(hash_table_multimap__construct__always__expected)
     BOOST_REQUIRE(!multimap.find(key));
 }
 
+BOOST_AUTO_TEST_CASE(hash_table_multimap__link__chain__newest_first)
+{
+    typedef test::tiny_hash key_type;
+    typedef uint32_t index_type;
+    typedef uint32_t link_type;
+    typedef record_manager<link_type> record_manager;
+    typedef hash_table<record_manager, index_type, link_type, key_type> record_map;
+    typedef hash_table_multimap<index_type, link_type, key_type> record_multimap;
+
+    const auto value_size = 1u;
+    const key_type key{ { 0xde, 0xad, 0xbe, 0xef } };
+
+    test::storage hash_table_file;
+    BOOST_REQUIRE(hash_table_file.open());
+    record_map table(hash_table_file, 100u, sizeof(link_type));
+    BOOST_REQUIRE(table.create());
+
+    test::storage index_file;
+    BOOST_REQUIRE(index_file.open());
+    record_manager index(index_file, 0, record_multimap::size(value_size));
+    record_multimap multimap(table, index);
+
+    const auto writer = [](uint8_t value)
+    {
+        return [=](byte_serializer& serial)
+        {
+            serial.write_byte(value);
+        };
+    };
+
+    // Link one element, then a chain of two allocated together.
+    auto element = multimap.allocator();
+    element.create(writer(1));
+    multimap.link(key, element);
+
+    const auto start = index.allocate(2);
+    auto second = multimap.allocator();
+    auto third = multimap.allocator();
+    second.create(start, empty_key{}, writer(2));
+    third.create(start + 1u, empty_key{}, writer(3));
+    third.set_next(second.link());
+    multimap.link(key, third, second);
+
+    std::vector<uint8_t> values;
+    for (auto it = multimap.find(key); it; it.jump_next())
+    {
+        it.read([&](byte_deserializer& deserial)
+        {
+            values.push_back(deserial.read_byte());
+        });
+    }
+
+    BOOST_REQUIRE_EQUAL(values.size(), 3u);
+    BOOST_REQUIRE_EQUAL(values[0], 3u);
+    BOOST_REQUIRE_EQUAL(values[1], 2u);
+    BOOST_REQUIRE_EQUAL(values[2], 1u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -18,6 +18,7 @@
  */
 #include <boost/test/unit_test.hpp>
 #include <bitcoin/database.hpp>
+#include "../utility/storage.hpp"
 
 using namespace bc;
 using namespace bc::database;
@@ -29,4 +30,43 @@ BOOST_AUTO_TEST_CASE(list_element__method__vector__expectation)
     BOOST_REQUIRE(true);
 }
 
+BOOST_AUTO_TEST_CASE(list_element__write_little_endian__offsets__read_expected)
+{
+    typedef uint32_t link_type;
+    typedef hash_digest key_type;
+    typedef record_manager<link_type> manager_type;
+    typedef list_element<manager_type, link_type, key_type> element_type;
+    const auto value_size = sizeof(uint32_t) + sizeof(uint8_t);
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    manager_type manager(file, 0, element_type::size(value_size));
+    BOOST_REQUIRE(manager.create());
+    BOOST_REQUIRE(manager.start());
+
+    shared_mutex mutex;
+    element_type element(manager, mutex);
+    element.create(null_hash, [](byte_serializer& serial)
+    {
+        serial.write_4_bytes_little_endian(0);
+        serial.write_byte(0);
+    });
+
+    element.write_little_endian(0, uint32_t(42));
+    element.write_little_endian(sizeof(uint32_t), uint8_t(7));
+    BOOST_REQUIRE_EQUAL(element.read_little_endian<uint32_t>(0), 42u);
+    BOOST_REQUIRE_EQUAL(element.read_little_endian<uint8_t>(sizeof(uint32_t)), 7u);
+
+    uint32_t height;
+    uint8_t state;
+    element.read([&](byte_deserializer& deserial)
+    {
+        height = deserial.read_4_bytes_little_endian();
+        state = deserial.read_byte();
+    });
+
+    BOOST_REQUIRE_EQUAL(height, 42u);
+    BOOST_REQUIRE_EQUAL(state, 7u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -168,4 +168,62 @@ BOOST_AUTO_TEST_CASE(record_manager__get__read_write__expected)
     memory.reset();
 }
 
+BOOST_AUTO_TEST_CASE(record_manager__allocate__within_mapped_file__reserved_on_commit)
+{
+    typedef uint32_t link_type;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+
+    const auto record_size = 10u;
+    const auto link_size = sizeof(link_type);
+    record_manager<link_type> manager(file, 0, record_size);
+    BOOST_REQUIRE(manager.create());
+
+    // Map more than the records, so that allocation does not grow the file.
+    BOOST_REQUIRE(file.resize(1000));
+    BOOST_REQUIRE(manager.start());
+
+    BOOST_REQUIRE_EQUAL(manager.allocate(10), 0u);
+    BOOST_REQUIRE_EQUAL(manager.allocate(20), 10u);
+    BOOST_REQUIRE_EQUAL(file.size(), 1000u);
+
+    // Growth beyond the mapped file is reserved at allocation.
+    BOOST_REQUIRE_EQUAL(manager.allocate(100), 30u);
+    BOOST_REQUIRE_GE(file.size(), link_size + 130u * record_size);
+    manager.commit();
+    BOOST_REQUIRE_EQUAL(manager.count(), 130u);
+}
+
+BOOST_AUTO_TEST_CASE(record_manager__recover__count_beyond_file__truncated)
+{
+    typedef uint32_t link_type;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+
+    const auto record_size = 10u;
+    const auto link_size = sizeof(link_type);
+    record_manager<link_type> manager(file, 0, record_size);
+    BOOST_REQUIRE(manager.create());
+    manager.allocate(10);
+    manager.commit();
+
+    // A count committed without its records (as of an unclean shutdown).
+    {
+        const auto memory = file.access();
+        auto serial = make_unsafe_serializer(memory->buffer());
+        serial.write_4_bytes_little_endian(1000000u);
+    }
+
+    record_manager<link_type> recovered(file, 0, record_size);
+    BOOST_REQUIRE(!recovered.start());
+    BOOST_REQUIRE(recovered.recover());
+
+    const auto expected = (file.size() - link_size) / record_size;
+    BOOST_REQUIRE_EQUAL(recovered.count(), expected);
+    BOOST_REQUIRE(recovered.contains(expected - 1u));
+    BOOST_REQUIRE(!recovered.contains(expected));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
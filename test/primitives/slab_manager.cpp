@@ -18,6 +18,9 @@
  */
 #include <boost/test/unit_test.hpp>
 
+#include <cstddef>
+#include <thread>
+#include <vector>
 #include <bitcoin/database.hpp>
 #include "../utility/storage.hpp"
 
@@ -147,4 +150,129 @@ BOOST_AUTO_TEST_CASE(slab_manager__get__read_write__expected)
     memory.reset();
 }
 
+BOOST_AUTO_TEST_CASE(slab_manager__allocate__within_mapped_file__reserved_on_commit)
+{
+    typedef uint64_t link_type;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+
+    const auto link_size = sizeof(link_type);
+    slab_manager<link_type> manager(file, 0);
+    BOOST_REQUIRE(manager.create());
+
+    // Map more than the payload, so that allocation does not grow the file.
+    BOOST_REQUIRE(file.resize(1000));
+    BOOST_REQUIRE(manager.start());
+
+    BOOST_REQUIRE_EQUAL(manager.allocate(100), link_size);
+    BOOST_REQUIRE_EQUAL(manager.allocate(200), link_size + 100u);
+    BOOST_REQUIRE_EQUAL(file.size(), 1000u);
+
+    // Growth beyond the mapped file is reserved at allocation.
+    BOOST_REQUIRE_EQUAL(manager.allocate(800), link_size + 300u);
+    BOOST_REQUIRE_GE(file.size(), link_size + 1100u);
+    manager.commit();
+    BOOST_REQUIRE_EQUAL(manager.payload_size(), link_size + 1100u);
+}
+
+BOOST_AUTO_TEST_CASE(slab_manager__allocate__concurrent__distinct)
+{
+    typedef uint64_t link_type;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+
+    const auto link_size = sizeof(link_type);
+    slab_manager<link_type> manager(file, 0);
+    BOOST_REQUIRE(manager.create());
+
+    const size_t threads = 4;
+    const size_t slabs = 1000;
+    const size_t slab_size = 10;
+    std::vector<std::vector<link_type>> links(threads);
+    std::vector<std::thread> writers;
+
+    for (size_t thread = 0; thread < threads; ++thread)
+        writers.emplace_back([&, thread]()
+        {
+            for (size_t slab = 0; slab < slabs; ++slab)
+                links[thread].push_back(manager.allocate(slab_size));
+        });
+
+    for (auto& writer: writers)
+        writer.join();
+
+    manager.commit();
+    const auto payload = link_size + threads * slabs * slab_size;
+    BOOST_REQUIRE_EQUAL(manager.payload_size(), payload);
+    BOOST_REQUIRE_GE(file.size(), payload);
+
+    // Each slab is allocated once, at a multiple of the slab size.
+    std::vector<bool> allocated(threads * slabs, false);
+    for (const auto& thread: links)
+    {
+        for (const auto link: thread)
+        {
+            const auto index = (link - link_size) / slab_size;
+            BOOST_REQUIRE_EQUAL((link - link_size) % slab_size, 0u);
+            BOOST_REQUIRE(!allocated[index]);
+            allocated[index] = true;
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(slab_manager__recover__payload_beyond_file__truncated)
+{
+    typedef uint32_t link_type;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+
+    const auto link_size = sizeof(link_type);
+    slab_manager<link_type> manager(file, 0);
+    BOOST_REQUIRE(manager.create());
+    manager.allocate(100);
+    manager.commit();
+
+    // A size committed without its slabs (as of an unclean shutdown).
+    {
+        const auto memory = file.access();
+        auto serial = make_unsafe_serializer(memory->buffer());
+        serial.write_4_bytes_little_endian(1000000u);
+    }
+
+    slab_manager<link_type> recovered(file, 0);
+    BOOST_REQUIRE(!recovered.start());
+    BOOST_REQUIRE(recovered.recover());
+    BOOST_REQUIRE_EQUAL(recovered.payload_size(), file.size());
+    BOOST_REQUIRE(recovered.contains(link_size));
+    BOOST_REQUIRE(!recovered.contains(0));
+    BOOST_REQUIRE(!recovered.contains(file.size()));
+}
+
+BOOST_AUTO_TEST_CASE(slab_manager__release__range__zeroed)
+{
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+
+    uint64_t value = 0x0102030405060708;
+    slab_manager<uint32_t> manager(file, 0);
+    BOOST_REQUIRE(manager.create());
+
+    const auto link = manager.allocate(2 * sizeof(value));
+    auto memory = manager.get(link);
+    auto serial = make_unsafe_serializer(memory->buffer());
+    serial.write_little_endian(value);
+    serial.write_little_endian(value);
+    memory.reset();
+
+    manager.release(link, sizeof(value), sizeof(value));
+
+    memory = manager.get(link);
+    auto deserial = make_unsafe_deserializer(memory->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.template read_little_endian<uint64_t>(), value);
+    BOOST_REQUIRE_EQUAL(deserial.template read_little_endian<uint64_t>(), 0u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -17,16 +17,89 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <boost/test/unit_test.hpp>
+
 #include <bitcoin/database.hpp>
+#include "../utility/storage.hpp"
 
 using namespace bc;
+using namespace bc::chain;
 using namespace bc::database;
 
+typedef hash_table_chunked_multimap<array_index, array_index, short_hash>
+    record_multimap;
+typedef record_multimap::table record_map;
+typedef record_multimap::manager manager_type;
+
+static const short_hash key{ { 0x42 } };
+static const auto row_size = sizeof(uint32_t) +
+    payment_record::satoshi_fixed_size(false);
+
+// Link rows of the given heights, oldest first (newest is iterated first).
+static void link_rows(record_multimap& multimap,
+    const std::vector<uint32_t>& heights)
+{
+    for (size_t index = 0; index < heights.size(); ++index)
+    {
+        const payment_record payment{ index, 0, 0, true };
+        multimap.link(key, 1, [&](byte_serializer& serial, size_t)
+        {
+            serial.write_4_bytes_little_endian(heights[index]);
+            payment.to_data(serial, false);
+        });
+    }
+}
+
 BOOST_AUTO_TEST_SUITE(address_iterator_tests)
 
-BOOST_AUTO_TEST_CASE(address_iterator__method__vector__expectation)
+BOOST_AUTO_TEST_CASE(address_iterator__increment__bounds__expected)
 {
-    BOOST_REQUIRE(true);
+    test::storage table_file;
+    BOOST_REQUIRE(table_file.open());
+    record_map table(table_file, 10u, sizeof(file_offset));
+    BOOST_REQUIRE(table.create());
+
+    test::storage rows_file;
+    BOOST_REQUIRE(rows_file.open());
+    manager_type rows(rows_file, 0);
+    BOOST_REQUIRE(rows.create());
+    record_multimap multimap(table, rows, row_size);
+
+    link_rows(multimap, { 10, 20, 30, max_uint32 });
+    const auto head = multimap.find(key);
+
+    // Unbounded.
+    size_t count = 0;
+    const address_iterator end(head.terminator());
+    for (address_iterator it(head); it != end; ++it)
+        ++count;
+
+    BOOST_REQUIRE_EQUAL(count, 4u);
+
+    // Stops at the first row below the height.
+    std::vector<size_t> heights;
+    for (address_iterator it(head, 20); it != end; ++it)
+        heights.push_back((*it).height());
+
+    BOOST_REQUIRE_EQUAL(heights.size(), 3u);
+    BOOST_REQUIRE_EQUAL(heights[0], max_uint32);
+    BOOST_REQUIRE_EQUAL(heights[2], 20u);
+
+    // Pages of two, resumed from the cursor.
+    address_iterator page(head, 0, 2);
+    for (count = 0; page != end; ++page)
+        ++count;
+
+    BOOST_REQUIRE_EQUAL(count, 2u);
+    BOOST_REQUIRE(page.link() != end.link());
+
+    address_iterator next(multimap.element(page.link()), 0, 2);
+    BOOST_REQUIRE_EQUAL((*next).height(), 20u);
+    ++next;
+    BOOST_REQUIRE(next != end);
+    BOOST_REQUIRE_EQUAL((*next).height(), 10u);
+    ++next;
+    BOOST_REQUIRE(next == end);
+    BOOST_REQUIRE_EQUAL(next.link(), end.link());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
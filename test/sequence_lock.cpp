@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(sequence_lock_tests)
+
+BOOST_AUTO_TEST_CASE(sequence_lock__read__no_write__invoked_once)
+{
+    sequence_lock instance;
+    size_t calls = 0;
+    instance.read([&]() { ++calls; });
+    BOOST_REQUIRE_EQUAL(calls, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(sequence_lock__read__overlapping_write__repeated)
+{
+    sequence_lock instance;
+    size_t calls = 0;
+    instance.read([&]()
+    {
+        // The first read overlaps a write.
+        if (calls++ == 0)
+            sequence_lock::scope lock(instance);
+    });
+
+    BOOST_REQUIRE_EQUAL(calls, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(sequence_lock__read__concurrent_writer__not_torn)
+{
+    sequence_lock instance;
+    volatile uint32_t low = 0;
+    volatile uint32_t high = 0;
+
+    std::thread writer([&]()
+    {
+        for (uint32_t value = 1; value <= 10000; ++value)
+        {
+            sequence_lock::scope lock(instance);
+            low = value;
+            high = value;
+        }
+    });
+
+    for (size_t read = 0; read < 10000; ++read)
+    {
+        uint32_t first;
+        uint32_t second;
+        instance.read([&]()
+        {
+            first = low;
+            second = high;
+        });
+
+        BOOST_REQUIRE_EQUAL(first, second);
+    }
+
+    writer.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
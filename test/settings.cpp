@@ -31,52 +31,188 @@ BOOST_AUTO_TEST_CASE(settings__construct__default_context__expected)
 {
     database::settings configuration;
     BOOST_REQUIRE_EQUAL(configuration.directory, "blockchain");
+    BOOST_REQUIRE(configuration.table_placement.transactions.empty());
     BOOST_REQUIRE(configuration.index_addresses);
+    BOOST_REQUIRE(!configuration.index_deferred);
+    BOOST_REQUIRE(!configuration.index_filters);
+    BOOST_REQUIRE(!configuration.index_spends);
     BOOST_REQUIRE(!configuration.flush_writes);
+    BOOST_REQUIRE_EQUAL(configuration.flush_interval_ms, 0u);
+    BOOST_REQUIRE(!configuration.journal_writes);
+    BOOST_REQUIRE(!configuration.read_only);
     BOOST_REQUIRE_EQUAL(configuration.file_growth_rate, 5u);
+    BOOST_REQUIRE(configuration.file_growth_policy.policy == database::growth_policy::geometric);
+    BOOST_REQUIRE(!configuration.file_growth_policy.preallocate);
+    BOOST_REQUIRE_EQUAL(configuration.file_reservation_mb, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.table_load_percent, 0u);
     BOOST_REQUIRE_EQUAL(configuration.block_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.block_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.block_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE(!configuration.block_index_advice.huge_pages);
+    BOOST_REQUIRE_EQUAL(configuration.header_cache_capacity, 0u);
     BOOST_REQUIRE_EQUAL(configuration.transaction_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.transaction_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.transaction_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_filter_mb, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_filter_error_ppm, 1000u);
+    BOOST_REQUIRE(!configuration.transaction_compaction);
+    BOOST_REQUIRE(!configuration.transaction_linked_inputs);
+    BOOST_REQUIRE(!configuration.transaction_split_state);
+    BOOST_REQUIRE(!configuration.transaction_checksums);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_verify_rate, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_warm_segments, 0u);
     BOOST_REQUIRE_EQUAL(configuration.address_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.address_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.address_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.address_balance_buckets, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.address_filter_range, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.filter_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.filter_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.filter_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.spend_table_buckets, 0u);
     BOOST_REQUIRE_EQUAL(configuration.cache_capacity, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.cache_budget_mb, 0u);
+    BOOST_REQUIRE(configuration.cache_eviction == database::eviction_policy::fifo);
 }
 
 BOOST_AUTO_TEST_CASE(settings__construct__none_context__expected)
 {
     database::settings configuration(config::settings::none);
     BOOST_REQUIRE_EQUAL(configuration.directory, "blockchain");
+    BOOST_REQUIRE(configuration.table_placement.transactions.empty());
     BOOST_REQUIRE(configuration.index_addresses);
+    BOOST_REQUIRE(!configuration.index_deferred);
+    BOOST_REQUIRE(!configuration.index_filters);
+    BOOST_REQUIRE(!configuration.index_spends);
     BOOST_REQUIRE(!configuration.flush_writes);
+    BOOST_REQUIRE_EQUAL(configuration.flush_interval_ms, 0u);
+    BOOST_REQUIRE(!configuration.journal_writes);
+    BOOST_REQUIRE(!configuration.read_only);
     BOOST_REQUIRE_EQUAL(configuration.file_growth_rate, 5u);
+    BOOST_REQUIRE(configuration.file_growth_policy.policy == database::growth_policy::geometric);
+    BOOST_REQUIRE(!configuration.file_growth_policy.preallocate);
+    BOOST_REQUIRE_EQUAL(configuration.file_reservation_mb, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.table_load_percent, 0u);
     BOOST_REQUIRE_EQUAL(configuration.block_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.block_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.block_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE(!configuration.block_index_advice.huge_pages);
+    BOOST_REQUIRE_EQUAL(configuration.header_cache_capacity, 0u);
     BOOST_REQUIRE_EQUAL(configuration.transaction_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.transaction_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.transaction_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_filter_mb, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_filter_error_ppm, 1000u);
+    BOOST_REQUIRE(!configuration.transaction_compaction);
+    BOOST_REQUIRE(!configuration.transaction_linked_inputs);
+    BOOST_REQUIRE(!configuration.transaction_split_state);
+    BOOST_REQUIRE(!configuration.transaction_checksums);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_verify_rate, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_warm_segments, 0u);
     BOOST_REQUIRE_EQUAL(configuration.address_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.address_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.address_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.address_balance_buckets, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.address_filter_range, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.filter_table_buckets, 0u);
+    BOOST_REQUIRE(configuration.filter_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.filter_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.spend_table_buckets, 0u);
     BOOST_REQUIRE_EQUAL(configuration.cache_capacity, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.cache_budget_mb, 0u);
+    BOOST_REQUIRE(configuration.cache_eviction == database::eviction_policy::fifo);
 }
 
 BOOST_AUTO_TEST_CASE(settings__construct__mainnet_context__expected)
 {
     database::settings configuration(config::settings::mainnet);
     BOOST_REQUIRE_EQUAL(configuration.directory, "blockchain");
+    BOOST_REQUIRE(configuration.table_placement.transactions.empty());
     BOOST_REQUIRE(configuration.index_addresses);
+    BOOST_REQUIRE(!configuration.index_deferred);
+    BOOST_REQUIRE(!configuration.index_filters);
+    BOOST_REQUIRE(!configuration.index_spends);
     BOOST_REQUIRE(!configuration.flush_writes);
+    BOOST_REQUIRE_EQUAL(configuration.flush_interval_ms, 0u);
+    BOOST_REQUIRE(!configuration.journal_writes);
+    BOOST_REQUIRE(!configuration.read_only);
     BOOST_REQUIRE_EQUAL(configuration.file_growth_rate, 5u);
+    BOOST_REQUIRE(configuration.file_growth_policy.policy == database::growth_policy::geometric);
+    BOOST_REQUIRE(!configuration.file_growth_policy.preallocate);
+    BOOST_REQUIRE_EQUAL(configuration.file_reservation_mb, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.table_load_percent, 0u);
     BOOST_REQUIRE_EQUAL(configuration.block_table_buckets, 650000u);
+    BOOST_REQUIRE(configuration.block_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.block_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE(!configuration.block_index_advice.huge_pages);
+    BOOST_REQUIRE_EQUAL(configuration.header_cache_capacity, 0u);
     BOOST_REQUIRE_EQUAL(configuration.transaction_table_buckets, 110000000u);
+    BOOST_REQUIRE(configuration.transaction_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.transaction_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE(!configuration.transaction_compaction);
+    BOOST_REQUIRE(!configuration.transaction_linked_inputs);
+    BOOST_REQUIRE(!configuration.transaction_split_state);
+    BOOST_REQUIRE(!configuration.transaction_checksums);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_verify_rate, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_warm_segments, 0u);
     BOOST_REQUIRE_EQUAL(configuration.address_table_buckets, 107000000u);
+    BOOST_REQUIRE(configuration.address_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.address_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.address_balance_buckets, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.address_filter_range, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.filter_table_buckets, 650000u);
+    BOOST_REQUIRE(configuration.filter_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.filter_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.spend_table_buckets, 107000000u);
     BOOST_REQUIRE_EQUAL(configuration.cache_capacity, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.cache_budget_mb, 0u);
+    BOOST_REQUIRE(configuration.cache_eviction == database::eviction_policy::fifo);
 }
 
 BOOST_AUTO_TEST_CASE(settings__construct__testnet_context__expected)
 {
     database::settings configuration(config::settings::testnet);
     BOOST_REQUIRE_EQUAL(configuration.directory, "blockchain");
+    BOOST_REQUIRE(configuration.table_placement.transactions.empty());
     BOOST_REQUIRE(configuration.index_addresses);
+    BOOST_REQUIRE(!configuration.index_deferred);
+    BOOST_REQUIRE(!configuration.index_filters);
+    BOOST_REQUIRE(!configuration.index_spends);
     BOOST_REQUIRE(!configuration.flush_writes);
+    BOOST_REQUIRE_EQUAL(configuration.flush_interval_ms, 0u);
+    BOOST_REQUIRE(!configuration.journal_writes);
+    BOOST_REQUIRE(!configuration.read_only);
     BOOST_REQUIRE_EQUAL(configuration.file_growth_rate, 5u);
+    BOOST_REQUIRE(configuration.file_growth_policy.policy == database::growth_policy::geometric);
+    BOOST_REQUIRE(!configuration.file_growth_policy.preallocate);
+    BOOST_REQUIRE_EQUAL(configuration.file_reservation_mb, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.table_load_percent, 0u);
     BOOST_REQUIRE_EQUAL(configuration.block_table_buckets, 650000u);
+    BOOST_REQUIRE(configuration.block_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.block_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE(!configuration.block_index_advice.huge_pages);
+    BOOST_REQUIRE_EQUAL(configuration.header_cache_capacity, 0u);
     BOOST_REQUIRE_EQUAL(configuration.transaction_table_buckets, 110000000u);
+    BOOST_REQUIRE(configuration.transaction_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.transaction_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE(!configuration.transaction_compaction);
+    BOOST_REQUIRE(!configuration.transaction_linked_inputs);
+    BOOST_REQUIRE(!configuration.transaction_split_state);
+    BOOST_REQUIRE(!configuration.transaction_checksums);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_verify_rate, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.transaction_warm_segments, 0u);
     BOOST_REQUIRE_EQUAL(configuration.address_table_buckets, 107000000u);
+    BOOST_REQUIRE(configuration.address_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.address_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.address_balance_buckets, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.address_filter_range, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.filter_table_buckets, 650000u);
+    BOOST_REQUIRE(configuration.filter_table_storage == database::storage_backend::file);
+    BOOST_REQUIRE(configuration.filter_table_advice.numa == database::numa_policy::none);
+    BOOST_REQUIRE_EQUAL(configuration.spend_table_buckets, 107000000u);
     BOOST_REQUIRE_EQUAL(configuration.cache_capacity, 0u);
+    BOOST_REQUIRE_EQUAL(configuration.cache_budget_mb, 0u);
+    BOOST_REQUIRE(configuration.cache_eviction == database::eviction_policy::fifo);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
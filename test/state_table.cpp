@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <bitcoin/database.hpp>
+#include "utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+// Test directory
+#define DIRECTORY "state_table"
+
+struct state_table_directory_setup_fixture
+{
+    state_table_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(state_table_tests, state_table_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(state_table__allocate__sequential__ordinals)
+{
+    const auto transactions = DIRECTORY "/transactions";
+    const auto outputs = DIRECTORY "/outputs";
+    BOOST_REQUIRE(test::create(transactions));
+    BOOST_REQUIRE(test::create(outputs));
+
+    state_table table(transactions, outputs, 50);
+    BOOST_REQUIRE(table.create());
+    BOOST_REQUIRE_EQUAL(table.allocate_transactions(2), 0u);
+    BOOST_REQUIRE_EQUAL(table.allocate_transactions(1), 2u);
+    BOOST_REQUIRE_EQUAL(table.allocate_outputs(3), 0u);
+    BOOST_REQUIRE_EQUAL(table.allocate_outputs(5), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(state_table__open__committed__round_trips)
+{
+    const auto transactions = DIRECTORY "/transactions";
+    const auto outputs = DIRECTORY "/outputs";
+    BOOST_REQUIRE(test::create(transactions));
+    BOOST_REQUIRE(test::create(outputs));
+
+    {
+        state_table table(transactions, outputs, 50);
+        BOOST_REQUIRE(table.create());
+
+        const auto ordinal = table.allocate_transactions(1);
+        auto serial = make_unsafe_serializer(
+            table.transaction(ordinal)->buffer());
+        serial.write_4_bytes_little_endian(42);
+        serial.write_2_bytes_little_endian(7);
+        serial.write_byte(1);
+        serial.write_4_bytes_little_endian(1234);
+
+        const auto output = table.allocate_outputs(2) + 1u;
+        auto spend = make_unsafe_serializer(table.output(output)->buffer());
+        spend.write_byte(1);
+        spend.write_4_bytes_little_endian(43);
+
+        table.commit();
+        BOOST_REQUIRE(table.close());
+    }
+
+    state_table table(transactions, outputs, 50);
+    BOOST_REQUIRE(table.open());
+
+    auto deserial = make_unsafe_deserializer(table.transaction(0)->buffer());
+    BOOST_REQUIRE_EQUAL(deserial.read_4_bytes_little_endian(), 42u);
+    BOOST_REQUIRE_EQUAL(deserial.read_2_bytes_little_endian(), 7u);
+    BOOST_REQUIRE_EQUAL(deserial.read_byte(), 1u);
+    BOOST_REQUIRE_EQUAL(deserial.read_4_bytes_little_endian(), 1234u);
+
+    auto spend = make_unsafe_deserializer(table.output(1)->buffer());
+    BOOST_REQUIRE_EQUAL(spend.read_byte(), 1u);
+    BOOST_REQUIRE_EQUAL(spend.read_4_bytes_little_endian(), 43u);
+
+    // Allocation continues from the committed counts.
+    BOOST_REQUIRE_EQUAL(table.allocate_transactions(1), 1u);
+    BOOST_REQUIRE_EQUAL(table.allocate_outputs(1), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -32,12 +32,24 @@ class store_accessor
 {
 public:
     store_accessor(const path& prefix, bool indexes=false, bool flush=false,
-        bool result=true)
-      : store(prefix, indexes, flush), result_(result)
+        bool result=true, bool filters=false, bool split=false,
+        bool read_only=false,
+        const table_directories& directories=table_directories())
+      : store(prefix, indexes, flush, false, filters, split, read_only,
+            false, directories),
+        result_(result)
     {
     }
 
     virtual bool flush() const { return result_; }
+    virtual bool journal(commit_log&) const { return result_; }
+
+    virtual bool tops(size_t& candidate, size_t& confirmed) const
+    {
+        candidate = 42;
+        confirmed = 24;
+        return result_;
+    }
 
 private:
     bool result_;
@@ -94,6 +106,10 @@ BOOST_AUTO_TEST_CASE(store__construct__no_indexes__expected_files)
     static const std::string tx_table = directory + "/" + store::TRANSACTION_TABLE;
     static const std::string address_table = directory + "/" + store::ADDRESS_TABLE;
     static const std::string address_rows = directory + "/" + store::ADDRESS_ROWS;
+    static const std::string address_height = directory + "/" + store::ADDRESS_HEIGHT;
+    static const std::string address_balances = directory + "/" + store::ADDRESS_BALANCES;
+    static const std::string address_filters = directory + "/" + store::ADDRESS_FILTERS;
+    static const std::string filter_table = directory + "/" + store::FILTER_TABLE;
 
     BOOST_REQUIRE(!test::exists(block_table));
     BOOST_REQUIRE(!test::exists(candidate_index));
@@ -102,6 +118,10 @@ BOOST_AUTO_TEST_CASE(store__construct__no_indexes__expected_files)
     BOOST_REQUIRE(!test::exists(tx_table));
     BOOST_REQUIRE(!test::exists(address_table));
     BOOST_REQUIRE(!test::exists(address_rows));
+    BOOST_REQUIRE(!test::exists(address_height));
+    BOOST_REQUIRE(!test::exists(address_balances));
+    BOOST_REQUIRE(!test::exists(address_filters));
+    BOOST_REQUIRE(!test::exists(filter_table));
 
     BOOST_REQUIRE(store.create());
 
@@ -112,6 +132,9 @@ BOOST_AUTO_TEST_CASE(store__construct__no_indexes__expected_files)
     BOOST_REQUIRE(test::exists(tx_table));
     BOOST_REQUIRE(!test::exists(address_table));
     BOOST_REQUIRE(!test::exists(address_rows));
+    BOOST_REQUIRE(!test::exists(address_height));
+    BOOST_REQUIRE(!test::exists(address_balances));
+    BOOST_REQUIRE(!test::exists(address_filters));
 
     BOOST_REQUIRE(store.close());
 }
@@ -128,6 +151,10 @@ BOOST_AUTO_TEST_CASE(store__construct__indexes__expected_files)
     static const std::string tx_table = directory + "/" + store::TRANSACTION_TABLE;
     static const std::string address_table = directory + "/" + store::ADDRESS_TABLE;
     static const std::string address_rows = directory + "/" + store::ADDRESS_ROWS;
+    static const std::string address_height = directory + "/" + store::ADDRESS_HEIGHT;
+    static const std::string address_balances = directory + "/" + store::ADDRESS_BALANCES;
+    static const std::string address_filters = directory + "/" + store::ADDRESS_FILTERS;
+    static const std::string filter_table = directory + "/" + store::FILTER_TABLE;
 
     BOOST_REQUIRE(!test::exists(block_table));
     BOOST_REQUIRE(!test::exists(candidate_index));
@@ -136,6 +163,10 @@ BOOST_AUTO_TEST_CASE(store__construct__indexes__expected_files)
     BOOST_REQUIRE(!test::exists(tx_table));
     BOOST_REQUIRE(!test::exists(address_table));
     BOOST_REQUIRE(!test::exists(address_rows));
+    BOOST_REQUIRE(!test::exists(address_height));
+    BOOST_REQUIRE(!test::exists(address_balances));
+    BOOST_REQUIRE(!test::exists(address_filters));
+    BOOST_REQUIRE(!test::exists(filter_table));
 
     BOOST_REQUIRE(store.create());
 
@@ -146,6 +177,48 @@ BOOST_AUTO_TEST_CASE(store__construct__indexes__expected_files)
     BOOST_REQUIRE(test::exists(tx_table));
     BOOST_REQUIRE(test::exists(address_table));
     BOOST_REQUIRE(test::exists(address_rows));
+    BOOST_REQUIRE(test::exists(address_height));
+    BOOST_REQUIRE(test::exists(address_balances));
+    BOOST_REQUIRE(test::exists(address_filters));
+    BOOST_REQUIRE(!test::exists(filter_table));
+
+    BOOST_REQUIRE(store.close());
+}
+
+BOOST_AUTO_TEST_CASE(store__construct__filters__expected_files)
+{
+    static const std::string directory = DIRECTORY "/" + TEST_NAME;
+    store_accessor store(directory, false, false, true, true);
+
+    static const std::string address_table = directory + "/" + store::ADDRESS_TABLE;
+    static const std::string filter_table = directory + "/" + store::FILTER_TABLE;
+
+    BOOST_REQUIRE(!test::exists(address_table));
+    BOOST_REQUIRE(!test::exists(filter_table));
+
+    BOOST_REQUIRE(store.create());
+
+    BOOST_REQUIRE(!test::exists(address_table));
+    BOOST_REQUIRE(test::exists(filter_table));
+
+    BOOST_REQUIRE(store.close());
+}
+
+BOOST_AUTO_TEST_CASE(store__construct__split_state__expected_files)
+{
+    static const std::string directory = DIRECTORY "/" + TEST_NAME;
+    store_accessor store(directory, false, false, true, false, true);
+
+    static const std::string transaction_state = directory + "/" + store::TRANSACTION_STATE;
+    static const std::string output_state = directory + "/" + store::OUTPUT_STATE;
+
+    BOOST_REQUIRE(!test::exists(transaction_state));
+    BOOST_REQUIRE(!test::exists(output_state));
+
+    BOOST_REQUIRE(store.create());
+
+    BOOST_REQUIRE(test::exists(transaction_state));
+    BOOST_REQUIRE(test::exists(output_state));
 
     BOOST_REQUIRE(store.close());
 }
@@ -165,6 +238,47 @@ BOOST_AUTO_TEST_CASE(store__construct__exclusive_lock__expected_files)
     BOOST_REQUIRE(!test::exists(exclusive_lock));
 }
 
+BOOST_AUTO_TEST_CASE(store__construct__table_directories__expected_files)
+{
+    static const std::string directory = DIRECTORY "/" + TEST_NAME;
+    static const std::string bulk = directory + "_bulk";
+    table_directories directories;
+    directories.transactions = bulk;
+    store_accessor store(directory, false, false, true, false, false, false,
+        directories);
+
+    static const std::string block_table = directory + "/" + store::BLOCK_TABLE;
+    static const std::string transaction_table = bulk + "/" + store::TRANSACTION_TABLE;
+    static const std::string misplaced_table = directory + "/" + store::TRANSACTION_TABLE;
+
+    BOOST_REQUIRE_EQUAL(store.transaction_table.string(), transaction_table);
+    BOOST_REQUIRE(store.create());
+    BOOST_REQUIRE(test::exists(block_table));
+    BOOST_REQUIRE(test::exists(transaction_table));
+    BOOST_REQUIRE(!test::exists(misplaced_table));
+    BOOST_REQUIRE(store.close());
+}
+
+BOOST_AUTO_TEST_CASE(store__open__table_directories__exclusive_lock_in_each)
+{
+    static const std::string directory = DIRECTORY "/" + TEST_NAME;
+    static const std::string bulk = directory + "_bulk";
+    table_directories directories;
+    directories.transactions = bulk;
+    directories.state = bulk;
+    store_accessor store(directory, false, false, true, false, false, false,
+        directories);
+
+    static const std::string exclusive_lock = bulk + "/" + store::EXCLUSIVE_LOCK;
+
+    BOOST_REQUIRE(store.create());
+    BOOST_REQUIRE(!test::exists(exclusive_lock));
+    BOOST_REQUIRE(store.open());
+    BOOST_REQUIRE(test::exists(exclusive_lock));
+    BOOST_REQUIRE(store.close());
+    BOOST_REQUIRE(!test::exists(exclusive_lock));
+}
+
 BOOST_AUTO_TEST_CASE(store__construct__global_flush_lock__expected_files)
 {
     static const std::string directory = DIRECTORY "/" + TEST_NAME;
@@ -329,4 +443,40 @@ BOOST_AUTO_TEST_CASE(store__close__twice__idempotent)
     BOOST_REQUIRE(store.close());
 }
 
+BOOST_AUTO_TEST_CASE(store__open__read_only_without_writer__false)
+{
+    static const std::string directory = DIRECTORY "/" + TEST_NAME;
+    store_accessor writer(directory);
+    BOOST_REQUIRE(writer.create());
+
+    store_accessor reader(directory, false, false, true, false, false, true);
+    BOOST_REQUIRE(reader.read_only());
+    BOOST_REQUIRE(!reader.open());
+}
+
+BOOST_AUTO_TEST_CASE(store__published__read_only_after_write__expected)
+{
+    static const std::string directory = DIRECTORY "/" + TEST_NAME;
+    store_accessor writer(directory);
+    BOOST_REQUIRE(writer.create());
+    BOOST_REQUIRE(writer.open());
+    BOOST_REQUIRE(writer.begin_write());
+    BOOST_REQUIRE(writer.end_write());
+
+    // The secondary takes no exclusive lock and cannot write.
+    store_accessor reader(directory, false, false, true, false, false, true);
+    BOOST_REQUIRE(reader.open());
+    BOOST_REQUIRE(!reader.create());
+    BOOST_REQUIRE(!reader.begin_write());
+
+    commit_counter::state state;
+    BOOST_REQUIRE(reader.published(state));
+    BOOST_REQUIRE_EQUAL(state.sequence, 1u);
+    BOOST_REQUIRE_EQUAL(state.candidate_height, 42u);
+    BOOST_REQUIRE_EQUAL(state.confirmed_height, 24u);
+
+    BOOST_REQUIRE(reader.close());
+    BOOST_REQUIRE(writer.close());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
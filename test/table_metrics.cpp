@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <bitcoin/database.hpp>
+#include "utility/storage.hpp"
+#include "utility/utility.hpp"
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(table_metrics_tests)
+
+BOOST_AUTO_TEST_CASE(table_metrics__get__default__zero)
+{
+    const table_metrics metrics;
+    const auto values = metrics.get();
+    BOOST_REQUIRE_EQUAL(values.lookups, 0u);
+    BOOST_REQUIRE_EQUAL(values.allocations, 0u);
+    BOOST_REQUIRE_EQUAL(values.remaps, 0u);
+    BOOST_REQUIRE_EQUAL(values.average_chain(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(table_metrics__get__counted__expected)
+{
+    table_metrics metrics;
+    metrics.lookup(true, 1);
+    metrics.lookup(false, 3);
+    metrics.allocate(42);
+    metrics.remap(std::chrono::nanoseconds(7));
+
+    const auto values = metrics.get();
+    BOOST_REQUIRE_EQUAL(values.lookups, 2u);
+    BOOST_REQUIRE_EQUAL(values.hits, 1u);
+    BOOST_REQUIRE_EQUAL(values.misses(), 1u);
+    BOOST_REQUIRE_EQUAL(values.average_chain(), 2.0);
+    BOOST_REQUIRE_EQUAL(values.allocations, 1u);
+    BOOST_REQUIRE_EQUAL(values.allocated_bytes, 42u);
+    BOOST_REQUIRE_EQUAL(values.remaps, 1u);
+    BOOST_REQUIRE_EQUAL(values.remap_wait_ns, 7u);
+}
+
+BOOST_AUTO_TEST_CASE(table_metrics__hash_table_find__enabled__counts_lookups)
+{
+    typedef test::tiny_hash key_type;
+    typedef hash_table<slab_manager<uint32_t>, uint32_t, uint32_t, key_type>
+        slab_map;
+
+    test::storage file;
+    BOOST_REQUIRE(file.open());
+    slab_map table(file, 100u);
+    BOOST_REQUIRE(table.create());
+
+    table_metrics metrics;
+    table.enable_metrics(metrics);
+
+    const key_type key{ { 0xde, 0xad, 0xbe, 0xef } };
+    const key_type other{ { 0xba, 0xad, 0xf0, 0x0d } };
+    const auto writer = [](byte_serializer& serial)
+    {
+        serial.write_byte(42);
+    };
+
+    auto element = table.allocator();
+    element.create(key, writer, 1);
+    table.link(element);
+
+    BOOST_REQUIRE(table.find(key));
+    BOOST_REQUIRE(!table.find(other));
+
+    const auto values = metrics.get();
+    BOOST_REQUIRE_EQUAL(values.lookups, 2u);
+    BOOST_REQUIRE_EQUAL(values.hits, 1u);
+    BOOST_REQUIRE_EQUAL(values.allocations, 1u);
+    BOOST_REQUIRE(values.allocated_bytes > 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
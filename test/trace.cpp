@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(trace_tests)
+
+BOOST_AUTO_TEST_CASE(trace__enable__toggled__expected)
+{
+    BOOST_REQUIRE(!trace::enabled());
+    trace::enable(true);
+    BOOST_REQUIRE(trace::enabled());
+    trace::enable(false);
+    BOOST_REQUIRE(!trace::enabled());
+}
+
+BOOST_AUTO_TEST_CASE(trace__span__handler__begin_and_end)
+{
+    std::vector<std::string> events;
+    trace::set_handler([&](const char* name, bool begin)
+    {
+        events.push_back(std::string(begin ? "+" : "-") + name);
+    });
+
+    {
+        DATABASE_SPAN("outer");
+        trace::span inner("inner");
+    }
+
+    trace::set_handler(nullptr);
+
+    {
+        DATABASE_SPAN("unhandled");
+    }
+
+    BOOST_REQUIRE_EQUAL(events.size(), 4u);
+    BOOST_REQUIRE_EQUAL(events[0], "+outer");
+    BOOST_REQUIRE_EQUAL(events[1], "+inner");
+    BOOST_REQUIRE_EQUAL(events[2], "-inner");
+    BOOST_REQUIRE_EQUAL(events[3], "-outer");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
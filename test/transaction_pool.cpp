@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(transaction_pool_tests)
+
+BOOST_AUTO_TEST_CASE(transaction_pool__construct__budget_0__disabled)
+{
+    static const transaction tx{ 1, 0, {}, { {} } };
+    transaction_pool pool(0);
+    BOOST_REQUIRE(pool.disabled());
+    BOOST_REQUIRE(!pool.add(tx, 42));
+
+    uint32_t forks;
+    BOOST_REQUIRE(!pool.get(tx.hash(), forks));
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__new__found_with_forks)
+{
+    static const transaction tx{ 1, 0, {}, { {} } };
+    transaction_pool pool(1000000);
+    BOOST_REQUIRE(pool.add(tx, 42));
+    BOOST_REQUIRE_EQUAL(pool.size(), 1u);
+
+    uint32_t forks = 0;
+    const auto pooled = pool.get(tx.hash(), forks);
+    BOOST_REQUIRE(pooled);
+    BOOST_REQUIRE(*pooled == tx);
+    BOOST_REQUIRE_EQUAL(forks, 42u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__existing__false)
+{
+    static const transaction tx{ 1, 0, {}, { {} } };
+    transaction_pool pool(1000000);
+    BOOST_REQUIRE(pool.add(tx, 42));
+    BOOST_REQUIRE(!pool.add(tx, 43));
+    BOOST_REQUIRE_EQUAL(pool.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__remove__existing__not_found)
+{
+    static const transaction tx{ 1, 0, {}, { {} } };
+    transaction_pool pool(1000000);
+    BOOST_REQUIRE(pool.add(tx, 42));
+    pool.remove(tx.hash());
+    BOOST_REQUIRE_EQUAL(pool.size(), 0u);
+    BOOST_REQUIRE_EQUAL(pool.bytes(), 0u);
+
+    uint32_t forks;
+    BOOST_REQUIRE(!pool.get(tx.hash(), forks));
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__beyond_budget__oldest_evicted)
+{
+    static const transaction tx1{ 1, 0, {}, { {} } };
+    static const transaction tx2{ 2, 0, {}, { {} } };
+    static const transaction tx3{ 3, 0, {}, { {} } };
+    transaction_pool single(1000000);
+    BOOST_REQUIRE(single.add(tx1, 0));
+
+    // A budget that holds two of the (equally-sized) txs.
+    transaction_pool pool(2 * single.bytes());
+    BOOST_REQUIRE(pool.add(tx1, 0));
+    BOOST_REQUIRE(pool.add(tx2, 0));
+    BOOST_REQUIRE(pool.add(tx3, 0));
+    BOOST_REQUIRE_EQUAL(pool.size(), 2u);
+
+    uint32_t forks;
+    BOOST_REQUIRE(!pool.get(tx1.hash(), forks));
+    BOOST_REQUIRE(pool.get(tx2.hash(), forks));
+    BOOST_REQUIRE(pool.get(tx3.hash(), forks));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,34 +19,59 @@
 #include <boost/test/unit_test.hpp>
 
 #include <bitcoin/database.hpp>
+#include "utility/utility.hpp"
 
 using namespace bc;
 using namespace bc::chain;
 using namespace bc::database;
 
-BOOST_AUTO_TEST_SUITE(unspent_outputs_tests)
+// Test directory
+#define DIRECTORY "unspent_outputs"
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__construct__capacity_0__disabled)
+struct unspent_outputs_directory_setup_fixture
+{
+    unspent_outputs_directory_setup_fixture()
+    {
+        test::clear_path(DIRECTORY);
+    }
+};
+
+// Large enough for the outputs of any of these tests.
+static const size_t budget = 1024 * 1024;
+
+// The cost of one output with an empty script.
+static size_t output_cost()
+{
+    static const transaction tx{ 0, 0, {}, { {} } };
+    unspent_outputs cache(budget);
+    cache.add(tx, 0, 0, false);
+    return cache.bytes();
+}
+
+BOOST_FIXTURE_TEST_SUITE(unspent_outputs_tests, unspent_outputs_directory_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__construct__budget_0__disabled)
 {
     const unspent_outputs cache(0);
     BOOST_REQUIRE(cache.disabled());
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__construct__capacity_42__not_disabled)
+BOOST_AUTO_TEST_CASE(unspent_outputs__construct__budget__not_disabled)
 {
-    const unspent_outputs cache(42);
+    const unspent_outputs cache(budget);
     BOOST_REQUIRE(!cache.disabled());
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__construct__capacity_0__size_0)
+BOOST_AUTO_TEST_CASE(unspent_outputs__construct__budget_0__size_0)
 {
     const unspent_outputs cache(0);
     BOOST_REQUIRE_EQUAL(cache.size(), 0u);
+    BOOST_REQUIRE_EQUAL(cache.bytes(), 0u);
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__construct__capacity_42__empty)
+BOOST_AUTO_TEST_CASE(unspent_outputs__construct__budget__empty)
 {
-    const unspent_outputs cache(42);
+    const unspent_outputs cache(budget);
     BOOST_REQUIRE(cache.empty());
 }
 
@@ -56,23 +81,33 @@ BOOST_AUTO_TEST_CASE(unspent_outputs__hit_rate__default__1)
     BOOST_REQUIRE_EQUAL(cache.hit_rate(), 1.0f);
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__add__one_capacity_42__size_1)
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__one_budget__size_1)
 {
     static const transaction tx{ 0, 0, input::list{}, output::list{ output{} } };
-    unspent_outputs cache(42);
+    unspent_outputs cache(budget);
     cache.add(tx, 0, 0, false);
     BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE_GT(cache.bytes(), 0u);
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__add__no_outputs_capcity_42__empty)
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__two_outputs_budget__size_2)
+{
+    static const transaction tx{ 0, 0, {}, { {}, {} } };
+    unspent_outputs cache(budget);
+    cache.add(tx, 0, 0, false);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE_EQUAL(cache.bytes(), 2u * output_cost());
+}
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__no_outputs_budget__empty)
 {
     static const transaction tx{ 0, 0, {}, {} };
-    unspent_outputs cache(42);
+    unspent_outputs cache(budget);
     cache.add(tx, 0, 0, false);
     BOOST_REQUIRE(cache.empty());
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__add__one_capcity_0__empty)
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__one_budget_0__empty)
 {
     static const transaction tx{ 0, 0, {}, { {}, {} } };
     unspent_outputs cache(0);
@@ -80,25 +115,49 @@ BOOST_AUTO_TEST_CASE(unspent_outputs__add__one_capcity_0__empty)
     BOOST_REQUIRE(cache.empty());
 }
 
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__budget_below_output__empty)
+{
+    static const transaction tx{ 0, 0, {}, { {} } };
+    unspent_outputs cache(output_cost() - 1u);
+    cache.add(tx, 0, 0, false);
+    BOOST_REQUIRE(cache.empty());
+}
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__same_tx_twice__replaced)
+{
+    static const transaction tx{ 0, 0, {}, { {}, {} } };
+    unspent_outputs cache(budget);
+    cache.add(tx, 0, 0, false);
+    cache.add(tx, 1, 0, true);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE_EQUAL(cache.bytes(), 2u * output_cost());
+
+    chain::output_point point{ tx.hash(), 0 };
+    BOOST_REQUIRE(cache.populate(point, max_size_t));
+    BOOST_REQUIRE(point.metadata.confirmed);
+    BOOST_REQUIRE_EQUAL(point.metadata.height, 1u);
+}
+
 BOOST_AUTO_TEST_CASE(unspent_outputs__remove1__remove_only__empty)
 {
     static const transaction tx{ 0, 0, {}, { {}, {} } };
-    unspent_outputs cache(1);
+    unspent_outputs cache(budget);
     cache.add(tx, 0, 0, false);
-    BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
 
     cache.remove(tx.hash());
     BOOST_REQUIRE(cache.empty());
+    BOOST_REQUIRE_EQUAL(cache.bytes(), 0u);
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__remove1__capcity_0__empty)
+BOOST_AUTO_TEST_CASE(unspent_outputs__remove1__budget_0__empty)
 {
     unspent_outputs cache(0);
     cache.remove({ null_hash, 42 });
     BOOST_REQUIRE(cache.empty());
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__remove2__capcity_0__empty)
+BOOST_AUTO_TEST_CASE(unspent_outputs__remove2__budget_0__empty)
 {
     unspent_outputs cache(0);
     cache.remove(null_hash);
@@ -113,10 +172,10 @@ BOOST_AUTO_TEST_CASE(unspent_outputs__remove2__remove_one_output__expected_outpu
     static const uint32_t expected_median_time_past = 43;
     static const transaction tx1{ 0, 0, {}, { { 0, {} }, { 1, {} } } };
     static const transaction tx2{ 0, 0, {}, { { 0, {} }, { expected_value, {} } } };
-    unspent_outputs cache(42);
+    unspent_outputs cache(budget);
     cache.add(tx1, 0, 0, false);
     cache.add(tx2, expected_height, expected_median_time_past, expected_confirmed);
-    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE_EQUAL(cache.size(), 4u);
     BOOST_REQUIRE(cache.populate({ tx1.hash(), 0 }, max_size_t));
     BOOST_REQUIRE(cache.populate({ tx1.hash(), 1 }, max_size_t));
     BOOST_REQUIRE(cache.populate({ tx2.hash(), 0 }, max_size_t));
@@ -132,24 +191,25 @@ BOOST_AUTO_TEST_CASE(unspent_outputs__remove2__remove_one_output__expected_outpu
     BOOST_REQUIRE(!point.metadata.coinbase);
     BOOST_REQUIRE(!point.metadata.spent);
 
+    // Spent outputs are dropped immediately.
     cache.remove({ tx1.hash(), 1 });
-    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE_EQUAL(cache.size(), 3u);
+    BOOST_REQUIRE(!cache.populate({ tx1.hash(), 1 }, max_size_t));
 
     cache.remove({ tx1.hash(), 0 });
-    BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
     BOOST_REQUIRE(!cache.populate({ tx1.hash(), 0 }, max_size_t));
-    BOOST_REQUIRE(!cache.populate({ tx1.hash(), 1 }, max_size_t));
     BOOST_REQUIRE(cache.populate({ tx2.hash(), 0 }, max_size_t));
     BOOST_REQUIRE(cache.populate({ tx2.hash(), 1 }, max_size_t));
 }
 
-BOOST_AUTO_TEST_CASE(unspent_outputs__get__two_capacity_1__size_1_expected)
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__over_budget__oldest_evicted)
 {
     static const size_t expected_height = 40;
     static const transaction tx1{ 0, 0, {}, { {}, {} } };
-    unspent_outputs cache(1);
+    unspent_outputs cache(2u * output_cost());
     cache.add(tx1, expected_height, 0, false);
-    BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
 
     chain::output_point point{ tx1.hash(), 1 };
     BOOST_REQUIRE(cache.populate(point, max_size_t));
@@ -158,21 +218,123 @@ BOOST_AUTO_TEST_CASE(unspent_outputs__get__two_capacity_1__size_1_expected)
 
     static const uint64_t expected2a = 41;
     static const uint64_t expected2b = 42;
-    static const transaction tx2{ 0, 0, {}, { {}, { expected2a, {} }, { expected2b, {} } } };
+    static const transaction tx2{ 0, 0, {}, { { expected2a, {} }, { expected2b, {} } } };
     BOOST_REQUIRE(tx2.is_valid());
 
     cache.add(tx2, 0, 0, false);
-    BOOST_REQUIRE_EQUAL(cache.size(), 1u);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE(!cache.populate({ tx1.hash(), 0 }, max_size_t));
+    BOOST_REQUIRE(!cache.populate({ tx1.hash(), 1 }, max_size_t));
 
-    chain::output_point point2a{ tx2.hash(), 1 };
+    chain::output_point point2a{ tx2.hash(), 0 };
     BOOST_REQUIRE(cache.populate(point2a, max_size_t));
     BOOST_REQUIRE(point2a.metadata.cache.is_valid());
     BOOST_REQUIRE_EQUAL(point2a.metadata.cache.value(), expected2a);
 
-    chain::output_point point2b{ tx2.hash(), 2 };
+    chain::output_point point2b{ tx2.hash(), 1 };
     BOOST_REQUIRE(cache.populate(point2b, max_size_t));
     BOOST_REQUIRE(point2b.metadata.cache.is_valid());
     BOOST_REQUIRE_EQUAL(point2b.metadata.cache.value(), expected2b);
 }
 
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__many_sharded__budget_bounded)
+{
+    static const size_t limit = 8 * 64 * 1024;
+    unspent_outputs cache(limit, 8);
+
+    for (uint32_t locktime = 0; locktime < 10000; ++locktime)
+    {
+        const transaction tx{ 0, locktime, {}, { {}, {} } };
+        cache.add(tx, 0, 0, false);
+        BOOST_REQUIRE_LE(cache.bytes(), limit);
+
+        // The latest transaction is always in its shard.
+        BOOST_REQUIRE(cache.populate({ tx.hash(), 1 }, max_size_t));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__policy__default__fifo)
+{
+    const unspent_outputs cache(budget);
+    BOOST_REQUIRE(cache.policy() == eviction_policy::fifo);
+}
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__fifo_hit_over_budget__hit_evicted)
+{
+    static const transaction tx1{ 0, 1, {}, { {} } };
+    static const transaction tx2{ 0, 2, {}, { {} } };
+    static const transaction tx3{ 0, 3, {}, { {} } };
+    unspent_outputs cache(2u * output_cost(), 1, eviction_policy::fifo);
+    cache.add(tx1, 0, 0, false);
+    cache.add(tx2, 0, 0, false);
+    BOOST_REQUIRE(cache.populate({ tx1.hash(), 0 }, max_size_t));
+
+    cache.add(tx3, 0, 0, false);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE(!cache.populate({ tx1.hash(), 0 }, max_size_t));
+    BOOST_REQUIRE(cache.populate({ tx2.hash(), 0 }, max_size_t));
+    BOOST_REQUIRE(cache.populate({ tx3.hash(), 0 }, max_size_t));
+}
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__add__clock_hit_over_budget__hit_retained)
+{
+    static const transaction tx1{ 0, 1, {}, { {} } };
+    static const transaction tx2{ 0, 2, {}, { {} } };
+    static const transaction tx3{ 0, 3, {}, { {} } };
+    unspent_outputs cache(2u * output_cost(), 1, eviction_policy::clock);
+    BOOST_REQUIRE(cache.policy() == eviction_policy::clock);
+    cache.add(tx1, 0, 0, false);
+    cache.add(tx2, 0, 0, false);
+    BOOST_REQUIRE(cache.populate({ tx1.hash(), 0 }, max_size_t));
+
+    cache.add(tx3, 0, 0, false);
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+    BOOST_REQUIRE(!cache.populate({ tx2.hash(), 0 }, max_size_t));
+    BOOST_REQUIRE(cache.populate({ tx1.hash(), 0 }, max_size_t));
+    BOOST_REQUIRE(cache.populate({ tx3.hash(), 0 }, max_size_t));
+}
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__load__saved__round_trips_and_consumed)
+{
+    const auto path = DIRECTORY "/cache";
+    static const size_t expected_height = 41;
+    static const uint32_t expected_median_time_past = 43;
+    static const transaction tx1{ 0, 1, {}, { { 42, {} } } };
+    static const transaction tx2{ 0, 2, {}, { { 24, {} }, {} } };
+    unspent_outputs cache(budget);
+    cache.add(tx1, expected_height, expected_median_time_past, true);
+    cache.add(tx2, 0, 0, false);
+    BOOST_REQUIRE(cache.save(path, 100));
+
+    unspent_outputs loaded(budget);
+    BOOST_REQUIRE(loaded.load(path, 100));
+    BOOST_REQUIRE_EQUAL(loaded.size(), 3u);
+    BOOST_REQUIRE_EQUAL(loaded.bytes(), cache.bytes());
+
+    chain::output_point point{ tx1.hash(), 0 };
+    BOOST_REQUIRE(loaded.populate(point, max_size_t));
+    BOOST_REQUIRE_EQUAL(point.metadata.cache.value(), 42u);
+    BOOST_REQUIRE_EQUAL(point.metadata.height, expected_height);
+    BOOST_REQUIRE_EQUAL(point.metadata.median_time_past, expected_median_time_past);
+    BOOST_REQUIRE(point.metadata.confirmed);
+    BOOST_REQUIRE(loaded.populate({ tx2.hash(), 1 }, max_size_t));
+
+    // The file is removed when loaded.
+    unspent_outputs reloaded(budget);
+    BOOST_REQUIRE(!reloaded.load(path, 100));
+}
+
+BOOST_AUTO_TEST_CASE(unspent_outputs__load__height_mismatch__empty)
+{
+    const auto path = DIRECTORY "/cache";
+    static const transaction tx{ 0, 0, {}, { {} } };
+    unspent_outputs cache(budget);
+    cache.add(tx, 0, 0, false);
+    BOOST_REQUIRE(cache.save(path, 100));
+
+    unspent_outputs loaded(budget);
+    BOOST_REQUIRE(!loaded.load(path, 101));
+    BOOST_REQUIRE(loaded.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -99,26 +99,64 @@ BOOST_AUTO_TEST_CASE(unspent_transaction__outputs__construct1__tx_hash__empty)
 {
     static const transaction tx;
     const auto expected = tx.hash();
-    BOOST_REQUIRE(unspent_transaction(expected).outputs()->empty());
+    BOOST_REQUIRE_EQUAL(unspent_transaction(expected).output_count(), 0u);
 }
 
 BOOST_AUTO_TEST_CASE(unspent_transaction__outputs__construct2__empty)
 {
     static const transaction tx;
     const output_point point{ tx.hash(), 42 };
-    BOOST_REQUIRE(unspent_transaction(point).outputs()->empty());
+    BOOST_REQUIRE_EQUAL(unspent_transaction(point).output_count(), 0u);
 }
 
 BOOST_AUTO_TEST_CASE(unspent_transaction__outputs__construct3_empty_tx__empty)
 {
     static const transaction tx;
-    BOOST_REQUIRE(unspent_transaction(tx, 0, 0, false).outputs()->empty());
+    BOOST_REQUIRE_EQUAL(unspent_transaction(tx, 0, 0, false).output_count(), 0u);
 }
 
 BOOST_AUTO_TEST_CASE(unspent_transaction__outputs__construct3_single_output_tx__one_output)
 {
     static const transaction tx{ 0, 0, {}, { {} } };
-    BOOST_REQUIRE_EQUAL(unspent_transaction(tx, 0, 0, false).outputs()->size(), 1u);
+    BOOST_REQUIRE_EQUAL(unspent_transaction(tx, 0, 0, false).output_count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(unspent_transaction__output__two_outputs__expected)
+{
+    static const transaction tx{ 0, 0, {}, { { 42, script{ { 0x51, 0x52 }, false } }, { 24, script{ { 0x53 }, false } } } };
+    const unspent_transaction instance(tx, 0, 0, false);
+    BOOST_REQUIRE_EQUAL(instance.output_count(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.value(0), 42u);
+    BOOST_REQUIRE_EQUAL(instance.value(1), 24u);
+
+    output out;
+    BOOST_REQUIRE(instance.output(out, 0));
+    BOOST_REQUIRE(out == tx.outputs()[0]);
+    BOOST_REQUIRE(instance.output(out, 1));
+    BOOST_REQUIRE(out == tx.outputs()[1]);
+    BOOST_REQUIRE(!instance.output(out, 2));
+}
+
+BOOST_AUTO_TEST_CASE(unspent_transaction__output_bytes__two_outputs__one_allocation)
+{
+    static const transaction tx{ 0, 0, {}, { { 42, script{ { 0x51, 0x52 }, false } }, { 24, script{ { 0x53 }, false } } } };
+    const unspent_transaction instance(tx, 0, 0, false);
+
+    // One bitmap byte, two entries of value and script end, three script bytes.
+    BOOST_REQUIRE_EQUAL(instance.output_bytes(), 1u + 2u * 12u + 3u);
+}
+
+BOOST_AUTO_TEST_CASE(unspent_transaction__spend__copy__shared)
+{
+    static const transaction tx{ 0, 0, {}, { {}, {} } };
+    const unspent_transaction instance(tx, 0, 0, false);
+    const unspent_transaction copied(instance);
+    BOOST_REQUIRE(!instance.is_spent(0));
+    BOOST_REQUIRE(!instance.is_spent(1));
+
+    copied.spend(1);
+    BOOST_REQUIRE(!instance.is_spent(0));
+    BOOST_REQUIRE(instance.is_spent(1));
 }
 
 BOOST_AUTO_TEST_CASE(unspent_transaction__equal__tx_hash_only__true)
@@ -18,6 +18,7 @@
  */
 #include "storage.hpp"
 
+#include <algorithm>
 #include <utility>
 #include <bitcoin/database.hpp>
 
@@ -68,6 +69,11 @@ bool storage::flush() const
     return true;
 }
 
+bool storage::flush_dirty() const
+{
+    return true;
+}
+
 bool storage::close()
 {
     mutex_.lock_upgrade();
@@ -96,6 +102,16 @@ size_t storage::size() const
     return buffer_.size();
 }
 
+size_t storage::logical_size() const
+{
+    return size();
+}
+
+size_t storage::resident_size() const
+{
+    return size();
+}
+
 memory_ptr storage::access()
 {
     const auto memory = std::make_shared<accessor>(mutex_);
@@ -103,6 +119,17 @@ memory_ptr storage::access()
     return memory;
 }
 
+memory_handle storage::pin()
+{
+    mutex_.lock_shared();
+    return memory_handle(buffer_.data(), &storage::unlock, &mutex_);
+}
+
+void storage::unlock(void* mutex)
+{
+    static_cast<upgrade_mutex*>(mutex)->unlock_shared();
+}
+
 memory_ptr storage::resize(size_t size)
 {
     return reserve(size);
@@ -125,4 +152,60 @@ memory_ptr storage::reserve(size_t size)
     return memory;
 }
 
+void storage::journal(file_offset, size_t)
+{
+}
+
+void storage::release(file_offset offset, size_t size)
+{
+    const auto memory = access();
+    const auto end = std::min(offset + size, buffer_.size());
+
+    if (offset < end)
+        std::fill(memory->buffer() + offset, memory->buffer() + end, 0x00);
+}
+
+void storage::prefetch(file_offset, size_t)
+{
+}
+
+bool storage::refresh()
+{
+    return true;
+}
+
+void storage::scan(file_offset, size_t, bool)
+{
+}
+
+void storage::enable_journal()
+{
+}
+
+void storage::enable_advice(const map_advice&, size_t)
+{
+}
+
+void storage::enable_growth(const file_growth&)
+{
+}
+
+void storage::pregrow()
+{
+}
+
+size_t storage::compress(size_t)
+{
+    return 0;
+}
+
+bool storage::log_writes(commit_log&)
+{
+    return true;
+}
+
+void storage::enable_metrics(table_metrics&)
+{
+}
+
 } // namespace test
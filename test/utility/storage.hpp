@@ -35,14 +35,34 @@ public:
 
     bool open();
     bool flush() const;
+    bool flush_dirty() const;
     bool close();
     bool closed() const;
+    bool refresh();
     size_t size() const;
+    size_t logical_size() const;
+    size_t resident_size() const;
     bc::database::memory_ptr access();
+    bc::database::memory_handle pin();
     bc::database::memory_ptr resize(size_t size);
     bc::database::memory_ptr reserve(size_t size);
+    void journal(bc::database::file_offset offset, size_t size);
+    void release(bc::database::file_offset offset, size_t size);
+    void prefetch(bc::database::file_offset offset, size_t size);
+    void scan(bc::database::file_offset offset, size_t size,
+        bool sequential);
+    void enable_journal();
+    void enable_advice(const bc::database::map_advice& advice,
+        size_t header_size);
+    void enable_growth(const bc::database::file_growth& growth);
+    void pregrow();
+    size_t compress(size_t retain);
+    bool log_writes(bc::database::commit_log& log);
+    void enable_metrics(bc::database::table_metrics& metrics);
 
 private:
+    static void unlock(void* mutex);
+
     bool closed_;
     bc::data_chunk buffer_;
     mutable bc::upgrade_mutex mutex_;
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(verify_tests)
+
+static header_const_ptr make_header(const hash_digest& previous,
+    uint32_t nonce)
+{
+    return std::make_shared<const message::header>(1, previous, null_hash, 0,
+        0, nonce);
+}
+
+BOOST_AUTO_TEST_CASE(verify_batch__empty__success)
+{
+    const header_const_ptr_list headers;
+    BOOST_REQUIRE_EQUAL(verify_batch(headers, 4), error::success);
+}
+
+BOOST_AUTO_TEST_CASE(verify_batch__linked__success)
+{
+    header_const_ptr_list headers;
+    headers.push_back(make_header(null_hash, 0));
+
+    for (uint32_t nonce = 1; nonce < 200; ++nonce)
+        headers.push_back(make_header(headers.back()->hash(), nonce));
+
+    BOOST_REQUIRE_EQUAL(verify_batch(headers, 4), error::success);
+}
+
+BOOST_AUTO_TEST_CASE(verify_batch__unlinked__store_block_missing_parent)
+{
+    header_const_ptr_list headers;
+    headers.push_back(make_header(null_hash, 0));
+
+    for (uint32_t nonce = 1; nonce < 200; ++nonce)
+        headers.push_back(make_header(nonce == 150 ? null_hash :
+            headers.back()->hash(), nonce));
+
+    BOOST_REQUIRE_EQUAL(verify_batch(headers, 4),
+        error::store_block_missing_parent);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <bitcoin/database.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(write_sequence_tests)
+
+BOOST_AUTO_TEST_CASE(write_sequence__begin_read__no_write__true)
+{
+    write_sequence instance;
+    size_t sequence;
+    BOOST_REQUIRE(instance.begin_read(sequence));
+    BOOST_REQUIRE(instance.end_read(sequence));
+}
+
+BOOST_AUTO_TEST_CASE(write_sequence__begin_read__write_in_progress__false)
+{
+    write_sequence instance;
+    write_sequence::scope write(instance);
+    size_t sequence;
+    BOOST_REQUIRE(!instance.begin_read(sequence));
+}
+
+BOOST_AUTO_TEST_CASE(write_sequence__end_read__overlapping_write__false)
+{
+    write_sequence instance;
+    size_t sequence;
+    BOOST_REQUIRE(instance.begin_read(sequence));
+    {
+        write_sequence::scope write(instance);
+    }
+
+    BOOST_REQUIRE(!instance.end_read(sequence));
+}
+
+BOOST_AUTO_TEST_CASE(write_sequence__begin_read__nested_write_ended__false)
+{
+    write_sequence instance;
+    write_sequence::scope outer(instance);
+    {
+        write_sequence::scope inner(instance);
+    }
+
+    size_t sequence;
+    BOOST_REQUIRE(!instance.begin_read(sequence));
+}
+
+BOOST_AUTO_TEST_CASE(write_sequence__read__overlapping_write__retried)
+{
+    write_sequence instance;
+    size_t calls = 0;
+    const auto reader = [&]()
+    {
+        // The first read overlaps a write.
+        if (calls++ == 0)
+            write_sequence::scope write(instance);
+    };
+
+    BOOST_REQUIRE(instance.read(reader, 2));
+    BOOST_REQUIRE_EQUAL(calls, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(write_sequence__read__write_in_progress__false)
+{
+    write_sequence instance;
+    write_sequence::scope write(instance);
+    size_t calls = 0;
+    BOOST_REQUIRE(!instance.read([&]() { ++calls; }, 3));
+    BOOST_REQUIRE_EQUAL(calls, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,417 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <bitcoin/database.hpp>
+
+// Each result is one JSON object per line, for collection by perf tracking.
+#define BS_BENCHMARK_RESULT \
+    "{\"name\":\"%1%\",\"iterations\":%2%,\"threads\":%3%," \
+    "\"real_time_ns\":%4%,\"ns_per_op\":%5$.2f,\"ops_per_second\":%6$.0f}\n"
+#define BS_BENCHMARK_DIR_NEW \
+    "Failed to create directory %1% with error, '%2%'.\n"
+#define BS_BENCHMARK_FAIL \
+    "Failed to initialize benchmark %1%.\n"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+using namespace boost::filesystem;
+using namespace boost::system;
+using boost::format;
+
+typedef uint32_t link_type;
+typedef std::chrono::high_resolution_clock benchmark_clock;
+typedef hash_table<record_manager<link_type>, link_type, link_type,
+    hash_digest> record_map;
+typedef hash_table<slab_manager<link_type>, link_type, link_type,
+    hash_digest> slab_map;
+
+// The element shapes of the block, transaction and address tables.
+typedef hash_table<record_manager<array_index>, array_index, array_index,
+    hash_digest> block_map;
+typedef hash_table<slab_manager<file_offset>, array_index, file_offset,
+    hash_digest> transaction_map;
+typedef hash_table<record_manager<array_index>, array_index, array_index,
+    short_hash> address_map;
+
+static path directory;
+static std::string filter;
+
+// Run operations [0, iterations) on threads (partitioned), report the time.
+template <typename Operation>
+static void measure(const std::string& name, size_t iterations,
+    size_t threads, Operation operation)
+{
+    if (name.find(filter) == std::string::npos)
+        return;
+
+    const auto partition = [&](size_t first, size_t last)
+    {
+        for (auto index = first; index < last; ++index)
+            operation(index);
+    };
+
+    const auto start = benchmark_clock::now();
+
+    if (threads < 2)
+    {
+        partition(0, iterations);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        const auto share = iterations / threads;
+
+        for (size_t thread = 0; thread < threads; ++thread)
+            workers.emplace_back(partition, thread * share,
+                thread + 1 == threads ? iterations : (thread + 1) * share);
+
+        for (auto& worker: workers)
+            worker.join();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        benchmark_clock::now() - start).count();
+    const auto ns_per_op = static_cast<double>(elapsed) / iterations;
+
+    std::cout << format(BS_BENCHMARK_RESULT) % name % iterations % threads %
+        elapsed % ns_per_op % (1e9 / ns_per_op);
+}
+
+static std::vector<hash_digest> make_keys(size_t count)
+{
+    std::vector<hash_digest> keys;
+    keys.reserve(count);
+
+    for (uint64_t index = 0; index < count; ++index)
+        keys.push_back(bitcoin_hash(to_chunk(to_little_endian(index))));
+
+    return keys;
+}
+
+static std::vector<short_hash> make_short_keys(size_t count)
+{
+    std::vector<short_hash> keys;
+    keys.reserve(count);
+
+    for (uint64_t index = 0; index < count; ++index)
+        keys.push_back(bitcoin_short_hash(to_chunk(to_little_endian(index))));
+
+    return keys;
+}
+
+static std::string name(const std::string& base, const std::string& first,
+    size_t value1, const std::string& second="", size_t value2=0)
+{
+    auto out = base + "/" + first + ":" + std::to_string(value1);
+    return second.empty() ? out : out + "/" + second + ":" +
+        std::to_string(value2);
+}
+
+static path file(const std::string& name)
+{
+    const auto filename = directory / name;
+    boost::filesystem::remove(filename);
+    return filename;
+}
+
+// file_storage::reserve, growth of the logical size by record size steps.
+static void benchmark_file_storage()
+{
+    for (const auto record_size: { 8u, 64u, 256u })
+    {
+        static const size_t iterations = 1000000;
+        file_storage storage(file("file_storage"));
+
+        if (!storage.open())
+        {
+            std::cerr << format(BS_BENCHMARK_FAIL) % "file_storage";
+            return;
+        }
+
+        measure(name("file_storage_reserve", "record_size", record_size),
+            iterations, 1, [&](size_t index)
+            {
+                storage.reserve((index + 1) * record_size);
+            });
+
+        storage.close();
+    }
+}
+
+// record_manager::allocate and slab_manager::allocate, one record per call.
+static void benchmark_managers()
+{
+    for (const auto record_size: { 8u, 64u, 256u })
+    {
+        for (const auto threads: { 1u, 4u })
+        {
+            static const size_t iterations = 1000000;
+            file_storage records_file(file("records"));
+            file_storage slabs_file(file("slabs"));
+
+            if (!records_file.open() || !slabs_file.open())
+            {
+                std::cerr << format(BS_BENCHMARK_FAIL) % "managers";
+                return;
+            }
+
+            record_manager<link_type> records(records_file, 0, record_size);
+            slab_manager<link_type> slabs(slabs_file, 0);
+
+            if (!records.create() || !slabs.create())
+            {
+                std::cerr << format(BS_BENCHMARK_FAIL) % "managers";
+                return;
+            }
+
+            measure(name("record_manager_allocate", "record_size",
+                record_size, "threads", threads), iterations, threads,
+                [&](size_t)
+                {
+                    records.allocate(1);
+                });
+
+            measure(name("slab_manager_allocate", "slab_size", record_size,
+                "threads", threads), iterations, threads, [&](size_t)
+                {
+                    slabs.allocate(record_size);
+                });
+
+            records.commit();
+            slabs.commit();
+            records_file.close();
+            slabs_file.close();
+        }
+    }
+}
+
+// hash_table::link and hash_table::find, chains of the given mean length.
+static void benchmark_hash_table()
+{
+    static const size_t value_size = 64;
+
+    for (const auto buckets: { 1000u, 100000u })
+    {
+        for (const auto chain: { 1u, 4u, 16u })
+        {
+            const auto count = buckets * chain;
+            const auto keys = make_keys(count);
+            file_storage storage(file("hash_table"));
+
+            if (!storage.open())
+            {
+                std::cerr << format(BS_BENCHMARK_FAIL) % "hash_table";
+                return;
+            }
+
+            record_map table(storage, buckets, value_size);
+
+            if (!table.create())
+            {
+                std::cerr << format(BS_BENCHMARK_FAIL) % "hash_table";
+                return;
+            }
+
+            const auto writer = [](byte_serializer& serial)
+            {
+                serial.skip(value_size);
+            };
+
+            measure(name("hash_table_link", "buckets", buckets, "chain",
+                chain), count, 1, [&](size_t index)
+                {
+                    auto element = table.allocator();
+                    element.create(keys[index], writer);
+                    table.link(element);
+                });
+
+            for (const auto threads: { 1u, 4u })
+            {
+                std::atomic<size_t> found(0);
+
+                measure(name("hash_table_find", "buckets", buckets, "chain",
+                    chain) + "/threads:" + std::to_string(threads), count,
+                    threads, [&](size_t index)
+                    {
+                        if (table.find(keys[index]))
+                            found.fetch_add(1, std::memory_order_relaxed);
+                    });
+
+                if (found.load() != count)
+                    std::cerr << format(BS_BENCHMARK_FAIL) % "hash_table_find";
+            }
+
+            table.commit();
+            storage.close();
+        }
+    }
+}
+
+// element_traits::match and element_traits::read_next, as walked by find.
+// Create is any callable of (value_type&, const Key&), for record or slab.
+template <typename Table, typename Key, typename Create>
+static void benchmark_element(const std::string& shape,
+    const std::vector<Key>& keys, Table& table, Create create)
+{
+    for (const auto& key: keys)
+    {
+        auto element = table.allocator();
+        create(element, key);
+        table.link(element);
+    }
+
+    std::atomic<size_t> found(0);
+
+    measure("element_find/shape:" + shape, keys.size(), 1, [&](size_t index)
+    {
+        if (table.find(keys[index]))
+            found.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    if (found.load() != keys.size())
+        std::cerr << format(BS_BENCHMARK_FAIL) % "element_find";
+
+    table.commit();
+}
+
+// The element shapes of the concrete tables, chains of the mean length four.
+static void benchmark_elements()
+{
+    static const size_t buckets = 100000;
+    static const size_t count = buckets * 4;
+    static const size_t value_size = 64;
+    const auto keys = make_keys(count);
+    const auto short_keys = make_short_keys(count);
+
+    file_storage block_file(file("block_elements"));
+    file_storage transaction_file(file("transaction_elements"));
+    file_storage address_file(file("address_elements"));
+
+    if (!block_file.open() || !transaction_file.open() ||
+        !address_file.open())
+    {
+        std::cerr << format(BS_BENCHMARK_FAIL) % "elements";
+        return;
+    }
+
+    block_map blocks(block_file, buckets, value_size);
+    transaction_map transactions(transaction_file, buckets);
+    address_map addresses(address_file, buckets, value_size);
+
+    if (!blocks.create() || !transactions.create() || !addresses.create())
+    {
+        std::cerr << format(BS_BENCHMARK_FAIL) % "elements";
+        return;
+    }
+
+    const auto writer = [](byte_serializer& serial)
+    {
+        serial.skip(value_size);
+    };
+
+    benchmark_element("block", keys, blocks,
+        [&](block_map::value_type& element, const hash_digest& key)
+        {
+            element.create(key, writer);
+        });
+
+    benchmark_element("transaction", keys, transactions,
+        [&](transaction_map::value_type& element, const hash_digest& key)
+        {
+            element.create(key, writer, value_size);
+        });
+
+    benchmark_element("address", short_keys, addresses,
+        [&](address_map::value_type& element, const short_hash& key)
+        {
+            element.create(key, writer);
+        });
+
+    block_file.close();
+    transaction_file.close();
+    address_file.close();
+}
+
+// unspent_outputs::populate, hits of a fully cached set of transactions.
+static void benchmark_unspent_outputs()
+{
+    for (const auto outputs: { 1u, 8u })
+    {
+        for (const auto threads: { 1u, 4u })
+        {
+            static const size_t transactions = 100000;
+            unspent_outputs cache(max_size_t);
+            std::vector<output_point> points;
+            points.reserve(transactions * outputs);
+
+            for (uint32_t index = 0; index < transactions; ++index)
+            {
+                transaction tx;
+                tx.set_locktime(index);
+                tx.set_outputs(output::list(outputs,
+                    output(index, script{})));
+                cache.add(tx, 1, 0, true);
+
+                for (uint32_t slot = 0; slot < outputs; ++slot)
+                    points.push_back({ tx.hash(), slot });
+            }
+
+            measure(name("unspent_outputs_populate", "outputs", outputs,
+                "threads", threads), points.size(), threads,
+                [&](size_t index)
+                {
+                    cache.populate(points[index]);
+                });
+        }
+    }
+}
+
+// Microbenchmarks of the store primitives.
+// Usage: benchmark [directory] [filter]
+int main(int argc, char** argv)
+{
+    directory = argc > 1 ? argv[1] : "benchmark";
+    filter = argc > 2 ? argv[2] : "";
+
+    error_code code;
+    if (!create_directories(directory, code) && code.value() != 0)
+    {
+        std::cerr << format(BS_BENCHMARK_DIR_NEW) % directory % code.message();
+        return -1;
+    }
+
+    benchmark_file_storage();
+    benchmark_managers();
+    benchmark_hash_table();
+    benchmark_elements();
+    benchmark_unspent_outputs();
+
+    remove_all(directory);
+    return 0;
+}
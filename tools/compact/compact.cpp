@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <bitcoin/database.hpp>
+
+#define BS_COMPACT_USAGE \
+    "Usage: compact <source> <target> [load_percent] [name=value]...\n"
+#define BS_COMPACT_SETTING \
+    "Unknown or invalid setting '%1%'.\n"
+#define BS_COMPACT_DIR_EXISTS \
+    "Failed because the directory %1% already exists.\n"
+#define BS_COMPACT_SOURCE_FAIL \
+    "Failed to open source store %1%.\n"
+#define BS_COMPACT_TARGET_FAIL \
+    "Failed to create target store %1%.\n"
+#define BS_COMPACT_PRUNED \
+    "Failed to read block %1%, or it has pruned transactions.\n"
+#define BS_COMPACT_BLOCK_FAIL \
+    "Failed to write block %1% with error, '%2%'.\n"
+#define BS_COMPACT_SIZED \
+    "Sizing %1% blocks and %2% transactions to %3% and %4% buckets.\n"
+#define BS_COMPACT_DONE \
+    "Compacted store %1% to confirmed height %2%.\n"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+using namespace boost::filesystem;
+using namespace boost::system;
+using boost::format;
+
+// The default percentage of rows to buckets (one row per bucket).
+static const size_t default_load_percent = 100;
+
+// The number of buckets for the rows at the load percentage.
+static uint32_t buckets(size_t rows, size_t load_percent)
+{
+    const auto count = std::max(rows, size_t(1)) * 100 / load_percent;
+    return static_cast<uint32_t>(std::min(std::max(count, size_t(1)),
+        size_t(max_uint32)));
+}
+
+// Read the confirmed block at the height from the source store, failing if
+// any of its transactions is pruned (as it no longer has a payload).
+static block_ptr read_block(const data_base& source, size_t height)
+{
+    const auto result = source.blocks().get(height, false);
+
+    if (!result)
+        return nullptr;
+
+    transaction::list txs;
+    txs.reserve(result.transaction_count());
+
+    for (const auto link: result)
+    {
+        const auto tx = source.transactions().get(link);
+
+        if (!tx || tx.pruned())
+            return nullptr;
+
+        txs.push_back(tx.transaction());
+    }
+
+    const auto block = std::make_shared<message::block>(
+        chain::block(result.header(), std::move(txs)));
+    block->header().metadata.median_time_past = result.median_time_past();
+    return block;
+}
+
+// Apply a name=value override of a format setting to the target settings.
+static bool configure(database::settings& settings, const std::string& pair)
+{
+    const auto split = pair.find('=');
+
+    if (split == std::string::npos)
+        return false;
+
+    const auto name = pair.substr(0, split);
+    const auto value = pair.substr(split + 1);
+
+    try
+    {
+        if (name == "index_addresses")
+            settings.index_addresses = boost::lexical_cast<bool>(value);
+        else if (name == "index_filters")
+            settings.index_filters = boost::lexical_cast<bool>(value);
+        else if (name == "transaction_compaction")
+            settings.transaction_compaction = boost::lexical_cast<bool>(value);
+        else if (name == "transaction_linked_inputs")
+            settings.transaction_linked_inputs =
+                boost::lexical_cast<bool>(value);
+        else if (name == "transaction_split_state")
+            settings.transaction_split_state =
+                boost::lexical_cast<bool>(value);
+        else if (name == "address_table_buckets")
+            settings.address_table_buckets =
+                boost::lexical_cast<uint32_t>(value);
+        else if (name == "store_threads")
+            settings.store_threads = boost::lexical_cast<uint32_t>(value);
+        else
+            return false;
+    }
+    catch (const boost::bad_lexical_cast&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Count the confirmed transactions, from the block table only.
+static size_t count_transactions(const data_base& source, size_t top)
+{
+    size_t count = 0;
+
+    for (size_t height = 0; height <= top; ++height)
+    {
+        const auto result = source.blocks().get(height, false);
+
+        if (result)
+            count += result.transaction_count();
+    }
+
+    return count;
+}
+
+// Rewrite the confirmed chain of a source store into a new target store, so
+// that the transactions of each block are contiguous and in chain order, and
+// each hash table is sized to its rows. Pool txs and the candidate chain
+// above the confirmed chain are not carried, and are obtained again by sync.
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << BS_COMPACT_USAGE;
+        return -1;
+    }
+
+    const path source_directory(argv[1]);
+    const path target_directory(argv[2]);
+    auto load_percent = default_load_percent;
+    auto first_setting = 3;
+
+    if (argc > 3 && std::string(argv[3]).find('=') == std::string::npos)
+    {
+        try
+        {
+            load_percent = boost::lexical_cast<size_t>(argv[3]);
+            first_setting = 4;
+        }
+        catch (const boost::bad_lexical_cast&)
+        {
+            load_percent = 0;
+        }
+
+        if (load_percent == 0)
+        {
+            std::cerr << BS_COMPACT_USAGE;
+            return -1;
+        }
+    }
+
+    database::settings source_settings;
+    source_settings.directory = source_directory;
+    source_settings.read_only = true;
+
+    data_base source(source_settings);
+    size_t top;
+
+    if (!source.open() || !source.blocks().top(top, false))
+    {
+        std::cerr << format(BS_COMPACT_SOURCE_FAIL) % source_directory;
+        return -1;
+    }
+
+    const auto blocks = top + 1;
+    const auto transactions = count_transactions(source, top);
+
+    database::settings target_settings;
+    target_settings.directory = target_directory;
+    target_settings.block_table_buckets = buckets(blocks, load_percent);
+    target_settings.filter_table_buckets = target_settings.block_table_buckets;
+    target_settings.transaction_table_buckets = buckets(transactions,
+        load_percent);
+
+    // As with the network defaults, payments are of the order of txs.
+    target_settings.address_table_buckets =
+        target_settings.transaction_table_buckets;
+
+    for (auto arg = first_setting; arg < argc; ++arg)
+    {
+        if (!configure(target_settings, argv[arg]))
+        {
+            std::cerr << format(BS_COMPACT_SETTING) % argv[arg];
+            return -1;
+        }
+    }
+
+    error_code code;
+    if (!create_directories(target_directory, code))
+    {
+        std::cerr << format(BS_COMPACT_DIR_EXISTS) % target_directory;
+        return -1;
+    }
+
+    std::cout << format(BS_COMPACT_SIZED) % blocks % transactions %
+        target_settings.block_table_buckets %
+        target_settings.transaction_table_buckets;
+
+    const auto genesis = read_block(source, 0);
+    data_base target(target_settings);
+
+    if (!genesis || !target.create(*genesis))
+    {
+        std::cerr << format(BS_COMPACT_TARGET_FAIL) % target_directory;
+        return -1;
+    }
+
+    for (size_t height = 1; height <= top; ++height)
+    {
+        const auto block = read_block(source, height);
+
+        if (!block)
+        {
+            std::cerr << format(BS_COMPACT_PRUNED) % height;
+            return -1;
+        }
+
+        const auto ec = target.push(*block, height,
+            block->header().metadata.median_time_past);
+
+        if (ec)
+        {
+            std::cerr << format(BS_COMPACT_BLOCK_FAIL) % height % ec.message();
+            return -1;
+        }
+    }
+
+    source.close();
+    std::cout << format(BS_COMPACT_DONE) % target_directory % top;
+    return target.close() ? 0 : -1;
+}
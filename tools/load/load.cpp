@@ -0,0 +1,473 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <bitcoin/database.hpp>
+
+#define BS_LOAD_USAGE \
+    "Usage: load <blocks> <target> [threads]\n"
+#define BS_LOAD_DIR_EXISTS \
+    "Failed because the directory %1% already exists.\n"
+#define BS_LOAD_NO_FILES \
+    "Failed to find block files in %1%.\n"
+#define BS_LOAD_TARGET_FAIL \
+    "Failed to create target store %1%.\n"
+#define BS_LOAD_PARSE_FAIL \
+    "Failed to parse a block of file %1%.\n"
+#define BS_LOAD_BLOCK_FAIL \
+    "Failed to write block %1% with error, '%2%'.\n"
+#define BS_LOAD_INDEX_FAIL \
+    "Failed to index block %1% with error, '%2%'.\n"
+#define BS_LOAD_SIZED \
+    "Sizing %1% blocks and %2% transactions to %3% and %4% buckets.\n"
+#define BS_LOAD_ORPHANS \
+    "Stopped at height %1% with %2% blocks not connected.\n"
+#define BS_LOAD_DONE \
+    "Loaded store %1% to confirmed height %2%.\n"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+using namespace boost::filesystem;
+using namespace boost::system;
+using boost::format;
+
+// The mainnet message start, which prefixes each block of a block file.
+static const uint32_t block_file_magic = 0xd9b4bef9;
+static const size_t record_header_size = 2u * sizeof(uint32_t);
+static const size_t block_header_size = 80;
+
+// The number of blocks held between each stage of the pipeline.
+static const size_t queue_capacity = 256;
+
+// The number of timestamps of which median time past is the median.
+static const size_t median_time_past_interval = 11;
+
+// A blocking queue of bounded capacity, between two stages of the pipeline.
+// Pop returns false once the queue is closed and drained.
+template <typename Item>
+class bounded_queue
+{
+public:
+    bounded_queue(size_t capacity)
+      : capacity_(capacity), closed_(false)
+    {
+    }
+
+    bool push(Item&& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]()
+        {
+            return closed_ || queue_.size() < capacity_;
+        });
+
+        if (closed_)
+            return false;
+
+        queue_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(Item& out_item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]()
+        {
+            return closed_ || !queue_.empty();
+        });
+
+        if (queue_.empty())
+            return false;
+
+        out_item = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    bool closed_;
+    std::deque<Item> queue_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// The block files of the directory (blk*.dat), in file number order.
+static std::vector<path> block_files(const path& directory)
+{
+    std::vector<path> files;
+    error_code code;
+
+    for (directory_iterator it(directory, code), end; !code && it != end;
+        it.increment(code))
+    {
+        const auto name = it->path().filename().string();
+
+        if (name.size() > 7 && name.compare(0, 3, "blk") == 0 &&
+            it->path().extension() == ".dat")
+            files.push_back(it->path());
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Read the size of the next block record, false at the end of the blocks.
+// Block files are preallocated, so a zeroed record header ends the file.
+static bool read_record(bc::ifstream& file, uint32_t& out_size)
+{
+    byte_array<record_header_size> header;
+    file.read(reinterpret_cast<char*>(header.data()), header.size());
+
+    if (!file.good())
+        return false;
+
+    auto deserial = make_unsafe_deserializer(header.begin());
+    const auto magic = deserial.read_4_bytes_little_endian();
+    out_size = deserial.read_4_bytes_little_endian();
+    return magic == block_file_magic && out_size > 0;
+}
+
+// Count the blocks and txs of the block files from the record headers and the
+// tx count of each block, seeking over the remainder of each block.
+static void count_blocks(const std::vector<path>& files, size_t& out_blocks,
+    size_t& out_transactions)
+{
+    out_blocks = 0;
+    out_transactions = 0;
+
+    for (const auto& name: files)
+    {
+        bc::ifstream file(name.string(), std::ios::binary);
+        uint32_t size;
+
+        while (read_record(file, size))
+        {
+            const auto start = file.tellg();
+            byte_array<block_header_size + 9u> prefix;
+            const auto read = std::min(prefix.size(), size_t(size));
+            file.read(reinterpret_cast<char*>(prefix.data()), read);
+
+            if (!file.good())
+                break;
+
+            auto deserial = make_safe_deserializer(prefix.begin(),
+                prefix.begin() + read);
+            deserial.skip(block_header_size);
+            const auto count = deserial.read_size_little_endian();
+
+            if (!deserial)
+                break;
+
+            ++out_blocks;
+            out_transactions += count;
+            file.seekg(start + std::streamoff(size));
+        }
+    }
+}
+
+// The number of buckets for the rows at the load percentage.
+static uint32_t buckets(size_t rows, size_t load_percent)
+{
+    const auto count = std::max(rows, size_t(1)) * 100 / load_percent;
+    return static_cast<uint32_t>(std::min(std::max(count, size_t(1)),
+        size_t(max_uint32)));
+}
+
+// Bulk load a new mainnet store from a directory of raw block files, in the
+// stages parse and hash (threads), order, store and confirm, and index, with
+// bounded queues between. Blocks are presumed valid, as by push (initchain),
+// and writes are flushed once on close.
+int main(int argc, char** argv)
+{
+    if (argc < 3 || argc > 4)
+    {
+        std::cerr << BS_LOAD_USAGE;
+        return -1;
+    }
+
+    const path source_directory(argv[1]);
+    const path target_directory(argv[2]);
+    size_t threads = 0;
+
+    if (argc > 3)
+    {
+        try
+        {
+            threads = boost::lexical_cast<size_t>(argv[3]);
+        }
+        catch (const boost::bad_lexical_cast&)
+        {
+            std::cerr << BS_LOAD_USAGE;
+            return -1;
+        }
+    }
+
+    const auto files = block_files(source_directory);
+
+    if (files.empty())
+    {
+        std::cerr << format(BS_LOAD_NO_FILES) % source_directory;
+        return -1;
+    }
+
+    size_t blocks;
+    size_t transactions;
+    count_blocks(files, blocks, transactions);
+
+    // A failed bulk load is restarted, so neither flush nor journal.
+    database::settings settings;
+    settings.directory = target_directory;
+    settings.flush_writes = false;
+    settings.journal_writes = false;
+    settings.store_threads = static_cast<uint32_t>(threads);
+
+    const auto load_percent = settings.table_load_percent == 0 ? 100u :
+        settings.table_load_percent;
+    settings.block_table_buckets = buckets(blocks, load_percent);
+    settings.filter_table_buckets = settings.block_table_buckets;
+    settings.transaction_table_buckets = buckets(transactions, load_percent);
+
+    // As with the network defaults, payments are of the order of txs.
+    settings.address_table_buckets = settings.transaction_table_buckets;
+
+    error_code code;
+    if (!create_directories(target_directory, code))
+    {
+        std::cerr << format(BS_LOAD_DIR_EXISTS) % target_directory;
+        return -1;
+    }
+
+    std::cout << format(BS_LOAD_SIZED) % blocks % transactions %
+        settings.block_table_buckets % settings.transaction_table_buckets;
+
+    bc::settings bitcoin_settings(bc::config::settings::mainnet);
+    const auto genesis = bitcoin_settings.genesis_block.hash();
+    data_base store(settings);
+
+    if (!store.create(bitcoin_settings.genesis_block))
+    {
+        std::cerr << format(BS_LOAD_TARGET_FAIL) % target_directory;
+        return -1;
+    }
+
+    typedef std::shared_ptr<message::block> loaded_ptr;
+    bounded_queue<data_chunk> raw(queue_capacity);
+    bounded_queue<loaded_ptr> parsed(queue_capacity);
+    bounded_queue<loaded_ptr> ordered(queue_capacity);
+    bounded_queue<loaded_ptr> stored(queue_capacity);
+    std::atomic<bool> failed(false);
+
+    const auto stop = [&]()
+    {
+        failed = true;
+        raw.close();
+        parsed.close();
+        ordered.close();
+        stored.close();
+    };
+
+    // Read: the records of each file, in file order.
+    std::thread reader([&]()
+    {
+        for (const auto& name: files)
+        {
+            bc::ifstream file(name.string(), std::ios::binary);
+            uint32_t size;
+
+            while (!failed && read_record(file, size))
+            {
+                data_chunk data(size);
+                file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+                if (!file.good() || !raw.push(std::move(data)))
+                    break;
+            }
+        }
+
+        raw.close();
+    });
+
+    // Parse and hash: the block and tx hashes are cached by the parser.
+    const auto parsers = parallelism(threads);
+    std::atomic<size_t> parsing(parsers);
+    std::vector<std::thread> hashers;
+
+    for (size_t thread = 0; thread < parsers; ++thread)
+    {
+        hashers.emplace_back([&]()
+        {
+            data_chunk data;
+
+            while (raw.pop(data))
+            {
+                chain::block block;
+
+                if (!block.from_data(data, true))
+                {
+                    std::cerr << format(BS_LOAD_PARSE_FAIL) % source_directory;
+                    stop();
+                    break;
+                }
+
+                block.hash();
+                for (const auto& tx: block.transactions())
+                    tx.hash();
+
+                if (!parsed.push(std::make_shared<message::block>(
+                    std::move(block))))
+                    break;
+            }
+
+            if (--parsing == 0)
+                parsed.close();
+        });
+    }
+
+    // Order: file order is not chain order, so children wait for parents.
+    size_t top = 0;
+    size_t orphans = 0;
+    std::thread orderer([&]()
+    {
+        std::unordered_map<hash_digest, loaded_ptr> pending;
+        std::deque<uint32_t> timestamps;
+        timestamps.push_back(bitcoin_settings.genesis_block.header().
+            timestamp());
+        auto parent = genesis;
+        loaded_ptr block;
+
+        while (parsed.pop(block))
+        {
+            if (block->hash() == genesis)
+                continue;
+
+            pending.emplace(block->header().previous_block_hash(),
+                std::move(block));
+
+            for (auto it = pending.find(parent); it != pending.end();
+                it = pending.find(parent))
+            {
+                auto next = std::move(it->second);
+                pending.erase(it);
+
+                auto sorted = timestamps;
+                std::sort(sorted.begin(), sorted.end());
+                next->header().metadata.median_time_past =
+                    sorted[sorted.size() / 2u];
+
+                timestamps.push_back(next->header().timestamp());
+                if (timestamps.size() > median_time_past_interval)
+                    timestamps.pop_front();
+
+                parent = next->hash();
+                ++top;
+
+                if (!ordered.push(std::move(next)))
+                    break;
+            }
+        }
+
+        orphans = pending.size();
+        ordered.close();
+    });
+
+    // Store and confirm: each block is pushed at its height.
+    std::thread writer([&]()
+    {
+        loaded_ptr block;
+
+        for (size_t height = 1; ordered.pop(block); ++height)
+        {
+            const auto ec = store.push(*block, height,
+                block->header().metadata.median_time_past);
+
+            if (ec)
+            {
+                std::cerr << format(BS_LOAD_BLOCK_FAIL) % height %
+                    ec.message();
+                stop();
+                break;
+            }
+
+            if (settings.index_addresses && !stored.push(std::move(block)))
+                break;
+        }
+
+        stored.close();
+    });
+
+    // Index: prevouts are read from the store, as the block is confirmed.
+    loaded_ptr block;
+
+    for (size_t height = 1; stored.pop(block); ++height)
+    {
+        store.transactions().get_outputs(*block, height, false);
+        const auto ec = store.index(*block);
+
+        if (ec)
+        {
+            std::cerr << format(BS_LOAD_INDEX_FAIL) % height % ec.message();
+            stop();
+            break;
+        }
+    }
+
+    reader.join();
+    for (auto& hasher: hashers)
+        hasher.join();
+    orderer.join();
+    writer.join();
+
+    if (failed)
+        return -1;
+
+    if (orphans != 0)
+        std::cout << format(BS_LOAD_ORPHANS) % top % orphans;
+
+    // Writes are not flushed until close.
+    std::cout << format(BS_LOAD_DONE) % target_directory % top;
+    return store.close() ? 0 : -1;
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <bitcoin/database.hpp>
+
+#define BS_REPAIR_USAGE \
+    "Usage: repair <directory> [threads]\n"
+#define BS_REPAIR_DIR_MISSING \
+    "Failed because the directory %1% does not exist.\n"
+#define BS_REPAIR_FAIL \
+    "Failed to repair store %1%.\n"
+#define BS_REPAIR_HEIGHTS \
+    "Repaired store %1% to candidate height %2% and confirmed height %3%.\n"
+
+using namespace bc;
+using namespace bc::database;
+using namespace boost::filesystem;
+using namespace boost::system;
+using boost::format;
+
+// Repair a store that was not closed cleanly, then report its heights.
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << BS_REPAIR_USAGE;
+        return -1;
+    }
+
+    const path directory(argv[1]);
+    database::settings configuration;
+    configuration.directory = directory;
+
+    if (argc > 2)
+    {
+        try
+        {
+            configuration.store_threads = boost::lexical_cast<uint32_t>(
+                argv[2]);
+        }
+        catch (const boost::bad_lexical_cast&)
+        {
+            std::cerr << BS_REPAIR_USAGE;
+            return -1;
+        }
+    }
+
+    error_code code;
+    if (!exists(directory, code))
+    {
+        std::cerr << format(BS_REPAIR_DIR_MISSING) % directory;
+        return -1;
+    }
+
+    bool repaired;
+
+    try
+    {
+        repaired = data_base(configuration).repair();
+    }
+    catch (const std::runtime_error&)
+    {
+        // The block hash index is too small for the table.
+        repaired = false;
+    }
+
+    if (!repaired)
+    {
+        std::cerr << format(BS_REPAIR_FAIL) % directory;
+        return -1;
+    }
+
+    // The repaired store opens cleanly, and is read for its heights.
+    data_base store(configuration);
+    size_t candidate = 0;
+    size_t confirmed = 0;
+
+    if (!store.open())
+    {
+        std::cerr << format(BS_REPAIR_FAIL) % directory;
+        return -1;
+    }
+
+    store.blocks().top(candidate, true);
+    store.blocks().top(confirmed, false);
+    std::cout << format(BS_REPAIR_HEIGHTS) % directory % candidate % confirmed;
+    return store.close() ? 0 : -1;
+}
@@ -0,0 +1,405 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <bitcoin/database.hpp>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+
+// Each phase is one JSON object per line, for collection by perf tracking.
+#define BS_REPLAY_PHASE \
+    "{\"phase\":\"%1%\",\"blocks\":%2%,\"transactions\":%3%,\"inputs\":%4%," \
+    "\"seconds\":%5$.3f,\"blocks_per_second\":%6$.1f," \
+    "\"transactions_per_second\":%7$.1f,\"inputs_per_second\":%8$.1f," \
+    "\"flush_seconds\":%9$.3f,\"peak_rss_kb\":%10%}\n"
+#define BS_REPLAY_USAGE \
+    "Usage: replay <source> <target> [push|organize] [count] [name=value]...\n"
+#define BS_REPLAY_SETTING \
+    "Unknown or invalid setting '%1%'.\n"
+#define BS_REPLAY_DIR_EXISTS \
+    "Failed because the directory %1% already exists.\n"
+#define BS_REPLAY_SOURCE_FAIL \
+    "Failed to open source store %1%.\n"
+#define BS_REPLAY_TARGET_FAIL \
+    "Failed to create target store %1%.\n"
+#define BS_REPLAY_BLOCK_FAIL \
+    "Failed to replay block %1% with error, '%2%'.\n"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+using namespace boost::filesystem;
+using namespace boost::system;
+using boost::format;
+
+typedef std::chrono::steady_clock replay_clock;
+
+// The number of headers organized (and blocks read ahead) in one window.
+static const size_t window = 2000;
+
+// The accumulated cost of one replay phase.
+struct phase
+{
+    phase(const std::string& name)
+      : name(name), blocks(0), transactions(0), inputs(0), seconds(0)
+    {
+    }
+
+    std::string name;
+    size_t blocks;
+    size_t transactions;
+    size_t inputs;
+    double seconds;
+};
+
+static double seconds_since(const replay_clock::time_point& start)
+{
+    return std::chrono::duration<double>(replay_clock::now() - start).count();
+}
+
+static long peak_rss_kb()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+#endif
+}
+
+static void report(const phase& phase, double flush_seconds)
+{
+    const auto rate = [&](size_t count)
+    {
+        return phase.seconds == 0 ? 0.0 : count / phase.seconds;
+    };
+
+    std::cout << format(BS_REPLAY_PHASE) % phase.name % phase.blocks %
+        phase.transactions % phase.inputs % phase.seconds %
+        rate(phase.blocks) % rate(phase.transactions) % rate(phase.inputs) %
+        flush_seconds % peak_rss_kb();
+}
+
+// Time the operation against the phase, counting the block on success.
+template <typename Operation>
+static code measure(phase& phase, const chain::block& block,
+    Operation operation)
+{
+    const auto start = replay_clock::now();
+    const auto ec = operation();
+    phase.seconds += seconds_since(start);
+
+    if (!ec)
+    {
+        phase.blocks++;
+        phase.transactions += block.transactions().size();
+        phase.inputs += block.total_inputs(false);
+    }
+
+    return ec;
+}
+
+// Time a flush of the target, which is reported with each phase.
+static double timed_flush(const data_base& target)
+{
+    const auto start = replay_clock::now();
+    target.flush();
+    return seconds_since(start);
+}
+
+// Read the confirmed block at the height from the source store.
+static block_ptr read_block(const data_base& source, size_t height)
+{
+    const auto result = source.blocks().get(height, false);
+
+    if (!result)
+        return nullptr;
+
+    transaction::list txs;
+    txs.reserve(result.transaction_count());
+
+    for (const auto link: result)
+        txs.push_back(source.transactions().get(link).transaction());
+
+    const auto block = std::make_shared<message::block>(
+        chain::block(result.header(), std::move(txs)));
+    block->header().metadata.median_time_past = result.median_time_past();
+    return block;
+}
+
+// Apply a name=value override to the target settings.
+static bool configure(database::settings& settings, const std::string& pair)
+{
+    const auto split = pair.find('=');
+
+    if (split == std::string::npos)
+        return false;
+
+    const auto name = pair.substr(0, split);
+    const auto value = pair.substr(split + 1);
+
+    try
+    {
+        if (name == "file_growth_rate")
+            settings.file_growth_rate = boost::lexical_cast<uint16_t>(value);
+        else if (name == "file_reservation_mb")
+            settings.file_reservation_mb = boost::lexical_cast<uint32_t>(value);
+        else if (name == "store_threads")
+            settings.store_threads = boost::lexical_cast<uint32_t>(value);
+        else if (name == "block_table_buckets")
+            settings.block_table_buckets = boost::lexical_cast<uint32_t>(value);
+        else if (name == "transaction_table_buckets")
+            settings.transaction_table_buckets =
+                boost::lexical_cast<uint32_t>(value);
+        else if (name == "cache_capacity")
+            settings.cache_capacity = boost::lexical_cast<uint32_t>(value);
+        else if (name == "cache_budget_mb")
+            settings.cache_budget_mb = boost::lexical_cast<uint32_t>(value);
+        else if (name == "flush_writes")
+            settings.flush_writes = boost::lexical_cast<bool>(value);
+        else
+            return false;
+    }
+    catch (const boost::bad_lexical_cast&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Push each block through candidacy and confirmation (as initchain).
+static bool replay_push(const data_base& source, data_base& target,
+    size_t top)
+{
+    phase push{ "push" };
+
+    for (size_t height = 1; height <= top; ++height)
+    {
+        const auto block = read_block(source, height);
+
+        if (!block)
+        {
+            std::cerr << format(BS_REPLAY_BLOCK_FAIL) % height %
+                code(error::not_found).message();
+            return false;
+        }
+
+        const auto ec = measure(push, *block, [&]()
+        {
+            return target.push(*block, height,
+                block->header().metadata.median_time_past);
+        });
+
+        if (ec)
+        {
+            std::cerr << format(BS_REPLAY_BLOCK_FAIL) % height % ec.message();
+            return false;
+        }
+    }
+
+    report(push, timed_flush(target));
+    return true;
+}
+
+// Organize windows of headers, then update, candidate and confirm each
+// block of the window (as the node organizers).
+static bool replay_organize(const data_base& source, data_base& target,
+    size_t top)
+{
+    phase headers{ "headers" };
+    phase update{ "update" };
+    phase candidate{ "candidate" };
+    phase confirm{ "confirm" };
+
+    for (size_t first = 1; first <= top; first += window)
+    {
+        const auto last = std::min(first + window - 1, top);
+        std::vector<block_ptr> blocks;
+        blocks.reserve(last - first + 1);
+
+        const auto incoming = std::make_shared<header_const_ptr_list>();
+        const auto outgoing = std::make_shared<header_const_ptr_list>();
+        incoming->reserve(last - first + 1);
+
+        for (auto height = first; height <= last; ++height)
+        {
+            const auto block = read_block(source, height);
+
+            if (!block)
+            {
+                std::cerr << format(BS_REPLAY_BLOCK_FAIL) % height %
+                    code(error::not_found).message();
+                return false;
+            }
+
+            blocks.push_back(block);
+            incoming->push_back(std::make_shared<const message::header>(
+                blocks.back()->header()));
+        }
+
+        const config::checkpoint fork_point(
+            blocks.front()->header().previous_block_hash(), first - 1);
+
+        const auto start = replay_clock::now();
+        const auto ec = target.reorganize(fork_point, incoming, outgoing);
+        headers.seconds += seconds_since(start);
+
+        if (ec)
+        {
+            std::cerr << format(BS_REPLAY_BLOCK_FAIL) % first % ec.message();
+            return false;
+        }
+
+        headers.blocks += incoming->size();
+
+        for (size_t index = 0; index < blocks.size(); ++index)
+        {
+            const auto height = first + index;
+            const auto& block = blocks[index];
+            const auto incoming_block = std::make_shared<block_const_ptr_list>(
+                1, block);
+            const auto outgoing_block = std::make_shared<block_const_ptr_list>();
+            const config::checkpoint parent(
+                block->header().previous_block_hash(), height - 1);
+
+            code ec;
+            if ((ec = measure(update, *block, [&]()
+                {
+                    return target.update(*block, height);
+                })) ||
+                (ec = measure(candidate, *block, [&]()
+                {
+                    return target.candidate(*block);
+                })) ||
+                (ec = measure(confirm, *block, [&]()
+                {
+                    return target.reorganize(parent, incoming_block,
+                        outgoing_block);
+                })))
+            {
+                std::cerr << format(BS_REPLAY_BLOCK_FAIL) % height %
+                    ec.message();
+                return false;
+            }
+        }
+    }
+
+    const auto flush_seconds = timed_flush(target);
+    report(headers, 0);
+    report(update, 0);
+    report(candidate, 0);
+    report(confirm, flush_seconds);
+    return true;
+}
+
+// Replay the confirmed chain of a source store into a new target store.
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << BS_REPLAY_USAGE;
+        return -1;
+    }
+
+    const path source_directory(argv[1]);
+    const path target_directory(argv[2]);
+    const std::string mode(argc > 3 ? argv[3] : "organize");
+    auto count = max_size_t;
+
+    if (mode != "push" && mode != "organize")
+    {
+        std::cerr << BS_REPLAY_USAGE;
+        return -1;
+    }
+
+    if (argc > 4)
+    {
+        try
+        {
+            count = boost::lexical_cast<size_t>(argv[4]);
+        }
+        catch (const boost::bad_lexical_cast&)
+        {
+            std::cerr << BS_REPLAY_USAGE;
+            return -1;
+        }
+    }
+
+    database::settings source_settings;
+    source_settings.directory = source_directory;
+    source_settings.read_only = true;
+
+    database::settings target_settings;
+    target_settings.directory = target_directory;
+
+    for (auto arg = 5; arg < argc; ++arg)
+    {
+        if (!configure(target_settings, argv[arg]))
+        {
+            std::cerr << format(BS_REPLAY_SETTING) % argv[arg];
+            return -1;
+        }
+    }
+
+    error_code code;
+    if (!create_directories(target_directory, code))
+    {
+        std::cerr << format(BS_REPLAY_DIR_EXISTS) % target_directory;
+        return -1;
+    }
+
+    data_base source(source_settings);
+    size_t top;
+
+    if (!source.open() || !source.blocks().top(top, false))
+    {
+        std::cerr << format(BS_REPLAY_SOURCE_FAIL) % source_directory;
+        return -1;
+    }
+
+    top = std::min(top, count);
+    const auto genesis = read_block(source, 0);
+    data_base target(target_settings);
+
+    if (!genesis || !target.create(*genesis))
+    {
+        std::cerr << format(BS_REPLAY_TARGET_FAIL) % target_directory;
+        return -1;
+    }
+
+    const auto replayed = mode == "push" ?
+        replay_push(source, target, top) :
+        replay_organize(source, target, top);
+
+    target.close();
+    source.close();
+    return replayed ? 0 : -1;
+}
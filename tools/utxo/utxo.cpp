@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <bitcoin/database.hpp>
+
+#define BS_UTXO_USAGE \
+    "Usage: utxo export <directory> <file>\n" \
+    "       utxo import <file> <directory>\n"
+#define BS_UTXO_DIR_EXISTS \
+    "Failed because the directory %1% already exists.\n"
+#define BS_UTXO_STORE_FAIL \
+    "Failed to open store %1%.\n"
+#define BS_UTXO_CREATE_FAIL \
+    "Failed to create store %1%.\n"
+#define BS_UTXO_SNAPSHOT_FAIL \
+    "Failed to read snapshot %1%.\n"
+#define BS_UTXO_EXPORT_FAIL \
+    "Failed to export unspent outputs to %1%.\n"
+#define BS_UTXO_IMPORT_FAIL \
+    "Failed to import unspent outputs from %1%.\n"
+#define BS_UTXO_SNAPSHOT \
+    "Snapshot of %1% transactions at height %2% of block %3%.\n"
+#define BS_UTXO_EXPORTED \
+    "Exported unspent outputs of store %1% to %2%.\n"
+#define BS_UTXO_IMPORTED \
+    "Imported unspent outputs to store %1%.\n"
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::database;
+using namespace boost::filesystem;
+using namespace boost::system;
+using boost::format;
+
+// Export the unspent outputs of the confirmed chain of an existing store.
+static int export_unspent(const path& directory, const path& file)
+{
+    database::settings settings;
+    settings.directory = directory;
+    settings.read_only = true;
+
+    data_base store(settings);
+
+    if (!store.open())
+    {
+        std::cerr << format(BS_UTXO_STORE_FAIL) % directory;
+        return -1;
+    }
+
+    if (!store.export_unspent(file))
+    {
+        std::cerr << format(BS_UTXO_EXPORT_FAIL) % file;
+        return -1;
+    }
+
+    std::cout << format(BS_UTXO_EXPORTED) % directory % file;
+    return store.close() ? 0 : -1;
+}
+
+// Create a new mainnet store with the transaction table sized to the snapshot,
+// and import its unspent outputs. Headers are obtained again by sync.
+static int import_unspent(const path& file, const path& directory)
+{
+    size_t height;
+    hash_digest block_hash;
+    uint64_t transactions;
+
+    if (!transaction_database::read_snapshot(file, height, block_hash,
+        transactions))
+    {
+        std::cerr << format(BS_UTXO_SNAPSHOT_FAIL) % file;
+        return -1;
+    }
+
+    std::cout << format(BS_UTXO_SNAPSHOT) % transactions % height %
+        encode_hash(block_hash);
+
+    database::settings settings;
+    settings.directory = directory;
+    settings.transaction_table_buckets = static_cast<uint32_t>(std::min(
+        std::max(transactions, uint64_t(1)), uint64_t(max_uint32)));
+
+    error_code code;
+    if (!create_directories(directory, code))
+    {
+        std::cerr << format(BS_UTXO_DIR_EXISTS) % directory;
+        return -1;
+    }
+
+    bc::settings bitcoin_settings(bc::config::settings::mainnet);
+    data_base store(settings);
+
+    if (!store.create(bitcoin_settings.genesis_block))
+    {
+        std::cerr << format(BS_UTXO_CREATE_FAIL) % directory;
+        return -1;
+    }
+
+    if (!store.import_unspent(file))
+    {
+        std::cerr << format(BS_UTXO_IMPORT_FAIL) % file;
+        return -1;
+    }
+
+    std::cout << format(BS_UTXO_IMPORTED) % directory;
+    return store.close() ? 0 : -1;
+}
+
+// Export or import the unspent output set of a store, as a snapshot file.
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << BS_UTXO_USAGE;
+        return -1;
+    }
+
+    const std::string command(argv[1]);
+
+    if (command == "export")
+        return export_unspent(argv[2], argv[3]);
+
+    if (command == "import")
+        return import_unspent(argv[2], argv[3]);
+
+    std::cerr << BS_UTXO_USAGE;
+    return -1;
+}